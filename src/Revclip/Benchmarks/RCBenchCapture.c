@@ -0,0 +1,790 @@
+//
+//  RCBenchCapture.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCBenchCapture.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "RCBenchDatabase.h"
+#include "RCClipCompression.h"
+#include "RCClipContainer.h"
+#include "RCDigestFilter.h"
+#include "RCSHA256.h"
+
+// Keep in sync with RCDatabaseManager.m.
+static const char *const kRCLookupSQL = "SELECT id FROM clip_items WHERE data_hash = ? LIMIT 1";
+static const char *const kRCInsertSQL =
+    "INSERT INTO clip_items (data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code, data_size, fingerprint_version) "
+    "VALUES (?, ?, ?, ?, ?, '', 0, ?, 2)";
+static const char *const kRCInsertSearchSQL = "INSERT INTO clip_search (rowid, body) VALUES (?, rc_search_text(?))";
+static const char *const kRCUpdateTimeSQL = "UPDATE clip_items SET update_time = ? WHERE data_hash = ?";
+static const char *const kRCEvictSQL =
+    "DELETE FROM clip_items WHERE update_time < ? OR id IN "
+    "(SELECT id FROM clip_items ORDER BY update_time DESC, id DESC LIMIT -1 OFFSET ?) "
+    "RETURNING data_path, data_hash";
+
+// update_time of virtual time 0 (ms since 1970), so rows look like real ones.
+#define RC_CAPTURE_EPOCH_MILLISECONDS 1767225600000LL
+#define RC_CAPTURE_FILTER_MIN_CAPACITY 4096
+#define RC_CAPTURE_TITLE_LENGTH 200
+
+// RCClipData's representation order, with the pasteboard type stored as primaryType.
+static const struct {
+    RCClipRepresentation representation;
+    RCClipSectionType section;
+    const char *pasteboardType;
+} kRCRepresentations[] = {
+    { RCClipRepresentationString, RCClipSectionString, "public.utf8-plain-text" },
+    { RCClipRepresentationRTF, RCClipSectionRTF, "public.rtf" },
+    { RCClipRepresentationRTFD, RCClipSectionRTFD, "com.apple.flat-rtfd" },
+    { RCClipRepresentationPDF, RCClipSectionPDF, "com.adobe.pdf" },
+    { RCClipRepresentationFiles, RCClipSectionFileURLs, "public.file-url" },
+    { RCClipRepresentationURL, RCClipSectionURL, "public.url" },
+    { RCClipRepresentationTIFF, RCClipSectionTIFF, "public.tiff" },
+};
+#define RC_CAPTURE_REPRESENTATION_COUNT (sizeof(kRCRepresentations) / sizeof(kRCRepresentations[0]))
+
+typedef struct {
+    uint8_t *bytes[RC_CAPTURE_REPRESENTATION_COUNT];
+    size_t lengths[RC_CAPTURE_REPRESENTATION_COUNT];
+    uint64_t payloadLength;
+    /// Wall time spent on this clip so far (see RCBenchCaptureLatencies).
+    uint64_t costNanoseconds;
+} RCCaptureJob;
+
+typedef struct {
+    bool isInsert;
+    uint8_t digest[RC_SHA256_DIGEST_LENGTH];
+    int64_t updateTime;
+    char *dataPath;
+    char *title;
+    char *body;
+    const char *primaryType;
+    int64_t dataSize;
+    uint64_t costNanoseconds;
+} RCPendingWrite;
+
+struct RCBenchCapture {
+    RCBenchCaptureConfiguration configuration;
+    RCBenchPasteboard *pasteboard;
+    char *clipDirectory;
+    sqlite3 *db;
+    sqlite3_stmt *lookup;
+    sqlite3_stmt *insert;
+    sqlite3_stmt *insertSearch;
+    sqlite3_stmt *updateTime;
+    sqlite3_stmt *evict;
+    RCDigestFilter *filter;
+    RCPollScheduler scheduler;
+    RCBurstCoalescer coalescer;
+    int64_t cachedChangeCount;
+    uint64_t now;
+    uint64_t fileSerial;
+
+    RCPendingWrite *pending;
+    size_t pendingCount;
+    size_t pendingCapacity;
+    /// 0 when nothing is pending / scheduled.
+    uint64_t writeBehindDeadline;
+    uint64_t cleanupDeadline;
+    uint64_t periodicCleanupDeadline;
+    /// update_time cutoff of the last expiry run (INT64_MIN before one).
+    int64_t expiryCutoff;
+
+    RCBenchCaptureCounters counters;
+    RCBenchSamples latencies;
+};
+
+RCBenchCaptureConfiguration RCBenchCaptureDefaultConfiguration(void) {
+    return (RCBenchCaptureConfiguration){
+        .plan = RCCapturePlanMake(RC_CLIP_REPRESENTATION_ALL, 50ull * 1024 * 1024),
+        .poll = RCPollSchedulerDefaultConfiguration(),
+        .burst = RCBurstCoalescerDefaultConfiguration(),
+        .historyLimit = 30,
+        .expiryNanoseconds = 0,
+        .cleanupDelayNanoseconds = 5000000000ull,
+        .cleanupIntervalNanoseconds = 30ull * 60 * 1000000000ull,
+        .writeBehindNanoseconds = 250000000ull,
+        .writeBehindMaxPending = 128,
+        .excludedBundleIdentifier = NULL,
+    };
+}
+
+static void RCCaptureJobFree(RCCaptureJob *job) {
+    if (job == NULL) {
+        return;
+    }
+    for (size_t index = 0; index < RC_CAPTURE_REPRESENTATION_COUNT; index++) {
+        free(job->bytes[index]);
+    }
+    free(job);
+}
+
+static void RCPendingWriteFree(RCPendingWrite *write) {
+    free(write->dataPath);
+    free(write->title);
+    free(write->body);
+}
+
+static char *RCCopyBytesAsString(const uint8_t *bytes, size_t length, size_t limit) {
+    size_t count = length < limit ? length : limit;
+    char *string = malloc(count + 1);
+    if (string != NULL) {
+        memcpy(string, bytes, count);
+        string[count] = '\0';
+    }
+    return string;
+}
+
+// MARK: - Lifecycle
+
+RCBenchCapture *RCBenchCaptureCreate(const char *directory,
+                                     const RCBenchCaptureConfiguration *configuration,
+                                     RCBenchPasteboard *pasteboard) {
+    RCBenchCapture *capture = calloc(1, sizeof(*capture));
+    if (capture == NULL) {
+        return NULL;
+    }
+    capture->configuration = configuration != NULL ? *configuration : RCBenchCaptureDefaultConfiguration();
+    capture->pasteboard = pasteboard;
+    capture->cachedChangeCount = pasteboard->changeCount;
+    RCPollSchedulerInit(&capture->scheduler, &capture->configuration.poll, 0);
+    capture->periodicCleanupDeadline = capture->configuration.cleanupIntervalNanoseconds;
+    capture->expiryCutoff = INT64_MIN;
+    RCBurstCoalescerInit(&capture->coalescer, &capture->configuration.burst);
+    RCBenchSamplesInit(&capture->latencies, 1024);
+
+    long limit = capture->configuration.historyLimit;
+    size_t filterCapacity = limit > 0 && (size_t)limit * 2 > RC_CAPTURE_FILTER_MIN_CAPACITY
+        ? (size_t)limit * 2
+        : RC_CAPTURE_FILTER_MIN_CAPACITY;
+    char *databasePath = RCBenchPathJoin(directory, "revclip.db");
+    capture->clipDirectory = RCBenchPathJoin(directory, "ClipsData");
+    bool ready = databasePath != NULL && capture->clipDirectory != NULL
+        && mkdir(capture->clipDirectory, 0700) == 0
+        && (capture->filter = RCDigestFilterCreate(filterCapacity)) != NULL
+        && (capture->db = RCBenchOpenWriter(databasePath, RCBenchJournalModeWAL)) != NULL
+        && RCBenchCreateBaseSchema(capture->db)
+        && sqlite3_prepare_v2(capture->db, kRCLookupSQL, -1, &capture->lookup, NULL) == SQLITE_OK
+        && sqlite3_prepare_v2(capture->db, kRCInsertSQL, -1, &capture->insert, NULL) == SQLITE_OK
+        && sqlite3_prepare_v2(capture->db, kRCInsertSearchSQL, -1, &capture->insertSearch, NULL) == SQLITE_OK
+        && sqlite3_prepare_v2(capture->db, kRCUpdateTimeSQL, -1, &capture->updateTime, NULL) == SQLITE_OK
+        && sqlite3_prepare_v2(capture->db, kRCEvictSQL, -1, &capture->evict, NULL) == SQLITE_OK;
+    if (!ready && capture->db != NULL) {
+        fprintf(stderr, "capture setup failed: %s\n", sqlite3_errmsg(capture->db));
+    }
+    free(databasePath);
+    if (!ready) {
+        RCBenchCaptureDestroy(capture);
+        return NULL;
+    }
+    return capture;
+}
+
+static bool RCCommitPendingWrites(RCBenchCapture *capture);
+
+void RCBenchCaptureDestroy(RCBenchCapture *capture) {
+    if (capture == NULL) {
+        return;
+    }
+    if (capture->db != NULL) {
+        RCCommitPendingWrites(capture);
+    }
+    void *held[RC_BURST_COALESCER_MAX_KEEP];
+    size_t heldCount = RCBurstCoalescerFlush(&capture->coalescer, held);
+    for (size_t index = 0; index < heldCount; index++) {
+        RCCaptureJobFree(held[index]);
+    }
+    for (size_t index = 0; index < capture->pendingCount; index++) {
+        RCPendingWriteFree(&capture->pending[index]);
+    }
+    free(capture->pending);
+    sqlite3_finalize(capture->lookup);
+    sqlite3_finalize(capture->insert);
+    sqlite3_finalize(capture->insertSearch);
+    sqlite3_finalize(capture->updateTime);
+    sqlite3_finalize(capture->evict);
+    sqlite3_close(capture->db);
+    RCDigestFilterDestroy(capture->filter);
+    RCBenchSamplesFree(&capture->latencies);
+    free(capture->clipDirectory);
+    free(capture);
+}
+
+sqlite3 *RCBenchCaptureDatabase(const RCBenchCapture *capture) {
+    return capture->db;
+}
+
+void RCBenchCaptureGetCounters(const RCBenchCapture *capture, RCBenchCaptureCounters *outCounters) {
+    *outCounters = capture->counters;
+}
+
+RCBenchSamples *RCBenchCaptureLatencies(RCBenchCapture *capture) {
+    return &capture->latencies;
+}
+
+// MARK: - Snapshot
+
+// -[RCClipData clipDataFromPasteboard:plan:verdict:]: decide from the types
+// alone, then read the planned representations cheapest first within budget.
+static RCCaptureJob *RCSnapshotPasteboard(RCBenchCapture *capture) {
+    bool marked = false;
+    RCClipRepresentationMask offered = RCBenchPasteboardTypes(capture->pasteboard, &marked);
+    RCClipRepresentationMask readMask = 0;
+    RCCaptureVerdict verdict = RCCapturePlanEvaluate(&capture->configuration.plan, offered, marked, &readMask);
+
+    RCCaptureJob *job = NULL;
+    if (verdict == RCCaptureVerdictRead) {
+        job = calloc(1, sizeof(*job));
+        RCClipRepresentation order[RC_CLIP_REPRESENTATION_COUNT];
+        size_t count = RCCapturePlanReadOrder(readMask, order);
+        RCCaptureBudget budget;
+        RCCaptureBudgetInit(&budget, &capture->configuration.plan);
+        for (size_t index = 0; job != NULL && index < count; index++) {
+            size_t slot = 0;
+            while (slot < RC_CAPTURE_REPRESENTATION_COUNT && kRCRepresentations[slot].representation != order[index]) {
+                slot++;
+            }
+            if (slot == RC_CAPTURE_REPRESENTATION_COUNT) {
+                continue;
+            }
+            job->bytes[slot] = RCBenchPasteboardRead(capture->pasteboard, order[index], &job->lengths[slot]);
+            job->payloadLength += job->lengths[slot];
+            capture->counters.bytesRead += job->lengths[slot];
+            if (!RCCaptureBudgetCharge(&budget, job->lengths[slot])) {
+                verdict = RCCaptureVerdictSkipOversized;
+                RCCaptureJobFree(job);
+                job = NULL;
+            }
+        }
+    }
+
+    switch (verdict) {
+        case RCCaptureVerdictSkipMarked:
+            capture->counters.skippedMarked++;
+            break;
+        case RCCaptureVerdictSkipDisabled:
+            capture->counters.skippedDisabled++;
+            break;
+        case RCCaptureVerdictSkipEmpty:
+            capture->counters.skippedEmpty++;
+            break;
+        case RCCaptureVerdictSkipOversized:
+            capture->counters.skippedOversized++;
+            break;
+        default:
+            break;
+    }
+    return job;
+}
+
+// RCBurstKeyForClipData: length, representations and a sample of the bytes.
+static uint64_t RCBurstKeyForJob(const RCCaptureJob *job) {
+    uint64_t key = job->payloadLength;
+    for (size_t slot = 0; slot < RC_CAPTURE_REPRESENTATION_COUNT; slot++) {
+        key = key * 1099511628211ULL ^ job->lengths[slot];
+        size_t sample = job->lengths[slot] < 64 ? job->lengths[slot] : 64;
+        for (size_t index = 0; index < sample; index++) {
+            key = (key ^ job->bytes[slot][index]) * 1099511628211ULL;
+        }
+    }
+    return key;
+}
+
+// MARK: - Fingerprint / dedup / persist
+
+static const char *RCPrimaryTypeForJob(const RCCaptureJob *job) {
+    for (size_t slot = 0; slot < RC_CAPTURE_REPRESENTATION_COUNT; slot++) {
+        if (job->bytes[slot] != NULL) {
+            return kRCRepresentations[slot].pasteboardType;
+        }
+    }
+    return "";
+}
+
+// Fingerprint v2: every representation, tagged and length-prefixed.
+static void RCFingerprintJob(const RCCaptureJob *job, uint8_t digest[RC_SHA256_DIGEST_LENGTH]) {
+    RCSHA256Context context;
+    RCSHA256Init(&context);
+    for (size_t slot = 0; slot < RC_CAPTURE_REPRESENTATION_COUNT; slot++) {
+        if (job->bytes[slot] == NULL) {
+            continue;
+        }
+        uint8_t header[9];
+        header[0] = (uint8_t)kRCRepresentations[slot].section;
+        uint64_t length = job->lengths[slot];
+        for (int byte = 0; byte < 8; byte++) {
+            header[1 + byte] = (uint8_t)(length >> (byte * 8));
+        }
+        RCSHA256Update(&context, header, sizeof(header));
+        RCSHA256Update(&context, job->bytes[slot], job->lengths[slot]);
+    }
+    const char *primaryType = RCPrimaryTypeForJob(job);
+    RCSHA256Update(&context, primaryType, strlen(primaryType));
+    RCSHA256Final(&context, digest);
+}
+
+static RCPendingWrite *RCFindPendingInsert(RCBenchCapture *capture, const uint8_t digest[RC_SHA256_DIGEST_LENGTH]) {
+    for (size_t index = 0; index < capture->pendingCount; index++) {
+        if (capture->pending[index].isInsert && memcmp(capture->pending[index].digest, digest, RC_SHA256_DIGEST_LENGTH) == 0) {
+            return &capture->pending[index];
+        }
+    }
+    return NULL;
+}
+
+static bool RCHistoryContainsDigest(RCBenchCapture *capture, const uint8_t digest[RC_SHA256_DIGEST_LENGTH]) {
+    if (!RCDigestFilterMayContain(capture->filter, digest, RC_SHA256_DIGEST_LENGTH)) {
+        capture->counters.filterSkips++;
+        return false;
+    }
+    sqlite3_bind_blob(capture->lookup, 1, digest, RC_SHA256_DIGEST_LENGTH, SQLITE_STATIC);
+    bool found = sqlite3_step(capture->lookup) == SQLITE_ROW;
+    sqlite3_reset(capture->lookup);
+    sqlite3_clear_bindings(capture->lookup);
+    return found;
+}
+
+static RCPendingWrite *RCAppendPendingWrite(RCBenchCapture *capture) {
+    if (capture->pendingCount == capture->pendingCapacity) {
+        size_t capacity = capture->pendingCapacity == 0 ? 32 : capture->pendingCapacity * 2;
+        RCPendingWrite *pending = realloc(capture->pending, capacity * sizeof(*pending));
+        if (pending == NULL) {
+            return NULL;
+        }
+        capture->pending = pending;
+        capture->pendingCapacity = capacity;
+    }
+    RCPendingWrite *write = &capture->pending[capture->pendingCount++];
+    memset(write, 0, sizeof(*write));
+    return write;
+}
+
+// -[RCClipData saveToPath:digests:blobDigests:] without the blob store.
+static bool RCPersistJob(RCBenchCapture *capture, const RCCaptureJob *job, const char *path) {
+    RCClipContainerWriter *writer = RCClipContainerWriterCreate();
+    if (writer == NULL) {
+        return false;
+    }
+    RCClipContainerStatus status = RCClipContainerOK;
+    for (size_t slot = 0; status == RCClipContainerOK && slot < RC_CAPTURE_REPRESENTATION_COUNT; slot++) {
+        if (job->bytes[slot] == NULL) {
+            continue;
+        }
+        RCClipSectionType section = kRCRepresentations[slot].section;
+        if (section == RCClipSectionFileURLs) {
+            const char *item = (const char *)job->bytes[slot];
+            status = RCClipContainerWriterAddListSection(writer, section, &item, &job->lengths[slot], 1);
+            continue;
+        }
+        bool cold = section == RCClipSectionRTFD || section == RCClipSectionPDF || section == RCClipSectionTIFF;
+        status = RCClipContainerWriterAddCompressibleSection(writer, section, job->bytes[slot], job->lengths[slot],
+                                                             cold ? RCClipCompressionCold : RCClipCompressionHot);
+    }
+    const char *primaryType = RCPrimaryTypeForJob(job);
+    if (status == RCClipContainerOK) {
+        status = RCClipContainerWriterAddSection(writer, RCClipSectionPrimaryType, 0, primaryType, strlen(primaryType));
+    }
+    if (status == RCClipContainerOK) {
+        status = RCClipContainerWriterWriteFile(writer, path);
+    }
+    RCClipContainerWriterDestroy(writer);
+    if (status != RCClipContainerOK) {
+        fprintf(stderr, "clip write failed (%d): %s\n", (int)status, path);
+        return false;
+    }
+    struct stat info;
+    capture->counters.clipFilesWritten++;
+    capture->counters.clipBytesWritten += stat(path, &info) == 0 ? (uint64_t)info.st_size : 0;
+    return true;
+}
+
+static int64_t RCUpdateTimeAt(uint64_t now) {
+    return RC_CAPTURE_EPOCH_MILLISECONDS + (int64_t)(now / 1000000ull);
+}
+
+static void RCScheduleWriteBehind(RCBenchCapture *capture) {
+    if (capture->writeBehindDeadline == 0) {
+        capture->writeBehindDeadline = capture->now + capture->configuration.writeBehindNanoseconds;
+    }
+    if (capture->pendingCount >= capture->configuration.writeBehindMaxPending) {
+        RCCommitPendingWrites(capture);
+    }
+}
+
+// fingerprint -> dedup -> persist, then queue the row for the write-behind batch.
+static bool RCProcessJob(RCBenchCapture *capture, RCCaptureJob *job) {
+    uint64_t started = RCBenchNowNanoseconds();
+    uint8_t digest[RC_SHA256_DIGEST_LENGTH];
+    RCFingerprintJob(job, digest);
+    capture->counters.captured++;
+    int64_t updateTime = RCUpdateTimeAt(capture->now);
+
+    RCPendingWrite *inFlight = RCFindPendingInsert(capture, digest);
+    if (inFlight != NULL || RCHistoryContainsDigest(capture, digest)) {
+        // -[RCClipboardService handleExistingClipWithHash:...]: move the row to the top.
+        capture->counters.duplicates++;
+        uint64_t cost = job->costNanoseconds + RCBenchNowNanoseconds() - started;
+        RCCaptureJobFree(job);
+        if (inFlight != NULL) {
+            inFlight->updateTime = updateTime;
+            RCBenchSamplesAppend(&capture->latencies, cost);
+            return true;
+        }
+        RCPendingWrite *write = RCAppendPendingWrite(capture);
+        if (write == NULL) {
+            return false;
+        }
+        memcpy(write->digest, digest, sizeof(digest));
+        write->updateTime = updateTime;
+        write->costNanoseconds = cost;
+        RCScheduleWriteBehind(capture);
+        return true;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "%016llx-%llu.rcclip",
+             (unsigned long long)capture->now, (unsigned long long)++capture->fileSerial);
+    char *path = RCBenchPathJoin(capture->clipDirectory, name);
+    if (path == NULL || !RCPersistJob(capture, job, path)) {
+        free(path);
+        RCCaptureJobFree(job);
+        return false;
+    }
+
+    RCPendingWrite *write = RCAppendPendingWrite(capture);
+    if (write == NULL) {
+        free(path);
+        RCCaptureJobFree(job);
+        return false;
+    }
+    write->isInsert = true;
+    memcpy(write->digest, digest, sizeof(digest));
+    write->updateTime = updateTime;
+    write->dataPath = path;
+    write->primaryType = RCPrimaryTypeForJob(job);
+    write->dataSize = (int64_t)job->payloadLength;
+    for (size_t slot = 0; slot < RC_CAPTURE_REPRESENTATION_COUNT; slot++) {
+        RCClipRepresentation representation = kRCRepresentations[slot].representation;
+        if (job->bytes[slot] == NULL) {
+            continue;
+        }
+        if (write->title == NULL) {
+            write->title = RCCopyBytesAsString(job->bytes[slot], job->lengths[slot], RC_CAPTURE_TITLE_LENGTH);
+        }
+        if (write->body == NULL && (representation == RCClipRepresentationString || representation == RCClipRepresentationURL)) {
+            write->body = RCCopyBytesAsString(job->bytes[slot], job->lengths[slot], job->lengths[slot]);
+        }
+    }
+    RCDigestFilterAdd(capture->filter, digest, sizeof(digest));
+    write->costNanoseconds = job->costNanoseconds + RCBenchNowNanoseconds() - started;
+    RCCaptureJobFree(job);
+    RCScheduleWriteBehind(capture);
+    capture->cleanupDeadline = capture->now + capture->configuration.cleanupDelayNanoseconds;
+    return true;
+}
+
+// MARK: - Write-behind / cleanup
+
+// -[RCDatabaseManager flushPendingWrites]: one transaction per batch.
+static bool RCCommitPendingWrites(RCBenchCapture *capture) {
+    capture->writeBehindDeadline = 0;
+    if (capture->pendingCount == 0) {
+        return true;
+    }
+    uint64_t started = RCBenchNowNanoseconds();
+    bool ok = RCBenchExec(capture->db, "BEGIN IMMEDIATE");
+    for (size_t index = 0; ok && index < capture->pendingCount; index++) {
+        RCPendingWrite *write = &capture->pending[index];
+        if (!write->isInsert) {
+            sqlite3_bind_int64(capture->updateTime, 1, write->updateTime);
+            sqlite3_bind_blob(capture->updateTime, 2, write->digest, sizeof(write->digest), SQLITE_STATIC);
+            ok = sqlite3_step(capture->updateTime) == SQLITE_DONE;
+            sqlite3_reset(capture->updateTime);
+            continue;
+        }
+        sqlite3_bind_text(capture->insert, 1, write->dataPath, -1, SQLITE_STATIC);
+        sqlite3_bind_text(capture->insert, 2, write->title != NULL ? write->title : "", -1, SQLITE_STATIC);
+        sqlite3_bind_blob(capture->insert, 3, write->digest, sizeof(write->digest), SQLITE_STATIC);
+        sqlite3_bind_text(capture->insert, 4, write->primaryType, -1, SQLITE_STATIC);
+        sqlite3_bind_int64(capture->insert, 5, write->updateTime);
+        sqlite3_bind_int64(capture->insert, 6, write->dataSize);
+        ok = sqlite3_step(capture->insert) == SQLITE_DONE;
+        sqlite3_reset(capture->insert);
+        if (ok && write->body != NULL) {
+            sqlite3_bind_int64(capture->insertSearch, 1, sqlite3_last_insert_rowid(capture->db));
+            sqlite3_bind_text(capture->insertSearch, 2, write->body, -1, SQLITE_STATIC);
+            ok = sqlite3_step(capture->insertSearch) == SQLITE_DONE;
+            sqlite3_reset(capture->insertSearch);
+        }
+        capture->counters.inserted += ok ? 1 : 0;
+    }
+    if (!ok) {
+        fprintf(stderr, "write-behind flush failed: %s\n", sqlite3_errmsg(capture->db));
+        RCBenchExec(capture->db, "ROLLBACK");
+    } else {
+        ok = RCBenchExec(capture->db, "COMMIT");
+    }
+    capture->counters.transactions++;
+
+    uint64_t commit = RCBenchNowNanoseconds() - started;
+    for (size_t index = 0; index < capture->pendingCount; index++) {
+        RCBenchSamplesAppend(&capture->latencies, capture->pending[index].costNanoseconds + commit);
+        RCPendingWriteFree(&capture->pending[index]);
+    }
+    capture->pendingCount = 0;
+    return ok;
+}
+
+// -[RCDataCleanService evictHistoryWithDatabaseManager:honoringHistoryLimit:]
+static bool RCRunCleanup(RCBenchCapture *capture) {
+    capture->cleanupDeadline = 0;
+    if (!RCCommitPendingWrites(capture)) {
+        return false;
+    }
+    long limit = capture->configuration.historyLimit;
+    uint64_t expiry = capture->configuration.expiryNanoseconds;
+    if (limit <= 0 && expiry == 0) {
+        return true;
+    }
+    // expiryCutoffTimestampMs: NSIntegerMin when auto-expiry is off
+    int64_t cutoff = expiry != 0 ? RCUpdateTimeAt(capture->now) - (int64_t)(expiry / 1000000ull) : INT64_MIN;
+    capture->counters.cleanups++;
+    bool ok = RCBenchExec(capture->db, "BEGIN IMMEDIATE");
+    sqlite3_bind_int64(capture->evict, 1, cutoff);
+    capture->expiryCutoff = cutoff;
+    sqlite3_bind_int64(capture->evict, 2, limit > 0 ? limit : INT64_MAX);
+    size_t pathCount = 0;
+    size_t pathCapacity = 0;
+    char **paths = NULL;
+    int result = SQLITE_DONE;
+    while (ok && (result = sqlite3_step(capture->evict)) == SQLITE_ROW) {
+        if (pathCount == pathCapacity) {
+            pathCapacity = pathCapacity == 0 ? 64 : pathCapacity * 2;
+            char **grown = realloc(paths, pathCapacity * sizeof(*paths));
+            if (grown == NULL) {
+                ok = false;
+                break;
+            }
+            paths = grown;
+        }
+        paths[pathCount++] = strdup((const char *)sqlite3_column_text(capture->evict, 0));
+        RCDigestFilterRemove(capture->filter, sqlite3_column_blob(capture->evict, 1),
+                             (size_t)sqlite3_column_bytes(capture->evict, 1));
+    }
+    ok = ok && result == SQLITE_DONE;
+    sqlite3_reset(capture->evict);
+    ok = ok && RCBenchExec(capture->db, "COMMIT");
+    if (!ok) {
+        fprintf(stderr, "cleanup failed: %s\n", sqlite3_errmsg(capture->db));
+        RCBenchExec(capture->db, "ROLLBACK");
+    }
+    capture->counters.transactions++;
+    for (size_t index = 0; index < pathCount; index++) {
+        // removeFilesForClipItems: only once the rows are gone
+        if (ok) {
+            capture->counters.evicted++;
+            capture->counters.clipFilesRemoved += paths[index] != NULL && unlink(paths[index]) == 0 ? 1 : 0;
+        }
+        free(paths[index]);
+    }
+    free(paths);
+    return ok;
+}
+
+// MARK: - Poll loop
+
+static bool RCReleaseHeldJobs(RCBenchCapture *capture, bool force) {
+    void *items[RC_BURST_COALESCER_MAX_KEEP];
+    size_t count = force ? RCBurstCoalescerFlush(&capture->coalescer, items)
+                         : RCBurstCoalescerSettle(&capture->coalescer, capture->now, items);
+    bool ok = true;
+    for (size_t index = 0; index < count; index++) {
+        ok = RCProcessJob(capture, items[index]) && ok;
+    }
+    return ok;
+}
+
+// -[RCClipboardService offerCaptureJobOnMonitoringQueue:]
+static bool RCOfferJob(RCBenchCapture *capture, RCCaptureJob *job, const char *sourceBundleIdentifier) {
+    const char *excluded = capture->configuration.excludedBundleIdentifier;
+    if (excluded != NULL && sourceBundleIdentifier != NULL && strcmp(excluded, sourceBundleIdentifier) == 0) {
+        capture->counters.excluded++;
+        RCCaptureJobFree(job);
+        return true;
+    }
+    void *dropped = NULL;
+    RCBurstDecision decision = RCBurstCoalescerOffer(&capture->coalescer, capture->now, RCBurstKeyForJob(job), job, &dropped);
+    if (dropped != NULL) {
+        capture->counters.coalesced++;
+        RCCaptureJobFree(dropped);
+    }
+    return decision == RCBurstDecisionHold || RCProcessJob(capture, job);
+}
+
+bool RCBenchCapturePoll(RCBenchCapture *capture, uint64_t now) {
+    capture->now = now > capture->now ? now : capture->now;
+    capture->counters.polls++;
+    bool ok = true;
+    bool changed = capture->pasteboard->changeCount != capture->cachedChangeCount;
+    if (changed) {
+        uint64_t started = RCBenchNowNanoseconds();
+        capture->cachedChangeCount = capture->pasteboard->changeCount;
+        capture->counters.changes++;
+        RCCaptureJob *job = RCSnapshotPasteboard(capture);
+        if (job != NULL) {
+            job->costNanoseconds = RCBenchNowNanoseconds() - started;
+            ok = RCOfferJob(capture, job, capture->pasteboard->contents.sourceBundleIdentifier);
+        }
+    }
+    RCPollSchedulerRecordPoll(&capture->scheduler, capture->now, changed);
+    return RCReleaseHeldJobs(capture, false) && ok;
+}
+
+bool RCBenchCaptureFlush(RCBenchCapture *capture, uint64_t now) {
+    capture->now = now > capture->now ? now : capture->now;
+    bool ok = RCReleaseHeldJobs(capture, true);
+    ok = RCCommitPendingWrites(capture) && ok;
+    if (capture->cleanupDeadline != 0) {
+        ok = RCRunCleanup(capture) && ok;
+    }
+    return ok;
+}
+
+// Earliest of the poll timer, the burst settle deadline, the write-behind
+// flush and the debounced and periodic cleanups.
+static uint64_t RCNextDeadline(const RCBenchCapture *capture) {
+    uint64_t next = RCPollSchedulerNextPollNanoseconds(&capture->scheduler);
+    uint64_t deadlines[] = {
+        RCBurstCoalescerSettleDeadline(&capture->coalescer),
+        capture->writeBehindDeadline,
+        capture->cleanupDeadline,
+        capture->periodicCleanupDeadline,
+    };
+    for (size_t index = 0; index < sizeof(deadlines) / sizeof(deadlines[0]); index++) {
+        next = deadlines[index] != 0 && deadlines[index] < next ? deadlines[index] : next;
+    }
+    return next;
+}
+
+static bool RCRunDeadline(RCBenchCapture *capture, uint64_t now) {
+    capture->now = now > capture->now ? now : capture->now;
+    bool ok = true;
+    if (capture->writeBehindDeadline != 0 && capture->writeBehindDeadline <= capture->now) {
+        ok = RCCommitPendingWrites(capture) && ok;
+    }
+    if (capture->cleanupDeadline != 0 && capture->cleanupDeadline <= capture->now) {
+        ok = RCRunCleanup(capture) && ok;
+    }
+    if (capture->periodicCleanupDeadline != 0 && capture->periodicCleanupDeadline <= capture->now) {
+        capture->periodicCleanupDeadline += capture->configuration.cleanupIntervalNanoseconds;
+        ok = RCRunCleanup(capture) && ok;
+    }
+    if (RCPollSchedulerNextPollNanoseconds(&capture->scheduler) <= capture->now) {
+        ok = RCBenchCapturePoll(capture, capture->now) && ok;
+    } else {
+        // a settle deadline before the next poll (armPollTimerOnMonitoringQueue)
+        ok = RCReleaseHeldJobs(capture, false) && ok;
+    }
+    return ok;
+}
+
+bool RCBenchCaptureRunScript(RCBenchCapture *capture, const RCReplayEvent *events, size_t count) {
+    bool ok = true;
+    size_t index = 0;
+    while (index < count) {
+        const RCReplayEvent *event = &events[index];
+        uint64_t next = RCNextDeadline(capture);
+        if (next < event->atNanoseconds) {
+            ok = RCRunDeadline(capture, next) && ok;
+            continue;
+        }
+        capture->now = event->atNanoseconds > capture->now ? event->atNanoseconds : capture->now;
+        switch (event->kind) {
+            case RCReplayEventCopy:
+                RCBenchPasteboardCopy(capture->pasteboard, &event->contents);
+                break;
+            case RCReplayEventTouch:
+                RCBenchPasteboardAdvanceChangeCount(capture->pasteboard, 1);
+                break;
+            case RCReplayEventActivity:
+                if (RCPollSchedulerNoteActivity(&capture->scheduler, capture->now)) {
+                    ok = RCBenchCapturePoll(capture, capture->now) && ok;
+                }
+                break;
+        }
+        index++;
+    }
+    ok = RCBenchCapturePoll(capture, RCNextDeadline(capture)) && ok;
+    return RCBenchCaptureFlush(capture, capture->now) && ok;
+}
+
+// MARK: - Verification
+
+static int64_t RCQueryInteger(sqlite3 *db, const char *sql, int64_t bound) {
+    sqlite3_stmt *statement = NULL;
+    int64_t value = -1;
+    if (sqlite3_prepare_v2(db, sql, -1, &statement, NULL) == SQLITE_OK) {
+        if (sqlite3_bind_parameter_count(statement) > 0) {
+            sqlite3_bind_int64(statement, 1, bound);
+        }
+        if (sqlite3_step(statement) == SQLITE_ROW) {
+            value = sqlite3_column_int64(statement, 0);
+        }
+    }
+    sqlite3_finalize(statement);
+    return value;
+}
+
+static long RCCountClipFiles(const char *clipDirectory) {
+    DIR *directory = opendir(clipDirectory);
+    if (directory == NULL) {
+        return -1;
+    }
+    long count = 0;
+    struct dirent *entry = NULL;
+    while ((entry = readdir(directory)) != NULL) {
+        size_t length = strlen(entry->d_name);
+        count += length > 7 && strcmp(entry->d_name + length - 7, ".rcclip") == 0 ? 1 : 0;
+    }
+    closedir(directory);
+    return count;
+}
+
+bool RCBenchCaptureVerify(RCBenchCapture *capture) {
+    const RCBenchCaptureCounters *counters = &capture->counters;
+    long limit = capture->configuration.historyLimit;
+    int64_t rows = RCQueryInteger(capture->db, "SELECT count(*) FROM clip_items", 0);
+    int64_t expired = RCQueryInteger(capture->db, "SELECT count(*) FROM clip_items WHERE update_time < ?", capture->expiryCutoff);
+    long files = RCCountClipFiles(capture->clipDirectory);
+    uint64_t skipped = counters->skippedMarked + counters->skippedDisabled + counters->skippedEmpty + counters->skippedOversized;
+    uint64_t accounted = counters->captured + counters->coalesced + counters->excluded + skipped;
+
+    if (rows < 0 || (limit > 0 && rows > limit)) {
+        fprintf(stderr, "history holds %lld rows, limit %ld\n", (long long)rows, limit);
+    } else if (expired != 0) {
+        fprintf(stderr, "%lld rows older than the expiry cutoff\n", (long long)expired);
+    } else if (files != rows) {
+        fprintf(stderr, "%ld .rcclip files for %lld rows\n", files, (long long)rows);
+    } else if (accounted != counters->changes) {
+        fprintf(stderr, "unaccounted captures: %llu changes, %llu accounted\n",
+                (unsigned long long)counters->changes, (unsigned long long)accounted);
+    } else if (counters->inserted != counters->clipFilesWritten
+               || counters->clipFilesRemoved != counters->evicted) {
+        fprintf(stderr, "%llu rows inserted for %llu files written, %llu rows evicted for %llu files removed\n",
+                (unsigned long long)counters->inserted, (unsigned long long)counters->clipFilesWritten,
+                (unsigned long long)counters->evicted, (unsigned long long)counters->clipFilesRemoved);
+    } else {
+        return true;
+    }
+    return false;
+}
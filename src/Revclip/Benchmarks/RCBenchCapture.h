@@ -0,0 +1,120 @@
+//
+//  RCBenchCapture.h
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Headless mirror of the RCClipboardService capture path, driven by a
+//  scripted RCBenchPasteboard on a virtual clock:
+//
+//    poll (RCPollScheduler) -> snapshot (RCCapturePlan, read budget)
+//      -> burst coalescing (RCBurstCoalescer) -> fingerprint (SHA-256)
+//      -> dedup (in-flight clips, RCDigestFilter, data_hash lookup)
+//      -> persist (.rcclip via RCClipContainer)
+//      -> index (write-behind batches into clip_items / clip_search)
+//      -> cleanup (debounced and periodic DELETE ... RETURNING for the
+//         history limit and expiry, clip files unlinked)
+//
+//  The app runs the stages on separate queues; here they run inline on the
+//  caller's thread, so the per-capture latency is the CPU and I/O cost of
+//  one clip without queueing. Thumbnails and the blob store need AppKit and
+//  are left out. Keep in sync with RCClipboardService / RCDatabaseManager /
+//  RCDataCleanService.
+//
+//  This is a model for Linux CI and runs none of the app's classes. The
+//  capture path itself is measured by RCClipboardCapturePerformanceTests,
+//  which drives RCClipboardService through an RCInMemoryPasteboard.
+//
+
+#ifndef RCBenchCapture_h
+#define RCBenchCapture_h
+
+#include <sqlite3.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RCBenchPasteboard.h"
+#include "RCBenchSupport.h"
+#include "RCBurstCoalescer.h"
+#include "RCPollScheduler.h"
+#include "RCReplayTrace.h"
+
+typedef struct {
+    RCCapturePlan plan;
+    RCPollSchedulerConfiguration poll;
+    RCBurstCoalescerConfiguration burst;
+    /// History size limit (kRCPrefMaxHistorySizeKey).
+    long historyLimit;
+    /// Auto-expiry age (0: disabled, the app default).
+    uint64_t expiryNanoseconds;
+    /// Quiet time after the last insert before the cleanup runs.
+    uint64_t cleanupDelayNanoseconds;
+    /// Period of the cleanup timer (0: none).
+    uint64_t cleanupIntervalNanoseconds;
+    /// Write-behind window and batch size of RCDatabaseManager.
+    uint64_t writeBehindNanoseconds;
+    size_t writeBehindMaxPending;
+    /// Copies from this application are dropped before coalescing (NULL for none).
+    const char *excludedBundleIdentifier;
+} RCBenchCaptureConfiguration;
+
+/// App defaults: every representation, 50 MiB limit, 30 clips, no expiry,
+/// 5 s cleanup debounce, 30 min cleanup timer, 250 ms / 128 write-behind.
+RCBenchCaptureConfiguration RCBenchCaptureDefaultConfiguration(void);
+
+typedef struct {
+    uint64_t polls;
+    uint64_t changes;
+    uint64_t skippedMarked;
+    uint64_t skippedDisabled;
+    uint64_t skippedEmpty;
+    uint64_t skippedOversized;
+    uint64_t excluded;
+    uint64_t coalesced;
+    uint64_t captured;
+    uint64_t duplicates;
+    /// Data hash lookups the digest filter answered without SQLite.
+    uint64_t filterSkips;
+    uint64_t inserted;
+    uint64_t evicted;
+    uint64_t transactions;
+    uint64_t cleanups;
+    uint64_t bytesRead;
+    uint64_t clipFilesWritten;
+    uint64_t clipBytesWritten;
+    uint64_t clipFilesRemoved;
+} RCBenchCaptureCounters;
+
+typedef struct RCBenchCapture RCBenchCapture;
+
+/// Creates a fresh history (WAL database plus clip directory) in `directory`.
+RCBenchCapture *RCBenchCaptureCreate(const char *directory,
+                                     const RCBenchCaptureConfiguration *configuration,
+                                     RCBenchPasteboard *pasteboard);
+/// Flushes pending writes and closes the database. Files stay in place.
+void RCBenchCaptureDestroy(RCBenchCapture *capture);
+
+sqlite3 *RCBenchCaptureDatabase(const RCBenchCapture *capture);
+
+/// Plays `events` (sorted by time) against the pasteboard while polling on
+/// the virtual clock, then polls once more, settles held bursts, flushes the
+/// write-behind batch and runs the final cleanup.
+bool RCBenchCaptureRunScript(RCBenchCapture *capture, const RCReplayEvent *events, size_t count);
+
+/// Single steps, for tests: one poll tick at `now`, and everything due by `now`.
+bool RCBenchCapturePoll(RCBenchCapture *capture, uint64_t now);
+bool RCBenchCaptureFlush(RCBenchCapture *capture, uint64_t now);
+
+void RCBenchCaptureGetCounters(const RCBenchCapture *capture, RCBenchCaptureCounters *outCounters);
+/// Wall time per captured clip, from the start of its snapshot to its row
+/// being committed, minus the time it was held by the coalescer or waited
+/// for the write-behind batch.
+RCBenchSamples *RCBenchCaptureLatencies(RCBenchCapture *capture);
+
+/// Checks the end state after a script: at most historyLimit rows, nothing
+/// older than the last expiry cutoff, exactly one .rcclip per row, and every
+/// detected change counted by one stage. Prints the first violation.
+bool RCBenchCaptureVerify(RCBenchCapture *capture);
+
+#endif /* RCBenchCapture_h */
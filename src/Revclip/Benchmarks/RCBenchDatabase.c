@@ -0,0 +1,319 @@
+//
+//  RCBenchDatabase.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCBenchDatabase.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "RCSearchText.h"
+
+#define RC_CLIP_ITEMS_V2_DEFINITION \
+    "(id INTEGER PRIMARY KEY AUTOINCREMENT, data_path TEXT NOT NULL, title TEXT DEFAULT '', data_hash BLOB UNIQUE NOT NULL CHECK (length(data_hash) = 32), primary_type TEXT DEFAULT '', update_time INTEGER NOT NULL, thumbnail_path TEXT DEFAULT '', is_color_code INTEGER DEFAULT 0, data_size INTEGER NOT NULL DEFAULT 0, fingerprint_version INTEGER NOT NULL DEFAULT 1)"
+
+#define RC_CLIP_STATS_SCHEMA_STATEMENTS \
+    "CREATE TABLE IF NOT EXISTS clip_stats (primary_type TEXT PRIMARY KEY NOT NULL, item_count INTEGER NOT NULL DEFAULT 0, total_size INTEGER NOT NULL DEFAULT 0) WITHOUT ROWID", \
+    "CREATE TRIGGER IF NOT EXISTS clip_items_stats_insert AFTER INSERT ON clip_items BEGIN " \
+        "INSERT INTO clip_stats (primary_type, item_count, total_size) VALUES (coalesce(new.primary_type, ''), 1, new.data_size) " \
+        "ON CONFLICT (primary_type) DO UPDATE SET item_count = item_count + 1, total_size = total_size + excluded.total_size; END", \
+    "CREATE TRIGGER IF NOT EXISTS clip_items_stats_delete AFTER DELETE ON clip_items BEGIN " \
+        "UPDATE clip_stats SET item_count = item_count - 1, total_size = total_size - old.data_size WHERE primary_type = coalesce(old.primary_type, ''); " \
+        "DELETE FROM clip_stats WHERE primary_type = coalesce(old.primary_type, '') AND item_count <= 0; END", \
+    "CREATE TRIGGER IF NOT EXISTS clip_items_stats_update AFTER UPDATE OF primary_type, data_size ON clip_items BEGIN " \
+        "UPDATE clip_stats SET item_count = item_count - 1, total_size = total_size - old.data_size WHERE primary_type = coalesce(old.primary_type, ''); " \
+        "DELETE FROM clip_stats WHERE primary_type = coalesce(old.primary_type, '') AND item_count <= 0; " \
+        "INSERT INTO clip_stats (primary_type, item_count, total_size) VALUES (coalesce(new.primary_type, ''), 1, new.data_size) " \
+        "ON CONFLICT (primary_type) DO UPDATE SET item_count = item_count + 1, total_size = total_size + excluded.total_size; END",
+
+#define RC_CLIP_BLOB_SCHEMA_STATEMENTS \
+    "CREATE TABLE IF NOT EXISTS clip_blobs (digest BLOB PRIMARY KEY NOT NULL CHECK (length(digest) = 32), size INTEGER NOT NULL DEFAULT 0, ref_count INTEGER NOT NULL DEFAULT 0) WITHOUT ROWID", \
+    "CREATE TABLE IF NOT EXISTS clip_blob_refs (clip_id INTEGER NOT NULL, digest BLOB NOT NULL, PRIMARY KEY (clip_id, digest)) WITHOUT ROWID", \
+    "CREATE TABLE IF NOT EXISTS clip_blob_garbage (digest BLOB PRIMARY KEY NOT NULL) WITHOUT ROWID", \
+    "CREATE TRIGGER IF NOT EXISTS clip_items_blob_refs_delete AFTER DELETE ON clip_items BEGIN " \
+        "DELETE FROM clip_blob_refs WHERE clip_id = old.id; END", \
+    "CREATE TRIGGER IF NOT EXISTS clip_blob_refs_insert AFTER INSERT ON clip_blob_refs BEGIN " \
+        "UPDATE clip_blobs SET ref_count = ref_count + 1 WHERE digest = new.digest; " \
+        "DELETE FROM clip_blob_garbage WHERE digest = new.digest; END", \
+    "CREATE TRIGGER IF NOT EXISTS clip_blob_refs_delete AFTER DELETE ON clip_blob_refs BEGIN " \
+        "UPDATE clip_blobs SET ref_count = ref_count - 1 WHERE digest = old.digest; " \
+        "INSERT OR IGNORE INTO clip_blob_garbage (digest) SELECT digest FROM clip_blobs WHERE digest = old.digest AND ref_count <= 0; " \
+        "DELETE FROM clip_blobs WHERE digest = old.digest AND ref_count <= 0; END",
+
+#define RC_ONLINE_MIGRATION_SCHEMA_STATEMENT \
+    "CREATE TABLE IF NOT EXISTS online_migrations (name TEXT PRIMARY KEY NOT NULL, checkpoint INTEGER NOT NULL DEFAULT 0, migrated_rows INTEGER NOT NULL DEFAULT 0, completed INTEGER NOT NULL DEFAULT 0) WITHOUT ROWID"
+
+static const char *const kRCBenchBaseSchemaStatements[] = {
+    "CREATE TABLE IF NOT EXISTS clip_items " RC_CLIP_ITEMS_V2_DEFINITION,
+    "CREATE INDEX IF NOT EXISTS idx_clip_update_time ON clip_items(update_time DESC)",
+    "CREATE TABLE IF NOT EXISTS snippet_folders (id INTEGER PRIMARY KEY AUTOINCREMENT, identifier TEXT UNIQUE NOT NULL, folder_index INTEGER DEFAULT 0, enabled INTEGER DEFAULT 1, title TEXT DEFAULT 'untitled folder')",
+    "CREATE INDEX IF NOT EXISTS idx_folder_index ON snippet_folders(folder_index)",
+    "CREATE TABLE IF NOT EXISTS snippets (id INTEGER PRIMARY KEY AUTOINCREMENT, identifier TEXT UNIQUE NOT NULL, folder_id TEXT NOT NULL REFERENCES snippet_folders(identifier) ON DELETE CASCADE, snippet_index INTEGER DEFAULT 0, enabled INTEGER DEFAULT 1, title TEXT DEFAULT 'untitled snippet', content TEXT DEFAULT '')",
+    "CREATE INDEX IF NOT EXISTS idx_snippet_folder ON snippets(folder_id)",
+    "CREATE INDEX IF NOT EXISTS idx_snippet_index ON snippets(snippet_index)",
+    "CREATE TABLE IF NOT EXISTS schema_version (version INTEGER NOT NULL)",
+    "INSERT INTO schema_version (version) SELECT 7 WHERE NOT EXISTS (SELECT 1 FROM schema_version)",
+    // -[RCDatabaseManager createSearchIndexSchemaInDatabase:]
+    "CREATE VIRTUAL TABLE IF NOT EXISTS clip_search USING fts5(body, tokenize = 'unicode61 remove_diacritics 2', prefix = '2 3 4')",
+    "CREATE VIRTUAL TABLE IF NOT EXISTS snippet_search USING fts5(title, content, tokenize = 'unicode61 remove_diacritics 2', prefix = '2 3 4')",
+    "CREATE TRIGGER IF NOT EXISTS clip_items_search_delete AFTER DELETE ON clip_items BEGIN DELETE FROM clip_search WHERE rowid = old.id; END",
+    "CREATE TRIGGER IF NOT EXISTS snippets_search_insert AFTER INSERT ON snippets BEGIN INSERT INTO snippet_search (rowid, title, content) VALUES (new.id, rc_search_text(new.title), rc_search_text(new.content)); END",
+    "CREATE TRIGGER IF NOT EXISTS snippets_search_update AFTER UPDATE OF title, content ON snippets BEGIN DELETE FROM snippet_search WHERE rowid = old.id; INSERT INTO snippet_search (rowid, title, content) VALUES (new.id, rc_search_text(new.title), rc_search_text(new.content)); END",
+    "CREATE TRIGGER IF NOT EXISTS snippets_search_delete AFTER DELETE ON snippets BEGIN DELETE FROM snippet_search WHERE rowid = old.id; END",
+    // -[RCDatabaseManager createClipStatsSchemaInDatabase:]
+    RC_CLIP_STATS_SCHEMA_STATEMENTS
+    // -[RCDatabaseManager createClipBlobSchemaInDatabase:]
+    RC_CLIP_BLOB_SCHEMA_STATEMENTS
+    // -[RCDatabaseManager createOnlineMigrationSchemaInDatabase:]
+    RC_ONLINE_MIGRATION_SCHEMA_STATEMENT,
+    // -[RCDatabaseManager stampSchemaVersion]
+    "PRAGMA user_version = 7",
+};
+
+// v1: data_hash was a 64-character hex TEXT key.
+static const char *const kRCBenchSchemaV1Statements[] = {
+    "CREATE TABLE IF NOT EXISTS clip_items (id INTEGER PRIMARY KEY AUTOINCREMENT, data_path TEXT NOT NULL, title TEXT DEFAULT '', data_hash TEXT UNIQUE NOT NULL, primary_type TEXT DEFAULT '', update_time INTEGER NOT NULL, thumbnail_path TEXT DEFAULT '', is_color_code INTEGER DEFAULT 0)",
+    "CREATE INDEX IF NOT EXISTS idx_clip_update_time ON clip_items(update_time DESC)",
+    "CREATE TABLE IF NOT EXISTS schema_version (version INTEGER NOT NULL)",
+    "INSERT INTO schema_version (version) SELECT 1 WHERE NOT EXISTS (SELECT 1 FROM schema_version)",
+};
+
+bool RCBenchExec(sqlite3 *db, const char *sql) {
+    char *errorMessage = NULL;
+    if (sqlite3_exec(db, sql, NULL, NULL, &errorMessage) != SQLITE_OK) {
+        fprintf(stderr, "sqlite3_exec failed: %s\n  sql: %s\n", errorMessage ? errorMessage : "?", sql);
+        sqlite3_free(errorMessage);
+        return false;
+    }
+    return true;
+}
+
+sqlite3 *RCBenchOpenWriter(const char *path, RCBenchJournalMode journalMode) {
+    sqlite3 *db = NULL;
+    if (sqlite3_open_v2(path, &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Failed to open %s: %s\n", path, db ? sqlite3_errmsg(db) : "?");
+        sqlite3_close(db);
+        return NULL;
+    }
+
+    sqlite3_busy_timeout(db, 2000);
+    bool configured = RCSearchTextRegisterFunctions(db) == SQLITE_OK
+        && RCBenchExec(db, "PRAGMA foreign_keys = ON")
+        && RCBenchExec(db, "PRAGMA secure_delete = ON")
+        && RCBenchExec(db, "PRAGMA auto_vacuum = INCREMENTAL")
+        && RCBenchExec(db, journalMode == RCBenchJournalModeWAL ? "PRAGMA journal_mode = WAL" : "PRAGMA journal_mode = DELETE");
+    if (!configured) {
+        sqlite3_close(db);
+        return NULL;
+    }
+    return db;
+}
+
+sqlite3 *RCBenchOpenReader(const char *path) {
+    sqlite3 *db = NULL;
+    if (sqlite3_open_v2(path, &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_FULLMUTEX, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Failed to open reader %s: %s\n", path, db ? sqlite3_errmsg(db) : "?");
+        sqlite3_close(db);
+        return NULL;
+    }
+    sqlite3_busy_timeout(db, 2000);
+    return db;
+}
+
+static bool RCBenchExecAll(sqlite3 *db, const char *const *statements, size_t count) {
+    for (size_t index = 0; index < count; index++) {
+        if (!RCBenchExec(db, statements[index])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RCBenchCreateBaseSchema(sqlite3 *db) {
+    return RCBenchExecAll(db, kRCBenchBaseSchemaStatements,
+                          sizeof(kRCBenchBaseSchemaStatements) / sizeof(kRCBenchBaseSchemaStatements[0]));
+}
+
+bool RCBenchCreateSchemaV1(sqlite3 *db) {
+    return RCBenchExecAll(db, kRCBenchSchemaV1Statements,
+                          sizeof(kRCBenchSchemaV1Statements) / sizeof(kRCBenchSchemaV1Statements[0]));
+}
+
+void RCBenchDigestForSeed(uint64_t seed, uint8_t out[32]) {
+    // splitmix64 stream; good enough to look like a SHA-256 digest.
+    uint64_t state = seed;
+    for (int block = 0; block < 4; block++) {
+        state += 0x9E3779B97F4A7C15ull;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        for (int byte = 0; byte < 8; byte++) {
+            out[block * 8 + byte] = (uint8_t)(z >> (56 - byte * 8));
+        }
+    }
+}
+
+void RCBenchHexDigestForSeed(uint64_t seed, char out[65]) {
+    uint8_t digest[32];
+    RCBenchDigestForSeed(seed, digest);
+    RCBenchHexFromBytes(digest, sizeof(digest), out);
+}
+
+void RCBenchHexFromBytes(const uint8_t *bytes, size_t length, char *out) {
+    static const char kHexDigits[] = "0123456789abcdef";
+    for (size_t index = 0; index < length; index++) {
+        out[index * 2] = kHexDigits[bytes[index] >> 4];
+        out[index * 2 + 1] = kHexDigits[bytes[index] & 0x0F];
+    }
+    out[length * 2] = '\0';
+}
+
+bool RCBenchBytesFromHex(const char *hex, size_t hexLength, uint8_t *out) {
+    if (hex == NULL || (hexLength % 2) != 0) {
+        return false;
+    }
+    for (size_t index = 0; index < hexLength; index++) {
+        char character = hex[index];
+        uint8_t nibble;
+        if (character >= '0' && character <= '9') {
+            nibble = (uint8_t)(character - '0');
+        } else if (character >= 'a' && character <= 'f') {
+            nibble = (uint8_t)(character - 'a' + 10);
+        } else if (character >= 'A' && character <= 'F') {
+            nibble = (uint8_t)(character - 'A' + 10);
+        } else {
+            return false;
+        }
+        out[index / 2] = (index % 2 == 0) ? (uint8_t)(nibble << 4) : (uint8_t)(out[index / 2] | nibble);
+    }
+    return true;
+}
+
+int64_t RCBenchDataSizeForSeed(int index) {
+    // Text clips are small; every 7th row is an image (see primary_type below).
+    return (index % 7 == 0) ? 180000 + (index % 97) * 1024 : 200 + (index % 61) * 37;
+}
+
+static bool RCBenchSeed(sqlite3 *db, int count, int64_t baseTimeMs, bool hexKeys) {
+    if (!RCBenchExec(db, "BEGIN IMMEDIATE")) {
+        return false;
+    }
+
+    sqlite3_stmt *statement = NULL;
+    const char *sql = hexKeys
+        ? "INSERT INTO clip_items (data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code) VALUES (?, ?, ?, ?, ?, ?, 0)"
+        : "INSERT INTO clip_items (data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code, data_size, fingerprint_version) VALUES (?, ?, ?, ?, ?, ?, 0, ?, 2)";
+    if (sqlite3_prepare_v2(db, sql, -1, &statement, NULL) != SQLITE_OK) {
+        fprintf(stderr, "prepare failed: %s\n", sqlite3_errmsg(db));
+        RCBenchExec(db, "ROLLBACK");
+        return false;
+    }
+
+    for (int index = 0; index < count; index++) {
+        char dataPath[64];
+        char title[64];
+        snprintf(dataPath, sizeof(dataPath), "%08X-0000-4000-8000-%012X.rcclip", index, index);
+        snprintf(title, sizeof(title), "Synthetic clip %d", index);
+
+        sqlite3_bind_text(statement, 1, dataPath, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(statement, 2, title, -1, SQLITE_TRANSIENT);
+        if (hexKeys) {
+            char hash[65];
+            RCBenchHexDigestForSeed((uint64_t)index, hash);
+            sqlite3_bind_text(statement, 3, hash, 64, SQLITE_TRANSIENT);
+        } else {
+            uint8_t digest[32];
+            RCBenchDigestForSeed((uint64_t)index, digest);
+            sqlite3_bind_blob(statement, 3, digest, sizeof(digest), SQLITE_TRANSIENT);
+        }
+        sqlite3_bind_text(statement, 4, (index % 7 == 0) ? "public.tiff" : "public.utf8-plain-text", -1, SQLITE_STATIC);
+        sqlite3_bind_int64(statement, 5, baseTimeMs + index);
+        sqlite3_bind_text(statement, 6, (index % 7 == 0) ? "thumb.tiff" : "", -1, SQLITE_STATIC);
+        if (!hexKeys) {
+            sqlite3_bind_int64(statement, 7, RCBenchDataSizeForSeed(index));
+        }
+        if (sqlite3_step(statement) != SQLITE_DONE) {
+            fprintf(stderr, "seed insert failed: %s\n", sqlite3_errmsg(db));
+            sqlite3_finalize(statement);
+            RCBenchExec(db, "ROLLBACK");
+            return false;
+        }
+        sqlite3_reset(statement);
+    }
+
+    sqlite3_finalize(statement);
+    return RCBenchExec(db, "COMMIT");
+}
+
+bool RCBenchSeedClipItems(sqlite3 *db, int count, int64_t baseTimeMs) {
+    return RCBenchSeed(db, count, baseTimeMs, false);
+}
+
+bool RCBenchSeedClipItemsV1(sqlite3 *db, int count, int64_t baseTimeMs) {
+    return RCBenchSeed(db, count, baseTimeMs, true);
+}
+
+long RCBenchMigrateClipItemsToV2(sqlite3 *db) {
+    // Mirrors -[RCDatabaseManager migrateClipItemsToBinaryDigestInDatabase:]
+    // (called inside the migrateIfNeeded transaction).
+    if (!RCBenchExec(db, "BEGIN IMMEDIATE")) {
+        return -1;
+    }
+    if (!RCBenchExec(db, "DROP TABLE IF EXISTS clip_items_v2")
+        || !RCBenchExec(db, "CREATE TABLE clip_items_v2 " RC_CLIP_ITEMS_V2_DEFINITION)) {
+        RCBenchExec(db, "ROLLBACK");
+        return -1;
+    }
+
+    sqlite3_stmt *select = NULL;
+    sqlite3_stmt *insert = NULL;
+    if (sqlite3_prepare_v2(db, "SELECT id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code FROM clip_items",
+                           -1, &select, NULL) != SQLITE_OK
+        || sqlite3_prepare_v2(db, "INSERT INTO clip_items_v2 (id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code) VALUES (?, ?, ?, ?, ?, ?, ?, ?)",
+                              -1, &insert, NULL) != SQLITE_OK) {
+        fprintf(stderr, "migration prepare failed: %s\n", sqlite3_errmsg(db));
+        sqlite3_finalize(select);
+        RCBenchExec(db, "ROLLBACK");
+        return -1;
+    }
+
+    long copied = 0;
+    bool failed = false;
+    while (!failed && sqlite3_step(select) == SQLITE_ROW) {
+        uint8_t digest[32];
+        const char *hex = (const char *)sqlite3_column_text(select, 3);
+        if (sqlite3_column_bytes(select, 3) != 64 || !RCBenchBytesFromHex(hex, 64, digest)) {
+            continue;
+        }
+        for (int column = 0; column < 8; column++) {
+            if (column == 3) {
+                sqlite3_bind_blob(insert, 4, digest, sizeof(digest), SQLITE_TRANSIENT);
+            } else {
+                sqlite3_bind_value(insert, column + 1, sqlite3_column_value(select, column));
+            }
+        }
+        if (sqlite3_step(insert) != SQLITE_DONE) {
+            fprintf(stderr, "migration copy failed: %s\n", sqlite3_errmsg(db));
+            failed = true;
+        }
+        sqlite3_reset(insert);
+        copied++;
+    }
+    sqlite3_finalize(select);
+    sqlite3_finalize(insert);
+
+    if (failed
+        || !RCBenchExec(db, "DROP TABLE clip_items")
+        || !RCBenchExec(db, "ALTER TABLE clip_items_v2 RENAME TO clip_items")
+        || !RCBenchExec(db, "CREATE INDEX IF NOT EXISTS idx_clip_update_time ON clip_items(update_time DESC)")
+        || !RCBenchExec(db, "DELETE FROM schema_version")
+        || !RCBenchExec(db, "INSERT INTO schema_version (version) VALUES (2)")) {
+        RCBenchExec(db, "ROLLBACK");
+        return -1;
+    }
+    return RCBenchExec(db, "COMMIT") ? copied : -1;
+}
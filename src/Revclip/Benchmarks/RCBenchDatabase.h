@@ -0,0 +1,60 @@
+//
+//  RCBenchDatabase.h
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Plain-SQLite mirror of the RCDatabaseManager schema and connection setup,
+//  so storage benchmarks exercise the same statements without FMDB/Foundation.
+//  Keep in sync with -[RCDatabaseManager createBaseSchemaInDatabase:].
+//
+
+#ifndef RCBenchDatabase_h
+#define RCBenchDatabase_h
+
+#include <sqlite3.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    RCBenchJournalModeDelete = 0,   // rollback journal (pre-WAL behaviour)
+    RCBenchJournalModeWAL = 1,
+} RCBenchJournalMode;
+
+/// Opens a read-write connection with the pragmas RCDatabaseManager applies
+/// (foreign_keys, secure_delete, auto_vacuum=INCREMENTAL on new files) and
+/// the rc_search_text() function the search triggers call.
+sqlite3 *RCBenchOpenWriter(const char *path, RCBenchJournalMode journalMode);
+
+/// Opens a read-only connection (the RCDatabaseManager read pool flavour).
+sqlite3 *RCBenchOpenReader(const char *path);
+
+bool RCBenchExec(sqlite3 *db, const char *sql);
+/// Current schema (v7: 32-byte BLOB data_hash, FTS5 clip_search / snippet_search,
+/// trigger-maintained clip_stats, reference-counted clip_blobs, online_migrations
+/// checkpoints, per-row fingerprint_version).
+bool RCBenchCreateBaseSchema(sqlite3 *db);
+/// Legacy v1 schema (data_hash is 64-character hex TEXT), for migration runs.
+bool RCBenchCreateSchemaV1(sqlite3 *db);
+
+/// Inserts `count` synthetic clip_items rows in a single transaction.
+/// update_time runs from baseTimeMs upwards in 1 ms steps.
+bool RCBenchSeedClipItems(sqlite3 *db, int count, int64_t baseTimeMs);
+bool RCBenchSeedClipItemsV1(sqlite3 *db, int count, int64_t baseTimeMs);
+/// data_size written for seed row `index` by RCBenchSeedClipItems.
+int64_t RCBenchDataSizeForSeed(int index);
+
+/// Runs the v1 -> v2 clip_items rebuild in one transaction.
+/// Returns the number of copied rows, or -1 on failure.
+long RCBenchMigrateClipItemsToV2(sqlite3 *db);
+
+/// Writes a deterministic 32-byte digest for `seed` (the v2 data_hash key).
+void RCBenchDigestForSeed(uint64_t seed, uint8_t out[32]);
+/// Writes the same digest as a 64-character hex string into out[65].
+void RCBenchHexDigestForSeed(uint64_t seed, char out[65]);
+
+void RCBenchHexFromBytes(const uint8_t *bytes, size_t length, char *out);
+bool RCBenchBytesFromHex(const char *hex, size_t hexLength, uint8_t *out);
+
+#endif /* RCBenchDatabase_h */
@@ -0,0 +1,200 @@
+//
+//  RCBenchIOCounters.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCBenchIOCounters.h"
+
+#include <sqlite3.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/resource.h>
+
+typedef struct {
+    sqlite3_file base;
+    /// The wrapped VFS's file, allocated right after this struct.
+    sqlite3_file *real;
+} RCCountingFile;
+
+static sqlite3_vfs *gRCRealVFS;
+static sqlite3_vfs gRCCountingVFS;
+/// One method table per io_methods version, so the wrapper never offers
+/// more than the wrapped file implements.
+static sqlite3_io_methods gRCCountingMethods[3];
+
+static _Atomic uint64_t gRCSyncs;
+static _Atomic uint64_t gRCWrites;
+static _Atomic uint64_t gRCBytesWritten;
+
+static sqlite3_file *RCReal(sqlite3_file *file) {
+    return ((RCCountingFile *)file)->real;
+}
+
+// MARK: - File methods
+
+static int RCCountingClose(sqlite3_file *file) {
+    return RCReal(file)->pMethods->xClose(RCReal(file));
+}
+
+static int RCCountingRead(sqlite3_file *file, void *buffer, int amount, sqlite3_int64 offset) {
+    return RCReal(file)->pMethods->xRead(RCReal(file), buffer, amount, offset);
+}
+
+static int RCCountingWrite(sqlite3_file *file, const void *buffer, int amount, sqlite3_int64 offset) {
+    int result = RCReal(file)->pMethods->xWrite(RCReal(file), buffer, amount, offset);
+    if (result == SQLITE_OK) {
+        atomic_fetch_add_explicit(&gRCWrites, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&gRCBytesWritten, (uint64_t)amount, memory_order_relaxed);
+    }
+    return result;
+}
+
+static int RCCountingTruncate(sqlite3_file *file, sqlite3_int64 size) {
+    return RCReal(file)->pMethods->xTruncate(RCReal(file), size);
+}
+
+static int RCCountingSync(sqlite3_file *file, int flags) {
+    atomic_fetch_add_explicit(&gRCSyncs, 1, memory_order_relaxed);
+    return RCReal(file)->pMethods->xSync(RCReal(file), flags);
+}
+
+static int RCCountingFileSize(sqlite3_file *file, sqlite3_int64 *outSize) {
+    return RCReal(file)->pMethods->xFileSize(RCReal(file), outSize);
+}
+
+static int RCCountingLock(sqlite3_file *file, int lock) {
+    return RCReal(file)->pMethods->xLock(RCReal(file), lock);
+}
+
+static int RCCountingUnlock(sqlite3_file *file, int lock) {
+    return RCReal(file)->pMethods->xUnlock(RCReal(file), lock);
+}
+
+static int RCCountingCheckReservedLock(sqlite3_file *file, int *outResult) {
+    return RCReal(file)->pMethods->xCheckReservedLock(RCReal(file), outResult);
+}
+
+static int RCCountingFileControl(sqlite3_file *file, int operation, void *argument) {
+    return RCReal(file)->pMethods->xFileControl(RCReal(file), operation, argument);
+}
+
+static int RCCountingSectorSize(sqlite3_file *file) {
+    return RCReal(file)->pMethods->xSectorSize(RCReal(file));
+}
+
+static int RCCountingDeviceCharacteristics(sqlite3_file *file) {
+    return RCReal(file)->pMethods->xDeviceCharacteristics(RCReal(file));
+}
+
+static int RCCountingShmMap(sqlite3_file *file, int region, int size, int extend, void volatile **outAddress) {
+    return RCReal(file)->pMethods->xShmMap(RCReal(file), region, size, extend, outAddress);
+}
+
+static int RCCountingShmLock(sqlite3_file *file, int offset, int count, int flags) {
+    return RCReal(file)->pMethods->xShmLock(RCReal(file), offset, count, flags);
+}
+
+static void RCCountingShmBarrier(sqlite3_file *file) {
+    RCReal(file)->pMethods->xShmBarrier(RCReal(file));
+}
+
+static int RCCountingShmUnmap(sqlite3_file *file, int deleteFlag) {
+    return RCReal(file)->pMethods->xShmUnmap(RCReal(file), deleteFlag);
+}
+
+static int RCCountingFetch(sqlite3_file *file, sqlite3_int64 offset, int amount, void **outPointer) {
+    return RCReal(file)->pMethods->xFetch(RCReal(file), offset, amount, outPointer);
+}
+
+static int RCCountingUnfetch(sqlite3_file *file, sqlite3_int64 offset, void *pointer) {
+    return RCReal(file)->pMethods->xUnfetch(RCReal(file), offset, pointer);
+}
+
+// MARK: - VFS
+
+static int RCCountingOpen(sqlite3_vfs *vfs, const char *name, sqlite3_file *file, int flags, int *outFlags) {
+    (void)vfs;
+    RCCountingFile *countingFile = (RCCountingFile *)file;
+    countingFile->real = (sqlite3_file *)&countingFile[1];
+    int result = gRCRealVFS->xOpen(gRCRealVFS, name, countingFile->real, flags, outFlags);
+    const sqlite3_io_methods *methods = countingFile->real->pMethods;
+    if (methods == NULL) {
+        // xClose is only called when pMethods is set
+        file->pMethods = NULL;
+        return result;
+    }
+    int version = methods->iVersion < 1 ? 1 : methods->iVersion > 3 ? 3 : methods->iVersion;
+    file->pMethods = &gRCCountingMethods[version - 1];
+    return result;
+}
+
+bool RCBenchIOCountersInstall(void) {
+    if (gRCRealVFS != NULL) {
+        return true;
+    }
+    sqlite3_vfs *real = sqlite3_vfs_find(NULL);
+    if (real == NULL) {
+        return false;
+    }
+    for (int index = 0; index < 3; index++) {
+        gRCCountingMethods[index] = (sqlite3_io_methods){
+            .iVersion = index + 1,
+            .xClose = RCCountingClose,
+            .xRead = RCCountingRead,
+            .xWrite = RCCountingWrite,
+            .xTruncate = RCCountingTruncate,
+            .xSync = RCCountingSync,
+            .xFileSize = RCCountingFileSize,
+            .xLock = RCCountingLock,
+            .xUnlock = RCCountingUnlock,
+            .xCheckReservedLock = RCCountingCheckReservedLock,
+            .xFileControl = RCCountingFileControl,
+            .xSectorSize = RCCountingSectorSize,
+            .xDeviceCharacteristics = RCCountingDeviceCharacteristics,
+            .xShmMap = index >= 1 ? RCCountingShmMap : NULL,
+            .xShmLock = index >= 1 ? RCCountingShmLock : NULL,
+            .xShmBarrier = index >= 1 ? RCCountingShmBarrier : NULL,
+            .xShmUnmap = index >= 1 ? RCCountingShmUnmap : NULL,
+            .xFetch = index >= 2 ? RCCountingFetch : NULL,
+            .xUnfetch = index >= 2 ? RCCountingUnfetch : NULL,
+        };
+    }
+    // Everything but xOpen goes straight to the wrapped VFS.
+    gRCCountingVFS = *real;
+    gRCCountingVFS.szOsFile = (int)sizeof(RCCountingFile) + real->szOsFile;
+    gRCCountingVFS.zName = "rc-counting";
+    gRCCountingVFS.pNext = NULL;
+    gRCCountingVFS.xOpen = RCCountingOpen;
+    gRCRealVFS = real;
+    if (sqlite3_vfs_register(&gRCCountingVFS, 1) != SQLITE_OK) {
+        gRCRealVFS = NULL;
+        return false;
+    }
+    return true;
+}
+
+void RCBenchIOCountersGet(RCBenchIOCounters *outCounters) {
+    outCounters->syncs = atomic_load_explicit(&gRCSyncs, memory_order_relaxed);
+    outCounters->writes = atomic_load_explicit(&gRCWrites, memory_order_relaxed);
+    outCounters->bytesWritten = atomic_load_explicit(&gRCBytesWritten, memory_order_relaxed);
+}
+
+void RCBenchIOCountersReset(void) {
+    atomic_store_explicit(&gRCSyncs, 0, memory_order_relaxed);
+    atomic_store_explicit(&gRCWrites, 0, memory_order_relaxed);
+    atomic_store_explicit(&gRCBytesWritten, 0, memory_order_relaxed);
+}
+
+uint64_t RCBenchPeakResidentBytes(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return (uint64_t)usage.ru_maxrss;
+#else
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+}
@@ -0,0 +1,34 @@
+//
+//  RCBenchIOCounters.h
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  I/O accounting for the replay benchmarks: a pass-through SQLite VFS that
+//  counts xSync calls (fsync / F_FULLFSYNC on the database, WAL and journal)
+//  and the bytes SQLite writes, plus the process's peak resident set size.
+//
+
+#ifndef RCBenchIOCounters_h
+#define RCBenchIOCounters_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint64_t syncs;
+    uint64_t writes;
+    uint64_t bytesWritten;
+} RCBenchIOCounters;
+
+/// Registers the counting VFS as the default, wrapping the previous default.
+/// Affects connections opened afterwards. Idempotent.
+bool RCBenchIOCountersInstall(void);
+
+void RCBenchIOCountersGet(RCBenchIOCounters *outCounters);
+void RCBenchIOCountersReset(void);
+
+/// Peak resident set size of this process so far, in bytes.
+uint64_t RCBenchPeakResidentBytes(void);
+
+#endif /* RCBenchIOCounters_h */
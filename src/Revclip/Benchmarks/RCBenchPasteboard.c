@@ -0,0 +1,76 @@
+//
+//  RCBenchPasteboard.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCBenchPasteboard.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static bool RCIsTextRepresentation(RCClipRepresentation representation) {
+    return representation == RCClipRepresentationString
+        || representation == RCClipRepresentationURL
+        || representation == RCClipRepresentationFiles;
+}
+
+void RCBenchPasteboardInit(RCBenchPasteboard *pasteboard) {
+    memset(pasteboard, 0, sizeof(*pasteboard));
+    pasteboard->changeCount = 1;
+}
+
+int64_t RCBenchPasteboardCopy(RCBenchPasteboard *pasteboard, const RCBenchPasteboardContents *contents) {
+    pasteboard->contents = *contents;
+    pasteboard->changeCount++;
+    return pasteboard->changeCount;
+}
+
+void RCBenchPasteboardAdvanceChangeCount(RCBenchPasteboard *pasteboard, int64_t delta) {
+    pasteboard->changeCount += delta > 0 ? delta : 0;
+}
+
+RCClipRepresentationMask RCBenchPasteboardTypes(const RCBenchPasteboard *pasteboard, bool *outMarked) {
+    if (outMarked != NULL) {
+        *outMarked = pasteboard->contents.marked;
+    }
+    return pasteboard->contents.offered;
+}
+
+void RCBenchPasteboardFillPayload(uint64_t seed, RCClipRepresentation representation, uint8_t *bytes, size_t length) {
+    // splitmix64, 8 bytes per step
+    uint64_t state = seed ^ ((uint64_t)representation << 56);
+    bool text = RCIsTextRepresentation(representation);
+    for (size_t index = 0; index < length; index += 8) {
+        state += 0x9E3779B97F4A7C15ull;
+        uint64_t mixed = state;
+        mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ull;
+        mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBull;
+        mixed ^= mixed >> 31;
+        size_t count = length - index < 8 ? length - index : 8;
+        for (size_t byte = 0; byte < count; byte++) {
+            uint8_t value = (uint8_t)(mixed >> (byte * 8));
+            bytes[index + byte] = text ? (uint8_t)('a' + value % 26) : value;
+        }
+    }
+}
+
+uint8_t *RCBenchPasteboardRead(RCBenchPasteboard *pasteboard,
+                               RCClipRepresentation representation,
+                               size_t *outLength) {
+    *outLength = 0;
+    if ((pasteboard->contents.offered & representation) == 0) {
+        return NULL;
+    }
+    size_t length = pasteboard->contents.length;
+    uint8_t *bytes = malloc(length > 0 ? length : 1);
+    if (bytes == NULL) {
+        return NULL;
+    }
+    RCBenchPasteboardFillPayload(pasteboard->contents.seed, representation, bytes, length);
+    pasteboard->readCount++;
+    pasteboard->bytesRead += length;
+    *outLength = length;
+    return bytes;
+}
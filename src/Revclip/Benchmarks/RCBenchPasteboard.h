@@ -0,0 +1,65 @@
+//
+//  RCBenchPasteboard.h
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Scripted in-memory pasteboard, the C counterpart of RCInMemoryPasteboard
+//  (Services/RCPasteboardProvider.h), so the capture path can be driven
+//  without a window server. A copy replaces the contents and bumps the
+//  change count; the bytes of each representation are generated on read
+//  from the copy's seed, so re-copying the same seed yields the same clip
+//  and a large scripted payload costs nothing until the capture reads it.
+//
+
+#ifndef RCBenchPasteboard_h
+#define RCBenchPasteboard_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RCCapturePlan.h"
+
+/// One scripted copy.
+typedef struct {
+    /// Representations offered (RCClipRepresentation bits).
+    RCClipRepresentationMask offered;
+    /// A concealed / transient / auto-generated marker type is present.
+    bool marked;
+    /// Bytes per offered representation (text representations get ASCII).
+    size_t length;
+    /// Content seed: the same seed and representations give the same bytes.
+    uint64_t seed;
+    /// Frontmost application at copy time (not copied; may be NULL).
+    const char *sourceBundleIdentifier;
+} RCBenchPasteboardContents;
+
+typedef struct {
+    int64_t changeCount;
+    RCBenchPasteboardContents contents;
+    uint64_t readCount;
+    uint64_t bytesRead;
+} RCBenchPasteboard;
+
+void RCBenchPasteboardInit(RCBenchPasteboard *pasteboard);
+
+/// Replaces the contents and returns the new change count.
+int64_t RCBenchPasteboardCopy(RCBenchPasteboard *pasteboard, const RCBenchPasteboardContents *contents);
+/// Bumps the change count without changing the contents (several copies
+/// between two polls, or an app rewriting the same data).
+void RCBenchPasteboardAdvanceChangeCount(RCBenchPasteboard *pasteboard, int64_t delta);
+
+/// Representations on offer and whether a marker type is present. Reads no data.
+RCClipRepresentationMask RCBenchPasteboardTypes(const RCBenchPasteboard *pasteboard, bool *outMarked);
+
+/// Reads one representation into a newly allocated buffer (caller frees) and
+/// counts it. Returns NULL with *outLength = 0 when it is not on offer.
+uint8_t *RCBenchPasteboardRead(RCBenchPasteboard *pasteboard,
+                               RCClipRepresentation representation,
+                               size_t *outLength);
+
+/// Fills `bytes` with the deterministic payload for (seed, representation).
+void RCBenchPasteboardFillPayload(uint64_t seed, RCClipRepresentation representation, uint8_t *bytes, size_t length);
+
+#endif /* RCBenchPasteboard_h */
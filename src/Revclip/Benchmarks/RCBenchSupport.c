@@ -0,0 +1,229 @@
+//
+//  RCBenchSupport.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCBenchSupport.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+uint64_t RCBenchNowNanoseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+void RCBenchSleepMicroseconds(uint64_t microseconds) {
+    struct timespec duration = {
+        .tv_sec = (time_t)(microseconds / 1000000ull),
+        .tv_nsec = (long)((microseconds % 1000000ull) * 1000ull),
+    };
+    while (nanosleep(&duration, &duration) != 0 && errno == EINTR) {
+    }
+}
+
+void RCBenchSamplesInit(RCBenchSamples *samples, size_t initialCapacity) {
+    samples->capacity = initialCapacity > 0 ? initialCapacity : 1024;
+    samples->values = malloc(samples->capacity * sizeof(uint64_t));
+    samples->count = 0;
+    samples->sorted = true;
+    if (samples->values == NULL) {
+        fprintf(stderr, "RCBenchSamplesInit: out of memory\n");
+        exit(1);
+    }
+}
+
+void RCBenchSamplesAppend(RCBenchSamples *samples, uint64_t value) {
+    if (samples->count == samples->capacity) {
+        size_t newCapacity = samples->capacity * 2;
+        uint64_t *values = realloc(samples->values, newCapacity * sizeof(uint64_t));
+        if (values == NULL) {
+            fprintf(stderr, "RCBenchSamplesAppend: out of memory\n");
+            exit(1);
+        }
+        samples->values = values;
+        samples->capacity = newCapacity;
+    }
+    samples->values[samples->count++] = value;
+    samples->sorted = false;
+}
+
+void RCBenchSamplesAppendAll(RCBenchSamples *destination, const RCBenchSamples *source) {
+    for (size_t index = 0; index < source->count; index++) {
+        RCBenchSamplesAppend(destination, source->values[index]);
+    }
+}
+
+static int RCBenchCompareUInt64(const void *lhs, const void *rhs) {
+    uint64_t a = *(const uint64_t *)lhs;
+    uint64_t b = *(const uint64_t *)rhs;
+    return (a > b) - (a < b);
+}
+
+uint64_t RCBenchSamplesPercentile(RCBenchSamples *samples, double percentile) {
+    if (samples->count == 0) {
+        return 0;
+    }
+    if (!samples->sorted) {
+        qsort(samples->values, samples->count, sizeof(uint64_t), RCBenchCompareUInt64);
+        samples->sorted = true;
+    }
+    if (percentile <= 0.0) {
+        return samples->values[0];
+    }
+    if (percentile >= 100.0) {
+        return samples->values[samples->count - 1];
+    }
+    size_t rank = (size_t)((percentile / 100.0) * (double)(samples->count - 1) + 0.5);
+    return samples->values[rank];
+}
+
+void RCBenchSamplesFree(RCBenchSamples *samples) {
+    free(samples->values);
+    samples->values = NULL;
+    samples->count = 0;
+    samples->capacity = 0;
+}
+
+void RCBenchPrintLatencyRow(const char *label, RCBenchSamples *samples) {
+    printf("%-28s n=%-8zu p50=%9.1fus  p99=%9.1fus  max=%9.1fus\n",
+           label,
+           samples->count,
+           (double)RCBenchSamplesPercentile(samples, 50.0) / 1000.0,
+           (double)RCBenchSamplesPercentile(samples, 99.0) / 1000.0,
+           (double)RCBenchSamplesPercentile(samples, 100.0) / 1000.0);
+}
+
+char *RCBenchCreateScratchDirectory(const char *prefix) {
+    const char *temporaryDirectory = getenv("TMPDIR");
+    if (temporaryDirectory == NULL || temporaryDirectory[0] == '\0') {
+        temporaryDirectory = "/tmp";
+    }
+
+    size_t length = strlen(temporaryDirectory) + strlen(prefix) + 16;
+    char *path = malloc(length);
+    if (path == NULL) {
+        return NULL;
+    }
+    snprintf(path, length, "%s/%s.XXXXXX", temporaryDirectory, prefix);
+    if (mkdtemp(path) == NULL) {
+        perror("mkdtemp");
+        free(path);
+        return NULL;
+    }
+    return path;
+}
+
+void RCBenchRemoveScratchDirectory(const char *path) {
+    if (path == NULL) {
+        return;
+    }
+
+    DIR *directory = opendir(path);
+    if (directory != NULL) {
+        struct dirent *entry = NULL;
+        while ((entry = readdir(directory)) != NULL) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+            char *childPath = RCBenchPathJoin(path, entry->d_name);
+            struct stat status;
+            if (childPath != NULL && lstat(childPath, &status) == 0) {
+                if (S_ISDIR(status.st_mode)) {
+                    RCBenchRemoveScratchDirectory(childPath);
+                } else {
+                    unlink(childPath);
+                }
+            }
+            free(childPath);
+        }
+        closedir(directory);
+    }
+    rmdir(path);
+}
+
+char *RCBenchPathJoin(const char *directory, const char *name) {
+    size_t length = strlen(directory) + strlen(name) + 2;
+    char *path = malloc(length);
+    if (path != NULL) {
+        snprintf(path, length, "%s/%s", directory, name);
+    }
+    return path;
+}
+
+bool RCBenchCopyFile(const char *sourcePath, const char *destinationPath) {
+    int source = open(sourcePath, O_RDONLY);
+    if (source < 0) {
+        fprintf(stderr, "open %s failed: %s\n", sourcePath, strerror(errno));
+        return false;
+    }
+    int destination = open(destinationPath, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (destination < 0) {
+        fprintf(stderr, "open %s failed: %s\n", destinationPath, strerror(errno));
+        close(source);
+        return false;
+    }
+
+    char buffer[1 << 16];
+    bool copied = true;
+    ssize_t readCount;
+    while (copied && (readCount = read(source, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t offset = 0; offset < readCount;) {
+            ssize_t written = write(destination, buffer + offset, (size_t)(readCount - offset));
+            if (written < 0) {
+                copied = false;
+                break;
+            }
+            offset += written;
+        }
+    }
+    copied = copied && readCount == 0 && fsync(destination) == 0;
+    close(source);
+    close(destination);
+    if (!copied) {
+        fprintf(stderr, "copy %s -> %s failed: %s\n", sourcePath, destinationPath, strerror(errno));
+    }
+    return copied;
+}
+
+bool RCBenchEvictFromPageCache(const char *path) {
+#if defined(__linux__)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return errno == ENOENT;
+    }
+    bool evicted = fdatasync(fd) == 0 && posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return evicted;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+long RCBenchIntegerOption(int argc, char **argv, const char *name, long defaultValue) {
+    const char *value = RCBenchStringOption(argc, argv, name, NULL);
+    if (value == NULL) {
+        return defaultValue;
+    }
+    return strtol(value, NULL, 10);
+}
+
+const char *RCBenchStringOption(int argc, char **argv, const char *name, const char *defaultValue) {
+    for (int index = 1; index + 1 < argc; index++) {
+        if (strcmp(argv[index], name) == 0) {
+            return argv[index + 1];
+        }
+    }
+    return defaultValue;
+}
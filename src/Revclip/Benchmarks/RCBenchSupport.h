@@ -0,0 +1,54 @@
+//
+//  RCBenchSupport.h
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Shared helpers for the headless (Linux / macOS) benchmarks: monotonic
+//  clock, latency sample buffers with percentiles, and scratch directories.
+//
+
+#ifndef RCBenchSupport_h
+#define RCBenchSupport_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint64_t *values;
+    size_t count;
+    size_t capacity;
+    bool sorted;
+} RCBenchSamples;
+
+uint64_t RCBenchNowNanoseconds(void);
+void RCBenchSleepMicroseconds(uint64_t microseconds);
+
+void RCBenchSamplesInit(RCBenchSamples *samples, size_t initialCapacity);
+void RCBenchSamplesAppend(RCBenchSamples *samples, uint64_t value);
+void RCBenchSamplesAppendAll(RCBenchSamples *destination, const RCBenchSamples *source);
+uint64_t RCBenchSamplesPercentile(RCBenchSamples *samples, double percentile);
+void RCBenchSamplesFree(RCBenchSamples *samples);
+
+/// Prints "label  n=...  p50=...  p99=...  max=..." with microsecond units.
+void RCBenchPrintLatencyRow(const char *label, RCBenchSamples *samples);
+
+/// Creates a private scratch directory under $TMPDIR (0700). Caller frees.
+char *RCBenchCreateScratchDirectory(const char *prefix);
+void RCBenchRemoveScratchDirectory(const char *path);
+
+/// Joins a directory and a file name into a newly allocated path.
+char *RCBenchPathJoin(const char *directory, const char *name);
+
+/// Copies a file and fsyncs the copy.
+bool RCBenchCopyFile(const char *sourcePath, const char *destinationPath);
+/// Drops a file's clean pages from the OS page cache so the next read is cold
+/// (posix_fadvise on Linux). Returns false where that is unsupported (macOS).
+bool RCBenchEvictFromPageCache(const char *path);
+
+/// Parses "--name value" style options; returns defaultValue when absent.
+long RCBenchIntegerOption(int argc, char **argv, const char *name, long defaultValue);
+const char *RCBenchStringOption(int argc, char **argv, const char *name, const char *defaultValue);
+
+#endif /* RCBenchSupport_h */
@@ -0,0 +1,171 @@
+//
+//  RCBurstCoalescerTests.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Unit tests for clipboard burst coalescing (Revclip/Core/RCBurstCoalescer),
+//  driven by a simulated clock: sparse changes pass straight through, a
+//  burst keeps only its last distinct states and counts the dropped ones,
+//  repeats of a held state replace it, and the held states are released
+//  once the burst settles or is flushed. A simulated automation loop reports
+//  how many captures reach the pipeline with and without coalescing.
+//
+//  Usage: RCBurstCoalescerTests
+//
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "RCBurstCoalescer.h"
+#include "RCTestSupport.h"
+
+#define RC_MS(milliseconds) ((uint64_t)(milliseconds) * 1000000ULL)
+
+static void *RCItem(uint64_t value) {
+    return (void *)(uintptr_t)value;
+}
+
+static void TestSparseChangesPass(void) {
+    RCBurstCoalescerConfiguration configuration = RCBurstCoalescerDefaultConfiguration();
+    RCBurstCoalescer coalescer;
+    RCBurstCoalescerInit(&coalescer, &configuration);
+
+    void *dropped = RCItem(99);
+    for (uint64_t i = 1; i <= 20; i++) {
+        RC_TEST_ASSERT_EQUAL(RCBurstDecisionPass, RCBurstCoalescerOffer(&coalescer, RC_MS(300) * i, i, RCItem(i), &dropped));
+        RC_TEST_ASSERT(dropped == NULL);
+    }
+    // Two quick changes are not a burst yet.
+    RC_TEST_ASSERT_EQUAL(RCBurstDecisionPass, RCBurstCoalescerOffer(&coalescer, RC_MS(6100), 21, RCItem(21), &dropped));
+    RC_TEST_ASSERT(!RCBurstCoalescerIsInBurst(&coalescer));
+    RC_TEST_ASSERT_EQUAL(0, RCBurstCoalescerSettleDeadline(&coalescer));
+    RC_TEST_ASSERT_EQUAL(0, RCBurstCoalescerBurstCount(&coalescer));
+}
+
+static void TestBurstKeepsFinalState(void) {
+    RCBurstCoalescerConfiguration configuration = RCBurstCoalescerDefaultConfiguration();
+    RCBurstCoalescer coalescer;
+    RCBurstCoalescerInit(&coalescer, &configuration);
+
+    uint64_t passed = 0;
+    uint64_t droppedItems = 0;
+    uint64_t now = RC_MS(1000);
+    for (uint64_t i = 1; i <= 100; i++) {
+        now += RC_MS(50);
+        void *dropped = NULL;
+        if (RCBurstCoalescerOffer(&coalescer, now, i, RCItem(i), &dropped) == RCBurstDecisionPass) {
+            passed++;
+        }
+        droppedItems += dropped != NULL ? 1 : 0;
+    }
+    RC_TEST_ASSERT_EQUAL(2, passed);
+    RC_TEST_ASSERT_EQUAL(97, droppedItems);
+    RC_TEST_ASSERT_EQUAL(97, RCBurstCoalescerDroppedStateCount(&coalescer));
+    RC_TEST_ASSERT_EQUAL(1, RCBurstCoalescerHeldCount(&coalescer));
+    RC_TEST_ASSERT_EQUAL(1, RCBurstCoalescerBurstCount(&coalescer));
+    RC_TEST_ASSERT_EQUAL(now + RC_MS(500), RCBurstCoalescerSettleDeadline(&coalescer));
+
+    void *items[RC_BURST_COALESCER_MAX_KEEP];
+    RC_TEST_ASSERT_EQUAL(0, RCBurstCoalescerSettle(&coalescer, now + RC_MS(499), items));
+    RC_TEST_ASSERT_EQUAL(1, RCBurstCoalescerSettle(&coalescer, now + RC_MS(500), items));
+    RC_TEST_ASSERT(items[0] == RCItem(100));
+    RC_TEST_ASSERT(!RCBurstCoalescerIsInBurst(&coalescer));
+    RC_TEST_ASSERT_EQUAL(0, RCBurstCoalescerSettle(&coalescer, now + RC_MS(5000), items));
+
+    // The next change after the burst settled passes again.
+    void *dropped = NULL;
+    RC_TEST_ASSERT_EQUAL(RCBurstDecisionPass, RCBurstCoalescerOffer(&coalescer, now + RC_MS(600), 101, RCItem(101), &dropped));
+}
+
+static void TestWindowKeepsLastDistinctStates(void) {
+    RCBurstCoalescerConfiguration configuration = RCBurstCoalescerDefaultConfiguration();
+    configuration.burstThreshold = 2;
+    configuration.keepCount = 3;
+    RCBurstCoalescer coalescer;
+    RCBurstCoalescerInit(&coalescer, &configuration);
+
+    void *dropped = NULL;
+    RC_TEST_ASSERT_EQUAL(RCBurstDecisionPass, RCBurstCoalescerOffer(&coalescer, RC_MS(0), 'x', RCItem(1), &dropped));
+    // Burst states: A B A C D. The repeated A replaces the held one; D evicts B.
+    const uint64_t keys[] = { 'A', 'B', 'A', 'C', 'D' };
+    void *expectedDrops[] = { NULL, NULL, RCItem(2), NULL, RCItem(3) };
+    for (size_t i = 0; i < 5; i++) {
+        RC_TEST_ASSERT_EQUAL(RCBurstDecisionHold,
+                             RCBurstCoalescerOffer(&coalescer, RC_MS(10) * (i + 1), keys[i], RCItem(i + 2), &dropped));
+        RC_TEST_ASSERT(dropped == expectedDrops[i]);
+    }
+    RC_TEST_ASSERT_EQUAL(2, RCBurstCoalescerDroppedStateCount(&coalescer));
+
+    void *items[RC_BURST_COALESCER_MAX_KEEP];
+    RC_TEST_ASSERT_EQUAL(3, RCBurstCoalescerFlush(&coalescer, items));
+    RC_TEST_ASSERT(items[0] == RCItem(4));
+    RC_TEST_ASSERT(items[1] == RCItem(5));
+    RC_TEST_ASSERT(items[2] == RCItem(6));
+    RC_TEST_ASSERT_EQUAL(0, RCBurstCoalescerFlush(&coalescer, items));
+
+    RCBurstCoalescerResetCounters(&coalescer);
+    RC_TEST_ASSERT_EQUAL(0, RCBurstCoalescerDroppedStateCount(&coalescer));
+    RC_TEST_ASSERT_EQUAL(0, RCBurstCoalescerBurstCount(&coalescer));
+
+    configuration.burstThreshold = 0;
+    configuration.keepCount = 100;
+    RCBurstCoalescerInit(&coalescer, &configuration);
+    RC_TEST_ASSERT_EQUAL(2, coalescer.configuration.burstThreshold);
+    RC_TEST_ASSERT_EQUAL(RC_BURST_COALESCER_MAX_KEEP, coalescer.configuration.keepCount);
+}
+
+// MARK: Simulated automation
+
+static void TestAutomationLoop(void) {
+    RCBurstCoalescerConfiguration configuration = RCBurstCoalescerDefaultConfiguration();
+    RCBurstCoalescer coalescer;
+    RCBurstCoalescerInit(&coalescer, &configuration);
+
+    // A script copies 2000 lines 10 ms apart; polling at 100 ms sees every
+    // tenth state. Then an hour of sparse manual copies (one a minute).
+    uint64_t observed = 0;
+    uint64_t captured = 0;
+    void *items[RC_BURST_COALESCER_MAX_KEEP];
+    uint64_t now = 0;
+    for (uint64_t poll = 1; poll <= 200; poll++) {
+        now = RC_MS(100) * poll;
+        void *dropped = NULL;
+        observed++;
+        if (RCBurstCoalescerOffer(&coalescer, now, poll, RCItem(poll), &dropped) == RCBurstDecisionPass) {
+            captured++;
+        }
+    }
+    void *settled = NULL;
+    for (uint64_t poll = 1; poll <= 60; poll++) {
+        now += RC_MS(100);
+        size_t count = RCBurstCoalescerSettle(&coalescer, now, items);
+        if (count > 0) {
+            settled = items[count - 1];
+        }
+        captured += count;
+    }
+    RC_TEST_ASSERT(settled == RCItem(200));
+    for (uint64_t minute = 1; minute <= 60; minute++) {
+        now += RC_MS(60000);
+        void *dropped = NULL;
+        observed++;
+        if (RCBurstCoalescerOffer(&coalescer, now, 1000 + minute, RCItem(1000 + minute), &dropped) == RCBurstDecisionPass) {
+            captured++;
+        }
+    }
+
+    printf("     %llu observed changes, %llu captured (was %llu), %llu states dropped\n",
+           (unsigned long long)observed, (unsigned long long)captured, (unsigned long long)observed,
+           (unsigned long long)RCBurstCoalescerDroppedStateCount(&coalescer));
+    RC_TEST_ASSERT_EQUAL(2 + 1 + 60, captured);
+    RC_TEST_ASSERT_EQUAL(197, RCBurstCoalescerDroppedStateCount(&coalescer));
+}
+
+int main(void) {
+    RC_TEST_RUN(TestSparseChangesPass);
+    RC_TEST_RUN(TestBurstKeepsFinalState);
+    RC_TEST_RUN(TestWindowKeepsLastDistinctStates);
+    RC_TEST_RUN(TestAutomationLoop);
+    return RC_TEST_FINISH();
+}
@@ -0,0 +1,175 @@
+//
+//  RCCapturePlanTests.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Unit tests for the pasteboard capture plan (Revclip/Core/RCCapturePlan):
+//  marker and disabled-type verdicts are reached from the type list alone,
+//  only enabled representations are read and in cheapest-first order, and
+//  the budget stops an oversized snapshot at the first representation that
+//  crosses the limit. A simulated snapshot counts the bytes copied against
+//  the read-everything snapshot it replaces.
+//
+//  Usage: RCCapturePlanTests
+//
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "RCCapturePlan.h"
+#include "RCTestSupport.h"
+
+#define RC_MIB (1024ull * 1024ull)
+
+static void TestVerdictsFromTypesAlone(void) {
+    RCCapturePlan plan = RCCapturePlanMake(RC_CLIP_REPRESENTATION_ALL & ~RCClipRepresentationTIFF, 10 * RC_MIB);
+    RCClipRepresentationMask readMask = 0xff;
+
+    RC_TEST_ASSERT_EQUAL(RCCaptureVerdictSkipMarked,
+                         RCCapturePlanEvaluate(&plan, RCClipRepresentationString, true, &readMask));
+    RC_TEST_ASSERT_EQUAL(0, readMask);
+    RC_TEST_ASSERT_EQUAL(RCCaptureVerdictSkipEmpty, RCCapturePlanEvaluate(&plan, 0, false, &readMask));
+    // Bits outside the known representations are ignored.
+    RC_TEST_ASSERT_EQUAL(RCCaptureVerdictSkipEmpty, RCCapturePlanEvaluate(&plan, 1u << 20, false, &readMask));
+    RC_TEST_ASSERT_EQUAL(RCCaptureVerdictSkipDisabled,
+                         RCCapturePlanEvaluate(&plan, RCClipRepresentationTIFF, false, &readMask));
+    RC_TEST_ASSERT_EQUAL(0, readMask);
+
+    RC_TEST_ASSERT_EQUAL(RCCaptureVerdictRead,
+                         RCCapturePlanEvaluate(&plan, RCClipRepresentationString | RCClipRepresentationTIFF, false,
+                                               &readMask));
+    RC_TEST_ASSERT_EQUAL(RCClipRepresentationString, readMask);
+
+    RCCapturePlan everything = RCCapturePlanMake(0xffffffffu, 10 * RC_MIB);
+    RC_TEST_ASSERT_EQUAL(RC_CLIP_REPRESENTATION_ALL, everything.enabled);
+}
+
+static void TestReadOrderIsCheapestFirst(void) {
+    RCClipRepresentation order[RC_CLIP_REPRESENTATION_COUNT];
+    RC_TEST_ASSERT_EQUAL(RC_CLIP_REPRESENTATION_COUNT, RCCapturePlanReadOrder(RC_CLIP_REPRESENTATION_ALL, order));
+    RC_TEST_ASSERT_EQUAL(RCClipRepresentationString, order[0]);
+    RC_TEST_ASSERT_EQUAL(RCClipRepresentationTIFF, order[RC_CLIP_REPRESENTATION_COUNT - 1]);
+
+    size_t count = RCCapturePlanReadOrder(RCClipRepresentationTIFF | RCClipRepresentationPDF | RCClipRepresentationURL,
+                                          order);
+    RC_TEST_ASSERT_EQUAL(3, count);
+    RC_TEST_ASSERT_EQUAL(RCClipRepresentationURL, order[0]);
+    RC_TEST_ASSERT_EQUAL(RCClipRepresentationPDF, order[1]);
+    RC_TEST_ASSERT_EQUAL(RCClipRepresentationTIFF, order[2]);
+    RC_TEST_ASSERT_EQUAL(0, RCCapturePlanReadOrder(0, order));
+}
+
+static void TestBudgetStopsAtLimit(void) {
+    RCCapturePlan plan = RCCapturePlanMake(RC_CLIP_REPRESENTATION_ALL, 100);
+    RCCaptureBudget budget;
+    RCCaptureBudgetInit(&budget, &plan);
+    RC_TEST_ASSERT(RCCaptureBudgetCharge(&budget, 60));
+    RC_TEST_ASSERT(RCCaptureBudgetCharge(&budget, 40));
+    RC_TEST_ASSERT(!RCCaptureBudgetCharge(&budget, 1));
+    RC_TEST_ASSERT(!RCCaptureBudgetCharge(&budget, 0));
+
+    // Saturates instead of wrapping around.
+    RCCaptureBudgetInit(&budget, &plan);
+    RC_TEST_ASSERT(!RCCaptureBudgetCharge(&budget, UINT64_MAX));
+    RC_TEST_ASSERT(!RCCaptureBudgetCharge(&budget, UINT64_MAX));
+    RC_TEST_ASSERT_EQUAL(UINT64_MAX, budget.usedBytes);
+}
+
+// MARK: Simulated snapshot
+
+typedef struct {
+    RCClipRepresentationMask offered;
+    bool marked;
+    uint64_t sizes[RC_CLIP_REPRESENTATION_COUNT];
+} RCSimulatedPasteboard;
+
+static uint64_t RCSimulatedSize(const RCSimulatedPasteboard *pasteboard, RCClipRepresentation representation) {
+    for (int bit = 0; bit < RC_CLIP_REPRESENTATION_COUNT; bit++) {
+        if (representation == (1u << bit)) {
+            return pasteboard->sizes[bit];
+        }
+    }
+    return 0;
+}
+
+/// Returns the verdict and the bytes that had to be copied out of the
+/// pasteboard to reach it.
+static RCCaptureVerdict RCSimulateSnapshot(const RCCapturePlan *plan, const RCSimulatedPasteboard *pasteboard,
+                                           uint64_t *outBytesRead) {
+    *outBytesRead = 0;
+    RCClipRepresentationMask readMask = 0;
+    RCCaptureVerdict verdict = RCCapturePlanEvaluate(plan, pasteboard->offered, pasteboard->marked, &readMask);
+    if (verdict != RCCaptureVerdictRead) {
+        return verdict;
+    }
+    RCClipRepresentation order[RC_CLIP_REPRESENTATION_COUNT];
+    size_t count = RCCapturePlanReadOrder(readMask, order);
+    RCCaptureBudget budget;
+    RCCaptureBudgetInit(&budget, plan);
+    for (size_t i = 0; i < count; i++) {
+        uint64_t size = RCSimulatedSize(pasteboard, order[i]);
+        *outBytesRead += size;
+        if (!RCCaptureBudgetCharge(&budget, size)) {
+            return RCCaptureVerdictSkipOversized;
+        }
+    }
+    return RCCaptureVerdictRead;
+}
+
+/// The snapshot before the plan: every offered representation was copied,
+/// markers and store types were checked afterwards.
+static uint64_t RCSimulateReadEverything(const RCSimulatedPasteboard *pasteboard) {
+    uint64_t bytes = 0;
+    for (int bit = 0; bit < RC_CLIP_REPRESENTATION_COUNT; bit++) {
+        if (pasteboard->offered & (1u << bit)) {
+            bytes += pasteboard->sizes[bit];
+        }
+    }
+    return bytes;
+}
+
+static void TestSimulatedSnapshots(void) {
+    RCCapturePlan plan = RCCapturePlanMake(RC_CLIP_REPRESENTATION_ALL & ~RCClipRepresentationTIFF, 10 * RC_MIB);
+    uint64_t bytesRead = 0;
+
+    // A 30 MB screenshot with TIFF storage disabled: nothing is copied.
+    RCSimulatedPasteboard image = { .offered = RCClipRepresentationTIFF };
+    image.sizes[6] = 30 * RC_MIB;
+    RC_TEST_ASSERT_EQUAL(RCCaptureVerdictSkipDisabled, RCSimulateSnapshot(&plan, &image, &bytesRead));
+    RC_TEST_ASSERT_EQUAL(0, bytesRead);
+    printf("     30 MiB image, TIFF disabled: %llu bytes copied (was %llu)\n", (unsigned long long)bytesRead,
+           (unsigned long long)RCSimulateReadEverything(&image));
+
+    // A password manager copy is dropped on its marker.
+    RCSimulatedPasteboard concealed = { .offered = RCClipRepresentationString, .marked = true };
+    concealed.sizes[0] = 32;
+    RC_TEST_ASSERT_EQUAL(RCCaptureVerdictSkipMarked, RCSimulateSnapshot(&plan, &concealed, &bytesRead));
+    RC_TEST_ASSERT_EQUAL(0, bytesRead);
+
+    // A browser image copy keeps its URL, the disabled TIFF is never read.
+    RCSimulatedPasteboard browserImage = { .offered = RCClipRepresentationURL | RCClipRepresentationTIFF };
+    browserImage.sizes[5] = 80;
+    browserImage.sizes[6] = 30 * RC_MIB;
+    RC_TEST_ASSERT_EQUAL(RCCaptureVerdictRead, RCSimulateSnapshot(&plan, &browserImage, &bytesRead));
+    RC_TEST_ASSERT_EQUAL(80, bytesRead);
+
+    // An oversized document stops after the PDF; the larger RTFD is never read.
+    RCSimulatedPasteboard document = {
+        .offered = RCClipRepresentationString | RCClipRepresentationPDF | RCClipRepresentationRTFD,
+    };
+    document.sizes[0] = 4096;
+    document.sizes[3] = 12 * RC_MIB;
+    document.sizes[2] = 40 * RC_MIB;
+    RC_TEST_ASSERT_EQUAL(RCCaptureVerdictSkipOversized, RCSimulateSnapshot(&plan, &document, &bytesRead));
+    RC_TEST_ASSERT_EQUAL(4096 + 12 * RC_MIB, bytesRead);
+    RC_TEST_ASSERT(bytesRead < RCSimulateReadEverything(&document));
+}
+
+int main(void) {
+    RC_TEST_RUN(TestVerdictsFromTypesAlone);
+    RC_TEST_RUN(TestReadOrderIsCheapestFirst);
+    RC_TEST_RUN(TestBudgetStopsAtLimit);
+    RC_TEST_RUN(TestSimulatedSnapshots);
+    return RC_TEST_FINISH();
+}
@@ -0,0 +1,241 @@
+//
+//  RCCaptureSequencerTests.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Unit tests for the capture pipeline's sequencer
+//  (Revclip/Core/RCCaptureSequencer): results completed out of order are
+//  released in admission order, filtered-out (NULL) results keep their place,
+//  admission blocks at capacity until a release, and a multi-threaded run
+//  with a worker pool of uneven stage times never reorders or exceeds the
+//  bound.
+//
+//  Usage: RCCaptureSequencerTests
+//
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "RCCaptureSequencer.h"
+#include "RCTestSupport.h"
+
+static void *RCItemForSequence(uint64_t sequence) {
+    return (void *)(uintptr_t)(sequence + 1);
+}
+
+static void TestReleasesInAdmissionOrder(void) {
+    RCCaptureSequencer *sequencer = RCCaptureSequencerCreate(4);
+    RC_TEST_ASSERT(sequencer != NULL);
+
+    uint64_t sequences[4];
+    for (int i = 0; i < 4; i++) {
+        sequences[i] = RCCaptureSequencerAdmit(sequencer);
+        RC_TEST_ASSERT_EQUAL(i, sequences[i]);
+    }
+    RC_TEST_ASSERT_EQUAL(4, RCCaptureSequencerInFlightCount(sequencer));
+
+    void *item = NULL;
+    RC_TEST_ASSERT(!RCCaptureSequencerTakeNext(sequencer, &item));
+
+    // 2 and 1 finish before 0: nothing is released until 0 is done.
+    RCCaptureSequencerComplete(sequencer, 2, RCItemForSequence(2));
+    RCCaptureSequencerComplete(sequencer, 1, NULL);
+    RC_TEST_ASSERT(!RCCaptureSequencerTakeNext(sequencer, &item));
+    RCCaptureSequencerComplete(sequencer, 0, RCItemForSequence(0));
+
+    RC_TEST_ASSERT(RCCaptureSequencerTakeNext(sequencer, &item));
+    RC_TEST_ASSERT(item == RCItemForSequence(0));
+    // A filtered-out capture is released in its place as NULL.
+    RC_TEST_ASSERT(RCCaptureSequencerTakeNext(sequencer, &item));
+    RC_TEST_ASSERT(item == NULL);
+    RC_TEST_ASSERT(RCCaptureSequencerTakeNext(sequencer, &item));
+    RC_TEST_ASSERT(item == RCItemForSequence(2));
+    RC_TEST_ASSERT(!RCCaptureSequencerTakeNext(sequencer, &item));
+    RC_TEST_ASSERT_EQUAL(1, RCCaptureSequencerInFlightCount(sequencer));
+
+    // Completing an unknown or already released sequence is ignored.
+    RCCaptureSequencerComplete(sequencer, 0, RCItemForSequence(99));
+    RCCaptureSequencerComplete(sequencer, 17, RCItemForSequence(99));
+    RC_TEST_ASSERT(!RCCaptureSequencerTakeNext(sequencer, &item));
+
+    RCCaptureSequencerComplete(sequencer, 3, RCItemForSequence(3));
+    RC_TEST_ASSERT(RCCaptureSequencerTakeNext(sequencer, &item));
+    RC_TEST_ASSERT(item == RCItemForSequence(3));
+    RC_TEST_ASSERT_EQUAL(0, RCCaptureSequencerInFlightCount(sequencer));
+    RC_TEST_ASSERT(RCCaptureSequencerCreate(0) == NULL);
+
+    RCCaptureSequencerDestroy(sequencer);
+}
+
+typedef struct {
+    RCCaptureSequencer *sequencer;
+    _Atomic int admitted;
+} RCBlockedAdmission;
+
+static void *RCAdmitOnThread(void *context) {
+    RCBlockedAdmission *admission = context;
+    RCCaptureSequencerAdmit(admission->sequencer);
+    atomic_store(&admission->admitted, 1);
+    return NULL;
+}
+
+static void RCSleepMicroseconds(long microseconds) {
+    struct timespec duration = { microseconds / 1000000, (microseconds % 1000000) * 1000 };
+    nanosleep(&duration, NULL);
+}
+
+static void TestAdmissionBlocksAtCapacity(void) {
+    RCCaptureSequencer *sequencer = RCCaptureSequencerCreate(2);
+    RC_TEST_ASSERT(sequencer != NULL);
+
+    uint64_t sequence = 0;
+    RC_TEST_ASSERT(RCCaptureSequencerTryAdmit(sequencer, &sequence));
+    RC_TEST_ASSERT_EQUAL(0, sequence);
+    RC_TEST_ASSERT(RCCaptureSequencerTryAdmit(sequencer, &sequence));
+    RC_TEST_ASSERT_EQUAL(1, sequence);
+    RC_TEST_ASSERT(!RCCaptureSequencerTryAdmit(sequencer, &sequence));
+
+    RCBlockedAdmission admission = { sequencer, 0 };
+    pthread_t thread;
+    RC_TEST_ASSERT(pthread_create(&thread, NULL, RCAdmitOnThread, &admission) == 0);
+    RCSleepMicroseconds(20000);
+    RC_TEST_ASSERT_EQUAL(0, atomic_load(&admission.admitted));
+
+    // Completing frees nothing; only taking the oldest item does.
+    RCCaptureSequencerComplete(sequencer, 1, RCItemForSequence(1));
+    RCSleepMicroseconds(20000);
+    RC_TEST_ASSERT_EQUAL(0, atomic_load(&admission.admitted));
+
+    RCCaptureSequencerComplete(sequencer, 0, RCItemForSequence(0));
+    void *item = NULL;
+    RC_TEST_ASSERT(RCCaptureSequencerTakeNext(sequencer, &item));
+    pthread_join(thread, NULL);
+    RC_TEST_ASSERT_EQUAL(1, atomic_load(&admission.admitted));
+    RC_TEST_ASSERT_EQUAL(1, RCCaptureSequencerBlockedAdmissionCount(sequencer));
+    RC_TEST_ASSERT_EQUAL(2, RCCaptureSequencerInFlightCount(sequencer));
+
+    RCCaptureSequencerDestroy(sequencer);
+}
+
+// MARK: Concurrent pipeline
+
+#define RC_TEST_ITEMS 2000
+#define RC_TEST_WORKERS 4
+#define RC_TEST_CAPACITY 6
+
+typedef struct {
+    RCCaptureSequencer *sequencer;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    // Admitted sequences waiting for a worker.
+    uint64_t pending[RC_TEST_ITEMS];
+    size_t pendingHead;
+    size_t pendingTail;
+    bool producerDone;
+    _Atomic size_t maxInFlight;
+} RCTestPipeline;
+
+static void *RCWorkerThread(void *context) {
+    RCTestPipeline *pipeline = context;
+    uint64_t state = (uint64_t)(uintptr_t)&state;
+    for (;;) {
+        pthread_mutex_lock(&pipeline->lock);
+        while (pipeline->pendingHead == pipeline->pendingTail && !pipeline->producerDone) {
+            pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+        }
+        if (pipeline->pendingHead == pipeline->pendingTail) {
+            pthread_mutex_unlock(&pipeline->lock);
+            return NULL;
+        }
+        uint64_t sequence = pipeline->pending[pipeline->pendingHead++];
+        pthread_mutex_unlock(&pipeline->lock);
+
+        // Uneven "fingerprint" times: mostly small clips, the odd large image.
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        long microseconds = (state >> 33) % 50 == 0 ? 2000 : (long)((state >> 40) % 100);
+        RCSleepMicroseconds(microseconds);
+
+        // Every fifth capture is filtered out.
+        RCCaptureSequencerComplete(pipeline->sequencer, sequence, sequence % 5 == 3 ? NULL : RCItemForSequence(sequence));
+    }
+}
+
+static void *RCProducerThread(void *context) {
+    RCTestPipeline *pipeline = context;
+    for (int i = 0; i < RC_TEST_ITEMS; i++) {
+        uint64_t sequence = RCCaptureSequencerAdmit(pipeline->sequencer);
+        size_t inFlight = RCCaptureSequencerInFlightCount(pipeline->sequencer);
+        size_t maxInFlight = atomic_load(&pipeline->maxInFlight);
+        while (inFlight > maxInFlight && !atomic_compare_exchange_weak(&pipeline->maxInFlight, &maxInFlight, inFlight)) {
+        }
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->pending[pipeline->pendingTail++] = sequence;
+        pthread_cond_broadcast(&pipeline->changed);
+        pthread_mutex_unlock(&pipeline->lock);
+    }
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->producerDone = true;
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->lock);
+    return NULL;
+}
+
+static void TestConcurrentWorkersKeepOrder(void) {
+    static RCTestPipeline pipeline;
+    pipeline.sequencer = RCCaptureSequencerCreate(RC_TEST_CAPACITY);
+    RC_TEST_ASSERT(pipeline.sequencer != NULL);
+    pthread_mutex_init(&pipeline.lock, NULL);
+    pthread_cond_init(&pipeline.changed, NULL);
+
+    pthread_t producer;
+    pthread_t workers[RC_TEST_WORKERS];
+    RC_TEST_ASSERT(pthread_create(&producer, NULL, RCProducerThread, &pipeline) == 0);
+    for (int i = 0; i < RC_TEST_WORKERS; i++) {
+        RC_TEST_ASSERT(pthread_create(&workers[i], NULL, RCWorkerThread, &pipeline) == 0);
+    }
+
+    // This thread is the serial hand-off to the persist stage.
+    uint64_t expected = 0;
+    uint64_t released = 0;
+    bool ordered = true;
+    while (expected < RC_TEST_ITEMS) {
+        void *item = NULL;
+        if (!RCCaptureSequencerTakeNext(pipeline.sequencer, &item)) {
+            RCSleepMicroseconds(50);
+            continue;
+        }
+        void *wanted = expected % 5 == 3 ? NULL : RCItemForSequence(expected);
+        ordered = ordered && item == wanted;
+        released += item != NULL ? 1 : 0;
+        expected++;
+    }
+
+    pthread_join(producer, NULL);
+    for (int i = 0; i < RC_TEST_WORKERS; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    printf("     %d captures, %llu blocked admissions, max %zu in flight\n", RC_TEST_ITEMS,
+           (unsigned long long)RCCaptureSequencerBlockedAdmissionCount(pipeline.sequencer),
+           atomic_load(&pipeline.maxInFlight));
+    RC_TEST_ASSERT(ordered);
+    RC_TEST_ASSERT_EQUAL(RC_TEST_ITEMS - RC_TEST_ITEMS / 5, released);
+    RC_TEST_ASSERT(atomic_load(&pipeline.maxInFlight) <= RC_TEST_CAPACITY);
+    RC_TEST_ASSERT(RCCaptureSequencerBlockedAdmissionCount(pipeline.sequencer) > 0);
+    RC_TEST_ASSERT_EQUAL(0, RCCaptureSequencerInFlightCount(pipeline.sequencer));
+
+    pthread_cond_destroy(&pipeline.changed);
+    pthread_mutex_destroy(&pipeline.lock);
+    RCCaptureSequencerDestroy(pipeline.sequencer);
+}
+
+int main(void) {
+    RC_TEST_RUN(TestReleasesInAdmissionOrder);
+    RC_TEST_RUN(TestAdmissionBlocksAtCapacity);
+    RC_TEST_RUN(TestConcurrentWorkersKeepOrder);
+    return RC_TEST_FINISH();
+}
@@ -0,0 +1,295 @@
+//
+//  RCClipCompressionTests.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Unit tests for the section codecs (Revclip/Core/RCClipCompression) and
+//  compressed container sections: LZ4 / deflate round trips, a hand-encoded
+//  LZ4 block, rejection of malformed streams and length prefixes, the codec
+//  policy, and per-section decoding through RCClipContainer.
+//
+//  Usage: RCClipCompressionTests
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCClipContainer.h"
+#include "RCTestSupport.h"
+
+static const char *const kRCTestWords[] = {
+    "clipboard", "history", "snippet", "paste", "menu", "revclip", "the", "a", "of", "クリップ",
+};
+
+static uint8_t *RCTestTextBytes(size_t length, uint32_t seed) {
+    uint8_t *bytes = malloc(length + 1);
+    uint32_t state = seed;
+    size_t offset = 0;
+    while (offset < length) {
+        state = state * 1664525u + 1013904223u;
+        const char *word = kRCTestWords[(state >> 24) % (sizeof(kRCTestWords) / sizeof(kRCTestWords[0]))];
+        for (const char *p = word; *p != '\0' && offset < length; p++) {
+            bytes[offset++] = (uint8_t)*p;
+        }
+        if (offset < length) {
+            bytes[offset++] = (state >> 20) % 9 == 0 ? '\n' : ' ';
+        }
+    }
+    return bytes;
+}
+
+static uint8_t *RCTestRandomBytes(size_t length, uint32_t seed) {
+    uint8_t *bytes = malloc(length + 1);
+    uint32_t state = seed;
+    for (size_t i = 0; i < length; i++) {
+        state = state * 1664525u + 1013904223u;
+        bytes[i] = (uint8_t)(state >> 24);
+    }
+    return bytes;
+}
+
+static int RCTestLZ4RoundTrips(const uint8_t *bytes, size_t length) {
+    size_t capacity = RCClipLZ4CompressBound(length);
+    uint8_t *compressed = malloc(capacity);
+    uint8_t *decoded = malloc(length + 1);
+    size_t compressedLength = RCClipLZ4Compress(bytes, length, compressed, capacity);
+    int ok = compressedLength > 0
+        && RCClipLZ4Decompress(compressed, compressedLength, decoded, length)
+        && memcmp(decoded, bytes, length) == 0;
+    free(compressed);
+    free(decoded);
+    return ok;
+}
+
+static int RCTestDeflateRoundTrips(const uint8_t *bytes, size_t length) {
+    size_t capacity = RCClipDeflateCompressBound(length);
+    uint8_t *compressed = malloc(capacity);
+    uint8_t *decoded = malloc(length + 1);
+    size_t compressedLength = RCClipDeflateCompress(bytes, length, 6, compressed, capacity);
+    int ok = compressedLength > 0
+        && RCClipDeflateDecompress(compressed, compressedLength, decoded, length)
+        && memcmp(decoded, bytes, length) == 0;
+    free(compressed);
+    free(decoded);
+    return ok;
+}
+
+static void TestCodecsRoundTrip(void) {
+    static const size_t lengths[] = { 0, 1, 4, 12, 13, 17, 64, 255, 1000, 65536, 70000, 1 << 20 };
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        size_t length = lengths[i];
+        uint8_t *text = RCTestTextBytes(length, (uint32_t)i + 1);
+        uint8_t *random = RCTestRandomBytes(length, (uint32_t)i + 1);
+        uint8_t *zeros = calloc(length + 1, 1);
+        int ok = RCTestLZ4RoundTrips(text, length) && RCTestLZ4RoundTrips(random, length)
+            && RCTestLZ4RoundTrips(zeros, length) && RCTestDeflateRoundTrips(text, length)
+            && RCTestDeflateRoundTrips(random, length) && RCTestDeflateRoundTrips(zeros, length);
+        free(text);
+        free(random);
+        free(zeros);
+        if (!ok) {
+            fprintf(stderr, "round trip failed at length %zu\n", length);
+        }
+        RC_TEST_ASSERT(ok);
+    }
+}
+
+static void TestLZ4DecodesReferenceBlock(void) {
+    // "abc", then a 6-byte match at offset 3 (overlapping), then the last literals.
+    static const uint8_t block[] = { 0x32, 'a', 'b', 'c', 0x03, 0x00, 0x50, 'x', 'y', 'z', 'w', 'v' };
+    static const char expected[] = "abcabcabcxyzwv";
+    char decoded[sizeof(expected) - 1];
+    RC_TEST_ASSERT(RCClipLZ4Decompress(block, sizeof(block), decoded, sizeof(decoded)));
+    RC_TEST_ASSERT(memcmp(decoded, expected, sizeof(decoded)) == 0);
+
+    // Repetitive input must compress and round trip through the same decoder.
+    uint8_t run[4096];
+    memset(run, 'z', sizeof(run));
+    uint8_t compressed[64];
+    size_t compressedLength = RCClipLZ4Compress(run, sizeof(run), compressed, sizeof(compressed));
+    RC_TEST_ASSERT(compressedLength > 0 && compressedLength < 40);
+    uint8_t decodedRun[sizeof(run)];
+    RC_TEST_ASSERT(RCClipLZ4Decompress(compressed, compressedLength, decodedRun, sizeof(decodedRun)));
+    RC_TEST_ASSERT(memcmp(decodedRun, run, sizeof(run)) == 0);
+
+    // Too little room makes the encoder fail instead of overrunning.
+    RC_TEST_ASSERT_EQUAL(0, RCClipLZ4Compress(run, sizeof(run), compressed, compressedLength - 1));
+}
+
+static void TestMalformedStreamsAreRejected(void) {
+    static const uint8_t block[] = { 0x32, 'a', 'b', 'c', 0x03, 0x00, 0x50, 'x', 'y', 'z', 'w', 'v' };
+    uint8_t decoded[32];
+
+    // Wrong expected length in either direction.
+    RC_TEST_ASSERT(!RCClipLZ4Decompress(block, sizeof(block), decoded, 13));
+    RC_TEST_ASSERT(!RCClipLZ4Decompress(block, sizeof(block), decoded, 15));
+    // Every truncation.
+    for (size_t prefix = 0; prefix < sizeof(block); prefix++) {
+        RC_TEST_ASSERT(!RCClipLZ4Decompress(block, prefix, decoded, 14));
+    }
+    // Offset 0 and an offset reaching before the output.
+    uint8_t edited[sizeof(block)];
+    memcpy(edited, block, sizeof(block));
+    edited[4] = 0;
+    RC_TEST_ASSERT(!RCClipLZ4Decompress(edited, sizeof(edited), decoded, 14));
+    edited[4] = 4;
+    RC_TEST_ASSERT(!RCClipLZ4Decompress(edited, sizeof(edited), decoded, 14));
+    // A literal length extension that runs off the end.
+    static const uint8_t runaway[] = { 0xF0, 0xFF, 0xFF };
+    RC_TEST_ASSERT(!RCClipLZ4Decompress(runaway, sizeof(runaway), decoded, sizeof(decoded)));
+
+    size_t length = 10000;
+    uint8_t *text = RCTestTextBytes(length, 3);
+    size_t capacity = RCClipDeflateCompressBound(length);
+    uint8_t *compressed = malloc(capacity + 1);
+    uint8_t *output = malloc(length + 1);
+    size_t compressedLength = RCClipDeflateCompress(text, length, 6, compressed, capacity);
+    RC_TEST_ASSERT(compressedLength > 0);
+    RC_TEST_ASSERT(!RCClipDeflateDecompress(compressed, compressedLength - 1, output, length));
+    RC_TEST_ASSERT(!RCClipDeflateDecompress(compressed, compressedLength, output, length - 1));
+    RC_TEST_ASSERT(!RCClipDeflateDecompress(compressed, compressedLength, output, length + 1));
+    compressed[compressedLength] = 0;
+    RC_TEST_ASSERT(!RCClipDeflateDecompress(compressed, compressedLength + 1, output, length));
+    free(text);
+    free(compressed);
+    free(output);
+}
+
+static void TestPayloadLengthPrefix(void) {
+    size_t length = 50000;
+    uint8_t *text = RCTestTextBytes(length, 5);
+    uint8_t *payload = NULL;
+    size_t payloadLength = 0;
+    RC_TEST_ASSERT(RCClipCompressionEncode(RCClipCodecLZ4, text, length, &payload, &payloadLength));
+    uint64_t decodedLength = 0;
+    RC_TEST_ASSERT(RCClipCompressionDecodedLength(RCClipCodecLZ4, payload, payloadLength, &decodedLength));
+    RC_TEST_ASSERT_EQUAL(length, decodedLength);
+    uint8_t *decoded = malloc(length);
+    RC_TEST_ASSERT(RCClipCompressionDecode(RCClipCodecLZ4, payload, payloadLength, decoded, length));
+    RC_TEST_ASSERT(memcmp(decoded, text, length) == 0);
+    // The prefix names the codec's stream, not another one.
+    RC_TEST_ASSERT(!RCClipCompressionDecode(RCClipCodecDeflate, payload, payloadLength, decoded, length));
+
+    // A prefix larger than the stream could ever expand to is refused up front.
+    payload[5] = 0x10;
+    RC_TEST_ASSERT(!RCClipCompressionDecodedLength(RCClipCodecLZ4, payload, payloadLength, &decodedLength));
+    RC_TEST_ASSERT(!RCClipCompressionDecodedLength(RCClipCodecLZ4, payload, RC_CLIP_COMPRESSION_PREFIX_LENGTH,
+                                                   &decodedLength));
+
+    // Incompressible input is left to the caller to store raw.
+    uint8_t *random = RCTestRandomBytes(length, 5);
+    uint8_t *randomPayload = NULL;
+    size_t randomPayloadLength = 0;
+    RC_TEST_ASSERT(!RCClipCompressionEncode(RCClipCodecDeflate, random, length, &randomPayload, &randomPayloadLength));
+    RC_TEST_ASSERT(randomPayload == NULL);
+
+    free(random);
+    free(decoded);
+    free(payload);
+    free(text);
+}
+
+static void TestCodecPolicy(void) {
+    size_t length = 200000;
+    uint8_t *text = RCTestTextBytes(length, 7);
+    uint8_t *random = RCTestRandomBytes(length, 7);
+    RC_TEST_ASSERT_EQUAL(RCClipCodecNone, RCClipCompressionChooseCodec(text, RC_CLIP_COMPRESSION_MIN_LENGTH - 1,
+                                                                       RCClipCompressionHot));
+    RC_TEST_ASSERT_EQUAL(RCClipCodecLZ4, RCClipCompressionChooseCodec(text, length, RCClipCompressionHot));
+    RC_TEST_ASSERT_EQUAL(RCClipCodecDeflate, RCClipCompressionChooseCodec(text, length, RCClipCompressionCold));
+    RC_TEST_ASSERT_EQUAL(RCClipCodecNone, RCClipCompressionChooseCodec(random, length, RCClipCompressionHot));
+    RC_TEST_ASSERT_EQUAL(RCClipCodecNone, RCClipCompressionChooseCodec(random, length, RCClipCompressionCold));
+    free(text);
+    free(random);
+}
+
+static void TestCompressedSectionsDecodeIndependently(void) {
+    size_t textLength = 100000;
+    size_t randomLength = 30000;
+    uint8_t *text = RCTestTextBytes(textLength, 9);
+    uint8_t *rtf = RCTestTextBytes(textLength, 10);
+    uint8_t *random = RCTestRandomBytes(randomLength, 9);
+    RCClipContainerWriter *writer = RCClipContainerWriterCreate();
+    RC_TEST_ASSERT(writer != NULL);
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerWriterAddCompressibleSection(
+        writer, RCClipSectionString, text, textLength, RCClipCompressionHot));
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerWriterAddCompressibleSection(
+        writer, RCClipSectionRTFD, rtf, textLength, RCClipCompressionCold));
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerWriterAddCompressibleSection(
+        writer, RCClipSectionTIFF, random, randomLength, RCClipCompressionCold));
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerWriterAddCompressibleSection(
+        writer, RCClipSectionPrimaryType, "public.rtf", 10, RCClipCompressionHot));
+    uint8_t *bytes = NULL;
+    size_t length = 0;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerWriterCopyBytes(writer, &bytes, &length));
+    RCClipContainerWriterDestroy(writer);
+    RC_TEST_ASSERT(length < textLength);
+
+    RCClipContainer *container = NULL;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerOpenBytes(bytes, length, &container));
+    RCClipSection section;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerFindSection(container, RCClipSectionString, &section));
+    RC_TEST_ASSERT_EQUAL(RCClipCodecLZ4, RCClipSectionCodec(&section));
+    uint64_t decodedLength = 0;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipSectionDecodedLength(&section, &decodedLength));
+    RC_TEST_ASSERT_EQUAL(textLength, decodedLength);
+    uint8_t *decoded = malloc(textLength);
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipSectionDecode(&section, decoded, textLength));
+    RC_TEST_ASSERT(memcmp(decoded, text, textLength) == 0);
+
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerFindSection(container, RCClipSectionRTFD, &section));
+    RC_TEST_ASSERT_EQUAL(RCClipCodecDeflate, RCClipSectionCodec(&section));
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipSectionDecode(&section, decoded, textLength));
+    RC_TEST_ASSERT(memcmp(decoded, rtf, textLength) == 0);
+
+    // Incompressible and short payloads stay raw and readable in place.
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerFindSection(container, RCClipSectionTIFF, &section));
+    RC_TEST_ASSERT_EQUAL(RCClipCodecNone, RCClipSectionCodec(&section));
+    RC_TEST_ASSERT(section.length == randomLength && memcmp(section.bytes, random, randomLength) == 0);
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerFindSection(container, RCClipSectionPrimaryType, &section));
+    RC_TEST_ASSERT(section.flags == 0 && section.length == 10);
+    RCClipContainerClose(container);
+
+    // Both codec flags, or a codec on a blob reference, are corrupt.
+    uint8_t *edited = malloc(length);
+    static const uint32_t badFlags[] = {
+        RC_CLIP_SECTION_CODEC_FLAGS,
+        RC_CLIP_SECTION_FLAG_LZ4 | RC_CLIP_SECTION_FLAG_BLOB_REFERENCE,
+    };
+    for (size_t i = 0; i < sizeof(badFlags) / sizeof(badFlags[0]); i++) {
+        memcpy(edited, bytes, length);
+        uint8_t *entry = edited + RC_CLIP_CONTAINER_HEADER_LENGTH;
+        for (int b = 0; b < 4; b++) {
+            entry[4 + b] = (uint8_t)(badFlags[i] >> (8 * b));
+        }
+        uint32_t tocChecksum = RCClipContainerChecksum(0, entry, 4 * RC_CLIP_CONTAINER_TOC_ENTRY_LENGTH);
+        for (int b = 0; b < 4; b++) {
+            edited[24 + b] = (uint8_t)(tocChecksum >> (8 * b));
+        }
+        uint32_t headerChecksum = RCClipContainerChecksum(0, edited, 28);
+        for (int b = 0; b < 4; b++) {
+            edited[28 + b] = (uint8_t)(headerChecksum >> (8 * b));
+        }
+        RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerOpenBytes(edited, length, &container));
+        RC_TEST_ASSERT_EQUAL(RCClipContainerCorrupt, RCClipContainerFindSection(container, RCClipSectionString, &section));
+        RCClipContainerClose(container);
+    }
+
+    free(edited);
+    free(decoded);
+    free(bytes);
+    free(random);
+    free(rtf);
+    free(text);
+}
+
+int main(void) {
+    RC_TEST_RUN(TestCodecsRoundTrip);
+    RC_TEST_RUN(TestLZ4DecodesReferenceBlock);
+    RC_TEST_RUN(TestMalformedStreamsAreRejected);
+    RC_TEST_RUN(TestPayloadLengthPrefix);
+    RC_TEST_RUN(TestCodecPolicy);
+    RC_TEST_RUN(TestCompressedSectionsDecodeIndependently);
+    return RC_TEST_FINISH();
+}
@@ -0,0 +1,282 @@
+//
+//  RCClipContainerFuzz.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Fuzz target for the .rcclip container reader. Every input is opened, each
+//  section is verified, list sections are walked and compressed sections are
+//  decoded; inputs that open are re-written and must read back identically.
+//
+//  libFuzzer (clang):  make -C Benchmarks fuzz && build/RCClipContainerFuzzer
+//  Standalone driver:  RCClipContainerFuzz [--iterations 20000] [--seed 1]
+//    mutates a few valid containers (byte flips, truncation, TOC field edits
+//    with the checksums recomputed so the bounds checks and the section
+//    decoders are reached) and runs them through the same target.
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCClipContainer.h"
+
+static void RCFuzzCheck(int condition, const char *message) {
+    if (!condition) {
+        fprintf(stderr, "RCClipContainerFuzz: %s\n", message);
+        abort();
+    }
+}
+
+// Decoding may fail but must stay inside the declared length.
+static void RCFuzzDecode(const RCClipSection *section) {
+    uint64_t decodedLength = 0;
+    if (RCClipSectionDecodedLength(section, &decodedLength) != RCClipContainerOK) {
+        return;
+    }
+    RCFuzzCheck(RCClipSectionCodec(section) != RCClipCodecNone || decodedLength == section->length,
+                "raw section length changed");
+    if (decodedLength > 64u * 1024 * 1024) {
+        return;
+    }
+    uint8_t *decoded = malloc(decodedLength > 0 ? (size_t)decodedLength : 1);
+    RCFuzzCheck(decoded != NULL, "decode allocation failed");
+    RCClipSectionDecode(section, decoded, (size_t)decodedLength);
+    free(decoded);
+}
+
+static void RCFuzzWalkLists(const RCClipSection *section) {
+    uint64_t cursor = 0;
+    const uint8_t *item = NULL;
+    size_t itemLength = 0;
+    uint64_t consumed = 0;
+    RCClipContainerStatus status;
+    while ((status = RCClipSectionNextListItem(section, &cursor, &item, &itemLength)) == RCClipContainerOK) {
+        RCFuzzCheck(item >= section->bytes && item + itemLength <= section->bytes + section->length,
+                    "list item outside its section");
+        consumed += 4 + itemLength;
+    }
+    RCFuzzCheck(status == RCClipContainerNotFound || status == RCClipContainerCorrupt, "unexpected list status");
+    RCFuzzCheck(status != RCClipContainerNotFound || consumed == section->length, "list end before section end");
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    RCClipContainer *container = NULL;
+    if (RCClipContainerOpenBytes(data, size, &container) != RCClipContainerOK) {
+        RCFuzzCheck(container == NULL, "container returned on failure");
+        return 0;
+    }
+
+    RCClipContainerWriter *writer = RCClipContainerWriterCreate();
+    RCFuzzCheck(writer != NULL, "writer allocation failed");
+    uint32_t sectionCount = RCClipContainerSectionCount(container);
+    for (uint32_t i = 0; i < sectionCount; i++) {
+        RCClipSection section;
+        RCFuzzCheck(RCClipContainerSectionAtIndex(container, i, &section) == RCClipContainerOK, "missing TOC entry");
+        RCFuzzCheck(section.bytes >= data && section.length <= size
+                    && (size_t)(section.bytes - data) <= size - section.length,
+                    "section outside the input");
+
+        RCClipSection found;
+        RCClipContainerStatus status = RCClipContainerFindSection(container, section.type, &found);
+        RCFuzzCheck(status != RCClipContainerNotFound, "TOC entry not found by type");
+        if (status == RCClipContainerOK
+            && (section.type == RCClipSectionFileNames || section.type == RCClipSectionFileURLs)) {
+            RCFuzzWalkLists(&found);
+        }
+        if (status == RCClipContainerOK) {
+            RCFuzzDecode(&found);
+        }
+        RCFuzzCheck(RCClipContainerWriterAddSection(writer, section.type, section.flags, section.bytes,
+                                                    (size_t)section.length) == RCClipContainerOK,
+                    "valid section rejected by the writer");
+    }
+
+    uint8_t *rewritten = NULL;
+    size_t rewrittenLength = 0;
+    RCFuzzCheck(RCClipContainerWriterCopyBytes(writer, &rewritten, &rewrittenLength) == RCClipContainerOK,
+                "rewrite failed");
+    RCClipContainer *reopened = NULL;
+    RCFuzzCheck(RCClipContainerOpenBytes(rewritten, rewrittenLength, &reopened) == RCClipContainerOK,
+                "rewritten container does not open");
+    RCFuzzCheck(RCClipContainerSectionCount(reopened) == sectionCount, "section count changed");
+    for (uint32_t i = 0; i < sectionCount; i++) {
+        RCClipSection original;
+        RCClipSection copy;
+        RCClipContainerSectionAtIndex(container, i, &original);
+        RCClipContainerSectionAtIndex(reopened, i, &copy);
+        RCFuzzCheck(original.type == copy.type && original.flags == copy.flags && original.length == copy.length
+                    && memcmp(original.bytes, copy.bytes, (size_t)original.length) == 0,
+                    "section changed across a rewrite");
+        RCFuzzCheck(RCClipContainerVerifySection(&copy) == RCClipContainerOK, "rewritten checksum mismatch");
+    }
+
+    RCClipContainerClose(reopened);
+    free(rewritten);
+    RCClipContainerWriterDestroy(writer);
+    RCClipContainerClose(container);
+    return 0;
+}
+
+#ifndef RC_LIBFUZZER
+
+#include "RCBenchSupport.h"
+
+static uint64_t gRCFuzzState;
+
+static uint32_t RCFuzzRandom(void) {
+    gRCFuzzState ^= gRCFuzzState << 13;
+    gRCFuzzState ^= gRCFuzzState >> 7;
+    gRCFuzzState ^= gRCFuzzState << 17;
+    return (uint32_t)(gRCFuzzState >> 16);
+}
+
+static void RCFuzzWriteLE32(uint8_t *p, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint64_t RCFuzzReadLE64(const uint8_t *p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+static void RCFuzzReseal(uint8_t *bytes, size_t length) {
+    if (length < RC_CLIP_CONTAINER_HEADER_LENGTH) {
+        return;
+    }
+    uint32_t sectionCount = (uint32_t)bytes[12] | ((uint32_t)bytes[13] << 8)
+        | ((uint32_t)bytes[14] << 16) | ((uint32_t)bytes[15] << 24);
+    size_t tocLength = (size_t)sectionCount * RC_CLIP_CONTAINER_TOC_ENTRY_LENGTH;
+    if (sectionCount <= RC_CLIP_CONTAINER_MAX_SECTIONS && RC_CLIP_CONTAINER_HEADER_LENGTH + tocLength <= length) {
+        // Section checksums too, so mutated payloads reach the decoders.
+        for (uint32_t i = 0; i < sectionCount; i++) {
+            uint8_t *entry = bytes + RC_CLIP_CONTAINER_HEADER_LENGTH + (size_t)i * RC_CLIP_CONTAINER_TOC_ENTRY_LENGTH;
+            uint64_t offset = RCFuzzReadLE64(entry + 8);
+            uint64_t sectionLength = RCFuzzReadLE64(entry + 16);
+            if (offset <= length && sectionLength <= length - offset) {
+                RCFuzzWriteLE32(entry + 24, RCClipContainerChecksum(0, bytes + offset, (size_t)sectionLength));
+            }
+        }
+        RCFuzzWriteLE32(bytes + 24, RCClipContainerChecksum(0, bytes + RC_CLIP_CONTAINER_HEADER_LENGTH, tocLength));
+    }
+    RCFuzzWriteLE32(bytes + 28, RCClipContainerChecksum(0, bytes, 28));
+}
+
+static int RCFuzzAddSeed(uint8_t **seeds, size_t *seedLengths, size_t *seedCount, RCClipContainerWriter *writer) {
+    int status = RCClipContainerWriterCopyBytes(writer, &seeds[*seedCount], &seedLengths[*seedCount]);
+    RCClipContainerWriterDestroy(writer);
+    if (status != RCClipContainerOK) {
+        return 1;
+    }
+    (*seedCount)++;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    long iterations = RCBenchIntegerOption(argc, argv, "--iterations", 20000);
+    gRCFuzzState = (uint64_t)RCBenchIntegerOption(argc, argv, "--seed", 1) * 0x9E3779B97F4A7C15ull | 1;
+
+    uint8_t *seeds[4];
+    size_t seedLengths[4];
+    size_t seedCount = 0;
+    uint8_t payload[600];
+    for (size_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = (uint8_t)(i * 31);
+    }
+    const char *files[] = { "/tmp/a", "/tmp/b/c" };
+    size_t fileLengths[] = { 6, 8 };
+
+    RCClipContainerWriter *writer = RCClipContainerWriterCreate();
+    int failed = RCFuzzAddSeed(seeds, seedLengths, &seedCount, writer);
+    writer = RCClipContainerWriterCreate();
+    RCClipContainerWriterAddSection(writer, RCClipSectionString, 0, "hello", 5);
+    failed |= RCFuzzAddSeed(seeds, seedLengths, &seedCount, writer);
+    writer = RCClipContainerWriterCreate();
+    RCClipContainerWriterAddSection(writer, RCClipSectionString, 0, "x", 1);
+    RCClipContainerWriterAddListSection(writer, RCClipSectionFileNames, files, fileLengths, 2);
+    RCClipContainerWriterAddSection(writer, RCClipSectionTIFF, 0, payload, sizeof(payload));
+    RCClipContainerWriterAddSection(writer, RCClipSectionPDF, RC_CLIP_SECTION_FLAG_BLOB_REFERENCE, payload, 64);
+    failed |= RCFuzzAddSeed(seeds, seedLengths, &seedCount, writer);
+    // Compressible text and RTF so both codecs' streams get mutated.
+    char text[2048];
+    for (size_t i = 0; i < sizeof(text); i++) {
+        text[i] = "clip history "[i % 13] + (char)(i / 512);
+    }
+    writer = RCClipContainerWriterCreate();
+    RCClipContainerWriterAddCompressibleSection(writer, RCClipSectionString, text, sizeof(text), RCClipCompressionHot);
+    RCClipContainerWriterAddCompressibleSection(writer, RCClipSectionRTF, text, sizeof(text), RCClipCompressionCold);
+    failed |= RCFuzzAddSeed(seeds, seedLengths, &seedCount, writer);
+    if (failed) {
+        fprintf(stderr, "failed to build fuzz seeds\n");
+        return 1;
+    }
+
+    long opened = 0;
+    uint64_t start = RCBenchNowNanoseconds();
+    for (long iteration = 0; iteration < iterations; iteration++) {
+        size_t seedIndex = RCFuzzRandom() % seedCount;
+        size_t length = seedLengths[seedIndex];
+        // Room for up to four 64-byte extensions.
+        uint8_t *input = malloc(length + 256);
+        memcpy(input, seeds[seedIndex], length);
+
+        int mutations = 1 + (int)(RCFuzzRandom() % 4);
+        int reseal = RCFuzzRandom() % 4 != 0;
+        for (int m = 0; m < mutations && length > 0; m++) {
+            switch (RCFuzzRandom() % 5) {
+                case 0:
+                    input[RCFuzzRandom() % length] ^= (uint8_t)(1u << (RCFuzzRandom() % 8));
+                    break;
+                case 1:
+                    input[RCFuzzRandom() % length] = (uint8_t)RCFuzzRandom();
+                    break;
+                case 2:
+                    length = RCFuzzRandom() % (length + 1);
+                    break;
+                case 3: {
+                    size_t extra = 1 + RCFuzzRandom() % 64;
+                    for (size_t i = 0; i < extra; i++) {
+                        input[length + i] = (uint8_t)RCFuzzRandom();
+                    }
+                    length += extra;
+                    break;
+                }
+                default: {
+                    // Edit a header / TOC field with an interesting value.
+                    static const uint32_t values[] = { 0, 1, 7, 8, 31, 32, 64, 65, 0x7FFFFFFFu, 0xFFFFFFFFu };
+                    size_t fieldOffset = (RCFuzzRandom() % 64) * 4;
+                    if (fieldOffset + 4 <= length) {
+                        RCFuzzWriteLE32(input + fieldOffset, values[RCFuzzRandom() % 10]);
+                    }
+                    break;
+                }
+            }
+        }
+        if (reseal) {
+            RCFuzzReseal(input, length);
+        }
+
+        RCClipContainer *probe = NULL;
+        if (RCClipContainerOpenBytes(input, length, &probe) == RCClipContainerOK) {
+            opened++;
+            RCClipContainerClose(probe);
+        }
+        LLVMFuzzerTestOneInput(input, length);
+        free(input);
+    }
+    double seconds = (double)(RCBenchNowNanoseconds() - start) / 1e9;
+
+    printf("RCClipContainerFuzz: %ld inputs (%ld opened) in %.2f s, no crashes\n", iterations, opened, seconds);
+    for (size_t i = 0; i < seedCount; i++) {
+        free(seeds[i]);
+    }
+    return 0;
+}
+
+#endif /* RC_LIBFUZZER */
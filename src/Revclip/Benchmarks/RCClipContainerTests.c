@@ -0,0 +1,327 @@
+//
+//  RCClipContainerTests.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Unit tests for the .rcclip binary container (Revclip/Core/RCClipContainer):
+//  round trips in memory and through mmap'd files, lazy per-section checksum
+//  verification, and rejection of truncated, corrupted and future files.
+//
+//  Usage: RCClipContainerTests
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "RCBenchSupport.h"
+#include "RCClipContainer.h"
+#include "RCTestSupport.h"
+
+static const char kRCTestString[] = "クリップ text";
+static const char kRCTestPrimaryType[] = "public.utf8-plain-text";
+
+static uint8_t *RCTestPatternBytes(size_t length, uint32_t seed) {
+    uint8_t *bytes = malloc(length);
+    uint32_t state = seed;
+    for (size_t i = 0; i < length; i++) {
+        state = state * 1664525u + 1013904223u;
+        bytes[i] = (uint8_t)(state >> 24);
+    }
+    return bytes;
+}
+
+static uint32_t RCTestReadLE32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void RCTestWriteLE32(uint8_t *p, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+// Recomputes the TOC and header checksums after a test edits them on purpose.
+static void RCTestReseal(uint8_t *bytes) {
+    uint32_t sectionCount = RCTestReadLE32(bytes + 12);
+    RCTestWriteLE32(bytes + 24, RCClipContainerChecksum(0, bytes + RC_CLIP_CONTAINER_HEADER_LENGTH,
+                                                        sectionCount * RC_CLIP_CONTAINER_TOC_ENTRY_LENGTH));
+    RCTestWriteLE32(bytes + 28, RCClipContainerChecksum(0, bytes, 28));
+}
+
+// String, file names, an empty URL, a 1 MB TIFF and a primary type.
+static RCClipContainerWriter *RCTestCreateWriter(const uint8_t *tiff, size_t tiffLength) {
+    RCClipContainerWriter *writer = RCClipContainerWriterCreate();
+    const char *fileNames[] = { "/tmp/a.txt", "/Users/例/b c.pdf" };
+    size_t fileNameLengths[] = { strlen(fileNames[0]), strlen(fileNames[1]) };
+    if (RCClipContainerWriterAddSection(writer, RCClipSectionString, 0, kRCTestString, strlen(kRCTestString)) != RCClipContainerOK
+        || RCClipContainerWriterAddListSection(writer, RCClipSectionFileNames, fileNames, fileNameLengths, 2) != RCClipContainerOK
+        || RCClipContainerWriterAddSection(writer, RCClipSectionURL, 0, NULL, 0) != RCClipContainerOK
+        || RCClipContainerWriterAddSection(writer, RCClipSectionTIFF, 0, tiff, tiffLength) != RCClipContainerOK
+        || RCClipContainerWriterAddSection(writer, RCClipSectionPrimaryType, 0, kRCTestPrimaryType,
+                                           strlen(kRCTestPrimaryType)) != RCClipContainerOK) {
+        RCClipContainerWriterDestroy(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+static void RCTestCopyContainer(size_t tiffLength, uint8_t **outTIFF, uint8_t **outBytes, size_t *outLength) {
+    *outTIFF = RCTestPatternBytes(tiffLength, 7);
+    RCClipContainerWriter *writer = RCTestCreateWriter(*outTIFF, tiffLength);
+    *outBytes = NULL;
+    *outLength = 0;
+    if (writer != NULL) {
+        RCClipContainerWriterCopyBytes(writer, outBytes, outLength);
+        RCClipContainerWriterDestroy(writer);
+    }
+}
+
+// MARK: Tests
+
+static void TestChecksumMatchesReferenceVectors(void) {
+    RC_TEST_ASSERT_EQUAL(0xE3069283u, RCClipContainerChecksum(0, "123456789", 9));
+    RC_TEST_ASSERT_EQUAL(0u, RCClipContainerChecksum(0, NULL, 0));
+
+    // Incremental updates over odd split points equal one pass.
+    uint8_t *bytes = RCTestPatternBytes(1031, 3);
+    uint32_t whole = RCClipContainerChecksum(0, bytes, 1031);
+    size_t mismatches = 0;
+    for (size_t split = 0; split <= 1031; split += 97) {
+        uint32_t crc = RCClipContainerChecksum(0, bytes, split);
+        crc = RCClipContainerChecksum(crc, bytes + split, 1031 - split);
+        mismatches += crc != whole;
+    }
+    free(bytes);
+    RC_TEST_ASSERT_EQUAL(0, mismatches);
+}
+
+static void TestRoundTripInMemory(void) {
+    uint8_t *tiff = NULL;
+    uint8_t *bytes = NULL;
+    size_t length = 0;
+    RCTestCopyContainer(1024 * 1024 + 3, &tiff, &bytes, &length);
+    RC_TEST_ASSERT(bytes != NULL);
+    RC_TEST_ASSERT(RCClipContainerHasMagic(bytes, length));
+
+    RCClipContainer *container = NULL;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerOpenBytes(bytes, length, &container));
+    RC_TEST_ASSERT_EQUAL(5, RCClipContainerSectionCount(container));
+
+    RCClipSection section;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerFindSection(container, RCClipSectionString, &section));
+    RC_TEST_ASSERT_EQUAL(strlen(kRCTestString), section.length);
+    RC_TEST_ASSERT(memcmp(section.bytes, kRCTestString, section.length) == 0);
+    // Sections are views into the buffer, 8-byte aligned.
+    RC_TEST_ASSERT(section.bytes > bytes && section.bytes < bytes + length);
+    RC_TEST_ASSERT_EQUAL(0, (section.bytes - bytes) % 8);
+
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerFindSection(container, RCClipSectionTIFF, &section));
+    RC_TEST_ASSERT_EQUAL(1024 * 1024 + 3, section.length);
+    RC_TEST_ASSERT(memcmp(section.bytes, tiff, section.length) == 0);
+    RC_TEST_ASSERT_EQUAL(0, (section.bytes - bytes) % 8);
+
+    // Present but empty is distinct from absent.
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerFindSection(container, RCClipSectionURL, &section));
+    RC_TEST_ASSERT_EQUAL(0, section.length);
+    RC_TEST_ASSERT_EQUAL(RCClipContainerNotFound, RCClipContainerFindSection(container, RCClipSectionPDF, &section));
+
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerFindSection(container, RCClipSectionFileNames, &section));
+    uint64_t cursor = 0;
+    const uint8_t *item = NULL;
+    size_t itemLength = 0;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipSectionNextListItem(&section, &cursor, &item, &itemLength));
+    RC_TEST_ASSERT(itemLength == strlen("/tmp/a.txt") && memcmp(item, "/tmp/a.txt", itemLength) == 0);
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipSectionNextListItem(&section, &cursor, &item, &itemLength));
+    RC_TEST_ASSERT(itemLength == strlen("/Users/例/b c.pdf") && memcmp(item, "/Users/例/b c.pdf", itemLength) == 0);
+    RC_TEST_ASSERT_EQUAL(RCClipContainerNotFound, RCClipSectionNextListItem(&section, &cursor, &item, &itemLength));
+
+    RCClipContainerClose(container);
+    free(bytes);
+    free(tiff);
+}
+
+static void TestRoundTripThroughMappedFile(void) {
+    char *directory = RCBenchCreateScratchDirectory("rcclip-container");
+    RC_TEST_ASSERT(directory != NULL);
+    char *path = RCBenchPathJoin(directory, "clip.rcclip");
+
+    uint8_t *tiff = RCTestPatternBytes(300000, 11);
+    RCClipContainerWriter *writer = RCTestCreateWriter(tiff, 300000);
+    RC_TEST_ASSERT(writer != NULL);
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerWriterWriteFile(writer, path));
+    RCClipContainerWriterDestroy(writer);
+
+    struct stat fileStat;
+    RC_TEST_ASSERT(stat(path, &fileStat) == 0);
+    RC_TEST_ASSERT_EQUAL(0600, fileStat.st_mode & 0777);
+
+    RCClipContainer *container = NULL;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerOpenFile(path, &container));
+    RCClipSection section;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerFindSection(container, RCClipSectionTIFF, &section));
+
+    // Replacing the file (always by rename) leaves existing views intact.
+    writer = RCClipContainerWriterCreate();
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerWriterAddSection(writer, RCClipSectionString, 0, "new", 3));
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerWriterWriteFile(writer, path));
+    RCClipContainerWriterDestroy(writer);
+    RC_TEST_ASSERT(section.length == 300000 && memcmp(section.bytes, tiff, 300000) == 0);
+    RCClipContainerClose(container);
+
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerOpenFile(path, &container));
+    RC_TEST_ASSERT_EQUAL(RCClipContainerNotFound, RCClipContainerFindSection(container, RCClipSectionTIFF, &section));
+    RCClipContainerClose(container);
+
+    free(tiff);
+    free(path);
+    RCBenchRemoveScratchDirectory(directory);
+    free(directory);
+}
+
+static void TestLegacyAndEmptyFilesAreNotContainers(void) {
+    static const char legacy[] = "bplist00\xd4\x01\x02\x03\x04\x05\x06\x07\x0aX$versionY$archiver";
+    RCClipContainer *container = NULL;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerNotContainer, RCClipContainerOpenBytes(legacy, sizeof(legacy) - 1, &container));
+    RC_TEST_ASSERT(container == NULL);
+    RC_TEST_ASSERT(!RCClipContainerHasMagic(legacy, sizeof(legacy) - 1));
+
+    char *directory = RCBenchCreateScratchDirectory("rcclip-container");
+    RC_TEST_ASSERT(directory != NULL);
+    char *path = RCBenchPathJoin(directory, "empty.rcclip");
+    FILE *file = fopen(path, "wb");
+    RC_TEST_ASSERT(file != NULL);
+    fclose(file);
+    RC_TEST_ASSERT_EQUAL(RCClipContainerNotContainer, RCClipContainerOpenFile(path, &container));
+    char *missingPath = RCBenchPathJoin(directory, "missing.rcclip");
+    RC_TEST_ASSERT_EQUAL(RCClipContainerIOError, RCClipContainerOpenFile(missingPath, &container));
+    free(missingPath);
+    free(path);
+    RCBenchRemoveScratchDirectory(directory);
+    free(directory);
+}
+
+static void TestPayloadCorruptionIsDetectedPerSection(void) {
+    uint8_t *tiff = NULL;
+    uint8_t *bytes = NULL;
+    size_t length = 0;
+    RCTestCopyContainer(4096, &tiff, &bytes, &length);
+    RC_TEST_ASSERT(bytes != NULL);
+
+    RCClipContainer *container = NULL;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerOpenBytes(bytes, length, &container));
+    RCClipSection section;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerFindSection(container, RCClipSectionTIFF, &section));
+    ((uint8_t *)section.bytes)[100] ^= 0x40;
+
+    // Only the damaged section fails; the others stay readable.
+    RC_TEST_ASSERT_EQUAL(RCClipContainerChecksumMismatch, RCClipContainerFindSection(container, RCClipSectionTIFF, &section));
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerFindSection(container, RCClipSectionString, &section));
+    RCClipContainerClose(container);
+    free(bytes);
+    free(tiff);
+}
+
+static void TestDamagedHeadersAreRejected(void) {
+    uint8_t *tiff = NULL;
+    uint8_t *bytes = NULL;
+    size_t length = 0;
+    RCTestCopyContainer(1000, &tiff, &bytes, &length);
+    RC_TEST_ASSERT(bytes != NULL);
+    uint8_t *copy = malloc(length);
+    RCClipContainer *container = NULL;
+
+    // TOC byte flipped without resealing.
+    memcpy(copy, bytes, length);
+    copy[RC_CLIP_CONTAINER_HEADER_LENGTH + 8] ^= 1;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerChecksumMismatch, RCClipContainerOpenBytes(copy, length, &container));
+
+    // A section pointing past the end, resealed so only the bounds check catches it.
+    memcpy(copy, bytes, length);
+    RCTestWriteLE32(copy + RC_CLIP_CONTAINER_HEADER_LENGTH + 8, (uint32_t)length);
+    RCTestWriteLE32(copy + RC_CLIP_CONTAINER_HEADER_LENGTH + 16, 1);
+    RCTestReseal(copy);
+    RC_TEST_ASSERT_EQUAL(RCClipContainerCorrupt, RCClipContainerOpenBytes(copy, length, &container));
+
+    // Duplicate section types.
+    memcpy(copy, bytes, length);
+    RCTestWriteLE32(copy + RC_CLIP_CONTAINER_HEADER_LENGTH + RC_CLIP_CONTAINER_TOC_ENTRY_LENGTH, RCClipSectionString);
+    RCTestReseal(copy);
+    RC_TEST_ASSERT_EQUAL(RCClipContainerCorrupt, RCClipContainerOpenBytes(copy, length, &container));
+
+    // Newer format version.
+    memcpy(copy, bytes, length);
+    copy[8] = RC_CLIP_CONTAINER_VERSION + 1;
+    RCTestReseal(copy);
+    RC_TEST_ASSERT_EQUAL(RCClipContainerUnsupportedVersion, RCClipContainerOpenBytes(copy, length, &container));
+
+    // A section flag this build does not understand.
+    memcpy(copy, bytes, length);
+    RCTestWriteLE32(copy + RC_CLIP_CONTAINER_HEADER_LENGTH + 4, 0x80000000u);
+    RCTestReseal(copy);
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerOpenBytes(copy, length, &container));
+    RCClipSection section;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerUnsupportedVersion, RCClipContainerFindSection(container, RCClipSectionString, &section));
+    RCClipContainerClose(container);
+
+    // Every truncation fails cleanly.
+    for (size_t prefix = 0; prefix < length; prefix++) {
+        container = NULL;
+        RCClipContainerStatus status = RCClipContainerOpenBytes(bytes, prefix, &container);
+        RC_TEST_ASSERT(status != RCClipContainerOK && container == NULL);
+    }
+
+    free(copy);
+    free(bytes);
+    free(tiff);
+}
+
+static void TestMalformedListItemsAreReported(void) {
+    uint8_t list[] = { 3, 0, 0, 0, 'a', 'b', 'c', 9, 0, 0, 0, 'd' };
+    RCClipSection section = { RCClipSectionFileNames, 0, list, sizeof(list), 0 };
+    uint64_t cursor = 0;
+    const uint8_t *item = NULL;
+    size_t itemLength = 0;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipSectionNextListItem(&section, &cursor, &item, &itemLength));
+    RC_TEST_ASSERT_EQUAL(3, itemLength);
+    RC_TEST_ASSERT_EQUAL(RCClipContainerCorrupt, RCClipSectionNextListItem(&section, &cursor, &item, &itemLength));
+
+    section.length = 9;
+    cursor = 7;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerCorrupt, RCClipSectionNextListItem(&section, &cursor, &item, &itemLength));
+}
+
+static void TestWriterRejectsDuplicateTypes(void) {
+    RCClipContainerWriter *writer = RCClipContainerWriterCreate();
+    RC_TEST_ASSERT(writer != NULL);
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerWriterAddSection(writer, RCClipSectionPDF, 0, "x", 1));
+    RC_TEST_ASSERT_EQUAL(RCClipContainerCorrupt, RCClipContainerWriterAddSection(writer, RCClipSectionPDF, 0, "y", 1));
+    RC_TEST_ASSERT_EQUAL(RCClipContainerCorrupt, RCClipContainerWriterAddSection(writer, 0, 0, "y", 1));
+
+    // Readers skip types they do not know.
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerWriterAddSection(writer, 1000, 0, "future", 6));
+    uint8_t *bytes = NULL;
+    size_t length = 0;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerWriterCopyBytes(writer, &bytes, &length));
+    RCClipContainerWriterDestroy(writer);
+    RCClipContainer *container = NULL;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerOpenBytes(bytes, length, &container));
+    RCClipSection section;
+    RC_TEST_ASSERT_EQUAL(RCClipContainerOK, RCClipContainerFindSection(container, RCClipSectionPDF, &section));
+    RC_TEST_ASSERT(section.length == 1 && section.bytes[0] == 'x');
+    RCClipContainerClose(container);
+    free(bytes);
+}
+
+int main(void) {
+    RC_TEST_RUN(TestChecksumMatchesReferenceVectors);
+    RC_TEST_RUN(TestRoundTripInMemory);
+    RC_TEST_RUN(TestRoundTripThroughMappedFile);
+    RC_TEST_RUN(TestLegacyAndEmptyFilesAreNotContainers);
+    RC_TEST_RUN(TestPayloadCorruptionIsDetectedPerSection);
+    RC_TEST_RUN(TestDamagedHeadersAreRejected);
+    RC_TEST_RUN(TestMalformedListItemsAreReported);
+    RC_TEST_RUN(TestWriterRejectsDuplicateTypes);
+    return RC_TEST_FINISH();
+}
@@ -0,0 +1,216 @@
+//
+//  RCColdStartBenchmark.c
+//  Revclip Benchmarks
+//
+//  Cold-cache launch cost of -[RCDatabaseManager setupDatabase] against the
+//  history size. For each size the database file is copied fresh, its pages
+//  are dropped from the OS page cache, and one of three setup paths runs:
+//
+//    fast-path       connection pragmas + PRAGMA user_version check (current)
+//    full-ddl        connection pragmas + every CREATE ... IF NOT EXISTS +
+//                    schema_version read (previous steady-state launch)
+//    ddl+vacuum      full-ddl plus the auto_vacuum VACUUM that used to run on
+//                    the first launch after upgrading (now deferred)
+//
+//  Page-cache eviction uses posix_fadvise and only works on Linux; elsewhere
+//  the numbers are warm-cache.
+//
+//  Usage: RCColdStartBenchmark [--sizes 1000,10000,50000] [--iterations 3]
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "RCBenchDatabase.h"
+#include "RCBenchSupport.h"
+
+// Keep in sync with kRCCurrentSchemaVersion in RCDatabaseManager.m.
+static const int kRCCurrentSchemaVersion = 7;
+
+typedef enum {
+    RCSetupPathFast = 0,
+    RCSetupPathFullDDL,
+    RCSetupPathFullDDLWithVacuum,
+    RCSetupPathCount,
+} RCSetupPath;
+
+static const char *const kRCSetupPathNames[RCSetupPathCount] = {
+    [RCSetupPathFast] = "fast-path",
+    [RCSetupPathFullDDL] = "full-ddl",
+    [RCSetupPathFullDDLWithVacuum] = "ddl+vacuum",
+};
+
+static int64_t RCQueryInteger(sqlite3 *db, const char *sql) {
+    sqlite3_stmt *statement = NULL;
+    int64_t value = -1;
+    if (sqlite3_prepare_v2(db, sql, -1, &statement, NULL) == SQLITE_OK && sqlite3_step(statement) == SQLITE_ROW) {
+        value = sqlite3_column_int64(statement, 0);
+    } else {
+        fprintf(stderr, "query failed: %s\n  sql: %s\n", sqlite3_errmsg(db), sql);
+    }
+    sqlite3_finalize(statement);
+    return value;
+}
+
+// A pre-incremental (auto_vacuum = NONE) database at the current schema, the
+// shape every upgraded install had before its first VACUUM.
+static bool RCBuildTemplate(const char *path, int rows) {
+    // RCBenchOpenWriter switches to WAL, which fixes the header as INCREMENTAL,
+    // so the first page has to be written by a plain connection.
+    sqlite3 *db = NULL;
+    bool built = sqlite3_open(path, &db) == SQLITE_OK
+        && RCBenchExec(db, "PRAGMA auto_vacuum = NONE")
+        && RCBenchExec(db, "CREATE TABLE IF NOT EXISTS schema_version (version INTEGER NOT NULL)");
+    sqlite3_close(db);
+    if (!built) {
+        return false;
+    }
+
+    db = RCBenchOpenWriter(path, RCBenchJournalModeWAL);
+    built = db != NULL
+        && RCBenchCreateBaseSchema(db)
+        && RCBenchSeedClipItems(db, rows, 1700000000000LL)
+        && RCBenchExec(db, "PRAGMA wal_checkpoint(TRUNCATE)");
+    if (built && RCQueryInteger(db, "PRAGMA auto_vacuum") != 0) {
+        fprintf(stderr, "template is not auto_vacuum = NONE\n");
+        built = false;
+    }
+    sqlite3_close(db);
+    return built;
+}
+
+// Returns the time from open until the connection is ready for the first
+// query, or 0 on failure. The connection is closed outside the measurement.
+static uint64_t RCRunSetupPath(const char *path, RCSetupPath setupPath, int rows) {
+    uint64_t start = RCBenchNowNanoseconds();
+    sqlite3 *db = RCBenchOpenWriter(path, RCBenchJournalModeWAL);
+    if (db == NULL) {
+        return 0;
+    }
+
+    bool ready = false;
+    switch (setupPath) {
+        case RCSetupPathFast:
+            ready = RCQueryInteger(db, "PRAGMA user_version") == kRCCurrentSchemaVersion;
+            break;
+        case RCSetupPathFullDDL:
+        case RCSetupPathFullDDLWithVacuum:
+            ready = RCBenchCreateBaseSchema(db)
+                && RCQueryInteger(db, "SELECT MAX(version) FROM schema_version") == kRCCurrentSchemaVersion;
+            if (ready && setupPath == RCSetupPathFullDDLWithVacuum && RCQueryInteger(db, "PRAGMA auto_vacuum") == 0) {
+                ready = RCBenchExec(db, "PRAGMA auto_vacuum = INCREMENTAL") && RCBenchExec(db, "VACUUM");
+            }
+            break;
+        default:
+            break;
+    }
+    uint64_t elapsed = RCBenchNowNanoseconds() - start;
+
+    // The result must be a usable database with every row still there.
+    if (ready && RCQueryInteger(db, "SELECT COUNT(*) FROM clip_items") != rows) {
+        fprintf(stderr, "%s: row count changed\n", kRCSetupPathNames[setupPath]);
+        ready = false;
+    }
+    if (ready && setupPath == RCSetupPathFullDDLWithVacuum && RCQueryInteger(db, "PRAGMA auto_vacuum") != 2) {
+        fprintf(stderr, "%s: auto_vacuum was not switched to INCREMENTAL\n", kRCSetupPathNames[setupPath]);
+        ready = false;
+    }
+    sqlite3_close(db);
+    return ready ? (elapsed > 0 ? elapsed : 1) : 0;
+}
+
+int main(int argc, char **argv) {
+    const char *sizes = RCBenchStringOption(argc, argv, "--sizes", "1000,10000,50000");
+    long iterations = RCBenchIntegerOption(argc, argv, "--iterations", 3);
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    char *directory = RCBenchCreateScratchDirectory("rc-cold-start");
+    if (directory == NULL) {
+        return 1;
+    }
+    char *templatePath = RCBenchPathJoin(directory, "template.db");
+    char *databasePath = RCBenchPathJoin(directory, "revclip.db");
+    size_t databasePathLength = strlen(databasePath);
+    char *walPath = malloc(databasePathLength + 5);
+    char *shmPath = malloc(databasePathLength + 5);
+    snprintf(walPath, databasePathLength + 5, "%s-wal", databasePath);
+    snprintf(shmPath, databasePathLength + 5, "%s-shm", databasePath);
+
+    printf("RCColdStartBenchmark sizes=%s iterations=%ld sqlite=%s\n", sizes, iterations, sqlite3_libversion());
+    printf("%-8s %-12s %10s %10s %12s\n", "rows", "path", "p50 ms", "max ms", "db KiB");
+
+    int status = 0;
+    bool coldCache = true;
+    char *sizeList = strdup(sizes);
+    char *cursor = sizeList;
+    double fastestSmall = -1;
+    double fastestLarge = -1;
+    for (char *token = strsep(&cursor, ","); token != NULL && status == 0; token = strsep(&cursor, ",")) {
+        int rows = atoi(token);
+        if (rows < 1) {
+            continue;
+        }
+        unlink(templatePath);
+        if (!RCBuildTemplate(templatePath, rows)) {
+            status = 1;
+            break;
+        }
+        FILE *templateFile = fopen(templatePath, "rb");
+        long templateBytes = 0;
+        if (templateFile != NULL) {
+            fseek(templateFile, 0, SEEK_END);
+            templateBytes = ftell(templateFile);
+            fclose(templateFile);
+        }
+
+        for (int setupPath = 0; setupPath < RCSetupPathCount && status == 0; setupPath++) {
+            RCBenchSamples samples;
+            RCBenchSamplesInit(&samples, (size_t)iterations);
+            for (long iteration = 0; iteration < iterations; iteration++) {
+                unlink(walPath);
+                unlink(shmPath);
+                if (!RCBenchCopyFile(templatePath, databasePath)) {
+                    status = 1;
+                    break;
+                }
+                coldCache = RCBenchEvictFromPageCache(databasePath) && coldCache;
+                uint64_t elapsed = RCRunSetupPath(databasePath, (RCSetupPath)setupPath, rows);
+                if (elapsed == 0) {
+                    status = 1;
+                    break;
+                }
+                RCBenchSamplesAppend(&samples, elapsed);
+            }
+            if (status == 0) {
+                double median = (double)RCBenchSamplesPercentile(&samples, 50.0) / 1e6;
+                printf("%-8d %-12s %10.2f %10.2f %12ld\n",
+                       rows, kRCSetupPathNames[setupPath], median,
+                       (double)RCBenchSamplesPercentile(&samples, 100.0) / 1e6, templateBytes / 1024);
+                if (setupPath == RCSetupPathFast) {
+                    if (fastestSmall < 0) {
+                        fastestSmall = median;
+                    }
+                    fastestLarge = median;
+                }
+            }
+            RCBenchSamplesFree(&samples);
+        }
+    }
+    if (status == 0 && fastestSmall > 0) {
+        printf("fast-path largest/smallest history: %.2fx (%s page cache)\n",
+               fastestLarge / fastestSmall, coldCache ? "cold" : "warm");
+    }
+
+    free(sizeList);
+    RCBenchRemoveScratchDirectory(directory);
+    free(shmPath);
+    free(walPath);
+    free(databasePath);
+    free(templatePath);
+    free(directory);
+    return status;
+}
@@ -0,0 +1,279 @@
+//
+//  RCCompressionBenchmark.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Compression ratio and throughput of the .rcclip section codecs
+//  (Revclip/Core/RCClipCompression) over a synthetic clip corpus:
+//
+//    text        plain text from a Zipf-distributed vocabulary with some
+//                Japanese, the shape of a typical copied paragraph
+//    rtf         the same text wrapped in RTF control words and font tables
+//    tiff        a screenshot-like RGBA bitmap (flat panels, gradients,
+//                anti-aliased text rows) behind a minimal TIFF header
+//    pdf         mostly already-deflated page streams with plain objects
+//    random      incompressible bytes (photos, encrypted archives)
+//
+//  For every item it reports, per codec, the stored size relative to the
+//  input and the encode / decode throughput, plus the codec the policy
+//  (RCClipCompressionChooseCodec with the section's hot / cold class) picks.
+//  Every encode is decoded and compared; a mismatch fails the run.
+//
+//  Usage: RCCompressionBenchmark [--size-kib 1024] [--iterations 20]
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCBenchSupport.h"
+#include "RCClipCompression.h"
+
+typedef struct {
+    const char *name;
+    RCClipCompressionClass compressionClass;
+    uint8_t *bytes;
+    size_t length;
+} RCCorpusItem;
+
+static const char *const kRCCodecNames[] = { "raw", "lz4", "deflate" };
+
+static uint32_t gRCCorpusState = 0x2545F491u;
+
+static uint32_t RCCorpusRandom(void) {
+    gRCCorpusState ^= gRCCorpusState << 13;
+    gRCCorpusState ^= gRCCorpusState >> 17;
+    gRCCorpusState ^= gRCCorpusState << 5;
+    return gRCCorpusState;
+}
+
+// Zipf-ish rank: small ranks dominate.
+static size_t RCCorpusZipf(size_t count) {
+    double u = (double)(RCCorpusRandom() % 1000000 + 1) / 1000001.0;
+    size_t rank = (size_t)((double)count * u * u * u);
+    return rank < count ? rank : count - 1;
+}
+
+static size_t RCAppend(uint8_t *bytes, size_t offset, size_t capacity, const char *text) {
+    size_t length = strlen(text);
+    if (length > capacity - offset) {
+        length = capacity - offset;
+    }
+    memcpy(bytes + offset, text, length);
+    return offset + length;
+}
+
+static uint8_t *RCCorpusText(size_t length) {
+    static const char *const words[] = {
+        "the", "of", "and", "to", "a", "in", "is", "that", "for", "it", "as", "with", "was", "on", "be",
+        "clipboard", "history", "snippet", "paste", "menu", "shortcut", "folder", "preferences",
+        "performance", "storage", "capture", "compression", "section", "container", "benchmark",
+        "これは", "クリップボード", "の", "履歴", "です。", "スニペット", "を", "貼り付け",
+    };
+    size_t wordCount = sizeof(words) / sizeof(words[0]);
+    uint8_t *bytes = malloc(length);
+    size_t offset = 0;
+    while (offset < length) {
+        offset = RCAppend(bytes, offset, length, words[RCCorpusZipf(wordCount)]);
+        uint32_t r = RCCorpusRandom() % 16;
+        offset = RCAppend(bytes, offset, length, r == 0 ? ".\n" : r == 1 ? ", " : " ");
+    }
+    return bytes;
+}
+
+static uint8_t *RCCorpusRTF(size_t length) {
+    uint8_t *text = RCCorpusText(length);
+    uint8_t *bytes = malloc(length);
+    size_t offset = RCAppend(bytes, 0, length,
+                             "{\\rtf1\\ansi\\ansicpg1252\\cocoartf2761\n"
+                             "{\\fonttbl\\f0\\fswiss\\fcharset0 Helvetica;\\f1\\fnil\\fcharset128 HiraginoSans-W3;}\n"
+                             "{\\colortbl;\\red255\\green255\\blue255;\\red0\\green0\\blue0;}\n"
+                             "\\pard\\tx560\\tx1120\\tx1680\\pardirnatural\\partightenfactor0\n");
+    size_t textOffset = 0;
+    while (offset < length) {
+        static const char *const runs[] = { "\\f0\\fs24 \\cf2 ", "\\f1\\fs26 ", "\\b ", "\\b0 ", "\\i ", "\\par\n" };
+        offset = RCAppend(bytes, offset, length, runs[RCCorpusRandom() % 6]);
+        size_t run = 20 + RCCorpusRandom() % 120;
+        for (size_t i = 0; i < run && offset < length; i++) {
+            uint8_t c = text[textOffset++ % length];
+            if (c >= 0x80) {
+                // RTF escapes non-ASCII as \'xx.
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\'%02x", c);
+                offset = RCAppend(bytes, offset, length, escaped);
+            } else {
+                bytes[offset++] = c;
+            }
+        }
+    }
+    free(text);
+    return bytes;
+}
+
+static uint8_t *RCCorpusTIFF(size_t length) {
+    uint8_t *bytes = calloc(length, 1);
+    static const uint8_t header[] = { 'I', 'I', 42, 0, 8, 0, 0, 0 };
+    memcpy(bytes, header, length < sizeof(header) ? length : sizeof(header));
+    size_t width = 1024;
+    for (size_t offset = sizeof(header); offset + 4 <= length; offset += 4) {
+        size_t pixel = (offset - sizeof(header)) / 4;
+        size_t x = pixel % width;
+        size_t y = pixel / width;
+        uint8_t r, g, b;
+        if (x < 200) {
+            // Sidebar: flat.
+            r = 236; g = 236; b = 236;
+        } else if (y % 24 < 14 && x > 240 && x < 900 && (RCCorpusRandom() % 5) < 2) {
+            // Text rows: anti-aliased glyph pixels.
+            uint8_t ink = (uint8_t)(RCCorpusRandom() % 200);
+            r = ink; g = ink; b = ink;
+        } else {
+            // Content: a soft gradient.
+            r = (uint8_t)(250 - y / 8);
+            g = (uint8_t)(250 - x / 16);
+            b = 255;
+        }
+        bytes[offset] = r;
+        bytes[offset + 1] = g;
+        bytes[offset + 2] = b;
+        bytes[offset + 3] = 255;
+    }
+    return bytes;
+}
+
+static uint8_t *RCCorpusPDF(size_t length) {
+    uint8_t *bytes = malloc(length);
+    size_t offset = RCAppend(bytes, 0, length, "%PDF-1.7\n%\xe2\xe3\xcf\xd3\n");
+    int object = 1;
+    while (offset < length) {
+        char header[160];
+        snprintf(header, sizeof(header),
+                 "%d 0 obj\n<< /Length %d /Filter /FlateDecode >>\nstream\n", object++, 4000);
+        offset = RCAppend(bytes, offset, length, header);
+        for (int i = 0; i < 4000 && offset < length; i++) {
+            bytes[offset++] = (uint8_t)RCCorpusRandom();
+        }
+        offset = RCAppend(bytes, offset, length, "\nendstream\nendobj\n");
+        snprintf(header, sizeof(header),
+                 "%d 0 obj\n<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Contents %d 0 R >>\nendobj\n",
+                 object, object - 1);
+        object++;
+        offset = RCAppend(bytes, offset, length, header);
+    }
+    return bytes;
+}
+
+static uint8_t *RCCorpusRandomBytes(size_t length) {
+    uint8_t *bytes = malloc(length);
+    for (size_t i = 0; i < length; i++) {
+        bytes[i] = (uint8_t)RCCorpusRandom();
+    }
+    return bytes;
+}
+
+static double RCThroughput(size_t bytes, long iterations, uint64_t nanoseconds) {
+    return nanoseconds > 0 ? (double)bytes * (double)iterations / ((double)nanoseconds / 1e9) / 1e6 : 0;
+}
+
+// Encodes and decodes `item` with `codec`; prints one row. Returns false on a
+// round-trip mismatch.
+static bool RCMeasureCodec(const RCCorpusItem *item, RCClipCodec codec, long iterations, RCClipCodec chosen) {
+    uint8_t *payload = NULL;
+    size_t payloadLength = 0;
+    uint64_t encodeNanoseconds = 0;
+    bool compressed = false;
+    for (long iteration = 0; iteration < iterations; iteration++) {
+        free(payload);
+        payload = NULL;
+        uint64_t start = RCBenchNowNanoseconds();
+        compressed = RCClipCompressionEncode(codec, item->bytes, item->length, &payload, &payloadLength);
+        encodeNanoseconds += RCBenchNowNanoseconds() - start;
+    }
+    if (!compressed) {
+        // Stored raw: decoding is the zero-copy view of the mapped section.
+        printf("%-8s %-8s %9s %8s %12.0f %12s%s\n", item->name, kRCCodecNames[codec], "raw", "1.000",
+               RCThroughput(item->length, iterations, encodeNanoseconds), "-", chosen == codec ? "  *" : "");
+        return true;
+    }
+
+    uint8_t *decoded = malloc(item->length);
+    bool matched = true;
+    uint64_t decodeNanoseconds = 0;
+    for (long iteration = 0; iteration < iterations && matched; iteration++) {
+        uint64_t start = RCBenchNowNanoseconds();
+        matched = RCClipCompressionDecode(codec, payload, payloadLength, decoded, item->length);
+        decodeNanoseconds += RCBenchNowNanoseconds() - start;
+    }
+    matched = matched && memcmp(decoded, item->bytes, item->length) == 0;
+    if (!matched) {
+        fprintf(stderr, "%s/%s: round trip mismatch\n", item->name, kRCCodecNames[codec]);
+    }
+    printf("%-8s %-8s %9zu %8.3f %12.0f %12.0f%s\n", item->name, kRCCodecNames[codec], payloadLength,
+           (double)payloadLength / (double)item->length, RCThroughput(item->length, iterations, encodeNanoseconds),
+           RCThroughput(item->length, iterations, decodeNanoseconds), chosen == codec ? "  *" : "");
+    free(decoded);
+    free(payload);
+    return matched;
+}
+
+int main(int argc, char **argv) {
+    long sizeKiB = RCBenchIntegerOption(argc, argv, "--size-kib", 1024);
+    long iterations = RCBenchIntegerOption(argc, argv, "--iterations", 20);
+    if (sizeKiB < 1) {
+        sizeKiB = 1;
+    }
+    if (iterations < 1) {
+        iterations = 1;
+    }
+    size_t length = (size_t)sizeKiB * 1024;
+
+    RCCorpusItem corpus[] = {
+        { "text", RCClipCompressionHot, RCCorpusText(length), length },
+        { "rtf", RCClipCompressionHot, RCCorpusRTF(length), length },
+        { "tiff", RCClipCompressionCold, RCCorpusTIFF(length), length },
+        { "pdf", RCClipCompressionCold, RCCorpusPDF(length), length },
+        { "random", RCClipCompressionCold, RCCorpusRandomBytes(length), length },
+    };
+    size_t corpusCount = sizeof(corpus) / sizeof(corpus[0]);
+
+    printf("RCCompressionBenchmark size=%ld KiB iterations=%ld (* = codec picked by the policy)\n",
+           sizeKiB, iterations);
+    printf("%-8s %-8s %9s %8s %12s %12s\n", "item", "codec", "bytes", "ratio", "enc MB/s", "dec MB/s");
+
+    int status = 0;
+    size_t inputTotal = 0;
+    size_t storedTotal = 0;
+    for (size_t i = 0; i < corpusCount; i++) {
+        const RCCorpusItem *item = &corpus[i];
+        RCClipCodec chosen = RCClipCompressionChooseCodec(item->bytes, item->length, item->compressionClass);
+        if (chosen == RCClipCodecNone) {
+            printf("%-8s %-8s %9zu %8.3f %12s %12s  *\n", item->name, kRCCodecNames[RCClipCodecNone], item->length,
+                   1.0, "-", "-");
+        }
+        for (int codec = RCClipCodecLZ4; codec <= RCClipCodecDeflate; codec++) {
+            if (!RCMeasureCodec(item, (RCClipCodec)codec, iterations, chosen)) {
+                status = 1;
+            }
+        }
+
+        // What the writer would store for this item.
+        uint8_t *payload = NULL;
+        size_t payloadLength = item->length;
+        if (chosen != RCClipCodecNone
+            && RCClipCompressionEncode(chosen, item->bytes, item->length, &payload, &payloadLength)) {
+            free(payload);
+        } else {
+            payloadLength = item->length;
+        }
+        inputTotal += item->length;
+        storedTotal += payloadLength;
+    }
+    printf("corpus: %zu KiB -> %zu KiB stored with the policy (%.3f)\n",
+           inputTotal / 1024, storedTotal / 1024, (double)storedTotal / (double)inputTotal);
+
+    for (size_t i = 0; i < corpusCount; i++) {
+        free(corpus[i].bytes);
+    }
+    return status;
+}
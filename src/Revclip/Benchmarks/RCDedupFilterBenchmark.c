@@ -0,0 +1,170 @@
+//
+//  RCDedupFilterBenchmark.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Capture-time dedup check with and without the in-memory cuckoo filter
+//  (Revclip/Core/RCDigestFilter) in front of the clipItemForDataHash: point
+//  query, on a synthetic history of --rows clips (WAL, current schema).
+//
+//  Reports:
+//    - time to build the filter from `SELECT data_hash FROM clip_items` and
+//      its memory footprint
+//    - per-capture latency for novel clips (what most captures are) and for
+//      re-copied clips, SQLite only vs filter + SQLite
+//    - the fraction of SQLite lookups the filter skipped, and false positives
+//
+//  Usage: RCDedupFilterBenchmark [--rows 10000] [--lookups 20000]
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCBenchDatabase.h"
+#include "RCBenchSupport.h"
+#include "RCDigestFilter.h"
+
+static const char *const kRCLookupSQL =
+    "SELECT id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code "
+    "FROM clip_items WHERE data_hash = ? LIMIT 1";
+
+// Mirrors -[RCDatabaseManager rebuildDigestFilterInDatabase:]: headroom for twice the history.
+#define RC_BENCH_FILTER_MIN_CAPACITY 4096
+
+static RCDigestFilter *RCBuildFilter(sqlite3 *db, long rows) {
+    size_t capacity = (size_t)rows * 2 < RC_BENCH_FILTER_MIN_CAPACITY ? RC_BENCH_FILTER_MIN_CAPACITY : (size_t)rows * 2;
+    RCDigestFilter *filter = RCDigestFilterCreate(capacity);
+    sqlite3_stmt *statement = NULL;
+    if (filter == NULL || sqlite3_prepare_v2(db, "SELECT data_hash FROM clip_items", -1, &statement, NULL) != SQLITE_OK) {
+        RCDigestFilterDestroy(filter);
+        return NULL;
+    }
+    while (sqlite3_step(statement) == SQLITE_ROW) {
+        if (!RCDigestFilterAdd(filter, sqlite3_column_blob(statement, 0), (size_t)sqlite3_column_bytes(statement, 0))) {
+            RCDigestFilterDestroy(filter);
+            filter = NULL;
+            break;
+        }
+    }
+    sqlite3_finalize(statement);
+    return filter;
+}
+
+typedef struct {
+    long sqliteLookups;
+    long hits;
+} RCLookupCounts;
+
+static bool RCMeasureCaptures(sqlite3_stmt *statement,
+                              const RCDigestFilter *filter,
+                              uint64_t firstSeed,
+                              uint64_t seedRange,
+                              long lookups,
+                              RCBenchSamples *samples,
+                              RCLookupCounts *counts) {
+    uint64_t state = 0x5EEDull;
+    for (long index = 0; index < lookups; index++) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        uint64_t seed = firstSeed + (state >> 33) % seedRange;
+        uint8_t digest[32];
+        RCBenchDigestForSeed(seed, digest);
+
+        uint64_t start = RCBenchNowNanoseconds();
+        if (filter == NULL || RCDigestFilterMayContain(filter, digest, sizeof(digest))) {
+            counts->sqliteLookups++;
+            sqlite3_bind_blob(statement, 1, digest, sizeof(digest), SQLITE_TRANSIENT);
+            int result = sqlite3_step(statement);
+            if (result == SQLITE_ROW) {
+                counts->hits++;
+            } else if (result != SQLITE_DONE) {
+                return false;
+            }
+            sqlite3_reset(statement);
+        }
+        RCBenchSamplesAppend(samples, RCBenchNowNanoseconds() - start);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    long rows = RCBenchIntegerOption(argc, argv, "--rows", 10000);
+    long lookups = RCBenchIntegerOption(argc, argv, "--lookups", 20000);
+    if (rows < 1) {
+        rows = 1;
+    }
+    if (lookups < 1) {
+        lookups = 1;
+    }
+
+    printf("RCDedupFilterBenchmark rows=%ld lookups=%ld sqlite=%s\n", rows, lookups, sqlite3_libversion());
+
+    char *directory = RCBenchCreateScratchDirectory("rc-dedup-filter");
+    if (directory == NULL) {
+        return 1;
+    }
+    char *databasePath = RCBenchPathJoin(directory, "revclip.db");
+    int status = 1;
+    sqlite3_stmt *statement = NULL;
+    RCDigestFilter *filter = NULL;
+    RCBenchSamples samples[4];
+    for (int i = 0; i < 4; i++) {
+        RCBenchSamplesInit(&samples[i], (size_t)lookups);
+    }
+    RCLookupCounts counts[4];
+    memset(counts, 0, sizeof(counts));
+
+    sqlite3 *db = RCBenchOpenWriter(databasePath, RCBenchJournalModeWAL);
+    if (db == NULL || !RCBenchCreateBaseSchema(db) || !RCBenchSeedClipItems(db, (int)rows, 1700000000000LL)) {
+        goto cleanup;
+    }
+    if (sqlite3_prepare_v2(db, kRCLookupSQL, -1, &statement, NULL) != SQLITE_OK) {
+        fprintf(stderr, "lookup prepare failed: %s\n", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    uint64_t start = RCBenchNowNanoseconds();
+    filter = RCBuildFilter(db, rows);
+    uint64_t buildNanoseconds = RCBenchNowNanoseconds() - start;
+    if (filter == NULL) {
+        fprintf(stderr, "filter build failed\n");
+        goto cleanup;
+    }
+
+    // Seeds [0, rows) are stored; seeds from `rows` upwards are new content.
+    uint64_t novelSeed = (uint64_t)rows * 4;
+    if (!RCMeasureCaptures(statement, NULL, novelSeed, (uint64_t)lookups, lookups, &samples[0], &counts[0])
+        || !RCMeasureCaptures(statement, filter, novelSeed, (uint64_t)lookups, lookups, &samples[1], &counts[1])
+        || !RCMeasureCaptures(statement, NULL, 0, (uint64_t)rows, lookups, &samples[2], &counts[2])
+        || !RCMeasureCaptures(statement, filter, 0, (uint64_t)rows, lookups, &samples[3], &counts[3])) {
+        fprintf(stderr, "lookup failed: %s\n", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+    if (counts[1].hits != 0 || counts[2].hits != lookups || counts[3].hits != lookups) {
+        fprintf(stderr, "filter changed dedup results\n");
+        goto cleanup;
+    }
+
+    printf("%-28s %.2f ms, %zu bytes for %zu digests\n", "filter build",
+           (double)buildNanoseconds / 1e6, RCDigestFilterMemoryBytes(filter), RCDigestFilterCount(filter));
+    RCBenchPrintLatencyRow("novel: sqlite", &samples[0]);
+    RCBenchPrintLatencyRow("novel: filter + sqlite", &samples[1]);
+    RCBenchPrintLatencyRow("re-copied: sqlite", &samples[2]);
+    RCBenchPrintLatencyRow("re-copied: filter + sqlite", &samples[3]);
+    printf("%-28s %.2f%% of novel captures skipped SQLite (%ld false positives)\n", "filter",
+           100.0 * (double)(lookups - counts[1].sqliteLookups) / (double)lookups, counts[1].sqliteLookups);
+    status = 0;
+
+cleanup:
+    sqlite3_finalize(statement);
+    RCDigestFilterDestroy(filter);
+    sqlite3_close(db);
+    for (int i = 0; i < 4; i++) {
+        RCBenchSamplesFree(&samples[i]);
+    }
+    RCBenchRemoveScratchDirectory(directory);
+    free(databasePath);
+    free(directory);
+    return status;
+}
@@ -0,0 +1,176 @@
+//
+//  RCDigestFilterTests.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Unit tests for the dedup pre-filter (Revclip/Core/RCDigestFilter): no
+//  false negatives at the sized capacity, a false positive rate near the
+//  fingerprint bound, removals that follow evictions, a full filter that
+//  refuses additions without forgetting keys, and clearing.
+//
+//  Usage: RCDigestFilterTests
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCDigestFilter.h"
+#include "RCSHA256.h"
+#include "RCTestSupport.h"
+
+static void RCTestDigest(uint64_t seed, uint8_t digest[RC_SHA256_DIGEST_LENGTH]) {
+    RCSHA256(&seed, sizeof(seed), digest);
+}
+
+static void TestAddedDigestsAreAlwaysFound(void) {
+    const size_t count = 100000;
+    RCDigestFilter *filter = RCDigestFilterCreate(count);
+    RC_TEST_ASSERT(filter != NULL);
+    RC_TEST_ASSERT(RCDigestFilterCapacity(filter) >= count);
+
+    uint8_t digest[RC_SHA256_DIGEST_LENGTH];
+    for (uint64_t i = 0; i < count; i++) {
+        RCTestDigest(i, digest);
+        RC_TEST_ASSERT(RCDigestFilterAdd(filter, digest, sizeof(digest)));
+    }
+    RC_TEST_ASSERT_EQUAL(count, RCDigestFilterCount(filter));
+    for (uint64_t i = 0; i < count; i++) {
+        RCTestDigest(i, digest);
+        RC_TEST_ASSERT(RCDigestFilterMayContain(filter, digest, sizeof(digest)));
+    }
+
+    // Two buckets of four 16-bit fingerprints: at most 8 / 65536 per lookup.
+    const size_t probes = 1000000;
+    size_t falsePositives = 0;
+    for (uint64_t i = 0; i < probes; i++) {
+        RCTestDigest(count + i, digest);
+        falsePositives += RCDigestFilterMayContain(filter, digest, sizeof(digest)) ? 1 : 0;
+    }
+    printf("     false positives: %zu / %zu (%.4f%%), %zu bytes\n",
+           falsePositives, probes, 100.0 * (double)falsePositives / (double)probes,
+           RCDigestFilterMemoryBytes(filter));
+    RC_TEST_ASSERT(falsePositives < probes * 8 / 65536 * 2);
+
+    RCDigestFilterDestroy(filter);
+}
+
+static void TestRemovalFollowsEvictions(void) {
+    const size_t count = 20000;
+    RCDigestFilter *filter = RCDigestFilterCreate(count);
+    RC_TEST_ASSERT(filter != NULL);
+
+    uint8_t digest[RC_SHA256_DIGEST_LENGTH];
+    for (uint64_t i = 0; i < count; i++) {
+        RCTestDigest(i, digest);
+        RC_TEST_ASSERT(RCDigestFilterAdd(filter, digest, sizeof(digest)));
+    }
+
+    // Evict the older half.
+    for (uint64_t i = 0; i < count / 2; i++) {
+        RCTestDigest(i, digest);
+        RC_TEST_ASSERT(RCDigestFilterRemove(filter, digest, sizeof(digest)));
+    }
+    RC_TEST_ASSERT_EQUAL(count / 2, RCDigestFilterCount(filter));
+
+    size_t stillReported = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        RCTestDigest(i, digest);
+        bool mayContain = RCDigestFilterMayContain(filter, digest, sizeof(digest));
+        if (i >= count / 2) {
+            RC_TEST_ASSERT(mayContain);
+        } else if (mayContain) {
+            stillReported++;
+        }
+    }
+    // Only fingerprint collisions with the surviving half remain.
+    RC_TEST_ASSERT(stillReported < 10);
+
+    // A key that was never added is not found for removal (with these seeds).
+    RCTestDigest(count * 10, digest);
+    RC_TEST_ASSERT(!RCDigestFilterMayContain(filter, digest, sizeof(digest)));
+    RC_TEST_ASSERT(!RCDigestFilterRemove(filter, digest, sizeof(digest)));
+
+    // The same key added twice needs two removals, like two rows would.
+    RCTestDigest(count - 1, digest);
+    RC_TEST_ASSERT(RCDigestFilterAdd(filter, digest, sizeof(digest)));
+    RC_TEST_ASSERT(RCDigestFilterRemove(filter, digest, sizeof(digest)));
+    RC_TEST_ASSERT(RCDigestFilterMayContain(filter, digest, sizeof(digest)));
+
+    RCDigestFilterDestroy(filter);
+}
+
+static void TestFullFilterRefusesWithoutForgetting(void) {
+    RCDigestFilter *filter = RCDigestFilterCreate(64);
+    RC_TEST_ASSERT(filter != NULL);
+
+    uint8_t digest[RC_SHA256_DIGEST_LENGTH];
+    uint64_t added = 0;
+    for (;;) {
+        RCTestDigest(added, digest);
+        if (!RCDigestFilterAdd(filter, digest, sizeof(digest))) {
+            break;
+        }
+        added++;
+        RC_TEST_ASSERT(added <= RCDigestFilterMemoryBytes(filter) / sizeof(uint16_t) + 1);
+    }
+    RC_TEST_ASSERT(added >= RCDigestFilterCapacity(filter));
+    RC_TEST_ASSERT_EQUAL(added, RCDigestFilterCount(filter));
+
+    // Every key that was accepted, including the one parked as the victim,
+    // is still reported.
+    for (uint64_t i = 0; i < added; i++) {
+        RCTestDigest(i, digest);
+        RC_TEST_ASSERT(RCDigestFilterMayContain(filter, digest, sizeof(digest)));
+    }
+
+    // Removing keys makes room again.
+    for (uint64_t i = 0; i < 8; i++) {
+        RCTestDigest(i, digest);
+        RC_TEST_ASSERT(RCDigestFilterRemove(filter, digest, sizeof(digest)));
+    }
+    RCTestDigest(added, digest);
+    RC_TEST_ASSERT(RCDigestFilterAdd(filter, digest, sizeof(digest)));
+    for (uint64_t i = 8; i <= added; i++) {
+        RCTestDigest(i, digest);
+        RC_TEST_ASSERT(RCDigestFilterMayContain(filter, digest, sizeof(digest)));
+    }
+
+    RCDigestFilterDestroy(filter);
+}
+
+static void TestClearAndArbitraryKeys(void) {
+    RCDigestFilter *filter = RCDigestFilterCreate(1000);
+    RC_TEST_ASSERT(filter != NULL);
+
+    // Keys of any length, such as hex strings.
+    char key[32];
+    for (int i = 0; i < 1000; i++) {
+        int length = snprintf(key, sizeof(key), "clip-%d", i);
+        RC_TEST_ASSERT(RCDigestFilterAdd(filter, key, (size_t)length));
+    }
+    for (int i = 0; i < 1000; i++) {
+        int length = snprintf(key, sizeof(key), "clip-%d", i);
+        RC_TEST_ASSERT(RCDigestFilterMayContain(filter, key, (size_t)length));
+    }
+
+    RCDigestFilterClear(filter);
+    RC_TEST_ASSERT_EQUAL(0, RCDigestFilterCount(filter));
+    size_t reported = 0;
+    for (int i = 0; i < 1000; i++) {
+        int length = snprintf(key, sizeof(key), "clip-%d", i);
+        reported += RCDigestFilterMayContain(filter, key, (size_t)length) ? 1 : 0;
+    }
+    RC_TEST_ASSERT_EQUAL(0, reported);
+
+    RCDigestFilterDestroy(filter);
+}
+
+int main(void) {
+    RC_TEST_RUN(TestAddedDigestsAreAlwaysFound);
+    RC_TEST_RUN(TestRemovalFollowsEvictions);
+    RC_TEST_RUN(TestFullFilterRefusesWithoutForgetting);
+    RC_TEST_RUN(TestClearAndArbitraryKeys);
+    return RC_TEST_FINISH();
+}
@@ -0,0 +1,174 @@
+//
+//  RCEvictionBenchmark.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Measures how long it takes to trim the history from --rows down to --limit
+//  (the "max history 9999 -> 30" preference change).
+//
+//    per-row   : fetch the whole history, then one autocommit DELETE per excess
+//                row, i.e. the old trimHistoryIfNeededWithDatabaseManager:.
+//    set-based : one DELETE ... RETURNING inside one transaction, i.e.
+//                -[RCDatabaseManager evictClipItemsBeyondLimit:olderThan:].
+//
+//  Usage: RCEvictionBenchmark [--rows 9999] [--limit 30] [--iterations 3]
+//                             [--mode both|per-row|set-based]
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCBenchDatabase.h"
+#include "RCBenchSupport.h"
+
+// Keep in sync with kRCEvictClipItemsSQL in RCDatabaseManager.m.
+static const char *const kRCEvictClipItemsSQL =
+    "DELETE FROM clip_items WHERE update_time < ? OR id IN "
+    "(SELECT id FROM clip_items ORDER BY update_time DESC, id DESC LIMIT -1 OFFSET ?) "
+    "RETURNING id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code";
+
+static long RCEvictPerRow(sqlite3 *db, long limit) {
+    sqlite3_stmt *select = NULL;
+    sqlite3_stmt *delete = NULL;
+    if (sqlite3_prepare_v2(db,
+                           "SELECT id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code "
+                           "FROM clip_items ORDER BY update_time DESC LIMIT ?",
+                           -1, &select, NULL) != SQLITE_OK
+        || sqlite3_prepare_v2(db, "DELETE FROM clip_items WHERE data_hash = ?", -1, &delete, NULL) != SQLITE_OK) {
+        fprintf(stderr, "per-row prepare failed: %s\n", sqlite3_errmsg(db));
+        sqlite3_finalize(select);
+        return -1;
+    }
+
+    // The old path loaded every row first (fetchClipItemsWithLimit:count).
+    size_t hashCount = 0;
+    size_t hashCapacity = 1024;
+    uint8_t (*hashes)[32] = malloc(hashCapacity * sizeof(*hashes));
+    sqlite3_bind_int64(select, 1, INT64_MAX);
+    while (sqlite3_step(select) == SQLITE_ROW) {
+        if (hashCount == hashCapacity) {
+            hashCapacity *= 2;
+            hashes = realloc(hashes, hashCapacity * sizeof(*hashes));
+        }
+        memcpy(hashes[hashCount++], sqlite3_column_blob(select, 3), sizeof(*hashes));
+    }
+    sqlite3_finalize(select);
+
+    long deleted = 0;
+    for (size_t index = hashCount; index > (size_t)limit; index--) {
+        sqlite3_bind_blob(delete, 1, hashes[index - 1], sizeof(*hashes), SQLITE_STATIC);
+        if (sqlite3_step(delete) == SQLITE_DONE) {
+            deleted += sqlite3_changes(db);
+        }
+        sqlite3_reset(delete);
+    }
+    sqlite3_finalize(delete);
+
+    free(hashes);
+    return deleted;
+}
+
+static long RCEvictSetBased(sqlite3 *db, long limit) {
+    sqlite3_stmt *statement = NULL;
+    if (sqlite3_prepare_v2(db, kRCEvictClipItemsSQL, -1, &statement, NULL) != SQLITE_OK) {
+        fprintf(stderr, "set-based prepare failed: %s\n", sqlite3_errmsg(db));
+        return -1;
+    }
+
+    if (!RCBenchExec(db, "BEGIN IMMEDIATE")) {
+        sqlite3_finalize(statement);
+        return -1;
+    }
+
+    sqlite3_bind_int64(statement, 1, INT64_MIN);
+    sqlite3_bind_int64(statement, 2, limit);
+    long deleted = 0;
+    int rc;
+    while ((rc = sqlite3_step(statement)) == SQLITE_ROW) {
+        // The caller keeps the returned paths for batch file removal.
+        (void)sqlite3_column_text(statement, 1);
+        (void)sqlite3_column_text(statement, 6);
+        deleted++;
+    }
+    sqlite3_finalize(statement);
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "set-based eviction failed: %s\n", sqlite3_errmsg(db));
+        RCBenchExec(db, "ROLLBACK");
+        return -1;
+    }
+    return RCBenchExec(db, "COMMIT") ? deleted : -1;
+}
+
+static int RCRunScenario(bool setBased, long rows, long limit, long iterations) {
+    RCBenchSamples samples;
+    RCBenchSamplesInit(&samples, (size_t)iterations);
+    long lastDeleted = 0;
+    int status = 0;
+
+    for (long iteration = 0; iteration < iterations && status == 0; iteration++) {
+        char *directory = RCBenchCreateScratchDirectory("rc-eviction");
+        if (directory == NULL) {
+            status = 1;
+            break;
+        }
+        char *databasePath = RCBenchPathJoin(directory, "revclip.db");
+
+        sqlite3 *db = RCBenchOpenWriter(databasePath, RCBenchJournalModeWAL);
+        if (db == NULL
+            || !RCBenchCreateBaseSchema(db)
+            || !RCBenchSeedClipItems(db, (int)rows, 1700000000000LL)) {
+            status = 1;
+        } else {
+            uint64_t start = RCBenchNowNanoseconds();
+            lastDeleted = setBased ? RCEvictSetBased(db, limit) : RCEvictPerRow(db, limit);
+            RCBenchSamplesAppend(&samples, RCBenchNowNanoseconds() - start);
+            if (lastDeleted != (rows > limit ? rows - limit : 0)) {
+                fprintf(stderr, "unexpected deleted row count %ld\n", lastDeleted);
+                status = 1;
+            }
+        }
+
+        sqlite3_close(db);
+        RCBenchRemoveScratchDirectory(directory);
+        free(databasePath);
+        free(directory);
+    }
+
+    if (status == 0) {
+        char label[64];
+        snprintf(label, sizeof(label), "%s trim", setBased ? "set-based" : "per-row");
+        RCBenchPrintLatencyRow(label, &samples);
+        printf("%-28s %ld rows\n", "  evicted per run", lastDeleted);
+    }
+    RCBenchSamplesFree(&samples);
+    return status;
+}
+
+int main(int argc, char **argv) {
+    long rows = RCBenchIntegerOption(argc, argv, "--rows", 9999);
+    long limit = RCBenchIntegerOption(argc, argv, "--limit", 30);
+    long iterations = RCBenchIntegerOption(argc, argv, "--iterations", 3);
+    const char *mode = RCBenchStringOption(argc, argv, "--mode", "both");
+
+    if (limit < 1) {
+        limit = 1;
+    }
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    printf("RCEvictionBenchmark rows=%ld limit=%ld iterations=%ld sqlite=%s\n",
+           rows, limit, iterations, sqlite3_libversion());
+
+    int status = 0;
+    if (strcmp(mode, "both") == 0 || strcmp(mode, "per-row") == 0) {
+        status |= RCRunScenario(false, rows, limit, iterations);
+    }
+    if (strcmp(mode, "both") == 0 || strcmp(mode, "set-based") == 0) {
+        status |= RCRunScenario(true, rows, limit, iterations);
+    }
+    return status;
+}
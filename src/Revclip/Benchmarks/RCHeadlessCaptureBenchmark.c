@@ -0,0 +1,179 @@
+//
+//  RCHeadlessCaptureBenchmark.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Synthetic clipboard load through the headless capture path (RCBenchCapture
+//  on an RCBenchPasteboard): capture -> dedup -> persist -> cleanup, with no
+//  window server. The script of --copies copies is generated from --seed on
+//  a virtual clock, so a run takes as long as the work and not as long as
+//  the script:
+//
+//    - short text (most copies), RTF + text, file URLs, and TIFF images up
+//      to --image-kib
+//    - re-copies of recent clips (dedup hits), copies from a password
+//      manager (concealed marker type) and from an excluded app
+//    - script bursts of 5-20 copies 20 ms apart (coalesced), hot key activity
+//
+//  Reports wall time, copies per second, per-clip latency (snapshot to
+//  committed row) and the pipeline counters, then checks the end state:
+//  the history holds at most --limit rows, one .rcclip per row, and every
+//  copy is accounted for.
+//
+//  Runs the RCBenchCapture model, not RCClipboardService; the app's capture
+//  path is measured by RevclipTests/RCClipboardCapturePerformanceTests.m.
+//
+//  Usage: RCHeadlessCaptureBenchmark [--copies 5000] [--limit 100]
+//                                    [--image-kib 512] [--seed 1]
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCBenchCapture.h"
+#include "RCBenchSupport.h"
+
+static const char *const kRCExcludedBundleIdentifier = "com.example.excluded";
+
+static uint64_t RCNextRandom(uint64_t *state) {
+    *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+    return *state >> 33;
+}
+
+static RCReplayEvent *RCGenerateScript(long copies, long imageKiB, uint64_t seed, size_t *outCount) {
+    // worst case: one activity event per copy
+    RCReplayEvent *events = calloc((size_t)copies * 2, sizeof(*events));
+    if (events == NULL) {
+        return NULL;
+    }
+    uint64_t state = seed;
+    uint64_t now = 0;
+    size_t count = 0;
+    long burstRemaining = 0;
+    for (long copy = 0; copy < copies; copy++) {
+        if (burstRemaining > 0) {
+            burstRemaining--;
+            now += 20000000ull;
+        } else {
+            // 0.2 - 3 s between copies by hand
+            now += 200000000ull + RCNextRandom(&state) % 2800000000ull;
+            if (RCNextRandom(&state) % 100 < 10) {
+                events[count++] = (RCReplayEvent){ .atNanoseconds = now, .kind = RCReplayEventActivity };
+                now += 1000000ull;
+            }
+            if (RCNextRandom(&state) % 100 < 3) {
+                burstRemaining = 4 + (long)(RCNextRandom(&state) % 16);
+            }
+        }
+
+        RCBenchPasteboardContents contents = {
+            .offered = RCClipRepresentationString,
+            .length = 16 + RCNextRandom(&state) % 512,
+            .seed = seed * 1000003ull + (uint64_t)copy,
+            .sourceBundleIdentifier = "com.example.editor",
+        };
+        uint64_t kind = RCNextRandom(&state) % 100;
+        if (kind < 12 && copy > 0) {
+            // re-copy one of the last 20 copies' contents
+            const RCReplayEvent *previous = &events[count - 1];
+            uint64_t back = 1 + RCNextRandom(&state) % 20;
+            for (size_t index = count; index > 0 && back > 0; index--) {
+                if (events[index - 1].kind == RCReplayEventCopy) {
+                    previous = &events[index - 1];
+                    back--;
+                }
+            }
+            contents = previous->contents;
+        } else if (kind < 22) {
+            contents.offered = RCClipRepresentationString | RCClipRepresentationRTF;
+            contents.length = 1024 + RCNextRandom(&state) % (16 * 1024);
+        } else if (kind < 27) {
+            contents.offered = RCClipRepresentationFiles;
+            contents.length = 40 + RCNextRandom(&state) % 200;
+            contents.sourceBundleIdentifier = "com.apple.finder";
+        } else if (kind < 35) {
+            contents.offered = RCClipRepresentationTIFF;
+            contents.length = 1024 + RCNextRandom(&state) % ((uint64_t)imageKiB * 1024);
+            contents.sourceBundleIdentifier = "com.example.preview";
+        } else if (kind < 38) {
+            contents.marked = true;
+            contents.sourceBundleIdentifier = "com.example.passwords";
+        } else if (kind < 40) {
+            contents.sourceBundleIdentifier = kRCExcludedBundleIdentifier;
+        }
+        events[count++] = (RCReplayEvent){ .atNanoseconds = now, .kind = RCReplayEventCopy, .contents = contents };
+    }
+    *outCount = count;
+    return events;
+}
+
+int main(int argc, char **argv) {
+    long copies = RCBenchIntegerOption(argc, argv, "--copies", 5000);
+    long limit = RCBenchIntegerOption(argc, argv, "--limit", 100);
+    long imageKiB = RCBenchIntegerOption(argc, argv, "--image-kib", 512);
+    long seed = RCBenchIntegerOption(argc, argv, "--seed", 1);
+    copies = copies < 1 ? 1 : copies;
+    limit = limit < 1 ? 1 : limit;
+    imageKiB = imageKiB < 1 ? 1 : imageKiB;
+
+    printf("RCHeadlessCaptureBenchmark copies=%ld limit=%ld image-kib=%ld seed=%ld\n", copies, limit, imageKiB, seed);
+
+    size_t eventCount = 0;
+    RCReplayEvent *events = RCGenerateScript(copies, imageKiB, (uint64_t)seed, &eventCount);
+    char *directory = RCBenchCreateScratchDirectory("rc-headless-capture");
+    if (events == NULL || directory == NULL) {
+        free(events);
+        free(directory);
+        return 1;
+    }
+
+    int status = 1;
+    RCBenchPasteboard pasteboard;
+    RCBenchPasteboardInit(&pasteboard);
+    RCBenchCaptureConfiguration configuration = RCBenchCaptureDefaultConfiguration();
+    configuration.historyLimit = limit;
+    configuration.excludedBundleIdentifier = kRCExcludedBundleIdentifier;
+    RCBenchCapture *capture = RCBenchCaptureCreate(directory, &configuration, &pasteboard);
+    if (capture == NULL) {
+        goto cleanup;
+    }
+
+    uint64_t start = RCBenchNowNanoseconds();
+    bool ran = RCBenchCaptureRunScript(capture, events, eventCount);
+    uint64_t elapsed = RCBenchNowNanoseconds() - start;
+    uint64_t scriptNanoseconds = eventCount > 0 ? events[eventCount - 1].atNanoseconds : 0;
+
+    RCBenchCaptureCounters counters;
+    RCBenchCaptureGetCounters(capture, &counters);
+    printf("%-24s %.2f s wall for %.1f min of copies, %.0f copies/s\n", "run",
+           (double)elapsed / 1e9, (double)scriptNanoseconds / 6e10, (double)copies / ((double)elapsed / 1e9));
+    RCBenchPrintLatencyRow("capture latency", RCBenchCaptureLatencies(capture));
+    printf("%-24s polls=%llu changes=%llu captured=%llu duplicates=%llu coalesced=%llu\n", "pipeline",
+           (unsigned long long)counters.polls, (unsigned long long)counters.changes,
+           (unsigned long long)counters.captured, (unsigned long long)counters.duplicates,
+           (unsigned long long)counters.coalesced);
+    printf("%-24s marked=%llu excluded=%llu oversized=%llu filter-skips=%llu\n", "skipped",
+           (unsigned long long)counters.skippedMarked, (unsigned long long)counters.excluded,
+           (unsigned long long)counters.skippedOversized, (unsigned long long)counters.filterSkips);
+    printf("%-24s inserted=%llu evicted=%llu transactions=%llu cleanups=%llu\n", "history",
+           (unsigned long long)counters.inserted, (unsigned long long)counters.evicted,
+           (unsigned long long)counters.transactions, (unsigned long long)counters.cleanups);
+    printf("%-24s read=%.1f MiB files=%llu written=%.1f MiB removed=%llu\n", "bytes",
+           (double)counters.bytesRead / 1048576.0, (unsigned long long)counters.clipFilesWritten,
+           (double)counters.clipBytesWritten / 1048576.0, (unsigned long long)counters.clipFilesRemoved);
+
+    if (!ran) {
+        fprintf(stderr, "capture script failed\n");
+    } else if (RCBenchCaptureVerify(capture)) {
+        status = 0;
+    }
+
+cleanup:
+    RCBenchCaptureDestroy(capture);
+    RCBenchRemoveScratchDirectory(directory);
+    free(directory);
+    free(events);
+    return status;
+}
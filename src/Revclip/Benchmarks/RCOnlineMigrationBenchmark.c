@@ -0,0 +1,412 @@
+//
+//  RCOnlineMigrationBenchmark.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  A data migration over every clip_items row (filling a new data_hash_v2
+//  column, the shape of a future digest-format change) while a capture thread
+//  keeps inserting clips through the same writer connection, which stands in
+//  for the databaseQueue.
+//
+//    one-transaction  every row rewritten inside one writer transaction, the
+//                     way migrateIfNeeded runs its steps
+//    chunked          -[RCDatabaseManager runOnlineMigration:progress:]: rows
+//                     are read on a reader connection, then --batch rows per
+//                     writer transaction with the online_migrations checkpoint
+//                     committed alongside. The run stops half way and resumes
+//                     from the stored checkpoint on a new reader connection;
+//                     the result must cover every row exactly once.
+//                     --batch-interval-us pauses between batches, the way
+//                     RCOnlineMigration.batchInterval throttles the
+//                     fingerprint v2 rehash.
+//
+//  Reports capture insert latency (writer wait included), migration wall time
+//  and the longest single hold of the writer by the migration.
+//
+//  Usage: RCOnlineMigrationBenchmark [--rows 50000] [--batch 200]
+//                                    [--capture-interval-us 2000]
+//                                    [--batch-interval-us 0]
+//                                    [--mode both|one-transaction|chunked]
+//
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCBenchDatabase.h"
+#include "RCBenchSupport.h"
+
+static const char *const kRCMigrationName = "clip_items.data_hash_v2";
+static const char *const kRCSelectAllRowsSQL =
+    "SELECT id, data_hash FROM clip_items WHERE data_hash_v2 IS NULL ORDER BY id";
+// The RCOnlineMigration statements: keyset select, idempotent update, checkpoint.
+static const char *const kRCSelectBatchSQL = "SELECT id, data_hash FROM clip_items WHERE id > ? ORDER BY id LIMIT ?";
+static const char *const kRCUpdateRowSQL = "UPDATE clip_items SET data_hash_v2 = ? WHERE id = ? AND data_hash_v2 IS NULL";
+static const char *const kRCSelectCheckpointSQL = "SELECT checkpoint, completed FROM online_migrations WHERE name = ?";
+static const char *const kRCUpdateCheckpointSQL =
+    "UPDATE online_migrations SET checkpoint = ?, migrated_rows = migrated_rows + ?, completed = ? WHERE name = ?";
+static const char *const kRCCaptureSQL =
+    "INSERT INTO clip_items (data_path, title, data_hash, primary_type, update_time, data_hash_v2) "
+    "VALUES (?, 'capture', ?, 'public.utf8-plain-text', ?, ?)";
+
+typedef enum {
+    RCMigrationModeOneTransaction = 0,
+    RCMigrationModeChunked,
+} RCMigrationMode;
+
+typedef struct {
+    sqlite3 *writer;
+    pthread_mutex_t writerLock;
+    atomic_bool stop;
+    atomic_long captures;
+    long captureIntervalMicroseconds;
+    long batchIntervalMicroseconds;
+    RCBenchSamples captureLatencies;
+    long captureFailures;
+    uint64_t longestHoldNanoseconds;
+} RCMigrationContext;
+
+static int64_t RCQueryInteger(sqlite3 *db, const char *sql) {
+    sqlite3_stmt *statement = NULL;
+    int64_t value = -1;
+    if (sqlite3_prepare_v2(db, sql, -1, &statement, NULL) == SQLITE_OK && sqlite3_step(statement) == SQLITE_ROW) {
+        value = sqlite3_column_int64(statement, 0);
+    } else {
+        fprintf(stderr, "query failed: %s\n  sql: %s\n", sqlite3_errmsg(db), sql);
+    }
+    sqlite3_finalize(statement);
+    return value;
+}
+
+// The per-row work of the migration: a new digest derived from the old key.
+static void RCMigratedDigest(int64_t clipID, const void *dataHash, int dataHashLength, uint8_t out[32]) {
+    uint64_t seed = (uint64_t)clipID;
+    if (dataHash != NULL && dataHashLength >= 8) {
+        uint64_t prefix;
+        memcpy(&prefix, dataHash, sizeof(prefix));
+        seed ^= prefix;
+    }
+    RCBenchDigestForSeed(seed, out);
+}
+
+static uint64_t RCLockWriter(RCMigrationContext *context) {
+    pthread_mutex_lock(&context->writerLock);
+    return RCBenchNowNanoseconds();
+}
+
+static void RCUnlockWriter(RCMigrationContext *context, uint64_t lockedAt) {
+    uint64_t held = RCBenchNowNanoseconds() - lockedAt;
+    if (held > context->longestHoldNanoseconds) {
+        context->longestHoldNanoseconds = held;
+    }
+    pthread_mutex_unlock(&context->writerLock);
+}
+
+static void *RCCaptureMain(void *argument) {
+    RCMigrationContext *context = argument;
+    sqlite3_stmt *statement = NULL;
+    pthread_mutex_lock(&context->writerLock);
+    int prepared = sqlite3_prepare_v2(context->writer, kRCCaptureSQL, -1, &statement, NULL);
+    pthread_mutex_unlock(&context->writerLock);
+    if (prepared != SQLITE_OK) {
+        context->captureFailures++;
+        return NULL;
+    }
+
+    uint64_t sequence = 1u << 30;
+    int64_t updateTime = 2000000000000LL;
+    while (!atomic_load(&context->stop)) {
+        char dataPath[64];
+        uint8_t dataHash[32];
+        uint8_t migratedHash[32];
+        snprintf(dataPath, sizeof(dataPath), "%llu.rcclip", (unsigned long long)sequence);
+        RCBenchDigestForSeed(sequence, dataHash);
+        // New captures are written in the migrated format from the start.
+        RCMigratedDigest((int64_t)sequence, dataHash, (int)sizeof(dataHash), migratedHash);
+        sequence++;
+
+        uint64_t start = RCBenchNowNanoseconds();
+        pthread_mutex_lock(&context->writerLock);
+        sqlite3_bind_text(statement, 1, dataPath, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_blob(statement, 2, dataHash, (int)sizeof(dataHash), SQLITE_TRANSIENT);
+        sqlite3_bind_int64(statement, 3, updateTime++);
+        sqlite3_bind_blob(statement, 4, migratedHash, (int)sizeof(migratedHash), SQLITE_TRANSIENT);
+        bool inserted = sqlite3_step(statement) == SQLITE_DONE;
+        sqlite3_reset(statement);
+        pthread_mutex_unlock(&context->writerLock);
+        if (inserted) {
+            RCBenchSamplesAppend(&context->captureLatencies, RCBenchNowNanoseconds() - start);
+            atomic_fetch_add(&context->captures, 1);
+        } else {
+            context->captureFailures++;
+        }
+        RCBenchSleepMicroseconds((uint64_t)context->captureIntervalMicroseconds);
+    }
+
+    pthread_mutex_lock(&context->writerLock);
+    sqlite3_finalize(statement);
+    pthread_mutex_unlock(&context->writerLock);
+    return NULL;
+}
+
+static bool RCMigrateInOneTransaction(RCMigrationContext *context) {
+    sqlite3_stmt *selectStatement = NULL;
+    sqlite3_stmt *updateStatement = NULL;
+    uint64_t lockedAt = RCLockWriter(context);
+    bool migrated = RCBenchExec(context->writer, "BEGIN IMMEDIATE")
+        && sqlite3_prepare_v2(context->writer, kRCSelectAllRowsSQL, -1, &selectStatement, NULL) == SQLITE_OK
+        && sqlite3_prepare_v2(context->writer, kRCUpdateRowSQL, -1, &updateStatement, NULL) == SQLITE_OK;
+    while (migrated && sqlite3_step(selectStatement) == SQLITE_ROW) {
+        uint8_t digest[32];
+        int64_t clipID = sqlite3_column_int64(selectStatement, 0);
+        RCMigratedDigest(clipID, sqlite3_column_blob(selectStatement, 1), sqlite3_column_bytes(selectStatement, 1), digest);
+        sqlite3_bind_blob(updateStatement, 1, digest, (int)sizeof(digest), SQLITE_TRANSIENT);
+        sqlite3_bind_int64(updateStatement, 2, clipID);
+        migrated = sqlite3_step(updateStatement) == SQLITE_DONE;
+        sqlite3_reset(updateStatement);
+    }
+    sqlite3_finalize(selectStatement);
+    sqlite3_finalize(updateStatement);
+    migrated = migrated && RCBenchExec(context->writer, "COMMIT");
+    if (!migrated) {
+        fprintf(stderr, "one-transaction migration failed: %s\n", sqlite3_errmsg(context->writer));
+        RCBenchExec(context->writer, "ROLLBACK");
+    }
+    RCUnlockWriter(context, lockedAt);
+    return migrated;
+}
+
+// Runs up to maxBatches batches (0 = until the table is exhausted) starting
+// after the stored checkpoint. Returns the number of committed batches, or -1.
+static long RCMigrateInBatches(RCMigrationContext *context, sqlite3 *reader, long batchSize, long maxBatches) {
+    int64_t checkpoint = 0;
+    bool completed = false;
+    sqlite3_stmt *statement = NULL;
+    if (sqlite3_prepare_v2(reader, kRCSelectCheckpointSQL, -1, &statement, NULL) != SQLITE_OK) {
+        fprintf(stderr, "checkpoint prepare failed: %s\n", sqlite3_errmsg(reader));
+        return -1;
+    }
+    sqlite3_bind_text(statement, 1, kRCMigrationName, -1, SQLITE_STATIC);
+    if (sqlite3_step(statement) == SQLITE_ROW) {
+        checkpoint = sqlite3_column_int64(statement, 0);
+        completed = sqlite3_column_int(statement, 1) != 0;
+    }
+    sqlite3_finalize(statement);
+    if (completed) {
+        return 0;
+    }
+
+    int64_t *clipIDs = malloc(sizeof(int64_t) * (size_t)batchSize);
+    uint8_t (*digests)[32] = malloc(32 * (size_t)batchSize);
+    sqlite3_stmt *selectStatement = NULL;
+    sqlite3_stmt *updateStatement = NULL;
+    sqlite3_stmt *checkpointStatement = NULL;
+    pthread_mutex_lock(&context->writerLock);
+    bool prepared = sqlite3_prepare_v2(context->writer, kRCUpdateRowSQL, -1, &updateStatement, NULL) == SQLITE_OK
+        && sqlite3_prepare_v2(context->writer, kRCUpdateCheckpointSQL, -1, &checkpointStatement, NULL) == SQLITE_OK;
+    pthread_mutex_unlock(&context->writerLock);
+    prepared = prepared && sqlite3_prepare_v2(reader, kRCSelectBatchSQL, -1, &selectStatement, NULL) == SQLITE_OK;
+
+    long batches = prepared ? 0 : -1;
+    bool finished = false;
+    while (batches >= 0 && !finished && (maxBatches == 0 || batches < maxBatches)) {
+        // Read and transform outside the writer.
+        long count = 0;
+        sqlite3_bind_int64(selectStatement, 1, checkpoint);
+        sqlite3_bind_int64(selectStatement, 2, batchSize);
+        while (sqlite3_step(selectStatement) == SQLITE_ROW) {
+            clipIDs[count] = sqlite3_column_int64(selectStatement, 0);
+            RCMigratedDigest(clipIDs[count], sqlite3_column_blob(selectStatement, 1),
+                             sqlite3_column_bytes(selectStatement, 1), digests[count]);
+            count++;
+        }
+        sqlite3_reset(selectStatement);
+        finished = count < batchSize;
+        int64_t nextCheckpoint = count > 0 ? clipIDs[count - 1] : checkpoint;
+
+        uint64_t lockedAt = RCLockWriter(context);
+        bool committed = RCBenchExec(context->writer, "BEGIN IMMEDIATE");
+        for (long index = 0; committed && index < count; index++) {
+            sqlite3_bind_blob(updateStatement, 1, digests[index], 32, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(updateStatement, 2, clipIDs[index]);
+            committed = sqlite3_step(updateStatement) == SQLITE_DONE;
+            sqlite3_reset(updateStatement);
+        }
+        if (committed) {
+            sqlite3_bind_int64(checkpointStatement, 1, nextCheckpoint);
+            sqlite3_bind_int64(checkpointStatement, 2, count);
+            sqlite3_bind_int(checkpointStatement, 3, finished ? 1 : 0);
+            sqlite3_bind_text(checkpointStatement, 4, kRCMigrationName, -1, SQLITE_STATIC);
+            committed = sqlite3_step(checkpointStatement) == SQLITE_DONE;
+            sqlite3_reset(checkpointStatement);
+        }
+        committed = committed && RCBenchExec(context->writer, "COMMIT");
+        if (!committed) {
+            fprintf(stderr, "batch after id %lld failed: %s\n", (long long)checkpoint, sqlite3_errmsg(context->writer));
+            RCBenchExec(context->writer, "ROLLBACK");
+        }
+        RCUnlockWriter(context, lockedAt);
+
+        if (!committed) {
+            batches = -1;
+            break;
+        }
+        checkpoint = nextCheckpoint;
+        batches++;
+        if (!finished && context->batchIntervalMicroseconds > 0) {
+            RCBenchSleepMicroseconds((uint64_t)context->batchIntervalMicroseconds);
+        }
+    }
+
+    sqlite3_finalize(selectStatement);
+    pthread_mutex_lock(&context->writerLock);
+    sqlite3_finalize(updateStatement);
+    sqlite3_finalize(checkpointStatement);
+    pthread_mutex_unlock(&context->writerLock);
+    free(digests);
+    free(clipIDs);
+    return batches;
+}
+
+static bool RCVerifyMigration(sqlite3 *db, RCMigrationMode mode) {
+    int64_t unmigrated = RCQueryInteger(db, "SELECT COUNT(*) FROM clip_items WHERE data_hash_v2 IS NULL");
+    if (unmigrated != 0) {
+        fprintf(stderr, "%lld rows were not migrated\n", (long long)unmigrated);
+        return false;
+    }
+    if (mode != RCMigrationModeChunked) {
+        return true;
+    }
+    // Every row up to the checkpoint was visited once, including across the resume.
+    int64_t completed = RCQueryInteger(db, "SELECT completed FROM online_migrations WHERE name = 'clip_items.data_hash_v2'");
+    int64_t migratedRows = RCQueryInteger(db, "SELECT migrated_rows FROM online_migrations WHERE name = 'clip_items.data_hash_v2'");
+    int64_t coveredRows = RCQueryInteger(db,
+        "SELECT COUNT(*) FROM clip_items WHERE id <= (SELECT checkpoint FROM online_migrations WHERE name = 'clip_items.data_hash_v2')");
+    if (completed != 1 || migratedRows != coveredRows) {
+        fprintf(stderr, "checkpoint mismatch: completed=%lld migrated_rows=%lld rows<=checkpoint=%lld\n",
+                (long long)completed, (long long)migratedRows, (long long)coveredRows);
+        return false;
+    }
+    return true;
+}
+
+static int RCRunScenario(RCMigrationMode mode,
+                         long rows,
+                         long batchSize,
+                         long captureIntervalMicroseconds,
+                         long batchIntervalMicroseconds) {
+    char *directory = RCBenchCreateScratchDirectory("rc-online-migration");
+    if (directory == NULL) {
+        return 1;
+    }
+    char *databasePath = RCBenchPathJoin(directory, "revclip.db");
+
+    RCMigrationContext context;
+    memset(&context, 0, sizeof(context));
+    context.captureIntervalMicroseconds = captureIntervalMicroseconds;
+    context.batchIntervalMicroseconds = batchIntervalMicroseconds;
+    atomic_init(&context.stop, false);
+    atomic_init(&context.captures, 0);
+    pthread_mutex_init(&context.writerLock, NULL);
+    RCBenchSamplesInit(&context.captureLatencies, 4096);
+
+    char scheduleSQL[160];
+    snprintf(scheduleSQL, sizeof(scheduleSQL), "INSERT INTO online_migrations (name) VALUES ('%s')", kRCMigrationName);
+    context.writer = RCBenchOpenWriter(databasePath, RCBenchJournalModeWAL);
+    int status = 0;
+    if (context.writer == NULL
+        || !RCBenchCreateBaseSchema(context.writer)
+        || !RCBenchSeedClipItems(context.writer, (int)rows, 1700000000000LL)
+        || !RCBenchExec(context.writer, "ALTER TABLE clip_items ADD COLUMN data_hash_v2 BLOB")
+        || !RCBenchExec(context.writer, scheduleSQL)) {
+        status = 1;
+    }
+
+    pthread_t captureThread;
+    uint64_t elapsed = 0;
+    long batches = 0;
+    if (status == 0) {
+        pthread_create(&captureThread, NULL, RCCaptureMain, &context);
+        // Start once captures are flowing, so a stall shows up as capture latency.
+        while (atomic_load(&context.captures) < 5 && context.captureFailures == 0) {
+            RCBenchSleepMicroseconds(1000);
+        }
+        uint64_t start = RCBenchNowNanoseconds();
+        if (mode == RCMigrationModeOneTransaction) {
+            status = RCMigrateInOneTransaction(&context) ? 0 : 1;
+        } else {
+            // Stop half way (as if the app quit) and resume on a new reader.
+            long firstRun = rows / batchSize / 2 > 0 ? rows / batchSize / 2 : 1;
+            for (int run = 0; run < 2 && status == 0; run++) {
+                sqlite3 *reader = RCBenchOpenReader(databasePath);
+                long committed = reader != NULL ? RCMigrateInBatches(&context, reader, batchSize, run == 0 ? firstRun : 0) : -1;
+                sqlite3_close(reader);
+                if (committed < 0) {
+                    status = 1;
+                }
+                batches += committed;
+            }
+        }
+        elapsed = RCBenchNowNanoseconds() - start;
+        // Keep capturing briefly so the tail after the migration is sampled too.
+        RCBenchSleepMicroseconds(20000);
+        atomic_store(&context.stop, true);
+        pthread_join(captureThread, NULL);
+    }
+
+    if (status == 0 && (context.captureFailures > 0 || !RCVerifyMigration(context.writer, mode))) {
+        fprintf(stderr, "capture failures: %ld\n", context.captureFailures);
+        status = 1;
+    }
+    if (status == 0) {
+        char label[64];
+        const char *modeName = mode == RCMigrationModeOneTransaction ? "one-transaction" : "chunked";
+        snprintf(label, sizeof(label), "%s capture", modeName);
+        RCBenchPrintLatencyRow(label, &context.captureLatencies);
+        if (mode == RCMigrationModeChunked) {
+            printf("%-28s %.1f ms total, %ld batches of %ld, longest writer hold %.2f ms\n", "  migration",
+                   (double)elapsed / 1e6, batches, batchSize, (double)context.longestHoldNanoseconds / 1e6);
+        } else {
+            printf("%-28s %.1f ms total, longest writer hold %.2f ms\n", "  migration",
+                   (double)elapsed / 1e6, (double)context.longestHoldNanoseconds / 1e6);
+        }
+    }
+
+    RCBenchSamplesFree(&context.captureLatencies);
+    sqlite3_close(context.writer);
+    pthread_mutex_destroy(&context.writerLock);
+    RCBenchRemoveScratchDirectory(directory);
+    free(databasePath);
+    free(directory);
+    return status;
+}
+
+int main(int argc, char **argv) {
+    long rows = RCBenchIntegerOption(argc, argv, "--rows", 50000);
+    long batchSize = RCBenchIntegerOption(argc, argv, "--batch", 200);
+    long captureIntervalMicroseconds = RCBenchIntegerOption(argc, argv, "--capture-interval-us", 2000);
+    long batchIntervalMicroseconds = RCBenchIntegerOption(argc, argv, "--batch-interval-us", 0);
+    const char *mode = RCBenchStringOption(argc, argv, "--mode", "both");
+    if (rows < 1) {
+        rows = 1;
+    }
+    if (batchSize < 1) {
+        batchSize = 1;
+    }
+
+    printf("RCOnlineMigrationBenchmark rows=%ld batch=%ld capture-interval=%ldus batch-interval=%ldus sqlite=%s\n",
+           rows, batchSize, captureIntervalMicroseconds, batchIntervalMicroseconds, sqlite3_libversion());
+
+    int status = 0;
+    if (strcmp(mode, "both") == 0 || strcmp(mode, "one-transaction") == 0) {
+        status |= RCRunScenario(RCMigrationModeOneTransaction, rows, batchSize, captureIntervalMicroseconds, 0);
+    }
+    if (strcmp(mode, "both") == 0 || strcmp(mode, "chunked") == 0) {
+        status |= RCRunScenario(RCMigrationModeChunked, rows, batchSize, captureIntervalMicroseconds,
+                                batchIntervalMicroseconds);
+    }
+    return status;
+}
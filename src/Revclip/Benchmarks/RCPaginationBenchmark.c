@@ -0,0 +1,282 @@
+//
+//  RCPaginationBenchmark.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Walks the whole history (--rows, the 9999 cap by default) the ways the
+//  maintenance paths can, and reports per-page latency and peak RSS growth.
+//
+//    full-load : LIMIT count, every row decoded into memory, i.e. the old
+//                clipItemsWithLimit:[clipItemCount] orphan scan.
+//    offset    : fixed-size pages with LIMIT ? OFFSET ?.
+//    keyset    : fixed-size pages after the previous page's (update_time, id),
+//                i.e. -[RCDatabaseManager clipItemsAfterClipItem:limit:].
+//    stream    : one statement stepped row by row, i.e.
+//                -[RCDatabaseManager enumerateClipItemsUsingBlock:].
+//
+//  Every scenario runs in a forked child so that ru_maxrss is per scenario.
+//  update_time is bucketed so pages break inside runs of equal timestamps.
+//
+//  Usage: RCPaginationBenchmark [--rows 9999] [--page-size 100]
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "RCBenchDatabase.h"
+#include "RCBenchSupport.h"
+
+#define RC_CLIP_COLUMNS "id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code"
+
+// Keep in sync with kRCSelectRecentClipItemsSQL / kRCSelectClipItemsPageSQL in RCDatabaseManager.m.
+static const char *const kRCSelectRecentClipItemsSQL =
+    "SELECT " RC_CLIP_COLUMNS " FROM clip_items ORDER BY update_time DESC, id DESC LIMIT ?";
+static const char *const kRCSelectClipItemsPageSQL =
+    "SELECT " RC_CLIP_COLUMNS " FROM clip_items WHERE (update_time, id) < (?, ?) "
+    "ORDER BY update_time DESC, id DESC LIMIT ?";
+static const char *const kRCSelectClipItemsOffsetSQL =
+    "SELECT " RC_CLIP_COLUMNS " FROM clip_items ORDER BY update_time DESC, id DESC LIMIT ? OFFSET ?";
+
+typedef enum {
+    RCScanFullLoad,
+    RCScanOffset,
+    RCScanKeyset,
+    RCScanStream,
+} RCScanMode;
+
+// Stand-in for a decoded RCClipItem.
+typedef struct {
+    int64_t itemId;
+    int64_t updateTime;
+    char *dataPath;
+    char *title;
+    char *primaryType;
+    char *thumbnailPath;
+    uint8_t dataHash[32];
+} RCRow;
+
+typedef struct {
+    long visited;
+    int64_t idSum;
+    int64_t lastUpdateTime;
+    int64_t lastItemId;
+    bool ordered;
+} RCScanTally;
+
+static char *RCCopyColumnText(sqlite3_stmt *statement, int column) {
+    const unsigned char *text = sqlite3_column_text(statement, column);
+    return text != NULL ? strdup((const char *)text) : NULL;
+}
+
+static void RCRowDecode(sqlite3_stmt *statement, RCRow *row) {
+    row->itemId = sqlite3_column_int64(statement, 0);
+    row->dataPath = RCCopyColumnText(statement, 1);
+    row->title = RCCopyColumnText(statement, 2);
+    const void *hash = sqlite3_column_blob(statement, 3);
+    if (hash != NULL && sqlite3_column_bytes(statement, 3) == (int)sizeof(row->dataHash)) {
+        memcpy(row->dataHash, hash, sizeof(row->dataHash));
+    }
+    row->primaryType = RCCopyColumnText(statement, 4);
+    row->updateTime = sqlite3_column_int64(statement, 5);
+    row->thumbnailPath = RCCopyColumnText(statement, 6);
+}
+
+static void RCRowFree(RCRow *row) {
+    free(row->dataPath);
+    free(row->title);
+    free(row->primaryType);
+    free(row->thumbnailPath);
+}
+
+static void RCTallyRow(RCScanTally *tally, const RCRow *row) {
+    if (tally->visited > 0
+        && (row->updateTime > tally->lastUpdateTime
+            || (row->updateTime == tally->lastUpdateTime && row->itemId >= tally->lastItemId))) {
+        tally->ordered = false;
+    }
+    tally->visited++;
+    tally->idSum += row->itemId;
+    tally->lastUpdateTime = row->updateTime;
+    tally->lastItemId = row->itemId;
+}
+
+// Runs one page (or the whole scan for full-load / stream) and tallies it.
+// Returns the number of rows, or -1 on error.
+static long RCStepRows(sqlite3 *db, sqlite3_stmt *statement, bool retainRows, RCScanTally *tally) {
+    size_t count = 0;
+    size_t capacity = retainRows ? 256 : 0;
+    RCRow *rows = retainRows ? malloc(capacity * sizeof(RCRow)) : NULL;
+    int rc;
+    while ((rc = sqlite3_step(statement)) == SQLITE_ROW) {
+        RCRow row = { 0 };
+        RCRowDecode(statement, &row);
+        RCTallyRow(tally, &row);
+        if (retainRows) {
+            if (count == capacity) {
+                capacity *= 2;
+                rows = realloc(rows, capacity * sizeof(RCRow));
+            }
+            rows[count] = row;
+        } else {
+            RCRowFree(&row);
+        }
+        count++;
+    }
+    sqlite3_reset(statement);
+
+    for (size_t index = 0; retainRows && index < count; index++) {
+        RCRowFree(&rows[index]);
+    }
+    free(rows);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "scan failed: %s\n", sqlite3_errmsg(db));
+        return -1;
+    }
+    return (long)count;
+}
+
+static long RCMaxRSSKilobytes(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+static int RCRunScan(const char *databasePath, RCScanMode mode, long rows, long pageSize, int64_t expectedIdSum) {
+    static const char *const labels[] = { "full-load", "offset", "keyset", "stream" };
+    sqlite3 *db = RCBenchOpenReader(databasePath);
+    if (db == NULL) {
+        return 1;
+    }
+    const char *sql = mode == RCScanKeyset ? kRCSelectClipItemsPageSQL
+                    : mode == RCScanOffset ? kRCSelectClipItemsOffsetSQL
+                    : kRCSelectRecentClipItemsSQL;
+    sqlite3_stmt *statement = NULL;
+    if (sqlite3_prepare_v2(db, sql, -1, &statement, NULL) != SQLITE_OK) {
+        fprintf(stderr, "prepare failed: %s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+
+    RCBenchSamples pages;
+    RCBenchSamplesInit(&pages, (size_t)(rows / pageSize + 2));
+    RCScanTally tally = { .ordered = true };
+    long baselineKilobytes = RCMaxRSSKilobytes();
+    uint64_t start = RCBenchNowNanoseconds();
+    int status = 0;
+
+    if (mode == RCScanFullLoad || mode == RCScanStream) {
+        sqlite3_bind_int64(statement, 1, mode == RCScanFullLoad ? rows : -1);
+        status = RCStepRows(db, statement, mode == RCScanFullLoad, &tally) < 0;
+    } else {
+        long pageRows;
+        do {
+            uint64_t pageStart = RCBenchNowNanoseconds();
+            if (mode == RCScanOffset) {
+                sqlite3_bind_int64(statement, 1, pageSize);
+                sqlite3_bind_int64(statement, 2, tally.visited);
+            } else if (tally.visited == 0) {
+                sqlite3_bind_int64(statement, 1, INT64_MAX);
+                sqlite3_bind_int64(statement, 2, INT64_MAX);
+                sqlite3_bind_int64(statement, 3, pageSize);
+            } else {
+                sqlite3_bind_int64(statement, 1, tally.lastUpdateTime);
+                sqlite3_bind_int64(statement, 2, tally.lastItemId);
+                sqlite3_bind_int64(statement, 3, pageSize);
+            }
+            pageRows = RCStepRows(db, statement, true, &tally);
+            RCBenchSamplesAppend(&pages, RCBenchNowNanoseconds() - pageStart);
+        } while (pageRows == pageSize);
+        status = pageRows < 0;
+    }
+
+    double totalMs = (double)(RCBenchNowNanoseconds() - start) / 1e6;
+    long peakGrowthKilobytes = RCMaxRSSKilobytes() - baselineKilobytes;
+    if (status == 0) {
+        char label[64];
+        snprintf(label, sizeof(label), "%s total", labels[mode]);
+        printf("%-28s %8.2f ms  peak RSS +%ld KiB  rows=%ld\n", label, totalMs, peakGrowthKilobytes, tally.visited);
+        if (pages.count > 0) {
+            // The deepest page is the one OFFSET pays for (read it before the samples get sorted).
+            uint64_t lastPage = pages.values[pages.count - 1];
+            snprintf(label, sizeof(label), "%s page", labels[mode]);
+            RCBenchPrintLatencyRow(label, &pages);
+            printf("%-28s %8.1f us\n", "  last page", (double)lastPage / 1e3);
+        }
+        if (tally.visited != rows || tally.idSum != expectedIdSum || !tally.ordered) {
+            fprintf(stderr, "%s visited %ld rows (expected %ld), order %s\n",
+                    labels[mode], tally.visited, rows, tally.ordered ? "ok" : "broken");
+            status = 1;
+        }
+    }
+
+    RCBenchSamplesFree(&pages);
+    sqlite3_finalize(statement);
+    sqlite3_close(db);
+    return status;
+}
+
+int main(int argc, char **argv) {
+    long rows = RCBenchIntegerOption(argc, argv, "--rows", 9999);
+    long pageSize = RCBenchIntegerOption(argc, argv, "--page-size", 100);
+    if (rows < 1) {
+        rows = 1;
+    }
+    if (pageSize < 1) {
+        pageSize = 1;
+    }
+
+    printf("RCPaginationBenchmark rows=%ld page-size=%ld sqlite=%s\n", rows, pageSize, sqlite3_libversion());
+
+    char *directory = RCBenchCreateScratchDirectory("rc-pagination");
+    if (directory == NULL) {
+        return 1;
+    }
+    char *databasePath = RCBenchPathJoin(directory, "revclip.db");
+    int status = 1;
+
+    sqlite3 *writer = RCBenchOpenWriter(databasePath, RCBenchJournalModeWAL);
+    if (writer == NULL
+        || !RCBenchCreateBaseSchema(writer)
+        || !RCBenchSeedClipItems(writer, (int)rows, 1700000000000LL)
+        || !RCBenchExec(writer, "UPDATE clip_items SET update_time = update_time - update_time % 7")) {
+        sqlite3_close(writer);
+        goto cleanup;
+    }
+    sqlite3_close(writer);
+
+    int64_t expectedIdSum = (int64_t)rows * (rows + 1) / 2;
+    status = 0;
+    for (RCScanMode mode = RCScanFullLoad; mode <= RCScanStream; mode++) {
+        fflush(stdout);
+        pid_t child = fork();
+        if (child < 0) {
+            perror("fork");
+            status = 1;
+            break;
+        }
+        if (child == 0) {
+            int scanStatus = RCRunScan(databasePath, mode, rows, pageSize, expectedIdSum);
+            fflush(stdout);
+            _exit(scanStatus);
+        }
+        int childStatus = 0;
+        if (waitpid(child, &childStatus, 0) < 0 || !WIFEXITED(childStatus) || WEXITSTATUS(childStatus) != 0) {
+            status = 1;
+        }
+    }
+
+cleanup:
+    RCBenchRemoveScratchDirectory(directory);
+    free(databasePath);
+    free(directory);
+    return status;
+}
@@ -0,0 +1,256 @@
+//
+//  RCPollSchedulerTests.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Unit tests for the adaptive clipboard polling policy
+//  (Revclip/Core/RCPollScheduler), driven by a simulated clock: back-off
+//  while idle, reset on change and on activity events, the rate limit on
+//  activity storms, and a simulated session (idle hour, copy bursts)
+//  compared with the former fixed 0.5 s timer.
+//
+//  Usage: RCPollSchedulerTests
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "RCPollScheduler.h"
+#include "RCTestSupport.h"
+
+#define RC_MS(milliseconds) ((uint64_t)(milliseconds) * 1000000ULL)
+#define RC_FIXED_INTERVAL RC_MS(500)
+
+typedef struct {
+    uint64_t polls;
+    uint64_t changedPolls;
+    uint64_t maxLatencyNanoseconds;
+} RCPollSimulation;
+
+/// Polls from `start` until `end` with the scheduler (or every
+/// RC_FIXED_INTERVAL when `scheduler` is NULL) while the pasteboard changes at
+/// the sorted `copies` times. Latency is the time from a copy to the poll
+/// that sees it.
+static void RCSimulate(RCPollScheduler *scheduler,
+                       uint64_t start,
+                       uint64_t end,
+                       const uint64_t *copies,
+                       size_t copyCount,
+                       RCPollSimulation *result) {
+    size_t nextCopy = 0;
+    uint64_t nextPoll = scheduler != NULL ? RCPollSchedulerNextPollNanoseconds(scheduler) : start + RC_FIXED_INTERVAL;
+    while (nextPoll <= end) {
+        uint64_t now = nextPoll;
+        bool changed = false;
+        while (nextCopy < copyCount && copies[nextCopy] <= now) {
+            uint64_t latency = now - copies[nextCopy];
+            if (latency > result->maxLatencyNanoseconds) {
+                result->maxLatencyNanoseconds = latency;
+            }
+            changed = true;
+            nextCopy++;
+        }
+        result->polls++;
+        result->changedPolls += changed ? 1 : 0;
+        nextPoll = scheduler != NULL ? RCPollSchedulerRecordPoll(scheduler, now, changed) : now + RC_FIXED_INTERVAL;
+    }
+}
+
+static void TestBacksOffWhileIdle(void) {
+    RCPollSchedulerConfiguration configuration = RCPollSchedulerDefaultConfiguration();
+    RCPollScheduler scheduler;
+    RCPollSchedulerInit(&scheduler, &configuration, 0);
+    RC_TEST_ASSERT(RCPollSchedulerIsActive(&scheduler));
+    RC_TEST_ASSERT_EQUAL(RC_MS(100), RCPollSchedulerNextPollNanoseconds(&scheduler));
+
+    // Minimum interval for the whole active window...
+    uint64_t now = RCPollSchedulerNextPollNanoseconds(&scheduler);
+    while (now < configuration.activeWindowNanoseconds) {
+        uint64_t next = RCPollSchedulerRecordPoll(&scheduler, now, false);
+        RC_TEST_ASSERT_EQUAL(RC_MS(100), next - now);
+        now = next;
+    }
+
+    // ...then doubling up to the maximum, where it stays.
+    const uint64_t expected[] = { RC_MS(200), RC_MS(400), RC_MS(800), RC_MS(1600), RC_MS(3200), RC_MS(3200) };
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        uint64_t next = RCPollSchedulerRecordPoll(&scheduler, now, false);
+        RC_TEST_ASSERT_EQUAL(expected[i], next - now);
+        RC_TEST_ASSERT_EQUAL(expected[i] / 10, RCPollSchedulerLeewayNanoseconds(&scheduler));
+        now = next;
+    }
+    RC_TEST_ASSERT(!RCPollSchedulerIsActive(&scheduler));
+
+    // A maximum that is not a power-of-two multiple of the minimum is still reached exactly.
+    configuration.maximumIntervalNanoseconds = RC_MS(3000);
+    RCPollSchedulerInit(&scheduler, &configuration, 0);
+    now = configuration.activeWindowNanoseconds;
+    for (int i = 0; i < 10; i++) {
+        now = RCPollSchedulerRecordPoll(&scheduler, now, false);
+    }
+    RC_TEST_ASSERT_EQUAL(RC_MS(3000), RCPollSchedulerIntervalNanoseconds(&scheduler));
+}
+
+static void TestChangeResetsToMinimum(void) {
+    RCPollSchedulerConfiguration configuration = RCPollSchedulerDefaultConfiguration();
+    RCPollScheduler scheduler;
+    RCPollSchedulerInit(&scheduler, &configuration, 0);
+    uint64_t now = configuration.activeWindowNanoseconds;
+    for (int i = 0; i < 10; i++) {
+        now = RCPollSchedulerRecordPoll(&scheduler, now, false);
+    }
+    RC_TEST_ASSERT_EQUAL(RC_MS(3200), RCPollSchedulerIntervalNanoseconds(&scheduler));
+
+    uint64_t next = RCPollSchedulerRecordPoll(&scheduler, now, true);
+    RC_TEST_ASSERT_EQUAL(RC_MS(100), next - now);
+    RC_TEST_ASSERT(RCPollSchedulerIsActive(&scheduler));
+
+    // The active window restarts at the change, not at launch.
+    uint64_t changeTime = now;
+    now = next;
+    while (now - changeTime < configuration.activeWindowNanoseconds) {
+        next = RCPollSchedulerRecordPoll(&scheduler, now, false);
+        RC_TEST_ASSERT_EQUAL(RC_MS(100), next - now);
+        now = next;
+    }
+    RC_TEST_ASSERT_EQUAL(RC_MS(200), RCPollSchedulerRecordPoll(&scheduler, now, false) - now);
+}
+
+static void TestActivityPullsNextPollIn(void) {
+    RCPollSchedulerConfiguration configuration = RCPollSchedulerDefaultConfiguration();
+    RCPollScheduler scheduler;
+    RCPollSchedulerInit(&scheduler, &configuration, 0);
+    uint64_t now = configuration.activeWindowNanoseconds;
+    for (int i = 0; i < 10; i++) {
+        now = RCPollSchedulerRecordPoll(&scheduler, now, false);
+    }
+    uint64_t lastPoll = now - RC_MS(3200);
+
+    // Idle at 3.2 s; an app activation 1 s after the last poll polls at once.
+    uint64_t activation = lastPoll + RC_MS(1000);
+    RC_TEST_ASSERT_EQUAL(now, RCPollSchedulerNextPollNanoseconds(&scheduler));
+    RC_TEST_ASSERT(RCPollSchedulerNoteActivity(&scheduler, activation));
+    RC_TEST_ASSERT_EQUAL(activation, RCPollSchedulerNextPollNanoseconds(&scheduler));
+    RC_TEST_ASSERT(RCPollSchedulerIsActive(&scheduler));
+
+    // An event that cannot move the poll any earlier asks for no re-arm.
+    RC_TEST_ASSERT(!RCPollSchedulerNoteActivity(&scheduler, activation));
+
+    // After that poll, a burst of events (hotkey right after the activation)
+    // waits for the minimum interval instead of polling once per event.
+    uint64_t next = RCPollSchedulerRecordPoll(&scheduler, activation, false);
+    RC_TEST_ASSERT_EQUAL(activation + RC_MS(100), next);
+    RC_TEST_ASSERT(!RCPollSchedulerNoteActivity(&scheduler, activation + RC_MS(10)));
+    RC_TEST_ASSERT_EQUAL(activation + RC_MS(100), RCPollSchedulerNextPollNanoseconds(&scheduler));
+
+    // Activity keeps polling at the minimum past the previous window.
+    now = next;
+    for (int i = 0; i < 30; i++) {
+        if (i == 15) {
+            RCPollSchedulerNoteActivity(&scheduler, now);
+        }
+        next = RCPollSchedulerRecordPoll(&scheduler, now, false);
+        RC_TEST_ASSERT_EQUAL(RC_MS(100), next - now);
+        now = next;
+    }
+}
+
+static void TestDegenerateConfiguration(void) {
+    RCPollSchedulerConfiguration configuration = { 0, 0, 0 };
+    RCPollScheduler scheduler;
+    RCPollSchedulerInit(&scheduler, &configuration, 5);
+    RC_TEST_ASSERT_EQUAL(6, RCPollSchedulerNextPollNanoseconds(&scheduler));
+    RC_TEST_ASSERT_EQUAL(7, RCPollSchedulerRecordPoll(&scheduler, 6, false));
+    RC_TEST_ASSERT_EQUAL(1, RCPollSchedulerIntervalNanoseconds(&scheduler));
+}
+
+static void TestSimulatedSession(void) {
+    RCPollSchedulerConfiguration configuration = RCPollSchedulerDefaultConfiguration();
+
+    // An idle hour.
+    RCPollScheduler scheduler;
+    RCPollSchedulerInit(&scheduler, &configuration, 0);
+    RCPollSimulation adaptiveIdle = { 0 };
+    RCPollSimulation fixedIdle = { 0 };
+    RCSimulate(&scheduler, 0, RC_MS(3600000), NULL, 0, &adaptiveIdle);
+    RCSimulate(NULL, 0, RC_MS(3600000), NULL, 0, &fixedIdle);
+    printf("     idle hour: %llu polls (fixed 0.5 s: %llu)\n",
+           (unsigned long long)adaptiveIdle.polls, (unsigned long long)fixedIdle.polls);
+    RC_TEST_ASSERT_EQUAL(7200, fixedIdle.polls);
+    RC_TEST_ASSERT(adaptiveIdle.polls < 3600000 / 3200 + 40);
+
+    // Bursts of 20 copies 150-650 ms apart after idle gaps of 10-120 s.
+    enum { kBursts = 50, kCopiesPerBurst = 20 };
+    uint64_t *copies = malloc(sizeof(uint64_t) * kBursts * kCopiesPerBurst);
+    RC_TEST_ASSERT(copies != NULL);
+    uint64_t state = 0x5EEDull;
+    uint64_t time = 0;
+    size_t count = 0;
+    for (int burst = 0; burst < kBursts; burst++) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        time += RC_MS(10000) + RC_MS((state >> 33) % 110000);
+        for (int copy = 0; copy < kCopiesPerBurst; copy++) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            time += RC_MS(150) + RC_MS((state >> 33) % 500);
+            copies[count++] = time;
+        }
+    }
+    uint64_t end = time + RC_MS(10000);
+
+    RCPollSimulation adaptive = { 0 };
+    RCPollSimulation fixed = { 0 };
+    RCPollSchedulerInit(&scheduler, &configuration, 0);
+    RCSimulate(&scheduler, 0, end, copies, count, &adaptive);
+    RCSimulate(NULL, 0, end, copies, count, &fixed);
+    free(copies);
+
+    printf("     bursts: %llu polls over %.0f s (fixed 0.5 s: %llu)\n",
+           (unsigned long long)adaptive.polls, (double)end / 1e9, (unsigned long long)fixed.polls);
+    printf("     bursts: %llu / %zu copies seen separately (fixed 0.5 s: %llu)\n",
+           (unsigned long long)adaptive.changedPolls, count, (unsigned long long)fixed.changedPolls);
+    RC_TEST_ASSERT(adaptive.polls < fixed.polls);
+    // Copies that land before the first poll of a burst (still at an idle
+    // interval) merge; once it has seen a change, polling at 100 ms separates
+    // copies 150 ms apart, which a fixed 0.5 s timer does not.
+    RC_TEST_ASSERT(adaptive.maxLatencyNanoseconds <= configuration.maximumIntervalNanoseconds);
+    RC_TEST_ASSERT(adaptive.changedPolls > fixed.changedPolls);
+}
+
+static void TestBurstLatencyAfterFirstCopy(void) {
+    RCPollSchedulerConfiguration configuration = RCPollSchedulerDefaultConfiguration();
+    RCPollScheduler scheduler;
+    RCPollSchedulerInit(&scheduler, &configuration, 0);
+
+    // First copy after a minute of idle, then one every 330 ms.
+    uint64_t copies[16];
+    copies[0] = RC_MS(60037);
+    for (size_t i = 1; i < 16; i++) {
+        copies[i] = copies[i - 1] + RC_MS(330);
+    }
+    RCPollSimulation first = { 0 };
+    RCSimulate(&scheduler, 0, copies[0] + RC_MS(4000), copies, 1, &first);
+    RC_TEST_ASSERT_EQUAL(1, first.changedPolls);
+    RC_TEST_ASSERT(first.maxLatencyNanoseconds <= configuration.maximumIntervalNanoseconds);
+
+    // Once the first copy has been seen, the rest of the burst is caught
+    // within the minimum interval.
+    RCPollSchedulerInit(&scheduler, &configuration, 0);
+    RCPollSchedulerRecordPoll(&scheduler, copies[0], true);
+    RCPollSimulation follow = { 0 };
+    RCSimulate(&scheduler, copies[0], copies[15] + RC_MS(1000), copies + 1, 15, &follow);
+    printf("     burst follow-up copies: worst latency %.0f ms (fixed 0.5 s: up to 500 ms)\n",
+           (double)follow.maxLatencyNanoseconds / 1e6);
+    RC_TEST_ASSERT(follow.maxLatencyNanoseconds <= configuration.minimumIntervalNanoseconds);
+    RC_TEST_ASSERT_EQUAL(15, follow.changedPolls);
+}
+
+int main(void) {
+    RC_TEST_RUN(TestBacksOffWhileIdle);
+    RC_TEST_RUN(TestChangeResetsToMinimum);
+    RC_TEST_RUN(TestActivityPullsNextPollIn);
+    RC_TEST_RUN(TestDegenerateConfiguration);
+    RC_TEST_RUN(TestSimulatedSession);
+    RC_TEST_RUN(TestBurstLatencyAfterFirstCopy);
+    return RC_TEST_FINISH();
+}
@@ -0,0 +1,269 @@
+//
+//  RCQueryMetricsBenchmark.c
+//  Revclip Benchmarks
+//
+//  Measures what the always-on statement histograms (Revclip/Core/RCQueryMetrics.c,
+//  attached to every RCDatabaseManager connection) add to the hot statements:
+//  the dedup point lookup and an autocommit insert + delete. Each workload runs
+//  with and without the trace, then the collected histograms are printed and
+//  their sample counts checked against the number of statements executed.
+//
+//  Usage: RCQueryMetricsBenchmark [--rows 9999] [--lookups 20000] [--writes 2000] [--threads 2]
+//
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCBenchDatabase.h"
+#include "RCBenchSupport.h"
+#include "RCQueryMetrics.h"
+
+// Keep in sync with kRCSelectClipItemByDataHashSQL / kRCInsertClipItemSQL /
+// kRCDeleteClipItemByDataHashSQL in RCDatabaseManager.m.
+static const char *const kRCSelectClipItemByDataHashSQL = "SELECT id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code FROM clip_items WHERE data_hash = ? LIMIT 1";
+static const char *const kRCInsertClipItemSQL = "INSERT INTO clip_items (data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code, data_size) VALUES (?, ?, ?, ?, ?, ?, ?, ?)";
+static const char *const kRCDeleteClipItemByDataHashSQL = "DELETE FROM clip_items WHERE data_hash = ?";
+// Not registered: lands in the "other" bucket.
+static const char *const kRCCountClipItemsSQL = "SELECT COUNT(*) FROM clip_items";
+
+// Returns ns per lookup, or -1 on failure.
+static double RCMeasureLookups(sqlite3 *db, long rows, long lookups) {
+    sqlite3_stmt *statement = NULL;
+    if (sqlite3_prepare_v2(db, kRCSelectClipItemByDataHashSQL, -1, &statement, NULL) != SQLITE_OK) {
+        fprintf(stderr, "lookup prepare failed: %s\n", sqlite3_errmsg(db));
+        return -1;
+    }
+    uint64_t start = RCBenchNowNanoseconds();
+    long found = 0;
+    for (long iteration = 0; iteration < lookups; iteration++) {
+        uint8_t digest[32];
+        RCBenchDigestForSeed((uint64_t)((iteration * 7919) % rows), digest);
+        sqlite3_bind_blob(statement, 1, digest, sizeof(digest), SQLITE_STATIC);
+        while (sqlite3_step(statement) == SQLITE_ROW) {
+            found++;
+        }
+        sqlite3_reset(statement);
+    }
+    uint64_t elapsed = RCBenchNowNanoseconds() - start;
+    sqlite3_finalize(statement);
+    if (found != lookups) {
+        fprintf(stderr, "lookup found %ld of %ld rows\n", found, lookups);
+        return -1;
+    }
+    return (double)elapsed / (double)lookups;
+}
+
+// Inserts then deletes `writes` rows, one autocommit statement each. Returns
+// ns per insert + delete pair, or -1 on failure.
+static double RCMeasureWrites(sqlite3 *db, long writes, uint64_t seedBase) {
+    sqlite3_stmt *insert = NULL;
+    sqlite3_stmt *delete = NULL;
+    if (sqlite3_prepare_v2(db, kRCInsertClipItemSQL, -1, &insert, NULL) != SQLITE_OK
+        || sqlite3_prepare_v2(db, kRCDeleteClipItemByDataHashSQL, -1, &delete, NULL) != SQLITE_OK) {
+        fprintf(stderr, "write prepare failed: %s\n", sqlite3_errmsg(db));
+        sqlite3_finalize(insert);
+        return -1;
+    }
+
+    uint64_t start = RCBenchNowNanoseconds();
+    bool failed = false;
+    for (long index = 0; index < writes && !failed; index++) {
+        uint8_t digest[32];
+        RCBenchDigestForSeed(seedBase + (uint64_t)index, digest);
+        sqlite3_bind_text(insert, 1, "w.rcclip", -1, SQLITE_STATIC);
+        sqlite3_bind_text(insert, 2, "w", -1, SQLITE_STATIC);
+        sqlite3_bind_blob(insert, 3, digest, sizeof(digest), SQLITE_STATIC);
+        sqlite3_bind_text(insert, 4, "public.utf8-plain-text", -1, SQLITE_STATIC);
+        sqlite3_bind_int64(insert, 5, 1800000000000LL + index);
+        sqlite3_bind_text(insert, 6, "", -1, SQLITE_STATIC);
+        sqlite3_bind_int(insert, 7, 0);
+        sqlite3_bind_int64(insert, 8, 512);
+        failed = sqlite3_step(insert) != SQLITE_DONE;
+        sqlite3_reset(insert);
+
+        sqlite3_bind_blob(delete, 1, digest, sizeof(digest), SQLITE_STATIC);
+        failed = failed || sqlite3_step(delete) != SQLITE_DONE;
+        sqlite3_reset(delete);
+    }
+    uint64_t elapsed = RCBenchNowNanoseconds() - start;
+    if (failed) {
+        fprintf(stderr, "write failed: %s\n", sqlite3_errmsg(db));
+    }
+    sqlite3_finalize(insert);
+    sqlite3_finalize(delete);
+    return failed ? -1 : (double)elapsed / (double)writes;
+}
+
+static void RCPrintSnapshot(const char *label, const RCLatencySnapshot *snapshot) {
+    printf("  %-34s n=%-7llu mean=%8.1fus p50<=%8.1fus p99<=%8.1fus max=%8.1fus\n",
+           label,
+           (unsigned long long)snapshot->count,
+           snapshot->count > 0 ? (double)snapshot->totalNanoseconds / 1e3 / (double)snapshot->count : 0.0,
+           (double)RCLatencySnapshotPercentileNanoseconds(snapshot, 0.50) / 1e3,
+           (double)RCLatencySnapshotPercentileNanoseconds(snapshot, 0.99) / 1e3,
+           (double)snapshot->maxNanoseconds / 1e3);
+}
+
+static uint64_t RCStatementSampleCount(const RCQueryMetrics *metrics, int index) {
+    RCLatencySnapshot snapshot;
+    RCQueryMetricsStatementSnapshot(metrics, (size_t)index, &snapshot);
+    return snapshot.count;
+}
+
+typedef struct {
+    RCQueryMetrics *metrics;
+    int operation;
+    long iterations;
+} RCRecorderContext;
+
+static void *RCRecorderThread(void *argument) {
+    RCRecorderContext *context = argument;
+    for (long iteration = 0; iteration < context->iterations; iteration++) {
+        RCQueryMetricsRecordOperation(context->metrics, context->operation,
+                                      (uint64_t)iteration % 5000, (uint64_t)iteration * 3);
+    }
+    return NULL;
+}
+
+// Concurrent recorders must not lose samples and recording must stay cheap.
+static bool RCMeasureConcurrentRecording(RCQueryMetrics *metrics, int operation, long threads, long iterations) {
+    pthread_t *workers = calloc((size_t)threads, sizeof(pthread_t));
+    RCRecorderContext context = { metrics, operation, iterations };
+    uint64_t start = RCBenchNowNanoseconds();
+    long started = 0;
+    for (; started < threads; started++) {
+        if (pthread_create(&workers[started], NULL, RCRecorderThread, &context) != 0) {
+            break;
+        }
+    }
+    for (long index = 0; index < started; index++) {
+        pthread_join(workers[index], NULL);
+    }
+    uint64_t elapsed = RCBenchNowNanoseconds() - start;
+    free(workers);
+
+    RCLatencySnapshot queueWait;
+    RCLatencySnapshot execution;
+    RCQueryMetricsOperationSnapshot(metrics, (size_t)operation, &queueWait, &execution);
+    uint64_t expected = (uint64_t)started * (uint64_t)iterations;
+    printf("%-28s %8.1f ns/sample (%ld threads)\n", "record operation",
+           (double)elapsed / (double)(expected > 0 ? expected : 1), started);
+    if (started != threads || queueWait.count != expected || execution.count != expected) {
+        fprintf(stderr, "recorded %llu/%llu samples, expected %llu\n",
+                (unsigned long long)queueWait.count, (unsigned long long)execution.count,
+                (unsigned long long)expected);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    long rows = RCBenchIntegerOption(argc, argv, "--rows", 9999);
+    long lookups = RCBenchIntegerOption(argc, argv, "--lookups", 20000);
+    long writes = RCBenchIntegerOption(argc, argv, "--writes", 2000);
+    long threads = RCBenchIntegerOption(argc, argv, "--threads", 2);
+    if (rows < 1) {
+        rows = 1;
+    }
+    if (lookups < 1) {
+        lookups = 1;
+    }
+    if (writes < 1) {
+        writes = 1;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    printf("RCQueryMetricsBenchmark rows=%ld lookups=%ld writes=%ld threads=%ld sqlite=%s\n",
+           rows, lookups, writes, threads, sqlite3_libversion());
+
+    char *directory = RCBenchCreateScratchDirectory("rc-query-metrics");
+    if (directory == NULL) {
+        return 1;
+    }
+    char *databasePath = RCBenchPathJoin(directory, "revclip.db");
+    sqlite3 *writer = RCBenchOpenWriter(databasePath, RCBenchJournalModeWAL);
+    sqlite3 *reader = NULL;
+    RCQueryMetrics *metrics = RCQueryMetricsCreate();
+    int status = 1;
+    if (metrics == NULL
+        || writer == NULL
+        || !RCBenchCreateBaseSchema(writer)
+        || !RCBenchSeedClipItems(writer, (int)rows, 1700000000000LL)) {
+        goto cleanup;
+    }
+    reader = RCBenchOpenReader(databasePath);
+    if (reader == NULL) {
+        goto cleanup;
+    }
+
+    int lookupIndex = RCQueryMetricsRegisterStatement(metrics, "selectClipItemByDataHash", kRCSelectClipItemByDataHashSQL);
+    int insertIndex = RCQueryMetricsRegisterStatement(metrics, "insertClipItem", kRCInsertClipItemSQL);
+    int deleteIndex = RCQueryMetricsRegisterStatement(metrics, "deleteClipItemByDataHash", kRCDeleteClipItemByDataHashSQL);
+    int operation = RCQueryMetricsRegisterOperation(metrics, "insert");
+    if (lookupIndex < 0 || insertIndex < 0 || deleteIndex < 0 || operation < 0) {
+        fprintf(stderr, "registration failed\n");
+        goto cleanup;
+    }
+
+    // Warm the page cache so both passes read the same pages.
+    double lookupPlain = RCMeasureLookups(reader, rows, lookups);
+    lookupPlain = RCMeasureLookups(reader, rows, lookups);
+    double writePlain = RCMeasureWrites(writer, writes, 0xFFFF0000u);
+    writePlain = RCMeasureWrites(writer, writes, 0xFFFD0000u);
+    if (lookupPlain < 0 || writePlain < 0
+        || !RCQueryMetricsAttachConnection(metrics, reader)
+        || !RCQueryMetricsAttachConnection(metrics, writer)) {
+        goto cleanup;
+    }
+    double lookupTraced = RCMeasureLookups(reader, rows, lookups);
+    double writeTraced = RCMeasureWrites(writer, writes, 0xFFFE0000u);
+    if (lookupTraced < 0 || writeTraced < 0 || !RCBenchExec(reader, kRCCountClipItemsSQL)) {
+        goto cleanup;
+    }
+
+    printf("%-28s %8.2f us/stmt traced %8.2f us/stmt (%+.2f us)\n", "dedup lookup",
+           lookupPlain / 1e3, lookupTraced / 1e3, (lookupTraced - lookupPlain) / 1e3);
+    printf("%-28s %8.2f us/pair traced %8.2f us/pair (%+.2f us)\n", "insert+delete",
+           writePlain / 1e3, writeTraced / 1e3, (writeTraced - writePlain) / 1e3);
+
+    printf("statement histograms:\n");
+    size_t statementCount = RCQueryMetricsStatementCount(metrics);
+    for (size_t index = 0; index < statementCount; index++) {
+        RCLatencySnapshot snapshot;
+        RCQueryMetricsStatementSnapshot(metrics, index, &snapshot);
+        RCPrintSnapshot(RCQueryMetricsStatementName(metrics, index), &snapshot);
+    }
+
+    // Trigger bodies must not be counted as statements of their own. Unregistered
+    // SQL goes to "other": the COUNT(*) plus the shadow-table statements FTS5
+    // runs for the clip_search delete trigger.
+    status = 0;
+    if (RCStatementSampleCount(metrics, lookupIndex) != (uint64_t)lookups
+        || RCStatementSampleCount(metrics, insertIndex) != (uint64_t)writes
+        || RCStatementSampleCount(metrics, deleteIndex) != (uint64_t)writes
+        || RCStatementSampleCount(metrics, 0) < 1) {
+        fprintf(stderr, "statement sample counts do not match executed statements\n");
+        status = 1;
+    }
+    if (status == 0 && !RCMeasureConcurrentRecording(metrics, operation, threads, lookups)) {
+        status = 1;
+    }
+    RCQueryMetricsReset(metrics);
+    if (status == 0 && RCStatementSampleCount(metrics, lookupIndex) != 0) {
+        fprintf(stderr, "reset left samples behind\n");
+        status = 1;
+    }
+
+cleanup:
+    sqlite3_close(reader);
+    sqlite3_close(writer);
+    RCQueryMetricsDestroy(metrics);
+    RCBenchRemoveScratchDirectory(directory);
+    free(databasePath);
+    free(directory);
+    return status;
+}
@@ -0,0 +1,230 @@
+//
+//  RCReadPoolBenchmark.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Measures menu-rebuild read latency (the appendClipHistorySectionToMenu:
+//  query) while a writer inserts clips continuously.
+//
+//    serialized : one rollback-journal connection behind a mutex, i.e. the
+//                 single FMDatabaseQueue that RCDatabaseManager used before.
+//    wal-pool   : one WAL writer connection plus read-only reader connections,
+//                 i.e. the current databaseQueue + readConnectionPool layout.
+//
+//  Usage: RCReadPoolBenchmark [--rows 9999] [--seconds 3] [--readers 2]
+//                             [--write-interval-us 2000] [--mode both|serialized|wal-pool]
+//
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCBenchDatabase.h"
+#include "RCBenchSupport.h"
+
+#define RC_MAX_READERS 16
+
+static const char *const kRCMenuQuery =
+    "SELECT id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code "
+    "FROM clip_items ORDER BY update_time DESC LIMIT 30";
+
+typedef struct {
+    const char *databasePath;
+    bool serialized;
+    sqlite3 *sharedConnection;          // serialized mode only
+    pthread_mutex_t sharedConnectionLock;
+    atomic_bool stop;
+    long writeIntervalMicroseconds;
+    int64_t nextUpdateTime;
+    atomic_long writerCommits;
+} RCReadPoolContext;
+
+typedef struct {
+    RCReadPoolContext *context;
+    RCBenchSamples samples;
+} RCReaderState;
+
+static void RCRunMenuQuery(sqlite3 *db) {
+    sqlite3_stmt *statement = NULL;
+    if (sqlite3_prepare_v2(db, kRCMenuQuery, -1, &statement, NULL) != SQLITE_OK) {
+        fprintf(stderr, "menu query prepare failed: %s\n", sqlite3_errmsg(db));
+        return;
+    }
+    while (sqlite3_step(statement) == SQLITE_ROW) {
+        (void)sqlite3_column_text(statement, 1);
+        (void)sqlite3_column_text(statement, 3);
+    }
+    sqlite3_finalize(statement);
+}
+
+static void *RCWriterMain(void *argument) {
+    RCReadPoolContext *context = argument;
+    sqlite3 *db = context->serialized ? context->sharedConnection
+                                      : RCBenchOpenWriter(context->databasePath, RCBenchJournalModeWAL);
+    if (db == NULL) {
+        return NULL;
+    }
+
+    uint64_t sequence = 1u << 30;
+    while (!atomic_load(&context->stop)) {
+        char sql[512];
+        char hash[65];
+        RCBenchHexDigestForSeed(sequence, hash);
+        snprintf(sql, sizeof(sql),
+                 "INSERT INTO clip_items (data_path, title, data_hash, primary_type, update_time) "
+                 "VALUES ('%llu.rcclip', 'burst', X'%s', 'public.utf8-plain-text', %lld)",
+                 (unsigned long long)sequence, hash, (long long)context->nextUpdateTime++);
+        sequence++;
+
+        if (context->serialized) {
+            pthread_mutex_lock(&context->sharedConnectionLock);
+        }
+        bool inserted = RCBenchExec(db, sql);
+        if (context->serialized) {
+            pthread_mutex_unlock(&context->sharedConnectionLock);
+        }
+        if (inserted) {
+            atomic_fetch_add(&context->writerCommits, 1);
+        }
+        if (context->writeIntervalMicroseconds > 0) {
+            RCBenchSleepMicroseconds((uint64_t)context->writeIntervalMicroseconds);
+        }
+    }
+
+    if (!context->serialized) {
+        sqlite3_close(db);
+    }
+    return NULL;
+}
+
+static void *RCReaderMain(void *argument) {
+    RCReaderState *state = argument;
+    RCReadPoolContext *context = state->context;
+    sqlite3 *db = context->serialized ? context->sharedConnection : RCBenchOpenReader(context->databasePath);
+    if (db == NULL) {
+        return NULL;
+    }
+
+    while (!atomic_load(&context->stop)) {
+        uint64_t start = RCBenchNowNanoseconds();
+        if (context->serialized) {
+            pthread_mutex_lock(&context->sharedConnectionLock);
+        }
+        RCRunMenuQuery(db);
+        if (context->serialized) {
+            pthread_mutex_unlock(&context->sharedConnectionLock);
+        }
+        RCBenchSamplesAppend(&state->samples, RCBenchNowNanoseconds() - start);
+        RCBenchSleepMicroseconds(500);
+    }
+
+    if (!context->serialized) {
+        sqlite3_close(db);
+    }
+    return NULL;
+}
+
+static int RCRunScenario(bool serialized, long rows, long seconds, long readers, long writeIntervalMicroseconds) {
+    char *directory = RCBenchCreateScratchDirectory("rc-readpool");
+    if (directory == NULL) {
+        return 1;
+    }
+    char *databasePath = RCBenchPathJoin(directory, "revclip.db");
+
+    RCReadPoolContext context;
+    memset(&context, 0, sizeof(context));
+    context.databasePath = databasePath;
+    context.serialized = serialized;
+    context.writeIntervalMicroseconds = writeIntervalMicroseconds;
+    context.nextUpdateTime = 2000000000000LL;
+    atomic_init(&context.stop, false);
+    atomic_init(&context.writerCommits, 0);
+    pthread_mutex_init(&context.sharedConnectionLock, NULL);
+
+    sqlite3 *setupConnection = RCBenchOpenWriter(databasePath,
+                                                 serialized ? RCBenchJournalModeDelete : RCBenchJournalModeWAL);
+    if (setupConnection == NULL
+        || !RCBenchCreateBaseSchema(setupConnection)
+        || !RCBenchSeedClipItems(setupConnection, (int)rows, 1700000000000LL)) {
+        sqlite3_close(setupConnection);
+        RCBenchRemoveScratchDirectory(directory);
+        free(databasePath);
+        free(directory);
+        return 1;
+    }
+    if (serialized) {
+        context.sharedConnection = setupConnection;
+    }
+
+    RCReaderState readerStates[RC_MAX_READERS];
+    pthread_t readerThreads[RC_MAX_READERS];
+    pthread_t writerThread;
+    for (long index = 0; index < readers; index++) {
+        readerStates[index].context = &context;
+        RCBenchSamplesInit(&readerStates[index].samples, 4096);
+    }
+
+    pthread_create(&writerThread, NULL, RCWriterMain, &context);
+    for (long index = 0; index < readers; index++) {
+        pthread_create(&readerThreads[index], NULL, RCReaderMain, &readerStates[index]);
+    }
+
+    RCBenchSleepMicroseconds((uint64_t)seconds * 1000000ull);
+    atomic_store(&context.stop, true);
+
+    pthread_join(writerThread, NULL);
+    RCBenchSamples merged;
+    RCBenchSamplesInit(&merged, 4096);
+    for (long index = 0; index < readers; index++) {
+        pthread_join(readerThreads[index], NULL);
+        RCBenchSamplesAppendAll(&merged, &readerStates[index].samples);
+        RCBenchSamplesFree(&readerStates[index].samples);
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "%s menu read", serialized ? "serialized" : "wal-pool");
+    RCBenchPrintLatencyRow(label, &merged);
+    printf("%-28s %.1f commits/s\n", "  writer throughput",
+           (double)atomic_load(&context.writerCommits) / (double)seconds);
+
+    RCBenchSamplesFree(&merged);
+    sqlite3_close(setupConnection);
+    pthread_mutex_destroy(&context.sharedConnectionLock);
+    RCBenchRemoveScratchDirectory(directory);
+    free(databasePath);
+    free(directory);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    long rows = RCBenchIntegerOption(argc, argv, "--rows", 9999);
+    long seconds = RCBenchIntegerOption(argc, argv, "--seconds", 3);
+    long readers = RCBenchIntegerOption(argc, argv, "--readers", 2);
+    long writeIntervalMicroseconds = RCBenchIntegerOption(argc, argv, "--write-interval-us", 2000);
+    const char *mode = RCBenchStringOption(argc, argv, "--mode", "both");
+
+    if (readers < 1) {
+        readers = 1;
+    }
+    if (readers > RC_MAX_READERS) {
+        readers = RC_MAX_READERS;
+    }
+    if (seconds < 1) {
+        seconds = 1;
+    }
+
+    printf("RCReadPoolBenchmark rows=%ld seconds=%ld readers=%ld write-interval=%ldus sqlite=%s\n",
+           rows, seconds, readers, writeIntervalMicroseconds, sqlite3_libversion());
+
+    int status = 0;
+    if (strcmp(mode, "both") == 0 || strcmp(mode, "serialized") == 0) {
+        status |= RCRunScenario(true, rows, seconds, readers, writeIntervalMicroseconds);
+    }
+    if (strcmp(mode, "both") == 0 || strcmp(mode, "wal-pool") == 0) {
+        status |= RCRunScenario(false, rows, seconds, readers, writeIntervalMicroseconds);
+    }
+    return status;
+}
@@ -0,0 +1,688 @@
+//
+//  RCReplayTrace.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCReplayTrace.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCBenchSupport.h"
+
+#define RC_MILLISECOND 1000000ull
+#define RC_SECOND (1000ull * RC_MILLISECOND)
+#define RC_HOUR (3600ull * RC_SECOND)
+
+// MARK: - Traces
+
+static const struct {
+    const char *name;
+    RCClipRepresentation representation;
+} kRCTypeNames[] = {
+    { "string", RCClipRepresentationString },
+    { "rtf", RCClipRepresentationRTF },
+    { "rtfd", RCClipRepresentationRTFD },
+    { "pdf", RCClipRepresentationPDF },
+    { "files", RCClipRepresentationFiles },
+    { "url", RCClipRepresentationURL },
+    { "tiff", RCClipRepresentationTIFF },
+};
+
+void RCReplayTraceInit(RCReplayTrace *trace) {
+    memset(trace, 0, sizeof(*trace));
+    trace->historyLimit = -1;
+}
+
+void RCReplayTraceFree(RCReplayTrace *trace) {
+    for (size_t index = 0; index < trace->stringCount; index++) {
+        free(trace->strings[index]);
+    }
+    free(trace->strings);
+    free(trace->events);
+    RCReplayTraceInit(trace);
+}
+
+static bool RCTraceAppend(RCReplayTrace *trace, RCReplayEvent event) {
+    if (trace->count == trace->capacity) {
+        size_t capacity = trace->capacity == 0 ? 1024 : trace->capacity * 2;
+        RCReplayEvent *events = realloc(trace->events, capacity * sizeof(*events));
+        if (events == NULL) {
+            return false;
+        }
+        trace->events = events;
+        trace->capacity = capacity;
+    }
+    trace->events[trace->count++] = event;
+    return true;
+}
+
+static bool RCTraceCopy(RCReplayTrace *trace, uint64_t at, RCClipRepresentationMask offered, size_t length,
+                        uint64_t seed, const char *application) {
+    RCReplayEvent event = {
+        .atNanoseconds = at,
+        .kind = RCReplayEventCopy,
+        .contents = { .offered = offered, .length = length, .seed = seed, .sourceBundleIdentifier = application },
+    };
+    return RCTraceAppend(trace, event);
+}
+
+static const char *RCTraceIntern(RCReplayTrace *trace, const char *string) {
+    for (size_t index = 0; index < trace->stringCount; index++) {
+        if (strcmp(trace->strings[index], string) == 0) {
+            return trace->strings[index];
+        }
+    }
+    char **strings = realloc(trace->strings, (trace->stringCount + 1) * sizeof(*strings));
+    if (strings == NULL) {
+        return NULL;
+    }
+    trace->strings = strings;
+    char *copy = strdup(string);
+    if (copy != NULL) {
+        trace->strings[trace->stringCount++] = copy;
+    }
+    return copy;
+}
+
+static bool RCParseUnsigned(const char *text, uint64_t *outValue) {
+    if (text == NULL || *text < '0' || *text > '9') {
+        return false;
+    }
+    char *end = NULL;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (errno != 0 || *end != '\0') {
+        return false;
+    }
+    *outValue = (uint64_t)value;
+    return true;
+}
+
+static bool RCParseTypes(char *text, RCClipRepresentationMask *outMask) {
+    RCClipRepresentationMask mask = 0;
+    char *save = NULL;
+    for (char *name = strtok_r(text, ",", &save); name != NULL; name = strtok_r(NULL, ",", &save)) {
+        size_t index = 0;
+        while (index < sizeof(kRCTypeNames) / sizeof(kRCTypeNames[0]) && strcmp(kRCTypeNames[index].name, name) != 0) {
+            index++;
+        }
+        if (index == sizeof(kRCTypeNames) / sizeof(kRCTypeNames[0])) {
+            return false;
+        }
+        mask |= kRCTypeNames[index].representation;
+    }
+    *outMask = mask;
+    return mask != 0;
+}
+
+/// Parses one line (comment already stripped). Blank lines are fine.
+static bool RCTraceParseLine(RCReplayTrace *trace, char *line) {
+    char *save = NULL;
+    char *first = strtok_r(line, " \t\r\n", &save);
+    if (first == NULL) {
+        return true;
+    }
+    uint64_t value = 0;
+    if (strcmp(first, "limit") == 0 || strcmp(first, "expiry-ms") == 0) {
+        char *argument = strtok_r(NULL, " \t\r\n", &save);
+        if (!RCParseUnsigned(argument, &value) || strtok_r(NULL, " \t\r\n", &save) != NULL) {
+            return false;
+        }
+        if (first[0] == 'l') {
+            trace->historyLimit = (long)value;
+        } else {
+            trace->expiryNanoseconds = value * RC_MILLISECOND;
+        }
+        return true;
+    }
+
+    uint64_t milliseconds = 0;
+    char *kind = strtok_r(NULL, " \t\r\n", &save);
+    if (!RCParseUnsigned(first, &milliseconds) || kind == NULL) {
+        return false;
+    }
+    RCReplayEvent event = { .atNanoseconds = milliseconds * RC_MILLISECOND };
+    if (trace->count > 0 && event.atNanoseconds < trace->events[trace->count - 1].atNanoseconds) {
+        return false;
+    }
+    if (strcmp(kind, "touch") == 0 || strcmp(kind, "activity") == 0) {
+        event.kind = kind[0] == 't' ? RCReplayEventTouch : RCReplayEventActivity;
+        return strtok_r(NULL, " \t\r\n", &save) == NULL && RCTraceAppend(trace, event);
+    }
+    if (strcmp(kind, "copy") != 0) {
+        return false;
+    }
+
+    event.kind = RCReplayEventCopy;
+    bool hasTypes = false;
+    bool hasBytes = false;
+    for (char *field = strtok_r(NULL, " \t\r\n", &save); field != NULL; field = strtok_r(NULL, " \t\r\n", &save)) {
+        if (strcmp(field, "marked") == 0) {
+            event.contents.marked = true;
+        } else if (strncmp(field, "types=", 6) == 0) {
+            hasTypes = RCParseTypes(field + 6, &event.contents.offered);
+        } else if (strncmp(field, "bytes=", 6) == 0) {
+            hasBytes = RCParseUnsigned(field + 6, &value);
+            event.contents.length = (size_t)value;
+        } else if (strncmp(field, "seed=", 5) == 0) {
+            if (!RCParseUnsigned(field + 5, &event.contents.seed)) {
+                return false;
+            }
+        } else if (strncmp(field, "app=", 4) == 0) {
+            event.contents.sourceBundleIdentifier = RCTraceIntern(trace, field + 4);
+            if (event.contents.sourceBundleIdentifier == NULL) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return hasTypes && hasBytes && RCTraceAppend(trace, event);
+}
+
+bool RCReplayTraceLoad(RCReplayTrace *trace, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+    char *line = NULL;
+    size_t capacity = 0;
+    long lineNumber = 0;
+    bool ok = true;
+    while (ok && getline(&line, &capacity, file) >= 0) {
+        lineNumber++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) {
+            *comment = '\0';
+        }
+        if (!RCTraceParseLine(trace, line)) {
+            fprintf(stderr, "%s:%ld: malformed trace line\n", path, lineNumber);
+            ok = false;
+        }
+    }
+    free(line);
+    fclose(file);
+    return ok;
+}
+
+bool RCReplayTraceWrite(const RCReplayTrace *trace, const char *name, const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+    fprintf(file, "# Revclip replay trace: %s\n", name);
+    if (trace->historyLimit >= 0) {
+        fprintf(file, "limit %ld\n", trace->historyLimit);
+    }
+    if (trace->expiryNanoseconds > 0) {
+        fprintf(file, "expiry-ms %llu\n", (unsigned long long)(trace->expiryNanoseconds / RC_MILLISECOND));
+    }
+    for (size_t index = 0; index < trace->count; index++) {
+        const RCReplayEvent *event = &trace->events[index];
+        unsigned long long milliseconds = (unsigned long long)(event->atNanoseconds / RC_MILLISECOND);
+        if (event->kind != RCReplayEventCopy) {
+            fprintf(file, "%llu %s\n", milliseconds, event->kind == RCReplayEventTouch ? "touch" : "activity");
+            continue;
+        }
+        fprintf(file, "%llu copy types=", milliseconds);
+        const char *separator = "";
+        for (size_t type = 0; type < sizeof(kRCTypeNames) / sizeof(kRCTypeNames[0]); type++) {
+            if ((event->contents.offered & kRCTypeNames[type].representation) != 0) {
+                fprintf(file, "%s%s", separator, kRCTypeNames[type].name);
+                separator = ",";
+            }
+        }
+        fprintf(file, " bytes=%zu seed=%llu", event->contents.length, (unsigned long long)event->contents.seed);
+        if (event->contents.sourceBundleIdentifier != NULL) {
+            fprintf(file, " app=%s", event->contents.sourceBundleIdentifier);
+        }
+        fprintf(file, "%s\n", event->contents.marked ? " marked" : "");
+    }
+    bool ok = ferror(file) == 0;
+    return fclose(file) == 0 && ok;
+}
+
+// MARK: - Scenarios
+
+static uint64_t RCNextRandom(uint64_t *state) {
+    *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+    return *state >> 33;
+}
+
+static uint64_t RCRandomBetween(uint64_t *state, uint64_t low, uint64_t high) {
+    return low + RCNextRandom(state) % (high - low + 1);
+}
+
+static bool RCGenerateTextBursts(RCReplayTrace *trace, const RCReplayOptions *options, uint64_t *state) {
+    uint64_t now = 0;
+    uint64_t seed = options->seed << 32;
+    for (long burst = 0; burst < 60 * options->scale; burst++) {
+        now += RCRandomBetween(state, 2 * RC_SECOND, 10 * RC_SECOND);
+        uint64_t copies = RCRandomBetween(state, 5, 20);
+        for (uint64_t copy = 0; copy < copies; copy++) {
+            now += RCRandomBetween(state, 10 * RC_MILLISECOND, 40 * RC_MILLISECOND);
+            if (!RCTraceCopy(trace, now, RCClipRepresentationString, RCRandomBetween(state, 8, 400), seed++,
+                             "com.example.terminal")) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool RCGenerateImages(RCReplayTrace *trace, const RCReplayOptions *options, uint64_t *state) {
+    uint64_t now = 0;
+    size_t length = (size_t)options->imageMiB * 1024 * 1024;
+    for (long image = 0; image < 3 * options->scale; image++) {
+        uint64_t seed = (options->seed << 32) + (uint64_t)image;
+        now += RCRandomBetween(state, 5 * RC_SECOND, 15 * RC_SECOND);
+        if (!RCTraceCopy(trace, now, RCClipRepresentationTIFF, length, seed, "com.example.preview")) {
+            return false;
+        }
+        // the same screenshot again: a full read and hash, then a dedup hit
+        now += 30 * RC_SECOND;
+        if (!RCTraceCopy(trace, now, RCClipRepresentationTIFF, length, seed, "com.example.preview")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool RCGenerateFileLists(RCReplayTrace *trace, const RCReplayOptions *options, uint64_t *state) {
+    uint64_t now = 0;
+    uint64_t seed = options->seed << 32;
+    for (long copy = 0; copy < 150 * options->scale; copy++) {
+        now += RCRandomBetween(state, 1 * RC_SECOND, 4 * RC_SECOND);
+        RCReplayEvent previous = trace->count > 0 ? trace->events[trace->count - 1] : (RCReplayEvent){ 0 };
+        if (trace->count > 0 && RCNextRandom(state) % 5 == 0) {
+            previous.atNanoseconds = now;
+            if (!RCTraceAppend(trace, previous)) {
+                return false;
+            }
+            continue;
+        }
+        if (!RCTraceCopy(trace, now, RCClipRepresentationFiles | RCClipRepresentationString,
+                         RCRandomBetween(state, 200, 4000), seed++, "com.apple.finder")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool RCGenerateDuplicates(RCReplayTrace *trace, const RCReplayOptions *options, uint64_t *state) {
+    enum { kRCPoolSize = 40 };
+    uint64_t now = 0;
+    trace->historyLimit = 30;
+    for (long copy = 0; copy < 400 * options->scale; copy++) {
+        now += RCRandomBetween(state, 500 * RC_MILLISECOND, 3 * RC_SECOND);
+        uint64_t entry = RCNextRandom(state) % kRCPoolSize;
+        if (!RCTraceCopy(trace, now, RCClipRepresentationString, 32 + entry * 24, (options->seed << 32) + entry,
+                         "com.example.editor")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool RCGenerateIdleExpiry(RCReplayTrace *trace, const RCReplayOptions *options, uint64_t *state) {
+    uint64_t now = 0;
+    uint64_t seed = options->seed << 32;
+    trace->historyLimit = 500;
+    trace->expiryNanoseconds = RC_HOUR;
+    for (long session = 0; session < 6 * options->scale; session++) {
+        if (session > 0) {
+            // wake from idle: hot key, then an app re-declaring its types
+            now += RCRandomBetween(state, 2 * RC_HOUR, 5 * RC_HOUR);
+            RCReplayEvent wake = { .atNanoseconds = now, .kind = RCReplayEventActivity };
+            RCReplayEvent touch = { .atNanoseconds = now + RC_SECOND, .kind = RCReplayEventTouch };
+            if (!RCTraceAppend(trace, wake) || !RCTraceAppend(trace, touch)) {
+                return false;
+            }
+            now += RC_SECOND;
+        }
+        for (int copy = 0; copy < 30; copy++) {
+            now += RCRandomBetween(state, 2 * RC_SECOND, 20 * RC_SECOND);
+            bool rich = RCNextRandom(state) % 4 == 0;
+            if (!RCTraceCopy(trace, now, rich ? RCClipRepresentationString | RCClipRepresentationRTF : RCClipRepresentationString,
+                             rich ? RCRandomBetween(state, 1024, 8192) : RCRandomBetween(state, 16, 512), seed++,
+                             "com.example.editor")) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+typedef bool (*RCReplayGenerator)(RCReplayTrace *trace, const RCReplayOptions *options, uint64_t *state);
+
+static const struct {
+    const char *name;
+    RCReplayGenerator generate;
+} kRCScenarios[] = {
+    { "text-bursts", RCGenerateTextBursts },
+    { "images", RCGenerateImages },
+    { "file-lists", RCGenerateFileLists },
+    { "duplicates", RCGenerateDuplicates },
+    { "idle-expiry", RCGenerateIdleExpiry },
+};
+
+#define RC_SCENARIO_COUNT (sizeof(kRCScenarios) / sizeof(kRCScenarios[0]))
+
+size_t RCReplayScenarioCount(void) {
+    return RC_SCENARIO_COUNT;
+}
+
+const char *RCReplayScenarioName(size_t scenario) {
+    return scenario < RC_SCENARIO_COUNT ? kRCScenarios[scenario].name : NULL;
+}
+
+static bool RCScenarioBuild(size_t scenario, const RCReplayOptions *options, RCReplayTrace *trace) {
+    uint64_t state = options->seed * 0x9E3779B97F4A7C15ull + scenario;
+    return kRCScenarios[scenario].generate(trace, options, &state);
+}
+
+bool RCReplayTraceBuild(size_t scenario, const char *tracePath, const RCReplayOptions *options,
+                        RCReplayTrace *trace) {
+    if (tracePath != NULL) {
+        return RCReplayTraceLoad(trace, tracePath);
+    }
+    return scenario < RC_SCENARIO_COUNT && RCScenarioBuild(scenario, options, trace);
+}
+
+// MARK: - Baseline
+
+typedef enum {
+    RCMetricLowerIsBetter,
+    RCMetricHigherIsBetter,
+} RCMetricDirection;
+
+typedef struct {
+    const char *name;
+    RCMetricDirection direction;
+    /// Timing metrics use --time-tolerance, the rest --tolerance.
+    bool timing;
+} RCMetric;
+
+static const RCMetric kRCMetrics[] = {
+    { "copies_per_second", RCMetricHigherIsBetter, true },
+    { "p50_us", RCMetricLowerIsBetter, true },
+    { "p99_us", RCMetricLowerIsBetter, true },
+    { "written_bytes", RCMetricLowerIsBetter, false },
+    { "fsyncs", RCMetricLowerIsBetter, false },
+    { "peak_rss_kib", RCMetricLowerIsBetter, false },
+};
+
+#define RC_METRIC_COUNT (sizeof(kRCMetrics) / sizeof(kRCMetrics[0]))
+
+static void RCResultMetrics(const RCReplayResult *result, double outValues[RC_METRIC_COUNT]) {
+    double seconds = (double)result->elapsedNanoseconds / 1e9;
+    outValues[0] = seconds > 0 ? (double)result->copies / seconds : 0;
+    outValues[1] = (double)result->p50Nanoseconds / 1e3;
+    outValues[2] = (double)result->p99Nanoseconds / 1e3;
+    outValues[3] = (double)result->bytesWritten;
+    outValues[4] = (double)result->syncs;
+    outValues[5] = (double)(result->peakResidentBytes / 1024);
+}
+
+typedef struct {
+    char scenario[64];
+    size_t metric;
+    double value;
+} RCBaselineEntry;
+
+typedef struct {
+    char options[128];
+    RCBaselineEntry *entries;
+    size_t count;
+} RCBaseline;
+
+static bool RCBaselineLoad(RCBaseline *baseline, const char *path) {
+    memset(baseline, 0, sizeof(*baseline));
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+    char *line = NULL;
+    size_t capacity = 0;
+    long lineNumber = 0;
+    bool ok = true;
+    while (ok && getline(&line, &capacity, file) >= 0) {
+        lineNumber++;
+        line[strcspn(line, "#\r\n")] = '\0';
+        if (strncmp(line, "options ", 8) == 0) {
+            snprintf(baseline->options, sizeof(baseline->options), "%s", line + 8);
+            continue;
+        }
+        char scenario[64];
+        char metric[32];
+        double value = 0;
+        int fields = sscanf(line, "%63s %31s %lf", scenario, metric, &value);
+        if (fields <= 0) {
+            continue;
+        }
+        size_t index = 0;
+        while (index < RC_METRIC_COUNT && strcmp(kRCMetrics[index].name, metric) != 0) {
+            index++;
+        }
+        if (fields != 3 || index == RC_METRIC_COUNT) {
+            fprintf(stderr, "%s:%ld: malformed baseline line\n", path, lineNumber);
+            ok = false;
+            continue;
+        }
+        RCBaselineEntry *entries = realloc(baseline->entries, (baseline->count + 1) * sizeof(*entries));
+        if (entries == NULL) {
+            ok = false;
+            continue;
+        }
+        baseline->entries = entries;
+        RCBaselineEntry *entry = &baseline->entries[baseline->count++];
+        snprintf(entry->scenario, sizeof(entry->scenario), "%s", scenario);
+        entry->metric = index;
+        entry->value = value;
+    }
+    free(line);
+    fclose(file);
+    return ok;
+}
+
+static const RCBaselineEntry *RCBaselineFind(const RCBaseline *baseline, const char *scenario, size_t metric) {
+    for (size_t index = 0; index < baseline->count; index++) {
+        if (baseline->entries[index].metric == metric && strcmp(baseline->entries[index].scenario, scenario) == 0) {
+            return &baseline->entries[index];
+        }
+    }
+    return NULL;
+}
+
+/// Prints one row per metric and returns the number of regressions.
+static int RCBaselineCompare(const RCBaseline *baseline, const char *scenario, const RCReplayResult *result,
+                             long tolerance, long timeTolerance) {
+    double values[RC_METRIC_COUNT];
+    RCResultMetrics(result, values);
+    int regressions = 0;
+    for (size_t metric = 0; metric < RC_METRIC_COUNT; metric++) {
+        const RCBaselineEntry *entry = RCBaselineFind(baseline, scenario, metric);
+        if (entry == NULL) {
+            printf("  %-14s %-18s %14s %14.1f  (no baseline)\n", scenario, kRCMetrics[metric].name, "-", values[metric]);
+            continue;
+        }
+        long percent = kRCMetrics[metric].timing ? timeTolerance : tolerance;
+        // percent worse than the baseline; for throughput, how much longer a copy takes
+        double worse = entry->value > 0 ? (values[metric] - entry->value) / entry->value * 100.0
+                                        : (values[metric] > 0 ? 100.0 : 0.0);
+        if (kRCMetrics[metric].direction == RCMetricHigherIsBetter) {
+            worse = values[metric] > 0 ? (entry->value - values[metric]) / values[metric] * 100.0 : 100.0;
+        }
+        const char *verdict = "ok";
+        if (percent >= 0 && worse > (double)percent) {
+            verdict = "REGRESSION";
+            regressions++;
+        } else if (percent >= 0 && worse < -(double)percent) {
+            verdict = "improved";
+        } else if (percent < 0) {
+            verdict = "report only";
+        }
+        printf("  %-14s %-18s %14.1f %14.1f %+8.1f%%  %s\n", scenario, kRCMetrics[metric].name, entry->value,
+               values[metric], worse, verdict);
+    }
+    return regressions;
+}
+
+static void RCBaselineWrite(FILE *file, const char *scenario, const RCReplayResult *result) {
+    double values[RC_METRIC_COUNT];
+    RCResultMetrics(result, values);
+    for (size_t metric = 0; metric < RC_METRIC_COUNT; metric++) {
+        fprintf(file, "%s %s %.1f\n", scenario, kRCMetrics[metric].name, values[metric]);
+    }
+}
+
+// MARK: - Command line
+
+static const char *RCBaseName(const char *path) {
+    const char *slash = strrchr(path, '/');
+    return slash != NULL ? slash + 1 : path;
+}
+
+void RCReplayOptionsParse(int argc, char **argv, RCReplayOptions *outOptions) {
+    outOptions->scale = RCBenchIntegerOption(argc, argv, "--scale", 1);
+    outOptions->imageMiB = RCBenchIntegerOption(argc, argv, "--image-mib", 20);
+    outOptions->seed = (uint64_t)RCBenchIntegerOption(argc, argv, "--seed", 1);
+    outOptions->scale = outOptions->scale < 1 ? 1 : outOptions->scale;
+    outOptions->imageMiB = outOptions->imageMiB < 1 ? 1 : outOptions->imageMiB;
+}
+
+int RCReplayMain(int argc, char **argv, const RCReplayDriver *driver) {
+    RCReplayOptions options;
+    RCReplayOptionsParse(argc, argv, &options);
+    const char *only = RCBenchStringOption(argc, argv, "--scenario", "all");
+    const char *tracePath = RCBenchStringOption(argc, argv, "--trace", NULL);
+    const char *baselinePath = RCBenchStringOption(argc, argv, "--baseline", NULL);
+    const char *writeBaselinePath = RCBenchStringOption(argc, argv, "--write-baseline", NULL);
+    const char *writeTracePath = RCBenchStringOption(argc, argv, "--write-trace", NULL);
+    long tolerance = RCBenchIntegerOption(argc, argv, "--tolerance", 10);
+    long timeTolerance = RCBenchIntegerOption(argc, argv, "--time-tolerance", 50);
+
+    char optionString[128];
+    int prefixLength = 0;
+    if (driver->pipeline != NULL) {
+        prefixLength = snprintf(optionString, sizeof(optionString), "pipeline=%s ", driver->pipeline);
+    }
+    if (tracePath != NULL) {
+        snprintf(optionString + prefixLength, sizeof(optionString) - (size_t)prefixLength, "trace=%s",
+                 RCBaseName(tracePath));
+    } else {
+        snprintf(optionString + prefixLength, sizeof(optionString) - (size_t)prefixLength,
+                 "scale=%ld image-mib=%ld seed=%llu", options.scale, options.imageMiB,
+                 (unsigned long long)options.seed);
+    }
+
+    bool selected[RC_SCENARIO_COUNT];
+    size_t selectedCount = 0;
+    for (size_t scenario = 0; scenario < RC_SCENARIO_COUNT; scenario++) {
+        selected[scenario] = strcmp(only, "all") == 0 || strcmp(only, kRCScenarios[scenario].name) == 0;
+        selectedCount += selected[scenario] ? 1 : 0;
+    }
+    if (tracePath == NULL && selectedCount == 0) {
+        fprintf(stderr, "unknown scenario: %s\n", only);
+        return 2;
+    }
+
+    if (writeTracePath != NULL) {
+        if (tracePath != NULL || selectedCount != 1) {
+            fprintf(stderr, "--write-trace needs a single --scenario\n");
+            return 2;
+        }
+        size_t scenario = 0;
+        while (!selected[scenario]) {
+            scenario++;
+        }
+        RCReplayTrace trace;
+        RCReplayTraceInit(&trace);
+        bool wrote = RCScenarioBuild(scenario, &options, &trace)
+            && RCReplayTraceWrite(&trace, kRCScenarios[scenario].name, writeTracePath);
+        printf("%s: %zu events -> %s\n", kRCScenarios[scenario].name, trace.count, writeTracePath);
+        RCReplayTraceFree(&trace);
+        return wrote ? 0 : 1;
+    }
+
+    RCBaseline baseline = { 0 };
+    if (baselinePath != NULL) {
+        if (!RCBaselineLoad(&baseline, baselinePath)) {
+            free(baseline.entries);
+            return 1;
+        }
+        if (strcmp(baseline.options, optionString) != 0) {
+            fprintf(stderr, "%s was recorded with \"%s\", this run uses \"%s\"\n", baselinePath, baseline.options,
+                    optionString);
+            free(baseline.entries);
+            return 1;
+        }
+    }
+    FILE *baselineOut = NULL;
+    if (writeBaselinePath != NULL) {
+        baselineOut = fopen(writeBaselinePath, "w");
+        if (baselineOut == NULL) {
+            fprintf(stderr, "%s: %s\n", writeBaselinePath, strerror(errno));
+            free(baseline.entries);
+            return 1;
+        }
+        fprintf(baselineOut, "# %s baseline (--write-baseline); compare with --baseline\n", driver->name);
+        fprintf(baselineOut, "options %s\n", optionString);
+    }
+
+    printf("%s %s\n", driver->name, optionString);
+    printf("%-14s %7s %9s %10s %10s %12s %8s %10s\n", "scenario", "copies", "copies/s", "p50 us", "p99 us",
+           "written MiB", "fsyncs", "peak MiB");
+
+    RCReplayResult results[RC_SCENARIO_COUNT];
+    const char *names[RC_SCENARIO_COUNT];
+    size_t runCount = 0;
+    bool failed = false;
+    for (size_t scenario = 0; scenario < RC_SCENARIO_COUNT; scenario++) {
+        if (tracePath == NULL && !selected[scenario]) {
+            continue;
+        }
+        const char *name = tracePath != NULL ? RCBaseName(tracePath) : kRCScenarios[scenario].name;
+        RCReplayResult *result = &results[runCount];
+        if (!driver->replay(scenario, tracePath, &options, result, driver->context)) {
+            fprintf(stderr, "%s: replay failed\n", name);
+            failed = true;
+        } else {
+            double values[RC_METRIC_COUNT];
+            RCResultMetrics(result, values);
+            printf("%-14s %7llu %9.0f %10.0f %10.0f %12.1f %8llu %10.1f\n", name,
+                   (unsigned long long)result->copies, values[0], values[1], values[2],
+                   (double)result->bytesWritten / 1048576.0, (unsigned long long)result->syncs,
+                   (double)result->peakResidentBytes / 1048576.0);
+            names[runCount++] = name;
+        }
+        if (tracePath != NULL) {
+            break;
+        }
+    }
+
+    int regressions = 0;
+    if (baselinePath != NULL && runCount > 0) {
+        printf("\nbaseline %s (tolerance %ld%%, time %ld%%)\n", baselinePath, tolerance, timeTolerance);
+        for (size_t index = 0; index < runCount; index++) {
+            regressions += RCBaselineCompare(&baseline, names[index], &results[index], tolerance, timeTolerance);
+        }
+        printf("%d regression(s)\n", regressions);
+    }
+    if (baselineOut != NULL) {
+        for (size_t index = 0; index < runCount; index++) {
+            RCBaselineWrite(baselineOut, names[index], &results[index]);
+        }
+        failed = fclose(baselineOut) != 0 || failed;
+    }
+    free(baseline.entries);
+    return failed || regressions > 0 ? 1 : 0;
+}
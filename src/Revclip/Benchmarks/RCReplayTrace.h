@@ -0,0 +1,112 @@
+//
+//  RCReplayTrace.h
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Clipboard event streams for the trace replays, shared by the model
+//  (RCTraceReplayBenchmark, RCBenchCapture) and the app replay
+//  (RevclipTraceReplay, the real RCClipboardService / RCDatabaseManager /
+//  RCDataCleanService): the trace text format, the built-in scenarios, the
+//  per-scenario metrics and the baseline files, plus the command line both
+//  tools run. Each tool supplies only the runner that replays one trace.
+//
+
+#ifndef RCReplayTrace_h
+#define RCReplayTrace_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RCBenchPasteboard.h"
+
+typedef enum {
+    /// Replace the pasteboard contents (a user or app copy).
+    RCReplayEventCopy = 0,
+    /// Bump the change count only.
+    RCReplayEventTouch,
+    /// Hot key / app switch / wake: RCPollSchedulerNoteActivity.
+    RCReplayEventActivity,
+} RCReplayEventKind;
+
+typedef struct {
+    /// Time from the start of the trace.
+    uint64_t atNanoseconds;
+    RCReplayEventKind kind;
+    RCBenchPasteboardContents contents;
+} RCReplayEvent;
+
+typedef struct {
+    long scale;
+    long imageMiB;
+    uint64_t seed;
+} RCReplayOptions;
+
+typedef struct {
+    RCReplayEvent *events;
+    size_t count;
+    size_t capacity;
+    /// History limit and expiry for the run (-1 / 0: the app defaults).
+    long historyLimit;
+    uint64_t expiryNanoseconds;
+    /// Bundle identifiers of a loaded trace; events point into these.
+    char **strings;
+    size_t stringCount;
+} RCReplayTrace;
+
+/// --scale, --image-mib and --seed, clamped to at least 1.
+void RCReplayOptionsParse(int argc, char **argv, RCReplayOptions *outOptions);
+
+void RCReplayTraceInit(RCReplayTrace *trace);
+void RCReplayTraceFree(RCReplayTrace *trace);
+
+/// Reads / writes the text format (see RCTraceReplayBenchmark.c).
+bool RCReplayTraceLoad(RCReplayTrace *trace, const char *path);
+bool RCReplayTraceWrite(const RCReplayTrace *trace, const char *name, const char *path);
+
+size_t RCReplayScenarioCount(void);
+const char *RCReplayScenarioName(size_t scenario);
+
+/// Builds built-in scenario `scenario`, or loads `tracePath` when it is set.
+bool RCReplayTraceBuild(size_t scenario, const char *tracePath, const RCReplayOptions *options,
+                        RCReplayTrace *trace);
+
+/// Metrics of one scenario.
+typedef struct {
+    uint64_t copies;
+    uint64_t captured;
+    /// Time the pipeline took: wall time for the model (virtual clock), CPU
+    /// time for the app replay (which runs on the real clock).
+    uint64_t elapsedNanoseconds;
+    uint64_t p50Nanoseconds;
+    uint64_t p99Nanoseconds;
+    uint64_t bytesWritten;
+    uint64_t syncs;
+    uint64_t peakResidentBytes;
+    bool passed;
+} RCReplayResult;
+
+/// Replays one scenario (or `tracePath`) in a fresh history and fills
+/// `outResult`. Returns false when the run or its end-state check failed.
+typedef bool (*RCReplayRunner)(size_t scenario, const char *tracePath, const RCReplayOptions *options,
+                               RCReplayResult *outResult, void *context);
+
+typedef struct {
+    /// Tool name for the report and baseline headers.
+    const char *name;
+    /// Tag recorded in the baseline's options line (NULL: none), so a
+    /// baseline of one pipeline is refused by the other.
+    const char *pipeline;
+    RCReplayRunner replay;
+    void *context;
+} RCReplayDriver;
+
+/// Parses the shared options (--scenario, --trace, --scale, --image-mib,
+/// --seed, --baseline, --write-baseline, --tolerance, --time-tolerance,
+/// --write-trace), runs the selected scenarios through `driver->replay`,
+/// prints the report and compares with or writes the baseline. Returns the
+/// process exit status.
+int RCReplayMain(int argc, char **argv, const RCReplayDriver *driver);
+
+#endif /* RCReplayTrace_h */
@@ -0,0 +1,180 @@
+//
+//  RCSHA256Benchmark.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  SHA-256 throughput of every kernel of Revclip/Core/RCSHA256 this CPU
+//  supports (scalar, x86 SHA-NI, ARMv8 crypto), for small clips (4 KiB), a
+//  typical RTF / image clip (256 KiB) and a large clip (--size-mib). Each
+//  row is the best of --iterations runs in GB/s (10^9 bytes per second).
+//
+//  It also measures what capturing a large image costs: the clip's data hash
+//  plus the blob digest of the same representation, hashed in two passes
+//  versus one pass (RCSHA256UpdateEach).
+//
+//  All kernels must produce the same digests; a mismatch fails the run.
+//
+//  Usage: RCSHA256Benchmark [--size-mib 64] [--iterations 5]
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCBenchSupport.h"
+#include "RCSHA256.h"
+
+static const RCSHA256Kernel kRCBenchKernels[] = {
+    RCSHA256KernelScalar,
+    RCSHA256KernelSHANI,
+    RCSHA256KernelARMv8,
+};
+
+static double RCGigabytesPerSecond(size_t length, uint64_t nanoseconds) {
+    return nanoseconds == 0 ? 0.0 : (double)length / (double)nanoseconds;
+}
+
+// Best time of `iterations` digests of `length` bytes, repeated so every
+// timed run covers at least `minimumBytes`.
+static uint64_t RCBestHashNanoseconds(const uint8_t *bytes,
+                                      size_t length,
+                                      size_t minimumBytes,
+                                      long iterations,
+                                      uint8_t digest[RC_SHA256_DIGEST_LENGTH],
+                                      size_t *outHashedBytes) {
+    size_t repeat = length >= minimumBytes ? 1 : minimumBytes / length;
+    uint64_t best = UINT64_MAX;
+    for (long iteration = 0; iteration < iterations; iteration++) {
+        uint64_t start = RCBenchNowNanoseconds();
+        for (size_t r = 0; r < repeat; r++) {
+            RCSHA256(bytes, length, digest);
+        }
+        uint64_t elapsed = RCBenchNowNanoseconds() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    *outHashedBytes = repeat * length;
+    return best;
+}
+
+int main(int argc, char **argv) {
+    long sizeMiB = RCBenchIntegerOption(argc, argv, "--size-mib", 64);
+    long iterations = RCBenchIntegerOption(argc, argv, "--iterations", 5);
+    if (sizeMiB < 1 || iterations < 1) {
+        fprintf(stderr, "usage: %s [--size-mib N] [--iterations N]\n", argv[0]);
+        return 2;
+    }
+
+    size_t largeLength = (size_t)sizeMiB * 1024 * 1024;
+    const size_t lengths[] = { 4 * 1024, 256 * 1024, largeLength };
+    const size_t lengthCount = sizeof(lengths) / sizeof(lengths[0]);
+
+    uint8_t *bytes = malloc(largeLength);
+    uint32_t state = 0x9E3779B9u;
+    for (size_t i = 0; i < largeLength; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        bytes[i] = (uint8_t)state;
+    }
+
+    printf("SHA-256 kernels (best of %ld, GB/s)\n", iterations);
+    char largeLabel[32];
+    snprintf(largeLabel, sizeof(largeLabel), "%ld MiB", sizeMiB);
+    printf("  %-10s %12s %12s %12s\n", "kernel", "4 KiB", "256 KiB", largeLabel);
+
+    uint8_t referenceDigests[3][RC_SHA256_DIGEST_LENGTH];
+    bool haveReference = false;
+    bool mismatch = false;
+    double scalarLarge = 0.0;
+    double fastestLarge = 0.0;
+    for (size_t k = 0; k < sizeof(kRCBenchKernels) / sizeof(kRCBenchKernels[0]); k++) {
+        RCSHA256Kernel kernel = kRCBenchKernels[k];
+        if (!RCSHA256SetKernel(kernel)) {
+            printf("  %-10s %12s\n", RCSHA256KernelName(kernel), "unavailable");
+            continue;
+        }
+        printf("  %-10s", RCSHA256KernelName(kernel));
+        for (size_t l = 0; l < lengthCount; l++) {
+            uint8_t digest[RC_SHA256_DIGEST_LENGTH];
+            size_t hashedBytes = 0;
+            uint64_t nanoseconds = RCBestHashNanoseconds(bytes, lengths[l], 64 * 1024 * 1024, iterations,
+                                                         digest, &hashedBytes);
+            double throughput = RCGigabytesPerSecond(hashedBytes, nanoseconds);
+            printf(" %12.2f", throughput);
+            if (!haveReference) {
+                memcpy(referenceDigests[l], digest, sizeof(digest));
+            } else if (memcmp(referenceDigests[l], digest, sizeof(digest)) != 0) {
+                mismatch = true;
+            }
+            if (l == lengthCount - 1) {
+                if (kernel == RCSHA256KernelScalar) {
+                    scalarLarge = throughput;
+                }
+                if (throughput > fastestLarge) {
+                    fastestLarge = throughput;
+                }
+            }
+        }
+        haveReference = true;
+        printf("\n");
+    }
+    if (mismatch) {
+        fprintf(stderr, "kernels disagree on a digest\n");
+        free(bytes);
+        return 1;
+    }
+
+    RCSHA256SetKernel(RCSHA256KernelAutomatic);
+    printf("  automatic picks %s (%.1fx scalar on %ld MiB)\n",
+           RCSHA256KernelName(RCSHA256ActiveKernel()),
+           scalarLarge > 0.0 ? fastestLarge / scalarLarge : 0.0, sizeMiB);
+
+    // Data hash plus blob digest of one large representation.
+    uint64_t twoPassBest = UINT64_MAX;
+    uint64_t onePassBest = UINT64_MAX;
+    uint8_t twoPassDigests[2][RC_SHA256_DIGEST_LENGTH];
+    uint8_t onePassDigests[2][RC_SHA256_DIGEST_LENGTH];
+    for (long iteration = 0; iteration < iterations; iteration++) {
+        RCSHA256Context dataHash;
+        RCSHA256Context blob;
+
+        uint64_t start = RCBenchNowNanoseconds();
+        RCSHA256Init(&dataHash);
+        RCSHA256Update(&dataHash, bytes, largeLength);
+        RCSHA256Final(&dataHash, twoPassDigests[0]);
+        RCSHA256Init(&blob);
+        RCSHA256Update(&blob, bytes, largeLength);
+        RCSHA256Final(&blob, twoPassDigests[1]);
+        uint64_t elapsed = RCBenchNowNanoseconds() - start;
+        if (elapsed < twoPassBest) {
+            twoPassBest = elapsed;
+        }
+
+        start = RCBenchNowNanoseconds();
+        RCSHA256Init(&dataHash);
+        RCSHA256Init(&blob);
+        RCSHA256Context *contexts[] = { &dataHash, &blob };
+        RCSHA256UpdateEach(contexts, 2, bytes, largeLength);
+        RCSHA256Final(&dataHash, onePassDigests[0]);
+        RCSHA256Final(&blob, onePassDigests[1]);
+        elapsed = RCBenchNowNanoseconds() - start;
+        if (elapsed < onePassBest) {
+            onePassBest = elapsed;
+        }
+    }
+    if (memcmp(twoPassDigests, onePassDigests, sizeof(twoPassDigests)) != 0) {
+        fprintf(stderr, "one-pass digests differ from two-pass digests\n");
+        free(bytes);
+        return 1;
+    }
+
+    printf("\nData hash + blob digest of %ld MiB (%s)\n", sizeMiB, RCSHA256KernelName(RCSHA256ActiveKernel()));
+    printf("  %-10s %10.2f ms\n", "two-pass", (double)twoPassBest / 1e6);
+    printf("  %-10s %10.2f ms\n", "one-pass", (double)onePassBest / 1e6);
+
+    free(bytes);
+    return 0;
+}
@@ -0,0 +1,223 @@
+//
+//  RCSHA256Tests.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Unit tests for the SHA-256 component (Revclip/Core/RCSHA256): the FIPS
+//  180-4 / NIST example vectors on every available kernel, digests that
+//  match the scalar kernel for every length around the block and padding
+//  boundaries and for arbitrary update splits, one-pass hashing into several
+//  contexts, and kernel selection.
+//
+//  Usage: RCSHA256Tests
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCSHA256.h"
+#include "RCTestSupport.h"
+
+static const RCSHA256Kernel kRCTestKernels[] = {
+    RCSHA256KernelScalar,
+    RCSHA256KernelSHANI,
+    RCSHA256KernelARMv8,
+};
+#define RC_TEST_KERNEL_COUNT (sizeof(kRCTestKernels) / sizeof(kRCTestKernels[0]))
+
+static void RCTestHex(const uint8_t digest[RC_SHA256_DIGEST_LENGTH], char hex[2 * RC_SHA256_DIGEST_LENGTH + 1]) {
+    for (int i = 0; i < RC_SHA256_DIGEST_LENGTH; i++) {
+        snprintf(hex + 2 * i, 3, "%02x", digest[i]);
+    }
+}
+
+static uint8_t *RCTestRandomBytes(size_t length, uint32_t seed) {
+    uint8_t *bytes = malloc(length + 1);
+    uint32_t state = seed;
+    for (size_t i = 0; i < length; i++) {
+        state = state * 1664525u + 1013904223u;
+        bytes[i] = (uint8_t)(state >> 24);
+    }
+    return bytes;
+}
+
+static void TestNISTVectors(void) {
+    static const struct {
+        const char *message;
+        size_t repeat;
+        const char *digest;
+    } vectors[] = {
+        { "", 1, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+        { "abc", 1, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+        { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+        { "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+          1, "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1" },
+        { "a", 1000000, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+    };
+
+    for (size_t k = 0; k < RC_TEST_KERNEL_COUNT; k++) {
+        if (!RCSHA256SetKernel(kRCTestKernels[k])) {
+            continue;
+        }
+        for (size_t v = 0; v < sizeof(vectors) / sizeof(vectors[0]); v++) {
+            RCSHA256Context context;
+            RCSHA256Init(&context);
+            size_t length = strlen(vectors[v].message);
+            for (size_t r = 0; r < vectors[v].repeat; r++) {
+                RCSHA256Update(&context, vectors[v].message, length);
+            }
+            uint8_t digest[RC_SHA256_DIGEST_LENGTH];
+            RCSHA256Final(&context, digest);
+            char hex[2 * RC_SHA256_DIGEST_LENGTH + 1];
+            RCTestHex(digest, hex);
+            if (strcmp(hex, vectors[v].digest) != 0) {
+                fprintf(stderr, "%s: vector %zu: %s\n", RCSHA256KernelName(kRCTestKernels[k]), v, hex);
+            }
+            RC_TEST_ASSERT(strcmp(hex, vectors[v].digest) == 0);
+        }
+    }
+    RCSHA256SetKernel(RCSHA256KernelAutomatic);
+}
+
+static void TestKernelsAgreeOnEveryLength(void) {
+    const size_t maxLength = 4 * RC_SHA256_BLOCK_LENGTH + 1;
+    uint8_t *bytes = RCTestRandomBytes(maxLength, 7);
+    uint8_t expected[RC_SHA256_DIGEST_LENGTH];
+    uint8_t actual[RC_SHA256_DIGEST_LENGTH];
+
+    for (size_t k = 1; k < RC_TEST_KERNEL_COUNT; k++) {
+        if (!RCSHA256KernelIsAvailable(kRCTestKernels[k])) {
+            continue;
+        }
+        for (size_t length = 0; length <= maxLength; length++) {
+            RCSHA256SetKernel(RCSHA256KernelScalar);
+            RCSHA256(bytes, length, expected);
+            RCSHA256SetKernel(kRCTestKernels[k]);
+            RCSHA256(bytes, length, actual);
+            RC_TEST_ASSERT(memcmp(expected, actual, sizeof(expected)) == 0);
+        }
+    }
+    RCSHA256SetKernel(RCSHA256KernelAutomatic);
+    free(bytes);
+}
+
+static void TestSplitUpdatesMatchOneShot(void) {
+    const size_t length = 1024 * 1024 + 77;
+    uint8_t *bytes = RCTestRandomBytes(length, 11);
+    uint8_t expected[RC_SHA256_DIGEST_LENGTH];
+    RCSHA256SetKernel(RCSHA256KernelScalar);
+    RCSHA256(bytes, length, expected);
+
+    uint32_t state = 3;
+    for (size_t k = 0; k < RC_TEST_KERNEL_COUNT; k++) {
+        if (!RCSHA256SetKernel(kRCTestKernels[k])) {
+            continue;
+        }
+        for (int round = 0; round < 8; round++) {
+            RCSHA256Context context;
+            RCSHA256Init(&context);
+            size_t offset = 0;
+            while (offset < length) {
+                state = state * 1664525u + 1013904223u;
+                // Mostly odd split points, with an occasional large piece.
+                size_t piece = (state >> 8) % ((state & 1) ? 200 : 100000);
+                if (piece > length - offset) {
+                    piece = length - offset;
+                }
+                RCSHA256Update(&context, bytes + offset, piece);
+                offset += piece;
+            }
+            uint8_t actual[RC_SHA256_DIGEST_LENGTH];
+            RCSHA256Final(&context, actual);
+            RC_TEST_ASSERT(memcmp(expected, actual, sizeof(expected)) == 0);
+        }
+    }
+
+    // A context keeps its meaning when the kernel changes mid-stream.
+    RCSHA256Context context;
+    RCSHA256Init(&context);
+    size_t offset = 0;
+    for (size_t k = 0; offset < length; k = (k + 1) % RC_TEST_KERNEL_COUNT) {
+        RCSHA256SetKernel(kRCTestKernels[k]);
+        size_t piece = length - offset < 4099 ? length - offset : 4099;
+        RCSHA256Update(&context, bytes + offset, piece);
+        offset += piece;
+    }
+    uint8_t actual[RC_SHA256_DIGEST_LENGTH];
+    RCSHA256Final(&context, actual);
+    RC_TEST_ASSERT(memcmp(expected, actual, sizeof(expected)) == 0);
+
+    RCSHA256SetKernel(RCSHA256KernelAutomatic);
+    free(bytes);
+}
+
+static void TestUpdateEachMatchesSeparateContexts(void) {
+    const size_t length = 300 * 1024 + 5;
+    uint8_t *prefix = RCTestRandomBytes(37, 19);
+    uint8_t *bytes = RCTestRandomBytes(length, 23);
+
+    // The data hash context already has bytes of earlier representations;
+    // the blob context starts fresh.
+    RCSHA256Context dataHash;
+    RCSHA256Context blob;
+    RCSHA256Init(&dataHash);
+    RCSHA256Init(&blob);
+    RCSHA256Update(&dataHash, prefix, 37);
+    RCSHA256Context *contexts[] = { &dataHash, &blob };
+    RCSHA256UpdateEach(contexts, 2, bytes, length);
+    uint8_t dataHashDigest[RC_SHA256_DIGEST_LENGTH];
+    uint8_t blobDigest[RC_SHA256_DIGEST_LENGTH];
+    RCSHA256Final(&dataHash, dataHashDigest);
+    RCSHA256Final(&blob, blobDigest);
+
+    RCSHA256Context expected;
+    RCSHA256Init(&expected);
+    RCSHA256Update(&expected, prefix, 37);
+    RCSHA256Update(&expected, bytes, length);
+    uint8_t expectedDigest[RC_SHA256_DIGEST_LENGTH];
+    RCSHA256Final(&expected, expectedDigest);
+    RC_TEST_ASSERT(memcmp(expectedDigest, dataHashDigest, sizeof(expectedDigest)) == 0);
+
+    RCSHA256(bytes, length, expectedDigest);
+    RC_TEST_ASSERT(memcmp(expectedDigest, blobDigest, sizeof(expectedDigest)) == 0);
+
+    free(bytes);
+    free(prefix);
+}
+
+static void TestKernelSelection(void) {
+    RC_TEST_ASSERT(RCSHA256KernelIsAvailable(RCSHA256KernelAutomatic));
+    RC_TEST_ASSERT(RCSHA256KernelIsAvailable(RCSHA256KernelScalar));
+
+    RC_TEST_ASSERT(RCSHA256SetKernel(RCSHA256KernelScalar));
+    RC_TEST_ASSERT_EQUAL(RCSHA256KernelScalar, RCSHA256ActiveKernel());
+
+    // Automatic picks a hardware kernel whenever one is available.
+    RC_TEST_ASSERT(RCSHA256SetKernel(RCSHA256KernelAutomatic));
+    RCSHA256Kernel active = RCSHA256ActiveKernel();
+    RC_TEST_ASSERT(active != RCSHA256KernelAutomatic);
+    if (RCSHA256KernelIsAvailable(RCSHA256KernelSHANI) || RCSHA256KernelIsAvailable(RCSHA256KernelARMv8)) {
+        RC_TEST_ASSERT(active != RCSHA256KernelScalar);
+    }
+
+    // An unavailable kernel is refused and leaves the selection alone.
+    for (size_t k = 0; k < RC_TEST_KERNEL_COUNT; k++) {
+        if (!RCSHA256KernelIsAvailable(kRCTestKernels[k])) {
+            RC_TEST_ASSERT(!RCSHA256SetKernel(kRCTestKernels[k]));
+            RC_TEST_ASSERT_EQUAL(active, RCSHA256ActiveKernel());
+        }
+    }
+    printf("     active kernel: %s\n", RCSHA256KernelName(active));
+}
+
+int main(void) {
+    RC_TEST_RUN(TestNISTVectors);
+    RC_TEST_RUN(TestKernelsAgreeOnEveryLength);
+    RC_TEST_RUN(TestSplitUpdatesMatchOneShot);
+    RC_TEST_RUN(TestUpdateEachMatchesSeparateContexts);
+    RC_TEST_RUN(TestKernelSelection);
+    return RC_TEST_FINISH();
+}
@@ -0,0 +1,142 @@
+//
+//  RCSchemaMigrationBenchmark.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Schema v1 -> v2 (data_hash hex TEXT -> 32-byte BLOB) on a synthetic history.
+//
+//  Reports:
+//    - time for the one-transaction table rebuild done by migrateIfNeeded
+//    - database size (page_count * page_size after VACUUM) before and after
+//    - dedup point-lookup latency (the clipItemForDataHash: query) on each key
+//
+//  Usage: RCSchemaMigrationBenchmark [--rows 10000] [--lookups 20000]
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCBenchDatabase.h"
+#include "RCBenchSupport.h"
+
+static const char *const kRCLookupSQL =
+    "SELECT id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code "
+    "FROM clip_items WHERE data_hash = ? LIMIT 1";
+
+static int64_t RCDatabaseBytes(sqlite3 *db) {
+    RCBenchExec(db, "VACUUM");
+    sqlite3_stmt *statement = NULL;
+    int64_t bytes = -1;
+    if (sqlite3_prepare_v2(db, "SELECT page_count * page_size FROM pragma_page_count(), pragma_page_size()",
+                           -1, &statement, NULL) == SQLITE_OK
+        && sqlite3_step(statement) == SQLITE_ROW) {
+        bytes = sqlite3_column_int64(statement, 0);
+    }
+    sqlite3_finalize(statement);
+    return bytes;
+}
+
+static bool RCMeasureLookups(sqlite3 *db, long rows, long lookups, bool binaryKeys, RCBenchSamples *samples) {
+    sqlite3_stmt *statement = NULL;
+    if (sqlite3_prepare_v2(db, kRCLookupSQL, -1, &statement, NULL) != SQLITE_OK) {
+        fprintf(stderr, "lookup prepare failed: %s\n", sqlite3_errmsg(db));
+        return false;
+    }
+
+    long misses = 0;
+    uint64_t state = 0x5EEDull;
+    for (long index = 0; index < lookups; index++) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        uint64_t seed = (state >> 33) % (uint64_t)rows;
+
+        // The API edge still hands over a hex string; v2 decodes it once per lookup.
+        char hex[65];
+        RCBenchHexDigestForSeed(seed, hex);
+        uint64_t start = RCBenchNowNanoseconds();
+        if (binaryKeys) {
+            uint8_t digest[32];
+            RCBenchBytesFromHex(hex, 64, digest);
+            sqlite3_bind_blob(statement, 1, digest, sizeof(digest), SQLITE_TRANSIENT);
+        } else {
+            sqlite3_bind_text(statement, 1, hex, 64, SQLITE_TRANSIENT);
+        }
+        if (sqlite3_step(statement) != SQLITE_ROW) {
+            misses++;
+        }
+        sqlite3_reset(statement);
+        RCBenchSamplesAppend(samples, RCBenchNowNanoseconds() - start);
+    }
+    sqlite3_finalize(statement);
+
+    if (misses > 0) {
+        fprintf(stderr, "%ld lookups missed\n", misses);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    long rows = RCBenchIntegerOption(argc, argv, "--rows", 10000);
+    long lookups = RCBenchIntegerOption(argc, argv, "--lookups", 20000);
+    if (rows < 1) {
+        rows = 1;
+    }
+    if (lookups < 1) {
+        lookups = 1;
+    }
+
+    printf("RCSchemaMigrationBenchmark rows=%ld lookups=%ld sqlite=%s\n", rows, lookups, sqlite3_libversion());
+
+    char *directory = RCBenchCreateScratchDirectory("rc-migration");
+    if (directory == NULL) {
+        return 1;
+    }
+    char *databasePath = RCBenchPathJoin(directory, "revclip.db");
+    int status = 1;
+    RCBenchSamples v1Lookups;
+    RCBenchSamples v2Lookups;
+    RCBenchSamplesInit(&v1Lookups, (size_t)lookups);
+    RCBenchSamplesInit(&v2Lookups, (size_t)lookups);
+
+    sqlite3 *db = RCBenchOpenWriter(databasePath, RCBenchJournalModeWAL);
+    if (db == NULL || !RCBenchCreateSchemaV1(db) || !RCBenchSeedClipItemsV1(db, (int)rows, 1700000000000LL)) {
+        goto cleanup;
+    }
+
+    int64_t bytesBefore = RCDatabaseBytes(db);
+    if (!RCMeasureLookups(db, rows, lookups, false, &v1Lookups)) {
+        goto cleanup;
+    }
+
+    uint64_t start = RCBenchNowNanoseconds();
+    long copied = RCBenchMigrateClipItemsToV2(db);
+    uint64_t elapsed = RCBenchNowNanoseconds() - start;
+    if (copied != rows) {
+        fprintf(stderr, "migration copied %ld of %ld rows\n", copied, rows);
+        goto cleanup;
+    }
+
+    int64_t bytesAfter = RCDatabaseBytes(db);
+    if (!RCMeasureLookups(db, rows, lookups, true, &v2Lookups)) {
+        goto cleanup;
+    }
+
+    printf("%-28s %.1f ms (%ld rows)\n", "v1 -> v2 migration", (double)elapsed / 1e6, copied);
+    printf("%-28s %lld -> %lld bytes (%.1f%%)\n", "database size",
+           (long long)bytesBefore, (long long)bytesAfter,
+           bytesBefore > 0 ? 100.0 * (double)bytesAfter / (double)bytesBefore : 0.0);
+    RCBenchPrintLatencyRow("v1 hex TEXT lookup", &v1Lookups);
+    RCBenchPrintLatencyRow("v2 BLOB lookup", &v2Lookups);
+    status = 0;
+
+cleanup:
+    sqlite3_close(db);
+    RCBenchSamplesFree(&v1Lookups);
+    RCBenchSamplesFree(&v2Lookups);
+    RCBenchRemoveScratchDirectory(directory);
+    free(databasePath);
+    free(directory);
+    return status;
+}
@@ -0,0 +1,269 @@
+//
+//  RCSearchBenchmark.c
+//  Revclip Benchmarks
+//
+//  Ranked, paginated full-text search over a synthetic clip history, using
+//  the same FTS5 schema, normalizer (RCSearchText.c) and SQL as
+//  -[RCDatabaseManager searchClipItemsMatching:limit:offset:].
+//
+//  Clip bodies are drawn from a Zipf-like vocabulary (so "common" terms match
+//  most of the history and stress bm25 + sort) with some Japanese text mixed in.
+//
+//  Usage: RCSearchBenchmark [--rows 10000] [--queries 200] [--page-size 20]
+//                           [--budget-us 5000]
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCBenchDatabase.h"
+#include "RCBenchSupport.h"
+#include "RCSearchText.h"
+
+// Keep in sync with kRCSearchClipItemsSQL in RCDatabaseManager.m.
+static const char *const kRCSearchClipItemsSQL =
+    "SELECT c.id, c.data_path, c.title, c.data_hash, c.primary_type, c.update_time, c.thumbnail_path, c.is_color_code "
+    "FROM clip_search JOIN clip_items AS c ON c.id = clip_search.rowid WHERE clip_search MATCH ? "
+    "ORDER BY clip_search.rank, c.update_time DESC LIMIT ? OFFSET ?";
+
+enum { kRCVocabularySize = 20000 };
+
+static const char *const kRCSyllables[] = {
+    "ka", "ri", "to", "men", "sa", "lo", "ne", "vi", "dor", "pa", "qui", "zen", "bu", "ra", "tel", "mo",
+};
+
+static const char *const kRCJapanesePhrases[] = {
+    "東京タワーの営業時間", "会議の議事録を共有します", "請求書を送付いたします", "パスワードを変更してください",
+    "明日の資料", "新しいプロジェクトの見積もり",
+};
+
+typedef struct {
+    const char *label;
+    const char *query;
+} RCSearchCase;
+
+static uint64_t RCNextRandom(uint64_t *state) {
+    *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+    return *state >> 33;
+}
+
+// Word for vocabulary rank `rank`: base-16 digits spelled with syllables.
+static size_t RCWordForRank(unsigned rank, char *out) {
+    size_t length = 0;
+    unsigned value = rank + 16;
+    while (value > 0) {
+        const char *syllable = kRCSyllables[value % 16];
+        size_t syllableLength = strlen(syllable);
+        memcpy(out + length, syllable, syllableLength);
+        length += syllableLength;
+        value /= 16;
+    }
+    out[length] = '\0';
+    return length;
+}
+
+// Log-uniform rank, i.e. P(rank) ~ 1/rank.
+static unsigned RCZipfRank(uint64_t *state) {
+    double u = (double)(RCNextRandom(state) % 1000000) / 1000000.0;
+    unsigned rank = (unsigned)exp(u * log((double)kRCVocabularySize)) - 1;
+    return rank < kRCVocabularySize ? rank : kRCVocabularySize - 1;
+}
+
+static bool RCSeedSearchIndex(sqlite3 *db, long rows) {
+    sqlite3_stmt *statement = NULL;
+    if (sqlite3_prepare_v2(db, "INSERT INTO clip_search (rowid, body) VALUES (?, rc_search_text(?))",
+                           -1, &statement, NULL) != SQLITE_OK) {
+        fprintf(stderr, "seed prepare failed: %s\n", sqlite3_errmsg(db));
+        return false;
+    }
+    if (!RCBenchExec(db, "BEGIN IMMEDIATE")) {
+        sqlite3_finalize(statement);
+        return false;
+    }
+
+    char *body = malloc(8192);
+    uint64_t state = 0xC11Full;
+    bool succeeded = true;
+    for (long row = 1; row <= rows && succeeded; row++) {
+        size_t length = 0;
+        long words = 8 + (long)(RCNextRandom(&state) % 120);
+        for (long index = 0; index < words; index++) {
+            char word[64];
+            size_t wordLength = RCWordForRank(RCZipfRank(&state), word);
+            memcpy(body + length, word, wordLength);
+            length += wordLength;
+            body[length++] = ' ';
+        }
+        if (row % 5 == 0) {
+            const char *phrase = kRCJapanesePhrases[RCNextRandom(&state) % (sizeof(kRCJapanesePhrases) / sizeof(kRCJapanesePhrases[0]))];
+            size_t phraseLength = strlen(phrase);
+            memcpy(body + length, phrase, phraseLength);
+            length += phraseLength;
+        }
+
+        sqlite3_bind_int64(statement, 1, row);
+        sqlite3_bind_text(statement, 2, body, (int)length, SQLITE_STATIC);
+        if (sqlite3_step(statement) != SQLITE_DONE) {
+            fprintf(stderr, "seed insert failed: %s\n", sqlite3_errmsg(db));
+            succeeded = false;
+        }
+        sqlite3_reset(statement);
+    }
+    free(body);
+    sqlite3_finalize(statement);
+
+    if (!succeeded) {
+        RCBenchExec(db, "ROLLBACK");
+        return false;
+    }
+    return RCBenchExec(db, "COMMIT");
+}
+
+static int RCRunSearchCase(sqlite3 *db, const RCSearchCase *searchCase, long queries, long pageSize, long budgetUs) {
+    char *expression = RCSearchTextCopyMatchExpression(searchCase->query, strlen(searchCase->query));
+    if (expression == NULL) {
+        fprintf(stderr, "no searchable term in %s\n", searchCase->query);
+        return 1;
+    }
+
+    sqlite3_stmt *statement = NULL;
+    if (sqlite3_prepare_v2(db, kRCSearchClipItemsSQL, -1, &statement, NULL) != SQLITE_OK) {
+        fprintf(stderr, "search prepare failed: %s\n", sqlite3_errmsg(db));
+        free(expression);
+        return 1;
+    }
+
+    RCBenchSamples firstPage;
+    RCBenchSamples thirdPage;
+    RCBenchSamplesInit(&firstPage, (size_t)queries);
+    RCBenchSamplesInit(&thirdPage, (size_t)queries);
+    long hits = 0;
+    int status = 0;
+    for (long iteration = 0; iteration < queries * 2 && status == 0; iteration++) {
+        bool isFirstPage = (iteration % 2 == 0);
+        uint64_t start = RCBenchNowNanoseconds();
+        sqlite3_bind_text(statement, 1, expression, -1, SQLITE_STATIC);
+        sqlite3_bind_int64(statement, 2, pageSize);
+        sqlite3_bind_int64(statement, 3, isFirstPage ? 0 : pageSize * 2);
+        long rows = 0;
+        int rc;
+        while ((rc = sqlite3_step(statement)) == SQLITE_ROW) {
+            (void)sqlite3_column_text(statement, 1);
+            (void)sqlite3_column_blob(statement, 3);
+            rows++;
+        }
+        sqlite3_reset(statement);
+        RCBenchSamplesAppend(isFirstPage ? &firstPage : &thirdPage, RCBenchNowNanoseconds() - start);
+        if (rc != SQLITE_DONE) {
+            fprintf(stderr, "search failed: %s\n", sqlite3_errmsg(db));
+            status = 1;
+        }
+        if (isFirstPage) {
+            hits = rows;
+        }
+    }
+
+    if (status == 0) {
+        char label[64];
+        snprintf(label, sizeof(label), "%s p1", searchCase->label);
+        RCBenchPrintLatencyRow(label, &firstPage);
+        snprintf(label, sizeof(label), "%s p3", searchCase->label);
+        RCBenchPrintLatencyRow(label, &thirdPage);
+
+        uint64_t worst = RCBenchSamplesPercentile(&firstPage, 99.0);
+        uint64_t worstThirdPage = RCBenchSamplesPercentile(&thirdPage, 99.0);
+        worst = worst > worstThirdPage ? worst : worstThirdPage;
+        bool withinBudget = worst <= (uint64_t)budgetUs * 1000;
+        printf("%-28s %s  query=%s hits(p1)=%ld\n", "", withinBudget ? "ok  " : "SLOW", expression, hits);
+        if (hits == 0) {
+            fprintf(stderr, "query %s returned no rows\n", expression);
+            status = 1;
+        }
+    }
+
+    RCBenchSamplesFree(&firstPage);
+    RCBenchSamplesFree(&thirdPage);
+    sqlite3_finalize(statement);
+    free(expression);
+    return status;
+}
+
+int main(int argc, char **argv) {
+    long rows = RCBenchIntegerOption(argc, argv, "--rows", 10000);
+    long queries = RCBenchIntegerOption(argc, argv, "--queries", 200);
+    long pageSize = RCBenchIntegerOption(argc, argv, "--page-size", 20);
+    long budgetUs = RCBenchIntegerOption(argc, argv, "--budget-us", 5000);
+    if (rows < 100) {
+        rows = 100;
+    }
+    if (queries < 1) {
+        queries = 1;
+    }
+    if (pageSize < 1) {
+        pageSize = 1;
+    }
+
+    printf("RCSearchBenchmark rows=%ld queries=%ld page-size=%ld budget=%ldus sqlite=%s\n",
+           rows, queries, pageSize, budgetUs, sqlite3_libversion());
+
+    char *directory = RCBenchCreateScratchDirectory("rc-search");
+    if (directory == NULL) {
+        return 1;
+    }
+    char *databasePath = RCBenchPathJoin(directory, "revclip.db");
+    int status = 1;
+
+    sqlite3 *writer = RCBenchOpenWriter(databasePath, RCBenchJournalModeWAL);
+    sqlite3 *reader = NULL;
+    uint64_t start = RCBenchNowNanoseconds();
+    if (writer == NULL
+        || !RCBenchCreateBaseSchema(writer)
+        || !RCBenchSeedClipItems(writer, (int)rows, 1700000000000LL)
+        || !RCSeedSearchIndex(writer, rows)) {
+        goto cleanup;
+    }
+    printf("%-28s %.1f ms\n", "build index", (double)(RCBenchNowNanoseconds() - start) / 1e6);
+
+    // Searches run on the read pool in the app.
+    reader = RCBenchOpenReader(databasePath);
+    if (reader == NULL) {
+        goto cleanup;
+    }
+
+    char commonWord[64];
+    char mediumWord[64];
+    char rareWord[64];
+    char prefix[64];
+    char twoTerms[160];
+    RCWordForRank(0, commonWord);
+    RCWordForRank(40, mediumWord);
+    RCWordForRank(2000, rareWord);
+    RCWordForRank(3, prefix);
+    prefix[3] = '\0';
+    snprintf(twoTerms, sizeof(twoTerms), "%s %s", commonWord, mediumWord);
+
+    const RCSearchCase cases[] = {
+        { "common term", commonWord },
+        { "medium term", mediumWord },
+        { "rare term", rareWord },
+        { "3-char prefix", prefix },
+        { "two terms", twoTerms },
+        { "japanese phrase", "議事録" },
+    };
+    status = 0;
+    for (size_t index = 0; index < sizeof(cases) / sizeof(cases[0]); index++) {
+        status |= RCRunSearchCase(reader, &cases[index], queries, pageSize, budgetUs);
+    }
+
+cleanup:
+    sqlite3_close(reader);
+    sqlite3_close(writer);
+    RCBenchRemoveScratchDirectory(directory);
+    free(databasePath);
+    free(directory);
+    return status;
+}
@@ -0,0 +1,195 @@
+//
+//  RCStatsBenchmark.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Compares counting the history with COUNT(*) against reading the
+//  trigger-maintained clip_stats table (-[RCDatabaseManager clipItemCount] /
+//  clipStatistics), and measures what the stats triggers add to each
+//  insert + delete. Also checks clip_stats against a full GROUP BY.
+//
+//  Usage: RCStatsBenchmark [--rows 9999] [--reads 2000] [--writes 2000]
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCBenchDatabase.h"
+#include "RCBenchSupport.h"
+
+// Keep in sync with kRCSelectClipStatsTotalCountSQL / kRCSelectClipStatsSQL in RCDatabaseManager.m.
+static const char *const kRCCountClipItemsSQL = "SELECT COUNT(*) FROM clip_items";
+static const char *const kRCSelectClipStatsTotalCountSQL = "SELECT COALESCE(SUM(item_count), 0) FROM clip_stats";
+static const char *const kRCSelectClipStatsSQL = "SELECT primary_type, item_count, total_size FROM clip_stats";
+
+static int RCMeasureRead(sqlite3 *db, const char *label, const char *sql, long reads, int64_t *outFirstValue) {
+    sqlite3_stmt *statement = NULL;
+    if (sqlite3_prepare_v2(db, sql, -1, &statement, NULL) != SQLITE_OK) {
+        fprintf(stderr, "prepare failed: %s\n", sqlite3_errmsg(db));
+        return 1;
+    }
+
+    RCBenchSamples samples;
+    RCBenchSamplesInit(&samples, (size_t)reads);
+    int status = 0;
+    for (long iteration = 0; iteration < reads && status == 0; iteration++) {
+        uint64_t start = RCBenchNowNanoseconds();
+        int rc;
+        while ((rc = sqlite3_step(statement)) == SQLITE_ROW) {
+            if (outFirstValue != NULL) {
+                *outFirstValue = sqlite3_column_int64(statement, 0);
+            }
+        }
+        sqlite3_reset(statement);
+        RCBenchSamplesAppend(&samples, RCBenchNowNanoseconds() - start);
+        if (rc != SQLITE_DONE) {
+            fprintf(stderr, "%s failed: %s\n", label, sqlite3_errmsg(db));
+            status = 1;
+        }
+    }
+    if (status == 0) {
+        RCBenchPrintLatencyRow(label, &samples);
+    }
+    RCBenchSamplesFree(&samples);
+    sqlite3_finalize(statement);
+    return status;
+}
+
+// clip_stats must equal the aggregate it replaces.
+static bool RCVerifyClipStats(sqlite3 *db) {
+    sqlite3_stmt *statement = NULL;
+    const char *sql =
+        "SELECT COUNT(*) FROM ("
+        "SELECT coalesce(primary_type, '') AS primary_type, COUNT(*) AS item_count, SUM(data_size) AS total_size FROM clip_items GROUP BY 1 "
+        "EXCEPT SELECT primary_type, item_count, total_size FROM clip_stats) "
+        "UNION ALL SELECT (SELECT COUNT(DISTINCT coalesce(primary_type, '')) FROM clip_items) - (SELECT COUNT(*) FROM clip_stats)";
+    if (sqlite3_prepare_v2(db, sql, -1, &statement, NULL) != SQLITE_OK) {
+        fprintf(stderr, "verify prepare failed: %s\n", sqlite3_errmsg(db));
+        return false;
+    }
+    bool matches = true;
+    while (sqlite3_step(statement) == SQLITE_ROW) {
+        matches = matches && sqlite3_column_int64(statement, 0) == 0;
+    }
+    sqlite3_finalize(statement);
+    if (!matches) {
+        fprintf(stderr, "clip_stats does not match clip_items\n");
+    }
+    return matches;
+}
+
+// Inserts then deletes `writes` rows, one autocommit statement each (the
+// direct-mode insert / per-item delete shape), and returns us per row.
+static double RCMeasureWrites(sqlite3 *db, long writes) {
+    sqlite3_stmt *insert = NULL;
+    sqlite3_stmt *delete = NULL;
+    if (sqlite3_prepare_v2(db,
+                           "INSERT INTO clip_items (data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code, data_size) "
+                           "VALUES ('w.rcclip', 'w', ?, 'public.utf8-plain-text', ?, '', 0, ?)",
+                           -1, &insert, NULL) != SQLITE_OK
+        || sqlite3_prepare_v2(db, "DELETE FROM clip_items WHERE data_hash = ?", -1, &delete, NULL) != SQLITE_OK) {
+        fprintf(stderr, "write prepare failed: %s\n", sqlite3_errmsg(db));
+        sqlite3_finalize(insert);
+        return -1;
+    }
+
+    uint64_t start = RCBenchNowNanoseconds();
+    bool failed = false;
+    for (long index = 0; index < writes && !failed; index++) {
+        uint8_t digest[32];
+        RCBenchDigestForSeed(0xFFFF0000u + (uint64_t)index, digest);
+        sqlite3_bind_blob(insert, 1, digest, sizeof(digest), SQLITE_TRANSIENT);
+        sqlite3_bind_int64(insert, 2, 1800000000000LL + index);
+        sqlite3_bind_int64(insert, 3, 512);
+        failed = sqlite3_step(insert) != SQLITE_DONE;
+        sqlite3_reset(insert);
+
+        sqlite3_bind_blob(delete, 1, digest, sizeof(digest), SQLITE_TRANSIENT);
+        failed = failed || sqlite3_step(delete) != SQLITE_DONE;
+        sqlite3_reset(delete);
+    }
+    uint64_t elapsed = RCBenchNowNanoseconds() - start;
+    if (failed) {
+        fprintf(stderr, "write failed: %s\n", sqlite3_errmsg(db));
+    }
+    sqlite3_finalize(insert);
+    sqlite3_finalize(delete);
+    return failed ? -1 : (double)elapsed / 1e3 / (double)writes;
+}
+
+int main(int argc, char **argv) {
+    long rows = RCBenchIntegerOption(argc, argv, "--rows", 9999);
+    long reads = RCBenchIntegerOption(argc, argv, "--reads", 2000);
+    long writes = RCBenchIntegerOption(argc, argv, "--writes", 2000);
+    if (rows < 1) {
+        rows = 1;
+    }
+    if (reads < 1) {
+        reads = 1;
+    }
+    if (writes < 1) {
+        writes = 1;
+    }
+
+    printf("RCStatsBenchmark rows=%ld reads=%ld writes=%ld sqlite=%s\n", rows, reads, writes, sqlite3_libversion());
+
+    char *directory = RCBenchCreateScratchDirectory("rc-stats");
+    if (directory == NULL) {
+        return 1;
+    }
+    char *databasePath = RCBenchPathJoin(directory, "revclip.db");
+    sqlite3 *writer = RCBenchOpenWriter(databasePath, RCBenchJournalModeWAL);
+    sqlite3 *reader = NULL;
+    int status = 1;
+    if (writer == NULL
+        || !RCBenchCreateBaseSchema(writer)
+        || !RCBenchSeedClipItems(writer, (int)rows, 1700000000000LL)
+        || !RCVerifyClipStats(writer)) {
+        goto cleanup;
+    }
+
+    reader = RCBenchOpenReader(databasePath);
+    if (reader == NULL) {
+        goto cleanup;
+    }
+    int64_t scannedCount = -1;
+    int64_t statsCount = -1;
+    status = RCMeasureRead(reader, "COUNT(*)", kRCCountClipItemsSQL, reads, &scannedCount);
+    status |= RCMeasureRead(reader, "clip_stats count", kRCSelectClipStatsTotalCountSQL, reads, &statsCount);
+    status |= RCMeasureRead(reader, "clip_stats all", kRCSelectClipStatsSQL, reads, NULL);
+    if (status == 0 && (scannedCount != rows || statsCount != rows)) {
+        fprintf(stderr, "count mismatch: COUNT(*)=%lld clip_stats=%lld\n", (long long)scannedCount, (long long)statsCount);
+        status = 1;
+    }
+    if (status != 0) {
+        goto cleanup;
+    }
+
+    double withTriggers = RCMeasureWrites(writer, writes);
+    if (withTriggers < 0 || !RCVerifyClipStats(writer)) {
+        status = 1;
+        goto cleanup;
+    }
+    if (!RCBenchExec(writer, "DROP TRIGGER clip_items_stats_insert")
+        || !RCBenchExec(writer, "DROP TRIGGER clip_items_stats_delete")) {
+        status = 1;
+        goto cleanup;
+    }
+    double withoutTriggers = RCMeasureWrites(writer, writes);
+    if (withoutTriggers < 0) {
+        status = 1;
+        goto cleanup;
+    }
+    printf("%-28s %8.1f us/row (without stats triggers %.1f us/row)\n",
+           "insert+delete", withTriggers, withoutTriggers);
+
+cleanup:
+    sqlite3_close(reader);
+    sqlite3_close(writer);
+    RCBenchRemoveScratchDirectory(directory);
+    free(databasePath);
+    free(directory);
+    return status;
+}
@@ -0,0 +1,54 @@
+//
+//  RCTestSupport.h
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Minimal assertion macros for the headless unit tests of the portable
+//  core (Revclip/Core). Each test is a `static void Test...(void)`; a failed
+//  assertion reports the location and returns from the test, and main()
+//  exits non-zero if anything failed.
+//
+
+#ifndef RCTestSupport_h
+#define RCTestSupport_h
+
+#include <stdio.h>
+
+static int gRCTestFailureCount = 0;
+static int gRCTestCount = 0;
+
+#define RC_TEST_ASSERT(condition)                                                       \
+    do {                                                                                \
+        if (!(condition)) {                                                             \
+            fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #condition); \
+            gRCTestFailureCount++;                                                      \
+            return;                                                                     \
+        }                                                                               \
+    } while (0)
+
+#define RC_TEST_ASSERT_EQUAL(expected, actual)                                          \
+    do {                                                                                \
+        long long rcExpected = (long long)(expected);                                   \
+        long long rcActual = (long long)(actual);                                       \
+        if (rcExpected != rcActual) {                                                   \
+            fprintf(stderr, "%s:%d: %s == %s failed (%lld != %lld)\n", __FILE__, __LINE__, \
+                    #expected, #actual, rcExpected, rcActual);                          \
+            gRCTestFailureCount++;                                                      \
+            return;                                                                     \
+        }                                                                               \
+    } while (0)
+
+#define RC_TEST_RUN(test)                                                               \
+    do {                                                                                \
+        int rcFailuresBefore = gRCTestFailureCount;                                     \
+        gRCTestCount++;                                                                 \
+        test();                                                                         \
+        printf("%-4s %s\n", gRCTestFailureCount == rcFailuresBefore ? "ok" : "FAIL", #test); \
+    } while (0)
+
+/// Prints the summary line and returns the process exit status.
+#define RC_TEST_FINISH()                                                                \
+    (printf("%d tests, %d failed\n", gRCTestCount, gRCTestFailureCount), gRCTestFailureCount == 0 ? 0 : 1)
+
+#endif /* RCTestSupport_h */
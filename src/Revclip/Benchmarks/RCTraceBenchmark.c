@@ -0,0 +1,159 @@
+//
+//  RCTraceBenchmark.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Cost of one capture latency span (Revclip/Core/RCTrace) as paid by the
+//  instrumented code in RCClipboardService / RCMenuManager.
+//
+//  Reports the best of --iterations runs of --spans spans, in ns of thread
+//  CPU time per span:
+//    - disabled: RCTraceBegin + RCTraceEnd while tracing is off (the cost
+//      every capture pays in a normal build)
+//    - clock read: one RCTraceNowNanoseconds, for reference
+//    - begin/end: two clock reads plus the ring buffer append
+//    - record: RCTraceRecordSpan with caller-supplied times, i.e. the
+//      recorder itself
+//    - record x 4 threads: the same on 4 threads at once, per thread
+//  and the time to dump full buffers as Chrome trace JSON. Fails when the
+//  recorder costs more than --budget-ns (default 50) per span; the clock
+//  reads depend on the platform (a vDSO / commpage read on bare metal, far
+//  slower on some VMs) and are reported rather than budgeted.
+//
+//  Usage: RCTraceBenchmark [--spans 1000000] [--iterations 5] [--budget-ns 50]
+//
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "RCBenchSupport.h"
+#include "RCTrace.h"
+
+#define RC_BENCH_THREAD_COUNT 4
+
+typedef enum {
+    RCTraceModeBeginEnd = 0,
+    RCTraceModeRecord,
+    RCTraceModeClock,
+} RCTraceMode;
+
+typedef struct {
+    RCTraceMode mode;
+    long spans;
+    uint64_t elapsedNanoseconds;
+} RCTraceRun;
+
+// Keeps the clock-read loop from being optimised away.
+static volatile uint64_t gRCClockSink;
+
+// Time slicing on a busy or single-core machine would inflate wall time per
+// thread, so each run measures its own CPU time.
+static uint64_t RCThreadCPUNanoseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static void *RCRunSpans(void *context) {
+    RCTraceRun *run = context;
+    uint64_t start = RCThreadCPUNanoseconds();
+    if (run->mode == RCTraceModeBeginEnd) {
+        for (long i = 0; i < run->spans; i++) {
+            uint64_t begin = RCTraceBegin();
+            RCTraceEnd("span", begin, (uint64_t)i);
+        }
+    } else if (run->mode == RCTraceModeRecord) {
+        for (long i = 0; i < run->spans; i++) {
+            RCTraceRecordSpan("span", start + (uint64_t)i, start + (uint64_t)i + 100, (uint64_t)i);
+        }
+    } else {
+        for (long i = 0; i < run->spans; i++) {
+            gRCClockSink = RCTraceNowNanoseconds();
+        }
+    }
+    run->elapsedNanoseconds = RCThreadCPUNanoseconds() - start;
+    return NULL;
+}
+
+static double RCBestNanosecondsPerSpan(RCTraceMode mode, int threadCount, long spans, long iterations) {
+    double best = 0;
+    for (long iteration = 0; iteration < iterations; iteration++) {
+        pthread_t threads[RC_BENCH_THREAD_COUNT];
+        RCTraceRun runs[RC_BENCH_THREAD_COUNT];
+        for (int i = 0; i < threadCount; i++) {
+            runs[i] = (RCTraceRun){ mode, spans, 0 };
+        }
+        if (threadCount == 1) {
+            RCRunSpans(&runs[0]);
+        } else {
+            for (int i = 0; i < threadCount; i++) {
+                pthread_create(&threads[i], NULL, RCRunSpans, &runs[i]);
+            }
+            for (int i = 0; i < threadCount; i++) {
+                pthread_join(threads[i], NULL);
+            }
+        }
+        uint64_t slowest = 0;
+        for (int i = 0; i < threadCount; i++) {
+            slowest = runs[i].elapsedNanoseconds > slowest ? runs[i].elapsedNanoseconds : slowest;
+        }
+        double perSpan = (double)slowest / (double)spans;
+        best = iteration == 0 || perSpan < best ? perSpan : best;
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    long spans = RCBenchIntegerOption(argc, argv, "--spans", 1000000);
+    long iterations = RCBenchIntegerOption(argc, argv, "--iterations", 5);
+    long budget = RCBenchIntegerOption(argc, argv, "--budget-ns", 50);
+    if (spans < 1) {
+        spans = 1;
+    }
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    printf("RCTraceBenchmark spans=%ld iterations=%ld capacity=%d budget=%ldns\n",
+           spans, iterations, RC_TRACE_BUFFER_CAPACITY, budget);
+
+    RCTraceSetEnabled(false);
+    double disabled = RCBestNanosecondsPerSpan(RCTraceModeBeginEnd, 1, spans, iterations);
+    double clock = RCBestNanosecondsPerSpan(RCTraceModeClock, 1, spans, iterations);
+    RCTraceSetEnabled(true);
+    double beginEnd = RCBestNanosecondsPerSpan(RCTraceModeBeginEnd, 1, spans, iterations);
+    double record = RCBestNanosecondsPerSpan(RCTraceModeRecord, 1, spans, iterations);
+    double threaded = RCBestNanosecondsPerSpan(RCTraceModeRecord, RC_BENCH_THREAD_COUNT, spans, iterations);
+
+    printf("%-28s %8.2f ns/span\n", "disabled", disabled);
+    printf("%-28s %8.2f ns/read\n", "clock read", clock);
+    printf("%-28s %8.2f ns/span\n", "begin/end", beginEnd);
+    printf("%-28s %8.2f ns/span\n", "record", record);
+    printf("%-28s %8.2f ns/span\n", "record x 4 threads", threaded);
+
+    FILE *sink = fopen("/dev/null", "w");
+    if (sink == NULL) {
+        return 1;
+    }
+    size_t spanCount = RCTraceSpanCount();
+    uint64_t start = RCBenchNowNanoseconds();
+    bool written = RCTraceWriteChromeJSON(sink);
+    uint64_t dumpNanoseconds = RCBenchNowNanoseconds() - start;
+    fclose(sink);
+    RCTraceSetEnabled(false);
+    if (!written) {
+        fprintf(stderr, "trace dump failed\n");
+        return 1;
+    }
+    printf("%-28s %.2f ms for %zu spans\n", "chrome json dump", (double)dumpNanoseconds / 1e6, spanCount);
+
+    double worst = record > threaded ? record : threaded;
+    if (worst > (double)budget) {
+        fprintf(stderr, "recorder cost %.2f ns/span exceeds the %ld ns budget\n", worst, budget);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+//
+//  RCTraceReplayBenchmark.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Model add-on for Linux CI: replays clipboard event streams through the
+//  headless capture model (RCBenchCapture: capture -> dedup -> persist ->
+//  index -> cleanup) and compares the result with a stored baseline.
+//  RCBenchCapture is a C re-implementation of the pipeline and shares only
+//  Core/ and the SQLite schema with the app, so it does not execute (or
+//  guard) RCClipboardService / RCDatabaseManager / RCDataCleanService.
+//  It catches regressions in the shared C code, the schema and pragmas, and
+//  the I/O pattern the model mirrors; keep the model in sync by hand.
+//
+//  The app itself is replayed by RevclipTraceReplay (RevclipTraceReplay/),
+//  which runs the same traces, scenarios and baseline format (RCReplayTrace)
+//  against the real classes with an RCInMemoryPasteboard provider.
+//
+//  Built-in scenarios (sized by --scale):
+//
+//    text-bursts   bursts of 5-20 short texts 10-40 ms apart
+//    images        --image-mib TIFF copies, each copied again 30 s later
+//    file-lists    Finder file lists, a fifth of them copied twice in a row
+//    duplicates    a pool of 40 texts copied over and over (limit 30)
+//    idle-expiry   work sessions between 2-5 h idle periods, 1 h expiry
+//
+//  --trace replays a recorded stream instead, in the text format that
+//  --write-trace emits (times in ms from the start, `#` starts a comment):
+//
+//    limit 30
+//    expiry-ms 3600000
+//    1500 copy types=string,rtf bytes=2048 seed=7 app=com.example.editor
+//    1520 copy types=string bytes=12 seed=8 marked
+//    9000 touch
+//    9100 activity
+//
+//  Each scenario runs in a forked child with its own scratch directory, so
+//  peak RSS is per scenario. Reported per scenario: copies per second
+//  (wall time), p50 / p99 capture latency, bytes written (.rcclip files plus
+//  SQLite writes), SQLite xSync calls and peak RSS. The end state is checked
+//  with RCBenchCaptureVerify.
+//
+//  --write-baseline stores the metrics; --baseline compares against them and
+//  exits 1 on a regression beyond --tolerance (bytes, fsyncs, RSS) or
+//  --time-tolerance (throughput, latency; -1 reports only) percent.
+//
+//  Usage: RCTraceReplayBenchmark [--scenario all] [--trace path]
+//                                [--scale 1] [--image-mib 20] [--seed 1]
+//                                [--baseline path] [--write-baseline path]
+//                                [--tolerance 10] [--time-tolerance 50]
+//                                [--write-trace path]
+//
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "RCBenchCapture.h"
+#include "RCBenchIOCounters.h"
+#include "RCBenchSupport.h"
+#include "RCReplayTrace.h"
+
+// MARK: - Runs
+
+static void RCReplayRun(const RCReplayTrace *trace, RCReplayResult *result) {
+    memset(result, 0, sizeof(*result));
+    for (size_t index = 0; index < trace->count; index++) {
+        result->copies += trace->events[index].kind == RCReplayEventCopy ? 1 : 0;
+    }
+    char *directory = RCBenchCreateScratchDirectory("rc-trace-replay");
+    if (directory == NULL) {
+        return;
+    }
+    RCBenchPasteboard pasteboard;
+    RCBenchPasteboardInit(&pasteboard);
+    RCBenchCaptureConfiguration configuration = RCBenchCaptureDefaultConfiguration();
+    if (trace->historyLimit >= 0) {
+        configuration.historyLimit = trace->historyLimit;
+    }
+    configuration.expiryNanoseconds = trace->expiryNanoseconds;
+    RCBenchCapture *capture = RCBenchCaptureCreate(directory, &configuration, &pasteboard);
+    if (capture != NULL) {
+        // schema setup is not part of the replay
+        RCBenchIOCountersReset();
+        uint64_t start = RCBenchNowNanoseconds();
+        bool ran = RCBenchCaptureRunScript(capture, trace->events, trace->count);
+        result->elapsedNanoseconds = RCBenchNowNanoseconds() - start;
+
+        RCBenchCaptureCounters counters;
+        RCBenchIOCounters io;
+        RCBenchCaptureGetCounters(capture, &counters);
+        RCBenchIOCountersGet(&io);
+        RCBenchSamples *latencies = RCBenchCaptureLatencies(capture);
+        result->captured = counters.inserted;
+        result->p50Nanoseconds = RCBenchSamplesPercentile(latencies, 50.0);
+        result->p99Nanoseconds = RCBenchSamplesPercentile(latencies, 99.0);
+        result->bytesWritten = counters.clipBytesWritten + io.bytesWritten;
+        result->syncs = io.syncs;
+        result->passed = ran && RCBenchCaptureVerify(capture);
+        if (!ran) {
+            fprintf(stderr, "capture script failed\n");
+        }
+    }
+    RCBenchCaptureDestroy(capture);
+    result->peakResidentBytes = RCBenchPeakResidentBytes();
+    RCBenchRemoveScratchDirectory(directory);
+    free(directory);
+}
+
+/// Builds the trace (scenario index, or the --trace file when `tracePath`
+/// is set) and replays it in a child process.
+static bool RCReplayInChild(size_t scenario, const char *tracePath, const RCReplayOptions *options,
+                            RCReplayResult *outResult, void *context) {
+    (void)context;
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    fflush(stdout);
+    pid_t child = fork();
+    if (child < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (child == 0) {
+        close(fds[0]);
+        RCReplayResult result = { 0 };
+        RCReplayTrace trace;
+        RCReplayTraceInit(&trace);
+        if (RCReplayTraceBuild(scenario, tracePath, options, &trace) && RCBenchIOCountersInstall()) {
+            RCReplayRun(&trace, &result);
+        }
+        RCReplayTraceFree(&trace);
+        ssize_t written = write(fds[1], &result, sizeof(result));
+        _exit(written == (ssize_t)sizeof(result) && result.passed ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t received = 0;
+    while (received < (ssize_t)sizeof(*outResult)) {
+        ssize_t chunk = read(fds[0], (char *)outResult + received, sizeof(*outResult) - (size_t)received);
+        if (chunk <= 0) {
+            break;
+        }
+        received += chunk;
+    }
+    close(fds[0]);
+    int status = 0;
+    while (waitpid(child, &status, 0) < 0 && errno == EINTR) {
+    }
+    return received == (ssize_t)sizeof(*outResult) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// MARK: - Main
+
+int main(int argc, char **argv) {
+    RCReplayDriver driver = {
+        .name = "RCTraceReplayBenchmark",
+        .pipeline = NULL,
+        .replay = RCReplayInChild,
+    };
+    return RCReplayMain(argc, argv, &driver);
+}
@@ -0,0 +1,240 @@
+//
+//  RCTraceTests.c
+//  Revclip Benchmarks
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Unit tests for the capture latency span recorder (Revclip/Core/RCTrace):
+//  nothing is recorded while disabled, a thread's ring buffer keeps its last
+//  RC_TRACE_BUFFER_CAPACITY spans in order, a dump taken while other threads
+//  record never yields a torn span, buffers of exited threads are reused,
+//  and the Chrome trace JSON is well formed (escaped names, async begin / end
+//  pairs, balanced).
+//
+//  Usage: RCTraceTests
+//
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RCTestSupport.h"
+#include "RCTrace.h"
+
+// Dumps the recorder into a heap string. Caller frees.
+static char *RCDumpTrace(void) {
+    FILE *file = tmpfile();
+    if (file == NULL) {
+        return NULL;
+    }
+    char *json = NULL;
+    if (RCTraceWriteChromeJSON(file)) {
+        long length = ftell(file);
+        rewind(file);
+        json = calloc(1, (size_t)length + 1);
+        if (json != NULL && fread(json, 1, (size_t)length, file) != (size_t)length) {
+            free(json);
+            json = NULL;
+        }
+    }
+    fclose(file);
+    return json;
+}
+
+static size_t RCCountOccurrences(const char *haystack, const char *needle) {
+    size_t count = 0;
+    for (const char *cursor = strstr(haystack, needle); cursor != NULL; cursor = strstr(cursor + 1, needle)) {
+        count++;
+    }
+    return count;
+}
+
+static long RCOffsetOf(const char *haystack, const char *needle) {
+    const char *match = strstr(haystack, needle);
+    return match != NULL ? (long)(match - haystack) : -1;
+}
+
+// Every span below is recorded with duration == captureId nanoseconds, so a
+// span whose fields come from two different writes shows up as a mismatch.
+static size_t RCCountTornSpans(const char *json) {
+    size_t torn = 0;
+    for (const char *cursor = strstr(json, "\"dur\":"); cursor != NULL; cursor = strstr(cursor + 1, "\"dur\":")) {
+        double durationMicroseconds = 0;
+        unsigned long long capture = 0;
+        if (sscanf(cursor, "\"dur\":%lf,\"args\":{\"capture\":%llu}", &durationMicroseconds, &capture) != 2) {
+            continue;
+        }
+        unsigned long long duration = (unsigned long long)(durationMicroseconds * 1000.0 + 0.5);
+        torn += duration != capture ? 1 : 0;
+    }
+    return torn;
+}
+
+static void TestDisabledRecordsNothing(void) {
+    RCTraceSetEnabled(false);
+    RCTraceReset();
+    RC_TEST_ASSERT_EQUAL(0, RCTraceBegin());
+    RCTraceEnd("ignored", RCTraceBegin(), 1);
+    uint64_t now = RCTraceNowNanoseconds();
+    RCTraceRecordSpan("ignored", now, now + 10, 1);
+    RC_TEST_ASSERT_EQUAL(0, RCTraceSpanCount());
+
+    RCTraceSetEnabled(true);
+    RC_TEST_ASSERT(RCTraceBegin() != 0);
+    RCTraceRecordSpan("zero start", 0, now, 1);
+    RC_TEST_ASSERT_EQUAL(0, RCTraceSpanCount());
+    RCTraceSetEnabled(false);
+}
+
+static void TestRingKeepsLatestSpansInOrder(void) {
+    RCTraceSetEnabled(true);
+    RCTraceReset();
+    uint64_t base = RCTraceNowNanoseconds();
+    const uint64_t total = RC_TRACE_BUFFER_CAPACITY + 100;
+    for (uint64_t i = 1; i <= total; i++) {
+        RCTraceRecordSpan("span", base + i, base + i + i, i);
+    }
+    RC_TEST_ASSERT_EQUAL(RC_TRACE_BUFFER_CAPACITY, RCTraceSpanCount());
+
+    char *json = RCDumpTrace();
+    RC_TEST_ASSERT(json != NULL);
+    size_t spans = RCCountOccurrences(json, "\"ph\":\"X\"");
+    long oldest = RCOffsetOf(json, "\"capture\":101}");
+    long newest = RCOffsetOf(json, "\"capture\":4196}");
+    bool evicted = RCOffsetOf(json, "\"capture\":100}") >= 0;
+    size_t torn = RCCountTornSpans(json);
+    free(json);
+    RC_TEST_ASSERT_EQUAL(RC_TRACE_BUFFER_CAPACITY, spans);
+    RC_TEST_ASSERT(oldest >= 0 && oldest < newest);
+    RC_TEST_ASSERT(!evicted);
+    RC_TEST_ASSERT_EQUAL(0, torn);
+
+    RCTraceReset();
+    RC_TEST_ASSERT_EQUAL(0, RCTraceSpanCount());
+    RCTraceEnd("after reset", RCTraceBegin(), 0);
+    RC_TEST_ASSERT_EQUAL(1, RCTraceSpanCount());
+    RCTraceSetEnabled(false);
+}
+
+// MARK: Threads
+
+#define RC_WRITER_COUNT 4
+#define RC_WRITER_SPANS 200000
+
+typedef struct {
+    int index;
+} RCWriter;
+
+static void *RCWriterMain(void *context) {
+    RCWriter *writer = context;
+    char name[32];
+    snprintf(name, sizeof(name), "writer %d", writer->index);
+    RCTraceSetCurrentThreadName(name);
+    for (uint64_t i = 1; i <= RC_WRITER_SPANS; i++) {
+        uint64_t capture = (uint64_t)writer->index * 1000000 + i;
+        uint64_t start = RCTraceNowNanoseconds();
+        RCTraceRecordSpan("write", start, start + capture, capture);
+    }
+    return NULL;
+}
+
+static void TestConcurrentDumpNeverTearsSpans(void) {
+    RCTraceSetEnabled(true);
+    RCTraceReset();
+    pthread_t threads[RC_WRITER_COUNT];
+    RCWriter writers[RC_WRITER_COUNT];
+    for (int i = 0; i < RC_WRITER_COUNT; i++) {
+        writers[i].index = i + 1;
+        RC_TEST_ASSERT_EQUAL(0, pthread_create(&threads[i], NULL, RCWriterMain, &writers[i]));
+    }
+
+    size_t dumps = 0;
+    size_t torn = 0;
+    bool valid = true;
+    for (; dumps < 20; dumps++) {
+        char *json = RCDumpTrace();
+        if (json == NULL) {
+            valid = false;
+            break;
+        }
+        torn += RCCountTornSpans(json);
+        free(json);
+    }
+    for (int i = 0; i < RC_WRITER_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    RC_TEST_ASSERT(valid);
+    RC_TEST_ASSERT_EQUAL(0, torn);
+    RC_TEST_ASSERT_EQUAL(RC_WRITER_COUNT * RC_TRACE_BUFFER_CAPACITY, RCTraceSpanCount());
+    RCTraceSetEnabled(false);
+}
+
+static void *RCOneSpanMain(void *context) {
+    (void)context;
+    RCTraceEnd("once", RCTraceBegin(), 7);
+    return NULL;
+}
+
+static void TestExitedThreadBufferIsReused(void) {
+    RCTraceSetEnabled(true);
+    RCTraceReset();
+    for (int i = 0; i < 10; i++) {
+        pthread_t thread;
+        RC_TEST_ASSERT_EQUAL(0, pthread_create(&thread, NULL, RCOneSpanMain, NULL));
+        pthread_join(thread, NULL);
+    }
+    char *json = RCDumpTrace();
+    RC_TEST_ASSERT(json != NULL);
+    size_t lanes = RCCountOccurrences(json, "\"thread_name\"");
+    size_t spans = RCCountOccurrences(json, "\"name\":\"once\"");
+    free(json);
+    RC_TEST_ASSERT_EQUAL(1, lanes);
+    RC_TEST_ASSERT_EQUAL(10, spans);
+    RCTraceSetEnabled(false);
+}
+
+static void TestChromeJSONShape(void) {
+    RCTraceSetEnabled(true);
+    RCTraceReset();
+    RCTraceSetCurrentThreadName("main \"queue\"\\1");
+    uint64_t start = RCTraceNowNanoseconds();
+    RCTraceRecordSpan("poll", start, start + 1500, 0);
+    RCTraceRecordSpan("persist", start + 2000, start + 2000 + 250000, 42);
+    RCTraceRecordAsyncSpan("capture", start, start + 300000, 42);
+
+    char *json = RCDumpTrace();
+    RC_TEST_ASSERT(json != NULL);
+    bool prefix = strncmp(json, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[{\"ph\":\"M\"", 47) == 0;
+    bool suffix = strlen(json) >= 3 && strcmp(json + strlen(json) - 3, "]}\n") == 0;
+    bool escaped = strstr(json, "\"args\":{\"name\":\"main \\\"queue\\\"\\\\1\"}") != NULL;
+    bool anonymous = strstr(json, "\"name\":\"poll\",\"pid\":1") != NULL && strstr(json, "\"dur\":1.500}") != NULL;
+    bool tagged = strstr(json, "\"dur\":250.000,\"args\":{\"capture\":42}}") != NULL;
+    long asyncBegin = RCOffsetOf(json, "{\"ph\":\"b\",\"cat\":\"capture\",\"id\":42,\"name\":\"capture\"");
+    long asyncEnd = RCOffsetOf(json, "{\"ph\":\"e\",\"cat\":\"capture\",\"id\":42,\"name\":\"capture\"");
+    long depth = 0;
+    long minimumDepth = 0;
+    for (const char *cursor = json; *cursor != '\0'; cursor++) {
+        depth += (*cursor == '{' || *cursor == '[') ? 1 : (*cursor == '}' || *cursor == ']') ? -1 : 0;
+        minimumDepth = depth < minimumDepth ? depth : minimumDepth;
+    }
+    free(json);
+    RC_TEST_ASSERT(prefix);
+    RC_TEST_ASSERT(suffix);
+    RC_TEST_ASSERT(escaped);
+    RC_TEST_ASSERT(anonymous);
+    RC_TEST_ASSERT(tagged);
+    RC_TEST_ASSERT(asyncBegin >= 0 && asyncBegin < asyncEnd);
+    RC_TEST_ASSERT_EQUAL(0, depth);
+    RC_TEST_ASSERT_EQUAL(0, minimumDepth);
+    RCTraceSetEnabled(false);
+}
+
+int main(void) {
+    RC_TEST_RUN(TestDisabledRecordsNothing);
+    RC_TEST_RUN(TestRingKeepsLatestSpansInOrder);
+    RC_TEST_RUN(TestConcurrentDumpNeverTearsSpans);
+    RC_TEST_RUN(TestExitedThreadBufferIsReused);
+    RC_TEST_RUN(TestChromeJSONShape);
+    return RC_TEST_FINISH();
+}
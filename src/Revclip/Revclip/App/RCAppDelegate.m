@@ -109,6 +109,7 @@ static UTType *RCSnippetImportExportContentType(void) {
     [[RCDataCleanService shared] stopCleanupTimer];
     [[RCClipboardService shared] stopMonitoring];
     [[RCHotKeyService shared] unregisterAllHotKeys];
+    [[RCDatabaseManager shared] flushPendingWrites];
 
     // Nil out environment properties to break retain cycles
     RCEnvironment *environment = [RCEnvironment shared];
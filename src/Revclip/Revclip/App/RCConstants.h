@@ -21,6 +21,7 @@ extern NSString * const kRCPrefAutoExpiryEnabledKey;           // Default: NO
 extern NSString * const kRCPrefAutoExpiryValueKey;             // Default: 30
 extern NSString * const kRCPrefAutoExpiryUnitKey;              // Default: 0 (day)
 extern NSString * const kRCPrefMaxClipSizeBytesKey;            // Default: 52428800 (50MB)
+extern NSString * const kRCPrefCompressClipDataKey;            // Default: YES
 extern NSString * const kRCPrefInputPasteCommandKey;           // Default: YES
 extern NSString * const kRCPrefReorderClipsAfterPasting;       // Default: YES
 extern NSString * const kRCPrefShowStatusItemKey;              // Default: 1 (black)
@@ -48,6 +49,7 @@ extern NSString * const kRCThumbnailWidthKey;                      // Default: 1
 extern NSString * const kRCThumbnailHeightKey;                     // Default: 32
 extern NSString * const kRCPrefAddClearHistoryMenuItemKey;         // Default: YES
 extern NSString * const kRCPrefShowAlertBeforeClearHistoryKey;     // Default: YES
+extern NSString * const kRCPrefShowDebugMenuKey;                   // Default: NO (no UI; defaults write)
 
 // Shortcuts
 extern NSString * const kRCHotKeyMainKeyCombo;
@@ -13,6 +13,7 @@ NSString * const kRCPrefAutoExpiryEnabledKey = @"kRCPrefAutoExpiryEnabledKey";
 NSString * const kRCPrefAutoExpiryValueKey = @"kRCPrefAutoExpiryValueKey";
 NSString * const kRCPrefAutoExpiryUnitKey = @"kRCPrefAutoExpiryUnitKey";
 NSString * const kRCPrefMaxClipSizeBytesKey = @"kRCPrefMaxClipSizeBytesKey";
+NSString * const kRCPrefCompressClipDataKey = @"kRCPrefCompressClipDataKey";
 NSString * const kRCPrefInputPasteCommandKey = @"kRCPrefInputPasteCommandKey";
 NSString * const kRCPrefReorderClipsAfterPasting = @"kRCPrefReorderClipsAfterPasting";
 NSString * const kRCPrefShowStatusItemKey = @"kRCPrefShowStatusItemKey";
@@ -40,6 +41,7 @@ NSString * const kRCThumbnailWidthKey = @"kRCThumbnailWidthKey";
 NSString * const kRCThumbnailHeightKey = @"kRCThumbnailHeightKey";
 NSString * const kRCPrefAddClearHistoryMenuItemKey = @"kRCPrefAddClearHistoryMenuItemKey";
 NSString * const kRCPrefShowAlertBeforeClearHistoryKey = @"kRCPrefShowAlertBeforeClearHistoryKey";
+NSString * const kRCPrefShowDebugMenuKey = @"kRCPrefShowDebugMenuKey";
 
 // Shortcuts
 NSString * const kRCHotKeyMainKeyCombo = @"kRCHotKeyMainKeyCombo";
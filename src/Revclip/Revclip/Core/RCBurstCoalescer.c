@@ -0,0 +1,136 @@
+//
+//  RCBurstCoalescer.c
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCBurstCoalescer.h"
+
+#include <string.h>
+
+// MARK: Private
+
+static void RCBurstCoalescerRemoveHeld(RCBurstCoalescer *coalescer, size_t index) {
+    memmove(&coalescer->held[index], &coalescer->held[index + 1],
+            (coalescer->heldCount - index - 1) * sizeof(RCBurstCoalescerEntry));
+    coalescer->heldCount--;
+}
+
+static size_t RCBurstCoalescerRelease(RCBurstCoalescer *coalescer, void **outItems) {
+    size_t count = coalescer->heldCount;
+    for (size_t i = 0; i < count; i++) {
+        outItems[i] = coalescer->held[i].item;
+    }
+    coalescer->heldCount = 0;
+    coalescer->inBurst = false;
+    coalescer->closeRun = 0;
+    return count;
+}
+
+// MARK: Public
+
+RCBurstCoalescerConfiguration RCBurstCoalescerDefaultConfiguration(void) {
+    RCBurstCoalescerConfiguration configuration = {
+        .burstGapNanoseconds = 250000000ULL,
+        .burstThreshold = 3,
+        .settleNanoseconds = 500000000ULL,
+        .keepCount = 1,
+    };
+    return configuration;
+}
+
+void RCBurstCoalescerInit(RCBurstCoalescer *coalescer, const RCBurstCoalescerConfiguration *configuration) {
+    memset(coalescer, 0, sizeof(*coalescer));
+    coalescer->configuration = *configuration;
+    if (coalescer->configuration.burstThreshold < 2) {
+        coalescer->configuration.burstThreshold = 2;
+    }
+    if (coalescer->configuration.keepCount < 1) {
+        coalescer->configuration.keepCount = 1;
+    }
+    if (coalescer->configuration.keepCount > RC_BURST_COALESCER_MAX_KEEP) {
+        coalescer->configuration.keepCount = RC_BURST_COALESCER_MAX_KEEP;
+    }
+}
+
+RCBurstDecision RCBurstCoalescerOffer(RCBurstCoalescer *coalescer,
+                                      uint64_t now,
+                                      uint64_t key,
+                                      void *item,
+                                      void **outDropped) {
+    *outDropped = NULL;
+    bool close = coalescer->hasChange && now - coalescer->lastChangeNanoseconds <= coalescer->configuration.burstGapNanoseconds;
+    coalescer->closeRun = close ? coalescer->closeRun + 1 : 1;
+    coalescer->lastChangeNanoseconds = now;
+    coalescer->hasChange = true;
+
+    if (!coalescer->inBurst) {
+        if (coalescer->closeRun < coalescer->configuration.burstThreshold) {
+            return RCBurstDecisionPass;
+        }
+        coalescer->inBurst = true;
+        coalescer->burstCount++;
+    }
+
+    for (size_t i = 0; i < coalescer->heldCount; i++) {
+        if (coalescer->held[i].key == key) {
+            *outDropped = coalescer->held[i].item;
+            RCBurstCoalescerRemoveHeld(coalescer, i);
+            break;
+        }
+    }
+    if (*outDropped == NULL && coalescer->heldCount == coalescer->configuration.keepCount) {
+        *outDropped = coalescer->held[0].item;
+        RCBurstCoalescerRemoveHeld(coalescer, 0);
+    }
+    if (*outDropped != NULL) {
+        coalescer->droppedStateCount++;
+    }
+    coalescer->held[coalescer->heldCount].key = key;
+    coalescer->held[coalescer->heldCount].item = item;
+    coalescer->heldCount++;
+    return RCBurstDecisionHold;
+}
+
+size_t RCBurstCoalescerSettle(RCBurstCoalescer *coalescer, uint64_t now, void **outItems) {
+    if (!coalescer->inBurst || now - coalescer->lastChangeNanoseconds < coalescer->configuration.settleNanoseconds) {
+        return 0;
+    }
+    return RCBurstCoalescerRelease(coalescer, outItems);
+}
+
+size_t RCBurstCoalescerFlush(RCBurstCoalescer *coalescer, void **outItems) {
+    if (!coalescer->inBurst) {
+        return 0;
+    }
+    return RCBurstCoalescerRelease(coalescer, outItems);
+}
+
+uint64_t RCBurstCoalescerSettleDeadline(const RCBurstCoalescer *coalescer) {
+    if (!coalescer->inBurst) {
+        return 0;
+    }
+    return coalescer->lastChangeNanoseconds + coalescer->configuration.settleNanoseconds;
+}
+
+bool RCBurstCoalescerIsInBurst(const RCBurstCoalescer *coalescer) {
+    return coalescer->inBurst;
+}
+
+size_t RCBurstCoalescerHeldCount(const RCBurstCoalescer *coalescer) {
+    return coalescer->heldCount;
+}
+
+uint64_t RCBurstCoalescerBurstCount(const RCBurstCoalescer *coalescer) {
+    return coalescer->burstCount;
+}
+
+uint64_t RCBurstCoalescerDroppedStateCount(const RCBurstCoalescer *coalescer) {
+    return coalescer->droppedStateCount;
+}
+
+void RCBurstCoalescerResetCounters(RCBurstCoalescer *coalescer) {
+    coalescer->burstCount = 0;
+    coalescer->droppedStateCount = 0;
+}
@@ -0,0 +1,119 @@
+//
+//  RCBurstCoalescer.h
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Collapses bursts of pasteboard changes (a script, terminal tool or
+//  automation copying in a tight loop) so the history keeps only their last
+//  states instead of capturing, cleaning up and rebuilding the menu for each:
+//
+//    pass     changes further apart than burstGap are handed straight back
+//             to the caller and captured as before
+//    burst    once burstThreshold changes in a row are each within burstGap
+//             of the previous one, further changes are held in a window of
+//             the last keepCount distinct states; older states and repeats
+//             of a held state are dropped and counted
+//    settle   after settleInterval without a change the held states are
+//             released, oldest first, and the coalescer returns to pass
+//
+//  The first burstThreshold - 1 changes of a burst are passed before the
+//  burst is recognised. Items are opaque to the coalescer; the caller owns
+//  them and releases whatever comes back as dropped. Times are nanoseconds
+//  on a monotonic clock chosen by the caller. Not thread-safe;
+//  RCClipboardService only touches it on its monitoring queue.
+//
+
+#ifndef RCBurstCoalescer_h
+#define RCBurstCoalescer_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RC_BURST_COALESCER_MAX_KEEP 8
+
+typedef struct {
+    /// Changes closer together than this count toward a burst.
+    uint64_t burstGapNanoseconds;
+    /// Consecutive close changes that start a burst (at least 2).
+    uint32_t burstThreshold;
+    /// Quiet time after the last change that ends a burst.
+    uint64_t settleNanoseconds;
+    /// Distinct states released when a burst settles (1 ...
+    /// RC_BURST_COALESCER_MAX_KEEP).
+    uint32_t keepCount;
+} RCBurstCoalescerConfiguration;
+
+typedef struct {
+    uint64_t key;
+    void *item;
+} RCBurstCoalescerEntry;
+
+typedef struct {
+    RCBurstCoalescerConfiguration configuration;
+    bool hasChange;
+    bool inBurst;
+    uint64_t lastChangeNanoseconds;
+    /// Changes in the current run, each within burstGap of the previous.
+    uint32_t closeRun;
+    size_t heldCount;
+    RCBurstCoalescerEntry held[RC_BURST_COALESCER_MAX_KEEP];
+    uint64_t burstCount;
+    uint64_t droppedStateCount;
+} RCBurstCoalescer;
+
+typedef enum {
+    /// Not in a burst: the caller processes the item now.
+    RCBurstDecisionPass = 0,
+    /// The coalescer holds the item until the burst settles.
+    RCBurstDecisionHold,
+} RCBurstDecision;
+
+/// 250 ms gap, 3 changes, 500 ms settle, keep the final state only.
+RCBurstCoalescerConfiguration RCBurstCoalescerDefaultConfiguration(void);
+
+/// Out-of-range values are clamped (threshold to at least 2, keepCount to
+/// 1 ... RC_BURST_COALESCER_MAX_KEEP).
+void RCBurstCoalescerInit(RCBurstCoalescer *coalescer, const RCBurstCoalescerConfiguration *configuration);
+
+/// Records a change seen at `now`. `key` identifies the state cheaply; a
+/// held state with the same key is replaced by the new one. At most one
+/// item leaves the window per call: it is written to `outDropped` (NULL
+/// otherwise) and counted as dropped.
+RCBurstDecision RCBurstCoalescerOffer(RCBurstCoalescer *coalescer,
+                                      uint64_t now,
+                                      uint64_t key,
+                                      void *item,
+                                      void **outDropped);
+
+/// Ends a burst that has been quiet for settleInterval at `now`. Writes the
+/// held items oldest first to `outItems` (room for
+/// RC_BURST_COALESCER_MAX_KEEP) and returns how many; 0 while a burst is
+/// still running or none is active.
+size_t RCBurstCoalescerSettle(RCBurstCoalescer *coalescer, uint64_t now, void **outItems);
+
+/// Like Settle, but ends the burst regardless of time (flush, stop).
+size_t RCBurstCoalescerFlush(RCBurstCoalescer *coalescer, void **outItems);
+
+/// When the current burst settles if no further change arrives; 0 when no
+/// burst is active.
+uint64_t RCBurstCoalescerSettleDeadline(const RCBurstCoalescer *coalescer);
+
+bool RCBurstCoalescerIsInBurst(const RCBurstCoalescer *coalescer);
+size_t RCBurstCoalescerHeldCount(const RCBurstCoalescer *coalescer);
+/// Bursts recognised since Init / ResetCounters.
+uint64_t RCBurstCoalescerBurstCount(const RCBurstCoalescer *coalescer);
+/// Intermediate states dropped since Init / ResetCounters.
+uint64_t RCBurstCoalescerDroppedStateCount(const RCBurstCoalescer *coalescer);
+void RCBurstCoalescerResetCounters(RCBurstCoalescer *coalescer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RCBurstCoalescer_h */
@@ -0,0 +1,71 @@
+//
+//  RCCapturePlan.c
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCCapturePlan.h"
+
+// Cheapest first: strings and lists are small and already resident in the
+// pasteboard server, the document and image types are what can run to
+// megabytes (and TIFF is often converted on demand from PNG).
+static const RCClipRepresentation kRCCaptureReadOrder[RC_CLIP_REPRESENTATION_COUNT] = {
+    RCClipRepresentationString,
+    RCClipRepresentationURL,
+    RCClipRepresentationFiles,
+    RCClipRepresentationRTF,
+    RCClipRepresentationPDF,
+    RCClipRepresentationRTFD,
+    RCClipRepresentationTIFF,
+};
+
+// MARK: Public
+
+RCCapturePlan RCCapturePlanMake(RCClipRepresentationMask enabled, uint64_t maximumPayloadBytes) {
+    RCCapturePlan plan = {
+        .enabled = enabled & RC_CLIP_REPRESENTATION_ALL,
+        .maximumPayloadBytes = maximumPayloadBytes,
+    };
+    return plan;
+}
+
+RCCaptureVerdict RCCapturePlanEvaluate(const RCCapturePlan *plan,
+                                       RCClipRepresentationMask offered,
+                                       bool marked,
+                                       RCClipRepresentationMask *outReadMask) {
+    *outReadMask = 0;
+    if (marked) {
+        return RCCaptureVerdictSkipMarked;
+    }
+    offered &= RC_CLIP_REPRESENTATION_ALL;
+    if (offered == 0) {
+        return RCCaptureVerdictSkipEmpty;
+    }
+    RCClipRepresentationMask readMask = offered & plan->enabled;
+    if (readMask == 0) {
+        return RCCaptureVerdictSkipDisabled;
+    }
+    *outReadMask = readMask;
+    return RCCaptureVerdictRead;
+}
+
+size_t RCCapturePlanReadOrder(RCClipRepresentationMask readMask, RCClipRepresentation *outOrder) {
+    size_t count = 0;
+    for (size_t i = 0; i < RC_CLIP_REPRESENTATION_COUNT; i++) {
+        if (readMask & kRCCaptureReadOrder[i]) {
+            outOrder[count++] = kRCCaptureReadOrder[i];
+        }
+    }
+    return count;
+}
+
+void RCCaptureBudgetInit(RCCaptureBudget *budget, const RCCapturePlan *plan) {
+    budget->maximumBytes = plan->maximumPayloadBytes;
+    budget->usedBytes = 0;
+}
+
+bool RCCaptureBudgetCharge(RCCaptureBudget *budget, uint64_t bytes) {
+    budget->usedBytes = bytes > UINT64_MAX - budget->usedBytes ? UINT64_MAX : budget->usedBytes + bytes;
+    return budget->usedBytes <= budget->maximumBytes;
+}
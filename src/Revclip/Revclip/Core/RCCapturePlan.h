@@ -0,0 +1,98 @@
+//
+//  RCCapturePlan.h
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Decides what a pasteboard snapshot reads before any data is copied.
+//  The plan is built once from the store-type preferences and the clip size
+//  limit; each snapshot then looks only at the offered type list:
+//
+//    - a concealed / transient / auto-generated marker skips the clip
+//    - representations whose store type is disabled are never read, and a
+//      clip that offers nothing enabled is skipped outright
+//    - the rest is read smallest-first while a budget tracks the bytes
+//      copied, so an oversized clip is abandoned after the first
+//      representation that crosses the limit instead of after copying all
+//      of them (NSPasteboard cannot report a size without reading the data)
+//
+//  Portable so the policy is tested on Linux; RCClipData maps pasteboard
+//  types to representation bits and does the reading.
+//
+
+#ifndef RCCapturePlan_h
+#define RCCapturePlan_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// One bit per store type in kRCPrefStoreTypesKey. Files covers both file
+/// names and file URLs.
+enum {
+    RCClipRepresentationString = 1u << 0,
+    RCClipRepresentationRTF = 1u << 1,
+    RCClipRepresentationRTFD = 1u << 2,
+    RCClipRepresentationPDF = 1u << 3,
+    RCClipRepresentationFiles = 1u << 4,
+    RCClipRepresentationURL = 1u << 5,
+    RCClipRepresentationTIFF = 1u << 6,
+};
+#define RC_CLIP_REPRESENTATION_COUNT 7
+#define RC_CLIP_REPRESENTATION_ALL ((RCClipRepresentationMask)((1u << RC_CLIP_REPRESENTATION_COUNT) - 1))
+
+typedef uint32_t RCClipRepresentation;
+typedef uint32_t RCClipRepresentationMask;
+
+typedef enum {
+    RCCaptureVerdictRead = 0,
+    /// A concealed, transient or auto-generated marker type is present.
+    RCCaptureVerdictSkipMarked,
+    /// Only representations whose store type is disabled are offered.
+    RCCaptureVerdictSkipDisabled,
+    /// None of the representations Revclip stores is offered.
+    RCCaptureVerdictSkipEmpty,
+    /// Reading stopped because the copied bytes exceeded the size limit.
+    RCCaptureVerdictSkipOversized,
+} RCCaptureVerdict;
+
+typedef struct {
+    RCClipRepresentationMask enabled;
+    uint64_t maximumPayloadBytes;
+} RCCapturePlan;
+
+typedef struct {
+    uint64_t maximumBytes;
+    uint64_t usedBytes;
+} RCCaptureBudget;
+
+RCCapturePlan RCCapturePlanMake(RCClipRepresentationMask enabled, uint64_t maximumPayloadBytes);
+
+/// Decides from the offered representations alone. On RCCaptureVerdictRead,
+/// `outReadMask` holds the representations to read (offered and enabled);
+/// otherwise it is 0.
+RCCaptureVerdict RCCapturePlanEvaluate(const RCCapturePlan *plan,
+                                       RCClipRepresentationMask offered,
+                                       bool marked,
+                                       RCClipRepresentationMask *outReadMask);
+
+/// Writes the representations of `readMask` in reading order (text and
+/// lists first, then RTF, PDF, RTFD, TIFF) and returns how many were written.
+/// `outOrder` needs room for RC_CLIP_REPRESENTATION_COUNT entries.
+size_t RCCapturePlanReadOrder(RCClipRepresentationMask readMask, RCClipRepresentation *outOrder);
+
+void RCCaptureBudgetInit(RCCaptureBudget *budget, const RCCapturePlan *plan);
+/// Adds the bytes of a representation just read. Returns false once the
+/// total exceeds the plan's limit; the caller stops reading and drops the
+/// clip.
+bool RCCaptureBudgetCharge(RCCaptureBudget *budget, uint64_t bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RCCapturePlan_h */
@@ -0,0 +1,138 @@
+//
+//  RCCaptureSequencer.c
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCCaptureSequencer.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+typedef struct {
+    void *item;
+    bool completed;
+} RCCaptureSequencerSlot;
+
+struct RCCaptureSequencer {
+    pthread_mutex_t lock;
+    pthread_cond_t slotFreed;
+    size_t capacity;
+    // Sequence numbers in [nextRelease, nextSequence) are admitted; the slot
+    // of sequence s is slots[s % capacity].
+    uint64_t nextSequence;
+    uint64_t nextRelease;
+    uint64_t blockedAdmissions;
+    RCCaptureSequencerSlot *slots;
+};
+
+// MARK: Private
+
+static uint64_t RCCaptureSequencerAdmitLocked(RCCaptureSequencer *sequencer) {
+    uint64_t sequence = sequencer->nextSequence++;
+    RCCaptureSequencerSlot *slot = &sequencer->slots[sequence % sequencer->capacity];
+    slot->item = NULL;
+    slot->completed = false;
+    return sequence;
+}
+
+static bool RCCaptureSequencerIsFullLocked(const RCCaptureSequencer *sequencer) {
+    return sequencer->nextSequence - sequencer->nextRelease >= sequencer->capacity;
+}
+
+// MARK: Public
+
+RCCaptureSequencer *RCCaptureSequencerCreate(size_t capacity) {
+    if (capacity == 0) {
+        return NULL;
+    }
+    RCCaptureSequencer *sequencer = calloc(1, sizeof(*sequencer));
+    if (sequencer == NULL) {
+        return NULL;
+    }
+    sequencer->slots = calloc(capacity, sizeof(RCCaptureSequencerSlot));
+    if (sequencer->slots == NULL) {
+        free(sequencer);
+        return NULL;
+    }
+    sequencer->capacity = capacity;
+    pthread_mutex_init(&sequencer->lock, NULL);
+    pthread_cond_init(&sequencer->slotFreed, NULL);
+    return sequencer;
+}
+
+void RCCaptureSequencerDestroy(RCCaptureSequencer *sequencer) {
+    if (sequencer == NULL) {
+        return;
+    }
+    pthread_cond_destroy(&sequencer->slotFreed);
+    pthread_mutex_destroy(&sequencer->lock);
+    free(sequencer->slots);
+    free(sequencer);
+}
+
+uint64_t RCCaptureSequencerAdmit(RCCaptureSequencer *sequencer) {
+    pthread_mutex_lock(&sequencer->lock);
+    if (RCCaptureSequencerIsFullLocked(sequencer)) {
+        sequencer->blockedAdmissions++;
+        do {
+            pthread_cond_wait(&sequencer->slotFreed, &sequencer->lock);
+        } while (RCCaptureSequencerIsFullLocked(sequencer));
+    }
+    uint64_t sequence = RCCaptureSequencerAdmitLocked(sequencer);
+    pthread_mutex_unlock(&sequencer->lock);
+    return sequence;
+}
+
+bool RCCaptureSequencerTryAdmit(RCCaptureSequencer *sequencer, uint64_t *outSequence) {
+    pthread_mutex_lock(&sequencer->lock);
+    bool admitted = !RCCaptureSequencerIsFullLocked(sequencer);
+    if (admitted) {
+        *outSequence = RCCaptureSequencerAdmitLocked(sequencer);
+    }
+    pthread_mutex_unlock(&sequencer->lock);
+    return admitted;
+}
+
+void RCCaptureSequencerComplete(RCCaptureSequencer *sequencer, uint64_t sequence, void *item) {
+    pthread_mutex_lock(&sequencer->lock);
+    if (sequence >= sequencer->nextRelease && sequence < sequencer->nextSequence) {
+        RCCaptureSequencerSlot *slot = &sequencer->slots[sequence % sequencer->capacity];
+        slot->item = item;
+        slot->completed = true;
+    }
+    pthread_mutex_unlock(&sequencer->lock);
+}
+
+bool RCCaptureSequencerTakeNext(RCCaptureSequencer *sequencer, void **outItem) {
+    pthread_mutex_lock(&sequencer->lock);
+    bool taken = false;
+    if (sequencer->nextRelease < sequencer->nextSequence) {
+        RCCaptureSequencerSlot *slot = &sequencer->slots[sequencer->nextRelease % sequencer->capacity];
+        if (slot->completed) {
+            *outItem = slot->item;
+            slot->item = NULL;
+            slot->completed = false;
+            sequencer->nextRelease++;
+            pthread_cond_signal(&sequencer->slotFreed);
+            taken = true;
+        }
+    }
+    pthread_mutex_unlock(&sequencer->lock);
+    return taken;
+}
+
+size_t RCCaptureSequencerInFlightCount(RCCaptureSequencer *sequencer) {
+    pthread_mutex_lock(&sequencer->lock);
+    size_t count = (size_t)(sequencer->nextSequence - sequencer->nextRelease);
+    pthread_mutex_unlock(&sequencer->lock);
+    return count;
+}
+
+uint64_t RCCaptureSequencerBlockedAdmissionCount(RCCaptureSequencer *sequencer) {
+    pthread_mutex_lock(&sequencer->lock);
+    uint64_t count = sequencer->blockedAdmissions;
+    pthread_mutex_unlock(&sequencer->lock);
+    return count;
+}
@@ -0,0 +1,62 @@
+//
+//  RCCaptureSequencer.h
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Bounded admission and in-order release for the capture pipeline's
+//  fingerprint stage. Snapshots are admitted in pasteboard order and handed
+//  to a concurrent worker pool; workers finish in any order, and the
+//  sequencer releases their results strictly in admission order so history
+//  entries keep the order the user copied them in.
+//
+//  At most `capacity` items are between admission and release. Admitting
+//  past that blocks the caller (the monitoring queue), which is how a slow
+//  fingerprint or persist stage pushes back on capture instead of queueing
+//  snapshots without bound. Thread-safe.
+//
+
+#ifndef RCCaptureSequencer_h
+#define RCCaptureSequencer_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct RCCaptureSequencer RCCaptureSequencer;
+
+/// Returns NULL when `capacity` is 0 or the allocation fails.
+RCCaptureSequencer *RCCaptureSequencerCreate(size_t capacity);
+/// Items still held are not freed; callers drain first.
+void RCCaptureSequencerDestroy(RCCaptureSequencer *sequencer);
+
+/// Returns the next sequence number (0, 1, 2, ...), blocking while `capacity`
+/// admitted items have not been taken yet.
+uint64_t RCCaptureSequencerAdmit(RCCaptureSequencer *sequencer);
+/// Non-blocking admission. Returns false when the sequencer is full.
+bool RCCaptureSequencerTryAdmit(RCCaptureSequencer *sequencer, uint64_t *outSequence);
+
+/// Stores the result for an admitted sequence number; `item` may be NULL for
+/// a capture that was filtered out. Every admitted sequence must be completed
+/// exactly once, or the items after it are never released.
+void RCCaptureSequencerComplete(RCCaptureSequencer *sequencer, uint64_t sequence, void *item);
+
+/// Takes the oldest admitted item if it has completed, freeing its admission
+/// slot. Returns false when nothing is admitted or the oldest item is still in
+/// flight. Call it from one serial context so releases are handed on in order.
+bool RCCaptureSequencerTakeNext(RCCaptureSequencer *sequencer, void **outItem);
+
+/// Items admitted but not yet taken.
+size_t RCCaptureSequencerInFlightCount(RCCaptureSequencer *sequencer);
+/// Admissions that had to wait for a free slot.
+uint64_t RCCaptureSequencerBlockedAdmissionCount(RCCaptureSequencer *sequencer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RCCaptureSequencer_h */
@@ -0,0 +1,515 @@
+//
+//  RCClipCompression.c
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCClipCompression.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+// LZ4 block format constants (lz4_Block_format.md).
+#define RC_LZ4_MIN_MATCH 4
+#define RC_LZ4_LAST_LITERALS 5
+// The last match must start at least this many bytes before the end.
+#define RC_LZ4_MATCH_FIND_LIMIT 12
+#define RC_LZ4_MAX_OFFSET 65535
+#define RC_LZ4_MAX_INPUT_LENGTH 0x7E000000u
+#define RC_LZ4_HASH_LOG 14
+// Skip ahead faster through data that does not match (LZ4's acceleration).
+#define RC_LZ4_SKIP_TRIGGER 6
+
+// Largest expansion either stream can encode per input byte (an LZ4 match
+// length byte of 255, deflate's 258-byte match in under two bits), used to
+// reject impossible length prefixes before allocating.
+#define RC_LZ4_MAX_EXPANSION 255
+#define RC_DEFLATE_MAX_EXPANSION 1032
+#define RC_CLIP_COMPRESSION_EXPANSION_SLACK 1024
+
+#define RC_DEFLATE_LEVEL 6
+// zlib counts in uInt; feed larger buffers in pieces.
+#define RC_DEFLATE_CHUNK_LENGTH ((size_t)1 << 30)
+
+// MARK: Byte order
+
+static uint32_t RCRead32(const uint8_t *p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint64_t RCReadLE64(const uint8_t *p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+static void RCWriteLE64(uint8_t *p, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+// MARK: LZ4
+
+size_t RCClipLZ4CompressBound(size_t length) {
+    if (length > RC_LZ4_MAX_INPUT_LENGTH) {
+        return 0;
+    }
+    return length + length / 255 + 16;
+}
+
+static uint32_t RCLZ4Hash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - RC_LZ4_HASH_LOG);
+}
+
+static bool RCLZ4WriteLength(uint8_t **cursor, const uint8_t *end, size_t length) {
+    uint8_t *p = *cursor;
+    while (length >= 255) {
+        if (p >= end) {
+            return false;
+        }
+        *p++ = 255;
+        length -= 255;
+    }
+    if (p >= end) {
+        return false;
+    }
+    *p++ = (uint8_t)length;
+    *cursor = p;
+    return true;
+}
+
+// First position from `p` where `p` and `reference` differ, at most `limit`.
+static const uint8_t *RCLZ4MatchEnd(const uint8_t *p, const uint8_t *reference, const uint8_t *limit) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (limit - p >= 8) {
+        uint64_t a;
+        uint64_t b;
+        memcpy(&a, p, sizeof(a));
+        memcpy(&b, reference, sizeof(b));
+        if (a != b) {
+            return p + (__builtin_ctzll(a ^ b) >> 3);
+        }
+        p += 8;
+        reference += 8;
+    }
+#endif
+    while (p < limit && *p == *reference) {
+        p++;
+        reference++;
+    }
+    return p;
+}
+
+// Emits one sequence; `matchLength` 0 means the final literals-only sequence.
+static bool RCLZ4EmitSequence(uint8_t **cursor,
+                              const uint8_t *end,
+                              const uint8_t *literals,
+                              size_t literalLength,
+                              size_t offset,
+                              size_t matchLength) {
+    uint8_t *p = *cursor;
+    if (p >= end) {
+        return false;
+    }
+    uint8_t *token = p++;
+    *token = (uint8_t)((literalLength >= 15 ? 15 : literalLength) << 4);
+    if (literalLength >= 15 && !RCLZ4WriteLength(&p, end, literalLength - 15)) {
+        return false;
+    }
+    if (literalLength > (size_t)(end - p)) {
+        return false;
+    }
+    memcpy(p, literals, literalLength);
+    p += literalLength;
+
+    if (matchLength > 0) {
+        if (end - p < 2) {
+            return false;
+        }
+        *p++ = (uint8_t)offset;
+        *p++ = (uint8_t)(offset >> 8);
+        size_t code = matchLength - RC_LZ4_MIN_MATCH;
+        *token |= (uint8_t)(code >= 15 ? 15 : code);
+        if (code >= 15 && !RCLZ4WriteLength(&p, end, code - 15)) {
+            return false;
+        }
+    }
+    *cursor = p;
+    return true;
+}
+
+size_t RCClipLZ4Compress(const void *source, size_t length, void *destination, size_t capacity) {
+    if ((source == NULL && length > 0) || destination == NULL || length > RC_LZ4_MAX_INPUT_LENGTH) {
+        return 0;
+    }
+    const uint8_t *base = source;
+    const uint8_t *inputEnd = base + length;
+    const uint8_t *anchor = base;
+    uint8_t *output = destination;
+    const uint8_t *outputEnd = output + capacity;
+
+    if (length > RC_LZ4_MATCH_FIND_LIMIT) {
+        uint32_t *table = calloc((size_t)1 << RC_LZ4_HASH_LOG, sizeof(*table));
+        if (table == NULL) {
+            return 0;
+        }
+        const uint8_t *findLimit = inputEnd - RC_LZ4_MATCH_FIND_LIMIT;
+        const uint8_t *matchLimit = inputEnd - RC_LZ4_LAST_LITERALS;
+        const uint8_t *ip = base + 1;
+        table[RCLZ4Hash(RCRead32(base))] = 0;
+
+        while (ip < findLimit) {
+            uint32_t sequence = RCRead32(ip);
+            uint32_t hash = RCLZ4Hash(sequence);
+            const uint8_t *reference = base + table[hash];
+            table[hash] = (uint32_t)(ip - base);
+            if (reference >= ip || (size_t)(ip - reference) > RC_LZ4_MAX_OFFSET || RCRead32(reference) != sequence) {
+                ip += 1 + ((size_t)(ip - anchor) >> RC_LZ4_SKIP_TRIGGER);
+                continue;
+            }
+
+            while (ip > anchor && reference > base && ip[-1] == reference[-1]) {
+                ip--;
+                reference--;
+            }
+            const uint8_t *matchEnd = RCLZ4MatchEnd(ip + RC_LZ4_MIN_MATCH, reference + RC_LZ4_MIN_MATCH, matchLimit);
+            if (!RCLZ4EmitSequence(&output, outputEnd, anchor, (size_t)(ip - anchor), (size_t)(ip - reference),
+                                   (size_t)(matchEnd - ip))) {
+                free(table);
+                return 0;
+            }
+            ip = matchEnd;
+            anchor = ip;
+            // Index a position inside the match so runs keep chaining.
+            if (ip - 2 > base) {
+                table[RCLZ4Hash(RCRead32(ip - 2))] = (uint32_t)(ip - 2 - base);
+            }
+        }
+        free(table);
+    }
+
+    if (!RCLZ4EmitSequence(&output, outputEnd, anchor, (size_t)(inputEnd - anchor), 0, 0)) {
+        return 0;
+    }
+    return (size_t)(output - (uint8_t *)destination);
+}
+
+static bool RCLZ4ReadLength(const uint8_t **cursor, const uint8_t *end, size_t *length) {
+    const uint8_t *p = *cursor;
+    uint8_t byte;
+    do {
+        if (p >= end || *length > SIZE_MAX - 255) {
+            return false;
+        }
+        byte = *p++;
+        *length += byte;
+    } while (byte == 255);
+    *cursor = p;
+    return true;
+}
+
+bool RCClipLZ4Decompress(const void *source, size_t length, void *destination, size_t destinationLength) {
+    if ((source == NULL && length > 0) || (destination == NULL && destinationLength > 0) || length == 0) {
+        return false;
+    }
+    const uint8_t *ip = source;
+    const uint8_t *inputEnd = ip + length;
+    uint8_t *const outputStart = destination;
+    uint8_t *op = outputStart;
+    uint8_t *const outputEnd = op + destinationLength;
+
+    for (;;) {
+        if (ip >= inputEnd) {
+            return false;
+        }
+        unsigned token = *ip++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !RCLZ4ReadLength(&ip, inputEnd, &literalLength)) {
+            return false;
+        }
+        if (literalLength > (size_t)(inputEnd - ip) || literalLength > (size_t)(outputEnd - op)) {
+            return false;
+        }
+        // Short runs are copied as one fixed 16-byte move when both buffers
+        // have room; the extra bytes are overwritten by what follows.
+        if (literalLength <= 16 && inputEnd - ip >= 16 && outputEnd - op >= 16) {
+            memcpy(op, ip, 16);
+        } else {
+            memcpy(op, ip, literalLength);
+        }
+        op += literalLength;
+        ip += literalLength;
+        if (ip == inputEnd) {
+            return op == outputEnd;
+        }
+
+        if (inputEnd - ip < 2) {
+            return false;
+        }
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - outputStart)) {
+            return false;
+        }
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !RCLZ4ReadLength(&ip, inputEnd, &matchLength)) {
+            return false;
+        }
+        matchLength += RC_LZ4_MIN_MATCH;
+        if (matchLength > (size_t)(outputEnd - op)) {
+            return false;
+        }
+
+        const uint8_t *match = op - offset;
+        uint8_t *matchEnd = op + matchLength;
+        if (offset >= 8 && (size_t)(outputEnd - op) >= matchLength + 8) {
+            // At least a word apart (overlap or not): 8-byte steps, each
+            // reading bytes that are already final.
+            do {
+                memcpy(op, match, 8);
+                op += 8;
+                match += 8;
+            } while (op < matchEnd);
+            op = matchEnd;
+        } else if (offset >= matchLength) {
+            memcpy(op, match, matchLength);
+            op = matchEnd;
+        } else {
+            while (op < matchEnd) {
+                *op++ = *match++;
+            }
+        }
+    }
+}
+
+// MARK: Deflate
+
+size_t RCClipDeflateCompressBound(size_t length) {
+    // compressBound covers the zlib wrapper too, so it bounds raw deflate.
+    return (size_t)compressBound((uLong)length);
+}
+
+size_t RCClipDeflateCompress(const void *source, size_t length, int level, void *destination, size_t capacity) {
+    if ((source == NULL && length > 0) || destination == NULL) {
+        return 0;
+    }
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return 0;
+    }
+
+    const uint8_t *input = source;
+    size_t inputRemaining = length;
+    uint8_t *output = destination;
+    size_t outputRemaining = capacity;
+    int status = Z_OK;
+    while (status == Z_OK) {
+        if (stream.avail_in == 0) {
+            size_t chunk = inputRemaining < RC_DEFLATE_CHUNK_LENGTH ? inputRemaining : RC_DEFLATE_CHUNK_LENGTH;
+            stream.next_in = (Bytef *)input;
+            stream.avail_in = (uInt)chunk;
+            input += chunk;
+            inputRemaining -= chunk;
+        }
+        if (stream.avail_out == 0) {
+            if (outputRemaining == 0) {
+                break;
+            }
+            size_t chunk = outputRemaining < RC_DEFLATE_CHUNK_LENGTH ? outputRemaining : RC_DEFLATE_CHUNK_LENGTH;
+            stream.next_out = output;
+            stream.avail_out = (uInt)chunk;
+            output += chunk;
+            outputRemaining -= chunk;
+        }
+        status = deflate(&stream, inputRemaining == 0 ? Z_FINISH : Z_NO_FLUSH);
+    }
+    size_t written = (size_t)stream.total_out;
+    deflateEnd(&stream);
+    return status == Z_STREAM_END ? written : 0;
+}
+
+bool RCClipDeflateDecompress(const void *source, size_t length, void *destination, size_t destinationLength) {
+    if ((source == NULL && length > 0) || (destination == NULL && destinationLength > 0)) {
+        return false;
+    }
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+        return false;
+    }
+
+    const uint8_t *input = source;
+    size_t inputRemaining = length;
+    uint8_t *output = destination;
+    size_t outputRemaining = destinationLength;
+    // zlib refuses a NULL next_out even when nothing is to be written.
+    uint8_t empty;
+    stream.next_out = destinationLength > 0 ? output : &empty;
+    int status = Z_OK;
+    while (status == Z_OK) {
+        if (stream.avail_in == 0 && inputRemaining > 0) {
+            size_t chunk = inputRemaining < RC_DEFLATE_CHUNK_LENGTH ? inputRemaining : RC_DEFLATE_CHUNK_LENGTH;
+            stream.next_in = (Bytef *)input;
+            stream.avail_in = (uInt)chunk;
+            input += chunk;
+            inputRemaining -= chunk;
+        }
+        if (stream.avail_out == 0 && outputRemaining > 0) {
+            size_t chunk = outputRemaining < RC_DEFLATE_CHUNK_LENGTH ? outputRemaining : RC_DEFLATE_CHUNK_LENGTH;
+            stream.next_out = output;
+            stream.avail_out = (uInt)chunk;
+            output += chunk;
+            outputRemaining -= chunk;
+        }
+        status = inflate(&stream, Z_NO_FLUSH);
+    }
+    // The stream must end exactly at the end of the input and fill the output.
+    bool complete = status == Z_STREAM_END && stream.avail_in == 0 && inputRemaining == 0
+        && (size_t)stream.total_out == destinationLength;
+    inflateEnd(&stream);
+    return complete;
+}
+
+// MARK: Payloads
+
+static bool RCClipCompressionWorthKeeping(size_t compressedLength, size_t length) {
+    return compressedLength > 0
+        && (uint64_t)compressedLength * 100 <= (uint64_t)length * RC_CLIP_COMPRESSION_MAX_PERCENT;
+}
+
+static size_t RCClipCompressionBound(RCClipCodec codec, size_t length) {
+    switch (codec) {
+        case RCClipCodecLZ4:
+            return RCClipLZ4CompressBound(length);
+        case RCClipCodecDeflate:
+            return RCClipDeflateCompressBound(length);
+        default:
+            return 0;
+    }
+}
+
+static size_t RCClipCompressionCompress(RCClipCodec codec, const void *bytes, size_t length,
+                                        void *destination, size_t capacity) {
+    switch (codec) {
+        case RCClipCodecLZ4:
+            return RCClipLZ4Compress(bytes, length, destination, capacity);
+        case RCClipCodecDeflate:
+            return RCClipDeflateCompress(bytes, length, RC_DEFLATE_LEVEL, destination, capacity);
+        default:
+            return 0;
+    }
+}
+
+RCClipCodec RCClipCompressionChooseCodec(const void *bytes, size_t length, RCClipCompressionClass compressionClass) {
+    if (bytes == NULL || length < RC_CLIP_COMPRESSION_MIN_LENGTH) {
+        return RCClipCodecNone;
+    }
+    RCClipCodec codec = compressionClass == RCClipCompressionCold ? RCClipCodecDeflate : RCClipCodecLZ4;
+    size_t sampleLength = length < RC_CLIP_COMPRESSION_SAMPLE_LENGTH ? length : RC_CLIP_COMPRESSION_SAMPLE_LENGTH;
+    const uint8_t *sample = (const uint8_t *)bytes + (length - sampleLength) / 2;
+
+    size_t capacity = RCClipCompressionBound(codec, sampleLength);
+    uint8_t *scratch = capacity > 0 ? malloc(capacity) : NULL;
+    if (scratch == NULL) {
+        return RCClipCodecNone;
+    }
+    size_t compressedLength = RCClipCompressionCompress(codec, sample, sampleLength, scratch, capacity);
+    free(scratch);
+    return RCClipCompressionWorthKeeping(compressedLength, sampleLength) ? codec : RCClipCodecNone;
+}
+
+bool RCClipCompressionEncode(RCClipCodec codec,
+                             const void *bytes,
+                             size_t length,
+                             uint8_t **outPayload,
+                             size_t *outPayloadLength) {
+    if (outPayload == NULL || outPayloadLength == NULL || (bytes == NULL && length > 0)) {
+        return false;
+    }
+    *outPayload = NULL;
+    *outPayloadLength = 0;
+
+    // Only output below the keep threshold is useful, so cap the buffer there
+    // and let the codec fail early on data that does not compress.
+    size_t bound = RCClipCompressionBound(codec, length);
+    size_t capacity = (size_t)((uint64_t)length * RC_CLIP_COMPRESSION_MAX_PERCENT / 100);
+    if (bound == 0 || capacity == 0) {
+        return false;
+    }
+    if (capacity > bound) {
+        capacity = bound;
+    }
+    uint8_t *payload = malloc(RC_CLIP_COMPRESSION_PREFIX_LENGTH + capacity);
+    if (payload == NULL) {
+        return false;
+    }
+    size_t streamLength = RCClipCompressionCompress(codec, bytes, length, payload + RC_CLIP_COMPRESSION_PREFIX_LENGTH,
+                                                    capacity);
+    if (!RCClipCompressionWorthKeeping(streamLength, length)) {
+        free(payload);
+        return false;
+    }
+    RCWriteLE64(payload, (uint64_t)length);
+    *outPayload = payload;
+    *outPayloadLength = RC_CLIP_COMPRESSION_PREFIX_LENGTH + streamLength;
+    return true;
+}
+
+bool RCClipCompressionDecodedLength(RCClipCodec codec,
+                                    const void *payload,
+                                    size_t payloadLength,
+                                    uint64_t *outLength) {
+    if (payload == NULL || outLength == NULL || payloadLength <= RC_CLIP_COMPRESSION_PREFIX_LENGTH) {
+        return false;
+    }
+    uint64_t streamLength = payloadLength - RC_CLIP_COMPRESSION_PREFIX_LENGTH;
+    uint64_t expansion;
+    switch (codec) {
+        case RCClipCodecLZ4:
+            expansion = RC_LZ4_MAX_EXPANSION;
+            break;
+        case RCClipCodecDeflate:
+            expansion = RC_DEFLATE_MAX_EXPANSION;
+            break;
+        default:
+            return false;
+    }
+    uint64_t length = RCReadLE64(payload);
+    if (length > SIZE_MAX || streamLength > (UINT64_MAX - RC_CLIP_COMPRESSION_EXPANSION_SLACK) / expansion
+        || length > streamLength * expansion + RC_CLIP_COMPRESSION_EXPANSION_SLACK) {
+        return false;
+    }
+    *outLength = length;
+    return true;
+}
+
+bool RCClipCompressionDecode(RCClipCodec codec,
+                             const void *payload,
+                             size_t payloadLength,
+                             void *destination,
+                             size_t destinationLength) {
+    uint64_t length = 0;
+    if (!RCClipCompressionDecodedLength(codec, payload, payloadLength, &length) || length != destinationLength) {
+        return false;
+    }
+    const uint8_t *stream = (const uint8_t *)payload + RC_CLIP_COMPRESSION_PREFIX_LENGTH;
+    size_t streamLength = payloadLength - RC_CLIP_COMPRESSION_PREFIX_LENGTH;
+    switch (codec) {
+        case RCClipCodecLZ4:
+            return RCClipLZ4Decompress(stream, streamLength, destination, destinationLength);
+        case RCClipCodecDeflate:
+            return RCClipDeflateDecompress(stream, streamLength, destination, destinationLength);
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,115 @@
+//
+//  RCClipCompression.h
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Codecs for compressed .rcclip sections and blob files, and the policy that
+//  picks one per payload. Two codecs are supported:
+//
+//    LZ4      the LZ4 block format (no frame), for hot payloads read on every
+//             menu rebuild and paste (plain text, RTF, URLs). Decodes at
+//             memory-copy speed.
+//    Deflate  raw deflate (RFC 1951, zlib without header), for cold payloads
+//             that are large and rarely read (TIFF, PDF, RTFD, blobs).
+//
+//  Both are implemented identically on macOS and Linux (LZ4 in-house, deflate
+//  through the system zlib) so files move between the app and the headless
+//  tools unchanged.
+//
+//  A compressed payload is `decodedLength:u64 (little-endian)` followed by
+//  the codec stream.
+//
+
+#ifndef RCClipCompression_h
+#define RCClipCompression_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Codec identifiers. Values are not stored in files (sections carry flags).
+typedef enum {
+    RCClipCodecNone = 0,
+    RCClipCodecLZ4,
+    RCClipCodecDeflate,
+} RCClipCodec;
+
+typedef enum {
+    /// Read often and expected to be fast: favour decode speed (LZ4).
+    RCClipCompressionHot = 0,
+    /// Large and rarely read: favour ratio (deflate).
+    RCClipCompressionCold,
+} RCClipCompressionClass;
+
+/// Payloads shorter than this are always stored raw.
+#define RC_CLIP_COMPRESSION_MIN_LENGTH 512
+/// Bytes probed by RCClipCompressionChooseCodec (taken from the middle of
+/// the payload so file headers do not dominate the estimate).
+#define RC_CLIP_COMPRESSION_SAMPLE_LENGTH (64 * 1024)
+/// Compressed output is kept only when it is at most this percentage of the
+/// input; anything larger is not worth the decode.
+#define RC_CLIP_COMPRESSION_MAX_PERCENT 90
+#define RC_CLIP_COMPRESSION_PREFIX_LENGTH 8
+
+// MARK: Policy
+
+/// Picks the codec for a payload: RCClipCodecNone for short payloads and for
+/// payloads whose sample does not compress below
+/// RC_CLIP_COMPRESSION_MAX_PERCENT with the class's codec.
+RCClipCodec RCClipCompressionChooseCodec(const void *bytes, size_t length, RCClipCompressionClass compressionClass);
+
+// MARK: Payloads
+
+/// Compresses `bytes` with `codec` into a malloc'd payload (length prefix and
+/// stream; caller frees). Returns false when the codec fails or the result is
+/// not below RC_CLIP_COMPRESSION_MAX_PERCENT of the input, in which case the
+/// caller stores the bytes raw.
+bool RCClipCompressionEncode(RCClipCodec codec,
+                             const void *bytes,
+                             size_t length,
+                             uint8_t **outPayload,
+                             size_t *outPayloadLength);
+
+/// Reads the decoded length of a payload. Fails when the prefix is missing or
+/// the length is impossible for the stream's size, so a corrupt prefix never
+/// makes the caller allocate gigabytes.
+bool RCClipCompressionDecodedLength(RCClipCodec codec,
+                                    const void *payload,
+                                    size_t payloadLength,
+                                    uint64_t *outLength);
+
+/// Decodes a payload into `destination`, which must be exactly the decoded
+/// length. Fails on any malformed stream without writing outside
+/// `destination`.
+bool RCClipCompressionDecode(RCClipCodec codec,
+                             const void *payload,
+                             size_t payloadLength,
+                             void *destination,
+                             size_t destinationLength);
+
+// MARK: Raw codecs
+
+/// Upper bound of RCClipLZ4Compress output for `length` input bytes.
+size_t RCClipLZ4CompressBound(size_t length);
+/// LZ4 block compression. Returns the stream length, or 0 when `capacity` is
+/// too small or the input exceeds the block format's limit.
+size_t RCClipLZ4Compress(const void *source, size_t length, void *destination, size_t capacity);
+/// Decodes an LZ4 block that must expand to exactly `destinationLength` bytes.
+bool RCClipLZ4Decompress(const void *source, size_t length, void *destination, size_t destinationLength);
+
+/// Raw deflate at the given zlib level (1-9). Returns the stream length, or
+/// 0 when `capacity` is too small.
+size_t RCClipDeflateCompress(const void *source, size_t length, int level, void *destination, size_t capacity);
+size_t RCClipDeflateCompressBound(size_t length);
+bool RCClipDeflateDecompress(const void *source, size_t length, void *destination, size_t destinationLength);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RCClipCompression_h */
@@ -0,0 +1,672 @@
+//
+//  RCClipContainer.c
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCClipContainer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+// "RCLP" followed by CR LF SUB LF, so text-mode transfers and truncated
+// copies are detected the same way PNG does.
+static const uint8_t kRCClipContainerMagic[RC_CLIP_CONTAINER_MAGIC_LENGTH] = {
+    'R', 'C', 'L', 'P', 0x0D, 0x0A, 0x1A, 0x0A,
+};
+
+#define RC_CLIP_CONTAINER_SECTION_ALIGNMENT 8
+#define RC_CLIP_CONTAINER_PREFIX_MAX_LENGTH \
+    (RC_CLIP_CONTAINER_HEADER_LENGTH + RC_CLIP_CONTAINER_MAX_SECTIONS * RC_CLIP_CONTAINER_TOC_ENTRY_LENGTH)
+
+struct RCClipContainer {
+    const uint8_t *bytes;
+    size_t length;
+    // Non-NULL when the container owns an mmap of the file.
+    void *mapping;
+    size_t mappingLength;
+    const uint8_t *toc;
+    uint32_t sectionCount;
+};
+
+typedef struct {
+    uint32_t type;
+    uint32_t flags;
+    const uint8_t *bytes;
+    size_t length;
+    // List and compressed sections own their encoded bytes; others borrow them.
+    uint8_t *ownedBytes;
+} RCClipContainerWriterSection;
+
+struct RCClipContainerWriter {
+    RCClipContainerWriterSection sections[RC_CLIP_CONTAINER_MAX_SECTIONS];
+    uint32_t sectionCount;
+};
+
+// MARK: Byte order
+
+static uint16_t RCReadLE16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t RCReadLE32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t RCReadLE64(const uint8_t *p) {
+    return (uint64_t)RCReadLE32(p) | ((uint64_t)RCReadLE32(p + 4) << 32);
+}
+
+static void RCWriteLE16(uint8_t *p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static void RCWriteLE32(uint8_t *p, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static void RCWriteLE64(uint8_t *p, uint64_t value) {
+    RCWriteLE32(p, (uint32_t)value);
+    RCWriteLE32(p + 4, (uint32_t)(value >> 32));
+}
+
+// MARK: Checksum
+
+#if !defined(__ARM_FEATURE_CRC32)
+// Slicing-by-8 tables for the reflected Castagnoli polynomial.
+static uint32_t gRCCrc32cTable[8][256];
+static pthread_once_t gRCCrc32cTableOnce = PTHREAD_ONCE_INIT;
+
+static void RCCrc32cBuildTable(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78u : crc >> 1;
+        }
+        gRCCrc32cTable[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = gRCCrc32cTable[0][i];
+        for (int slice = 1; slice < 8; slice++) {
+            crc = gRCCrc32cTable[0][crc & 0xFF] ^ (crc >> 8);
+            gRCCrc32cTable[slice][i] = crc;
+        }
+    }
+}
+#endif
+
+uint32_t RCClipContainerChecksum(uint32_t crc, const void *bytes, size_t length) {
+    const uint8_t *p = bytes;
+    crc = ~crc;
+#if defined(__ARM_FEATURE_CRC32)
+    for (; length >= 8; p += 8, length -= 8) {
+        crc = __crc32cd(crc, RCReadLE64(p));
+    }
+    for (; length > 0; p++, length--) {
+        crc = __crc32cb(crc, *p);
+    }
+#else
+    pthread_once(&gRCCrc32cTableOnce, RCCrc32cBuildTable);
+    for (; length >= 8; p += 8, length -= 8) {
+        uint64_t word = RCReadLE64(p) ^ crc;
+        crc = gRCCrc32cTable[7][word & 0xFF]
+            ^ gRCCrc32cTable[6][(word >> 8) & 0xFF]
+            ^ gRCCrc32cTable[5][(word >> 16) & 0xFF]
+            ^ gRCCrc32cTable[4][(word >> 24) & 0xFF]
+            ^ gRCCrc32cTable[3][(word >> 32) & 0xFF]
+            ^ gRCCrc32cTable[2][(word >> 40) & 0xFF]
+            ^ gRCCrc32cTable[1][(word >> 48) & 0xFF]
+            ^ gRCCrc32cTable[0][word >> 56];
+    }
+    for (; length > 0; p++, length--) {
+        crc = gRCCrc32cTable[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+    }
+#endif
+    return ~crc;
+}
+
+bool RCClipContainerHasMagic(const void *bytes, size_t length) {
+    return bytes != NULL
+        && length >= RC_CLIP_CONTAINER_MAGIC_LENGTH
+        && memcmp(bytes, kRCClipContainerMagic, RC_CLIP_CONTAINER_MAGIC_LENGTH) == 0;
+}
+
+// MARK: Reader
+
+static RCClipContainerStatus RCClipContainerValidate(const uint8_t *bytes, size_t length, uint32_t *outSectionCount,
+                                                     const uint8_t **outToc) {
+    if (!RCClipContainerHasMagic(bytes, length)) {
+        return RCClipContainerNotContainer;
+    }
+    if (length < RC_CLIP_CONTAINER_HEADER_LENGTH) {
+        return RCClipContainerCorrupt;
+    }
+    if (RCReadLE32(bytes + 28) != RCClipContainerChecksum(0, bytes, 28)) {
+        return RCClipContainerChecksumMismatch;
+    }
+
+    uint16_t version = RCReadLE16(bytes + 8);
+    if (version == 0) {
+        return RCClipContainerCorrupt;
+    }
+    if (version > RC_CLIP_CONTAINER_VERSION) {
+        return RCClipContainerUnsupportedVersion;
+    }
+
+    uint64_t headerLength = RCReadLE16(bytes + 10);
+    uint64_t sectionCount = RCReadLE32(bytes + 12);
+    uint64_t fileLength = RCReadLE64(bytes + 16);
+    if (headerLength < RC_CLIP_CONTAINER_HEADER_LENGTH || fileLength != length
+        || sectionCount > RC_CLIP_CONTAINER_MAX_SECTIONS) {
+        return RCClipContainerCorrupt;
+    }
+    uint64_t tocEnd = headerLength + sectionCount * RC_CLIP_CONTAINER_TOC_ENTRY_LENGTH;
+    if (tocEnd > length) {
+        return RCClipContainerCorrupt;
+    }
+    const uint8_t *toc = bytes + headerLength;
+    size_t tocLength = (size_t)(sectionCount * RC_CLIP_CONTAINER_TOC_ENTRY_LENGTH);
+    if (RCReadLE32(bytes + 24) != RCClipContainerChecksum(0, toc, tocLength)) {
+        return RCClipContainerChecksumMismatch;
+    }
+
+    for (uint64_t i = 0; i < sectionCount; i++) {
+        const uint8_t *entry = toc + i * RC_CLIP_CONTAINER_TOC_ENTRY_LENGTH;
+        uint32_t type = RCReadLE32(entry);
+        uint64_t offset = RCReadLE64(entry + 8);
+        uint64_t sectionLength = RCReadLE64(entry + 16);
+        if (type == 0 || RCReadLE32(entry + 28) != 0) {
+            return RCClipContainerCorrupt;
+        }
+        if (offset < tocEnd || offset > length || sectionLength > length - offset) {
+            return RCClipContainerCorrupt;
+        }
+        for (uint64_t j = 0; j < i; j++) {
+            if (RCReadLE32(toc + j * RC_CLIP_CONTAINER_TOC_ENTRY_LENGTH) == type) {
+                return RCClipContainerCorrupt;
+            }
+        }
+    }
+
+    *outSectionCount = (uint32_t)sectionCount;
+    *outToc = toc;
+    return RCClipContainerOK;
+}
+
+RCClipContainerStatus RCClipContainerOpenBytes(const void *bytes, size_t length, RCClipContainer **outContainer) {
+    if (outContainer == NULL) {
+        return RCClipContainerCorrupt;
+    }
+    *outContainer = NULL;
+
+    uint32_t sectionCount = 0;
+    const uint8_t *toc = NULL;
+    RCClipContainerStatus status = RCClipContainerValidate(bytes, length, &sectionCount, &toc);
+    if (status != RCClipContainerOK) {
+        return status;
+    }
+
+    RCClipContainer *container = calloc(1, sizeof(*container));
+    if (container == NULL) {
+        return RCClipContainerNoMemory;
+    }
+    container->bytes = bytes;
+    container->length = length;
+    container->toc = toc;
+    container->sectionCount = sectionCount;
+    *outContainer = container;
+    return RCClipContainerOK;
+}
+
+RCClipContainerStatus RCClipContainerOpenFile(const char *path, RCClipContainer **outContainer) {
+    if (outContainer == NULL) {
+        return RCClipContainerCorrupt;
+    }
+    *outContainer = NULL;
+    if (path == NULL) {
+        return RCClipContainerIOError;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return RCClipContainerIOError;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) {
+        close(fd);
+        return RCClipContainerIOError;
+    }
+    if ((uint64_t)fileStat.st_size < RC_CLIP_CONTAINER_MAGIC_LENGTH || (uint64_t)fileStat.st_size > SIZE_MAX) {
+        close(fd);
+        return RCClipContainerNotContainer;
+    }
+
+    size_t length = (size_t)fileStat.st_size;
+    void *mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return RCClipContainerIOError;
+    }
+
+    RCClipContainerStatus status = RCClipContainerOpenBytes(mapping, length, outContainer);
+    if (status != RCClipContainerOK) {
+        munmap(mapping, length);
+        return status;
+    }
+    (*outContainer)->mapping = mapping;
+    (*outContainer)->mappingLength = length;
+    return RCClipContainerOK;
+}
+
+void RCClipContainerClose(RCClipContainer *container) {
+    if (container == NULL) {
+        return;
+    }
+    if (container->mapping != NULL) {
+        munmap(container->mapping, container->mappingLength);
+    }
+    free(container);
+}
+
+uint32_t RCClipContainerSectionCount(const RCClipContainer *container) {
+    return container != NULL ? container->sectionCount : 0;
+}
+
+RCClipContainerStatus RCClipContainerSectionAtIndex(const RCClipContainer *container,
+                                                    uint32_t index,
+                                                    RCClipSection *outSection) {
+    if (container == NULL || outSection == NULL || index >= container->sectionCount) {
+        return RCClipContainerNotFound;
+    }
+    const uint8_t *entry = container->toc + (size_t)index * RC_CLIP_CONTAINER_TOC_ENTRY_LENGTH;
+    outSection->type = RCReadLE32(entry);
+    outSection->flags = RCReadLE32(entry + 4);
+    outSection->bytes = container->bytes + RCReadLE64(entry + 8);
+    outSection->length = RCReadLE64(entry + 16);
+    outSection->checksum = RCReadLE32(entry + 24);
+    return RCClipContainerOK;
+}
+
+RCClipContainerStatus RCClipContainerVerifySection(const RCClipSection *section) {
+    if (section == NULL) {
+        return RCClipContainerCorrupt;
+    }
+    uint32_t checksum = RCClipContainerChecksum(0, section->bytes, (size_t)section->length);
+    return checksum == section->checksum ? RCClipContainerOK : RCClipContainerChecksumMismatch;
+}
+
+RCClipContainerStatus RCClipContainerFindSection(const RCClipContainer *container,
+                                                 uint32_t type,
+                                                 RCClipSection *outSection) {
+    if (container == NULL || outSection == NULL) {
+        return RCClipContainerNotFound;
+    }
+    for (uint32_t i = 0; i < container->sectionCount; i++) {
+        RCClipSection section;
+        RCClipContainerSectionAtIndex(container, i, &section);
+        if (section.type != type) {
+            continue;
+        }
+        if ((section.flags & ~RC_CLIP_SECTION_KNOWN_FLAGS) != 0) {
+            return RCClipContainerUnsupportedVersion;
+        }
+        // At most one codec, and never on a blob reference (always hex text).
+        uint32_t codecFlags = section.flags & RC_CLIP_SECTION_CODEC_FLAGS;
+        if (codecFlags == RC_CLIP_SECTION_CODEC_FLAGS
+            || (codecFlags != 0 && (section.flags & RC_CLIP_SECTION_FLAG_BLOB_REFERENCE) != 0)) {
+            return RCClipContainerCorrupt;
+        }
+        RCClipContainerStatus status = RCClipContainerVerifySection(&section);
+        if (status != RCClipContainerOK) {
+            return status;
+        }
+        *outSection = section;
+        return RCClipContainerOK;
+    }
+    return RCClipContainerNotFound;
+}
+
+RCClipContainerStatus RCClipSectionNextListItem(const RCClipSection *section,
+                                                uint64_t *cursor,
+                                                const uint8_t **outBytes,
+                                                size_t *outLength) {
+    if (section == NULL || cursor == NULL || outBytes == NULL || outLength == NULL) {
+        return RCClipContainerCorrupt;
+    }
+    uint64_t position = *cursor;
+    if (position == section->length) {
+        return RCClipContainerNotFound;
+    }
+    if (position > section->length || section->length - position < 4) {
+        return RCClipContainerCorrupt;
+    }
+    uint64_t itemLength = RCReadLE32(section->bytes + position);
+    position += 4;
+    if (itemLength > section->length - position) {
+        return RCClipContainerCorrupt;
+    }
+    *outBytes = section->bytes + position;
+    *outLength = (size_t)itemLength;
+    *cursor = position + itemLength;
+    return RCClipContainerOK;
+}
+
+// MARK: Compressed sections
+
+RCClipCodec RCClipSectionCodec(const RCClipSection *section) {
+    if (section == NULL) {
+        return RCClipCodecNone;
+    }
+    if ((section->flags & RC_CLIP_SECTION_FLAG_LZ4) != 0) {
+        return RCClipCodecLZ4;
+    }
+    if ((section->flags & RC_CLIP_SECTION_FLAG_DEFLATE) != 0) {
+        return RCClipCodecDeflate;
+    }
+    return RCClipCodecNone;
+}
+
+uint32_t RCClipSectionFlagsForCodec(RCClipCodec codec) {
+    switch (codec) {
+        case RCClipCodecLZ4:
+            return RC_CLIP_SECTION_FLAG_LZ4;
+        case RCClipCodecDeflate:
+            return RC_CLIP_SECTION_FLAG_DEFLATE;
+        default:
+            return 0;
+    }
+}
+
+RCClipContainerStatus RCClipSectionDecodedLength(const RCClipSection *section, uint64_t *outLength) {
+    if (section == NULL || outLength == NULL) {
+        return RCClipContainerCorrupt;
+    }
+    RCClipCodec codec = RCClipSectionCodec(section);
+    if (codec == RCClipCodecNone) {
+        *outLength = section->length;
+        return RCClipContainerOK;
+    }
+    return RCClipCompressionDecodedLength(codec, section->bytes, (size_t)section->length, outLength)
+        ? RCClipContainerOK
+        : RCClipContainerCorrupt;
+}
+
+RCClipContainerStatus RCClipSectionDecode(const RCClipSection *section, void *destination, size_t destinationLength) {
+    if (section == NULL || (destination == NULL && destinationLength > 0)) {
+        return RCClipContainerCorrupt;
+    }
+    RCClipCodec codec = RCClipSectionCodec(section);
+    if (codec == RCClipCodecNone) {
+        if (section->length != destinationLength) {
+            return RCClipContainerCorrupt;
+        }
+        if (destinationLength > 0) {
+            memcpy(destination, section->bytes, destinationLength);
+        }
+        return RCClipContainerOK;
+    }
+    return RCClipCompressionDecode(codec, section->bytes, (size_t)section->length, destination, destinationLength)
+        ? RCClipContainerOK
+        : RCClipContainerCorrupt;
+}
+
+// MARK: Writer
+
+RCClipContainerWriter *RCClipContainerWriterCreate(void) {
+    return calloc(1, sizeof(RCClipContainerWriter));
+}
+
+void RCClipContainerWriterDestroy(RCClipContainerWriter *writer) {
+    if (writer == NULL) {
+        return;
+    }
+    for (uint32_t i = 0; i < writer->sectionCount; i++) {
+        free(writer->sections[i].ownedBytes);
+    }
+    free(writer);
+}
+
+static RCClipContainerStatus RCClipContainerWriterAppend(RCClipContainerWriter *writer,
+                                                         uint32_t type,
+                                                         uint32_t flags,
+                                                         const uint8_t *bytes,
+                                                         size_t length,
+                                                         uint8_t *ownedBytes) {
+    if (writer == NULL || type == 0 || (bytes == NULL && length > 0)
+        || writer->sectionCount >= RC_CLIP_CONTAINER_MAX_SECTIONS) {
+        free(ownedBytes);
+        return RCClipContainerCorrupt;
+    }
+    for (uint32_t i = 0; i < writer->sectionCount; i++) {
+        if (writer->sections[i].type == type) {
+            free(ownedBytes);
+            return RCClipContainerCorrupt;
+        }
+    }
+    RCClipContainerWriterSection *section = &writer->sections[writer->sectionCount++];
+    section->type = type;
+    section->flags = flags;
+    section->bytes = bytes;
+    section->length = length;
+    section->ownedBytes = ownedBytes;
+    return RCClipContainerOK;
+}
+
+RCClipContainerStatus RCClipContainerWriterAddSection(RCClipContainerWriter *writer,
+                                                      uint32_t type,
+                                                      uint32_t flags,
+                                                      const void *bytes,
+                                                      size_t length) {
+    return RCClipContainerWriterAppend(writer, type, flags, bytes, length, NULL);
+}
+
+RCClipContainerStatus RCClipContainerWriterAddCompressibleSection(RCClipContainerWriter *writer,
+                                                                  uint32_t type,
+                                                                  const void *bytes,
+                                                                  size_t length,
+                                                                  RCClipCompressionClass compressionClass) {
+    RCClipCodec codec = RCClipCompressionChooseCodec(bytes, length, compressionClass);
+    uint8_t *payload = NULL;
+    size_t payloadLength = 0;
+    if (codec == RCClipCodecNone || !RCClipCompressionEncode(codec, bytes, length, &payload, &payloadLength)) {
+        return RCClipContainerWriterAppend(writer, type, 0, bytes, length, NULL);
+    }
+    return RCClipContainerWriterAppend(writer, type, RCClipSectionFlagsForCodec(codec), payload, payloadLength, payload);
+}
+
+RCClipContainerStatus RCClipContainerWriterAddListSection(RCClipContainerWriter *writer,
+                                                          uint32_t type,
+                                                          const char *const *items,
+                                                          const size_t *lengths,
+                                                          size_t count) {
+    if (count > 0 && (items == NULL || lengths == NULL)) {
+        return RCClipContainerCorrupt;
+    }
+    size_t encodedLength = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (lengths[i] > UINT32_MAX || (items[i] == NULL && lengths[i] > 0)
+            || lengths[i] > SIZE_MAX - 4 - encodedLength) {
+            return RCClipContainerCorrupt;
+        }
+        encodedLength += 4 + lengths[i];
+    }
+
+    uint8_t *encoded = malloc(encodedLength > 0 ? encodedLength : 1);
+    if (encoded == NULL) {
+        return RCClipContainerNoMemory;
+    }
+    uint8_t *p = encoded;
+    for (size_t i = 0; i < count; i++) {
+        RCWriteLE32(p, (uint32_t)lengths[i]);
+        if (lengths[i] > 0) {
+            memcpy(p + 4, items[i], lengths[i]);
+        }
+        p += 4 + lengths[i];
+    }
+    return RCClipContainerWriterAppend(writer, type, 0, encoded, encodedLength, encoded);
+}
+
+typedef bool (*RCClipContainerSink)(void *context, const void *bytes, size_t length);
+
+static uint64_t RCClipContainerAlign(uint64_t offset) {
+    return (offset + RC_CLIP_CONTAINER_SECTION_ALIGNMENT - 1) & ~(uint64_t)(RC_CLIP_CONTAINER_SECTION_ALIGNMENT - 1);
+}
+
+// Builds the header and TOC into `prefix` and returns the file length.
+static uint64_t RCClipContainerWriterLayout(const RCClipContainerWriter *writer, uint8_t *prefix, size_t *outPrefixLength) {
+    size_t prefixLength = RC_CLIP_CONTAINER_HEADER_LENGTH
+        + (size_t)writer->sectionCount * RC_CLIP_CONTAINER_TOC_ENTRY_LENGTH;
+    memset(prefix, 0, prefixLength);
+
+    uint64_t offset = prefixLength;
+    for (uint32_t i = 0; i < writer->sectionCount; i++) {
+        const RCClipContainerWriterSection *section = &writer->sections[i];
+        uint8_t *entry = prefix + RC_CLIP_CONTAINER_HEADER_LENGTH + (size_t)i * RC_CLIP_CONTAINER_TOC_ENTRY_LENGTH;
+        offset = RCClipContainerAlign(offset);
+        RCWriteLE32(entry, section->type);
+        RCWriteLE32(entry + 4, section->flags);
+        RCWriteLE64(entry + 8, offset);
+        RCWriteLE64(entry + 16, section->length);
+        RCWriteLE32(entry + 24, RCClipContainerChecksum(0, section->bytes, section->length));
+        offset += section->length;
+    }
+
+    memcpy(prefix, kRCClipContainerMagic, RC_CLIP_CONTAINER_MAGIC_LENGTH);
+    RCWriteLE16(prefix + 8, RC_CLIP_CONTAINER_VERSION);
+    RCWriteLE16(prefix + 10, RC_CLIP_CONTAINER_HEADER_LENGTH);
+    RCWriteLE32(prefix + 12, writer->sectionCount);
+    RCWriteLE64(prefix + 16, offset);
+    RCWriteLE32(prefix + 24, RCClipContainerChecksum(0, prefix + RC_CLIP_CONTAINER_HEADER_LENGTH,
+                                                     prefixLength - RC_CLIP_CONTAINER_HEADER_LENGTH));
+    RCWriteLE32(prefix + 28, RCClipContainerChecksum(0, prefix, 28));
+    *outPrefixLength = prefixLength;
+    return offset;
+}
+
+static bool RCClipContainerWriterEmit(const RCClipContainerWriter *writer,
+                                      const uint8_t *prefix,
+                                      size_t prefixLength,
+                                      RCClipContainerSink sink,
+                                      void *context) {
+    static const uint8_t padding[RC_CLIP_CONTAINER_SECTION_ALIGNMENT] = {0};
+    if (!sink(context, prefix, prefixLength)) {
+        return false;
+    }
+    uint64_t offset = prefixLength;
+    for (uint32_t i = 0; i < writer->sectionCount; i++) {
+        const RCClipContainerWriterSection *section = &writer->sections[i];
+        uint64_t aligned = RCClipContainerAlign(offset);
+        if (aligned > offset && !sink(context, padding, (size_t)(aligned - offset))) {
+            return false;
+        }
+        if (section->length > 0 && !sink(context, section->bytes, section->length)) {
+            return false;
+        }
+        offset = aligned + section->length;
+    }
+    return true;
+}
+
+static bool RCClipContainerFileSink(void *context, const void *bytes, size_t length) {
+    int fd = *(int *)context;
+    const uint8_t *p = bytes;
+    while (length > 0) {
+        ssize_t written = write(fd, p, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+typedef struct {
+    uint8_t *cursor;
+} RCClipContainerMemorySink;
+
+static bool RCClipContainerCopySink(void *context, const void *bytes, size_t length) {
+    RCClipContainerMemorySink *sink = context;
+    memcpy(sink->cursor, bytes, length);
+    sink->cursor += length;
+    return true;
+}
+
+RCClipContainerStatus RCClipContainerWriterWriteFile(RCClipContainerWriter *writer, const char *path) {
+    if (writer == NULL || path == NULL) {
+        return RCClipContainerIOError;
+    }
+    uint8_t prefix[RC_CLIP_CONTAINER_PREFIX_MAX_LENGTH];
+    size_t prefixLength = 0;
+    RCClipContainerWriterLayout(writer, prefix, &prefixLength);
+
+    size_t pathLength = strlen(path);
+    char *temporaryPath = malloc(pathLength + sizeof(".XXXXXX"));
+    if (temporaryPath == NULL) {
+        return RCClipContainerNoMemory;
+    }
+    memcpy(temporaryPath, path, pathLength);
+    memcpy(temporaryPath + pathLength, ".XXXXXX", sizeof(".XXXXXX"));
+
+    // mkstemp creates the file with mode 0600.
+    int fd = mkstemp(temporaryPath);
+    if (fd < 0) {
+        free(temporaryPath);
+        return RCClipContainerIOError;
+    }
+    bool wrote = RCClipContainerWriterEmit(writer, prefix, prefixLength, RCClipContainerFileSink, &fd);
+    if (close(fd) != 0) {
+        wrote = false;
+    }
+    if (!wrote || rename(temporaryPath, path) != 0) {
+        unlink(temporaryPath);
+        free(temporaryPath);
+        return RCClipContainerIOError;
+    }
+    free(temporaryPath);
+    return RCClipContainerOK;
+}
+
+RCClipContainerStatus RCClipContainerWriterCopyBytes(RCClipContainerWriter *writer,
+                                                     uint8_t **outBytes,
+                                                     size_t *outLength) {
+    if (writer == NULL || outBytes == NULL || outLength == NULL) {
+        return RCClipContainerCorrupt;
+    }
+    *outBytes = NULL;
+    *outLength = 0;
+
+    uint8_t prefix[RC_CLIP_CONTAINER_PREFIX_MAX_LENGTH];
+    size_t prefixLength = 0;
+    uint64_t fileLength = RCClipContainerWriterLayout(writer, prefix, &prefixLength);
+    if (fileLength > SIZE_MAX) {
+        return RCClipContainerNoMemory;
+    }
+    uint8_t *bytes = malloc((size_t)fileLength);
+    if (bytes == NULL) {
+        return RCClipContainerNoMemory;
+    }
+    RCClipContainerMemorySink sink = { bytes };
+    RCClipContainerWriterEmit(writer, prefix, prefixLength, RCClipContainerCopySink, &sink);
+    *outBytes = bytes;
+    *outLength = (size_t)fileLength;
+    return RCClipContainerOK;
+}
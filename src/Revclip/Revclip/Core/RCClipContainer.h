@@ -0,0 +1,190 @@
+//
+//  RCClipContainer.h
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Versioned binary container for .rcclip files. A fixed header is followed
+//  by a table of contents of typed sections (offset, length, CRC-32C), so a
+//  reader can map the file and hand out views of single sections without
+//  decoding or copying the rest (a tooltip never touches the TIFF bytes).
+//  Portable C so the app, the Linux unit tests and the fuzz target share it.
+//
+//  Layout (all integers little-endian):
+//    header   32 bytes  magic[8] version:u16 headerLength:u16 sectionCount:u32
+//                       fileLength:u64 tocChecksum:u32 headerChecksum:u32
+//    toc      32 bytes per section
+//                       type:u32 flags:u32 offset:u64 length:u64 checksum:u32 reserved:u32
+//    payload  sections, each starting on an 8-byte boundary
+//
+
+#ifndef RCClipContainer_h
+#define RCClipContainer_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RCClipCompression.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RC_CLIP_CONTAINER_VERSION 1
+#define RC_CLIP_CONTAINER_MAGIC_LENGTH 8
+#define RC_CLIP_CONTAINER_HEADER_LENGTH 32
+#define RC_CLIP_CONTAINER_TOC_ENTRY_LENGTH 32
+#define RC_CLIP_CONTAINER_MAX_SECTIONS 64
+
+typedef enum {
+    RCClipContainerOK = 0,
+    /// No section of the requested type, or the end of a list section.
+    RCClipContainerNotFound,
+    /// The bytes do not start with the container magic (e.g. a legacy
+    /// NSKeyedArchiver .rcclip).
+    RCClipContainerNotContainer,
+    RCClipContainerUnsupportedVersion,
+    RCClipContainerCorrupt,
+    RCClipContainerChecksumMismatch,
+    RCClipContainerIOError,
+    RCClipContainerNoMemory,
+} RCClipContainerStatus;
+
+/// Section types. Values are part of the file format; never renumber.
+/// Readers skip types they do not know.
+typedef enum {
+    RCClipSectionString = 1,        // UTF-8
+    RCClipSectionRTF = 2,
+    RCClipSectionRTFD = 3,
+    RCClipSectionPDF = 4,
+    RCClipSectionFileNames = 5,     // list of UTF-8 paths
+    RCClipSectionFileURLs = 6,      // list of UTF-8 absolute URL strings
+    RCClipSectionURL = 7,           // UTF-8
+    RCClipSectionTIFF = 8,
+    RCClipSectionPrimaryType = 9,   // UTF-8 pasteboard type
+    RCClipSectionBlob = 10,         // a clip blob store payload (.rcblob files)
+} RCClipSectionType;
+
+/// The payload is not the representation itself but the lowercase hex
+/// SHA-256 of a payload kept in the clip blob store.
+#define RC_CLIP_SECTION_FLAG_BLOB_REFERENCE 0x1u
+/// The payload is compressed (RCClipCompression.h): an 8-byte decoded length
+/// followed by an LZ4 block or a raw deflate stream. The checksum covers the
+/// stored (compressed) bytes. At most one codec flag is set.
+#define RC_CLIP_SECTION_FLAG_LZ4 0x2u
+#define RC_CLIP_SECTION_FLAG_DEFLATE 0x4u
+#define RC_CLIP_SECTION_CODEC_FLAGS (RC_CLIP_SECTION_FLAG_LZ4 | RC_CLIP_SECTION_FLAG_DEFLATE)
+/// Flags this build can interpret; sections with any other flag set were
+/// written by a newer version.
+#define RC_CLIP_SECTION_KNOWN_FLAGS (RC_CLIP_SECTION_FLAG_BLOB_REFERENCE | RC_CLIP_SECTION_CODEC_FLAGS)
+
+typedef struct {
+    uint32_t type;
+    uint32_t flags;
+    /// Points into the container; valid until RCClipContainerClose.
+    const uint8_t *bytes;
+    uint64_t length;
+    uint32_t checksum;
+} RCClipSection;
+
+typedef struct RCClipContainer RCClipContainer;
+typedef struct RCClipContainerWriter RCClipContainerWriter;
+
+/// CRC-32C (Castagnoli) used for the header, the TOC and every section.
+/// Pass 0 as `crc` to start a new checksum.
+uint32_t RCClipContainerChecksum(uint32_t crc, const void *bytes, size_t length);
+
+/// True when `bytes` starts with the container magic.
+bool RCClipContainerHasMagic(const void *bytes, size_t length);
+
+// MARK: Reader
+
+/// Maps `path` read-only and validates the header and the TOC. Section
+/// payloads are not read until they are looked up. The file must only ever be
+/// replaced by rename (never truncated in place) while it is mapped.
+RCClipContainerStatus RCClipContainerOpenFile(const char *path, RCClipContainer **outContainer);
+/// Same validation over caller-owned memory, which must outlive the container.
+RCClipContainerStatus RCClipContainerOpenBytes(const void *bytes, size_t length, RCClipContainer **outContainer);
+void RCClipContainerClose(RCClipContainer *container);
+
+uint32_t RCClipContainerSectionCount(const RCClipContainer *container);
+/// TOC entry `index` without verifying its checksum.
+RCClipContainerStatus RCClipContainerSectionAtIndex(const RCClipContainer *container,
+                                                    uint32_t index,
+                                                    RCClipSection *outSection);
+/// Finds the section of `type` and verifies its checksum (only that
+/// section's bytes are touched). Returns RCClipContainerUnsupportedVersion
+/// when the section carries flags outside RC_CLIP_SECTION_KNOWN_FLAGS.
+/// Compressed sections are returned as stored; see RCClipSectionDecode.
+RCClipContainerStatus RCClipContainerFindSection(const RCClipContainer *container,
+                                                 uint32_t type,
+                                                 RCClipSection *outSection);
+RCClipContainerStatus RCClipContainerVerifySection(const RCClipSection *section);
+
+/// Walks a list section (RCClipSectionFileNames / RCClipSectionFileURLs).
+/// Start with `*cursor = 0`; returns RCClipContainerOK per item,
+/// RCClipContainerNotFound at the end and RCClipContainerCorrupt when an item
+/// runs past the section.
+RCClipContainerStatus RCClipSectionNextListItem(const RCClipSection *section,
+                                                uint64_t *cursor,
+                                                const uint8_t **outBytes,
+                                                size_t *outLength);
+
+// MARK: Compressed sections
+
+/// RCClipCodecNone for sections stored raw.
+RCClipCodec RCClipSectionCodec(const RCClipSection *section);
+/// The section flag that marks a payload encoded with `codec` (0 for none).
+uint32_t RCClipSectionFlagsForCodec(RCClipCodec codec);
+/// Length of the section once decoded (its stored length when raw). Fails
+/// with RCClipContainerCorrupt on an impossible length prefix.
+RCClipContainerStatus RCClipSectionDecodedLength(const RCClipSection *section, uint64_t *outLength);
+/// Decodes (or copies, when raw) the section into `destination`, which must
+/// be exactly RCClipSectionDecodedLength bytes. Only this section is
+/// decompressed; readers that want raw bytes without a copy check
+/// RCClipSectionCodec first.
+RCClipContainerStatus RCClipSectionDecode(const RCClipSection *section, void *destination, size_t destinationLength);
+
+// MARK: Writer
+
+RCClipContainerWriter *RCClipContainerWriterCreate(void);
+void RCClipContainerWriterDestroy(RCClipContainerWriter *writer);
+
+/// Adds a section. `bytes` is borrowed, not copied: keep it alive and
+/// unchanged until the writer has written its output. A type may be added
+/// only once.
+RCClipContainerStatus RCClipContainerWriterAddSection(RCClipContainerWriter *writer,
+                                                      uint32_t type,
+                                                      uint32_t flags,
+                                                      const void *bytes,
+                                                      size_t length);
+/// Adds a section compressed with the codec RCClipCompressionChooseCodec
+/// picks for `compressionClass`, or borrowed raw (as AddSection) when the
+/// payload is short or does not compress. Compressed bytes are owned by the
+/// writer; `bytes` must still outlive it in case it is stored raw.
+RCClipContainerStatus RCClipContainerWriterAddCompressibleSection(RCClipContainerWriter *writer,
+                                                                  uint32_t type,
+                                                                  const void *bytes,
+                                                                  size_t length,
+                                                                  RCClipCompressionClass compressionClass);
+/// Adds a list section; the items are encoded (copied) immediately.
+RCClipContainerStatus RCClipContainerWriterAddListSection(RCClipContainerWriter *writer,
+                                                          uint32_t type,
+                                                          const char *const *items,
+                                                          const size_t *lengths,
+                                                          size_t count);
+
+/// Writes the container to a temporary file (mode 0600) next to `path` and
+/// renames it over `path`, so readers see either the old or the new file.
+RCClipContainerStatus RCClipContainerWriterWriteFile(RCClipContainerWriter *writer, const char *path);
+/// Serializes into a malloc'd buffer (caller frees).
+RCClipContainerStatus RCClipContainerWriterCopyBytes(RCClipContainerWriter *writer,
+                                                     uint8_t **outBytes,
+                                                     size_t *outLength);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RCClipContainer_h */
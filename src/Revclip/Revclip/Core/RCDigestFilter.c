@@ -0,0 +1,247 @@
+//
+//  RCDigestFilter.c
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCDigestFilter.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Buckets are sized so the requested capacity lands at this load factor;
+// four-slot cuckoo tables start failing insertions around 95%.
+#define RC_DIGEST_FILTER_TARGET_LOAD_PERCENT 90
+#define RC_DIGEST_FILTER_MIN_BUCKETS 16
+// Relocations tried before an insertion parks its last evicted fingerprint
+// in the victim slot.
+#define RC_DIGEST_FILTER_MAX_KICKS 500
+
+struct RCDigestFilter {
+    uint16_t *slots;
+    size_t bucketMask;
+    size_t count;
+    uint64_t kickState;
+    // A fingerprint that could not be placed after RC_DIGEST_FILTER_MAX_KICKS.
+    // Keeping it (instead of dropping it) means a full filter never forgets a key.
+    bool hasVictim;
+    size_t victimBucket;
+    uint16_t victimFingerprint;
+};
+
+// MARK: Hashing
+
+static inline uint64_t RCMix64(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+static uint64_t RCDigestFilterHash(const void *key, size_t length) {
+    const uint8_t *bytes = key;
+    uint64_t hash = 0x9e3779b97f4a7c15ULL ^ (uint64_t)length;
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        hash = RCMix64(hash ^ word);
+        bytes += 8;
+        length -= 8;
+    }
+    if (length > 0) {
+        uint64_t word = 0;
+        memcpy(&word, bytes, length);
+        hash = RCMix64(hash ^ word ^ 0x8000000000000000ULL);
+    }
+    return RCMix64(hash);
+}
+
+static inline uint16_t RCDigestFilterFingerprint(uint64_t hash) {
+    // 0 marks an empty slot.
+    uint16_t fingerprint = (uint16_t)(hash >> 48);
+    return fingerprint == 0 ? 1 : fingerprint;
+}
+
+// Partial-key cuckoo hashing: the alternate bucket depends only on the
+// current bucket and the fingerprint, so relocation never needs the key.
+static inline size_t RCDigestFilterAlternateBucket(const RCDigestFilter *filter, size_t bucket, uint16_t fingerprint) {
+    return (bucket ^ (size_t)RCMix64(fingerprint)) & filter->bucketMask;
+}
+
+// MARK: Buckets
+
+static bool RCDigestFilterBucketInsert(RCDigestFilter *filter, size_t bucket, uint16_t fingerprint) {
+    uint16_t *slots = filter->slots + bucket * RC_DIGEST_FILTER_BUCKET_SLOTS;
+    for (int i = 0; i < RC_DIGEST_FILTER_BUCKET_SLOTS; i++) {
+        if (slots[i] == 0) {
+            slots[i] = fingerprint;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool RCDigestFilterBucketContains(const RCDigestFilter *filter, size_t bucket, uint16_t fingerprint) {
+    const uint16_t *slots = filter->slots + bucket * RC_DIGEST_FILTER_BUCKET_SLOTS;
+    for (int i = 0; i < RC_DIGEST_FILTER_BUCKET_SLOTS; i++) {
+        if (slots[i] == fingerprint) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool RCDigestFilterBucketRemove(RCDigestFilter *filter, size_t bucket, uint16_t fingerprint) {
+    uint16_t *slots = filter->slots + bucket * RC_DIGEST_FILTER_BUCKET_SLOTS;
+    for (int i = 0; i < RC_DIGEST_FILTER_BUCKET_SLOTS; i++) {
+        if (slots[i] == fingerprint) {
+            slots[i] = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint64_t RCDigestFilterNextKick(RCDigestFilter *filter) {
+    filter->kickState ^= filter->kickState << 13;
+    filter->kickState ^= filter->kickState >> 7;
+    filter->kickState ^= filter->kickState << 17;
+    return filter->kickState;
+}
+
+// MARK: Public
+
+RCDigestFilter *RCDigestFilterCreate(size_t capacity) {
+    size_t wantedBuckets = capacity / RC_DIGEST_FILTER_BUCKET_SLOTS * 100 / RC_DIGEST_FILTER_TARGET_LOAD_PERCENT + 1;
+    size_t bucketCount = RC_DIGEST_FILTER_MIN_BUCKETS;
+    while (bucketCount < wantedBuckets) {
+        if (bucketCount > SIZE_MAX / 2 / RC_DIGEST_FILTER_BUCKET_SLOTS / sizeof(uint16_t)) {
+            return NULL;
+        }
+        bucketCount *= 2;
+    }
+
+    RCDigestFilter *filter = calloc(1, sizeof(*filter));
+    if (filter == NULL) {
+        return NULL;
+    }
+    filter->slots = calloc(bucketCount * RC_DIGEST_FILTER_BUCKET_SLOTS, sizeof(uint16_t));
+    if (filter->slots == NULL) {
+        free(filter);
+        return NULL;
+    }
+    filter->bucketMask = bucketCount - 1;
+    filter->kickState = 0x2545f4914f6cdd1dULL;
+    return filter;
+}
+
+void RCDigestFilterDestroy(RCDigestFilter *filter) {
+    if (filter == NULL) {
+        return;
+    }
+    free(filter->slots);
+    free(filter);
+}
+
+bool RCDigestFilterAdd(RCDigestFilter *filter, const void *key, size_t length) {
+    if (filter->hasVictim) {
+        return false;
+    }
+
+    uint64_t hash = RCDigestFilterHash(key, length);
+    uint16_t fingerprint = RCDigestFilterFingerprint(hash);
+    size_t bucket = (size_t)hash & filter->bucketMask;
+    size_t alternate = RCDigestFilterAlternateBucket(filter, bucket, fingerprint);
+    if (RCDigestFilterBucketInsert(filter, bucket, fingerprint)
+        || RCDigestFilterBucketInsert(filter, alternate, fingerprint)) {
+        filter->count++;
+        return true;
+    }
+
+    // Both buckets are full: evict a random resident to its other bucket.
+    bucket = (RCDigestFilterNextKick(filter) & 1) ? bucket : alternate;
+    for (int kick = 0; kick < RC_DIGEST_FILTER_MAX_KICKS; kick++) {
+        uint16_t *slot = filter->slots + bucket * RC_DIGEST_FILTER_BUCKET_SLOTS
+            + RCDigestFilterNextKick(filter) % RC_DIGEST_FILTER_BUCKET_SLOTS;
+        uint16_t evicted = *slot;
+        *slot = fingerprint;
+        fingerprint = evicted;
+        bucket = RCDigestFilterAlternateBucket(filter, bucket, fingerprint);
+        if (RCDigestFilterBucketInsert(filter, bucket, fingerprint)) {
+            filter->count++;
+            return true;
+        }
+    }
+
+    // The new key is placed; the fingerprint left homeless waits in the victim
+    // slot, and further additions fail until a removal frees room.
+    filter->hasVictim = true;
+    filter->victimBucket = bucket;
+    filter->victimFingerprint = fingerprint;
+    filter->count++;
+    return true;
+}
+
+bool RCDigestFilterMayContain(const RCDigestFilter *filter, const void *key, size_t length) {
+    uint64_t hash = RCDigestFilterHash(key, length);
+    uint16_t fingerprint = RCDigestFilterFingerprint(hash);
+    size_t bucket = (size_t)hash & filter->bucketMask;
+    size_t alternate = RCDigestFilterAlternateBucket(filter, bucket, fingerprint);
+    if (RCDigestFilterBucketContains(filter, bucket, fingerprint)
+        || RCDigestFilterBucketContains(filter, alternate, fingerprint)) {
+        return true;
+    }
+    return filter->hasVictim
+        && filter->victimFingerprint == fingerprint
+        && (filter->victimBucket == bucket || filter->victimBucket == alternate);
+}
+
+bool RCDigestFilterRemove(RCDigestFilter *filter, const void *key, size_t length) {
+    uint64_t hash = RCDigestFilterHash(key, length);
+    uint16_t fingerprint = RCDigestFilterFingerprint(hash);
+    size_t bucket = (size_t)hash & filter->bucketMask;
+    size_t alternate = RCDigestFilterAlternateBucket(filter, bucket, fingerprint);
+
+    bool removed = RCDigestFilterBucketRemove(filter, bucket, fingerprint)
+        || RCDigestFilterBucketRemove(filter, alternate, fingerprint);
+    if (!removed && filter->hasVictim && filter->victimFingerprint == fingerprint
+        && (filter->victimBucket == bucket || filter->victimBucket == alternate)) {
+        filter->hasVictim = false;
+        removed = true;
+    }
+    if (!removed) {
+        return false;
+    }
+    filter->count--;
+
+    // A freed slot may be the room the victim was waiting for.
+    if (filter->hasVictim) {
+        size_t victimAlternate = RCDigestFilterAlternateBucket(filter, filter->victimBucket, filter->victimFingerprint);
+        if (RCDigestFilterBucketInsert(filter, filter->victimBucket, filter->victimFingerprint)
+            || RCDigestFilterBucketInsert(filter, victimAlternate, filter->victimFingerprint)) {
+            filter->hasVictim = false;
+        }
+    }
+    return true;
+}
+
+void RCDigestFilterClear(RCDigestFilter *filter) {
+    memset(filter->slots, 0, (filter->bucketMask + 1) * RC_DIGEST_FILTER_BUCKET_SLOTS * sizeof(uint16_t));
+    filter->count = 0;
+    filter->hasVictim = false;
+}
+
+size_t RCDigestFilterCount(const RCDigestFilter *filter) {
+    return filter->count;
+}
+
+size_t RCDigestFilterCapacity(const RCDigestFilter *filter) {
+    return (filter->bucketMask + 1) * RC_DIGEST_FILTER_BUCKET_SLOTS * RC_DIGEST_FILTER_TARGET_LOAD_PERCENT / 100;
+}
+
+size_t RCDigestFilterMemoryBytes(const RCDigestFilter *filter) {
+    return (filter->bucketMask + 1) * RC_DIGEST_FILTER_BUCKET_SLOTS * sizeof(uint16_t);
+}
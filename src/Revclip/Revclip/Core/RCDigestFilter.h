@@ -0,0 +1,68 @@
+//
+//  RCDigestFilter.h
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  In-memory cuckoo filter over clip digests, consulted before the dedup
+//  lookup in SQLite so a brand-new clip does not cost a database round trip.
+//
+//  Each key is reduced to a 16-bit fingerprint stored in one of two buckets
+//  of four slots. A lookup reads at most two cache lines and answers either
+//  "definitely not stored" or "maybe stored" (false positive rate about
+//  8 / 65536 at full load). Unlike a Bloom filter, keys can be removed, so
+//  the filter follows evictions instead of only growing.
+//
+//  Never remove a key that was not added: that can remove another key's
+//  fingerprint and turn a stored key into a false negative. Not thread-safe;
+//  callers serialise access.
+//
+
+#ifndef RCDigestFilter_h
+#define RCDigestFilter_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RC_DIGEST_FILTER_BUCKET_SLOTS 4
+
+typedef struct RCDigestFilter RCDigestFilter;
+
+/// Creates an empty filter sized to hold at least `capacity` keys. Returns
+/// NULL when the allocation fails.
+RCDigestFilter *RCDigestFilterCreate(size_t capacity);
+void RCDigestFilterDestroy(RCDigestFilter *filter);
+
+/// Adds a key (any length; digests are used as-is). Returns false when the
+/// filter is full, in which case the key was not added and the caller must
+/// stop trusting negative answers (rebuild it larger).
+bool RCDigestFilterAdd(RCDigestFilter *filter, const void *key, size_t length);
+
+/// false means the key was never added (or was removed); true means it
+/// probably was.
+bool RCDigestFilterMayContain(const RCDigestFilter *filter, const void *key, size_t length);
+
+/// Removes one earlier RCDigestFilterAdd of the key. Returns false when no
+/// matching fingerprint was found.
+bool RCDigestFilterRemove(RCDigestFilter *filter, const void *key, size_t length);
+
+/// Removes every key.
+void RCDigestFilterClear(RCDigestFilter *filter);
+
+/// Keys currently stored.
+size_t RCDigestFilterCount(const RCDigestFilter *filter);
+/// Keys the filter can hold before additions start to fail.
+size_t RCDigestFilterCapacity(const RCDigestFilter *filter);
+/// Bytes of fingerprint storage.
+size_t RCDigestFilterMemoryBytes(const RCDigestFilter *filter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RCDigestFilter_h */
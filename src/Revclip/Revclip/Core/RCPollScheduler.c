@@ -0,0 +1,89 @@
+//
+//  RCPollScheduler.c
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCPollScheduler.h"
+
+// MARK: Private
+
+static void RCPollSchedulerBecomeActive(RCPollScheduler *scheduler, uint64_t now) {
+    scheduler->lastActivityNanoseconds = now;
+    scheduler->intervalNanoseconds = scheduler->configuration.minimumIntervalNanoseconds;
+}
+
+static bool RCPollSchedulerWithinActiveWindow(const RCPollScheduler *scheduler, uint64_t now) {
+    return now - scheduler->lastActivityNanoseconds < scheduler->configuration.activeWindowNanoseconds;
+}
+
+// MARK: Public
+
+RCPollSchedulerConfiguration RCPollSchedulerDefaultConfiguration(void) {
+    RCPollSchedulerConfiguration configuration = {
+        .minimumIntervalNanoseconds = 100000000ULL,
+        .maximumIntervalNanoseconds = 3200000000ULL,
+        .activeWindowNanoseconds = 2000000000ULL,
+    };
+    return configuration;
+}
+
+void RCPollSchedulerInit(RCPollScheduler *scheduler, const RCPollSchedulerConfiguration *configuration, uint64_t now) {
+    scheduler->configuration = *configuration;
+    if (scheduler->configuration.minimumIntervalNanoseconds == 0) {
+        scheduler->configuration.minimumIntervalNanoseconds = 1;
+    }
+    if (scheduler->configuration.maximumIntervalNanoseconds < scheduler->configuration.minimumIntervalNanoseconds) {
+        scheduler->configuration.maximumIntervalNanoseconds = scheduler->configuration.minimumIntervalNanoseconds;
+    }
+    RCPollSchedulerBecomeActive(scheduler, now);
+    scheduler->lastPollNanoseconds = now;
+    scheduler->nextPollNanoseconds = now + scheduler->intervalNanoseconds;
+}
+
+uint64_t RCPollSchedulerRecordPoll(RCPollScheduler *scheduler, uint64_t now, bool changed) {
+    if (changed) {
+        RCPollSchedulerBecomeActive(scheduler, now);
+    } else if (RCPollSchedulerWithinActiveWindow(scheduler, now)) {
+        scheduler->intervalNanoseconds = scheduler->configuration.minimumIntervalNanoseconds;
+    } else {
+        uint64_t maximum = scheduler->configuration.maximumIntervalNanoseconds;
+        scheduler->intervalNanoseconds = scheduler->intervalNanoseconds > maximum / 2
+            ? maximum
+            : scheduler->intervalNanoseconds * 2;
+    }
+    scheduler->lastPollNanoseconds = now;
+    scheduler->nextPollNanoseconds = now + scheduler->intervalNanoseconds;
+    return scheduler->nextPollNanoseconds;
+}
+
+bool RCPollSchedulerNoteActivity(RCPollScheduler *scheduler, uint64_t now) {
+    RCPollSchedulerBecomeActive(scheduler, now);
+
+    // Poll right away, but a storm of events still polls at most once per
+    // minimum interval.
+    uint64_t earliest = scheduler->lastPollNanoseconds + scheduler->configuration.minimumIntervalNanoseconds;
+    uint64_t wanted = earliest > now ? earliest : now;
+    if (wanted >= scheduler->nextPollNanoseconds) {
+        return false;
+    }
+    scheduler->nextPollNanoseconds = wanted;
+    return true;
+}
+
+uint64_t RCPollSchedulerNextPollNanoseconds(const RCPollScheduler *scheduler) {
+    return scheduler->nextPollNanoseconds;
+}
+
+uint64_t RCPollSchedulerIntervalNanoseconds(const RCPollScheduler *scheduler) {
+    return scheduler->intervalNanoseconds;
+}
+
+uint64_t RCPollSchedulerLeewayNanoseconds(const RCPollScheduler *scheduler) {
+    return scheduler->intervalNanoseconds / 10;
+}
+
+bool RCPollSchedulerIsActive(const RCPollScheduler *scheduler) {
+    return scheduler->intervalNanoseconds == scheduler->configuration.minimumIntervalNanoseconds;
+}
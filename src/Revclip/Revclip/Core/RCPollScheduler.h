@@ -0,0 +1,81 @@
+//
+//  RCPollScheduler.h
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Adaptive interval policy for clipboard polling. macOS has no pasteboard
+//  change notification, so RCClipboardService reads changeCount on a timer;
+//  this state machine decides when the next read is due:
+//
+//    active   for activeWindow after the last change or activity event, poll
+//             every minimumInterval so a burst of copies is caught quickly
+//    idle     afterwards every unchanged poll doubles the interval up to
+//             maximumInterval, so an idle session costs few wakeups
+//    activity a hotkey, app activation or wake event pulls the next poll in
+//             to now (never closer than minimumInterval to the previous
+//             poll) and returns to active
+//
+//  Times are nanoseconds on any monotonic clock chosen by the caller; the
+//  scheduler never reads a clock itself, so tests drive it with a simulated
+//  one. Not thread-safe; RCClipboardService only touches it on its
+//  monitoring queue.
+//
+
+#ifndef RCPollScheduler_h
+#define RCPollScheduler_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint64_t minimumIntervalNanoseconds;
+    uint64_t maximumIntervalNanoseconds;
+    /// How long polling stays at the minimum interval after the last change
+    /// or activity event before backing off.
+    uint64_t activeWindowNanoseconds;
+} RCPollSchedulerConfiguration;
+
+typedef struct {
+    RCPollSchedulerConfiguration configuration;
+    uint64_t intervalNanoseconds;
+    uint64_t lastActivityNanoseconds;
+    uint64_t lastPollNanoseconds;
+    uint64_t nextPollNanoseconds;
+} RCPollScheduler;
+
+/// 100 ms while active, 2 s active window, backing off to 3.2 s.
+RCPollSchedulerConfiguration RCPollSchedulerDefaultConfiguration(void);
+
+/// Starts in the active state (launch counts as activity) with the first poll
+/// due one minimum interval after `now`. A zero minimum is raised to 1 ns and
+/// a maximum below the minimum is raised to it.
+void RCPollSchedulerInit(RCPollScheduler *scheduler, const RCPollSchedulerConfiguration *configuration, uint64_t now);
+
+/// Records a poll made at `now` and whether the pasteboard had changed since
+/// the previous one. Returns the time the next poll is due.
+uint64_t RCPollSchedulerRecordPoll(RCPollScheduler *scheduler, uint64_t now, bool changed);
+
+/// Records a hotkey, app activation or wake event. Returns true when the next
+/// poll moved earlier, in which case the caller re-arms its timer for
+/// RCPollSchedulerNextPollNanoseconds().
+bool RCPollSchedulerNoteActivity(RCPollScheduler *scheduler, uint64_t now);
+
+uint64_t RCPollSchedulerNextPollNanoseconds(const RCPollScheduler *scheduler);
+/// Interval used to schedule the next poll.
+uint64_t RCPollSchedulerIntervalNanoseconds(const RCPollScheduler *scheduler);
+/// Timer slack the caller may grant the OS for coalescing wakeups (a tenth of
+/// the current interval).
+uint64_t RCPollSchedulerLeewayNanoseconds(const RCPollScheduler *scheduler);
+/// true while polling at the minimum interval.
+bool RCPollSchedulerIsActive(const RCPollScheduler *scheduler);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RCPollScheduler_h */
@@ -0,0 +1,398 @@
+//
+//  RCQueryMetrics.c
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCQueryMetrics.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Statements can nest on one connection (an UPDATE issued while a SELECT is
+// still being stepped), so each connection tracks a few in-flight starts.
+#define RC_QUERY_TRACE_IN_FLIGHT 8
+
+typedef struct {
+    _Atomic uint64_t count;
+    _Atomic uint64_t totalNanoseconds;
+    _Atomic uint64_t maxNanoseconds;
+    _Atomic uint64_t buckets[RC_LATENCY_BUCKET_COUNT];
+} RCLatencyHistogram;
+
+typedef struct {
+    char *name;
+    char *sql;
+    uint64_t sqlHash;
+    RCLatencyHistogram histogram;
+} RCQueryStatement;
+
+typedef struct {
+    char *name;
+    RCLatencyHistogram queueWait;
+    RCLatencyHistogram execution;
+} RCQueryOperation;
+
+struct RCQueryMetrics {
+    pthread_mutex_t registrationLock;
+    // Entries are written before the count is published (release), and
+    // readers only look at indexes below the count they loaded (acquire).
+    _Atomic size_t statementCount;
+    _Atomic size_t operationCount;
+    RCQueryStatement statements[RC_QUERY_METRICS_MAX_STATEMENTS];
+    RCQueryOperation operations[RC_QUERY_METRICS_MAX_OPERATIONS];
+};
+
+// One per traced connection. FMDatabaseQueue / FMDatabasePool hand a
+// connection to one thread at a time, so this needs no locking.
+typedef struct {
+    RCQueryMetrics *metrics;
+    sqlite3_stmt *statements[RC_QUERY_TRACE_IN_FLIGHT];
+    uint64_t startNanoseconds[RC_QUERY_TRACE_IN_FLIGHT];
+} RCQueryTraceConnection;
+
+uint64_t RCQueryMetricsNowNanoseconds(void) {
+#ifdef __APPLE__
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+// MARK: Histogram
+
+static size_t RCLatencyBucketForNanoseconds(uint64_t nanoseconds) {
+    uint64_t microseconds = nanoseconds / 1000;
+    if (microseconds == 0) {
+        return 0;
+    }
+    size_t bucket = (size_t)(64 - __builtin_clzll(microseconds));
+    return bucket < RC_LATENCY_BUCKET_COUNT ? bucket : RC_LATENCY_BUCKET_COUNT - 1;
+}
+
+uint64_t RCLatencyBucketUpperBoundNanoseconds(size_t bucket) {
+    if (bucket >= RC_LATENCY_BUCKET_COUNT - 1) {
+        return UINT64_MAX;
+    }
+    return 1000ull << bucket;
+}
+
+static void RCLatencyHistogramRecord(RCLatencyHistogram *histogram, uint64_t nanoseconds) {
+    atomic_fetch_add_explicit(&histogram->buckets[RCLatencyBucketForNanoseconds(nanoseconds)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->totalNanoseconds, nanoseconds, memory_order_relaxed);
+    uint64_t currentMax = atomic_load_explicit(&histogram->maxNanoseconds, memory_order_relaxed);
+    while (nanoseconds > currentMax
+           && !atomic_compare_exchange_weak_explicit(&histogram->maxNanoseconds, &currentMax, nanoseconds,
+                                                     memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+// Fields are read one by one, so a snapshot taken during recording may be off
+// by the samples in flight; fine for diagnostics.
+static void RCLatencyHistogramSnapshot(const RCLatencyHistogram *histogram, RCLatencySnapshot *outSnapshot) {
+    RCLatencyHistogram *mutableHistogram = (RCLatencyHistogram *)histogram;
+    outSnapshot->count = atomic_load_explicit(&mutableHistogram->count, memory_order_relaxed);
+    outSnapshot->totalNanoseconds = atomic_load_explicit(&mutableHistogram->totalNanoseconds, memory_order_relaxed);
+    outSnapshot->maxNanoseconds = atomic_load_explicit(&mutableHistogram->maxNanoseconds, memory_order_relaxed);
+    for (size_t bucket = 0; bucket < RC_LATENCY_BUCKET_COUNT; bucket++) {
+        outSnapshot->buckets[bucket] = atomic_load_explicit(&mutableHistogram->buckets[bucket], memory_order_relaxed);
+    }
+}
+
+static void RCLatencyHistogramReset(RCLatencyHistogram *histogram) {
+    atomic_store_explicit(&histogram->count, 0, memory_order_relaxed);
+    atomic_store_explicit(&histogram->totalNanoseconds, 0, memory_order_relaxed);
+    atomic_store_explicit(&histogram->maxNanoseconds, 0, memory_order_relaxed);
+    for (size_t bucket = 0; bucket < RC_LATENCY_BUCKET_COUNT; bucket++) {
+        atomic_store_explicit(&histogram->buckets[bucket], 0, memory_order_relaxed);
+    }
+}
+
+uint64_t RCLatencySnapshotPercentileNanoseconds(const RCLatencySnapshot *snapshot, double fraction) {
+    if (snapshot == NULL || snapshot->count == 0) {
+        return 0;
+    }
+    if (fraction < 0.0) {
+        fraction = 0.0;
+    } else if (fraction > 1.0) {
+        fraction = 1.0;
+    }
+
+    uint64_t rank = (uint64_t)(fraction * (double)snapshot->count + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < RC_LATENCY_BUCKET_COUNT; bucket++) {
+        seen += snapshot->buckets[bucket];
+        if (seen >= rank) {
+            uint64_t upperBound = RCLatencyBucketUpperBoundNanoseconds(bucket);
+            return upperBound < snapshot->maxNanoseconds ? upperBound : snapshot->maxNanoseconds;
+        }
+    }
+    return snapshot->maxNanoseconds;
+}
+
+// MARK: Registry
+
+static uint64_t RCQueryMetricsHashSQL(const char *sql) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const unsigned char *cursor = (const unsigned char *)sql; *cursor != '\0'; cursor++) {
+        hash ^= *cursor;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static char *RCQueryMetricsCopyString(const char *string) {
+    size_t length = strlen(string) + 1;
+    char *copy = malloc(length);
+    if (copy != NULL) {
+        memcpy(copy, string, length);
+    }
+    return copy;
+}
+
+RCQueryMetrics *RCQueryMetricsCreate(void) {
+    RCQueryMetrics *metrics = calloc(1, sizeof(RCQueryMetrics));
+    if (metrics == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&metrics->registrationLock, NULL);
+    metrics->statements[0].name = RCQueryMetricsCopyString("other");
+    if (metrics->statements[0].name == NULL) {
+        RCQueryMetricsDestroy(metrics);
+        return NULL;
+    }
+    atomic_store_explicit(&metrics->statementCount, 1, memory_order_release);
+    return metrics;
+}
+
+void RCQueryMetricsDestroy(RCQueryMetrics *metrics) {
+    if (metrics == NULL) {
+        return;
+    }
+    for (size_t index = 0; index < RC_QUERY_METRICS_MAX_STATEMENTS; index++) {
+        free(metrics->statements[index].name);
+        free(metrics->statements[index].sql);
+    }
+    for (size_t index = 0; index < RC_QUERY_METRICS_MAX_OPERATIONS; index++) {
+        free(metrics->operations[index].name);
+    }
+    pthread_mutex_destroy(&metrics->registrationLock);
+    free(metrics);
+}
+
+int RCQueryMetricsRegisterStatement(RCQueryMetrics *metrics, const char *name, const char *sql) {
+    if (metrics == NULL || name == NULL || sql == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&metrics->registrationLock);
+    size_t count = atomic_load_explicit(&metrics->statementCount, memory_order_relaxed);
+    int index = -1;
+    if (count < RC_QUERY_METRICS_MAX_STATEMENTS) {
+        RCQueryStatement *statement = &metrics->statements[count];
+        statement->name = RCQueryMetricsCopyString(name);
+        statement->sql = RCQueryMetricsCopyString(sql);
+        if (statement->name != NULL && statement->sql != NULL) {
+            statement->sqlHash = RCQueryMetricsHashSQL(sql);
+            index = (int)count;
+            atomic_store_explicit(&metrics->statementCount, count + 1, memory_order_release);
+        } else {
+            free(statement->name);
+            free(statement->sql);
+            statement->name = NULL;
+            statement->sql = NULL;
+        }
+    }
+    pthread_mutex_unlock(&metrics->registrationLock);
+    return index;
+}
+
+int RCQueryMetricsRegisterOperation(RCQueryMetrics *metrics, const char *name) {
+    if (metrics == NULL || name == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&metrics->registrationLock);
+    size_t count = atomic_load_explicit(&metrics->operationCount, memory_order_relaxed);
+    int index = -1;
+    if (count < RC_QUERY_METRICS_MAX_OPERATIONS) {
+        metrics->operations[count].name = RCQueryMetricsCopyString(name);
+        if (metrics->operations[count].name != NULL) {
+            index = (int)count;
+            atomic_store_explicit(&metrics->operationCount, count + 1, memory_order_release);
+        }
+    }
+    pthread_mutex_unlock(&metrics->registrationLock);
+    return index;
+}
+
+static size_t RCQueryMetricsStatementIndexForSQL(RCQueryMetrics *metrics, const char *sql) {
+    if (sql == NULL) {
+        return 0;
+    }
+    uint64_t hash = RCQueryMetricsHashSQL(sql);
+    size_t count = atomic_load_explicit(&metrics->statementCount, memory_order_acquire);
+    for (size_t index = 1; index < count; index++) {
+        if (metrics->statements[index].sqlHash == hash && strcmp(metrics->statements[index].sql, sql) == 0) {
+            return index;
+        }
+    }
+    return 0;
+}
+
+// MARK: Tracing
+
+static int RCQueryMetricsTrace(unsigned int type, void *context, void *p, void *x) {
+    RCQueryTraceConnection *connection = context;
+    switch (type) {
+        case SQLITE_TRACE_STMT: {
+            // Trigger sub-programs report the same statement with a "-- TRIGGER" text.
+            const char *text = x;
+            if (text != NULL && text[0] == '-' && text[1] == '-') {
+                return 0;
+            }
+            sqlite3_stmt *statement = p;
+            size_t slot = RC_QUERY_TRACE_IN_FLIGHT;
+            size_t oldestSlot = 0;
+            for (size_t index = 0; index < RC_QUERY_TRACE_IN_FLIGHT; index++) {
+                if (connection->statements[index] == statement) {
+                    return 0;
+                }
+                if (slot == RC_QUERY_TRACE_IN_FLIGHT && connection->statements[index] == NULL) {
+                    slot = index;
+                }
+                if (connection->startNanoseconds[index] < connection->startNanoseconds[oldestSlot]) {
+                    oldestSlot = index;
+                }
+            }
+            if (slot == RC_QUERY_TRACE_IN_FLIGHT) {
+                slot = oldestSlot;
+            }
+            connection->statements[slot] = statement;
+            connection->startNanoseconds[slot] = RCQueryMetricsNowNanoseconds();
+            return 0;
+        }
+        case SQLITE_TRACE_PROFILE: {
+            sqlite3_stmt *statement = p;
+            uint64_t elapsed = 0;
+            bool found = false;
+            for (size_t index = 0; index < RC_QUERY_TRACE_IN_FLIGHT; index++) {
+                if (connection->statements[index] == statement) {
+                    elapsed = RCQueryMetricsNowNanoseconds() - connection->startNanoseconds[index];
+                    connection->statements[index] = NULL;
+                    connection->startNanoseconds[index] = 0;
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                // SQLite's own figure only has millisecond resolution.
+                sqlite3_int64 reported = x != NULL ? *(const sqlite3_int64 *)x : 0;
+                elapsed = reported > 0 ? (uint64_t)reported : 0;
+            }
+            RCQueryMetrics *metrics = connection->metrics;
+            size_t index = RCQueryMetricsStatementIndexForSQL(metrics, sqlite3_sql(statement));
+            RCLatencyHistogramRecord(&metrics->statements[index].histogram, elapsed);
+            return 0;
+        }
+        case SQLITE_TRACE_CLOSE:
+            free(connection);
+            return 0;
+        default:
+            return 0;
+    }
+}
+
+bool RCQueryMetricsAttachConnection(RCQueryMetrics *metrics, sqlite3 *db) {
+    if (metrics == NULL || db == NULL) {
+        return false;
+    }
+    RCQueryTraceConnection *connection = calloc(1, sizeof(RCQueryTraceConnection));
+    if (connection == NULL) {
+        return false;
+    }
+    connection->metrics = metrics;
+    unsigned int mask = SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE | SQLITE_TRACE_CLOSE;
+    if (sqlite3_trace_v2(db, mask, RCQueryMetricsTrace, connection) != SQLITE_OK) {
+        free(connection);
+        return false;
+    }
+    return true;
+}
+
+// MARK: Recording / snapshots
+
+void RCQueryMetricsRecordOperation(RCQueryMetrics *metrics,
+                                   int operation,
+                                   uint64_t queueWaitNanoseconds,
+                                   uint64_t executionNanoseconds) {
+    if (metrics == NULL || operation < 0
+        || (size_t)operation >= atomic_load_explicit(&metrics->operationCount, memory_order_acquire)) {
+        return;
+    }
+    RCLatencyHistogramRecord(&metrics->operations[operation].queueWait, queueWaitNanoseconds);
+    RCLatencyHistogramRecord(&metrics->operations[operation].execution, executionNanoseconds);
+}
+
+size_t RCQueryMetricsStatementCount(const RCQueryMetrics *metrics) {
+    if (metrics == NULL) {
+        return 0;
+    }
+    return atomic_load_explicit(&((RCQueryMetrics *)metrics)->statementCount, memory_order_acquire);
+}
+
+const char *RCQueryMetricsStatementName(const RCQueryMetrics *metrics, size_t index) {
+    return index < RCQueryMetricsStatementCount(metrics) ? metrics->statements[index].name : NULL;
+}
+
+void RCQueryMetricsStatementSnapshot(const RCQueryMetrics *metrics, size_t index, RCLatencySnapshot *outSnapshot) {
+    memset(outSnapshot, 0, sizeof(*outSnapshot));
+    if (index < RCQueryMetricsStatementCount(metrics)) {
+        RCLatencyHistogramSnapshot(&metrics->statements[index].histogram, outSnapshot);
+    }
+}
+
+size_t RCQueryMetricsOperationCount(const RCQueryMetrics *metrics) {
+    if (metrics == NULL) {
+        return 0;
+    }
+    return atomic_load_explicit(&((RCQueryMetrics *)metrics)->operationCount, memory_order_acquire);
+}
+
+const char *RCQueryMetricsOperationName(const RCQueryMetrics *metrics, size_t index) {
+    return index < RCQueryMetricsOperationCount(metrics) ? metrics->operations[index].name : NULL;
+}
+
+void RCQueryMetricsOperationSnapshot(const RCQueryMetrics *metrics,
+                                     size_t index,
+                                     RCLatencySnapshot *outQueueWait,
+                                     RCLatencySnapshot *outExecution) {
+    memset(outQueueWait, 0, sizeof(*outQueueWait));
+    memset(outExecution, 0, sizeof(*outExecution));
+    if (index < RCQueryMetricsOperationCount(metrics)) {
+        RCLatencyHistogramSnapshot(&metrics->operations[index].queueWait, outQueueWait);
+        RCLatencyHistogramSnapshot(&metrics->operations[index].execution, outExecution);
+    }
+}
+
+void RCQueryMetricsReset(RCQueryMetrics *metrics) {
+    size_t statementCount = RCQueryMetricsStatementCount(metrics);
+    for (size_t index = 0; index < statementCount; index++) {
+        RCLatencyHistogramReset(&metrics->statements[index].histogram);
+    }
+    size_t operationCount = RCQueryMetricsOperationCount(metrics);
+    for (size_t index = 0; index < operationCount; index++) {
+        RCLatencyHistogramReset(&metrics->operations[index].queueWait);
+        RCLatencyHistogramReset(&metrics->operations[index].execution);
+    }
+}
@@ -0,0 +1,88 @@
+//
+//  RCQueryMetrics.h
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Fixed-bucket latency histograms for the SQLite layer. Statement execution
+//  time is captured with sqlite3_trace_v2 on every attached connection and
+//  filed under the name registered for its SQL text; callers record queue
+//  wait / execution time of whole operations themselves. Recording is a few
+//  relaxed atomic adds, so it stays on in release builds.
+//
+
+#ifndef RCQueryMetrics_h
+#define RCQueryMetrics_h
+
+#include <sqlite3.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Bucket 0 holds samples under 1 us, bucket i holds [2^(i-1), 2^i) us and the
+/// last bucket everything from 2^(RC_LATENCY_BUCKET_COUNT-2) us (~18 min) up.
+#define RC_LATENCY_BUCKET_COUNT 32
+#define RC_QUERY_METRICS_MAX_STATEMENTS 64
+#define RC_QUERY_METRICS_MAX_OPERATIONS 32
+
+typedef struct {
+    uint64_t count;
+    uint64_t totalNanoseconds;
+    uint64_t maxNanoseconds;
+    uint64_t buckets[RC_LATENCY_BUCKET_COUNT];
+} RCLatencySnapshot;
+
+typedef struct RCQueryMetrics RCQueryMetrics;
+
+/// Monotonic clock used for every sample.
+uint64_t RCQueryMetricsNowNanoseconds(void);
+
+/// Exclusive upper bound of a bucket in nanoseconds (UINT64_MAX for the last one).
+uint64_t RCLatencyBucketUpperBoundNanoseconds(size_t bucket);
+/// Upper bound of the bucket containing the `fraction` quantile (0 when empty).
+uint64_t RCLatencySnapshotPercentileNanoseconds(const RCLatencySnapshot *snapshot, double fraction);
+
+RCQueryMetrics *RCQueryMetricsCreate(void);
+/// Only call once every attached connection has been closed.
+void RCQueryMetricsDestroy(RCQueryMetrics *metrics);
+
+/// Files statements whose SQL text equals `sql` under `name`. Statement 0 is
+/// the built-in "other" bucket for unregistered SQL, including the statements
+/// FTS5 runs on its shadow tables from inside a write. Returns the statement
+/// index, or -1 when the table is full. Safe while connections are traced.
+int RCQueryMetricsRegisterStatement(RCQueryMetrics *metrics, const char *name, const char *sql);
+/// Returns the index of a new named operation, or -1 when the table is full.
+int RCQueryMetricsRegisterOperation(RCQueryMetrics *metrics, const char *name);
+
+/// Installs the statement trace on `db` (replacing any previous trace). The
+/// per-connection state is freed when the connection closes.
+bool RCQueryMetricsAttachConnection(RCQueryMetrics *metrics, sqlite3 *db);
+
+void RCQueryMetricsRecordOperation(RCQueryMetrics *metrics,
+                                   int operation,
+                                   uint64_t queueWaitNanoseconds,
+                                   uint64_t executionNanoseconds);
+
+size_t RCQueryMetricsStatementCount(const RCQueryMetrics *metrics);
+const char *RCQueryMetricsStatementName(const RCQueryMetrics *metrics, size_t index);
+void RCQueryMetricsStatementSnapshot(const RCQueryMetrics *metrics, size_t index, RCLatencySnapshot *outSnapshot);
+
+size_t RCQueryMetricsOperationCount(const RCQueryMetrics *metrics);
+const char *RCQueryMetricsOperationName(const RCQueryMetrics *metrics, size_t index);
+void RCQueryMetricsOperationSnapshot(const RCQueryMetrics *metrics,
+                                     size_t index,
+                                     RCLatencySnapshot *outQueueWait,
+                                     RCLatencySnapshot *outExecution);
+
+/// Zeroes every histogram (names stay registered).
+void RCQueryMetricsReset(RCQueryMetrics *metrics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RCQueryMetrics_h */
@@ -0,0 +1,417 @@
+//
+//  RCSHA256.c
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCSHA256.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define RC_SHA256_HAVE_SHANI 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+#define RC_SHA256_HAVE_ARMV8 1
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+#endif
+
+// Bytes hashed into every context before moving to the next piece in
+// RCSHA256UpdateEach; small enough to stay in L1 between the passes.
+#define RC_SHA256_EACH_PIECE_LENGTH (16 * 1024)
+
+typedef void (*RCSHA256BlocksFunction)(uint32_t state[8], const uint8_t *blocks, size_t blockCount);
+
+static const uint32_t kRCSHA256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint32_t kRCSHA256InitialState[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+// MARK: Scalar kernel
+
+static inline uint32_t RCRotateRight(uint32_t value, unsigned bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+static inline uint32_t RCReadBE32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void RCSHA256BlocksScalar(uint32_t state[8], const uint8_t *blocks, size_t blockCount) {
+    for (size_t block = 0; block < blockCount; block++, blocks += RC_SHA256_BLOCK_LENGTH) {
+        uint32_t w[16];
+        for (int i = 0; i < 16; i++) {
+            w[i] = RCReadBE32(blocks + 4 * i);
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+#pragma GCC unroll 16
+        for (int i = 0; i < 64; i++) {
+            // The message schedule is kept as a rolling window of 16 words.
+            uint32_t word;
+            if (i < 16) {
+                word = w[i];
+            } else {
+                uint32_t w15 = w[(i - 15) & 15];
+                uint32_t w2 = w[(i - 2) & 15];
+                uint32_t s0 = RCRotateRight(w15, 7) ^ RCRotateRight(w15, 18) ^ (w15 >> 3);
+                uint32_t s1 = RCRotateRight(w2, 17) ^ RCRotateRight(w2, 19) ^ (w2 >> 10);
+                word = w[i & 15] + s0 + w[(i - 7) & 15] + s1;
+                w[i & 15] = word;
+            }
+
+            uint32_t S1 = RCRotateRight(e, 6) ^ RCRotateRight(e, 11) ^ RCRotateRight(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t t1 = h + S1 + ch + kRCSHA256K[i] + word;
+            uint32_t S0 = RCRotateRight(a, 2) ^ RCRotateRight(a, 13) ^ RCRotateRight(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t t2 = S0 + maj;
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+// MARK: x86 SHA extensions
+
+#if RC_SHA256_HAVE_SHANI
+
+static bool RCSHA256CPUHasSHANI(void) {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    // SSSE3 (pshufb) and SSE4.1 (pblendw) are used alongside the SHA instructions.
+    bool hasSSE = (ecx & (1u << 9)) != 0 && (ecx & (1u << 19)) != 0;
+    if (!hasSSE || __get_cpuid_max(0, NULL) < 7) {
+        return false;
+    }
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & (1u << 29)) != 0;
+}
+
+// Four rounds: sha256rnds2 does two rounds with the low two words of `message + K`.
+#define RC_SHANI_FOUR_ROUNDS(message, k)                                          \
+    do {                                                                          \
+        __m128i rcWK = _mm_add_epi32((message), _mm_loadu_si128((const __m128i *)(k))); \
+        state1 = _mm_sha256rnds2_epu32(state1, state0, rcWK);                     \
+        rcWK = _mm_shuffle_epi32(rcWK, 0x0E);                                     \
+        state0 = _mm_sha256rnds2_epu32(state0, state1, rcWK);                     \
+    } while (0)
+
+__attribute__((target("sha,sse4.1")))
+static void RCSHA256BlocksSHANI(uint32_t state[8], const uint8_t *blocks, size_t blockCount) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+
+    // The instructions keep the state as ABEF / CDGH.
+    __m128i cdab = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xB1);
+    __m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(cdab, efgh, 8);
+    __m128i state1 = _mm_blend_epi16(efgh, cdab, 0xF0);
+
+    for (size_t block = 0; block < blockCount; block++, blocks += RC_SHA256_BLOCK_LENGTH) {
+        __m128i savedState0 = state0;
+        __m128i savedState1 = state1;
+
+        __m128i w0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(blocks + 0)), byteSwap);
+        __m128i w1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(blocks + 16)), byteSwap);
+        __m128i w2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(blocks + 32)), byteSwap);
+        __m128i w3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(blocks + 48)), byteSwap);
+        RC_SHANI_FOUR_ROUNDS(w0, &kRCSHA256K[0]);
+        RC_SHANI_FOUR_ROUNDS(w1, &kRCSHA256K[4]);
+        RC_SHANI_FOUR_ROUNDS(w2, &kRCSHA256K[8]);
+        RC_SHANI_FOUR_ROUNDS(w3, &kRCSHA256K[12]);
+
+        // w0..w3 hold the previous 16 schedule words, oldest first. Unrolled
+        // so the rotation below is register renaming rather than moves.
+#pragma GCC unroll 12
+        for (int group = 4; group < 16; group++) {
+            __m128i next = _mm_sha256msg1_epu32(w0, w1);
+            next = _mm_add_epi32(next, _mm_alignr_epi8(w3, w2, 4));
+            next = _mm_sha256msg2_epu32(next, w3);
+            RC_SHANI_FOUR_ROUNDS(next, &kRCSHA256K[4 * group]);
+            w0 = w1;
+            w1 = w2;
+            w2 = w3;
+            w3 = next;
+        }
+
+        state0 = _mm_add_epi32(state0, savedState0);
+        state1 = _mm_add_epi32(state1, savedState1);
+    }
+
+    __m128i feba = _mm_shuffle_epi32(state0, 0x1B);
+    __m128i dchg = _mm_shuffle_epi32(state1, 0xB1);
+    _mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(feba, dchg, 0xF0));
+    _mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(dchg, feba, 8));
+}
+
+#undef RC_SHANI_FOUR_ROUNDS
+
+#endif
+
+// MARK: ARMv8 cryptography extensions
+
+#if RC_SHA256_HAVE_ARMV8
+
+static bool RCSHA256CPUHasARMv8(void) {
+#if defined(__APPLE__)
+    return true;
+#elif defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+#else
+    return false;
+#endif
+}
+
+static void RCSHA256BlocksARMv8(uint32_t state[8], const uint8_t *blocks, size_t blockCount) {
+    uint32x4_t abcd = vld1q_u32(&state[0]);
+    uint32x4_t efgh = vld1q_u32(&state[4]);
+
+    for (size_t block = 0; block < blockCount; block++, blocks += RC_SHA256_BLOCK_LENGTH) {
+        uint32x4_t savedABCD = abcd;
+        uint32x4_t savedEFGH = efgh;
+
+        uint32x4_t w0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 0)));
+        uint32x4_t w1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 16)));
+        uint32x4_t w2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 32)));
+        uint32x4_t w3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 48)));
+
+#pragma GCC unroll 16
+        for (int group = 0; group < 16; group++) {
+            uint32x4_t message = w0;
+            if (group >= 4) {
+                message = vsha256su1q_u32(vsha256su0q_u32(w0, w1), w2, w3);
+            }
+            uint32x4_t wk = vaddq_u32(message, vld1q_u32(&kRCSHA256K[4 * group]));
+            uint32x4_t previousABCD = abcd;
+            abcd = vsha256hq_u32(abcd, efgh, wk);
+            efgh = vsha256h2q_u32(efgh, previousABCD, wk);
+            // w0..w3 hold the previous 16 schedule words, oldest first.
+            w0 = w1;
+            w1 = w2;
+            w2 = w3;
+            w3 = message;
+        }
+
+        abcd = vaddq_u32(abcd, savedABCD);
+        efgh = vaddq_u32(efgh, savedEFGH);
+    }
+
+    vst1q_u32(&state[0], abcd);
+    vst1q_u32(&state[4], efgh);
+}
+
+#endif
+
+// MARK: Dispatch
+
+static _Atomic(RCSHA256BlocksFunction) gRCSHA256Blocks = NULL;
+static _Atomic(int) gRCSHA256ActiveKernel = RCSHA256KernelAutomatic;
+
+static RCSHA256BlocksFunction RCSHA256BlocksForKernel(RCSHA256Kernel kernel) {
+    switch (kernel) {
+        case RCSHA256KernelScalar:
+            return RCSHA256BlocksScalar;
+#if RC_SHA256_HAVE_SHANI
+        case RCSHA256KernelSHANI:
+            return RCSHA256CPUHasSHANI() ? RCSHA256BlocksSHANI : NULL;
+#endif
+#if RC_SHA256_HAVE_ARMV8
+        case RCSHA256KernelARMv8:
+            return RCSHA256CPUHasARMv8() ? RCSHA256BlocksARMv8 : NULL;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+static RCSHA256Kernel RCSHA256FastestKernel(void) {
+    static const RCSHA256Kernel preference[] = { RCSHA256KernelSHANI, RCSHA256KernelARMv8 };
+    for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+        if (RCSHA256BlocksForKernel(preference[i]) != NULL) {
+            return preference[i];
+        }
+    }
+    return RCSHA256KernelScalar;
+}
+
+static void RCSHA256Activate(RCSHA256Kernel kernel) {
+    atomic_store_explicit(&gRCSHA256ActiveKernel, (int)kernel, memory_order_relaxed);
+    atomic_store_explicit(&gRCSHA256Blocks, RCSHA256BlocksForKernel(kernel), memory_order_release);
+}
+
+static RCSHA256BlocksFunction RCSHA256Blocks(void) {
+    RCSHA256BlocksFunction blocks = atomic_load_explicit(&gRCSHA256Blocks, memory_order_acquire);
+    if (blocks == NULL) {
+        // Racing first callers detect the same CPU and store the same kernel.
+        RCSHA256Activate(RCSHA256FastestKernel());
+        blocks = atomic_load_explicit(&gRCSHA256Blocks, memory_order_acquire);
+    }
+    return blocks;
+}
+
+bool RCSHA256KernelIsAvailable(RCSHA256Kernel kernel) {
+    return kernel == RCSHA256KernelAutomatic || RCSHA256BlocksForKernel(kernel) != NULL;
+}
+
+RCSHA256Kernel RCSHA256ActiveKernel(void) {
+    RCSHA256Blocks();
+    return (RCSHA256Kernel)atomic_load_explicit(&gRCSHA256ActiveKernel, memory_order_relaxed);
+}
+
+bool RCSHA256SetKernel(RCSHA256Kernel kernel) {
+    if (!RCSHA256KernelIsAvailable(kernel)) {
+        return false;
+    }
+    RCSHA256Activate(kernel == RCSHA256KernelAutomatic ? RCSHA256FastestKernel() : kernel);
+    return true;
+}
+
+const char *RCSHA256KernelName(RCSHA256Kernel kernel) {
+    switch (kernel) {
+        case RCSHA256KernelAutomatic:
+            return "automatic";
+        case RCSHA256KernelScalar:
+            return "scalar";
+        case RCSHA256KernelSHANI:
+            return "sha-ni";
+        case RCSHA256KernelARMv8:
+            return "armv8";
+    }
+    return "unknown";
+}
+
+// MARK: Hashing
+
+void RCSHA256Init(RCSHA256Context *context) {
+    memcpy(context->state, kRCSHA256InitialState, sizeof(context->state));
+    context->length = 0;
+    context->bufferLength = 0;
+}
+
+static void RCSHA256UpdateWithBlocks(RCSHA256Context *context,
+                                     RCSHA256BlocksFunction blocksFunction,
+                                     const uint8_t *bytes,
+                                     size_t length) {
+    context->length += length;
+
+    if (context->bufferLength > 0) {
+        size_t fill = RC_SHA256_BLOCK_LENGTH - context->bufferLength;
+        if (fill > length) {
+            fill = length;
+        }
+        memcpy(context->buffer + context->bufferLength, bytes, fill);
+        context->bufferLength += fill;
+        bytes += fill;
+        length -= fill;
+        if (context->bufferLength < RC_SHA256_BLOCK_LENGTH) {
+            return;
+        }
+        blocksFunction(context->state, context->buffer, 1);
+        context->bufferLength = 0;
+    }
+
+    size_t blockCount = length / RC_SHA256_BLOCK_LENGTH;
+    if (blockCount > 0) {
+        blocksFunction(context->state, bytes, blockCount);
+        bytes += blockCount * RC_SHA256_BLOCK_LENGTH;
+        length -= blockCount * RC_SHA256_BLOCK_LENGTH;
+    }
+
+    if (length > 0) {
+        memcpy(context->buffer, bytes, length);
+        context->bufferLength = length;
+    }
+}
+
+void RCSHA256Update(RCSHA256Context *context, const void *bytes, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    RCSHA256UpdateWithBlocks(context, RCSHA256Blocks(), bytes, length);
+}
+
+void RCSHA256UpdateEach(RCSHA256Context *const *contexts, size_t count, const void *bytes, size_t length) {
+    if (count == 1) {
+        RCSHA256Update(contexts[0], bytes, length);
+        return;
+    }
+    RCSHA256BlocksFunction blocksFunction = RCSHA256Blocks();
+    const uint8_t *cursor = bytes;
+    while (length > 0) {
+        size_t pieceLength = length < RC_SHA256_EACH_PIECE_LENGTH ? length : RC_SHA256_EACH_PIECE_LENGTH;
+        for (size_t i = 0; i < count; i++) {
+            RCSHA256UpdateWithBlocks(contexts[i], blocksFunction, cursor, pieceLength);
+        }
+        cursor += pieceLength;
+        length -= pieceLength;
+    }
+}
+
+void RCSHA256Final(RCSHA256Context *context, uint8_t digest[RC_SHA256_DIGEST_LENGTH]) {
+    RCSHA256BlocksFunction blocksFunction = RCSHA256Blocks();
+    uint64_t bitLength = context->length * 8;
+
+    context->buffer[context->bufferLength++] = 0x80;
+    if (context->bufferLength > RC_SHA256_BLOCK_LENGTH - 8) {
+        memset(context->buffer + context->bufferLength, 0, RC_SHA256_BLOCK_LENGTH - context->bufferLength);
+        blocksFunction(context->state, context->buffer, 1);
+        context->bufferLength = 0;
+    }
+    memset(context->buffer + context->bufferLength, 0, RC_SHA256_BLOCK_LENGTH - 8 - context->bufferLength);
+    for (int i = 0; i < 8; i++) {
+        context->buffer[RC_SHA256_BLOCK_LENGTH - 1 - i] = (uint8_t)(bitLength >> (8 * i));
+    }
+    blocksFunction(context->state, context->buffer, 1);
+
+    for (int i = 0; i < 8; i++) {
+        digest[4 * i + 0] = (uint8_t)(context->state[i] >> 24);
+        digest[4 * i + 1] = (uint8_t)(context->state[i] >> 16);
+        digest[4 * i + 2] = (uint8_t)(context->state[i] >> 8);
+        digest[4 * i + 3] = (uint8_t)context->state[i];
+    }
+    memset(context, 0, sizeof(*context));
+}
+
+void RCSHA256(const void *bytes, size_t length, uint8_t digest[RC_SHA256_DIGEST_LENGTH]) {
+    RCSHA256Context context;
+    RCSHA256Init(&context);
+    RCSHA256Update(&context, bytes, length);
+    RCSHA256Final(&context, digest);
+}
@@ -0,0 +1,85 @@
+//
+//  RCSHA256.h
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  SHA-256 (FIPS 180-4) with interchangeable block kernels, used for clip
+//  data hashes and blob digests. Three kernels compute the same compression
+//  function:
+//
+//    scalar   portable C, always available
+//    sha-ni   x86-64 SHA extensions (Intel Goldmont / Ice Lake and later,
+//             AMD Zen)
+//    armv8    ARMv8 cryptography extensions (every Apple silicon Mac)
+//
+//  The fastest kernel the CPU supports is picked on first use. Digests are
+//  byte-identical whichever kernel runs, and a context may be continued
+//  after the kernel changes.
+//
+
+#ifndef RCSHA256_h
+#define RCSHA256_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RC_SHA256_DIGEST_LENGTH 32
+#define RC_SHA256_BLOCK_LENGTH 64
+
+typedef enum {
+    /// Let RCSHA256 pick the fastest available kernel.
+    RCSHA256KernelAutomatic = 0,
+    RCSHA256KernelScalar,
+    RCSHA256KernelSHANI,
+    RCSHA256KernelARMv8,
+} RCSHA256Kernel;
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;
+    uint8_t buffer[RC_SHA256_BLOCK_LENGTH];
+    size_t bufferLength;
+} RCSHA256Context;
+
+// MARK: Hashing
+
+void RCSHA256Init(RCSHA256Context *context);
+void RCSHA256Update(RCSHA256Context *context, const void *bytes, size_t length);
+void RCSHA256Final(RCSHA256Context *context, uint8_t digest[RC_SHA256_DIGEST_LENGTH]);
+
+/// One-shot digest of a buffer.
+void RCSHA256(const void *bytes, size_t length, uint8_t digest[RC_SHA256_DIGEST_LENGTH]);
+
+/// Feeds the same bytes to several contexts in one pass over memory (for
+/// example a clip's data hash and the digest of a representation that goes
+/// to the blob store). The input is walked in cache-sized pieces, so a large
+/// buffer is read from RAM once rather than once per context.
+void RCSHA256UpdateEach(RCSHA256Context *const *contexts, size_t count, const void *bytes, size_t length);
+
+// MARK: Kernels
+
+/// Whether `kernel` is compiled in and supported by this CPU.
+/// RCSHA256KernelAutomatic is always available.
+bool RCSHA256KernelIsAvailable(RCSHA256Kernel kernel);
+
+/// The kernel used by subsequent updates (never RCSHA256KernelAutomatic).
+RCSHA256Kernel RCSHA256ActiveKernel(void);
+
+/// Forces a kernel for tests and benchmarks; RCSHA256KernelAutomatic returns
+/// to runtime selection. Returns false, leaving the selection unchanged,
+/// when the kernel is not available.
+bool RCSHA256SetKernel(RCSHA256Kernel kernel);
+
+const char *RCSHA256KernelName(RCSHA256Kernel kernel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RCSHA256_h */
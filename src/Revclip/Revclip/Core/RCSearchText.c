@@ -0,0 +1,231 @@
+//
+//  RCSearchText.c
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCSearchText.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Decodes one UTF-8 sequence. Returns -1 for an invalid / truncated sequence
+// (one byte is consumed in that case).
+static int32_t RCSearchTextDecode(const unsigned char *bytes, size_t length, size_t *consumed) {
+    unsigned char lead = bytes[0];
+    *consumed = 1;
+    if (lead < 0x80) {
+        return lead;
+    }
+
+    size_t sequenceLength;
+    int32_t codePoint;
+    int32_t minimum;
+    if ((lead & 0xE0) == 0xC0) {
+        sequenceLength = 2;
+        codePoint = lead & 0x1F;
+        minimum = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        sequenceLength = 3;
+        codePoint = lead & 0x0F;
+        minimum = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        sequenceLength = 4;
+        codePoint = lead & 0x07;
+        minimum = 0x10000;
+    } else {
+        return -1;
+    }
+    if (sequenceLength > length) {
+        return -1;
+    }
+
+    for (size_t index = 1; index < sequenceLength; index++) {
+        if ((bytes[index] & 0xC0) != 0x80) {
+            return -1;
+        }
+        codePoint = (codePoint << 6) | (bytes[index] & 0x3F);
+    }
+    if (codePoint < minimum || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+        return -1;
+    }
+    *consumed = sequenceLength;
+    return codePoint;
+}
+
+static bool RCSearchTextIsSeparator(int32_t codePoint) {
+    return codePoint <= 0x20
+        || (codePoint >= 0x7F && codePoint <= 0xA0)
+        || codePoint == 0x1680
+        || (codePoint >= 0x2000 && codePoint <= 0x200B)
+        || codePoint == 0x2028 || codePoint == 0x2029
+        || codePoint == 0x202F || codePoint == 0x205F
+        || codePoint == 0x3000 || codePoint == 0xFEFF;
+}
+
+// unicode61 keeps runs of these as one token; split them per character instead.
+static bool RCSearchTextIsCJK(int32_t codePoint) {
+    return (codePoint >= 0x3005 && codePoint <= 0x3007)     // 々〆〇
+        || (codePoint >= 0x3040 && codePoint <= 0x30FF)     // Hiragana, Katakana
+        || (codePoint >= 0x31F0 && codePoint <= 0x31FF)     // Katakana phonetic extensions
+        || (codePoint >= 0x3400 && codePoint <= 0x4DBF)     // CJK extension A
+        || (codePoint >= 0x4E00 && codePoint <= 0x9FFF)     // CJK unified ideographs
+        || (codePoint >= 0xAC00 && codePoint <= 0xD7AF)     // Hangul syllables
+        || (codePoint >= 0xF900 && codePoint <= 0xFAFF)     // CJK compatibility ideographs
+        || (codePoint >= 0xFF66 && codePoint <= 0xFF9F)     // Halfwidth Katakana
+        || (codePoint >= 0x20000 && codePoint <= 0x3FFFF);  // CJK extensions B+
+}
+
+static size_t RCSearchTextNormalizeInto(const unsigned char *text, size_t length, size_t maxBytes, char *out) {
+    size_t written = 0;
+    bool pendingSpace = false;
+    size_t offset = 0;
+    while (offset < length) {
+        size_t consumed = 0;
+        int32_t codePoint = RCSearchTextDecode(text + offset, length - offset, &consumed);
+        if (codePoint < 0 || RCSearchTextIsSeparator(codePoint)) {
+            pendingSpace = (written > 0);
+            offset += consumed;
+            continue;
+        }
+
+        bool isCJK = RCSearchTextIsCJK(codePoint);
+        if (isCJK && written > 0) {
+            pendingSpace = true;
+        }
+        size_t needed = consumed + (pendingSpace ? 1 : 0);
+        if (written + needed > maxBytes) {
+            break;
+        }
+        if (pendingSpace) {
+            out[written++] = ' ';
+        }
+        memcpy(out + written, text + offset, consumed);
+        written += consumed;
+        pendingSpace = isCJK;
+        offset += consumed;
+    }
+    out[written] = '\0';
+    return written;
+}
+
+char *RCSearchTextCopyNormalized(const char *text, size_t length, size_t maxBytes, size_t *outLength) {
+    if (text == NULL) {
+        length = 0;
+    }
+    // Every character expands by at most one separator.
+    size_t limit = length * 2 < maxBytes ? length * 2 : maxBytes;
+    char *out = malloc(limit + 1);
+    if (out == NULL) {
+        return NULL;
+    }
+
+    size_t written = RCSearchTextNormalizeInto((const unsigned char *)text, length, limit, out);
+    if (outLength != NULL) {
+        *outLength = written;
+    }
+    return out;
+}
+
+static bool RCSearchTextHasSearchableCharacter(const char *term, size_t length) {
+    for (size_t index = 0; index < length; index++) {
+        unsigned char character = (unsigned char)term[index];
+        if (character >= 0x80
+            || (character >= '0' && character <= '9')
+            || (character >= 'a' && character <= 'z')
+            || (character >= 'A' && character <= 'Z')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+char *RCSearchTextCopyMatchExpression(const char *query, size_t length) {
+    if (query == NULL || length == 0) {
+        return NULL;
+    }
+
+    // Worst case: every byte is a doubled quote or a CJK separator, plus
+    // `"` `"*` and a joining space per term.
+    char *expression = malloc(length * 4 + 1);
+    char *normalized = malloc(length * 2 + 1);
+    if (expression == NULL || normalized == NULL) {
+        free(expression);
+        free(normalized);
+        return NULL;
+    }
+
+    const unsigned char *bytes = (const unsigned char *)query;
+    size_t written = 0;
+    size_t lastTermEnd = 0;
+    size_t offset = 0;
+    while (offset < length) {
+        size_t consumed = 0;
+        int32_t codePoint = RCSearchTextDecode(bytes + offset, length - offset, &consumed);
+        if (codePoint < 0 || RCSearchTextIsSeparator(codePoint)) {
+            offset += consumed;
+            continue;
+        }
+
+        size_t termStart = offset;
+        while (offset < length) {
+            codePoint = RCSearchTextDecode(bytes + offset, length - offset, &consumed);
+            if (codePoint < 0 || RCSearchTextIsSeparator(codePoint)) {
+                break;
+            }
+            offset += consumed;
+        }
+
+        size_t termLength = RCSearchTextNormalizeInto(bytes + termStart, offset - termStart, length * 2, normalized);
+        if (!RCSearchTextHasSearchableCharacter(normalized, termLength)) {
+            continue;
+        }
+
+        if (written > 0) {
+            expression[written++] = ' ';
+        }
+        expression[written++] = '"';
+        for (size_t index = 0; index < termLength; index++) {
+            if (normalized[index] == '"') {
+                expression[written++] = '"';
+            }
+            expression[written++] = normalized[index];
+        }
+        expression[written++] = '"';
+        lastTermEnd = written;
+    }
+    free(normalized);
+
+    if (written == 0) {
+        free(expression);
+        return NULL;
+    }
+    // Only the term being typed is a prefix; exact earlier terms keep the
+    // doclist merge (and the bm25 pass) cheap.
+    expression[lastTermEnd] = '*';
+    expression[lastTermEnd + 1] = '\0';
+    return expression;
+}
+
+static void RCSearchTextSQLFunction(sqlite3_context *context, int argc, sqlite3_value **argv) {
+    (void)argc;
+    const unsigned char *text = sqlite3_value_text(argv[0]);
+    size_t length = (size_t)sqlite3_value_bytes(argv[0]);
+    size_t normalizedLength = 0;
+    char *normalized = RCSearchTextCopyNormalized((const char *)text, text != NULL ? length : 0,
+                                                  RC_SEARCH_TEXT_MAX_BYTES, &normalizedLength);
+    if (normalized == NULL) {
+        sqlite3_result_error_nomem(context);
+        return;
+    }
+    sqlite3_result_text(context, normalized, (int)normalizedLength, free);
+}
+
+int RCSearchTextRegisterFunctions(sqlite3 *db) {
+    return sqlite3_create_function_v2(db, "rc_search_text", 1,
+                                      SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS,
+                                      NULL, RCSearchTextSQLFunction, NULL, NULL, NULL);
+}
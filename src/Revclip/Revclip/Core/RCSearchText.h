@@ -0,0 +1,48 @@
+//
+//  RCSearchText.h
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Text normalization for the FTS5 search index (clip_search / snippet_search).
+//  Portable C so the app and the Linux benchmarks index exactly the same text.
+//
+
+#ifndef RCSearchText_h
+#define RCSearchText_h
+
+#include <sqlite3.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Upper bound, in bytes, of the normalized text indexed per document.
+#define RC_SEARCH_TEXT_MAX_BYTES 16384
+
+/// Normalizes UTF-8 text for the `unicode61` tokenizer:
+///   - runs of whitespace / control characters collapse to one space, trimmed
+///   - CJK characters (kana, kanji, hangul) become one token each, so words
+///     written without spaces can be found as phrases ("東京" -> "東 京")
+///   - invalid UTF-8 bytes are treated as separators
+///   - the result is cut at a character boundary after at most `maxBytes`
+/// Returns a malloc'd NUL-terminated string (caller frees), or NULL on OOM.
+char *RCSearchTextCopyNormalized(const char *text, size_t length, size_t maxBytes, size_t *outLength);
+
+/// Builds an FTS5 MATCH expression from free-form user input. Every
+/// whitespace-separated term becomes a quoted phrase, all terms must match,
+/// and the last one is matched as a prefix ("foo 東京" -> "\"foo\" \"東 京\"*").
+/// Returns a malloc'd string, or NULL when the input has no searchable term.
+char *RCSearchTextCopyMatchExpression(const char *query, size_t length);
+
+/// Registers `rc_search_text(text)` (deterministic, RCSearchTextCopyNormalized
+/// with RC_SEARCH_TEXT_MAX_BYTES) on `db`. The search triggers call it, so it
+/// must be registered on every connection that writes clip_items / snippets.
+int RCSearchTextRegisterFunctions(sqlite3 *db);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RCSearchText_h */
@@ -0,0 +1,304 @@
+//
+//  RCTrace.c
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#include "RCTrace.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RC_TRACE_BUFFER_MASK (RC_TRACE_BUFFER_CAPACITY - 1)
+#define RC_TRACE_THREAD_NAME_LENGTH 32
+
+typedef struct {
+    // index + 1 of the span in the slot once published, 0 while being written.
+    _Atomic uint64_t sequence;
+    const char *name;
+    uint64_t start;
+    uint64_t duration;
+    uint64_t captureId;
+    bool async;
+} RCTraceSlot;
+
+typedef struct RCTraceBuffer {
+    struct RCTraceBuffer *next;
+    uint32_t lane;
+    _Atomic bool owned;
+    char threadName[RC_TRACE_THREAD_NAME_LENGTH];
+    // Spans ever written; only the owning thread stores it.
+    _Atomic uint64_t head;
+    RCTraceSlot slots[RC_TRACE_BUFFER_CAPACITY];
+} RCTraceBuffer;
+
+typedef struct {
+    const char *name;
+    uint64_t start;
+    uint64_t duration;
+    uint64_t captureId;
+    bool async;
+} RCTraceSpan;
+
+static _Atomic bool gRCTraceEnabled;
+static _Atomic(RCTraceBuffer *) gRCTraceBuffers;
+static _Atomic uint32_t gRCTraceLaneCount;
+static _Atomic uint64_t gRCTraceResetNanoseconds;
+static pthread_key_t gRCTraceThreadKey;
+static pthread_once_t gRCTraceThreadKeyOnce = PTHREAD_ONCE_INIT;
+static _Thread_local RCTraceBuffer *tRCTraceBuffer;
+
+// MARK: Buffers
+
+static void RCTraceThreadDidExit(void *value) {
+    RCTraceBuffer *buffer = value;
+    atomic_store_explicit(&buffer->owned, false, memory_order_release);
+}
+
+static void RCTraceCreateThreadKey(void) {
+    pthread_key_create(&gRCTraceThreadKey, RCTraceThreadDidExit);
+}
+
+static RCTraceBuffer *RCTraceClaimBuffer(void) {
+    pthread_once(&gRCTraceThreadKeyOnce, RCTraceCreateThreadKey);
+
+    RCTraceBuffer *buffer = NULL;
+    for (RCTraceBuffer *candidate = atomic_load_explicit(&gRCTraceBuffers, memory_order_acquire);
+         candidate != NULL;
+         candidate = candidate->next) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong_explicit(&candidate->owned, &expected, true,
+                                                    memory_order_acquire, memory_order_relaxed)) {
+            buffer = candidate;
+            break;
+        }
+    }
+
+    if (buffer == NULL) {
+        buffer = calloc(1, sizeof(*buffer));
+        if (buffer == NULL) {
+            return NULL;
+        }
+        atomic_init(&buffer->owned, true);
+        buffer->lane = atomic_fetch_add_explicit(&gRCTraceLaneCount, 1, memory_order_relaxed) + 1;
+        RCTraceBuffer *head = atomic_load_explicit(&gRCTraceBuffers, memory_order_relaxed);
+        do {
+            buffer->next = head;
+        } while (!atomic_compare_exchange_weak_explicit(&gRCTraceBuffers, &head, buffer,
+                                                        memory_order_release, memory_order_relaxed));
+    }
+
+    buffer->threadName[0] = '\0';
+    pthread_setspecific(gRCTraceThreadKey, buffer);
+    tRCTraceBuffer = buffer;
+    return buffer;
+}
+
+static void RCTraceAppend(const char *name, uint64_t start, uint64_t duration, uint64_t captureId, bool async) {
+    RCTraceBuffer *buffer = tRCTraceBuffer;
+    if (buffer == NULL) {
+        buffer = RCTraceClaimBuffer();
+        if (buffer == NULL) {
+            return;
+        }
+    }
+
+    uint64_t index = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    RCTraceSlot *slot = &buffer->slots[index & RC_TRACE_BUFFER_MASK];
+    atomic_store_explicit(&slot->sequence, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->name = name;
+    slot->start = start;
+    slot->duration = duration;
+    slot->captureId = captureId;
+    slot->async = async;
+    atomic_store_explicit(&slot->sequence, index + 1, memory_order_release);
+    atomic_store_explicit(&buffer->head, index + 1, memory_order_release);
+}
+
+// Copies the published spans of `buffer` that start after the last reset,
+// oldest first. `outSpans` needs RC_TRACE_BUFFER_CAPACITY entries.
+static size_t RCTraceCopyBuffer(RCTraceBuffer *buffer, RCTraceSpan *outSpans) {
+    uint64_t resetNanoseconds = atomic_load_explicit(&gRCTraceResetNanoseconds, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+    uint64_t first = head > RC_TRACE_BUFFER_CAPACITY ? head - RC_TRACE_BUFFER_CAPACITY : 0;
+    size_t count = 0;
+    for (uint64_t index = first; index < head; index++) {
+        RCTraceSlot *slot = &buffer->slots[index & RC_TRACE_BUFFER_MASK];
+        if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != index + 1) {
+            continue;
+        }
+        RCTraceSpan span = { slot->name, slot->start, slot->duration, slot->captureId, slot->async };
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->sequence, memory_order_relaxed) != index + 1) {
+            continue;
+        }
+        if (span.start < resetNanoseconds) {
+            continue;
+        }
+        outSpans[count++] = span;
+    }
+    return count;
+}
+
+// MARK: JSON
+
+static bool RCTraceWriteJSONString(FILE *file, const char *string) {
+    if (fputc('"', file) == EOF) {
+        return false;
+    }
+    for (const unsigned char *cursor = (const unsigned char *)string; *cursor != '\0'; cursor++) {
+        int written = 0;
+        if (*cursor == '"' || *cursor == '\\') {
+            written = fprintf(file, "\\%c", *cursor);
+        } else if (*cursor < 0x20) {
+            written = fprintf(file, "\\u%04x", *cursor);
+        } else {
+            written = fputc(*cursor, file) == EOF ? -1 : 1;
+        }
+        if (written < 0) {
+            return false;
+        }
+    }
+    return fputc('"', file) != EOF;
+}
+
+// Async spans become a begin / end pair keyed by the capture id, which
+// chrome://tracing draws on a track of their own instead of the lane.
+static bool RCTraceWriteAsyncEvent(FILE *file, const RCTraceSpan *span, uint32_t lane, char phase, uint64_t timestamp) {
+    return fprintf(file, ",{\"ph\":\"%c\",\"cat\":\"capture\",\"id\":%llu,\"name\":", phase,
+                   (unsigned long long)span->captureId) >= 0
+        && RCTraceWriteJSONString(file, span->name != NULL ? span->name : "")
+        && fprintf(file, ",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", lane, (double)timestamp / 1000.0) >= 0;
+}
+
+// MARK: Public
+
+uint64_t RCTraceNowNanoseconds(void) {
+#ifdef __APPLE__
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+void RCTraceSetEnabled(bool enabled) {
+    atomic_store_explicit(&gRCTraceEnabled, enabled, memory_order_relaxed);
+}
+
+bool RCTraceIsEnabled(void) {
+    return atomic_load_explicit(&gRCTraceEnabled, memory_order_relaxed);
+}
+
+uint64_t RCTraceBegin(void) {
+    return RCTraceIsEnabled() ? RCTraceNowNanoseconds() : 0;
+}
+
+void RCTraceEnd(const char *name, uint64_t begin, uint64_t captureId) {
+    if (begin == 0) {
+        return;
+    }
+    uint64_t end = RCTraceNowNanoseconds();
+    RCTraceAppend(name, begin, end > begin ? end - begin : 0, captureId, false);
+}
+
+void RCTraceRecordSpan(const char *name, uint64_t start, uint64_t end, uint64_t captureId) {
+    if (start == 0 || !RCTraceIsEnabled()) {
+        return;
+    }
+    RCTraceAppend(name, start, end > start ? end - start : 0, captureId, false);
+}
+
+void RCTraceRecordAsyncSpan(const char *name, uint64_t start, uint64_t end, uint64_t captureId) {
+    if (start == 0 || !RCTraceIsEnabled()) {
+        return;
+    }
+    RCTraceAppend(name, start, end > start ? end - start : 0, captureId, true);
+}
+
+void RCTraceSetCurrentThreadName(const char *name) {
+    RCTraceBuffer *buffer = tRCTraceBuffer;
+    if (buffer == NULL) {
+        buffer = RCTraceClaimBuffer();
+        if (buffer == NULL) {
+            return;
+        }
+    }
+    strncpy(buffer->threadName, name != NULL ? name : "", RC_TRACE_THREAD_NAME_LENGTH - 1);
+    buffer->threadName[RC_TRACE_THREAD_NAME_LENGTH - 1] = '\0';
+}
+
+void RCTraceReset(void) {
+    atomic_store_explicit(&gRCTraceResetNanoseconds, RCTraceNowNanoseconds(), memory_order_relaxed);
+}
+
+size_t RCTraceSpanCount(void) {
+    RCTraceSpan *spans = malloc(sizeof(RCTraceSpan) * RC_TRACE_BUFFER_CAPACITY);
+    if (spans == NULL) {
+        return 0;
+    }
+    size_t total = 0;
+    for (RCTraceBuffer *buffer = atomic_load_explicit(&gRCTraceBuffers, memory_order_acquire);
+         buffer != NULL;
+         buffer = buffer->next) {
+        total += RCTraceCopyBuffer(buffer, spans);
+    }
+    free(spans);
+    return total;
+}
+
+bool RCTraceWriteChromeJSON(FILE *file) {
+    RCTraceSpan *spans = malloc(sizeof(RCTraceSpan) * RC_TRACE_BUFFER_CAPACITY);
+    if (spans == NULL) {
+        return false;
+    }
+
+    bool ok = fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file) != EOF;
+    bool first = true;
+    for (RCTraceBuffer *buffer = atomic_load_explicit(&gRCTraceBuffers, memory_order_acquire);
+         ok && buffer != NULL;
+         buffer = buffer->next) {
+        size_t count = RCTraceCopyBuffer(buffer, spans);
+        if (count == 0) {
+            continue;
+        }
+
+        char threadName[RC_TRACE_THREAD_NAME_LENGTH];
+        memcpy(threadName, buffer->threadName, sizeof(threadName));
+        threadName[RC_TRACE_THREAD_NAME_LENGTH - 1] = '\0';
+        if (threadName[0] == '\0') {
+            snprintf(threadName, sizeof(threadName), "lane %u", buffer->lane);
+        }
+        ok = fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                     first ? "" : ",", buffer->lane) >= 0
+            && RCTraceWriteJSONString(file, threadName)
+            && fputs("}}", file) != EOF;
+        first = false;
+
+        for (size_t index = 0; ok && index < count; index++) {
+            const RCTraceSpan *span = &spans[index];
+            if (span->async) {
+                ok = RCTraceWriteAsyncEvent(file, span, buffer->lane, 'b', span->start)
+                    && RCTraceWriteAsyncEvent(file, span, buffer->lane, 'e', span->start + span->duration);
+                continue;
+            }
+            ok = fputs(",{\"ph\":\"X\",\"cat\":\"capture\",\"name\":", file) != EOF
+                && RCTraceWriteJSONString(file, span->name != NULL ? span->name : "")
+                && fprintf(file, ",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f", buffer->lane,
+                           (double)span->start / 1000.0, (double)span->duration / 1000.0) >= 0;
+            if (ok && span->captureId != 0) {
+                ok = fprintf(file, ",\"args\":{\"capture\":%llu}", (unsigned long long)span->captureId) >= 0;
+            }
+            ok = ok && fputc('}', file) != EOF;
+        }
+    }
+    ok = ok && fputs("]}\n", file) != EOF;
+    free(spans);
+    return ok;
+}
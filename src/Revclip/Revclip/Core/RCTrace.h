@@ -0,0 +1,83 @@
+//
+//  RCTrace.h
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  In-process span recorder for tracing a clip from the poll tick that sees
+//  it to the menu rebuild that shows it. Each thread appends to its own ring
+//  buffer of the last RC_TRACE_BUFFER_CAPACITY spans, so recording takes no
+//  lock and never allocates after the thread's first span:
+//
+//    - the writer fills a slot and publishes it with a release store of its
+//      sequence number; a reader copies the slot and keeps it only when the
+//      sequence is unchanged afterwards, so a slot overwritten mid-copy is
+//      skipped instead of torn
+//    - buffers live on a lock-free list for the life of the process; when a
+//      thread exits its buffer is handed to the next thread that records
+//      (GCD creates and retires worker threads all the time), and the Chrome
+//      trace shows one lane per buffer
+//
+//  Disabled by default; RCTraceBegin then returns 0 and RCTraceEnd returns at
+//  once. Span names must be string literals (the pointer is stored). The
+//  recorded spans are dumped as Chrome trace JSON (chrome://tracing,
+//  Perfetto) on demand.
+//
+
+#ifndef RCTrace_h
+#define RCTrace_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Spans kept per thread (a power of two).
+#define RC_TRACE_BUFFER_CAPACITY 4096
+
+/// Same monotonic clock as RCQueryMetricsNowNanoseconds.
+uint64_t RCTraceNowNanoseconds(void);
+
+void RCTraceSetEnabled(bool enabled);
+bool RCTraceIsEnabled(void);
+
+/// Start of a span: the current time, or 0 while tracing is disabled.
+uint64_t RCTraceBegin(void);
+/// Records `name` from `begin` (an RCTraceBegin result) to now. Does nothing
+/// when `begin` is 0. `captureId` ties the spans of one clip together (0 for
+/// none) and appears as args.capture in the trace.
+void RCTraceEnd(const char *name, uint64_t begin, uint64_t captureId);
+/// Records a span whose ends were measured by the caller (e.g. across
+/// queues). Does nothing while disabled or when `start` is 0.
+void RCTraceRecordSpan(const char *name, uint64_t start, uint64_t end, uint64_t captureId);
+/// Like RCTraceRecordSpan, for a span that starts on one thread and ends on
+/// another (a clip from detection to display). It is written as an async
+/// event pair keyed by `captureId` so it does not have to nest inside the
+/// recording thread's spans.
+void RCTraceRecordAsyncSpan(const char *name, uint64_t start, uint64_t end, uint64_t captureId);
+
+/// Names the calling thread's lane in the trace (copied, truncated to 31
+/// bytes). Takes effect for the buffer the thread records into.
+void RCTraceSetCurrentThreadName(const char *name);
+
+/// Hides every span recorded so far from later dumps.
+void RCTraceReset(void);
+
+/// Number of spans a dump would contain right now.
+size_t RCTraceSpanCount(void);
+
+/// Writes the recorded spans as a Chrome trace JSON object
+/// ({"traceEvents": [...]}, "X" events and "b"/"e" pairs, microseconds,
+/// one lane per thread buffer named by a thread_name record). Safe while
+/// other threads record. Returns false on a write error.
+bool RCTraceWriteChromeJSON(FILE *file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RCTrace_h */
@@ -0,0 +1,54 @@
+//
+//  RCClipBlobStore.h
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// ClipsData/Blobs 以下の内容アドレス型ペイロードストア。
+// 大きな表現（TIFF / PDF / RTF / RTFD）を SHA-256 ダイジェスト名のファイルとして 1 度だけ保存し、
+// .rcclip はダイジェストで参照する。参照数は RCDatabaseManager の clip_blobs が持つ。
+// kRCPrefCompressClipDataKey が有効なら、圧縮できるペイロードは 1 セクション
+// （RCClipSectionBlob）の .rcclip コンテナとして圧縮して保存する。ダイジェストは常に展開後の内容に対するもの。
+@interface RCClipBlobStore : NSObject
+
++ (instancetype)shared;
+
+@property (nonatomic, copy, readonly) NSString *blobDirectoryPath;
+
+// 参照が無くなったブロブでも、最終書き込みからこの秒数が経つまでは削除しない
+// （保存済みで DB への参照登録がまだのキャプチャを守る）。既定 60 秒。
+@property (atomic, assign) NSTimeInterval releaseGracePeriod;
+
+/// Stores `data` under its SHA-256 digest and returns the lowercase hex digest.
+/// An existing identical blob is reused (its modification date is refreshed so
+/// a concurrent release does not delete it). Returns nil on failure.
+- (nullable NSString *)storeData:(NSData *)data;
+/// Same as storeData:, reusing a digest the caller already computed over
+/// `data` (see -[RCClipData storageDigests]) instead of hashing it again.
+/// A nil or malformed digest falls back to hashing.
+- (nullable NSString *)storeData:(NSData *)data digest:(nullable NSString *)digest;
+
+/// Returns the (decompressed) blob contents, or nil when the digest is
+/// malformed, the blob is missing or it fails to decode.
+- (nullable NSData *)dataForDigest:(NSString *)digest;
+
+/// Blob file path for a hex digest, or nil when the digest is malformed.
+- (nullable NSString *)pathForDigest:(NSString *)digest;
+
+/// Deletes the blob for a digest whose last reference went away, unless
+/// `isReferenced` (evaluated under the store lock) reports it is in use again.
+/// Returns NO when the blob was written within releaseGracePeriod and must be
+/// retried later; YES when the digest no longer needs tracking.
+- (BOOL)removeReleasedBlobWithDigest:(NSString *)digest isReferenced:(BOOL (^)(void))isReferenced;
+
+/// Hex digests of every blob file on disk (for the orphan sweep).
+- (NSArray<NSString *> *)storedDigests;
+
+@end
+
+NS_ASSUME_NONNULL_END
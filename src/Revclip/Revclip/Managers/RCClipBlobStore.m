@@ -0,0 +1,294 @@
+//
+//  RCClipBlobStore.m
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#import "RCClipBlobStore.h"
+
+#import <os/log.h>
+
+#import "RCClipContainer.h"
+#import "RCConstants.h"
+#import "RCPanicEraseService.h"
+#import "RCSHA256.h"
+#import "RCUtilities.h"
+
+static NSString * const kRCClipBlobDirectoryName = @"Blobs";
+static NSString * const kRCClipBlobFileExtension = @"rcblob";
+static NSTimeInterval const kRCClipBlobDefaultReleaseGracePeriod = 60.0;
+
+static os_log_t RCClipBlobStoreLog(void) {
+    static os_log_t logger = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        logger = os_log_create("com.revclip", "RCClipBlobStore");
+    });
+    return logger;
+}
+
+@interface RCClipBlobStore ()
+
+- (BOOL)isValidDigest:(NSString *)digest;
+- (BOOL)ensureBlobDirectory;
+- (BOOL)isStoredBlobAtPath:(NSString *)path length:(NSUInteger)length;
+- (BOOL)writeData:(NSData *)data toPath:(NSString *)path;
+
+@end
+
+@implementation RCClipBlobStore
+
++ (instancetype)shared {
+    static RCClipBlobStore *sharedStore = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedStore = [[self alloc] init];
+    });
+    return sharedStore;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _blobDirectoryPath = [[RCUtilities clipDataDirectoryPath] stringByAppendingPathComponent:kRCClipBlobDirectoryName];
+        _releaseGracePeriod = kRCClipBlobDefaultReleaseGracePeriod;
+    }
+    return self;
+}
+
+#pragma mark - Public
+
+- (nullable NSString *)storeData:(NSData *)data {
+    return [self storeData:data digest:nil];
+}
+
+- (nullable NSString *)storeData:(NSData *)data digest:(nullable NSString *)digest {
+    if (data.length == 0 || data.length > UINT32_MAX) {
+        return nil;
+    }
+
+    if (![self isValidDigest:digest]) {
+        uint8_t digestBytes[RC_SHA256_DIGEST_LENGTH];
+        RCSHA256(data.bytes, data.length, digestBytes);
+        digest = [RCUtilities hexStringFromBytes:digestBytes length:RC_SHA256_DIGEST_LENGTH];
+    }
+    NSString *path = [self pathForDigest:digest];
+
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    @synchronized (self) {
+        if (![self ensureBlobDirectory]) {
+            return nil;
+        }
+
+        // 同じ内容が既にあれば書き込まず、解放処理の猶予期間だけ延ばす。
+        if ([self isStoredBlobAtPath:path length:data.length]) {
+            [fileManager setAttributes:@{ NSFileModificationDate: [NSDate date] } ofItemAtPath:path error:nil];
+            return digest;
+        }
+        if (![self writeData:data toPath:path]) {
+            return nil;
+        }
+    }
+    return digest;
+}
+
+- (nullable NSData *)dataForDigest:(NSString *)digest {
+    NSString *path = [self pathForDigest:digest];
+    if (path == nil) {
+        return nil;
+    }
+
+    NSError *readError = nil;
+    // 解放時にゼロ埋めしてから削除するため、マップせずに読み込む。
+    NSData *data = [NSData dataWithContentsOfFile:path options:0 error:&readError];
+    if (data == nil) {
+        os_log_error(RCClipBlobStoreLog(),
+                     "Failed to read clip blob %{private}@ (%{private}@)",
+                     path, readError.localizedDescription);
+        return nil;
+    }
+    // マジックで始まらないファイルは圧縮前に書かれた生のブロブ。
+    if (!RCClipContainerHasMagic(data.bytes, data.length)) {
+        return data;
+    }
+
+    RCClipContainer *container = NULL;
+    RCClipSection section;
+    uint64_t decodedLength = 0;
+    NSMutableData *decoded = nil;
+    RCClipContainerStatus status = RCClipContainerOpenBytes(data.bytes, data.length, &container);
+    if (status == RCClipContainerOK) {
+        status = RCClipContainerFindSection(container, RCClipSectionBlob, &section);
+    }
+    if (status == RCClipContainerOK) {
+        status = RCClipSectionDecodedLength(&section, &decodedLength);
+    }
+    if (status == RCClipContainerOK) {
+        decoded = [NSMutableData dataWithLength:(NSUInteger)decodedLength];
+        status = decoded != nil ? RCClipSectionDecode(&section, decoded.mutableBytes, decoded.length)
+                                : RCClipContainerNoMemory;
+    }
+    RCClipContainerClose(container);
+    if (status != RCClipContainerOK) {
+        os_log_error(RCClipBlobStoreLog(), "Unreadable clip blob %{private}@ (status %d)", path, (int)status);
+        return nil;
+    }
+    return decoded;
+}
+
+- (nullable NSString *)pathForDigest:(NSString *)digest {
+    if (![self isValidDigest:digest]) {
+        return nil;
+    }
+    NSString *fileName = [digest.lowercaseString stringByAppendingPathExtension:kRCClipBlobFileExtension];
+    return [self.blobDirectoryPath stringByAppendingPathComponent:fileName];
+}
+
+- (BOOL)removeReleasedBlobWithDigest:(NSString *)digest isReferenced:(BOOL (^)(void))isReferenced {
+    NSString *path = [self pathForDigest:digest];
+    if (path == nil) {
+        return YES;
+    }
+
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    @synchronized (self) {
+        if (isReferenced != nil && isReferenced()) {
+            return YES;
+        }
+
+        NSDictionary<NSFileAttributeKey, id> *attributes = [fileManager attributesOfItemAtPath:path error:nil];
+        if (attributes == nil) {
+            return YES;
+        }
+        NSDate *modifiedDate = attributes.fileModificationDate;
+        if (modifiedDate != nil && [[NSDate date] timeIntervalSinceDate:modifiedDate] < self.releaseGracePeriod) {
+            return NO;
+        }
+
+        [RCPanicEraseService secureOverwriteFileAtPath:path];
+        NSError *removeError = nil;
+        if (![fileManager removeItemAtPath:path error:&removeError]) {
+            os_log_error(RCClipBlobStoreLog(),
+                         "Failed to remove clip blob %{private}@ (%{private}@)",
+                         path, removeError.localizedDescription);
+            return NO;
+        }
+    }
+    return YES;
+}
+
+- (NSArray<NSString *> *)storedDigests {
+    NSArray<NSString *> *fileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:self.blobDirectoryPath
+                                                                                         error:nil];
+    NSMutableArray<NSString *> *digests = [NSMutableArray array];
+    for (NSString *fileName in fileNames) {
+        if (![fileName.pathExtension isEqualToString:kRCClipBlobFileExtension]) {
+            continue;
+        }
+        NSString *digest = fileName.stringByDeletingPathExtension;
+        if ([self isValidDigest:digest]) {
+            [digests addObject:digest];
+        }
+    }
+    return [digests copy];
+}
+
+#pragma mark - Private
+
+// 生のブロブはファイルサイズ、コンテナのブロブは展開後の長さで照合する。
+- (BOOL)isStoredBlobAtPath:(NSString *)path length:(NSUInteger)length {
+    RCClipContainer *container = NULL;
+    RCClipContainerStatus status = RCClipContainerOpenFile(path.fileSystemRepresentation, &container);
+    if (status == RCClipContainerNotContainer) {
+        NSDictionary<NSFileAttributeKey, id> *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:path
+                                                                                                          error:nil];
+        return attributes != nil && attributes.fileSize == length;
+    }
+    if (status != RCClipContainerOK) {
+        return NO;
+    }
+    // 書き込み済みのペイロードは読まず、TOC と長さの接頭辞だけを見る。
+    BOOL matches = NO;
+    for (uint32_t index = 0; index < RCClipContainerSectionCount(container); index++) {
+        RCClipSection section;
+        uint64_t decodedLength = 0;
+        if (RCClipContainerSectionAtIndex(container, index, &section) == RCClipContainerOK
+            && section.type == RCClipSectionBlob) {
+            matches = RCClipSectionDecodedLength(&section, &decodedLength) == RCClipContainerOK
+                && decodedLength == length;
+            break;
+        }
+    }
+    RCClipContainerClose(container);
+    return matches;
+}
+
+// 冷たいデータとして圧縮できればブロブ用の 1 セクションのコンテナに、できなければ従来どおり生で書く。
+// 生の内容がたまたまコンテナのマジックで始まる場合は、読み出し時に取り違えないよう必ずコンテナに包む。
+- (BOOL)writeData:(NSData *)data toPath:(NSString *)path {
+    BOOL compress = [[NSUserDefaults standardUserDefaults] boolForKey:kRCPrefCompressClipDataKey];
+    RCClipCodec codec = compress
+        ? RCClipCompressionChooseCodec(data.bytes, data.length, RCClipCompressionCold)
+        : RCClipCodecNone;
+    uint8_t *payload = NULL;
+    size_t payloadLength = 0;
+    if (codec != RCClipCodecNone && !RCClipCompressionEncode(codec, data.bytes, data.length, &payload, &payloadLength)) {
+        codec = RCClipCodecNone;
+    }
+
+    if (codec == RCClipCodecNone && !RCClipContainerHasMagic(data.bytes, data.length)) {
+        NSError *writeError = nil;
+        if (![data writeToFile:path options:NSDataWritingAtomic error:&writeError]) {
+            os_log_error(RCClipBlobStoreLog(),
+                         "Failed to write clip blob %{private}@ (%{private}@)",
+                         path, writeError.localizedDescription);
+            return NO;
+        }
+        [[NSFileManager defaultManager] setAttributes:@{ NSFilePosixPermissions: @(0600) } ofItemAtPath:path error:nil];
+        return YES;
+    }
+
+    // WriteFile は mkstemp（0600）の一時ファイルから rename する。
+    RCClipContainerWriter *writer = RCClipContainerWriterCreate();
+    RCClipContainerStatus status = writer != NULL ? RCClipContainerOK : RCClipContainerNoMemory;
+    if (status == RCClipContainerOK) {
+        status = codec != RCClipCodecNone
+            ? RCClipContainerWriterAddSection(writer, RCClipSectionBlob, RCClipSectionFlagsForCodec(codec),
+                                              payload, payloadLength)
+            : RCClipContainerWriterAddSection(writer, RCClipSectionBlob, 0, data.bytes, data.length);
+    }
+    if (status == RCClipContainerOK) {
+        status = RCClipContainerWriterWriteFile(writer, path.fileSystemRepresentation);
+    }
+    RCClipContainerWriterDestroy(writer);
+    free(payload);
+    if (status != RCClipContainerOK) {
+        os_log_error(RCClipBlobStoreLog(), "Failed to write clip blob %{private}@ (status %d)", path, (int)status);
+        return NO;
+    }
+    return YES;
+}
+
+- (BOOL)isValidDigest:(NSString *)digest {
+    if (digest.length != RC_SHA256_DIGEST_LENGTH * 2) {
+        return NO;
+    }
+    return [RCUtilities dataFromHexString:digest] != nil;
+}
+
+- (BOOL)ensureBlobDirectory {
+    NSError *directoryError = nil;
+    BOOL created = [[NSFileManager defaultManager] createDirectoryAtPath:self.blobDirectoryPath
+                                             withIntermediateDirectories:YES
+                                                              attributes:@{ NSFilePosixPermissions: @(0700) }
+                                                                   error:&directoryError];
+    if (!created) {
+        os_log_error(RCClipBlobStoreLog(),
+                     "Failed to create clip blob directory %{private}@ (%{private}@)",
+                     self.blobDirectoryPath, directoryError.localizedDescription);
+    }
+    return created;
+}
+
+@end
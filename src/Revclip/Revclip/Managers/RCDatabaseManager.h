@@ -10,7 +10,13 @@
 NS_ASSUME_NONNULL_BEGIN
 
 @class FMDatabase;
+@class RCClipData;
 @class RCClipItem;
+@class RCClipStatistics;
+
+// enqueueClipItemObject:completion: / enqueueClipItemUpdateTime:time:completion: の結果。
+// committed は書き込みが行に反映されてコミットされたとき YES。
+typedef void (^RCClipItemWriteCompletion)(BOOL committed);
 
 @interface RCDatabaseManager : NSObject
 
@@ -19,11 +25,43 @@ NS_ASSUME_NONNULL_BEGIN
 // データベースパス: ~/Library/Application Support/Revclip/revclip.db
 @property (nonatomic, readonly) NSString *databasePath;
 
+// キャプチャ由来の INSERT / update_time 更新をまとめてコミットするまでの猶予（秒）。
+// この間にクラッシュした書き込みは失われる。0 以下で従来どおり即時コミット。既定 0.25 秒。
+@property (atomic, assign) NSTimeInterval writeBehindInterval;
+
 // 初期化・マイグレーション
+/// Opens the database. When PRAGMA user_version already matches the current
+/// schema it only applies the connection pragmas; otherwise it creates the
+/// schema and migrates, then stamps user_version. Work proportional to the
+/// database size is left for performDeferredMaintenanceWithProgress:.
 - (BOOL)setupDatabase;
 - (NSInteger)currentSchemaVersion;
 - (BOOL)migrateIfNeeded;
+/// YES while work deferred from setupDatabase (the auto_vacuum VACUUM, pending
+/// online migrations) is still outstanding.
+- (BOOL)hasDeferredMaintenance;
+/// YES while a row-by-row migration scheduled by migrateIfNeeded (see
+/// RCOnlineMigration) has not reached the end of its table.
+- (BOOL)hasPendingOnlineMigrations;
+/// Runs the pending online migrations in registration order. Each batch of rows
+/// commits together with its checkpoint in online_migrations, so captures keep
+/// committing between batches and a cancelled or interrupted run resumes from
+/// the last committed batch. `progress` gets one unit per migration and each
+/// child progress counts rows. Returns NO on failure or cancellation.
+- (BOOL)runOnlineMigrationsWithProgress:(nullable NSProgress *)progress;
+/// Runs the deferred work on the calling thread (never the main thread).
+/// `progress` gets one unit per step, each step reports through a child
+/// progress, and cancelling it stops at the next batch (or interrupts the
+/// VACUUM). Returns NO on failure or cancellation; the next call resumes.
+- (BOOL)performDeferredMaintenanceWithProgress:(nullable NSProgress *)progress;
+/// Runs `block` on the writer connection. Rows added to clip_items here bypass
+/// the dedup filter, so clipItemForDataHash: may miss them until the next
+/// setupDatabase; insert clips through insertClipItemObject: instead.
 - (BOOL)performDatabaseOperation:(BOOL (^)(FMDatabase *db))block;
+/// Runs a read-only block on a pooled WAL reader connection so it never waits
+/// for writers (queued write-behind rows are not visible until they commit).
+/// Falls back to the writer connection when WAL is unavailable.
+- (BOOL)performReadOperation:(BOOL (^)(FMDatabase *db))block;
 - (BOOL)performTransaction:(BOOL (^)(FMDatabase *db, BOOL *rollback))block;
 - (void)closeDatabase;
 - (void)deleteDatabaseFiles;
@@ -31,6 +69,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 // clip_items CRUD
 - (BOOL)insertClipItem:(NSDictionary *)clipDict;
+/// Returns YES only once the new update_time is committed to an existing row;
+/// NO when no row matched (deleted or evicted) or the write failed. With
+/// write-behind on this commits the queue, so hot paths use
+/// enqueueClipItemUpdateTime:time:completion: instead.
 - (BOOL)updateClipItemUpdateTime:(NSString *)dataHash time:(NSInteger)updateTime;
 - (BOOL)deleteClipItemWithDataHash:(NSString *)dataHash;
 - (BOOL)deleteClipItemWithDataHash:(NSString *)dataHash olderThan:(NSInteger)updateTimeMs;
@@ -38,7 +80,98 @@ NS_ASSUME_NONNULL_BEGIN
 - (NSArray<RCClipItem *> *)clipItemsOlderThan:(NSInteger)updateTimeMs;
 - (NSArray *)fetchClipItemsWithLimit:(NSInteger)limit;
 - (nullable NSDictionary *)clipItemWithDataHash:(NSString *)dataHash;
+/// Reads the trigger-maintained clip_stats table, so it never scans clip_items.
+/// Counts committed rows only; queued inserts are counted once they commit.
 - (NSInteger)clipItemCount;
+/// Item count, total .rcclip bytes and per-primary_type counts from clip_stats
+/// (a few rows, one per primary_type). Returns zeros if the database is unavailable.
+- (RCClipStatistics *)clipStatistics;
+
+// clip_items typed access
+// 行を RCClipItem に直接デコードする。ホットパス（キャプチャ・メニュー構築・
+// クリーンアップ）はこちらを使い、行ごとの NSDictionary 生成を避ける。
+/// Inserts `clipItem` and returns YES only once its row is committed (queued
+/// writes ahead of it are committed in the same flush).
+- (BOOL)insertClipItemObject:(RCClipItem *)clipItem;
+/// Queues `clipItem` for the next write-behind commit. `completion` runs once,
+/// on the flushing thread, with YES when the row is committed and NO when it
+/// was rejected (constraint violation, failed COMMIT, Panic Erase); on NO the
+/// caller owns the clip files. Returns NO, without calling `completion`, when
+/// the item is refused up front (malformed, or the hash is already queued).
+- (BOOL)enqueueClipItemObject:(RCClipItem *)clipItem completion:(RCClipItemWriteCompletion)completion;
+/// Queues an update_time change for the next write-behind commit. `completion`
+/// runs once, on the flushing thread, with YES when a row took the new time and
+/// NO when none matched (deleted or evicted while queued), the UPDATE or COMMIT
+/// failed, or the write was discarded. Returns NO, without calling
+/// `completion`, for a malformed hash.
+- (BOOL)enqueueClipItemUpdateTime:(NSString *)dataHash
+                             time:(NSInteger)updateTime
+                       completion:(RCClipItemWriteCompletion)completion;
+- (NSArray<RCClipItem *> *)clipItemsWithLimit:(NSInteger)limit;
+/// Dedup lookup. An in-memory cuckoo filter over stored digests answers most
+/// misses (new content) without touching SQLite.
+- (nullable RCClipItem *)clipItemForDataHash:(NSString *)dataHash;
+/// Capture-time dedup for `clipData`, whose current fingerprint is `dataHash`.
+/// While rows written before fingerprint v2 are still being rehashed in the
+/// background, a miss is retried with the clip's legacy (v1) fingerprint, so
+/// the returned item's dataHash may differ from `dataHash`.
+- (nullable RCClipItem *)clipItemForCapturedClipData:(RCClipData *)clipData dataHash:(NSString *)dataHash;
+/// Returns the next page of the newest-first history after `clipItem` (the last
+/// item of the previous page; nil for the first page), keyed on
+/// (update_time, id) so deep pages cost the same as the first one. Queued
+/// inserts appear with itemId 0 until they commit.
+- (NSArray<RCClipItem *> *)clipItemsAfterClipItem:(nullable RCClipItem *)clipItem limit:(NSInteger)limit;
+/// Streams the whole history newest-first from one read snapshot, decoding one
+/// row at a time. The block must not call back into RCDatabaseManager.
+/// Returns NO if the query failed.
+- (BOOL)enumerateClipItemsUsingBlock:(void (^)(RCClipItem *clipItem, BOOL *stop))block;
+
+/// Commits every queued insert and update_time change in one transaction.
+/// Inserts and timestamp updates are queued for `writeBehindInterval`. Point
+/// lookups by hash and the newest-first list pages merge queued writes without
+/// waiting for the writer; counts and search see them once committed. Writes,
+/// deletes and reads that feed deletes (enumeration, expiry) flush first.
+/// Call before termination to close the durability window.
+- (BOOL)flushPendingWrites;
+
+/// Deletes, in one statement and one transaction, every clip older than
+/// `cutoffMs` and every clip beyond the newest `maxHistorySize` (pass 0 to
+/// skip the size limit). Returns the evicted rows with resolved data and
+/// thumbnail paths so the caller can remove files afterwards, or nil on error.
+- (nullable NSArray<RCClipItem *> *)evictClipItemsBeyondLimit:(NSInteger)maxHistorySize
+                                                     olderThan:(NSInteger)cutoffMs;
+
+// 全文検索（FTS5）
+/// Ranked full-text search over clip history: every whitespace-separated term
+/// must match and the last one may be a prefix (kana/kanji match as
+/// substrings). Every match is ordered by bm25, newer clips first on ties, so
+/// old clips are found by relevance and paging continues until the matches run
+/// out. Returns an empty array for a blank query.
+- (NSArray<RCClipItem *> *)searchClipItemsMatching:(NSString *)query
+                                             limit:(NSInteger)limit
+                                            offset:(NSInteger)offset;
+/// Full-text search over snippet titles (weighted x2) and contents, same query
+/// syntax, ordered by bm25.
+- (NSArray *)searchSnippetsMatching:(NSString *)query limit:(NSInteger)limit offset:(NSInteger)offset;
+// 索引の無いクリップ（v3 移行前の履歴）を新しい順に返す。searchText を埋めて
+// indexSearchTextForClipItems: に渡すとバックフィルされる。
+- (NSArray<RCClipItem *> *)clipItemsMissingSearchTextWithLimit:(NSInteger)limit;
+- (BOOL)indexSearchTextForClipItems:(NSArray<RCClipItem *> *)clipItems;
+
+// 内容アドレス型ブロブ（RCClipBlobStore）の参照数
+/// Hex digests whose last referencing clip was deleted. The blob files stay on
+/// disk until the caller removes them and calls forgetReleasedBlobDigests:.
+- (NSArray<NSString *> *)releasedBlobDigestsWithLimit:(NSInteger)limit;
+/// YES when a committed or queued clip still references the blob.
+- (BOOL)isBlobDigestReferenced:(NSString *)digest;
+- (BOOL)forgetReleasedBlobDigests:(NSArray<NSString *> *)digests;
+
+// 診断: 操作ごとのキュー待ち・実行時間と SQL 文ごとの実行時間のヒストグラム
+/// JSON snapshot of the latency histograms: per operation `queueWait` and
+/// `execution`, per registered statement (unregistered SQL is filed under
+/// "other"). Values are microseconds; percentiles are bucket upper bounds.
+- (nullable NSData *)queryMetricsJSONData;
+- (void)resetQueryMetrics;
 
 // snippet_folders CRUD
 - (BOOL)insertSnippetFolder:(NSDictionary *)folderDict;
@@ -8,16 +8,175 @@
 #import "RCDatabaseManager.h"
 
 #import "FMDB.h"
+#import "RCClipBlobStore.h"
+#import "RCClipData.h"
 #import "RCClipItem.h"
+#import "RCClipStatistics.h"
+#import "RCDigestFilter.h"
+#import "RCOnlineMigration.h"
 #import "RCPanicEraseService.h"
+#import "RCQueryMetrics.h"
+#import "RCSearchText.h"
 #import "RCUtilities.h"
 #import <os/log.h>
 #import <sqlite3.h>
 
-static NSInteger const kRCCurrentSchemaVersion = 1;
+static NSInteger const kRCCurrentSchemaVersion = 7;
+static NSUInteger const kRCDataDigestLength = 32;
+static NSUInteger const kRCReadConnectionPoolSize = 3;
 static NSNumber * const kRCDatabaseFilePermissions = @(0600);
 static NSNumber * const kRCDatabaseDirectoryPermissions = @(0700);
 static NSString * const kRCAutoVacuumMigrationCompletedKey = @"kRCAutoVacuumMigrationCompletedKey";
+// v5 までの data_size バックフィルの予約。v6 の移行で online_migrations に移す。
+static NSString * const kRCDataSizeBackfillPendingKey = @"kRCDataSizeBackfillPendingKey";
+static NSString * const kRCClipItemsDataSizeMigrationName = @"clip_items.data_size";
+static NSString * const kRCClipItemsFingerprintV2MigrationName = @"clip_items.fingerprint_v2";
+// フィンガープリントの再計算は .rcclip を丸ごと読むので、小さなバッチの合間に休んで
+// キャプチャにディスクと CPU を譲る。
+static NSInteger const kRCFingerprintMigrationBatchSize = 32;
+static NSTimeInterval const kRCFingerprintMigrationBatchInterval = 0.1;
+static NSTimeInterval const kRCDefaultWriteBehindInterval = 0.25;
+// WAL の復旧やメンテナンス中の一時的な SQLITE_BUSY で読み取りを失敗させないための待ち時間。
+static NSTimeInterval const kRCReadConnectionBusyTimeout = 0.5;
+static NSUInteger const kRCWriteBehindMaxPendingWrites = 128;
+// 重複検出フィルタは履歴の 2 倍を目安に確保し、溢れたら作り直す。
+static NSUInteger const kRCDigestFilterMinimumCapacity = 4096;
+
+// 固定 SQL は FMDB のステートメントキャッシュ（shouldCacheStatements）のキーになるため
+// 定数として一箇所に集約する。SELECT の列順は RCClipItemColumn 等と一致させること。
+// v2: data_hash は SHA-256 ダイジェストの 32 バイト BLOB。16 進文字列は API の境界でのみ扱う。
+static NSString * const kRCClipItemsTableDefinitionSQL = @"(id INTEGER PRIMARY KEY AUTOINCREMENT, data_path TEXT NOT NULL, title TEXT DEFAULT '', data_hash BLOB UNIQUE NOT NULL CHECK (length(data_hash) = 32), primary_type TEXT DEFAULT '', update_time INTEGER NOT NULL, thumbnail_path TEXT DEFAULT '', is_color_code INTEGER DEFAULT 0, data_size INTEGER NOT NULL DEFAULT 0, fingerprint_version INTEGER NOT NULL DEFAULT 1)";
+// 新しい行は常に現行のフィンガープリント（v2）で書く。
+static NSString * const kRCInsertClipItemSQL = @"INSERT INTO clip_items (data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code, data_size, fingerprint_version) VALUES (?, ?, ?, ?, ?, ?, ?, ?, 2)";
+static NSString * const kRCUpdateClipItemUpdateTimeSQL = @"UPDATE clip_items SET update_time = ? WHERE data_hash = ?";
+static NSString * const kRCSelectRecentClipItemsSQL = @"SELECT id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code FROM clip_items ORDER BY update_time DESC, id DESC LIMIT ?";
+// キーセットページング。(update_time, id) の行値比較で前ページ末尾の続きから読み、
+// OFFSET のように読み飛ばした行を毎回走査しない。
+static NSString * const kRCSelectClipItemsPageSQL = @"SELECT id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code FROM clip_items WHERE (update_time, id) < (?, ?) ORDER BY update_time DESC, id DESC LIMIT ?";
+static NSString * const kRCSelectClipItemByDataHashSQL = @"SELECT id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code FROM clip_items WHERE data_hash = ? LIMIT 1";
+static NSString * const kRCDeleteClipItemByDataHashSQL = @"DELETE FROM clip_items WHERE data_hash = ?";
+static NSString * const kRCDeleteExpiredClipItemByDataHashSQL = @"DELETE FROM clip_items WHERE data_hash = ? AND update_time < ?";
+static NSString * const kRCDeleteClipItemsOlderThanSQL = @"DELETE FROM clip_items WHERE update_time < ?";
+static NSString * const kRCSelectClipItemsOlderThanSQL = @"SELECT id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code FROM clip_items WHERE update_time < ? ORDER BY update_time ASC";
+// 履歴の一括削除。期限切れ行と新しい順で上限を超えた行を 1 文で削除し、
+// RETURNING で削除行のパスを返す（SQLite 3.35+）。
+static NSString * const kRCEvictClipItemsSQL = @"DELETE FROM clip_items WHERE update_time < ? OR id IN (SELECT id FROM clip_items ORDER BY update_time DESC, id DESC LIMIT -1 OFFSET ?) RETURNING id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code";
+static NSString * const kRCExpireClipItemsSQL = @"DELETE FROM clip_items WHERE update_time < ? RETURNING id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code";
+// v3: 全文検索索引。clip_search の rowid は clip_items.id、snippet_search の rowid は snippets.id。
+// クリップ本文は .rcclip 内にしか無いため挿入時にアプリ側で書き込み、削除はトリガーで追従する。
+// スニペットはテーブルに本文があるのでトリガーだけで同期する。
+static NSString * const kRCInsertClipSearchTextSQL = @"INSERT INTO clip_search (rowid, body) VALUES (?, rc_search_text(?))";
+static NSString * const kRCBackfillClipSearchTextSQL = @"INSERT INTO clip_search (rowid, body) SELECT id, rc_search_text(?) FROM clip_items WHERE id = ? AND NOT EXISTS (SELECT 1 FROM clip_search WHERE rowid = ?)";
+static NSString * const kRCSelectClipItemsMissingSearchTextSQL = @"SELECT id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code FROM clip_items WHERE NOT EXISTS (SELECT 1 FROM clip_search WHERE rowid = clip_items.id) ORDER BY update_time DESC, id DESC LIMIT ?";
+// bm25 は一致行ごとに位置リストを読むため、ほぼ全件に一致する語では 1 万件で十数 ms かかる。
+// 一致した全件を bm25 で順位付けする（古いクリップも関連度で見つかり、ページ送りも打ち切られない）。
+static NSString * const kRCSearchClipItemsSQL = @"SELECT c.id, c.data_path, c.title, c.data_hash, c.primary_type, c.update_time, c.thumbnail_path, c.is_color_code FROM clip_search JOIN clip_items AS c ON c.id = clip_search.rowid WHERE clip_search MATCH ? ORDER BY clip_search.rank, c.update_time DESC LIMIT ? OFFSET ?";
+static NSString * const kRCSearchSnippetsSQL = @"SELECT s.id, s.identifier, s.folder_id, s.snippet_index, s.enabled, s.title, s.content FROM snippet_search JOIN snippets AS s ON s.id = snippet_search.rowid WHERE snippet_search MATCH ? ORDER BY bm25(snippet_search, 2.0, 1.0), s.snippet_index ASC LIMIT ? OFFSET ?";
+// v4: 件数・合計サイズ・primary_type 別件数をトリガーで clip_stats に保持し、
+// COUNT(*) の全件走査を避ける。行は primary_type ごとなので読み取りは数行で済む。
+// update_time の更新は UPDATE OF の対象外なのでトリガーは発火しない。
+static NSString * const kRCSelectClipStatsSQL = @"SELECT primary_type, item_count, total_size FROM clip_stats";
+static NSString * const kRCSelectClipStatsTotalCountSQL = @"SELECT COALESCE(SUM(item_count), 0) FROM clip_stats";
+static NSString * const kRCSelectClipItemDataHashesSQL = @"SELECT data_hash FROM clip_items";
+// data_size のバックフィルはオンライン移行（RCOnlineMigration）として起動後に id 順で少しずつ進める。
+static NSString * const kRCCountClipItemsForDataSizeBackfillSQL = @"SELECT COUNT(*) FROM clip_items WHERE data_size = 0 AND id > ?";
+static NSString * const kRCSelectClipItemsForDataSizeBackfillSQL = @"SELECT id, data_path FROM clip_items WHERE data_size = 0 AND id > ? ORDER BY id LIMIT ?";
+static NSString * const kRCUpdateClipItemDataSizeSQL = @"UPDATE clip_items SET data_size = ? WHERE id = ? AND data_size = 0";
+// v7: data_hash を v2 のフィンガープリントで書き直す。同じ内容の v2 の行が既にあれば
+// UNIQUE 違反になるので、その行は v1 のまま残す（v2 の行が重複判定に使われる）。
+// 移行の最後に v1 のまま残った行は fingerprint_version = 0（再計算できない行）にする。
+static NSString * const kRCCountClipItemsForFingerprintV2SQL = @"SELECT COUNT(*) FROM clip_items WHERE fingerprint_version = 1 AND id > ?";
+static NSString * const kRCSelectClipItemsForFingerprintV2SQL = @"SELECT id, data_path FROM clip_items WHERE fingerprint_version = 1 AND id > ? ORDER BY id LIMIT ?";
+static NSString * const kRCUpdateClipItemFingerprintSQL = @"UPDATE OR IGNORE clip_items SET data_hash = ?, fingerprint_version = 2 WHERE id = ? AND fingerprint_version = 1";
+static NSString * const kRCRetireLegacyFingerprintsSQL = @"UPDATE clip_items SET fingerprint_version = 0 WHERE fingerprint_version = 1";
+// v6: オンライン移行のチェックポイント。checkpoint は処理済みの最後の id で、
+// 各チャンクの書き込みと同じトランザクションで進める。
+static NSString * const kRCOnlineMigrationsTableSQL = @"CREATE TABLE IF NOT EXISTS online_migrations (name TEXT PRIMARY KEY NOT NULL, checkpoint INTEGER NOT NULL DEFAULT 0, migrated_rows INTEGER NOT NULL DEFAULT 0, completed INTEGER NOT NULL DEFAULT 0) WITHOUT ROWID";
+static NSString * const kRCScheduleOnlineMigrationSQL = @"INSERT OR IGNORE INTO online_migrations (name) VALUES (?)";
+static NSString * const kRCSelectPendingOnlineMigrationsSQL = @"SELECT name FROM online_migrations WHERE completed = 0";
+static NSString * const kRCSelectOnlineMigrationSQL = @"SELECT checkpoint, completed FROM online_migrations WHERE name = ?";
+static NSString * const kRCUpdateOnlineMigrationCheckpointSQL = @"UPDATE online_migrations SET checkpoint = ?, migrated_rows = migrated_rows + ?, completed = ? WHERE name = ?";
+// v5: 内容アドレス型ブロブ（RCClipBlobStore）の参照数。clip_blob_refs の増減をトリガーで
+// clip_blobs.ref_count に反映し、最後の参照が消えたダイジェストを clip_blob_garbage に積む。
+// ファイルの削除は RCDataCleanService が猶予期間を置いて行う。
+static NSString * const kRCInsertClipBlobSQL = @"INSERT INTO clip_blobs (digest, size, ref_count) VALUES (?, ?, 0) ON CONFLICT (digest) DO NOTHING";
+static NSString * const kRCInsertClipBlobRefSQL = @"INSERT OR IGNORE INTO clip_blob_refs (clip_id, digest) VALUES (?, ?)";
+static NSString * const kRCDeleteClipItemByIDSQL = @"DELETE FROM clip_items WHERE id = ?";
+static NSString * const kRCSelectReleasedBlobDigestsSQL = @"SELECT digest FROM clip_blob_garbage LIMIT ?";
+static NSString * const kRCSelectClipBlobReferencedSQL = @"SELECT 1 FROM clip_blobs WHERE digest = ? AND ref_count > 0 LIMIT 1";
+static NSString * const kRCDeleteReleasedBlobDigestSQL = @"DELETE FROM clip_blob_garbage WHERE digest = ?";
+static NSString * const kRCSelectSnippetFoldersSQL = @"SELECT id, identifier, folder_index, enabled, title FROM snippet_folders ORDER BY folder_index ASC, id ASC";
+static NSString * const kRCSelectSnippetsForFolderSQL = @"SELECT id, identifier, folder_id, snippet_index, enabled, title, content FROM snippets WHERE folder_id = ? ORDER BY snippet_index ASC, id ASC";
+
+// 行は列インデックスで直接デコードし、FMResultSet の列名マップ生成と
+// 行ごとの NSDictionary ボックス化を避ける。
+typedef NS_ENUM(int, RCClipItemColumn) {
+    RCClipItemColumnID = 0,
+    RCClipItemColumnDataPath,
+    RCClipItemColumnTitle,
+    RCClipItemColumnDataHash,
+    RCClipItemColumnPrimaryType,
+    RCClipItemColumnUpdateTime,
+    RCClipItemColumnThumbnailPath,
+    RCClipItemColumnIsColorCode,
+};
+
+typedef NS_ENUM(int, RCSnippetFolderColumn) {
+    RCSnippetFolderColumnID = 0,
+    RCSnippetFolderColumnIdentifier,
+    RCSnippetFolderColumnFolderIndex,
+    RCSnippetFolderColumnEnabled,
+    RCSnippetFolderColumnTitle,
+};
+
+typedef NS_ENUM(int, RCSnippetColumn) {
+    RCSnippetColumnID = 0,
+    RCSnippetColumnIdentifier,
+    RCSnippetColumnFolderID,
+    RCSnippetColumnSnippetIndex,
+    RCSnippetColumnEnabled,
+    RCSnippetColumnTitle,
+    RCSnippetColumnContent,
+};
+
+// 診断用のレイテンシ計測単位。キュー待ちと実行時間を操作ごとに RCQueryMetrics へ記録する。
+// 値は RCQueryMetricsRegisterOperation の戻り値と一致させるため、登録は列挙順に行う。
+typedef NS_ENUM(int, RCDatabaseOperation) {
+    RCDatabaseOperationInsert = 0,
+    RCDatabaseOperationWriteBehindFlush,
+    RCDatabaseOperationUpdateTime,
+    RCDatabaseOperationDedupLookup,
+    RCDatabaseOperationDelete,
+    RCDatabaseOperationEvict,
+    RCDatabaseOperationList,
+    RCDatabaseOperationEnumerate,
+    RCDatabaseOperationStatistics,
+    RCDatabaseOperationSearch,
+    RCDatabaseOperationSearchBackfill,
+    RCDatabaseOperationBlobReferences,
+    RCDatabaseOperationSnippets,
+    RCDatabaseOperationMaintenance,
+    RCDatabaseOperationDigestFilter,
+    RCDatabaseOperationCount,
+};
+
+static const char * const kRCDatabaseOperationNames[RCDatabaseOperationCount] = {
+    [RCDatabaseOperationInsert] = "insert",
+    [RCDatabaseOperationWriteBehindFlush] = "writeBehindFlush",
+    [RCDatabaseOperationUpdateTime] = "updateTime",
+    [RCDatabaseOperationDedupLookup] = "dedupLookup",
+    [RCDatabaseOperationDelete] = "delete",
+    [RCDatabaseOperationEvict] = "evict",
+    [RCDatabaseOperationList] = "list",
+    [RCDatabaseOperationEnumerate] = "enumerate",
+    [RCDatabaseOperationStatistics] = "statistics",
+    [RCDatabaseOperationSearch] = "search",
+    [RCDatabaseOperationSearchBackfill] = "searchBackfill",
+    [RCDatabaseOperationBlobReferences] = "blobReferences",
+    [RCDatabaseOperationSnippets] = "snippets",
+    [RCDatabaseOperationMaintenance] = "maintenance",
+    [RCDatabaseOperationDigestFilter] = "digestFilter",
+};
 
 static os_log_t RCDatabaseManagerLog(void) {
     static os_log_t logger = nil;
@@ -28,22 +187,112 @@ static os_log_t RCDatabaseManagerLog(void) {
     return logger;
 }
 
+// VACUUM など長い文の途中で取り消しを確認する（非 0 で SQLITE_INTERRUPT）。
+static int RCDatabaseMaintenanceProgressHandler(void *context) {
+    NSProgress *progress = (__bridge NSProgress *)context;
+    return progress.isCancelled ? 1 : 0;
+}
+
 @interface RCDatabaseManager ()
 
 @property (nonatomic, strong, nullable) FMDatabaseQueue *databaseQueue;
+// WAL 時のみ作成される読み取り専用コネクションプール。
+// 書き込みは databaseQueue の単一コネクションに限定し、
+// 読み取りはスナップショット分離によりライターを待たない。
+@property (nonatomic, strong, nullable) FMDatabasePool *readConnectionPool;
 @property (nonatomic, readwrite, copy) NSString *databasePath;
 @property (nonatomic, assign) BOOL setupCompleted;
 @property (nonatomic, assign) BOOL databaseCreatedDuringCurrentSetup;
+// write-behind キュー。キャプチャ由来の INSERT / update_time 更新を
+// writeBehindInterval の間ためて 1 トランザクションでコミットする。
+// pending* / flushing* は pendingWriteLock で保護する。コミット中の書き込みは
+// flushing* に移し、コミット完了まで読み取りから見えるようにする。
+@property (nonatomic, strong) NSObject *pendingWriteLock;
+@property (nonatomic, strong) NSObject *writeBehindFlushLock;
+@property (nonatomic, strong) dispatch_queue_t writeBehindQueue;
+@property (nonatomic, strong) NSMutableArray<RCClipItem *> *pendingInserts;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *pendingUpdateTimes;
+@property (nonatomic, copy, nullable) NSArray<RCClipItem *> *flushingInserts;
+@property (nonatomic, copy, nullable) NSDictionary<NSString *, NSNumber *> *flushingUpdateTimes;
+// enqueueClipItemObject:completion: の完了ブロック（data_hash → ブロック）。
+@property (nonatomic, strong) NSMutableDictionary<NSString *, RCClipItemWriteCompletion> *pendingInsertCompletions;
+// enqueueClipItemUpdateTime:time:completion: の完了ブロック（data_hash → 投入順のブロック）。
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSMutableArray<RCClipItemWriteCompletion> *> *pendingUpdateCompletions;
+@property (nonatomic, assign) BOOL writeBehindFlushScheduled;
+// clip_items.data_hash の cuckoo フィルタ。「無い」と答えたハッシュは点検索を省く。
+// 変更は databaseQueue 上（行の追加・削除と同じブロック）で行い、読み書きとも
+// digestFilterLock で保護する。NULL（未構築・溢れ）の間は常に SQLite を引く。
+@property (nonatomic, strong) NSObject *digestFilterLock;
+@property (nonatomic, assign, nullable) RCDigestFilter *digestFilter;
+// v1 のフィンガープリントの行が残っている間（再計算の移行が未完了）は YES。
+// キャプチャの重複判定で旧フィンガープリントも引く。
+@property (atomic, assign) BOOL legacyFingerprintsPending;
+// シングルトンと同じ寿命なので解放しない。
+@property (nonatomic, assign) RCQueryMetrics *queryMetrics;
+// 登録順に実行するオンライン移行（registeredOnlineMigrations）。
+@property (nonatomic, copy) NSArray<RCOnlineMigration *> *onlineMigrations;
 
 - (BOOL)enableSecureDeleteForDatabase:(FMDatabase *)db;
+- (BOOL)enableWriteAheadLoggingForDatabase:(FMDatabase *)db;
+- (void)openReadConnectionPoolIfNeeded;
+- (void)inDatabaseForOperation:(RCDatabaseOperation)operation block:(void (^)(FMDatabase *db))block;
+- (BOOL)inTransactionForOperation:(RCDatabaseOperation)operation
+                            block:(void (^)(FMDatabase *db, BOOL *rollback))block;
+- (BOOL)inTransactionForOperation:(RCDatabaseOperation)operation
+                            block:(void (^)(FMDatabase *db, BOOL *rollback))block
+                      afterCommit:(nullable void (^)(FMDatabase *db))afterCommit;
+- (void)inReadDatabaseForOperation:(RCDatabaseOperation)operation block:(void (^)(FMDatabase *db))block;
+- (void)registerQueryMetricsStatements;
 - (BOOL)configureIncrementalAutoVacuumForNewDatabase:(FMDatabase *)db;
 - (NSInteger)integerValueForPragma:(NSString *)pragmaName
                         inDatabase:(FMDatabase *)db
                       defaultValue:(NSInteger)defaultValue;
-- (void)migrateAutoVacuumToIncrementalIfNeeded;
+- (BOOL)migrateAutoVacuumToIncrementalWithProgress:(nullable NSProgress *)progress;
+- (NSArray<RCOnlineMigration *> *)registeredOnlineMigrations;
+- (nullable NSSet<NSString *> *)pendingOnlineMigrationNames;
+- (BOOL)runOnlineMigration:(RCOnlineMigration *)migration progress:(nullable NSProgress *)progress;
+- (void)stampSchemaVersion;
 - (void)applyDatabaseFilePermissionsIfNeeded;
 - (NSString *)storagePathForClipPath:(NSString *)path;
 - (NSString *)resolvedPathForStoredClipPath:(NSString *)storedPath;
+- (NSString *)resolvedPathForStoredClipPath:(NSString *)storedPath
+                          clipDirectoryPath:(NSString *)clipDirectoryPath
+                 canonicalClipDirectoryPath:(NSString *)canonicalClipDirectoryPath;
+- (NSArray<RCClipItem *> *)clipItemsForQuery:(NSString *)sql
+                                   arguments:(NSArray *)arguments
+                                   operation:(RCDatabaseOperation)operation
+                                errorContext:(NSString *)errorContext;
+- (BOOL)insertClipItemRow:(RCClipItem *)clipItem inDatabase:(FMDatabase *)db;
+- (nullable NSData *)digestDataForDataHash:(NSString *)dataHash;
+- (BOOL)migrateClipItemsToBinaryDigestInDatabase:(FMDatabase *)db;
+- (BOOL)createSearchIndexSchemaInDatabase:(FMDatabase *)db;
+- (BOOL)migrateToSearchIndexInDatabase:(FMDatabase *)db;
+- (BOOL)createClipStatsSchemaInDatabase:(FMDatabase *)db;
+- (BOOL)migrateToClipStatsInDatabase:(FMDatabase *)db;
+- (long long)fileSizeAtClipPath:(NSString *)path;
+- (BOOL)insertBlobReferencesForClipItem:(RCClipItem *)clipItem clipID:(sqlite_int64)clipID inDatabase:(FMDatabase *)db;
+- (BOOL)createClipBlobSchemaInDatabase:(FMDatabase *)db;
+- (BOOL)migrateToClipBlobsInDatabase:(FMDatabase *)db;
+- (BOOL)createOnlineMigrationSchemaInDatabase:(FMDatabase *)db;
+- (BOOL)scheduleOnlineMigrationNamed:(NSString *)name inDatabase:(FMDatabase *)db;
+- (BOOL)migrateToOnlineMigrationsInDatabase:(FMDatabase *)db;
+- (BOOL)migrateToFingerprintV2InDatabase:(FMDatabase *)db;
+- (void)retireLegacyFingerprintRows;
+- (void)optimizeSearchIndexTable:(NSString *)tableName inDatabase:(FMDatabase *)db;
+- (nullable NSString *)matchExpressionForSearchQuery:(NSString *)query;
+- (NSArray<RCClipItem *> *)clipItemsMergingQueuedWritesAfterClipItem:(nullable RCClipItem *)cursor
+                                                                limit:(NSInteger)limit
+                                                         committedRows:(NSArray<RCClipItem *> *(^)(NSInteger fetchLimit))committedRows;
+- (RCClipItem *)pendingClipItemForDataHash:(NSString *)dataHash;
+- (void)scheduleWriteBehindFlushImmediately:(BOOL)immediately;
+- (void)discardPendingWrites;
+- (void)scheduleDigestFilterRebuild;
+- (void)rebuildDigestFilterInDatabase:(FMDatabase *)db;
+- (void)replaceDigestFilter:(nullable RCDigestFilter *)filter;
+- (void)addDigestToFilter:(NSData *)digest;
+- (void)removeDataHashesFromFilter:(NSArray<NSString *> *)dataHashes;
+- (void)clearDigestFilter;
+- (BOOL)digestFilterMayContainDigest:(NSData *)digest;
 - (NSString *)standardizedPath:(NSString *)path;
 - (NSString *)canonicalPath:(NSString *)path;
 - (BOOL)isPath:(NSString *)path withinDirectory:(NSString *)directoryPath;
@@ -73,6 +322,18 @@ static os_log_t RCDatabaseManagerLog(void) {
     if (self) {
         _databasePath = [[self class] defaultDatabasePath];
         _setupCompleted = NO;
+        _writeBehindInterval = kRCDefaultWriteBehindInterval;
+        _pendingWriteLock = [[NSObject alloc] init];
+        _writeBehindFlushLock = [[NSObject alloc] init];
+        _writeBehindQueue = dispatch_queue_create("com.revclip.database-write-behind", DISPATCH_QUEUE_SERIAL);
+        _pendingInserts = [NSMutableArray array];
+        _pendingUpdateTimes = [NSMutableDictionary dictionary];
+        _pendingInsertCompletions = [NSMutableDictionary dictionary];
+        _pendingUpdateCompletions = [NSMutableDictionary dictionary];
+        _digestFilterLock = [[NSObject alloc] init];
+        _queryMetrics = RCQueryMetricsCreate();
+        [self registerQueryMetricsStatements];
+        _onlineMigrations = [self registeredOnlineMigrations];
     }
     return self;
 }
@@ -90,6 +351,8 @@ static os_log_t RCDatabaseManagerLog(void) {
         }
 
         __block BOOL setupSucceeded = YES;
+        __block BOOL walEnabled = NO;
+        __block BOOL schemaCurrent = NO;
         [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
             if (![self enableForeignKeysForDatabase:db]) {
                 setupSucceeded = NO;
@@ -107,22 +370,43 @@ static os_log_t RCDatabaseManagerLog(void) {
                 return;
             }
 
-            setupSucceeded = [self createBaseSchemaInDatabase:db];
+            walEnabled = [self enableWriteAheadLoggingForDatabase:db];
+
+            // 起動の高速経路: user_version（ヘッダーの 4 バイト）が現行スキーマと一致すれば
+            // CREATE ... IF NOT EXISTS の列とマイグレーション判定を省く。
+            // user_version は migrateIfNeeded が成功した後にだけ書く。
+            schemaCurrent = !self.databaseCreatedDuringCurrentSetup
+                && [self integerValueForPragma:@"user_version" inDatabase:db defaultValue:0] == kRCCurrentSchemaVersion;
+            if (!schemaCurrent) {
+                setupSucceeded = [self createBaseSchemaInDatabase:db];
+            }
         }];
 
         if (!setupSucceeded) {
             return NO;
         }
 
-        BOOL migrated = [self migrateIfNeeded];
-        if (!migrated) {
-            return NO;
+        if (!schemaCurrent) {
+            BOOL migrated = [self migrateIfNeeded];
+            if (!migrated) {
+                return NO;
+            }
+            [self stampSchemaVersion];
         }
 
-        [self migrateAutoVacuumToIncrementalIfNeeded];
+        // VACUUM やファイルを読むバックフィルは DB サイズに比例するため、ここでは行わず
+        // RCDataCleanService が performDeferredMaintenanceWithProgress: で後から実行する。
         [self applyDatabaseFilePermissionsIfNeeded];
 
+        // rollback journal のままだと読み取り専用コネクションがライターと
+        // SQLITE_BUSY で衝突するため、WAL が有効な場合のみプールを使う。
+        if (walEnabled) {
+            [self openReadConnectionPoolIfNeeded];
+        }
+        self.legacyFingerprintsPending = [[self pendingOnlineMigrationNames] containsObject:kRCClipItemsFingerprintV2MigrationName];
+
         self.setupCompleted = YES;
+        [self scheduleDigestFilterRebuild];
         return YES;
     }
 }
@@ -134,8 +418,8 @@ static os_log_t RCDatabaseManagerLog(void) {
 
     __block NSInteger version = 0;
     [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
-        if (![db executeUpdate:@"CREATE TABLE IF NOT EXISTS schema_version (version INTEGER NOT NULL)"]) {
-            [self logDatabaseError:db context:@"Failed to create schema_version table before reading version"];
+        // 読み取りだけで済ませる。テーブルが無ければ未作成（v0）として扱う。
+        if (![self tableExists:@"schema_version" inDatabase:db]) {
             return;
         }
 
@@ -184,6 +468,48 @@ static os_log_t RCDatabaseManagerLog(void) {
             switch (nextVersion) {
                 case 1:
                     break;
+                case 2:
+                    if (![self migrateClipItemsToBinaryDigestInDatabase:db]) {
+                        migrated = NO;
+                        *rollback = YES;
+                        return;
+                    }
+                    break;
+                case 3:
+                    if (![self migrateToSearchIndexInDatabase:db]) {
+                        migrated = NO;
+                        *rollback = YES;
+                        return;
+                    }
+                    break;
+                case 4:
+                    if (![self migrateToClipStatsInDatabase:db]) {
+                        migrated = NO;
+                        *rollback = YES;
+                        return;
+                    }
+                    break;
+                case 5:
+                    if (![self migrateToClipBlobsInDatabase:db]) {
+                        migrated = NO;
+                        *rollback = YES;
+                        return;
+                    }
+                    break;
+                case 6:
+                    if (![self migrateToOnlineMigrationsInDatabase:db]) {
+                        migrated = NO;
+                        *rollback = YES;
+                        return;
+                    }
+                    break;
+                case 7:
+                    if (![self migrateToFingerprintV2InDatabase:db]) {
+                        migrated = NO;
+                        *rollback = YES;
+                        return;
+                    }
+                    break;
                 default:
                     migrated = NO;
                     *rollback = YES;
@@ -208,16 +534,43 @@ static os_log_t RCDatabaseManagerLog(void) {
         }
     }];
 
+    // 予約は online_migrations に移ったので、コミット後に旧来の印を消す。
+    if (migrated && version < 6) {
+        [[NSUserDefaults standardUserDefaults] removeObjectForKey:kRCDataSizeBackfillPendingKey];
+    }
     return migrated;
 }
 
+- (void)stampSchemaVersion {
+    NSString *statement = [NSString stringWithFormat:@"PRAGMA user_version = %ld", (long)kRCCurrentSchemaVersion];
+    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
+        // 失敗しても次回の起動が通常経路になるだけなので、セットアップは続ける。
+        if (![db executeStatements:statement]) {
+            [self logDatabaseError:db context:@"Failed to write user_version"];
+        }
+    }];
+}
+
 - (BOOL)performDatabaseOperation:(BOOL (^)(FMDatabase *db))block {
     if (block == nil || ![self ensureDatabaseReadyForOperation]) {
         return NO;
     }
+    [self flushPendingWrites];
 
     __block BOOL succeeded = YES;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
+    [self inDatabaseForOperation:RCDatabaseOperationMaintenance block:^(FMDatabase * _Nonnull db) {
+        succeeded = block(db);
+    }];
+    return succeeded;
+}
+
+- (BOOL)performReadOperation:(BOOL (^)(FMDatabase *db))block {
+    if (block == nil || ![self ensureDatabaseReadyForOperation]) {
+        return NO;
+    }
+
+    __block BOOL succeeded = YES;
+    [self inReadDatabaseForOperation:RCDatabaseOperationMaintenance block:^(FMDatabase * _Nonnull db) {
         succeeded = block(db);
     }];
     return succeeded;
@@ -227,9 +580,10 @@ static os_log_t RCDatabaseManagerLog(void) {
     if (block == nil || ![self ensureDatabaseReadyForOperation]) {
         return NO;
     }
+    [self flushPendingWrites];
 
     __block BOOL succeeded = YES;
-    [self.databaseQueue inTransaction:^(FMDatabase * _Nonnull db, BOOL * _Nonnull rollback) {
+    BOOL committed = [self inTransactionForOperation:RCDatabaseOperationMaintenance block:^(FMDatabase * _Nonnull db, BOOL * _Nonnull rollback) {
         BOOL operationSucceeded = block(db, rollback);
         if (!operationSucceeded || *rollback) {
             succeeded = NO;
@@ -237,14 +591,23 @@ static os_log_t RCDatabaseManagerLog(void) {
         }
     }];
 
-    return succeeded;
+    return succeeded && committed;
 }
 
 - (void)closeDatabase {
+    if ([RCPanicEraseService shared].isPanicInProgress) {
+        [self discardPendingWrites];
+    } else {
+        [self flushPendingWrites];
+    }
+
     @synchronized (self) {
+        [self.readConnectionPool releaseAllDatabases];
+        self.readConnectionPool = nil;
         [self.databaseQueue close];
         self.databaseQueue = nil;
         self.setupCompleted = NO;
+        [self replaceDigestFilter:NULL];
         self.databaseCreatedDuringCurrentSetup = NO;
     }
 }
@@ -283,45 +646,89 @@ static os_log_t RCDatabaseManagerLog(void) {
         return NO;
     }
 
-    NSString *title = [self stringValueInDictionary:clipDict keys:@[@"title"] defaultValue:@""];
-    NSString *primaryType = [self stringValueInDictionary:clipDict keys:@[@"primary_type", @"primaryType"] defaultValue:@""];
-    NSString *rawThumbnailPath = [self stringValueInDictionary:clipDict keys:@[@"thumbnail_path", @"thumbnailPath"] defaultValue:@""];
-    NSString *thumbnailPath = [self storagePathForClipPath:rawThumbnailPath];
-    NSNumber *isColorCode = [self numberValueInDictionary:clipDict keys:@[@"is_color_code", @"isColorCode"] defaultValue:@0];
+    return [self insertClipItemObject:[[RCClipItem alloc] initWithDictionary:clipDict]];
+}
 
-    __block BOOL inserted = NO;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
-        inserted = [db executeUpdate:@"INSERT INTO clip_items (data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code) VALUES (?, ?, ?, ?, ?, ?, ?)"
-                     withArgumentsInArray:@[dataPath, title, dataHash, primaryType, updateTime, thumbnailPath, isColorCode]];
-        if (!inserted) {
-            int errorCode = db.lastErrorCode;
-            int extendedErrorCode = db.lastExtendedErrorCode;
-            if (errorCode == SQLITE_CONSTRAINT && extendedErrorCode == SQLITE_CONSTRAINT_UNIQUE) {
-                NSLog(@"[RCDatabaseManager] insertClipItem: duplicate data_hash detected (code=%d, extended=%d)",
-                      errorCode,
-                      extendedErrorCode);
-            } else if (errorCode == SQLITE_CONSTRAINT) {
-                os_log_with_type(RCDatabaseManagerLog(), OS_LOG_TYPE_DEBUG,
-                                 "insertClipItem constraint violation (code=%d, extended=%d, message=%{private}@)",
-                                 errorCode, extendedErrorCode, db.lastErrorMessage);
-            } else {
-                [self logDatabaseError:db context:@"Failed to insert clip_items row"];
-            }
+- (BOOL)insertClipItemObject:(RCClipItem *)clipItem {
+    if (clipItem == nil || ![self ensureDatabaseReadyForOperation]) {
+        return NO;
+    }
+
+    if ([self storagePathForClipPath:clipItem.dataPath].length == 0 || [self digestDataForDataHash:clipItem.dataHash] == nil) {
+        return NO;
+    }
+
+    if (self.writeBehindInterval <= 0) {
+        __block BOOL inserted = NO;
+        BOOL committed = [self inTransactionForOperation:RCDatabaseOperationInsert block:^(FMDatabase * _Nonnull db, BOOL * _Nonnull rollback) {
+            inserted = [self insertClipItemRow:clipItem inDatabase:db];
+            *rollback = !inserted;
+        }];
+        return inserted && committed;
+    }
+
+    // キュー上の書き込みとのコミット順を保つため、キューに入れてから flush する。
+    __block BOOL committed = NO;
+    if (![self enqueueClipItemObject:clipItem completion:^(BOOL rowCommitted) {
+        committed = rowCommitted;
+    }]) {
+        return NO;
+    }
+    [self flushPendingWrites];
+    return committed;
+}
+
+- (BOOL)enqueueClipItemObject:(RCClipItem *)clipItem completion:(RCClipItemWriteCompletion)completion {
+    if (clipItem == nil || completion == nil || ![self ensureDatabaseReadyForOperation]) {
+        return NO;
+    }
+
+    if ([self storagePathForClipPath:clipItem.dataPath].length == 0 || [self digestDataForDataHash:clipItem.dataHash] == nil) {
+        return NO;
+    }
+
+    if (self.writeBehindInterval <= 0) {
+        completion([self insertClipItemObject:clipItem]);
+        return YES;
+    }
+
+    BOOL flushImmediately = NO;
+    @synchronized (self.pendingWriteLock) {
+        // UNIQUE(data_hash) をキュー上でも保証する。
+        if ([self pendingClipItemForDataHash:clipItem.dataHash] != nil) {
+            return NO;
         }
-    }];
+        [self.pendingInserts addObject:[clipItem copy]];
+        self.pendingInsertCompletions[clipItem.dataHash] = [completion copy];
+        flushImmediately = (self.pendingInserts.count + self.pendingUpdateTimes.count >= kRCWriteBehindMaxPendingWrites);
+    }
 
-    return inserted;
+    [self scheduleWriteBehindFlushImmediately:flushImmediately];
+    return YES;
 }
 
 - (BOOL)updateClipItemUpdateTime:(NSString *)dataHash time:(NSInteger)updateTime {
-    if (dataHash.length == 0 || ![self ensureDatabaseReadyForOperation]) {
+    NSData *digest = [self digestDataForDataHash:dataHash];
+    if (digest == nil || ![self ensureDatabaseReadyForOperation]) {
         return NO;
     }
 
+    if (self.writeBehindInterval > 0) {
+        // キュー上の書き込みとのコミット順を保つため、キューに入れてから flush する。
+        __block BOOL updated = NO;
+        if (![self enqueueClipItemUpdateTime:dataHash time:updateTime completion:^(BOOL committed) {
+            updated = committed;
+        }]) {
+            return NO;
+        }
+        [self flushPendingWrites];
+        return updated;
+    }
+
     __block BOOL updated = NO;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
-        updated = [db executeUpdate:@"UPDATE clip_items SET update_time = ? WHERE data_hash = ?"
-               withArgumentsInArray:@[@(updateTime), dataHash]];
+    [self inDatabaseForOperation:RCDatabaseOperationUpdateTime block:^(FMDatabase * _Nonnull db) {
+        updated = [db executeUpdate:kRCUpdateClipItemUpdateTimeSQL
+               withArgumentsInArray:@[@(updateTime), digest]];
         if (!updated) {
             [self logDatabaseError:db context:@"Failed to update clip_items.update_time"];
         } else if (db.changes == 0) {
@@ -333,16 +740,166 @@ static os_log_t RCDatabaseManagerLog(void) {
     return updated;
 }
 
+- (BOOL)enqueueClipItemUpdateTime:(NSString *)dataHash
+                              time:(NSInteger)updateTime
+                        completion:(RCClipItemWriteCompletion)completion {
+    if (completion == nil || [self digestDataForDataHash:dataHash] == nil || ![self ensureDatabaseReadyForOperation]) {
+        return NO;
+    }
+
+    if (self.writeBehindInterval <= 0) {
+        completion([self updateClipItemUpdateTime:dataHash time:updateTime]);
+        return YES;
+    }
+
+    BOOL flushImmediately = NO;
+    @synchronized (self.pendingWriteLock) {
+        RCClipItem *pendingItem = nil;
+        for (RCClipItem *candidate in self.pendingInserts) {
+            if ([candidate.dataHash isEqualToString:dataHash]) {
+                pendingItem = candidate;
+                break;
+            }
+        }
+
+        // キュー上の INSERT に重ねた更新は、その INSERT の結果で完了する。
+        if (pendingItem != nil) {
+            pendingItem.updateTime = updateTime;
+        } else {
+            self.pendingUpdateTimes[dataHash] = @(updateTime);
+        }
+        NSMutableArray<RCClipItemWriteCompletion> *completions = self.pendingUpdateCompletions[dataHash];
+        if (completions == nil) {
+            completions = [NSMutableArray array];
+            self.pendingUpdateCompletions[dataHash] = completions;
+        }
+        [completions addObject:[completion copy]];
+        flushImmediately = (self.pendingInserts.count + self.pendingUpdateTimes.count >= kRCWriteBehindMaxPendingWrites);
+    }
+
+    [self scheduleWriteBehindFlushImmediately:flushImmediately];
+    return YES;
+}
+
+- (BOOL)flushPendingWrites {
+    // flush 同士を直列化し、コミット順がキュー投入順と一致するようにする。
+    @synchronized (self.writeBehindFlushLock) {
+        NSArray<RCClipItem *> *inserts = nil;
+        NSDictionary<NSString *, NSNumber *> *updateTimes = nil;
+        NSDictionary<NSString *, RCClipItemWriteCompletion> *completions = nil;
+        NSDictionary<NSString *, NSArray<RCClipItemWriteCompletion> *> *updateCompletions = nil;
+        @synchronized (self.pendingWriteLock) {
+            self.writeBehindFlushScheduled = NO;
+            if (self.pendingInserts.count == 0 && self.pendingUpdateTimes.count == 0) {
+                return YES;
+            }
+
+            inserts = [self.pendingInserts copy];
+            updateTimes = [self.pendingUpdateTimes copy];
+            completions = [self.pendingInsertCompletions copy];
+            updateCompletions = [self.pendingUpdateCompletions copy];
+            [self.pendingInserts removeAllObjects];
+            [self.pendingUpdateTimes removeAllObjects];
+            [self.pendingInsertCompletions removeAllObjects];
+            [self.pendingUpdateCompletions removeAllObjects];
+            self.flushingInserts = inserts;
+            self.flushingUpdateTimes = updateTimes;
+        }
+
+        BOOL committed = NO;
+        NSMutableSet<NSString *> *rejectedHashes = [NSMutableSet set];
+        NSMutableSet<NSString *> *updatedHashes = [NSMutableSet set];
+        FMDatabaseQueue *databaseQueue = self.databaseQueue;
+        if (databaseQueue != nil && ![RCPanicEraseService shared].isPanicInProgress) {
+            committed = [self inTransactionForOperation:RCDatabaseOperationWriteBehindFlush block:^(FMDatabase * _Nonnull db, BOOL * _Nonnull rollback) {
+                (void)rollback;
+                // 行ごとにセーブポイントを切り、失敗した行（制約違反・ブロブ参照の失敗）だけを
+                // 取り消して残りは同じトランザクションでコミットする。
+                for (RCClipItem *clipItem in inserts) {
+                    NSError *savePointError = nil;
+                    if (![db startSavePointWithName:@"write_behind_insert" error:&savePointError]) {
+                        [self logDatabaseError:db context:@"Failed to start write-behind savepoint"];
+                        [rejectedHashes addObject:clipItem.dataHash];
+                        continue;
+                    }
+                    if (![self insertClipItemRow:clipItem inDatabase:db]) {
+                        [rejectedHashes addObject:clipItem.dataHash];
+                        [db rollbackToSavePointWithName:@"write_behind_insert" error:&savePointError];
+                    }
+                    [db releaseSavePointWithName:@"write_behind_insert" error:&savePointError];
+                }
+                [updateTimes enumerateKeysAndObjectsUsingBlock:^(NSString *dataHash, NSNumber *updateTime, BOOL *stop) {
+                    (void)stop;
+                    NSData *digest = [self digestDataForDataHash:dataHash];
+                    if (digest == nil) {
+                        return;
+                    }
+                    if (![db executeUpdate:kRCUpdateClipItemUpdateTimeSQL withArgumentsInArray:@[updateTime, digest]]) {
+                        [self logDatabaseError:db context:@"Failed to update clip_items.update_time"];
+                    } else if (db.changes > 0) {
+                        // 0 行なら、キューにある間に削除・押し出しされた行。
+                        [updatedHashes addObject:dataHash];
+                    }
+                }];
+            }];
+        }
+
+        // COMMIT に失敗した場合、フィルタには入らなかった行の分が残るが、
+        // 偽陽性（SQLite を引くだけ）なので作り直さない。
+        if (!committed) {
+            os_log_error(RCDatabaseManagerLog(),
+                         "Dropped %lu pending clip writes",
+                         (unsigned long)(inserts.count + updateTimes.count));
+        } else if (rejectedHashes.count > 0) {
+            os_log_error(RCDatabaseManagerLog(),
+                         "Rejected %lu queued clip inserts",
+                         (unsigned long)rejectedHashes.count);
+        }
+
+        @synchronized (self.pendingWriteLock) {
+            self.flushingInserts = nil;
+            self.flushingUpdateTimes = nil;
+        }
+        // flush の直列化を保ったまま通知し、insertClipItemObject: が自分の行の結果を待てるようにする。
+        // 失敗した行のクリップファイルは呼び出し側が消す。
+        NSMutableSet<NSString *> *insertedHashes = [NSMutableSet set];
+        for (RCClipItem *clipItem in inserts) {
+            BOOL inserted = committed && ![rejectedHashes containsObject:clipItem.dataHash];
+            if (inserted) {
+                [insertedHashes addObject:clipItem.dataHash];
+            }
+            RCClipItemWriteCompletion completion = completions[clipItem.dataHash];
+            if (completion != nil) {
+                completion(inserted);
+            }
+        }
+        [updateCompletions enumerateKeysAndObjectsUsingBlock:^(NSString *dataHash, NSArray<RCClipItemWriteCompletion> *blocks, BOOL *stop) {
+            (void)stop;
+            BOOL updated = committed && ([insertedHashes containsObject:dataHash] || [updatedHashes containsObject:dataHash]);
+            for (RCClipItemWriteCompletion completion in blocks) {
+                completion(updated);
+            }
+        }];
+        return committed;
+    }
+}
+
 - (BOOL)deleteClipItemWithDataHash:(NSString *)dataHash {
-    if (dataHash.length == 0 || ![self ensureDatabaseReadyForOperation]) {
+    NSData *digest = [self digestDataForDataHash:dataHash];
+    if (digest == nil || ![self ensureDatabaseReadyForOperation]) {
         return NO;
     }
+    [self flushPendingWrites];
 
     __block BOOL deleted = NO;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
-        deleted = [db executeUpdate:@"DELETE FROM clip_items WHERE data_hash = ?" withArgumentsInArray:@[dataHash]];
+    [self inDatabaseForOperation:RCDatabaseOperationDelete block:^(FMDatabase * _Nonnull db) {
+        deleted = [db executeUpdate:kRCDeleteClipItemByDataHashSQL withArgumentsInArray:@[digest]];
         if (!deleted) {
             [self logDatabaseError:db context:@"Failed to delete clip_items row by data_hash"];
+            return;
+        }
+        if (db.changes > 0) {
+            [self removeDataHashesFromFilter:@[dataHash]];
         }
     }];
 
@@ -350,19 +907,24 @@ static os_log_t RCDatabaseManagerLog(void) {
 }
 
 - (BOOL)deleteClipItemWithDataHash:(NSString *)dataHash olderThan:(NSInteger)updateTimeMs {
-    if (dataHash.length == 0 || ![self ensureDatabaseReadyForOperation]) {
+    NSData *digest = [self digestDataForDataHash:dataHash];
+    if (digest == nil || ![self ensureDatabaseReadyForOperation]) {
         return NO;
     }
+    [self flushPendingWrites];
 
     __block BOOL deleted = NO;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
-        BOOL executed = [db executeUpdate:@"DELETE FROM clip_items WHERE data_hash = ? AND update_time < ?"
-                     withArgumentsInArray:@[dataHash, @(updateTimeMs)]];
+    [self inDatabaseForOperation:RCDatabaseOperationDelete block:^(FMDatabase * _Nonnull db) {
+        BOOL executed = [db executeUpdate:kRCDeleteExpiredClipItemByDataHashSQL
+                     withArgumentsInArray:@[digest, @(updateTimeMs)]];
         if (!executed) {
             [self logDatabaseError:db context:@"Failed to delete expired clip_items row"];
             return;
         }
         deleted = (db.changes > 0);
+        if (deleted) {
+            [self removeDataHashesFromFilter:@[dataHash]];
+        }
     }];
 
     return deleted;
@@ -372,12 +934,18 @@ static os_log_t RCDatabaseManagerLog(void) {
     if (![self ensureDatabaseReadyForOperation]) {
         return NO;
     }
+    [self flushPendingWrites];
 
     __block BOOL deleted = NO;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
-        deleted = [db executeUpdate:@"DELETE FROM clip_items WHERE update_time < ?" withArgumentsInArray:@[@(updateTime)]];
+    [self inDatabaseForOperation:RCDatabaseOperationDelete block:^(FMDatabase * _Nonnull db) {
+        deleted = [db executeUpdate:kRCDeleteClipItemsOlderThanSQL withArgumentsInArray:@[@(updateTime)]];
         if (!deleted) {
             [self logDatabaseError:db context:@"Failed to delete old clip_items rows"];
+            return;
+        }
+        // 消えたハッシュが分からないので、フィルタは残った行から作り直す。
+        if (db.changes > 0) {
+            [self rebuildDigestFilterInDatabase:db];
         }
     }];
 
@@ -388,106 +956,277 @@ static os_log_t RCDatabaseManagerLog(void) {
     if (![self ensureDatabaseReadyForOperation]) {
         return @[];
     }
+    // 結果はそのまま削除に使われるため、キュー上の update_time 更新を先にコミットする。
+    [self flushPendingWrites];
 
-    __block NSMutableArray<RCClipItem *> *clipItems = [NSMutableArray array];
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
-        FMResultSet *resultSet = [db executeQuery:@"SELECT id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code FROM clip_items WHERE update_time < ? ORDER BY update_time ASC"
-                             withArgumentsInArray:@[@(updateTimeMs)]];
+    return [self clipItemsForQuery:kRCSelectClipItemsOlderThanSQL
+                         arguments:@[@(updateTimeMs)]
+                         operation:RCDatabaseOperationList
+                      errorContext:@"Failed to fetch old clip_items rows"];
+}
+
+- (nullable NSArray<RCClipItem *> *)evictClipItemsBeyondLimit:(NSInteger)maxHistorySize
+                                                     olderThan:(NSInteger)cutoffMs {
+    if (![self ensureDatabaseReadyForOperation]) {
+        return nil;
+    }
+    [self flushPendingWrites];
+
+    NSString *sql = kRCExpireClipItemsSQL;
+    NSArray *arguments = @[@(cutoffMs)];
+    if (maxHistorySize > 0) {
+        sql = kRCEvictClipItemsSQL;
+        arguments = @[@(cutoffMs), @(maxHistorySize)];
+    }
+
+    NSString *clipDirectoryPath = [self standardizedPath:[RCUtilities clipDataDirectoryPath]];
+    NSString *canonicalClipDirectoryPath = [self canonicalPath:clipDirectoryPath];
+
+    __block NSMutableArray<RCClipItem *> *evictedItems = [NSMutableArray array];
+    __block BOOL succeeded = NO;
+    BOOL committed = [self inTransactionForOperation:RCDatabaseOperationEvict block:^(FMDatabase * _Nonnull db, BOOL * _Nonnull rollback) {
+        FMResultSet *resultSet = [db executeQuery:sql withArgumentsInArray:arguments];
         if (!resultSet) {
-            [self logDatabaseError:db context:@"Failed to fetch old clip_items rows"];
+            [self logDatabaseError:db context:@"Failed to evict clip_items rows"];
+            *rollback = YES;
             return;
         }
 
-        while ([resultSet next]) {
-            NSDictionary *clipDictionary = [self clipItemDictionaryFromResultSet:resultSet];
-            RCClipItem *clipItem = [[RCClipItem alloc] initWithDictionary:clipDictionary];
-            [clipItems addObject:clipItem];
+        // RETURNING 付き DELETE は制約違反などをステップ時に返すため、
+        // next ではなく nextWithError: でエラーを拾う。
+        NSError *stepError = nil;
+        while ([resultSet nextWithError:&stepError]) {
+            [evictedItems addObject:[self clipItemFromResultSet:resultSet
+                                              clipDirectoryPath:clipDirectoryPath
+                                     canonicalClipDirectoryPath:canonicalClipDirectoryPath]];
         }
         [resultSet close];
+
+        if (stepError != nil) {
+            [self logDatabaseError:db context:@"Failed to evict clip_items rows"];
+            [evictedItems removeAllObjects];
+            *rollback = YES;
+            return;
+        }
+        succeeded = YES;
+    } afterCommit:^(FMDatabase * _Nonnull db) {
+        (void)db;
+        // コミット後、databaseQueue を離れる前に外す。キューの外で外すと、間に走った
+        // フィルタの再構築（消えた行を含まない）から別の行の指紋を消しかねない。
+        [self removeDataHashesFromFilter:[evictedItems valueForKey:@"dataHash"]];
     }];
 
-    return [clipItems copy];
+    if (!succeeded || !committed) {
+        return nil;
+    }
+    return [evictedItems copy];
 }
 
-- (NSArray *)fetchClipItemsWithLimit:(NSInteger)limit {
+- (NSArray<RCClipItem *> *)clipItemsWithLimit:(NSInteger)limit {
     if (limit <= 0 || ![self ensureDatabaseReadyForOperation]) {
         return @[];
     }
 
-    __block NSMutableArray<NSDictionary *> *rows = [NSMutableArray array];
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
-        FMResultSet *resultSet = [db executeQuery:@"SELECT id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code FROM clip_items ORDER BY update_time DESC LIMIT ?"
-                             withArgumentsInArray:@[@(limit)]];
+    return [self clipItemsMergingQueuedWritesAfterClipItem:nil
+                                                      limit:limit
+                                              committedRows:^NSArray<RCClipItem *> *(NSInteger fetchLimit) {
+        return [self clipItemsForQuery:kRCSelectRecentClipItemsSQL
+                             arguments:@[@(fetchLimit)]
+                             operation:RCDatabaseOperationList
+                          errorContext:@"Failed to fetch clip_items list"];
+    }];
+}
+
+- (NSArray<RCClipItem *> *)clipItemsAfterClipItem:(nullable RCClipItem *)clipItem limit:(NSInteger)limit {
+    if (clipItem == nil) {
+        return [self clipItemsWithLimit:limit];
+    }
+    // 未コミットの行（itemId 0）も前ページの末尾になり得る。
+    if (limit <= 0 || clipItem.itemId < 0 || ![self ensureDatabaseReadyForOperation]) {
+        return @[];
+    }
+
+    return [self clipItemsMergingQueuedWritesAfterClipItem:clipItem
+                                                      limit:limit
+                                              committedRows:^NSArray<RCClipItem *> *(NSInteger fetchLimit) {
+        return [self clipItemsForQuery:kRCSelectClipItemsPageSQL
+                             arguments:@[@(clipItem.updateTime), @(clipItem.itemId), @(fetchLimit)]
+                             operation:RCDatabaseOperationList
+                          errorContext:@"Failed to fetch clip_items page"];
+    }];
+}
+
+- (BOOL)enumerateClipItemsUsingBlock:(void (^)(RCClipItem *clipItem, BOOL *stop))block {
+    if (block == nil || ![self ensureDatabaseReadyForOperation]) {
+        return NO;
+    }
+    // 列挙結果は孤立ファイルの判定や履歴ファイルの削除に使われるため、キュー上の行も先にコミットする。
+    [self flushPendingWrites];
+
+    NSString *clipDirectoryPath = [self standardizedPath:[RCUtilities clipDataDirectoryPath]];
+    NSString *canonicalClipDirectoryPath = [self canonicalPath:clipDirectoryPath];
+
+    // 1 本のステートメントを最後までステップするので、列挙全体が同じ読み取りスナップショットになる。
+    // 1 行ずつデコードして autoreleasepool で解放し、履歴件数に比例した配列を作らない。
+    __block BOOL succeeded = YES;
+    [self inReadDatabaseForOperation:RCDatabaseOperationEnumerate block:^(FMDatabase * _Nonnull db) {
+        FMResultSet *resultSet = [db executeQuery:kRCSelectRecentClipItemsSQL withArgumentsInArray:@[@(-1)]];
         if (!resultSet) {
-            [self logDatabaseError:db context:@"Failed to fetch clip_items list"];
+            [self logDatabaseError:db context:@"Failed to enumerate clip_items"];
+            succeeded = NO;
             return;
         }
 
-        while ([resultSet next]) {
-            [rows addObject:[self clipItemDictionaryFromResultSet:resultSet]];
+        BOOL stop = NO;
+        NSError *stepError = nil;
+        while (!stop) {
+            @autoreleasepool {
+                if (![resultSet nextWithError:&stepError]) {
+                    break;
+                }
+                block([self clipItemFromResultSet:resultSet
+                                clipDirectoryPath:clipDirectoryPath
+                       canonicalClipDirectoryPath:canonicalClipDirectoryPath], &stop);
+            }
         }
         [resultSet close];
+
+        if (stepError != nil) {
+            [self logDatabaseError:db context:@"Failed to step clip_items enumeration"];
+            succeeded = NO;
+        }
     }];
+    return succeeded;
+}
 
+- (NSArray *)fetchClipItemsWithLimit:(NSInteger)limit {
+    NSArray<RCClipItem *> *clipItems = [self clipItemsWithLimit:limit];
+    NSMutableArray<NSDictionary *> *rows = [NSMutableArray arrayWithCapacity:clipItems.count];
+    for (RCClipItem *clipItem in clipItems) {
+        [rows addObject:[clipItem toDictionary]];
+    }
     return [rows copy];
 }
 
-- (nullable NSDictionary *)clipItemWithDataHash:(NSString *)dataHash {
-    if (dataHash.length == 0 || ![self ensureDatabaseReadyForOperation]) {
+- (nullable RCClipItem *)clipItemForDataHash:(NSString *)dataHash {
+    NSData *digest = [self digestDataForDataHash:dataHash];
+    if (digest == nil || ![self ensureDatabaseReadyForOperation]) {
         return nil;
     }
 
-    __block NSDictionary *clipItem = nil;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
-        FMResultSet *resultSet = [db executeQuery:@"SELECT id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code FROM clip_items WHERE data_hash = ? LIMIT 1"
-                             withArgumentsInArray:@[dataHash]];
+    // キャプチャ毎に呼ばれる点検索は flush せず、未コミットの書き込みを重ねて返す。
+    // pending → flushing → コミット済みの順に移るため、先にキューを見れば取りこぼさない。
+    RCClipItem *clipItem = nil;
+    NSNumber *pendingUpdateTime = nil;
+    @synchronized (self.pendingWriteLock) {
+        clipItem = [[self pendingClipItemForDataHash:dataHash] copy];
+        pendingUpdateTime = self.pendingUpdateTimes[dataHash] ?: self.flushingUpdateTimes[dataHash];
+    }
+
+    // フィルタへの追加は行の INSERT と同じトランザクション内で行い、flushing* は
+    // コミット後に空になるので、キューに無くフィルタにも無ければ未保存と確定する。
+    if (clipItem == nil && ![self digestFilterMayContainDigest:digest]) {
+        return nil;
+    }
+    if (clipItem == nil) {
+        clipItem = [self clipItemsForQuery:kRCSelectClipItemByDataHashSQL
+                                 arguments:@[digest]
+                                 operation:RCDatabaseOperationDedupLookup
+                              errorContext:@"Failed to fetch clip_items row by data_hash"].firstObject;
+    }
+    if (clipItem != nil && pendingUpdateTime != nil) {
+        clipItem.updateTime = pendingUpdateTime.integerValue;
+    }
+    return clipItem;
+}
+
+- (nullable RCClipItem *)clipItemForCapturedClipData:(RCClipData *)clipData dataHash:(NSString *)dataHash {
+    RCClipItem *clipItem = [self clipItemForDataHash:dataHash];
+    if (clipItem != nil || !self.legacyFingerprintsPending) {
+        return clipItem;
+    }
+
+    // 再計算がまだの行は v1 のフィンガープリントで保存されている。v1 は先頭の表現しか
+    // 読まず、計算するのも v2 で見つからなかったキャプチャで移行が終わるまでの間だけ。
+    NSString *legacyDataHash = [clipData legacyDataHash];
+    if (legacyDataHash.length == 0 || [legacyDataHash isEqualToString:dataHash]) {
+        return nil;
+    }
+    return [self clipItemForDataHash:legacyDataHash];
+}
+
+- (nullable NSDictionary *)clipItemWithDataHash:(NSString *)dataHash {
+    return [[self clipItemForDataHash:dataHash] toDictionary];
+}
+
+- (NSInteger)clipItemCount {
+    if (![self ensureDatabaseReadyForOperation]) {
+        return 0;
+    }
+
+    __block NSInteger count = 0;
+    [self inReadDatabaseForOperation:RCDatabaseOperationStatistics block:^(FMDatabase * _Nonnull db) {
+        FMResultSet *resultSet = [db executeQuery:kRCSelectClipStatsTotalCountSQL];
         if (!resultSet) {
-            [self logDatabaseError:db context:@"Failed to fetch clip_items row by data_hash"];
+            [self logDatabaseError:db context:@"Failed to count clip_items rows"];
             return;
         }
 
         if ([resultSet next]) {
-            clipItem = [self clipItemDictionaryFromResultSet:resultSet];
+            count = (NSInteger)[resultSet longLongIntForColumnIndex:0];
         }
         [resultSet close];
     }];
 
-    return clipItem;
+    return count;
 }
 
-- (NSInteger)clipItemCount {
+- (RCClipStatistics *)clipStatistics {
+    RCClipStatistics *statistics = [[RCClipStatistics alloc] init];
     if (![self ensureDatabaseReadyForOperation]) {
-        return 0;
+        return statistics;
     }
 
-    __block NSInteger count = 0;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
-        FMResultSet *resultSet = [db executeQuery:@"SELECT COUNT(*) AS total FROM clip_items"];
+    NSMutableDictionary<NSString *, NSNumber *> *countsByPrimaryType = [NSMutableDictionary dictionary];
+    __block NSInteger itemCount = 0;
+    __block long long totalDataSize = 0;
+    [self inReadDatabaseForOperation:RCDatabaseOperationStatistics block:^(FMDatabase * _Nonnull db) {
+        FMResultSet *resultSet = [db executeQuery:kRCSelectClipStatsSQL];
         if (!resultSet) {
-            [self logDatabaseError:db context:@"Failed to count clip_items rows"];
+            [self logDatabaseError:db context:@"Failed to read clip_stats"];
             return;
         }
 
-        if ([resultSet next]) {
-            count = [resultSet longLongIntForColumn:@"total"];
+        while ([resultSet next]) {
+            NSInteger typeCount = (NSInteger)[resultSet longLongIntForColumnIndex:1];
+            countsByPrimaryType[[resultSet stringForColumnIndex:0] ?: @""] = @(typeCount);
+            itemCount += typeCount;
+            totalDataSize += [resultSet longLongIntForColumnIndex:2];
         }
         [resultSet close];
     }];
 
-    return count;
+    statistics.itemCount = itemCount;
+    statistics.totalDataSize = totalDataSize;
+    statistics.itemCountsByPrimaryType = countsByPrimaryType;
+    return statistics;
 }
 
 - (BOOL)deleteAllClipItems {
     if (![self ensureDatabaseReadyForOperation]) {
         return NO;
     }
+    [self flushPendingWrites];
 
     __block BOOL deleted = NO;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
+    [self inDatabaseForOperation:RCDatabaseOperationDelete block:^(FMDatabase * _Nonnull db) {
         deleted = [db executeUpdate:@"DELETE FROM clip_items"];
         if (!deleted) {
             [self logDatabaseError:db context:@"Failed to delete all clip_items rows"];
+            return;
         }
+        [self clearDigestFilter];
+        [self optimizeSearchIndexTable:@"clip_search" inDatabase:db];
     }];
 
     return deleted;
@@ -499,7 +1238,7 @@ static os_log_t RCDatabaseManagerLog(void) {
     }
 
     __block BOOL deleted = YES;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
+    [self inDatabaseForOperation:RCDatabaseOperationSnippets block:^(FMDatabase * _Nonnull db) {
         if ([self tableExists:@"snippets" inDatabase:db]) {
             if (![db executeUpdate:@"DELETE FROM snippets"]) {
                 [self logDatabaseError:db context:@"Failed to delete all snippets rows"];
@@ -521,6 +1260,7 @@ static os_log_t RCDatabaseManagerLog(void) {
 }
 
 - (BOOL)panicDeleteAllClipItems {
+    [self discardPendingWrites];
     if (![self ensureDatabaseQueue]) {
         return NO;
     }
@@ -530,7 +1270,10 @@ static os_log_t RCDatabaseManagerLog(void) {
         deleted = [db executeUpdate:@"DELETE FROM clip_items"];
         if (!deleted) {
             [self logDatabaseError:db context:@"Panic: Failed to delete all clip_items rows"];
+            return;
         }
+        [self clearDigestFilter];
+        [self optimizeSearchIndexTable:@"clip_search" inDatabase:db];
     }];
     return deleted;
 }
@@ -557,6 +1300,7 @@ static os_log_t RCDatabaseManagerLog(void) {
                 return;
             }
         }
+        [self optimizeSearchIndexTable:@"snippet_search" inDatabase:db];
     }];
     return deleted;
 }
@@ -578,7 +1322,7 @@ static os_log_t RCDatabaseManagerLog(void) {
     NSString *title = [self stringValueInDictionary:folderDict keys:@[@"title"] defaultValue:@"untitled folder"];
 
     __block BOOL inserted = NO;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
+    [self inDatabaseForOperation:RCDatabaseOperationSnippets block:^(FMDatabase * _Nonnull db) {
         inserted = [db executeUpdate:@"INSERT INTO snippet_folders (identifier, folder_index, enabled, title) VALUES (?, ?, ?, ?)"
                 withArgumentsInArray:@[identifier, folderIndex, enabled, title]];
         if (!inserted) {
@@ -634,7 +1378,7 @@ static os_log_t RCDatabaseManagerLog(void) {
     [arguments addObject:identifier];
 
     __block BOOL updated = NO;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
+    [self inDatabaseForOperation:RCDatabaseOperationSnippets block:^(FMDatabase * _Nonnull db) {
         updated = [db executeUpdate:sql withArgumentsInArray:arguments];
         if (!updated) {
             [self logDatabaseError:db context:@"Failed to update snippet_folders row"];
@@ -653,7 +1397,7 @@ static os_log_t RCDatabaseManagerLog(void) {
     }
 
     __block BOOL deleted = NO;
-    [self.databaseQueue inTransaction:^(FMDatabase * _Nonnull db, BOOL * _Nonnull rollback) {
+    BOOL committed = [self inTransactionForOperation:RCDatabaseOperationSnippets block:^(FMDatabase * _Nonnull db, BOOL * _Nonnull rollback) {
         // Explicitly delete child snippets before deleting the folder as a
         // defensive measure, rather than relying solely on ON DELETE CASCADE.
         BOOL deletedChildren = [db executeUpdate:@"DELETE FROM snippets WHERE folder_id = ?" withArgumentsInArray:@[identifier]];
@@ -675,7 +1419,7 @@ static os_log_t RCDatabaseManagerLog(void) {
         deleted = YES;
     }];
 
-    return deleted;
+    return deleted && committed;
 }
 
 - (BOOL)deleteAllSnippetFolders {
@@ -684,7 +1428,7 @@ static os_log_t RCDatabaseManagerLog(void) {
     }
 
     __block BOOL deleted = NO;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
+    [self inDatabaseForOperation:RCDatabaseOperationSnippets block:^(FMDatabase * _Nonnull db) {
         deleted = [db executeUpdate:@"DELETE FROM snippet_folders"];
         if (!deleted) {
             [self logDatabaseError:db context:@"Failed to delete all snippet_folders rows"];
@@ -700,8 +1444,8 @@ static os_log_t RCDatabaseManagerLog(void) {
     }
 
     __block NSMutableArray<NSDictionary *> *rows = [NSMutableArray array];
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
-        FMResultSet *resultSet = [db executeQuery:@"SELECT id, identifier, folder_index, enabled, title FROM snippet_folders ORDER BY folder_index ASC, id ASC"];
+    [self inReadDatabaseForOperation:RCDatabaseOperationSnippets block:^(FMDatabase * _Nonnull db) {
+        FMResultSet *resultSet = [db executeQuery:kRCSelectSnippetFoldersSQL];
         if (!resultSet) {
             [self logDatabaseError:db context:@"Failed to fetch snippet_folders rows"];
             return;
@@ -722,7 +1466,7 @@ static os_log_t RCDatabaseManagerLog(void) {
     }
 
     __block BOOL exists = NO;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
+    [self inReadDatabaseForOperation:RCDatabaseOperationSnippets block:^(FMDatabase * _Nonnull db) {
         FMResultSet *resultSet = [db executeQuery:@"SELECT 1 FROM snippet_folders WHERE identifier = ? LIMIT 1"
                              withArgumentsInArray:@[identifier]];
         if (!resultSet) {
@@ -757,7 +1501,7 @@ static os_log_t RCDatabaseManagerLog(void) {
     NSString *content = [self stringValueInDictionary:snippetDict keys:@[@"content"] defaultValue:@""];
 
     __block BOOL inserted = NO;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
+    [self inDatabaseForOperation:RCDatabaseOperationSnippets block:^(FMDatabase * _Nonnull db) {
         inserted = [db executeUpdate:@"INSERT INTO snippets (identifier, folder_id, snippet_index, enabled, title, content) VALUES (?, ?, ?, ?, ?, ?)"
                 withArgumentsInArray:@[identifier, folderID, snippetIndex, enabled, title, content]];
         if (!inserted) {
@@ -838,7 +1582,7 @@ static os_log_t RCDatabaseManagerLog(void) {
     [arguments addObject:identifier];
 
     __block BOOL updated = NO;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
+    [self inDatabaseForOperation:RCDatabaseOperationSnippets block:^(FMDatabase * _Nonnull db) {
         updated = [db executeUpdate:sql withArgumentsInArray:arguments];
         if (!updated) {
             [self logDatabaseError:db context:@"Failed to update snippets row"];
@@ -857,7 +1601,7 @@ static os_log_t RCDatabaseManagerLog(void) {
     }
 
     __block BOOL deleted = NO;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
+    [self inDatabaseForOperation:RCDatabaseOperationSnippets block:^(FMDatabase * _Nonnull db) {
         deleted = [db executeUpdate:@"DELETE FROM snippets WHERE identifier = ?" withArgumentsInArray:@[identifier]];
         if (!deleted) {
             [self logDatabaseError:db context:@"Failed to delete snippets row"];
@@ -873,8 +1617,8 @@ static os_log_t RCDatabaseManagerLog(void) {
     }
 
     __block NSMutableArray<NSDictionary *> *rows = [NSMutableArray array];
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
-        FMResultSet *resultSet = [db executeQuery:@"SELECT id, identifier, folder_id, snippet_index, enabled, title, content FROM snippets WHERE folder_id = ? ORDER BY snippet_index ASC, id ASC"
+    [self inReadDatabaseForOperation:RCDatabaseOperationSnippets block:^(FMDatabase * _Nonnull db) {
+        FMResultSet *resultSet = [db executeQuery:kRCSelectSnippetsForFolderSQL
                              withArgumentsInArray:@[folderIdentifier]];
         if (!resultSet) {
             [self logDatabaseError:db context:@"Failed to fetch snippets rows"];
@@ -896,7 +1640,7 @@ static os_log_t RCDatabaseManagerLog(void) {
     }
 
     __block BOOL exists = NO;
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
+    [self inReadDatabaseForOperation:RCDatabaseOperationSnippets block:^(FMDatabase * _Nonnull db) {
         FMResultSet *resultSet = [db executeQuery:@"SELECT 1 FROM snippets WHERE identifier = ? LIMIT 1"
                              withArgumentsInArray:@[identifier]];
         if (!resultSet) {
@@ -911,32 +1655,328 @@ static os_log_t RCDatabaseManagerLog(void) {
     return exists;
 }
 
-#pragma mark - Private: Database setup
+#pragma mark - Public: search
 
-+ (NSString *)defaultDatabasePath {
-    NSString *revclipDirectoryPath = [RCUtilities applicationSupportPath];
-    return [revclipDirectoryPath stringByAppendingPathComponent:@"revclip.db"];
+- (NSArray<RCClipItem *> *)searchClipItemsMatching:(NSString *)query limit:(NSInteger)limit offset:(NSInteger)offset {
+    NSString *matchExpression = [self matchExpressionForSearchQuery:query];
+    if (matchExpression == nil || limit <= 0 || ![self ensureDatabaseReadyForOperation]) {
+        return @[];
+    }
+
+    return [self clipItemsForQuery:kRCSearchClipItemsSQL
+                         arguments:@[matchExpression, @(limit), @(MAX(offset, 0))]
+                         operation:RCDatabaseOperationSearch
+                      errorContext:@"Failed to search clip_items"];
 }
 
-// WARNING: This method must never be called from within an FMDatabaseQueue
-// inDatabase: or inTransaction: block. FMDatabaseQueue uses a serial dispatch
-// queue internally, so re-entrant calls will deadlock.
-- (BOOL)ensureDatabaseReadyForOperation {
-    if ([RCPanicEraseService shared].isPanicInProgress) {
-        return NO;
+- (NSArray *)searchSnippetsMatching:(NSString *)query limit:(NSInteger)limit offset:(NSInteger)offset {
+    NSString *matchExpression = [self matchExpressionForSearchQuery:query];
+    if (matchExpression == nil || limit <= 0 || ![self ensureDatabaseReadyForOperation]) {
+        return @[];
     }
 
-    @synchronized (self) {
-        if (self.setupCompleted) {
-            return YES;
+    __block NSMutableArray<NSDictionary *> *rows = [NSMutableArray array];
+    [self inReadDatabaseForOperation:RCDatabaseOperationSearch block:^(FMDatabase * _Nonnull db) {
+        FMResultSet *resultSet = [db executeQuery:kRCSearchSnippetsSQL
+                             withArgumentsInArray:@[matchExpression, @(limit), @(MAX(offset, 0))]];
+        if (!resultSet) {
+            [self logDatabaseError:db context:@"Failed to search snippets"];
+            return;
         }
 
-        return [self setupDatabase];
-    }
+        while ([resultSet next]) {
+            [rows addObject:[self snippetDictionaryFromResultSet:resultSet]];
+        }
+        [resultSet close];
+    }];
+
+    return [rows copy];
 }
 
-- (BOOL)ensureDatabaseQueue {
-    if (self.databaseQueue != nil) {
+- (NSArray<RCClipItem *> *)clipItemsMissingSearchTextWithLimit:(NSInteger)limit {
+    if (limit <= 0 || ![self ensureDatabaseReadyForOperation]) {
+        return @[];
+    }
+
+    return [self clipItemsForQuery:kRCSelectClipItemsMissingSearchTextSQL
+                         arguments:@[@(limit)]
+                         operation:RCDatabaseOperationSearchBackfill
+                      errorContext:@"Failed to fetch clip_items rows missing search text"];
+}
+
+- (BOOL)indexSearchTextForClipItems:(NSArray<RCClipItem *> *)clipItems {
+    if (clipItems.count == 0) {
+        return YES;
+    }
+    if (![self ensureDatabaseReadyForOperation]) {
+        return NO;
+    }
+
+    __block BOOL indexed = YES;
+    BOOL committed = [self inTransactionForOperation:RCDatabaseOperationSearchBackfill block:^(FMDatabase * _Nonnull db, BOOL * _Nonnull rollback) {
+        for (RCClipItem *clipItem in clipItems) {
+            // 取得後に削除された行には索引を作らない（WHERE id = ? で弾かれる）。
+            if (![db executeUpdate:kRCBackfillClipSearchTextSQL
+              withArgumentsInArray:@[clipItem.searchText ?: @"", @(clipItem.itemId), @(clipItem.itemId)]]) {
+                [self logDatabaseError:db context:@"Failed to backfill clip_search row"];
+                indexed = NO;
+                *rollback = YES;
+                return;
+            }
+        }
+    }];
+    return indexed && committed;
+}
+
+#pragma mark - Public: clip blobs
+
+- (NSArray<NSString *> *)releasedBlobDigestsWithLimit:(NSInteger)limit {
+    if (limit <= 0 || ![self ensureDatabaseReadyForOperation]) {
+        return @[];
+    }
+    // 返したダイジェストのブロブは削除されるため、キュー上の参照を先にコミットする。
+    [self flushPendingWrites];
+
+    NSMutableArray<NSString *> *digests = [NSMutableArray array];
+    [self inReadDatabaseForOperation:RCDatabaseOperationBlobReferences block:^(FMDatabase * _Nonnull db) {
+        FMResultSet *resultSet = [db executeQuery:kRCSelectReleasedBlobDigestsSQL withArgumentsInArray:@[@(limit)]];
+        if (!resultSet) {
+            [self logDatabaseError:db context:@"Failed to read clip_blob_garbage"];
+            return;
+        }
+
+        while ([resultSet next]) {
+            NSData *digest = [resultSet dataForColumnIndex:0];
+            if (digest.length == kRCDataDigestLength) {
+                [digests addObject:[RCUtilities hexStringFromBytes:digest.bytes length:digest.length]];
+            }
+        }
+        [resultSet close];
+    }];
+    return [digests copy];
+}
+
+- (BOOL)isBlobDigestReferenced:(NSString *)digest {
+    NSData *digestData = [self digestDataForDataHash:digest];
+    if (digestData == nil || ![self ensureDatabaseReadyForOperation]) {
+        // 判定できない場合は参照中として扱い、削除させない。
+        return YES;
+    }
+
+    @synchronized (self.pendingWriteLock) {
+        NSArray<RCClipItem *> *queuedInserts = [self.pendingInserts arrayByAddingObjectsFromArray:self.flushingInserts ?: @[]];
+        for (RCClipItem *clipItem in queuedInserts) {
+            if ([clipItem.blobDigests containsObject:digest.lowercaseString]) {
+                return YES;
+            }
+        }
+    }
+
+    __block BOOL referenced = YES;
+    [self inReadDatabaseForOperation:RCDatabaseOperationBlobReferences block:^(FMDatabase * _Nonnull db) {
+        FMResultSet *resultSet = [db executeQuery:kRCSelectClipBlobReferencedSQL withArgumentsInArray:@[digestData]];
+        if (!resultSet) {
+            [self logDatabaseError:db context:@"Failed to look up clip_blobs row"];
+            return;
+        }
+        referenced = [resultSet next];
+        [resultSet close];
+    }];
+    return referenced;
+}
+
+- (BOOL)forgetReleasedBlobDigests:(NSArray<NSString *> *)digests {
+    if (digests.count == 0) {
+        return YES;
+    }
+    if (![self ensureDatabaseReadyForOperation]) {
+        return NO;
+    }
+
+    __block BOOL deleted = YES;
+    BOOL committed = [self inTransactionForOperation:RCDatabaseOperationBlobReferences block:^(FMDatabase * _Nonnull db, BOOL * _Nonnull rollback) {
+        for (NSString *digest in digests) {
+            NSData *digestData = [self digestDataForDataHash:digest];
+            if (digestData == nil) {
+                continue;
+            }
+            if (![db executeUpdate:kRCDeleteReleasedBlobDigestSQL withArgumentsInArray:@[digestData]]) {
+                [self logDatabaseError:db context:@"Failed to delete clip_blob_garbage row"];
+                deleted = NO;
+                *rollback = YES;
+                return;
+            }
+        }
+    }];
+    return deleted && committed;
+}
+
+#pragma mark - Public: deferred maintenance
+
+- (BOOL)hasDeferredMaintenance {
+    return ![[NSUserDefaults standardUserDefaults] boolForKey:kRCAutoVacuumMigrationCompletedKey]
+        || [self hasPendingOnlineMigrations];
+}
+
+- (BOOL)hasPendingOnlineMigrations {
+    if (![self ensureDatabaseReadyForOperation]) {
+        return NO;
+    }
+    NSSet<NSString *> *pendingNames = [self pendingOnlineMigrationNames];
+    for (RCOnlineMigration *migration in self.onlineMigrations) {
+        if ([pendingNames containsObject:migration.name]) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+- (BOOL)runOnlineMigrationsWithProgress:(nullable NSProgress *)progress {
+    if (![self ensureDatabaseReadyForOperation]) {
+        return NO;
+    }
+    NSSet<NSString *> *pendingNames = [self pendingOnlineMigrationNames];
+    if (pendingNames == nil) {
+        return NO;
+    }
+
+    // 新しいビルドが予約した未知の名前は、このビルドでは実行できないので残しておく。
+    NSMutableArray<RCOnlineMigration *> *pendingMigrations = [NSMutableArray array];
+    for (RCOnlineMigration *migration in self.onlineMigrations) {
+        if ([pendingNames containsObject:migration.name]) {
+            [pendingMigrations addObject:migration];
+        }
+    }
+    progress.totalUnitCount = MAX((int64_t)pendingMigrations.count, 1);
+    for (RCOnlineMigration *migration in pendingMigrations) {
+        if (progress.isCancelled) {
+            return NO;
+        }
+        NSProgress *migrationProgress = nil;
+        if (progress != nil) {
+            migrationProgress = [NSProgress progressWithTotalUnitCount:1 parent:progress pendingUnitCount:1];
+        }
+        if (![self runOnlineMigration:migration progress:migrationProgress]) {
+            return NO;
+        }
+        migrationProgress.completedUnitCount = migrationProgress.totalUnitCount;
+    }
+    progress.completedUnitCount = progress.totalUnitCount;
+    return YES;
+}
+
+- (BOOL)performDeferredMaintenanceWithProgress:(nullable NSProgress *)progress {
+    if (![self hasDeferredMaintenance]) {
+        progress.totalUnitCount = 1;
+        progress.completedUnitCount = 1;
+        return YES;
+    }
+    if (![self ensureDatabaseReadyForOperation]) {
+        return NO;
+    }
+    [self flushPendingWrites];
+
+    // 手順ごとに 1 単位を割り当て、各手順の進捗は子の NSProgress で報告する。
+    progress.totalUnitCount = 2;
+    NSProgress *migrationProgress = nil;
+    if (progress != nil) {
+        migrationProgress = [NSProgress progressWithTotalUnitCount:1 parent:progress pendingUnitCount:1];
+    }
+    if (![self runOnlineMigrationsWithProgress:migrationProgress]) {
+        return NO;
+    }
+    migrationProgress.completedUnitCount = migrationProgress.totalUnitCount;
+
+    NSProgress *vacuumProgress = nil;
+    if (progress != nil) {
+        vacuumProgress = [NSProgress progressWithTotalUnitCount:1 parent:progress pendingUnitCount:1];
+    }
+    if (![self migrateAutoVacuumToIncrementalWithProgress:vacuumProgress]) {
+        return NO;
+    }
+    vacuumProgress.completedUnitCount = vacuumProgress.totalUnitCount;
+    return YES;
+}
+
+#pragma mark - Public: diagnostics
+
+- (nullable NSData *)queryMetricsJSONData {
+    NSMutableDictionary<NSString *, NSDictionary *> *operations = [NSMutableDictionary dictionary];
+    size_t operationCount = RCQueryMetricsOperationCount(self.queryMetrics);
+    for (size_t index = 0; index < operationCount; index++) {
+        RCLatencySnapshot queueWait;
+        RCLatencySnapshot execution;
+        RCQueryMetricsOperationSnapshot(self.queryMetrics, index, &queueWait, &execution);
+        if (execution.count == 0) {
+            continue;
+        }
+        NSString *name = @(RCQueryMetricsOperationName(self.queryMetrics, index));
+        operations[name] = @{
+            @"queueWait": [RCUtilities dictionaryFromLatencySnapshot:&queueWait],
+            @"execution": [RCUtilities dictionaryFromLatencySnapshot:&execution],
+        };
+    }
+
+    NSMutableDictionary<NSString *, NSDictionary *> *statements = [NSMutableDictionary dictionary];
+    size_t statementCount = RCQueryMetricsStatementCount(self.queryMetrics);
+    for (size_t index = 0; index < statementCount; index++) {
+        RCLatencySnapshot snapshot;
+        RCQueryMetricsStatementSnapshot(self.queryMetrics, index, &snapshot);
+        if (snapshot.count == 0) {
+            continue;
+        }
+        statements[@(RCQueryMetricsStatementName(self.queryMetrics, index))] = [RCUtilities dictionaryFromLatencySnapshot:&snapshot];
+    }
+
+    NSDictionary *report = @{
+        @"generatedAt": @((long long)([[NSDate date] timeIntervalSince1970] * 1000)),
+        @"sqliteVersion": @(sqlite3_libversion()),
+        @"bucketUpperBoundsMicroseconds": [RCUtilities latencyBucketUpperBoundsMicroseconds],
+        @"operations": operations,
+        @"statements": statements,
+    };
+    NSError *error = nil;
+    NSData *data = [NSJSONSerialization dataWithJSONObject:report
+                                                   options:NSJSONWritingPrettyPrinted | NSJSONWritingSortedKeys
+                                                     error:&error];
+    if (data == nil) {
+        os_log_error(RCDatabaseManagerLog(),
+                     "Failed to serialize query metrics (%{public}@)",
+                     error.localizedDescription);
+    }
+    return data;
+}
+
+- (void)resetQueryMetrics {
+    RCQueryMetricsReset(self.queryMetrics);
+}
+
+#pragma mark - Private: Database setup
+
++ (NSString *)defaultDatabasePath {
+    NSString *revclipDirectoryPath = [RCUtilities applicationSupportPath];
+    return [revclipDirectoryPath stringByAppendingPathComponent:@"revclip.db"];
+}
+
+// WARNING: This method must never be called from within an FMDatabaseQueue
+// inDatabase: or inTransaction: block. FMDatabaseQueue uses a serial dispatch
+// queue internally, so re-entrant calls will deadlock.
+- (BOOL)ensureDatabaseReadyForOperation {
+    if ([RCPanicEraseService shared].isPanicInProgress) {
+        return NO;
+    }
+
+    @synchronized (self) {
+        if (self.setupCompleted) {
+            return YES;
+        }
+
+        return [self setupDatabase];
+    }
+}
+
+- (BOOL)ensureDatabaseQueue {
+    if (self.databaseQueue != nil) {
         return YES;
     }
 
@@ -995,10 +2035,18 @@ static os_log_t RCDatabaseManagerLog(void) {
         return NO;
     }
 
-    // Enable foreign keys once on the connection. FMDatabaseQueue reuses a single
-    // connection, so this setting persists for all subsequent operations.
+    // Enable foreign keys and the prepared-statement cache once on the connection.
+    // FMDatabaseQueue reuses a single connection, so these settings persist for
+    // all subsequent operations.
     __block BOOL foreignKeysEnabled = NO;
     [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
+        db.shouldCacheStatements = YES;
+        // 検索索引のトリガーが rc_search_text() を呼ぶため、書き込み前に登録する。
+        if (RCSearchTextRegisterFunctions((sqlite3 *)db.sqliteHandle) != SQLITE_OK) {
+            [self logDatabaseError:db context:@"Failed to register rc_search_text()"];
+            return;
+        }
+        RCQueryMetricsAttachConnection(self.queryMetrics, (sqlite3 *)db.sqliteHandle);
         foreignKeysEnabled = [self enableForeignKeysForDatabase:db];
     }];
     if (!foreignKeysEnabled) {
@@ -1028,7 +2076,7 @@ static os_log_t RCDatabaseManagerLog(void) {
 
 - (BOOL)createBaseSchemaInDatabase:(FMDatabase *)db {
     NSArray<NSString *> *schemaStatements = @[
-        @"CREATE TABLE IF NOT EXISTS clip_items (id INTEGER PRIMARY KEY AUTOINCREMENT, data_path TEXT NOT NULL, title TEXT DEFAULT '', data_hash TEXT UNIQUE NOT NULL, primary_type TEXT DEFAULT '', update_time INTEGER NOT NULL, thumbnail_path TEXT DEFAULT '', is_color_code INTEGER DEFAULT 0)",
+        [@"CREATE TABLE IF NOT EXISTS clip_items " stringByAppendingString:kRCClipItemsTableDefinitionSQL],
         @"CREATE INDEX IF NOT EXISTS idx_clip_update_time ON clip_items(update_time DESC)",
         @"CREATE TABLE IF NOT EXISTS snippet_folders (id INTEGER PRIMARY KEY AUTOINCREMENT, identifier TEXT UNIQUE NOT NULL, folder_index INTEGER DEFAULT 0, enabled INTEGER DEFAULT 1, title TEXT DEFAULT 'untitled folder')",
         @"CREATE INDEX IF NOT EXISTS idx_folder_index ON snippet_folders(folder_index)",
@@ -1045,6 +2093,14 @@ static os_log_t RCDatabaseManagerLog(void) {
         }
     }
 
+    // 新規 DB は schema_version が最新で作られ migrateIfNeeded を通らないため、ここでも作成する。
+    if (![self createSearchIndexSchemaInDatabase:db]
+        || ![self createClipStatsSchemaInDatabase:db]
+        || ![self createClipBlobSchemaInDatabase:db]
+        || ![self createOnlineMigrationSchemaInDatabase:db]) {
+        return NO;
+    }
+
     // --- Schema version seed ---
     // Seed the initial version row if the table is empty. This is logically
     // separate from table/index creation above and only runs once on first launch.
@@ -1074,6 +2130,176 @@ static os_log_t RCDatabaseManagerLog(void) {
     return enabled;
 }
 
+- (BOOL)enableWriteAheadLoggingForDatabase:(FMDatabase *)db {
+    // journal_mode は永続設定。WAL に切り替えられない環境（ネットワークボリューム等）では
+    // 従来の rollback journal のまま動作を継続する。
+    NSString *journalMode = [[db stringForQuery:@"PRAGMA journal_mode = WAL"] lowercaseString];
+    if (![journalMode isEqualToString:@"wal"]) {
+        os_log_error(RCDatabaseManagerLog(),
+                     "Failed to enable WAL journal mode (mode=%{public}@); reads will share the writer connection",
+                     journalMode ?: @"(null)");
+        return NO;
+    }
+    return YES;
+}
+
+- (void)openReadConnectionPoolIfNeeded {
+    if (self.readConnectionPool != nil) {
+        return;
+    }
+
+    FMDatabasePool *pool = [FMDatabasePool databasePoolWithPath:self.databasePath
+                                                          flags:SQLITE_OPEN_READONLY];
+    if (pool == nil) {
+        os_log_error(RCDatabaseManagerLog(),
+                     "Failed to create read connection pool for path %{private}@",
+                     self.databasePath);
+        return;
+    }
+
+    pool.maximumNumberOfDatabasesToCreate = kRCReadConnectionPoolSize;
+    pool.delegate = self;
+    self.readConnectionPool = pool;
+}
+
+// 読み取り専用クエリを実行する。プールが無い場合（WAL 無効時・セットアップ前）は
+// ライター用の databaseQueue にフォールバックする。
+// WARNING: ensureDatabaseReadyForOperation と同様、databaseQueue / プールの
+// ブロック内から呼び出してはならない。
+- (void)inReadDatabaseForOperation:(RCDatabaseOperation)operation block:(void (^)(FMDatabase *db))block {
+    FMDatabasePool *pool = self.readConnectionPool;
+    if (pool == nil) {
+        [self inDatabaseForOperation:operation block:block];
+        return;
+    }
+
+    uint64_t enqueued = RCQueryMetricsNowNanoseconds();
+    [pool inDatabase:^(FMDatabase * _Nonnull db) {
+        uint64_t started = RCQueryMetricsNowNanoseconds();
+        block(db);
+        RCQueryMetricsRecordOperation(self.queryMetrics, operation,
+                                      started - enqueued, RCQueryMetricsNowNanoseconds() - started);
+    }];
+}
+
+// databaseQueue 経由の操作。キュー待ち（先行する書き込みやメンテナンスを待った時間）と
+// ブロックの実行時間を分けて記録する。
+- (void)inDatabaseForOperation:(RCDatabaseOperation)operation block:(void (^)(FMDatabase *db))block {
+    uint64_t enqueued = RCQueryMetricsNowNanoseconds();
+    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
+        uint64_t started = RCQueryMetricsNowNanoseconds();
+        block(db);
+        RCQueryMetricsRecordOperation(self.queryMetrics, operation,
+                                      started - enqueued, RCQueryMetricsNowNanoseconds() - started);
+    }];
+}
+
+// 実行時間には COMMIT（WAL への書き出しと fsync）も含める。
+- (BOOL)inTransactionForOperation:(RCDatabaseOperation)operation
+                            block:(void (^)(FMDatabase *db, BOOL *rollback))block {
+    return [self inTransactionForOperation:operation block:block afterCommit:nil];
+}
+
+// FMDatabaseQueue の inTransaction: は COMMIT の失敗（SQLITE_BUSY・ディスクフル）を捨てるため、
+// BEGIN / COMMIT を自前で発行し、コミットできたときだけ YES を返す。
+// afterCommit はコミット成功後、キューを離れる前に同じコネクションで呼ぶ。
+- (BOOL)inTransactionForOperation:(RCDatabaseOperation)operation
+                            block:(void (^)(FMDatabase *db, BOOL *rollback))block
+                      afterCommit:(nullable void (^)(FMDatabase *db))afterCommit {
+    uint64_t enqueued = RCQueryMetricsNowNanoseconds();
+    __block uint64_t started = 0;
+    __block BOOL committed = NO;
+    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
+        started = RCQueryMetricsNowNanoseconds();
+        if (![db beginTransaction]) {
+            [self logDatabaseError:db context:@"Failed to begin transaction"];
+            return;
+        }
+        BOOL rollback = NO;
+        block(db, &rollback);
+        if (rollback) {
+            [db rollback];
+            return;
+        }
+        committed = [db commit];
+        if (!committed) {
+            [self logDatabaseError:db context:@"Failed to commit transaction"];
+            [db rollback];
+            return;
+        }
+        if (afterCommit != nil) {
+            afterCommit(db);
+        }
+    }];
+    if (started != 0) {
+        RCQueryMetricsRecordOperation(self.queryMetrics, operation,
+                                      started - enqueued, RCQueryMetricsNowNanoseconds() - started);
+    }
+    return committed;
+}
+
+- (void)registerQueryMetricsStatements {
+    for (int operation = 0; operation < RCDatabaseOperationCount; operation++) {
+        RCQueryMetricsRegisterOperation(self.queryMetrics, kRCDatabaseOperationNames[operation]);
+    }
+
+    // ステートメントは SQL 文字列の完全一致で振り分ける。未登録の SQL（スキーマ操作や
+    // スニペットの単発クエリ）は "other" に集計される。
+    NSDictionary<NSString *, NSString *> *statements = @{
+        @"insertClipItem": kRCInsertClipItemSQL,
+        @"updateClipItemUpdateTime": kRCUpdateClipItemUpdateTimeSQL,
+        @"selectRecentClipItems": kRCSelectRecentClipItemsSQL,
+        @"selectClipItemsPage": kRCSelectClipItemsPageSQL,
+        @"selectClipItemByDataHash": kRCSelectClipItemByDataHashSQL,
+        @"deleteClipItemByDataHash": kRCDeleteClipItemByDataHashSQL,
+        @"deleteExpiredClipItemByDataHash": kRCDeleteExpiredClipItemByDataHashSQL,
+        @"deleteClipItemsOlderThan": kRCDeleteClipItemsOlderThanSQL,
+        @"selectClipItemsOlderThan": kRCSelectClipItemsOlderThanSQL,
+        @"evictClipItems": kRCEvictClipItemsSQL,
+        @"expireClipItems": kRCExpireClipItemsSQL,
+        @"insertClipSearchText": kRCInsertClipSearchTextSQL,
+        @"backfillClipSearchText": kRCBackfillClipSearchTextSQL,
+        @"selectClipItemsMissingSearchText": kRCSelectClipItemsMissingSearchTextSQL,
+        @"searchClipItems": kRCSearchClipItemsSQL,
+        @"searchSnippets": kRCSearchSnippetsSQL,
+        @"selectClipStats": kRCSelectClipStatsSQL,
+        @"selectClipStatsTotalCount": kRCSelectClipStatsTotalCountSQL,
+        @"selectClipItemDataHashes": kRCSelectClipItemDataHashesSQL,
+        @"countClipItemsForDataSizeBackfill": kRCCountClipItemsForDataSizeBackfillSQL,
+        @"selectClipItemsForDataSizeBackfill": kRCSelectClipItemsForDataSizeBackfillSQL,
+        @"updateClipItemDataSize": kRCUpdateClipItemDataSizeSQL,
+        @"countClipItemsForFingerprintV2": kRCCountClipItemsForFingerprintV2SQL,
+        @"selectClipItemsForFingerprintV2": kRCSelectClipItemsForFingerprintV2SQL,
+        @"updateClipItemFingerprint": kRCUpdateClipItemFingerprintSQL,
+        @"retireLegacyFingerprints": kRCRetireLegacyFingerprintsSQL,
+        @"scheduleOnlineMigration": kRCScheduleOnlineMigrationSQL,
+        @"selectPendingOnlineMigrations": kRCSelectPendingOnlineMigrationsSQL,
+        @"selectOnlineMigration": kRCSelectOnlineMigrationSQL,
+        @"updateOnlineMigrationCheckpoint": kRCUpdateOnlineMigrationCheckpointSQL,
+        @"insertClipBlob": kRCInsertClipBlobSQL,
+        @"insertClipBlobRef": kRCInsertClipBlobRefSQL,
+        @"deleteClipItemByID": kRCDeleteClipItemByIDSQL,
+        @"selectReleasedBlobDigests": kRCSelectReleasedBlobDigestsSQL,
+        @"selectClipBlobReferenced": kRCSelectClipBlobReferencedSQL,
+        @"deleteReleasedBlobDigest": kRCDeleteReleasedBlobDigestSQL,
+        @"selectSnippetFolders": kRCSelectSnippetFoldersSQL,
+        @"selectSnippetsForFolder": kRCSelectSnippetsForFolderSQL,
+    };
+    NSArray<NSString *> *names = [statements.allKeys sortedArrayUsingSelector:@selector(compare:)];
+    for (NSString *name in names) {
+        if (RCQueryMetricsRegisterStatement(self.queryMetrics, name.UTF8String, statements[name].UTF8String) < 0) {
+            os_log_error(RCDatabaseManagerLog(), "Query metrics statement table is full (%{public}@)", name);
+        }
+    }
+}
+
+- (void)databasePool:(FMDatabasePool *)pool didAddDatabase:(FMDatabase *)database {
+    (void)pool;
+    database.shouldCacheStatements = YES;
+    database.maxBusyRetryTimeInterval = kRCReadConnectionBusyTimeout;
+    RCQueryMetricsAttachConnection(self.queryMetrics, (sqlite3 *)database.sqliteHandle);
+}
+
 - (BOOL)configureIncrementalAutoVacuumForNewDatabase:(FMDatabase *)db {
     BOOL configured = [db executeStatements:@"PRAGMA auto_vacuum = INCREMENTAL"];
     if (!configured) {
@@ -1104,16 +2330,22 @@ static os_log_t RCDatabaseManagerLog(void) {
     return value;
 }
 
-- (void)migrateAutoVacuumToIncrementalIfNeeded {
+// auto_vacuum は VACUUM でしか切り替わらないため、旧形式の DB では DB 全体を書き直す。
+// ライターを占有するので起動後に実行し、progress の取り消しで中断できるようにする。
+- (BOOL)migrateAutoVacuumToIncrementalWithProgress:(nullable NSProgress *)progress {
     NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
     if ([defaults boolForKey:kRCAutoVacuumMigrationCompletedKey]) {
-        return;
+        return YES;
+    }
+    if (progress.isCancelled) {
+        return NO;
     }
 
+    progress.totalUnitCount = 1;
     __block BOOL shouldMarkCompleted = NO;
     __block BOOL didFailMigration = NO;
 
-    [self.databaseQueue inDatabase:^(FMDatabase * _Nonnull db) {
+    [self inDatabaseForOperation:RCDatabaseOperationMaintenance block:^(FMDatabase * _Nonnull db) {
         NSInteger autoVacuumMode = [self integerValueForPragma:@"auto_vacuum"
                                                     inDatabase:db
                                                   defaultValue:-1];
@@ -1130,7 +2362,12 @@ static os_log_t RCDatabaseManagerLog(void) {
                 return;
             }
 
+            sqlite3 *handle = (sqlite3 *)db.sqliteHandle;
+            if (progress != nil) {
+                sqlite3_progress_handler(handle, 10000, RCDatabaseMaintenanceProgressHandler, (__bridge void *)progress);
+            }
             BOOL vacuumed = [db executeStatements:@"VACUUM"];
+            sqlite3_progress_handler(handle, 0, NULL, NULL);
             if (!vacuumed) {
                 didFailMigration = YES;
                 [self logDatabaseError:db context:@"Failed to run VACUUM for auto_vacuum migration"];
@@ -1143,54 +2380,229 @@ static os_log_t RCDatabaseManagerLog(void) {
 
     if (shouldMarkCompleted) {
         [defaults setBool:YES forKey:kRCAutoVacuumMigrationCompletedKey];
+        progress.completedUnitCount = progress.totalUnitCount;
     } else if (didFailMigration) {
         os_log_error(RCDatabaseManagerLog(),
                      "auto_vacuum migration failed; continuing without migration completion flag");
     }
+    return shouldMarkCompleted;
 }
 
-- (void)applyDatabaseFilePermissionsIfNeeded {
-    NSFileManager *fileManager = [NSFileManager defaultManager];
-    NSString *databaseBasePath = self.databasePath ?: @"";
-    if (databaseBasePath.length == 0) {
-        return;
-    }
+// 登録順に実行する。新しい移行は末尾に追加し、対応する migrateIfNeeded の
+// ステップで scheduleOnlineMigrationNamed:inDatabase: を呼んで予約する。
+- (NSArray<RCOnlineMigration *> *)registeredOnlineMigrations {
+    __weak typeof(self) weakSelf = self;
+
+    // v4 より前の履歴の data_size を .rcclip のファイルサイズで埋める。
+    RCOnlineMigration *dataSizeMigration = [[RCOnlineMigration alloc] initWithName:kRCClipItemsDataSizeMigrationName
+                                                                         selectSQL:kRCSelectClipItemsForDataSizeBackfillSQL
+                                                                         updateSQL:kRCUpdateClipItemDataSizeSQL];
+    dataSizeMigration.countSQL = kRCCountClipItemsForDataSizeBackfillSQL;
+    dataSizeMigration.transform = ^NSArray * _Nullable (NSArray *row) {
+        NSString *storedPath = [row[1] isKindOfClass:[NSString class]] ? row[1] : @"";
+        long long dataSize = [weakSelf fileSizeAtClipPath:[weakSelf resolvedPathForStoredClipPath:storedPath]];
+        return dataSize > 0 ? @[@(dataSize), row[0]] : nil;
+    };
 
-    NSArray<NSString *> *suffixes = @[@"", @"-journal", @"-wal", @"-shm"];
-    for (NSString *suffix in suffixes) {
-        NSString *path = [databaseBasePath stringByAppendingString:suffix];
-        BOOL isDirectory = NO;
-        if (![fileManager fileExistsAtPath:path isDirectory:&isDirectory] || isDirectory) {
-            continue;
+    // v7 より前の行の data_hash を、すべての表現を含む v2 のフィンガープリントに書き直す。
+    // 移行中は重複判定を v1 でも引く。読めない .rcclip の行と、v2 のハッシュが既存の行と
+    // 衝突した行（UPDATE OR IGNORE）は終了時に v1 の対象から外す（didFinish）。
+    RCOnlineMigration *fingerprintMigration = [[RCOnlineMigration alloc] initWithName:kRCClipItemsFingerprintV2MigrationName
+                                                                            selectSQL:kRCSelectClipItemsForFingerprintV2SQL
+                                                                            updateSQL:kRCUpdateClipItemFingerprintSQL];
+    fingerprintMigration.countSQL = kRCCountClipItemsForFingerprintV2SQL;
+    fingerprintMigration.batchSize = kRCFingerprintMigrationBatchSize;
+    fingerprintMigration.batchInterval = kRCFingerprintMigrationBatchInterval;
+    fingerprintMigration.transform = ^NSArray * _Nullable (NSArray *row) {
+        NSString *storedPath = [row[1] isKindOfClass:[NSString class]] ? row[1] : @"";
+        @autoreleasepool {
+            RCClipData *clipData = [RCClipData clipDataFromPath:[weakSelf resolvedPathForStoredClipPath:storedPath]];
+            NSData *digest = clipData != nil ? [weakSelf digestDataForDataHash:[clipData dataHash]] : nil;
+            return digest != nil ? @[digest, row[0]] : nil;
         }
+    };
+    // 書き直したハッシュは同じトランザクションでフィルタに入れる。v1 のハッシュは
+    // 偽陽性として残るだけなので外さない（次回の再構築で消える）。
+    fingerprintMigration.didUpdateRow = ^(NSArray *arguments) {
+        [weakSelf addDigestToFilter:arguments[0]];
+    };
+    fingerprintMigration.didFinish = ^{
+        [weakSelf retireLegacyFingerprintRows];
+        weakSelf.legacyFingerprintsPending = NO;
+    };
 
-        NSError *permissionError = nil;
-        BOOL applied = [fileManager setAttributes:@{ NSFilePosixPermissions: kRCDatabaseFilePermissions }
-                                     ofItemAtPath:path
-                                            error:&permissionError];
-        if (!applied && permissionError != nil) {
-            os_log_error(RCDatabaseManagerLog(),
-                         "Failed to apply database file permissions for %{private}@ (%{private}@)",
-                         path, permissionError.localizedDescription);
-        }
-    }
+    return @[dataSizeMigration, fingerprintMigration];
 }
 
-- (void)logDatabaseError:(FMDatabase *)db context:(NSString *)context {
-    os_log_error(RCDatabaseManagerLog(),
-                 "%{public}@ (code=%d, message=%{private}@)",
-                 context, db.lastErrorCode, db.lastErrorMessage);
+- (nullable NSSet<NSString *> *)pendingOnlineMigrationNames {
+    __block NSMutableSet<NSString *> *names = nil;
+    [self inReadDatabaseForOperation:RCDatabaseOperationMaintenance block:^(FMDatabase * _Nonnull db) {
+        FMResultSet *resultSet = [db executeQuery:kRCSelectPendingOnlineMigrationsSQL];
+        if (!resultSet) {
+            [self logDatabaseError:db context:@"Failed to read online_migrations"];
+            return;
+        }
+        names = [NSMutableSet set];
+        while ([resultSet next]) {
+            NSString *name = [resultSet stringForColumnIndex:0];
+            if (name.length > 0) {
+                [names addObject:name];
+            }
+        }
+        [resultSet close];
+    }];
+    return names;
 }
 
-- (NSString *)storagePathForClipPath:(NSString *)path {
-    NSString *standardizedPath = [self standardizedPath:path];
-    if (standardizedPath.length == 0) {
-        return @"";
+// チェックポイントの次の行から batchSize 行ずつ進める。読み出しと transform は
+// ライターの外で行い、書き込みとチェックポイントの更新だけを 1 トランザクションに
+// まとめるので、チャンクの合間にキャプチャの書き込みがコミットできる。
+- (BOOL)runOnlineMigration:(RCOnlineMigration *)migration progress:(nullable NSProgress *)progress {
+    __block BOOL scheduled = NO;
+    __block BOOL completed = NO;
+    __block long long checkpoint = 0;
+    __block long remaining = 0;
+    [self inReadDatabaseForOperation:RCDatabaseOperationMaintenance block:^(FMDatabase * _Nonnull db) {
+        FMResultSet *resultSet = [db executeQuery:kRCSelectOnlineMigrationSQL, migration.name];
+        if ([resultSet next]) {
+            scheduled = YES;
+            checkpoint = [resultSet longLongIntForColumnIndex:0];
+            completed = [resultSet boolForColumnIndex:1];
+        }
+        [resultSet close];
+        if (scheduled && !completed && migration.countSQL != nil) {
+            remaining = [db longForQuery:migration.countSQL, @(checkpoint)];
+        }
+    }];
+    progress.totalUnitCount = MAX(remaining, 1);
+    if (!scheduled || completed) {
+        progress.completedUnitCount = progress.totalUnitCount;
+        return YES;
     }
 
-    NSString *clipDirectoryPath = [self standardizedPath:[RCUtilities clipDataDirectoryPath]];
-    if (clipDirectoryPath.length == 0) {
-        return @"";
+    NSInteger batchSize = MAX(migration.batchSize, 1);
+    BOOL finished = NO;
+    while (!finished) {
+        if (progress.isCancelled || [RCPanicEraseService shared].isPanicInProgress) {
+            return NO;
+        }
+
+        NSMutableArray<NSArray *> *rows = [NSMutableArray arrayWithCapacity:(NSUInteger)batchSize];
+        __block BOOL selected = YES;
+        [self inReadDatabaseForOperation:RCDatabaseOperationMaintenance block:^(FMDatabase * _Nonnull db) {
+            FMResultSet *resultSet = [db executeQuery:migration.selectSQL
+                                 withArgumentsInArray:@[@(checkpoint), @(batchSize)]];
+            if (!resultSet) {
+                [self logDatabaseError:db context:[NSString stringWithFormat:@"Failed to select rows for online migration %@", migration.name]];
+                selected = NO;
+                return;
+            }
+            int columnCount = [resultSet columnCount];
+            while ([resultSet next]) {
+                NSMutableArray *row = [NSMutableArray arrayWithCapacity:(NSUInteger)columnCount];
+                for (int column = 0; column < columnCount; column++) {
+                    [row addObject:[resultSet objectForColumnIndex:column] ?: [NSNull null]];
+                }
+                [rows addObject:row];
+            }
+            [resultSet close];
+        }];
+        if (!selected) {
+            return NO;
+        }
+
+        NSMutableArray<NSArray *> *updates = [NSMutableArray arrayWithCapacity:rows.count];
+        for (NSArray *row in rows) {
+            NSArray *arguments = migration.transform != nil ? migration.transform(row) : row;
+            if (arguments != nil) {
+                [updates addObject:arguments];
+            }
+        }
+        // 最後のチャンクでは completed も同じトランザクションで立てる。
+        // 以降に追加される行は新しい形式で書かれるので、取りこぼしにはならない。
+        finished = (NSInteger)rows.count < batchSize;
+        long long nextCheckpoint = rows.count > 0 ? [rows.lastObject[0] longLongValue] : checkpoint;
+
+        __block BOOL applied = YES;
+        BOOL committed = [self inTransactionForOperation:RCDatabaseOperationMaintenance block:^(FMDatabase * _Nonnull db, BOOL * _Nonnull rollback) {
+            for (NSArray *arguments in updates) {
+                if (![db executeUpdate:migration.updateSQL withArgumentsInArray:arguments]) {
+                    [self logDatabaseError:db context:[NSString stringWithFormat:@"Failed to apply online migration %@", migration.name]];
+                    applied = NO;
+                    *rollback = YES;
+                    return;
+                }
+                if (migration.didUpdateRow != nil && db.changes > 0) {
+                    migration.didUpdateRow(arguments);
+                }
+            }
+            if (![db executeUpdate:kRCUpdateOnlineMigrationCheckpointSQL,
+                  @(nextCheckpoint), @(rows.count), @(finished), migration.name]) {
+                [self logDatabaseError:db context:[NSString stringWithFormat:@"Failed to advance checkpoint of online migration %@", migration.name]];
+                applied = NO;
+                *rollback = YES;
+            }
+        }];
+        if (!applied || !committed) {
+            return NO;
+        }
+        checkpoint = nextCheckpoint;
+        progress.completedUnitCount = MIN(progress.completedUnitCount + (int64_t)rows.count, progress.totalUnitCount);
+        if (!finished && migration.batchInterval > 0) {
+            [NSThread sleepForTimeInterval:migration.batchInterval];
+        }
+    }
+
+    os_log_info(RCDatabaseManagerLog(), "Online migration %{public}@ finished", migration.name);
+    if (migration.didFinish != nil) {
+        migration.didFinish();
+    }
+    progress.completedUnitCount = progress.totalUnitCount;
+    return YES;
+}
+
+- (void)applyDatabaseFilePermissionsIfNeeded {
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSString *databaseBasePath = self.databasePath ?: @"";
+    if (databaseBasePath.length == 0) {
+        return;
+    }
+
+    NSArray<NSString *> *suffixes = @[@"", @"-journal", @"-wal", @"-shm"];
+    for (NSString *suffix in suffixes) {
+        NSString *path = [databaseBasePath stringByAppendingString:suffix];
+        BOOL isDirectory = NO;
+        if (![fileManager fileExistsAtPath:path isDirectory:&isDirectory] || isDirectory) {
+            continue;
+        }
+
+        NSError *permissionError = nil;
+        BOOL applied = [fileManager setAttributes:@{ NSFilePosixPermissions: kRCDatabaseFilePermissions }
+                                     ofItemAtPath:path
+                                            error:&permissionError];
+        if (!applied && permissionError != nil) {
+            os_log_error(RCDatabaseManagerLog(),
+                         "Failed to apply database file permissions for %{private}@ (%{private}@)",
+                         path, permissionError.localizedDescription);
+        }
+    }
+}
+
+- (void)logDatabaseError:(FMDatabase *)db context:(NSString *)context {
+    os_log_error(RCDatabaseManagerLog(),
+                 "%{public}@ (code=%d, message=%{private}@)",
+                 context, db.lastErrorCode, db.lastErrorMessage);
+}
+
+- (NSString *)storagePathForClipPath:(NSString *)path {
+    NSString *standardizedPath = [self standardizedPath:path];
+    if (standardizedPath.length == 0) {
+        return @"";
+    }
+
+    NSString *clipDirectoryPath = [self standardizedPath:[RCUtilities clipDataDirectoryPath]];
+    if (clipDirectoryPath.length == 0) {
+        return @"";
     }
 
     NSString *canonicalPath = [self canonicalPath:standardizedPath];
@@ -1203,12 +2615,22 @@ static os_log_t RCDatabaseManagerLog(void) {
 }
 
 - (NSString *)resolvedPathForStoredClipPath:(NSString *)storedPath {
+    NSString *clipDirectoryPath = [self standardizedPath:[RCUtilities clipDataDirectoryPath]];
+    return [self resolvedPathForStoredClipPath:storedPath
+                             clipDirectoryPath:clipDirectoryPath
+                    canonicalClipDirectoryPath:[self canonicalPath:clipDirectoryPath]];
+}
+
+// 一覧取得ではクリップディレクトリの正規化を 1 回だけ行い、行ごとには
+// 格納パス自身の解決のみを行う。
+- (NSString *)resolvedPathForStoredClipPath:(NSString *)storedPath
+                          clipDirectoryPath:(NSString *)clipDirectoryPath
+                 canonicalClipDirectoryPath:(NSString *)canonicalClipDirectoryPath {
     NSString *standardizedPath = [self standardizedPath:storedPath];
     if (standardizedPath.length == 0) {
         return @"";
     }
 
-    NSString *clipDirectoryPath = [self standardizedPath:[RCUtilities clipDataDirectoryPath]];
     if (clipDirectoryPath.length == 0) {
         return @"";
     }
@@ -1219,7 +2641,6 @@ static os_log_t RCDatabaseManagerLog(void) {
     }
 
     NSString *canonicalPath = [self canonicalPath:resolvedPath];
-    NSString *canonicalClipDirectoryPath = [self canonicalPath:clipDirectoryPath];
     if ([self isPath:canonicalPath withinDirectory:canonicalClipDirectoryPath]) {
         return resolvedPath;
     }
@@ -1309,43 +2730,684 @@ static os_log_t RCDatabaseManagerLog(void) {
     return defaultValue;
 }
 
-#pragma mark - Private: ResultSet mapping
+#pragma mark - Private: clip_items rows
 
-- (NSDictionary *)clipItemDictionaryFromResultSet:(FMResultSet *)resultSet {
-    NSString *storedDataPath = [resultSet stringForColumn:@"data_path"] ?: @"";
-    NSString *storedThumbnailPath = [resultSet stringForColumn:@"thumbnail_path"] ?: @"";
+- (BOOL)insertClipItemRow:(RCClipItem *)clipItem inDatabase:(FMDatabase *)db {
+    NSData *digest = [self digestDataForDataHash:clipItem.dataHash];
+    if (digest == nil) {
+        return NO;
+    }
 
-    return @{
-        @"id": @([resultSet longLongIntForColumn:@"id"]),
-        @"data_path": [self resolvedPathForStoredClipPath:storedDataPath],
-        @"title": [resultSet stringForColumn:@"title"] ?: @"",
-        @"data_hash": [resultSet stringForColumn:@"data_hash"] ?: @"",
-        @"primary_type": [resultSet stringForColumn:@"primary_type"] ?: @"",
-        @"update_time": @([resultSet longLongIntForColumn:@"update_time"]),
-        @"thumbnail_path": [self resolvedPathForStoredClipPath:storedThumbnailPath],
-        @"is_color_code": @([resultSet intForColumn:@"is_color_code"]),
-    };
+    NSArray *arguments = @[
+        [self storagePathForClipPath:clipItem.dataPath],
+        clipItem.title ?: @"",
+        digest,
+        clipItem.primaryType ?: @"",
+        @(clipItem.updateTime),
+        [self storagePathForClipPath:clipItem.thumbnailPath],
+        @(clipItem.isColorCode),
+        @([self fileSizeAtClipPath:clipItem.dataPath]),
+    ];
+
+    BOOL inserted = [db executeUpdate:kRCInsertClipItemSQL withArgumentsInArray:arguments];
+    if (!inserted) {
+        int errorCode = db.lastErrorCode;
+        int extendedErrorCode = db.lastExtendedErrorCode;
+        if (errorCode == SQLITE_CONSTRAINT && extendedErrorCode == SQLITE_CONSTRAINT_UNIQUE) {
+            NSLog(@"[RCDatabaseManager] insertClipItem: duplicate data_hash detected (code=%d, extended=%d)",
+                  errorCode,
+                  extendedErrorCode);
+        } else if (errorCode == SQLITE_CONSTRAINT) {
+            os_log_with_type(RCDatabaseManagerLog(), OS_LOG_TYPE_DEBUG,
+                             "insertClipItem constraint violation (code=%d, extended=%d, message=%{private}@)",
+                             errorCode, extendedErrorCode, db.lastErrorMessage);
+        } else {
+            [self logDatabaseError:db context:@"Failed to insert clip_items row"];
+        }
+        return NO;
+    }
+    sqlite_int64 clipID = db.lastInsertRowId;
+
+    // 参照を登録できないとブロブが解放対象になり得るため、行ごと取り消す。
+    if (![self insertBlobReferencesForClipItem:clipItem clipID:clipID inDatabase:db]) {
+        if (![db executeUpdate:kRCDeleteClipItemByIDSQL withArgumentsInArray:@[@(clipID)]]) {
+            [self logDatabaseError:db context:@"Failed to remove clip_items row without blob references"];
+        }
+        return NO;
+    }
+
+    // 本文の無いクリップ（画像等）も空行を入れ、バックフィル対象から外す。
+    if (![db executeUpdate:kRCInsertClipSearchTextSQL
+      withArgumentsInArray:@[@(clipID), clipItem.searchText ?: @""]]) {
+        [self logDatabaseError:db context:@"Failed to index clip_items row for search"];
+    }
+    [self addDigestToFilter:digest];
+    return YES;
+}
+
+- (BOOL)insertBlobReferencesForClipItem:(RCClipItem *)clipItem clipID:(sqlite_int64)clipID inDatabase:(FMDatabase *)db {
+    RCClipBlobStore *blobStore = [RCClipBlobStore shared];
+    for (NSString *blobDigest in clipItem.blobDigests) {
+        NSData *digest = [self digestDataForDataHash:blobDigest];
+        if (digest == nil) {
+            os_log_error(RCDatabaseManagerLog(), "Malformed blob digest on clip item");
+            return NO;
+        }
+
+        NSNumber *size = @([self fileSizeAtClipPath:[blobStore pathForDigest:blobDigest]]);
+        if (![db executeUpdate:kRCInsertClipBlobSQL withArgumentsInArray:@[digest, size]]
+            || ![db executeUpdate:kRCInsertClipBlobRefSQL withArgumentsInArray:@[@(clipID), digest]]) {
+            [self logDatabaseError:db context:@"Failed to register clip blob reference"];
+            return NO;
+        }
+    }
+    return YES;
+}
+
+- (nullable NSData *)digestDataForDataHash:(NSString *)dataHash {
+    if (dataHash.length != kRCDataDigestLength * 2) {
+        return nil;
+    }
+    return [RCUtilities dataFromHexString:dataHash];
+}
+
+// v1 → v2: data_hash を 64 文字の hex TEXT から 32 バイトの BLOB に移す。
+// SQLite は列型を変更できないため、新テーブルへ行をコピーして差し替える。
+// migrateIfNeeded のトランザクション内で呼ばれる。
+- (BOOL)migrateClipItemsToBinaryDigestInDatabase:(FMDatabase *)db {
+    NSString *createStatement = [@"CREATE TABLE clip_items_v2 " stringByAppendingString:kRCClipItemsTableDefinitionSQL];
+    if (![db executeUpdate:@"DROP TABLE IF EXISTS clip_items_v2"] || ![db executeUpdate:createStatement]) {
+        [self logDatabaseError:db context:@"Failed to create clip_items_v2 table"];
+        return NO;
+    }
+
+    FMResultSet *resultSet = [db executeQuery:@"SELECT id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code FROM clip_items"];
+    if (!resultSet) {
+        [self logDatabaseError:db context:@"Failed to read clip_items rows for v2 migration"];
+        return NO;
+    }
+
+    NSUInteger skippedRows = 0;
+    while ([resultSet next]) {
+        @autoreleasepool {
+            NSData *digest = [self digestDataForDataHash:[resultSet stringForColumnIndex:RCClipItemColumnDataHash]];
+            if (digest == nil) {
+                skippedRows++;
+                continue;
+            }
+
+            NSArray *arguments = @[
+                [resultSet objectForColumnIndex:RCClipItemColumnID],
+                [resultSet objectForColumnIndex:RCClipItemColumnDataPath],
+                [resultSet objectForColumnIndex:RCClipItemColumnTitle],
+                digest,
+                [resultSet objectForColumnIndex:RCClipItemColumnPrimaryType],
+                [resultSet objectForColumnIndex:RCClipItemColumnUpdateTime],
+                [resultSet objectForColumnIndex:RCClipItemColumnThumbnailPath],
+                [resultSet objectForColumnIndex:RCClipItemColumnIsColorCode],
+            ];
+            if (![db executeUpdate:@"INSERT INTO clip_items_v2 (id, data_path, title, data_hash, primary_type, update_time, thumbnail_path, is_color_code) VALUES (?, ?, ?, ?, ?, ?, ?, ?)"
+              withArgumentsInArray:arguments]) {
+                [self logDatabaseError:db context:@"Failed to copy clip_items row during v2 migration"];
+                [resultSet close];
+                return NO;
+            }
+        }
+    }
+    [resultSet close];
+
+    NSArray<NSString *> *swapStatements = @[
+        @"DROP TABLE clip_items",
+        @"ALTER TABLE clip_items_v2 RENAME TO clip_items",
+        @"CREATE INDEX IF NOT EXISTS idx_clip_update_time ON clip_items(update_time DESC)",
+    ];
+    for (NSString *statement in swapStatements) {
+        if (![db executeUpdate:statement]) {
+            [self logDatabaseError:db context:[NSString stringWithFormat:@"Failed to execute v2 migration statement: %@", statement]];
+            return NO;
+        }
+    }
+
+    if (skippedRows > 0) {
+        os_log_error(RCDatabaseManagerLog(),
+                     "Dropped %lu clip_items rows with malformed data_hash during v2 migration",
+                     (unsigned long)skippedRows);
+    }
+    return YES;
+}
+
+// clip_search / snippet_search と同期用トリガー。IF NOT EXISTS なので何度呼んでもよい。
+- (BOOL)createSearchIndexSchemaInDatabase:(FMDatabase *)db {
+    NSArray<NSString *> *statements = @[
+        @"CREATE VIRTUAL TABLE IF NOT EXISTS clip_search USING fts5(body, tokenize = 'unicode61 remove_diacritics 2', prefix = '2 3 4')",
+        @"CREATE VIRTUAL TABLE IF NOT EXISTS snippet_search USING fts5(title, content, tokenize = 'unicode61 remove_diacritics 2', prefix = '2 3 4')",
+        @"CREATE TRIGGER IF NOT EXISTS clip_items_search_delete AFTER DELETE ON clip_items BEGIN DELETE FROM clip_search WHERE rowid = old.id; END",
+        @"CREATE TRIGGER IF NOT EXISTS snippets_search_insert AFTER INSERT ON snippets BEGIN INSERT INTO snippet_search (rowid, title, content) VALUES (new.id, rc_search_text(new.title), rc_search_text(new.content)); END",
+        @"CREATE TRIGGER IF NOT EXISTS snippets_search_update AFTER UPDATE OF title, content ON snippets BEGIN DELETE FROM snippet_search WHERE rowid = old.id; INSERT INTO snippet_search (rowid, title, content) VALUES (new.id, rc_search_text(new.title), rc_search_text(new.content)); END",
+        @"CREATE TRIGGER IF NOT EXISTS snippets_search_delete AFTER DELETE ON snippets BEGIN DELETE FROM snippet_search WHERE rowid = old.id; END",
+    ];
+    for (NSString *statement in statements) {
+        if (![db executeUpdate:statement]) {
+            [self logDatabaseError:db context:[NSString stringWithFormat:@"Failed to execute search schema statement: %@", statement]];
+            return NO;
+        }
+    }
+    return YES;
+}
+
+// v2 → v3: 検索索引を作り、既存スニペットを索引する。既存クリップの本文は
+// .rcclip の読み込みが必要なため、RCDataCleanService がバックグラウンドで少しずつ埋める。
+- (BOOL)migrateToSearchIndexInDatabase:(FMDatabase *)db {
+    if (![self createSearchIndexSchemaInDatabase:db]) {
+        return NO;
+    }
+
+    NSArray<NSString *> *statements = @[
+        @"DELETE FROM snippet_search",
+        @"INSERT INTO snippet_search (rowid, title, content) SELECT id, rc_search_text(title), rc_search_text(content) FROM snippets",
+    ];
+    for (NSString *statement in statements) {
+        if (![db executeUpdate:statement]) {
+            [self logDatabaseError:db context:[NSString stringWithFormat:@"Failed to execute v3 migration statement: %@", statement]];
+            return NO;
+        }
+    }
+    return YES;
+}
+
+- (BOOL)createClipStatsSchemaInDatabase:(FMDatabase *)db {
+    NSArray<NSString *> *statements = @[
+        @"CREATE TABLE IF NOT EXISTS clip_stats (primary_type TEXT PRIMARY KEY NOT NULL, item_count INTEGER NOT NULL DEFAULT 0, total_size INTEGER NOT NULL DEFAULT 0) WITHOUT ROWID",
+        @"CREATE TRIGGER IF NOT EXISTS clip_items_stats_insert AFTER INSERT ON clip_items BEGIN "
+            "INSERT INTO clip_stats (primary_type, item_count, total_size) VALUES (coalesce(new.primary_type, ''), 1, new.data_size) "
+            "ON CONFLICT (primary_type) DO UPDATE SET item_count = item_count + 1, total_size = total_size + excluded.total_size; END",
+        @"CREATE TRIGGER IF NOT EXISTS clip_items_stats_delete AFTER DELETE ON clip_items BEGIN "
+            "UPDATE clip_stats SET item_count = item_count - 1, total_size = total_size - old.data_size WHERE primary_type = coalesce(old.primary_type, ''); "
+            "DELETE FROM clip_stats WHERE primary_type = coalesce(old.primary_type, '') AND item_count <= 0; END",
+        @"CREATE TRIGGER IF NOT EXISTS clip_items_stats_update AFTER UPDATE OF primary_type, data_size ON clip_items BEGIN "
+            "UPDATE clip_stats SET item_count = item_count - 1, total_size = total_size - old.data_size WHERE primary_type = coalesce(old.primary_type, ''); "
+            "DELETE FROM clip_stats WHERE primary_type = coalesce(old.primary_type, '') AND item_count <= 0; "
+            "INSERT INTO clip_stats (primary_type, item_count, total_size) VALUES (coalesce(new.primary_type, ''), 1, new.data_size) "
+            "ON CONFLICT (primary_type) DO UPDATE SET item_count = item_count + 1, total_size = total_size + excluded.total_size; END",
+    ];
+    for (NSString *statement in statements) {
+        if (![db executeUpdate:statement]) {
+            [self logDatabaseError:db context:[NSString stringWithFormat:@"Failed to execute stats schema statement: %@", statement]];
+            return NO;
+        }
+    }
+    return YES;
+}
+
+// v3 → v4: data_size 列を追加し、clip_stats を一度だけ集計する。
+// v1 からの移行では v2 の作り直しで data_size 列が既にある。
+- (BOOL)migrateToClipStatsInDatabase:(FMDatabase *)db {
+    if (![db columnExists:@"data_size" inTableWithName:@"clip_items"]
+        && ![db executeUpdate:@"ALTER TABLE clip_items ADD COLUMN data_size INTEGER NOT NULL DEFAULT 0"]) {
+        [self logDatabaseError:db context:@"Failed to add clip_items.data_size"];
+        return NO;
+    }
+
+    // 既存行の data_size は 0 のまま集計し、ファイルサイズは起動後に
+    // オンライン移行が埋める（clip_stats は更新トリガーが追従する）。
+    if (![self createClipStatsSchemaInDatabase:db]
+        || ![self scheduleOnlineMigrationNamed:kRCClipItemsDataSizeMigrationName inDatabase:db]) {
+        return NO;
+    }
+    NSArray<NSString *> *statements = @[
+        @"DELETE FROM clip_stats",
+        @"INSERT INTO clip_stats (primary_type, item_count, total_size) SELECT coalesce(primary_type, ''), COUNT(*), SUM(data_size) FROM clip_items GROUP BY 1",
+    ];
+    for (NSString *statement in statements) {
+        if (![db executeUpdate:statement]) {
+            [self logDatabaseError:db context:[NSString stringWithFormat:@"Failed to execute v4 migration statement: %@", statement]];
+            return NO;
+        }
+    }
+    return YES;
+}
+
+// ブロブ表と参照数トリガー。clip_items の行削除で参照が外れ、最後の参照が外れた
+// ダイジェストは clip_blob_garbage に移る。再び参照されたらそこから外す。
+- (BOOL)createClipBlobSchemaInDatabase:(FMDatabase *)db {
+    NSArray<NSString *> *statements = @[
+        @"CREATE TABLE IF NOT EXISTS clip_blobs (digest BLOB PRIMARY KEY NOT NULL CHECK (length(digest) = 32), size INTEGER NOT NULL DEFAULT 0, ref_count INTEGER NOT NULL DEFAULT 0) WITHOUT ROWID",
+        @"CREATE TABLE IF NOT EXISTS clip_blob_refs (clip_id INTEGER NOT NULL, digest BLOB NOT NULL, PRIMARY KEY (clip_id, digest)) WITHOUT ROWID",
+        @"CREATE TABLE IF NOT EXISTS clip_blob_garbage (digest BLOB PRIMARY KEY NOT NULL) WITHOUT ROWID",
+        @"CREATE TRIGGER IF NOT EXISTS clip_items_blob_refs_delete AFTER DELETE ON clip_items BEGIN "
+            "DELETE FROM clip_blob_refs WHERE clip_id = old.id; END",
+        @"CREATE TRIGGER IF NOT EXISTS clip_blob_refs_insert AFTER INSERT ON clip_blob_refs BEGIN "
+            "UPDATE clip_blobs SET ref_count = ref_count + 1 WHERE digest = new.digest; "
+            "DELETE FROM clip_blob_garbage WHERE digest = new.digest; END",
+        @"CREATE TRIGGER IF NOT EXISTS clip_blob_refs_delete AFTER DELETE ON clip_blob_refs BEGIN "
+            "UPDATE clip_blobs SET ref_count = ref_count - 1 WHERE digest = old.digest; "
+            "INSERT OR IGNORE INTO clip_blob_garbage (digest) SELECT digest FROM clip_blobs WHERE digest = old.digest AND ref_count <= 0; "
+            "DELETE FROM clip_blobs WHERE digest = old.digest AND ref_count <= 0; END",
+    ];
+    for (NSString *statement in statements) {
+        if (![db executeUpdate:statement]) {
+            [self logDatabaseError:db context:[NSString stringWithFormat:@"Failed to execute blob schema statement: %@", statement]];
+            return NO;
+        }
+    }
+    return YES;
+}
+
+// v4 → v5: ブロブ表を作るだけ。既存の .rcclip は表現をインラインで持つのでそのまま読める。
+- (BOOL)migrateToClipBlobsInDatabase:(FMDatabase *)db {
+    return [self createClipBlobSchemaInDatabase:db];
+}
+
+- (BOOL)createOnlineMigrationSchemaInDatabase:(FMDatabase *)db {
+    if (![db executeUpdate:kRCOnlineMigrationsTableSQL]) {
+        [self logDatabaseError:db context:@"Failed to create online_migrations"];
+        return NO;
+    }
+    return YES;
+}
+
+// v6 より前の移行ステップからも呼ばれるため、表はここでも作る。
+- (BOOL)scheduleOnlineMigrationNamed:(NSString *)name inDatabase:(FMDatabase *)db {
+    if (![self createOnlineMigrationSchemaInDatabase:db]) {
+        return NO;
+    }
+    if (![db executeUpdate:kRCScheduleOnlineMigrationSQL, name]) {
+        [self logDatabaseError:db context:[NSString stringWithFormat:@"Failed to schedule online migration %@", name]];
+        return NO;
+    }
+    return YES;
+}
+
+// 移行を最後まで進めても v1 のまま残った行を fingerprint_version = 0 にする。衝突した行の内容は
+// v2 の別の行で見つかり、読めない行は再キャプチャで新しい行になるので、v1 の重複判定
+// （新しいキャプチャごとの 2 回目の SHA-256）を続ける理由が無い。失敗しても次の起動では
+// 移行済みとして v1 を引かないので、結果は同じ。
+- (void)retireLegacyFingerprintRows {
+    [self inDatabaseForOperation:RCDatabaseOperationMaintenance block:^(FMDatabase * _Nonnull db) {
+        if (![db executeUpdate:kRCRetireLegacyFingerprintsSQL]) {
+            [self logDatabaseError:db context:@"Failed to retire v1 fingerprints"];
+            return;
+        }
+        if (db.changes > 0) {
+            os_log_info(RCDatabaseManagerLog(), "Retired %d clip_items rows left on the v1 fingerprint", db.changes);
+        }
+    }];
+}
+
+// v6 → v7: fingerprint_version 列を追加する。既存の行は v1 のまま読めるようにし、
+// v2 への再計算は起動後にオンライン移行（clip_items.fingerprint_v2）で進める。
+- (BOOL)migrateToFingerprintV2InDatabase:(FMDatabase *)db {
+    if (![db columnExists:@"fingerprint_version" inTableWithName:@"clip_items"]
+        && ![db executeUpdate:@"ALTER TABLE clip_items ADD COLUMN fingerprint_version INTEGER NOT NULL DEFAULT 1"]) {
+        [self logDatabaseError:db context:@"Failed to add clip_items.fingerprint_version"];
+        return NO;
+    }
+    // 履歴が空なら再計算する行も無い。予約すると完了まで毎回 v1 も計算することになる。
+    if ([db intForQuery:@"SELECT EXISTS (SELECT 1 FROM clip_items WHERE fingerprint_version = 1)"] == 0) {
+        return YES;
+    }
+    return [self scheduleOnlineMigrationNamed:kRCClipItemsFingerprintV2MigrationName inDatabase:db];
+}
+
+// v5 → v6: online_migrations を作る。v5 までは data_size のバックフィルの予約を
+// NSUserDefaults に持っていたので、残っていればここで移す。
+- (BOOL)migrateToOnlineMigrationsInDatabase:(FMDatabase *)db {
+    if ([[NSUserDefaults standardUserDefaults] boolForKey:kRCDataSizeBackfillPendingKey]) {
+        return [self scheduleOnlineMigrationNamed:kRCClipItemsDataSizeMigrationName inDatabase:db];
+    }
+    return [self createOnlineMigrationSchemaInDatabase:db];
+}
+
+- (long long)fileSizeAtClipPath:(NSString *)path {
+    if (path.length == 0) {
+        return 0;
+    }
+    NSDictionary<NSFileAttributeKey, id> *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil];
+    return (long long)attributes.fileSize;
+}
+
+// FTS5 の削除は墓標として残るため、全削除後はセグメントを統合して本文を物理的に消す。
+- (void)optimizeSearchIndexTable:(NSString *)tableName inDatabase:(FMDatabase *)db {
+    if (![self tableExists:tableName inDatabase:db]) {
+        return;
+    }
+    NSString *statement = [NSString stringWithFormat:@"INSERT INTO %@ (%@) VALUES ('optimize')", tableName, tableName];
+    if (![db executeUpdate:statement]) {
+        [self logDatabaseError:db context:[NSString stringWithFormat:@"Failed to optimize %@", tableName]];
+    }
+}
+
+- (nullable NSString *)matchExpressionForSearchQuery:(NSString *)query {
+    const char *utf8Query = query.UTF8String;
+    if (utf8Query == NULL) {
+        return nil;
+    }
+
+    char *expression = RCSearchTextCopyMatchExpression(utf8Query, strlen(utf8Query));
+    if (expression == NULL) {
+        return nil;
+    }
+    NSString *matchExpression = [NSString stringWithUTF8String:expression];
+    free(expression);
+    return matchExpression;
+}
+
+#pragma mark - Private: Write-behind
+
+// pendingWriteLock を保持した状態で呼び出すこと。
+- (RCClipItem *)pendingClipItemForDataHash:(NSString *)dataHash {
+    for (RCClipItem *clipItem in self.pendingInserts) {
+        if ([clipItem.dataHash isEqualToString:dataHash]) {
+            return clipItem;
+        }
+    }
+    for (RCClipItem *clipItem in self.flushingInserts) {
+        if ([clipItem.dataHash isEqualToString:dataHash]) {
+            return clipItem;
+        }
+    }
+    return nil;
+}
+
+// 一覧の読み取りは flush で書き込みを待たず、コミット済みの行にキュー上の INSERT と
+// update_time を重ねる。キューを写してから読むので、その間にコミットされた行は
+// data_hash で一本化される。cursor 以降（新しい順で後ろ）の行だけを返す。
+- (NSArray<RCClipItem *> *)clipItemsMergingQueuedWritesAfterClipItem:(nullable RCClipItem *)cursor
+                                                                limit:(NSInteger)limit
+                                                         committedRows:(NSArray<RCClipItem *> *(^)(NSInteger fetchLimit))committedRows {
+    NSArray<RCClipItem *> *queuedInserts = nil;
+    NSMutableDictionary<NSString *, NSNumber *> *queuedUpdateTimes = nil;
+    @synchronized (self.pendingWriteLock) {
+        queuedInserts = [[NSArray alloc] initWithArray:[self.pendingInserts arrayByAddingObjectsFromArray:self.flushingInserts ?: @[]]
+                                             copyItems:YES];
+        queuedUpdateTimes = [NSMutableDictionary dictionaryWithDictionary:self.flushingUpdateTimes ?: @{}];
+        [queuedUpdateTimes addEntriesFromDictionary:self.pendingUpdateTimes];
+    }
+    if (queuedInserts.count == 0 && queuedUpdateTimes.count == 0) {
+        return committedRows(limit);
+    }
+
+    // update_time が進んだ行は前のページへ移って抜けるので、その分だけ多めに読む。
+    NSArray<RCClipItem *> *rows = committedRows(limit + (NSInteger)queuedUpdateTimes.count);
+    NSMutableDictionary<NSString *, RCClipItem *> *itemsByHash = [NSMutableDictionary dictionary];
+    for (RCClipItem *clipItem in queuedInserts) {
+        itemsByHash[clipItem.dataHash] = clipItem;
+    }
+    for (RCClipItem *clipItem in rows) {
+        itemsByHash[clipItem.dataHash] = clipItem;
+    }
+
+    // 読んだ範囲の外から update_time の更新で繰り上がる行は、ハッシュで個別に引く。
+    NSInteger oldestListedTime = (rows.count >= (NSUInteger)limit) ? rows.lastObject.updateTime : NSIntegerMin;
+    [queuedUpdateTimes enumerateKeysAndObjectsUsingBlock:^(NSString *dataHash, NSNumber *updateTime, BOOL *stop) {
+        (void)stop;
+        NSData *digest = [self digestDataForDataHash:dataHash];
+        if (itemsByHash[dataHash] != nil || digest == nil || updateTime.integerValue < oldestListedTime) {
+            return;
+        }
+        RCClipItem *clipItem = [self clipItemsForQuery:kRCSelectClipItemByDataHashSQL
+                                             arguments:@[digest]
+                                             operation:RCDatabaseOperationList
+                                          errorContext:@"Failed to fetch clip_items row by data_hash"].firstObject;
+        if (clipItem != nil) {
+            itemsByHash[dataHash] = clipItem;
+        }
+    }];
+
+    NSMutableArray<RCClipItem *> *clipItems = [NSMutableArray arrayWithCapacity:itemsByHash.count];
+    for (RCClipItem *clipItem in itemsByHash.allValues) {
+        NSNumber *updateTime = queuedUpdateTimes[clipItem.dataHash];
+        if (updateTime != nil) {
+            clipItem.updateTime = updateTime.integerValue;
+        }
+        BOOL afterCursor = cursor == nil
+            || clipItem.updateTime < cursor.updateTime
+            || (clipItem.updateTime == cursor.updateTime && clipItem.itemId < cursor.itemId);
+        if (afterCursor && ![clipItem.dataHash isEqualToString:cursor.dataHash]) {
+            [clipItems addObject:clipItem];
+        }
+    }
+    [clipItems sortUsingComparator:^NSComparisonResult(RCClipItem *lhs, RCClipItem *rhs) {
+        if (lhs.updateTime != rhs.updateTime) {
+            return lhs.updateTime > rhs.updateTime ? NSOrderedAscending : NSOrderedDescending;
+        }
+        if (lhs.itemId != rhs.itemId) {
+            return lhs.itemId > rhs.itemId ? NSOrderedAscending : NSOrderedDescending;
+        }
+        return NSOrderedSame;
+    }];
+    if (clipItems.count > (NSUInteger)limit) {
+        [clipItems removeObjectsInRange:NSMakeRange((NSUInteger)limit, clipItems.count - (NSUInteger)limit)];
+    }
+    return [clipItems copy];
+}
+
+- (void)scheduleWriteBehindFlushImmediately:(BOOL)immediately {
+    @synchronized (self.pendingWriteLock) {
+        if (self.writeBehindFlushScheduled && !immediately) {
+            return;
+        }
+        self.writeBehindFlushScheduled = YES;
+    }
+
+    NSTimeInterval delay = immediately ? 0 : self.writeBehindInterval;
+    __weak typeof(self) weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * (double)NSEC_PER_SEC)),
+                   self.writeBehindQueue,
+                   ^{
+        [weakSelf flushPendingWrites];
+    });
+}
+
+// Panic Erase 用: 未コミットの書き込みをディスクに触れずに破棄する。
+- (void)discardPendingWrites {
+    NSDictionary<NSString *, RCClipItemWriteCompletion> *completions = nil;
+    NSDictionary<NSString *, NSArray<RCClipItemWriteCompletion> *> *updateCompletions = nil;
+    @synchronized (self.pendingWriteLock) {
+        completions = [self.pendingInsertCompletions copy];
+        updateCompletions = [self.pendingUpdateCompletions copy];
+        [self.pendingInserts removeAllObjects];
+        [self.pendingUpdateTimes removeAllObjects];
+        [self.pendingInsertCompletions removeAllObjects];
+        [self.pendingUpdateCompletions removeAllObjects];
+        self.writeBehindFlushScheduled = NO;
+    }
+    [completions enumerateKeysAndObjectsUsingBlock:^(NSString *dataHash, RCClipItemWriteCompletion completion, BOOL *stop) {
+        (void)dataHash;
+        (void)stop;
+        completion(NO);
+    }];
+    [updateCompletions enumerateKeysAndObjectsUsingBlock:^(NSString *dataHash, NSArray<RCClipItemWriteCompletion> *blocks, BOOL *stop) {
+        (void)dataHash;
+        (void)stop;
+        for (RCClipItemWriteCompletion completion in blocks) {
+            completion(NO);
+        }
+    }];
+}
+
+- (NSArray<RCClipItem *> *)clipItemsForQuery:(NSString *)sql
+                                   arguments:(NSArray *)arguments
+                                   operation:(RCDatabaseOperation)operation
+                                errorContext:(NSString *)errorContext {
+    NSString *clipDirectoryPath = [self standardizedPath:[RCUtilities clipDataDirectoryPath]];
+    NSString *canonicalClipDirectoryPath = [self canonicalPath:clipDirectoryPath];
+
+    __block NSMutableArray<RCClipItem *> *clipItems = [NSMutableArray array];
+    [self inReadDatabaseForOperation:operation block:^(FMDatabase * _Nonnull db) {
+        FMResultSet *resultSet = [db executeQuery:sql withArgumentsInArray:arguments];
+        if (!resultSet) {
+            [self logDatabaseError:db context:errorContext];
+            return;
+        }
+
+        while ([resultSet next]) {
+            [clipItems addObject:[self clipItemFromResultSet:resultSet
+                                           clipDirectoryPath:clipDirectoryPath
+                                  canonicalClipDirectoryPath:canonicalClipDirectoryPath]];
+        }
+        [resultSet close];
+    }];
+
+    return [clipItems copy];
+}
+
+#pragma mark - Private: Dedup filter
+
+- (void)scheduleDigestFilterRebuild {
+    __weak typeof(self) weakSelf = self;
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        typeof(self) strongSelf = weakSelf;
+        if (strongSelf == nil || [RCPanicEraseService shared].isPanicInProgress) {
+            return;
+        }
+        [strongSelf inDatabaseForOperation:RCDatabaseOperationDigestFilter block:^(FMDatabase * _Nonnull db) {
+            [strongSelf rebuildDigestFilterInDatabase:db];
+        }];
+    });
+}
+
+// databaseQueue 上で呼び出すこと。走査中の追加・削除は同じキューで待たされる。
+- (void)rebuildDigestFilterInDatabase:(FMDatabase *)db {
+    long rowCount = [db longForQuery:kRCSelectClipStatsTotalCountSQL];
+    NSUInteger capacity = MAX(kRCDigestFilterMinimumCapacity, (NSUInteger)MAX(rowCount, 0) * 2);
+    RCDigestFilter *filter = RCDigestFilterCreate(capacity);
+    if (filter == NULL) {
+        os_log_error(RCDatabaseManagerLog(), "Failed to allocate dedup filter (capacity=%lu)", (unsigned long)capacity);
+        [self replaceDigestFilter:NULL];
+        return;
+    }
+
+    FMResultSet *resultSet = [db executeQuery:kRCSelectClipItemDataHashesSQL];
+    if (!resultSet) {
+        [self logDatabaseError:db context:@"Failed to read data_hash for dedup filter"];
+        RCDigestFilterDestroy(filter);
+        [self replaceDigestFilter:NULL];
+        return;
+    }
+
+    NSError *stepError = nil;
+    BOOL complete = YES;
+    while ([resultSet nextWithError:&stepError]) {
+        NSData *digest = [resultSet dataNoCopyForColumnIndex:0];
+        if (digest.length == 0) {
+            continue;
+        }
+        if (!RCDigestFilterAdd(filter, digest.bytes, digest.length)) {
+            complete = NO;
+            break;
+        }
+    }
+    [resultSet close];
+
+    if (stepError != nil || !complete) {
+        if (stepError != nil) {
+            [self logDatabaseError:db context:@"Failed to read data_hash for dedup filter"];
+        }
+        RCDigestFilterDestroy(filter);
+        filter = NULL;
+    }
+    [self replaceDigestFilter:filter];
+}
+
+- (void)replaceDigestFilter:(nullable RCDigestFilter *)filter {
+    RCDigestFilter *previousFilter = NULL;
+    @synchronized (self.digestFilterLock) {
+        previousFilter = self.digestFilter;
+        self.digestFilter = filter;
+    }
+    RCDigestFilterDestroy(previousFilter);
+}
+
+// databaseQueue 上で、行の INSERT が成功した後に呼び出すこと。
+- (void)addDigestToFilter:(NSData *)digest {
+    BOOL saturated = NO;
+    @synchronized (self.digestFilterLock) {
+        if (self.digestFilter != NULL && !RCDigestFilterAdd(self.digestFilter, digest.bytes, digest.length)) {
+            // 入りきらないハッシュがあると「無い」を信用できないので、作り直すまで使わない。
+            RCDigestFilterDestroy(self.digestFilter);
+            self.digestFilter = NULL;
+            saturated = YES;
+        }
+    }
+    if (saturated) {
+        [self scheduleDigestFilterRebuild];
+    }
+}
+
+// databaseQueue 上で、実際に削除（コミット）した行のハッシュだけを渡すこと。
+// 追加していないハッシュを外すと別の行の指紋が消え、保存済みのクリップを見落とす。
+- (void)removeDataHashesFromFilter:(NSArray<NSString *> *)dataHashes {
+    @synchronized (self.digestFilterLock) {
+        if (self.digestFilter == NULL) {
+            return;
+        }
+        for (NSString *dataHash in dataHashes) {
+            NSData *digest = [self digestDataForDataHash:dataHash];
+            if (digest != nil) {
+                RCDigestFilterRemove(self.digestFilter, digest.bytes, digest.length);
+            }
+        }
+    }
+}
+
+- (void)clearDigestFilter {
+    @synchronized (self.digestFilterLock) {
+        if (self.digestFilter != NULL) {
+            RCDigestFilterClear(self.digestFilter);
+        }
+    }
+}
+
+- (BOOL)digestFilterMayContainDigest:(NSData *)digest {
+    @synchronized (self.digestFilterLock) {
+        return self.digestFilter == NULL || RCDigestFilterMayContain(self.digestFilter, digest.bytes, digest.length);
+    }
+}
+
+#pragma mark - Private: ResultSet mapping
+
+- (RCClipItem *)clipItemFromResultSet:(FMResultSet *)resultSet
+                    clipDirectoryPath:(NSString *)clipDirectoryPath
+           canonicalClipDirectoryPath:(NSString *)canonicalClipDirectoryPath {
+    NSString *storedDataPath = [resultSet stringForColumnIndex:RCClipItemColumnDataPath] ?: @"";
+    NSString *storedThumbnailPath = [resultSet stringForColumnIndex:RCClipItemColumnThumbnailPath] ?: @"";
+
+    RCClipItem *clipItem = [[RCClipItem alloc] init];
+    clipItem.itemId = (NSInteger)[resultSet longLongIntForColumnIndex:RCClipItemColumnID];
+    clipItem.dataPath = [self resolvedPathForStoredClipPath:storedDataPath
+                                          clipDirectoryPath:clipDirectoryPath
+                                 canonicalClipDirectoryPath:canonicalClipDirectoryPath];
+    clipItem.title = [resultSet stringForColumnIndex:RCClipItemColumnTitle] ?: @"";
+    clipItem.dataHash = [RCUtilities hexStringFromData:[resultSet dataNoCopyForColumnIndex:RCClipItemColumnDataHash]];
+    clipItem.primaryType = [resultSet stringForColumnIndex:RCClipItemColumnPrimaryType] ?: @"";
+    clipItem.updateTime = (NSInteger)[resultSet longLongIntForColumnIndex:RCClipItemColumnUpdateTime];
+    clipItem.thumbnailPath = [self resolvedPathForStoredClipPath:storedThumbnailPath
+                                               clipDirectoryPath:clipDirectoryPath
+                                      canonicalClipDirectoryPath:canonicalClipDirectoryPath];
+    clipItem.isColorCode = ([resultSet intForColumnIndex:RCClipItemColumnIsColorCode] != 0);
+    return clipItem;
 }
 
 - (NSDictionary *)snippetFolderDictionaryFromResultSet:(FMResultSet *)resultSet {
     return @{
-        @"id": @([resultSet longLongIntForColumn:@"id"]),
-        @"identifier": [resultSet stringForColumn:@"identifier"] ?: @"",
-        @"folder_index": @([resultSet longLongIntForColumn:@"folder_index"]),
-        @"enabled": @([resultSet intForColumn:@"enabled"]),
-        @"title": [resultSet stringForColumn:@"title"] ?: @"",
+        @"id": @([resultSet longLongIntForColumnIndex:RCSnippetFolderColumnID]),
+        @"identifier": [resultSet stringForColumnIndex:RCSnippetFolderColumnIdentifier] ?: @"",
+        @"folder_index": @([resultSet longLongIntForColumnIndex:RCSnippetFolderColumnFolderIndex]),
+        @"enabled": @([resultSet intForColumnIndex:RCSnippetFolderColumnEnabled]),
+        @"title": [resultSet stringForColumnIndex:RCSnippetFolderColumnTitle] ?: @"",
     };
 }
 
 - (NSDictionary *)snippetDictionaryFromResultSet:(FMResultSet *)resultSet {
     return @{
-        @"id": @([resultSet longLongIntForColumn:@"id"]),
-        @"identifier": [resultSet stringForColumn:@"identifier"] ?: @"",
-        @"folder_id": [resultSet stringForColumn:@"folder_id"] ?: @"",
-        @"snippet_index": @([resultSet longLongIntForColumn:@"snippet_index"]),
-        @"enabled": @([resultSet intForColumn:@"enabled"]),
-        @"title": [resultSet stringForColumn:@"title"] ?: @"",
-        @"content": [resultSet stringForColumn:@"content"] ?: @"",
+        @"id": @([resultSet longLongIntForColumnIndex:RCSnippetColumnID]),
+        @"identifier": [resultSet stringForColumnIndex:RCSnippetColumnIdentifier] ?: @"",
+        @"folder_id": [resultSet stringForColumnIndex:RCSnippetColumnFolderID] ?: @"",
+        @"snippet_index": @([resultSet longLongIntForColumnIndex:RCSnippetColumnSnippetIndex]),
+        @"enabled": @([resultSet intForColumnIndex:RCSnippetColumnEnabled]),
+        @"title": [resultSet stringForColumnIndex:RCSnippetColumnTitle] ?: @"",
+        @"content": [resultSet stringForColumnIndex:RCSnippetColumnContent] ?: @"",
     };
 }
 
@@ -15,6 +15,7 @@
 #import "RCHotKeyService.h"
 #import "RCPanicEraseService.h"
 #import "RCPasteService.h"
+#import "RCTrace.h"
 #import "FMDB.h"
 #import "NSColor+HexString.h"
 #import "NSImage+Color.h"
@@ -384,6 +385,7 @@ static os_log_t RCMenuManagerLog(void) {
         return;
     }
 
+    uint64_t traceBegin = RCTraceBegin();
     [self configureMenuForSimpleTransparentBackground:self.statusMenu];
     [self.statusMenu removeAllItems];
     [self appendClipHistorySectionToMenu:self.statusMenu];
@@ -403,6 +405,7 @@ static os_log_t RCMenuManagerLog(void) {
     [self.statusMenu addItem:[NSMenuItem separatorItem]];
     [self appendApplicationSectionToMenu:self.statusMenu];
     self.statusItem.menu = self.statusMenu;
+    RCTraceEnd("menu rebuild", traceBegin, 0);
 }
 
 - (NSMenu *)buildStandaloneMenu {
@@ -430,12 +433,9 @@ static os_log_t RCMenuManagerLog(void) {
     RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
     NSInteger maxHistorySize = [self integerPreferenceForKey:kRCPrefMaxHistorySizeKey defaultValue:30];
     NSInteger limit = MAX(1, maxHistorySize);
-    NSArray<NSDictionary *> *clipRows = @[];
-    if ([databaseManager clipItemCount] > 0) {
-        clipRows = [databaseManager fetchClipItemsWithLimit:limit];
-    }
+    NSArray<RCClipItem *> *clipItems = [databaseManager clipItemsWithLimit:limit];
 
-    if (clipRows.count == 0) {
+    if (clipItems.count == 0) {
         NSMenuItem *noHistoryItem = [[NSMenuItem alloc] initWithTitle:NSLocalizedString(@"No History", nil)
                                                                action:nil
                                                         keyEquivalent:@""];
@@ -444,10 +444,6 @@ static os_log_t RCMenuManagerLog(void) {
         return;
     }
 
-    NSMutableArray<RCClipItem *> *clipItems = [NSMutableArray arrayWithCapacity:clipRows.count];
-    for (NSDictionary *row in clipRows) {
-        [clipItems addObject:[[RCClipItem alloc] initWithDictionary:row]];
-    }
     [self prefetchThumbnailsForClipItems:clipItems];
     [self prefetchClipDataFallbackForClipItems:clipItems];
 
@@ -586,6 +582,10 @@ static os_log_t RCMenuManagerLog(void) {
     editSnippetsItem.target = self;
     [menu addItem:editSnippetsItem];
 
+    if ([self boolPreferenceForKey:kRCPrefShowDebugMenuKey defaultValue:NO]) {
+        [self appendDebugSubmenuToMenu:menu];
+    }
+
     [menu addItem:[NSMenuItem separatorItem]];
 
     NSMenuItem *quitItem = [[NSMenuItem alloc] initWithTitle:NSLocalizedString(@"Quit Revclip", nil)
@@ -596,6 +596,42 @@ static os_log_t RCMenuManagerLog(void) {
     [menu addItem:quitItem];
 }
 
+// kRCPrefShowDebugMenuKey が YES のときだけ出す（設定画面は無く defaults write で切り替える）
+- (void)appendDebugSubmenuToMenu:(NSMenu *)menu {
+    NSMenu *debugMenu = [self menuWithTitle:NSLocalizedString(@"Debug", nil)];
+
+    NSMenuItem *traceItem = [[NSMenuItem alloc] initWithTitle:NSLocalizedString(@"Record Capture Trace", nil)
+                                                       action:@selector(toggleCaptureTrace:)
+                                                keyEquivalent:@""];
+    traceItem.target = self;
+    traceItem.state = RCTraceIsEnabled() ? NSControlStateValueOn : NSControlStateValueOff;
+    [debugMenu addItem:traceItem];
+
+    NSMenuItem *exportItem = [[NSMenuItem alloc] initWithTitle:NSLocalizedString(@"Export Capture Trace...", nil)
+                                                        action:@selector(exportCaptureTrace:)
+                                                 keyEquivalent:@""];
+    exportItem.target = self;
+    [debugMenu addItem:exportItem];
+
+    NSMenuItem *queryMetricsItem = [[NSMenuItem alloc] initWithTitle:NSLocalizedString(@"Export Query Metrics...", nil)
+                                                              action:@selector(exportQueryMetrics:)
+                                                       keyEquivalent:@""];
+    queryMetricsItem.target = self;
+    [debugMenu addItem:queryMetricsItem];
+
+    NSMenuItem *captureMetricsItem = [[NSMenuItem alloc] initWithTitle:NSLocalizedString(@"Export Capture Metrics...", nil)
+                                                                action:@selector(exportCaptureMetrics:)
+                                                         keyEquivalent:@""];
+    captureMetricsItem.target = self;
+    [debugMenu addItem:captureMetricsItem];
+
+    NSMenuItem *debugItem = [[NSMenuItem alloc] initWithTitle:NSLocalizedString(@"Debug", nil)
+                                                       action:nil
+                                                keyEquivalent:@""];
+    debugItem.submenu = debugMenu;
+    [menu addItem:debugItem];
+}
+
 - (NSMenu *)menuWithTitle:(NSString *)title {
     NSMenu *menu = [[NSMenu alloc] initWithTitle:title ?: @""];
     menu.delegate = self;
@@ -947,7 +983,9 @@ static os_log_t RCMenuManagerLog(void) {
     if (dataPath.length == 0) {
         return nil;
     }
-    return [RCClipData clipDataFromPath:dataPath];
+    // ツールチップと色プレビューは文字列と URL しか使わないので、画像や PDF のセクションは読まない。
+    return [RCClipData clipDataFromPath:dataPath
+                        representations:RCClipDataRepresentationString | RCClipDataRepresentationURL];
 }
 
 - (void)prefetchClipDataFallbackForClipItems:(NSArray<RCClipItem *> *)clipItems
@@ -1242,12 +1280,11 @@ static os_log_t RCMenuManagerLog(void) {
         return;
     }
 
-    NSDictionary *clipRow = [[RCDatabaseManager shared] clipItemWithDataHash:dataHash];
-    if (![clipRow isKindOfClass:[NSDictionary class]]) {
+    RCClipItem *clipItem = [[RCDatabaseManager shared] clipItemForDataHash:dataHash];
+    if (clipItem == nil) {
         return;
     }
 
-    RCClipItem *clipItem = [[RCClipItem alloc] initWithDictionary:clipRow];
     if (clipItem.dataPath.length == 0) {
         [self handleMissingClipDataForClipItem:clipItem reason:@"empty data path"];
         return;
@@ -1365,33 +1402,104 @@ static os_log_t RCMenuManagerLog(void) {
     NSBeep();
 }
 
-#pragma mark - Helpers
+- (void)toggleCaptureTrace:(NSMenuItem *)sender {
+    (void)sender;
 
-- (NSArray<NSString *> *)clipDataFilePathsSnapshotForCurrentHistoryWithDatabaseManager:(RCDatabaseManager *)databaseManager {
-    if (databaseManager == nil) {
-        return @[];
+    BOOL enabled = !RCTraceIsEnabled();
+    if (enabled) {
+        // 書き出すトレースを今回の記録分だけにする
+        RCTraceReset();
+        RCTraceSetCurrentThreadName("main");
     }
+    RCTraceSetEnabled(enabled);
+    [self rebuildMenu];
+}
 
-    NSInteger count = [databaseManager clipItemCount];
-    if (count <= 0) {
-        return @[];
+// 記録中のスパンを Chrome トレース JSON（chrome://tracing / Perfetto で開く）として
+// ~/Library/Logs/Revclip/ に書き出し、Finder で表示する。記録は止めない。
+- (void)exportCaptureTrace:(NSMenuItem *)sender {
+    (void)sender;
+
+    NSString *path = [self diagnosticsExportPathWithPrefix:@"capture-trace"];
+    if (path == nil) {
+        NSBeep();
+        return;
+    }
+
+    FILE *file = fopen(path.fileSystemRepresentation, "w");
+    BOOL written = file != NULL && RCTraceWriteChromeJSON(file);
+    if (file != NULL && fclose(file) != 0) {
+        written = NO;
+    }
+    if (!written) {
+        os_log_error(RCMenuManagerLog(), "Failed to write capture trace to %{private}@", path);
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+        NSBeep();
+        return;
+    }
+
+    os_log_info(RCMenuManagerLog(), "Wrote %zu capture trace spans to %{private}@", RCTraceSpanCount(), path);
+    [[NSWorkspace sharedWorkspace] activateFileViewerSelectingURLs:@[ [NSURL fileURLWithPath:path] ]];
+}
+
+// SQL 文・操作ごとのレイテンシのヒストグラム（RCDatabaseManager の queryMetricsJSONData）を
+// トレースと同じ場所に書き出し、Finder で表示する。
+- (void)exportQueryMetrics:(NSMenuItem *)sender {
+    (void)sender;
+    [self exportDiagnosticsData:[[RCDatabaseManager shared] queryMetricsJSONData] prefix:@"query-metrics"];
+}
+
+// キャプチャパイプラインの段ごとのレイテンシ（RCClipboardService の captureMetricsJSONData）。
+- (void)exportCaptureMetrics:(NSMenuItem *)sender {
+    (void)sender;
+    [self exportDiagnosticsData:[[RCClipboardService shared] captureMetricsJSONData] prefix:@"capture-metrics"];
+}
+
+- (void)exportDiagnosticsData:(nullable NSData *)data prefix:(NSString *)prefix {
+    NSString *path = [self diagnosticsExportPathWithPrefix:prefix];
+    NSError *writeError = nil;
+    if (data == nil || path == nil || ![data writeToFile:path options:NSDataWritingAtomic error:&writeError]) {
+        os_log_error(RCMenuManagerLog(), "Failed to write %{public}@ to %{private}@ (%{private}@)",
+                     prefix, path, writeError.localizedDescription);
+        NSBeep();
+        return;
     }
 
-    NSArray<NSDictionary *> *clipRows = [databaseManager fetchClipItemsWithLimit:count];
-    if (clipRows.count == 0) {
+    os_log_info(RCMenuManagerLog(), "Wrote %{public}@ to %{private}@", prefix, path);
+    [[NSWorkspace sharedWorkspace] activateFileViewerSelectingURLs:@[ [NSURL fileURLWithPath:path] ]];
+}
+
+// ~/Library/Logs/Revclip/<prefix>-<日時>.json。ディレクトリを作れなければ nil。
+- (nullable NSString *)diagnosticsExportPathWithPrefix:(NSString *)prefix {
+    NSString *directoryPath = [[NSHomeDirectory() stringByAppendingPathComponent:@"Library/Logs"]
+                               stringByAppendingPathComponent:@"Revclip"];
+    if (![RCUtilities ensureDirectoryExists:directoryPath]) {
+        return nil;
+    }
+
+    NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+    formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+    formatter.dateFormat = @"yyyyMMdd-HHmmss";
+    NSString *fileName = [NSString stringWithFormat:@"%@-%@.json", prefix, [formatter stringFromDate:[NSDate date]]];
+    return [directoryPath stringByAppendingPathComponent:fileName];
+}
+
+#pragma mark - Helpers
+
+- (NSArray<NSString *> *)clipDataFilePathsSnapshotForCurrentHistoryWithDatabaseManager:(RCDatabaseManager *)databaseManager {
+    if (databaseManager == nil) {
         return @[];
     }
 
     NSMutableOrderedSet<NSString *> *paths = [NSMutableOrderedSet orderedSet];
-    for (NSDictionary *clipRow in clipRows) {
-        RCClipItem *clipItem = [[RCClipItem alloc] initWithDictionary:clipRow];
+    [databaseManager enumerateClipItemsUsingBlock:^(RCClipItem *clipItem, BOOL *stop) {
         if (clipItem.dataPath.length > 0) {
             [paths addObject:clipItem.dataPath];
         }
         if (clipItem.thumbnailPath.length > 0) {
             [paths addObject:clipItem.thumbnailPath];
         }
-    }
+    }];
 
     return paths.array;
 }
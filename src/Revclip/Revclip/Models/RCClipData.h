@@ -7,9 +7,38 @@
 
 #import <Foundation/Foundation.h>
 
+#import "RCCapturePlan.h"
+
 NS_ASSUME_NONNULL_BEGIN
 
-@class NSPasteboard;
+@protocol RCPasteboard;
+
+// clipDataFromPath:representations: で読み込む表現。primaryType は常に読む。
+typedef NS_OPTIONS(NSUInteger, RCClipDataRepresentation) {
+    RCClipDataRepresentationString    = 1 << 0,
+    RCClipDataRepresentationRTF       = 1 << 1,
+    RCClipDataRepresentationRTFD      = 1 << 2,
+    RCClipDataRepresentationPDF       = 1 << 3,
+    RCClipDataRepresentationFileNames = 1 << 4,
+    RCClipDataRepresentationFileURLs  = 1 << 5,
+    RCClipDataRepresentationURL       = 1 << 6,
+    RCClipDataRepresentationTIFF      = 1 << 7,
+    RCClipDataRepresentationAll       = 0xFF,
+};
+
+// キャプチャ時に RCClipData の表現を 1 回走査して求めるダイジェスト。
+@interface RCClipDataDigests : NSObject
+
+- (instancetype)initWithDataHash:(NSString *)dataHash
+                blobDigestsByKey:(NSDictionary<NSString *, NSString *> *)blobDigestsByKey NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+// -[RCClipData dataHash] と同じ値
+@property (nonatomic, copy, readonly) NSString *dataHash;
+// RCClipBlobStore に出す大きさの表現のキー → SHA-256（16 進）
+@property (nonatomic, copy, readonly) NSDictionary<NSString *, NSString *> *blobDigestsByKey;
+
+@end
 
 @interface RCClipData : NSObject <NSSecureCoding>
 
@@ -26,21 +55,62 @@ NS_ASSUME_NONNULL_BEGIN
 // プライマリタイプ
 @property (nonatomic, copy, nullable) NSString *primaryType;
 
-// NSPasteboardからの作成
-+ (instancetype)clipDataFromPasteboard:(NSPasteboard *)pasteboard;
+// ペーストボード（NSPasteboard または RCInMemoryPasteboard）からの作成。
+// pasteboard.types を 1 回だけ見て plan で読む表現を決め、
+// マーカー型（Concealed / Transient / AutoGenerated）があるもの・保存する型を含まないものは
+// データに触れずに nil を返す。読む表現は安い順に取り出し、合計が上限を超えた時点で打ち切って nil を返す。
+// nil のときの理由は outVerdict に入る。
++ (nullable instancetype)clipDataFromPasteboard:(id<RCPasteboard>)pasteboard
+                                           plan:(const RCCapturePlan *)plan
+                                        verdict:(nullable RCCaptureVerdict *)outVerdict;
 
-// データハッシュ生成（SHA256）
+// 型の一覧が提供する表現（RCCapturePlan のビット）。データは読まない。
++ (RCClipRepresentationMask)capturePlanRepresentationsForTypes:(NSArray<NSString *> *)types;
+
+// 空でない表現（RCCapturePlan のビット）
+- (RCClipRepresentationMask)capturePlanRepresentations;
+
+// データハッシュ生成（SHA256、フィンガープリント v2: すべての表現を含む）。
+// 結果はハッシュ対象の表現を変更するまでキャッシュする
 - (NSString *)dataHash;
 
+// フィンガープリント v1（最初の空でない表現と primaryType のみ）。v2 への
+// 再計算が済んでいない行を重複判定で探すときだけ使う。キャッシュしない
+- (NSString *)legacyDataHash;
+
+// 表現の生のバイト数の合計。シリアライズやハッシュの前に最大サイズの判定に使う
+// （.rcclip はこれにキー名など数百バイトが加わるだけ）。コピーは作らない。
+- (unsigned long long)payloadLength;
+
+// dataHash と、ブロブストアに出す大きな表現の SHA-256 を同じ走査で求める（dataHash と同じくキャッシュする）。
+- (RCClipDataDigests *)storageDigests;
+
 // タイトル文字列（メニュー表示用）
 - (NSString *)title;
 
+// 全文検索用のプレーンテキスト（文字列・URL・ファイル名・RTF から抽出した本文）
+- (NSString *)searchText;
+
 // NSPasteboardへの書き戻し
-- (BOOL)writeToPasteboard:(NSPasteboard *)pasteboard;
+- (BOOL)writeToPasteboard:(id<RCPasteboard>)pasteboard;
 
 // ファイル保存・読み込み
+// .rcclip はヘッダ・目次・表現ごとのセクションからなるコンテナ（Core/RCClipContainer.h）。
+// 読み込みはファイルを mmap し、大きな表現はコピーせずマップ上のバイトを指す NSData で返す。
 - (BOOL)saveToPath:(NSString *)path;
+// 大きな表現を RCClipBlobStore に 1 度だけ保存し、.rcclip にはダイジェストだけを書く。
+// 書き込んだブロブのダイジェストを返すので、呼び出し側は RCClipItem.blobDigests に渡して
+// clip_items と同じトランザクションで参照を登録すること（未登録のブロブは孤立扱いで削除される）。
+- (BOOL)saveToPath:(NSString *)path blobDigests:(NSArray<NSString *> * _Nullable * _Nullable)outBlobDigests;
+// storageDigests の結果を渡すと、ブロブストアでペイロードを再ハッシュせずにアーカイブを 1 度だけ作って書く。
+// digests を求めてから保存するまでの間に表現を変更しないこと。
+- (BOOL)saveToPath:(NSString *)path
+           digests:(nullable RCClipDataDigests *)digests
+       blobDigests:(NSArray<NSString *> * _Nullable * _Nullable)outBlobDigests;
 + (nullable instancetype)clipDataFromPath:(NSString *)path;
+// 指定した表現のセクションだけを読む（ツールチップなら TIFF や PDF には触れない）。
+// NSKeyedArchiver 形式の旧ファイルは全体を読み、バックグラウンドでコンテナ形式に書き換える。
++ (nullable instancetype)clipDataFromPath:(NSString *)path representations:(RCClipDataRepresentation)representations;
 
 @end
 
@@ -8,9 +8,16 @@
 #import "RCClipData.h"
 
 #import <AppKit/AppKit.h>
-#import <CommonCrypto/CommonDigest.h>
+#import <fcntl.h>
 #import <os/log.h>
-
+#import <sys/stat.h>
+#import <unistd.h>
+
+#import "RCClipBlobStore.h"
+#import "RCClipContainer.h"
+#import "RCConstants.h"
+#import "RCPasteboardProvider.h"
+#import "RCSHA256.h"
 #import "RCUtilities.h"
 
 static NSString * const kRCClipDataStringValueKey = @"stringValue";
@@ -22,6 +29,35 @@ static NSString * const kRCClipDataFileURLsKey = @"fileURLs";
 static NSString * const kRCClipDataURLStringKey = @"URLString";
 static NSString * const kRCClipDataTIFFDataKey = @"TIFFData";
 static NSString * const kRCClipDataPrimaryTypeKey = @"primaryType";
+// 表現のキー → ブロブのダイジェスト。値がブロブストアにある表現はアーカイブ内では nil になる。
+static NSString * const kRCClipDataBlobDigestsKey = @"blobDigests";
+// これ未満の表現はファイルを分けるコストの方が大きいので .rcclip に埋め込む。
+static NSUInteger const kRCClipDataBlobMinimumLength = 16 * 1024;
+// dataHash の形式。v1 は最初の空でない表現だけ、v2 はすべての表現を含む。
+static uint8_t const kRCClipDataFingerprintVersion = 2;
+// 索引側（RC_SEARCH_TEXT_MAX_BYTES）でも切り詰めるため、ここでは巨大な文字列の受け渡しだけを抑える。
+static NSUInteger const kRCClipDataSearchTextMaxLength = 16384;
+
+// これらの型を含むクリップ（パスワードマネージャーなど）は保存しない。
+static NSArray<NSPasteboardType> *kRCClipDataCaptureMarkerTypes(void) {
+    static NSArray<NSPasteboardType> *types = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        types = @[
+            @"org.nspasteboard.ConcealedType",
+            @"org.nspasteboard.TransientType",
+            @"org.nspasteboard.AutoGeneratedType",
+        ];
+    });
+    return types;
+}
+
+static NSPasteboardType kRCClipDataFilenamesType(void) {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    return NSFilenamesPboardType;
+#pragma clang diagnostic pop
+}
 
 static os_log_t RCClipDataLog(void) {
     static os_log_t logger = nil;
@@ -32,11 +68,285 @@ static os_log_t RCClipDataLog(void) {
     return logger;
 }
 
+// NSKeyedArchiver 形式の .rcclip を読んだときに、コンテナ形式へ書き換えるキュー。
+static dispatch_queue_t RCClipDataMigrationQueue(void) {
+    static dispatch_queue_t queue = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        dispatch_queue_attr_t attributes = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL,
+                                                                                   QOS_CLASS_UTILITY, 0);
+        queue = dispatch_queue_create("com.revclip.clipdata.migration", attributes);
+    });
+    return queue;
+}
+
+// 置き換えた旧ファイルを、削除時（RCPanicEraseService）と同じくゼロで上書きする。
+static void RCClipDataZeroFillFile(int fd, off_t length) {
+    static const size_t kZeroBufferSize = 64 * 1024;
+    void *zeros = calloc(1, kZeroBufferSize);
+    if (zeros == NULL) {
+        return;
+    }
+    off_t offset = 0;
+    while (offset < length) {
+        size_t chunkLength = (size_t)MIN((off_t)kZeroBufferSize, length - offset);
+        ssize_t written = pwrite(fd, zeros, chunkLength, offset);
+        if (written <= 0) {
+            break;
+        }
+        offset += written;
+    }
+    fsync(fd);
+    free(zeros);
+}
+
+// 表示やペーストのたびに読む表現は展開の速い LZ4、大きくて滅多に読まない表現は
+// 圧縮率の高い deflate を候補にする（実際に使うかは RCClipCompressionChooseCodec が試し圧縮で決める）。
+static RCClipCompressionClass RCClipDataCompressionClass(RCClipSectionType type) {
+    switch (type) {
+        case RCClipSectionRTFD:
+        case RCClipSectionPDF:
+        case RCClipSectionTIFF:
+            return RCClipCompressionCold;
+        default:
+            return RCClipCompressionHot;
+    }
+}
+
+// writer はバイト列を借りるだけなので、書き終えるまで data を保持すること。
+static BOOL RCClipDataAddSection(RCClipContainerWriter *writer, RCClipSectionType type, NSData *data, BOOL compress) {
+    RCClipContainerStatus status = compress
+        ? RCClipContainerWriterAddCompressibleSection(writer, type, data.bytes, data.length,
+                                                      RCClipDataCompressionClass(type))
+        : RCClipContainerWriterAddSection(writer, type, 0, data.bytes, data.length);
+    return status == RCClipContainerOK;
+}
+
+// mmap したコンテナの持ち主。セクションを指す NSData が解放されるまで生かしておく。
+@interface RCClipContainerFile : NSObject
+
+- (instancetype)initWithContainer:(RCClipContainer *)container path:(NSString *)path NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+- (BOOL)loadString:(NSString * _Nullable * _Nonnull)outString type:(RCClipSectionType)type;
+- (BOOL)loadStrings:(NSArray<NSString *> * _Nullable * _Nonnull)outStrings type:(RCClipSectionType)type;
+- (BOOL)loadData:(NSData * _Nullable * _Nonnull)outData
+            type:(RCClipSectionType)type
+       blobStore:(RCClipBlobStore *)blobStore;
+- (nullable NSData *)payloadOfSection:(const RCClipSection *)section;
+
+@end
+
+@implementation RCClipContainerFile {
+    RCClipContainer *_container;
+    NSString *_path;
+}
+
+- (instancetype)initWithContainer:(RCClipContainer *)container path:(NSString *)path {
+    self = [super init];
+    if (self) {
+        _container = container;
+        _path = [path copy];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    RCClipContainerClose(_container);
+}
+
+// 無いセクションは *outFound = NO で YES を返す。壊れている・新しすぎるときだけ NO。
+- (BOOL)findSection:(RCClipSection *)outSection type:(RCClipSectionType)type found:(BOOL *)outFound {
+    RCClipContainerStatus status = RCClipContainerFindSection(_container, type, outSection);
+    *outFound = (status == RCClipContainerOK);
+    if (status == RCClipContainerOK || status == RCClipContainerNotFound) {
+        return YES;
+    }
+    os_log_error(RCClipDataLog(),
+                 "Unreadable section %d in clip data at path %{private}@ (status %d)",
+                 (int)type, _path, (int)status);
+    return NO;
+}
+
+- (BOOL)loadString:(NSString * _Nullable * _Nonnull)outString type:(RCClipSectionType)type {
+    *outString = nil;
+    RCClipSection section;
+    BOOL found = NO;
+    if (![self findSection:&section type:type found:&found]) {
+        return NO;
+    }
+    if (!found) {
+        return YES;
+    }
+    NSData *payload = [self payloadOfSection:&section];
+    if (payload == nil) {
+        return NO;
+    }
+    *outString = [[NSString alloc] initWithData:payload encoding:NSUTF8StringEncoding] ?: @"";
+    return YES;
+}
+
+- (BOOL)loadStrings:(NSArray<NSString *> * _Nullable * _Nonnull)outStrings type:(RCClipSectionType)type {
+    *outStrings = nil;
+    RCClipSection section;
+    BOOL found = NO;
+    if (![self findSection:&section type:type found:&found]) {
+        return NO;
+    }
+    if (!found) {
+        return YES;
+    }
+    // 圧縮されたリストは展開したバイト列を同じ形式のセクションとして辿る。
+    NSData *payload = [self payloadOfSection:&section];
+    if (payload == nil) {
+        return NO;
+    }
+    section.bytes = payload.bytes;
+    section.length = payload.length;
+    section.flags &= ~RC_CLIP_SECTION_CODEC_FLAGS;
+
+    NSMutableArray<NSString *> *strings = [NSMutableArray array];
+    uint64_t cursor = 0;
+    const uint8_t *itemBytes = NULL;
+    size_t itemLength = 0;
+    RCClipContainerStatus status;
+    while ((status = RCClipSectionNextListItem(&section, &cursor, &itemBytes, &itemLength)) == RCClipContainerOK) {
+        NSString *string = [[NSString alloc] initWithBytes:itemBytes length:itemLength encoding:NSUTF8StringEncoding];
+        [strings addObject:string ?: @""];
+    }
+    if (status != RCClipContainerNotFound) {
+        os_log_error(RCClipDataLog(), "Malformed list section %d in clip data at path %{private}@", (int)type, _path);
+        return NO;
+    }
+    *outStrings = [strings copy];
+    return YES;
+}
+
+- (BOOL)loadData:(NSData * _Nullable * _Nonnull)outData
+            type:(RCClipSectionType)type
+       blobStore:(RCClipBlobStore *)blobStore {
+    *outData = nil;
+    RCClipSection section;
+    BOOL found = NO;
+    if (![self findSection:&section type:type found:&found]) {
+        return NO;
+    }
+    if (!found) {
+        return YES;
+    }
+
+    if ((section.flags & RC_CLIP_SECTION_FLAG_BLOB_REFERENCE) != 0) {
+        NSString *digest = [[NSString alloc] initWithBytes:section.bytes
+                                                    length:(NSUInteger)section.length
+                                                  encoding:NSUTF8StringEncoding];
+        *outData = digest != nil ? [blobStore dataForDigest:digest] : nil;
+        return *outData != nil;
+    }
+    *outData = [self payloadOfSection:&section];
+    return *outData != nil;
+}
+
+// 非圧縮のセクションはマップ上のバイトをコピーせずに、圧縮されたセクションは
+// そのセクションだけを展開して返す。展開に失敗したら nil。
+- (nullable NSData *)payloadOfSection:(const RCClipSection *)section {
+    if (RCClipSectionCodec(section) != RCClipCodecNone) {
+        uint64_t decodedLength = 0;
+        NSMutableData *decoded = nil;
+        if (RCClipSectionDecodedLength(section, &decodedLength) == RCClipContainerOK) {
+            decoded = [NSMutableData dataWithLength:(NSUInteger)decodedLength];
+        }
+        if (decoded == nil
+            || RCClipSectionDecode(section, decoded.mutableBytes, decoded.length) != RCClipContainerOK) {
+            os_log_error(RCClipDataLog(),
+                         "Failed to decompress section %d in clip data at path %{private}@",
+                         (int)section->type, _path);
+            return nil;
+        }
+        return decoded;
+    }
+    if (section->length == 0) {
+        return [NSData data];
+    }
+    // ブロックが self を保持するので、この NSData（と copy プロパティが共有する参照）が
+    // 消えるまでマップは解放されない。
+    return [[NSData alloc] initWithBytesNoCopy:(void *)section->bytes
+                                        length:(NSUInteger)section->length
+                                   deallocator:^(void *bytes, NSUInteger length) {
+        (void)bytes;
+        (void)length;
+        (void)self;
+    }];
+}
+
+@end
+
+@implementation RCClipDataDigests
+
+- (instancetype)initWithDataHash:(NSString *)dataHash
+                blobDigestsByKey:(NSDictionary<NSString *, NSString *> *)blobDigestsByKey {
+    self = [super init];
+    if (self) {
+        _dataHash = [dataHash copy];
+        _blobDigestsByKey = [blobDigestsByKey copy];
+    }
+    return self;
+}
+
+@end
+
 @interface RCClipData ()
 
+@property (nonatomic, copy, nullable) NSDictionary<NSString *, NSString *> *blobDigestsByKey;
+// dataHash / storageDigests のメモ。isEqual: や hash のたびにペイロード全体を読み直さない。
+// ハッシュ対象の表現のセッターで破棄する（各プロパティは copy なので外から書き換わらない）。
+@property (atomic, copy, nullable) NSString *memoizedDataHash;
+@property (atomic, strong, nullable) RCClipDataDigests *memoizedDigests;
+
++ (NSArray<NSString *> *)blobEligibleKeys;
+- (void)invalidateFingerprint;
+- (BOOL)writeContainerToPath:(NSString *)path
+            externalizeBlobs:(BOOL)externalizeBlobs
+            knownBlobDigests:(nullable NSDictionary<NSString *, NSString *> *)knownBlobDigests
+                 blobDigests:(NSArray<NSString *> * _Nullable * _Nullable)outBlobDigests;
+- (BOOL)loadSectionsFromContainerFile:(RCClipContainerFile *)containerFile
+                      representations:(RCClipDataRepresentation)representations;
+- (BOOL)addString:(nullable NSString *)string
+             type:(RCClipSectionType)type
+         toWriter:(RCClipContainerWriter *)writer
+  retainedBuffers:(NSMutableArray<NSData *> *)retainedBuffers;
+- (BOOL)addStrings:(nullable NSArray<NSString *> *)strings
+              type:(RCClipSectionType)type
+          toWriter:(RCClipContainerWriter *)writer;
+- (BOOL)addData:(nullable NSData *)data
+             key:(NSString *)key
+            type:(RCClipSectionType)type
+externalizeBlobs:(BOOL)externalizeBlobs
+knownBlobDigests:(nullable NSDictionary<NSString *, NSString *> *)knownBlobDigests
+        toWriter:(RCClipContainerWriter *)writer
+ retainedBuffers:(NSMutableArray<NSData *> *)retainedBuffers
+     blobDigests:(NSMutableArray<NSString *> *)blobDigests;
++ (nullable instancetype)clipDataFromLegacyArchiveAtPath:(NSString *)path;
++ (void)migrateLegacyArchiveAtPath:(NSString *)path fileNumber:(ino_t)fileNumber clipData:(RCClipData *)clipData;
+- (RCClipData *)shallowCopy;
+- (BOOL)loadBlobsFromStore:(RCClipBlobStore *)blobStore;
+- (NSString *)dataHashWithBlobDigests:(nullable NSMutableDictionary<NSString *, NSString *> *)blobDigests;
 + (NSString *)sha256HexForDigest:(const unsigned char *)digest;
-+ (BOOL)updateHashContext:(CC_SHA256_CTX *)context withData:(nullable NSData *)source;
-+ (BOOL)updateHashContext:(CC_SHA256_CTX *)context withString:(nullable NSString *)string;
++ (NSString *)sha256HexForData:(NSData *)data;
++ (BOOL)updateHashContext:(RCSHA256Context *)context withData:(nullable NSData *)source;
++ (BOOL)updateHashContext:(RCSHA256Context *)context
+                 withData:(nullable NSData *)source
+            blobDigestKey:(nullable NSString *)blobDigestKey
+              blobDigests:(nullable NSMutableDictionary<NSString *, NSString *> *)blobDigests;
++ (BOOL)updateHashContext:(RCSHA256Context *)context withString:(nullable NSString *)string;
++ (BOOL)updateHashContext:(RCSHA256Context *)context
+                  section:(RCClipSectionType)section
+                 withData:(nullable NSData *)source
+            blobDigestKey:(nullable NSString *)blobDigestKey
+              blobDigests:(nullable NSMutableDictionary<NSString *, NSString *> *)blobDigests;
++ (BOOL)updateHashContext:(RCSHA256Context *)context section:(RCClipSectionType)section withString:(nullable NSString *)string;
++ (BOOL)updateHashContext:(RCSHA256Context *)context
+                  section:(RCClipSectionType)section
+              withStrings:(nullable NSArray<NSString *> *)strings;
 + (NSString *)truncateString:(NSString *)string length:(NSUInteger)length;
 + (NSString *)standardizedPath:(NSString *)path;
 + (NSString *)resolvedClipStoragePath:(NSString *)path;
@@ -49,61 +359,111 @@ static os_log_t RCClipDataLog(void) {
 
 #pragma mark - Create
 
-+ (instancetype)clipDataFromPasteboard:(NSPasteboard *)pasteboard {
-    RCClipData *clipData = [[self alloc] init];
-
-    if (pasteboard == nil) {
-        return clipData;
++ (nullable instancetype)clipDataFromPasteboard:(id<RCPasteboard>)pasteboard
+                                           plan:(const RCCapturePlan *)plan
+                                        verdict:(nullable RCCaptureVerdict *)outVerdict {
+    // 型の一覧だけで判定する。ここまではペーストボードのデータを 1 バイトも読まない。
+    NSArray<NSPasteboardType> *types = pasteboard.types ?: @[];
+    BOOL marked = NO;
+    for (NSPasteboardType type in kRCClipDataCaptureMarkerTypes()) {
+        if ([types containsObject:type]) {
+            marked = YES;
+            break;
+        }
     }
-
-    void (^setPrimaryTypeIfNeeded)(NSString *) = ^(NSString *type) {
-        if (clipData.primaryType.length == 0) {
-            clipData.primaryType = type;
+    RCClipRepresentationMask readMask = 0;
+    RCCaptureVerdict verdict = RCCapturePlanEvaluate(plan,
+                                                     [self capturePlanRepresentationsForTypes:types],
+                                                     marked,
+                                                     &readMask);
+
+    RCClipData *clipData = nil;
+    if (verdict == RCCaptureVerdictRead) {
+        clipData = [[self alloc] init];
+        RCClipRepresentation order[RC_CLIP_REPRESENTATION_COUNT];
+        size_t count = RCCapturePlanReadOrder(readMask, order);
+        RCCaptureBudget budget;
+        RCCaptureBudgetInit(&budget, plan);
+        for (size_t index = 0; index < count; index++) {
+            unsigned long long length = [clipData readRepresentation:order[index] fromPasteboard:pasteboard];
+            if (!RCCaptureBudgetCharge(&budget, length)) {
+                verdict = RCCaptureVerdictSkipOversized;
+                clipData = nil;
+                break;
+            }
         }
-    };
-
-    NSString *stringValue = [pasteboard stringForType:NSPasteboardTypeString];
-    if (stringValue != nil) {
-        clipData.stringValue = stringValue;
-        setPrimaryTypeIfNeeded(NSPasteboardTypeString);
+        [clipData updatePrimaryTypeFromRepresentations];
     }
 
-    NSData *RTFData = [pasteboard dataForType:NSPasteboardTypeRTF];
-    if (RTFData != nil) {
-        clipData.RTFData = RTFData;
-        setPrimaryTypeIfNeeded(NSPasteboardTypeRTF);
+    if (outVerdict != NULL) {
+        *outVerdict = verdict;
     }
+    return clipData;
+}
 
-    NSData *RTFDData = [pasteboard dataForType:NSPasteboardTypeRTFD];
-    if (RTFDData != nil) {
-        clipData.RTFDData = RTFDData;
-        setPrimaryTypeIfNeeded(NSPasteboardTypeRTFD);
++ (RCClipRepresentationMask)capturePlanRepresentationsForTypes:(NSArray<NSString *> *)types {
+    RCClipRepresentationMask representations = 0;
+    for (NSString *type in types) {
+        if ([type isEqualToString:NSPasteboardTypeString]) {
+            representations |= RCClipRepresentationString;
+        } else if ([type isEqualToString:NSPasteboardTypeRTF]) {
+            representations |= RCClipRepresentationRTF;
+        } else if ([type isEqualToString:NSPasteboardTypeRTFD]) {
+            representations |= RCClipRepresentationRTFD;
+        } else if ([type isEqualToString:NSPasteboardTypePDF]) {
+            representations |= RCClipRepresentationPDF;
+        } else if ([type isEqualToString:NSPasteboardTypeFileURL] || [type isEqualToString:kRCClipDataFilenamesType()]) {
+            representations |= RCClipRepresentationFiles;
+        } else if ([type isEqualToString:NSPasteboardTypeURL]) {
+            representations |= RCClipRepresentationURL;
+        } else if ([type isEqualToString:NSPasteboardTypeTIFF] || [type isEqualToString:NSPasteboardTypePNG]) {
+            // PNG だけのペーストボードからも dataForType:TIFF で変換して取り出せる
+            representations |= RCClipRepresentationTIFF;
+        }
     }
+    return representations;
+}
 
-    NSData *PDFData = [pasteboard dataForType:NSPasteboardTypePDF];
-    if (PDFData != nil) {
-        clipData.PDFData = PDFData;
-        setPrimaryTypeIfNeeded(NSPasteboardTypePDF);
+// 1 つの表現を読み、読んだ生のバイト数（payloadLength と同じ数え方）を返す。
+- (unsigned long long)readRepresentation:(RCClipRepresentation)representation fromPasteboard:(id<RCPasteboard>)pasteboard {
+    switch (representation) {
+        case RCClipRepresentationString:
+            self.stringValue = [pasteboard stringForType:NSPasteboardTypeString];
+            return [self.stringValue lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+        case RCClipRepresentationRTF:
+            self.RTFData = [pasteboard dataForType:NSPasteboardTypeRTF];
+            return self.RTFData.length;
+        case RCClipRepresentationRTFD:
+            self.RTFDData = [pasteboard dataForType:NSPasteboardTypeRTFD];
+            return self.RTFDData.length;
+        case RCClipRepresentationPDF:
+            self.PDFData = [pasteboard dataForType:NSPasteboardTypePDF];
+            return self.PDFData.length;
+        case RCClipRepresentationFiles:
+            return [self readFilesFromPasteboard:pasteboard];
+        case RCClipRepresentationURL:
+            self.URLString = [pasteboard stringForType:NSPasteboardTypeURL];
+            return [self.URLString lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+        case RCClipRepresentationTIFF:
+            self.TIFFData = [pasteboard dataForType:NSPasteboardTypeTIFF];
+            return self.TIFFData.length;
+        default:
+            return 0;
     }
+}
 
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wdeprecated-declarations"
-    id rawFileNames = [pasteboard propertyListForType:NSFilenamesPboardType];
-#pragma clang diagnostic pop
+- (unsigned long long)readFilesFromPasteboard:(id<RCPasteboard>)pasteboard {
+    unsigned long long length = 0;
+    id rawFileNames = [pasteboard propertyListForType:kRCClipDataFilenamesType()];
     if ([rawFileNames isKindOfClass:[NSArray class]]) {
         NSMutableArray<NSString *> *fileNames = [NSMutableArray array];
         for (id value in (NSArray *)rawFileNames) {
             if ([value isKindOfClass:[NSString class]]) {
                 [fileNames addObject:value];
+                length += [(NSString *)value lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
             }
         }
-        clipData.fileNames = [fileNames copy];
-        if (fileNames.count > 0) {
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wdeprecated-declarations"
-            setPrimaryTypeIfNeeded(NSFilenamesPboardType);
-#pragma clang diagnostic pop
-        }
+        self.fileNames = [fileNames copy];
     }
 
     NSArray *readObjects = [pasteboard readObjectsForClasses:@[[NSURL class]] options:nil];
@@ -112,58 +472,227 @@ static os_log_t RCClipDataLog(void) {
         for (id object in readObjects) {
             if ([object isKindOfClass:[NSURL class]] && [(NSURL *)object isFileURL]) {
                 [fileURLs addObject:object];
+                length += [[(NSURL *)object absoluteString] lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
             }
         }
         if (fileURLs.count > 0) {
-            clipData.fileURLs = [fileURLs copy];
-            setPrimaryTypeIfNeeded(NSPasteboardTypeFileURL);
+            self.fileURLs = [fileURLs copy];
         }
     }
+    return length;
+}
 
-    NSString *URLString = [pasteboard stringForType:NSPasteboardTypeURL];
-    if (URLString != nil) {
-        clipData.URLString = URLString;
-        setPrimaryTypeIfNeeded(NSPasteboardTypeURL);
+// 読む順序はサイズ順になったため、primaryType は従来の優先順位で読み終えた後に決める。
+- (void)updatePrimaryTypeFromRepresentations {
+    if (self.stringValue != nil) {
+        self.primaryType = NSPasteboardTypeString;
+    } else if (self.RTFData != nil) {
+        self.primaryType = NSPasteboardTypeRTF;
+    } else if (self.RTFDData != nil) {
+        self.primaryType = NSPasteboardTypeRTFD;
+    } else if (self.PDFData != nil) {
+        self.primaryType = NSPasteboardTypePDF;
+    } else if (self.fileNames.count > 0) {
+        self.primaryType = kRCClipDataFilenamesType();
+    } else if (self.fileURLs.count > 0) {
+        self.primaryType = NSPasteboardTypeFileURL;
+    } else if (self.URLString != nil) {
+        self.primaryType = NSPasteboardTypeURL;
+    } else if (self.TIFFData != nil) {
+        self.primaryType = NSPasteboardTypeTIFF;
     }
+}
 
-    NSData *TIFFData = [pasteboard dataForType:NSPasteboardTypeTIFF];
-    if (TIFFData != nil) {
-        clipData.TIFFData = TIFFData;
-        setPrimaryTypeIfNeeded(NSPasteboardTypeTIFF);
+- (RCClipRepresentationMask)capturePlanRepresentations {
+    RCClipRepresentationMask representations = 0;
+    if (self.stringValue.length > 0) {
+        representations |= RCClipRepresentationString;
     }
+    if (self.RTFData.length > 0) {
+        representations |= RCClipRepresentationRTF;
+    }
+    if (self.RTFDData.length > 0) {
+        representations |= RCClipRepresentationRTFD;
+    }
+    if (self.PDFData.length > 0) {
+        representations |= RCClipRepresentationPDF;
+    }
+    if (self.fileNames.count > 0 || self.fileURLs.count > 0) {
+        representations |= RCClipRepresentationFiles;
+    }
+    if (self.URLString.length > 0) {
+        representations |= RCClipRepresentationURL;
+    }
+    if (self.TIFFData.length > 0) {
+        representations |= RCClipRepresentationTIFF;
+    }
+    return representations;
+}
 
-    return clipData;
+#pragma mark - Accessors
+
+// ハッシュ対象の表現が変わったらメモを捨てる。表現の変更とハッシュの計算を
+// 別スレッドで同時に行うことは想定しない（従来どおり）。
+- (void)setStringValue:(nullable NSString *)stringValue {
+    _stringValue = [stringValue copy];
+    [self invalidateFingerprint];
+}
+
+- (void)setRTFData:(nullable NSData *)RTFData {
+    _RTFData = [RTFData copy];
+    [self invalidateFingerprint];
+}
+
+- (void)setRTFDData:(nullable NSData *)RTFDData {
+    _RTFDData = [RTFDData copy];
+    [self invalidateFingerprint];
+}
+
+- (void)setPDFData:(nullable NSData *)PDFData {
+    _PDFData = [PDFData copy];
+    [self invalidateFingerprint];
+}
+
+- (void)setFileNames:(nullable NSArray<NSString *> *)fileNames {
+    _fileNames = [fileNames copy];
+    [self invalidateFingerprint];
+}
+
+- (void)setFileURLs:(nullable NSArray<NSURL *> *)fileURLs {
+    _fileURLs = [fileURLs copy];
+    [self invalidateFingerprint];
+}
+
+- (void)setURLString:(nullable NSString *)URLString {
+    _URLString = [URLString copy];
+    [self invalidateFingerprint];
+}
+
+- (void)setTIFFData:(nullable NSData *)TIFFData {
+    _TIFFData = [TIFFData copy];
+    [self invalidateFingerprint];
+}
+
+- (void)setPrimaryType:(nullable NSString *)primaryType {
+    _primaryType = [primaryType copy];
+    [self invalidateFingerprint];
+}
+
+- (void)invalidateFingerprint {
+    self.memoizedDataHash = nil;
+    self.memoizedDigests = nil;
 }
 
 #pragma mark - Hash / Title
 
 - (NSString *)dataHash {
-    CC_SHA256_CTX context;
-    CC_SHA256_Init(&context);
+    NSString *dataHash = self.memoizedDataHash;
+    if (dataHash == nil) {
+        dataHash = [self dataHashWithBlobDigests:nil];
+        self.memoizedDataHash = dataHash;
+    }
+    return dataHash;
+}
+
+- (unsigned long long)payloadLength {
+    unsigned long long length = 0;
+    length += [self.stringValue lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    length += self.RTFData.length + self.RTFDData.length + self.PDFData.length + self.TIFFData.length;
+    for (NSString *fileName in self.fileNames) {
+        length += [fileName lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    }
+    for (NSURL *fileURL in self.fileURLs) {
+        length += [fileURL.absoluteString lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    }
+    length += [self.URLString lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    return length;
+}
+
+- (RCClipDataDigests *)storageDigests {
+    RCClipDataDigests *digests = self.memoizedDigests;
+    if (digests != nil) {
+        return digests;
+    }
+
+    NSMutableDictionary<NSString *, NSString *> *blobDigests = [NSMutableDictionary dictionary];
+    NSString *dataHash = [self dataHashWithBlobDigests:blobDigests];
+    digests = [[RCClipDataDigests alloc] initWithDataHash:dataHash blobDigestsByKey:blobDigests];
+    self.memoizedDigests = digests;
+    self.memoizedDataHash = dataHash;
+    return digests;
+}
+
+// フィンガープリント v2。版番号の後に、空でない表現を .rcclip のセクション順に
+// (セクション種別 1 バイト, 長さ, 中身) で並べてハッシュする。v1 と違いすべての表現を
+// 含むので、同じ文字列で RTF や画像だけが違うクリップは別の行になる。
+// blobDigests が非 nil のとき、ブロブに出す大きさの表現は同じ走査で単体の SHA-256 も求める。
+- (NSString *)dataHashWithBlobDigests:(nullable NSMutableDictionary<NSString *, NSString *> *)blobDigests {
+    Class cls = [self class];
+    RCSHA256Context context;
+    RCSHA256Init(&context);
+    uint8_t version = kRCClipDataFingerprintVersion;
+    RCSHA256Update(&context, &version, sizeof(version));
+
+    NSMutableArray<NSString *> *fileURLStrings = nil;
+    if (self.fileURLs.count > 0) {
+        fileURLStrings = [NSMutableArray arrayWithCapacity:self.fileURLs.count];
+        for (NSURL *fileURL in self.fileURLs) {
+            [fileURLStrings addObject:fileURL.absoluteString ?: @""];
+        }
+    }
 
     BOOL didUpdate = NO;
-    didUpdate = didUpdate || [[self class] updateHashContext:&context withString:self.stringValue];
-    didUpdate = didUpdate || [[self class] updateHashContext:&context withData:self.RTFData];
-    didUpdate = didUpdate || [[self class] updateHashContext:&context withData:self.RTFDData];
-    didUpdate = didUpdate || [[self class] updateHashContext:&context withData:self.PDFData];
-    didUpdate = didUpdate || [[self class] updateHashContext:&context withData:self.TIFFData];
+    didUpdate |= [cls updateHashContext:&context section:RCClipSectionString withString:self.stringValue];
+    didUpdate |= [cls updateHashContext:&context section:RCClipSectionRTF withData:self.RTFData
+                          blobDigestKey:kRCClipDataRTFDataKey blobDigests:blobDigests];
+    didUpdate |= [cls updateHashContext:&context section:RCClipSectionRTFD withData:self.RTFDData
+                          blobDigestKey:kRCClipDataRTFDDataKey blobDigests:blobDigests];
+    didUpdate |= [cls updateHashContext:&context section:RCClipSectionPDF withData:self.PDFData
+                          blobDigestKey:kRCClipDataPDFDataKey blobDigests:blobDigests];
+    didUpdate |= [cls updateHashContext:&context section:RCClipSectionFileNames withStrings:self.fileNames];
+    didUpdate |= [cls updateHashContext:&context section:RCClipSectionFileURLs withStrings:fileURLStrings];
+    didUpdate |= [cls updateHashContext:&context section:RCClipSectionURL withString:self.URLString];
+    didUpdate |= [cls updateHashContext:&context section:RCClipSectionTIFF withData:self.TIFFData
+                          blobDigestKey:kRCClipDataTIFFDataKey blobDigests:blobDigests];
+    didUpdate |= [cls updateHashContext:&context section:RCClipSectionPrimaryType withString:self.primaryType];
+
+    if (!didUpdate) {
+        return @"";
+    }
+
+    uint8_t digest[RC_SHA256_DIGEST_LENGTH];
+    RCSHA256Final(&context, digest);
+    return [cls sha256HexForDigest:digest];
+}
+
+- (NSString *)legacyDataHash {
+    Class cls = [self class];
+    RCSHA256Context context;
+    RCSHA256Init(&context);
+
+    // v1 は最初に空でなかった表現だけを読む（短絡評価）。既存の data_hash と一致させるため変えない。
+    BOOL didUpdate = NO;
+    didUpdate = didUpdate || [cls updateHashContext:&context withString:self.stringValue];
+    didUpdate = didUpdate || [cls updateHashContext:&context withData:self.RTFData];
+    didUpdate = didUpdate || [cls updateHashContext:&context withData:self.RTFDData];
+    didUpdate = didUpdate || [cls updateHashContext:&context withData:self.PDFData];
+    didUpdate = didUpdate || [cls updateHashContext:&context withData:self.TIFFData];
     for (NSString *fileName in self.fileNames) {
-        didUpdate = didUpdate || [[self class] updateHashContext:&context withString:fileName];
+        didUpdate = didUpdate || [cls updateHashContext:&context withString:fileName];
     }
     for (NSURL *fileURL in self.fileURLs) {
-        didUpdate = didUpdate || [[self class] updateHashContext:&context withString:fileURL.absoluteString];
+        didUpdate = didUpdate || [cls updateHashContext:&context withString:fileURL.absoluteString];
     }
-    didUpdate = didUpdate || [[self class] updateHashContext:&context withString:self.URLString];
-    // Include primaryType in hash to differentiate items with identical data but different primary types
-    didUpdate = didUpdate || [[self class] updateHashContext:&context withString:self.primaryType];
+    didUpdate = didUpdate || [cls updateHashContext:&context withString:self.URLString];
+    didUpdate = didUpdate || [cls updateHashContext:&context withString:self.primaryType];
 
     if (!didUpdate) {
         return @"";
     }
 
-    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
-    CC_SHA256_Final(digest, &context);
-    return [[self class] sha256HexForDigest:digest];
+    uint8_t digest[RC_SHA256_DIGEST_LENGTH];
+    RCSHA256Final(&context, digest);
+    return [cls sha256HexForDigest:digest];
 }
 
 - (NSString *)title {
@@ -200,6 +729,36 @@ static os_log_t RCClipDataLog(void) {
     return @"";
 }
 
+- (NSString *)searchText {
+    NSMutableArray<NSString *> *parts = [NSMutableArray array];
+    if (self.stringValue.length > 0) {
+        [parts addObject:self.stringValue];
+    } else if (self.RTFData.length > 0 || self.RTFDData.length > 0) {
+        // 文字列表現が無い RTF / RTFD のみのクリップは本文を抽出する。
+        NSAttributedString *attributedString = self.RTFData.length > 0
+            ? [[NSAttributedString alloc] initWithRTF:self.RTFData documentAttributes:nil]
+            : [[NSAttributedString alloc] initWithRTFD:self.RTFDData documentAttributes:nil];
+        if (attributedString.string.length > 0) {
+            [parts addObject:attributedString.string];
+        }
+    }
+
+    if (self.URLString.length > 0) {
+        [parts addObject:self.URLString];
+    }
+    for (NSString *fileName in self.fileNames) {
+        [parts addObject:fileName];
+    }
+    for (NSURL *fileURL in self.fileURLs) {
+        if (fileURL.path.length > 0 && ![self.fileNames containsObject:fileURL.path]) {
+            [parts addObject:fileURL.path];
+        }
+    }
+
+    return [[self class] truncateString:[parts componentsJoinedByString:@"\n"]
+                                 length:kRCClipDataSearchTextMaxLength];
+}
+
 #pragma mark - Equality
 
 - (BOOL)isEqual:(id)object {
@@ -219,7 +778,7 @@ static os_log_t RCClipDataLog(void) {
 
 #pragma mark - Write
 
-- (BOOL)writeToPasteboard:(NSPasteboard *)pasteboard {
+- (BOOL)writeToPasteboard:(id<RCPasteboard>)pasteboard {
     if (pasteboard == nil) {
         return NO;
     }
@@ -298,6 +857,9 @@ static os_log_t RCClipDataLog(void) {
     [coder encodeObject:self.URLString forKey:kRCClipDataURLStringKey];
     [coder encodeObject:self.TIFFData forKey:kRCClipDataTIFFDataKey];
     [coder encodeObject:self.primaryType forKey:kRCClipDataPrimaryTypeKey];
+    if (self.blobDigestsByKey.count > 0) {
+        [coder encodeObject:self.blobDigestsByKey forKey:kRCClipDataBlobDigestsKey];
+    }
 }
 
 - (instancetype)initWithCoder:(NSCoder *)coder {
@@ -315,6 +877,8 @@ static os_log_t RCClipDataLog(void) {
         self.URLString = [coder decodeObjectOfClass:[NSString class] forKey:kRCClipDataURLStringKey];
         self.TIFFData = [coder decodeObjectOfClass:[NSData class] forKey:kRCClipDataTIFFDataKey];
         self.primaryType = [coder decodeObjectOfClass:[NSString class] forKey:kRCClipDataPrimaryTypeKey];
+        NSSet<Class> *digestMapClasses = [NSSet setWithArray:@[[NSDictionary class], [NSString class]]];
+        self.blobDigestsByKey = [coder decodeObjectOfClasses:digestMapClasses forKey:kRCClipDataBlobDigestsKey];
     }
     return self;
 }
@@ -322,6 +886,19 @@ static os_log_t RCClipDataLog(void) {
 #pragma mark - File
 
 - (BOOL)saveToPath:(NSString *)path {
+    return [self saveToPath:path blobDigests:NULL];
+}
+
+- (BOOL)saveToPath:(NSString *)path blobDigests:(NSArray<NSString *> * _Nullable * _Nullable)outBlobDigests {
+    return [self saveToPath:path digests:nil blobDigests:outBlobDigests];
+}
+
+- (BOOL)saveToPath:(NSString *)path
+           digests:(nullable RCClipDataDigests *)digests
+       blobDigests:(NSArray<NSString *> * _Nullable * _Nullable)outBlobDigests {
+    if (outBlobDigests != NULL) {
+        *outBlobDigests = @[];
+    }
     if (path.length == 0) {
         return NO;
     }
@@ -346,37 +923,24 @@ static os_log_t RCClipDataLog(void) {
         }
     }
 
-    NSError *archiveError = nil;
-    NSData *archiveData = [NSKeyedArchiver archivedDataWithRootObject:self
-                                                 requiringSecureCoding:YES
-                                                                 error:&archiveError];
-    if (archiveData == nil) {
-        NSLog(@"[RCClipData] Failed to archive clip data: %@", archiveError.localizedDescription);
-        return NO;
-    }
-
-    NSError *writeError = nil;
-    BOOL wrote = [archiveData writeToFile:resolvedPath options:NSDataWritingAtomic error:&writeError];
-    if (!wrote) {
-        os_log_error(RCClipDataLog(),
-                     "Failed to save clip data at path %{private}@ (%{private}@)",
-                     resolvedPath, writeError.localizedDescription);
+    NSArray<NSString *> *blobDigests = nil;
+    if (![self writeContainerToPath:resolvedPath
+                   externalizeBlobs:(outBlobDigests != NULL)
+                   knownBlobDigests:digests.blobDigestsByKey
+                        blobDigests:&blobDigests]) {
         return NO;
     }
-
-    NSError *permissionsError = nil;
-    BOOL permissionApplied = [[NSFileManager defaultManager] setAttributes:@{ NSFilePosixPermissions: @(0600) }
-                                                               ofItemAtPath:resolvedPath
-                                                                      error:&permissionsError];
-    if (!permissionApplied && permissionsError != nil) {
-        os_log_error(RCClipDataLog(),
-                     "Failed to set clip data file permissions for %{private}@ (%{private}@)",
-                     resolvedPath, permissionsError.localizedDescription);
+    if (outBlobDigests != NULL) {
+        *outBlobDigests = blobDigests ?: @[];
     }
     return YES;
 }
 
 + (nullable instancetype)clipDataFromPath:(NSString *)path {
+    return [self clipDataFromPath:path representations:RCClipDataRepresentationAll];
+}
+
++ (nullable instancetype)clipDataFromPath:(NSString *)path representations:(RCClipDataRepresentation)representations {
     if (path.length == 0) {
         return nil;
     }
@@ -390,8 +954,226 @@ static os_log_t RCClipDataLog(void) {
         return nil;
     }
 
+    RCClipContainer *container = NULL;
+    RCClipContainerStatus status = RCClipContainerOpenFile(canonicalPath.fileSystemRepresentation, &container);
+    if (status == RCClipContainerNotContainer) {
+        return [self clipDataFromLegacyArchiveAtPath:canonicalPath];
+    }
+    if (status != RCClipContainerOK) {
+        if (status != RCClipContainerIOError) {
+            os_log_error(RCClipDataLog(),
+                         "Failed to open clip data at path %{private}@ (status %d)",
+                         canonicalPath, (int)status);
+        }
+        return nil;
+    }
+
+    RCClipContainerFile *containerFile = [[RCClipContainerFile alloc] initWithContainer:container path:canonicalPath];
+    RCClipData *clipData = [[self alloc] init];
+    if (![clipData loadSectionsFromContainerFile:containerFile representations:representations]) {
+        return nil;
+    }
+    return clipData;
+}
+
+#pragma mark - Container
+
+- (BOOL)loadSectionsFromContainerFile:(RCClipContainerFile *)containerFile
+                      representations:(RCClipDataRepresentation)representations {
+    RCClipBlobStore *blobStore = [RCClipBlobStore shared];
+    NSString *stringValue = nil;
+    NSData *RTFData = nil;
+    NSData *RTFDData = nil;
+    NSData *PDFData = nil;
+    NSArray<NSString *> *fileNames = nil;
+    NSArray<NSString *> *fileURLStrings = nil;
+    NSString *URLString = nil;
+    NSData *TIFFData = nil;
+    NSString *primaryType = nil;
+
+    // 要求されなかった表現のセクションには触れない（チェックサムの検証もしない）。
+    BOOL loaded = [containerFile loadString:&primaryType type:RCClipSectionPrimaryType]
+        && (!(representations & RCClipDataRepresentationString)
+            || [containerFile loadString:&stringValue type:RCClipSectionString])
+        && (!(representations & RCClipDataRepresentationRTF)
+            || [containerFile loadData:&RTFData type:RCClipSectionRTF blobStore:blobStore])
+        && (!(representations & RCClipDataRepresentationRTFD)
+            || [containerFile loadData:&RTFDData type:RCClipSectionRTFD blobStore:blobStore])
+        && (!(representations & RCClipDataRepresentationPDF)
+            || [containerFile loadData:&PDFData type:RCClipSectionPDF blobStore:blobStore])
+        && (!(representations & RCClipDataRepresentationFileNames)
+            || [containerFile loadStrings:&fileNames type:RCClipSectionFileNames])
+        && (!(representations & RCClipDataRepresentationFileURLs)
+            || [containerFile loadStrings:&fileURLStrings type:RCClipSectionFileURLs])
+        && (!(representations & RCClipDataRepresentationURL)
+            || [containerFile loadString:&URLString type:RCClipSectionURL])
+        && (!(representations & RCClipDataRepresentationTIFF)
+            || [containerFile loadData:&TIFFData type:RCClipSectionTIFF blobStore:blobStore]);
+    if (!loaded) {
+        return NO;
+    }
+
+    self.stringValue = stringValue;
+    self.RTFData = RTFData;
+    self.RTFDData = RTFDData;
+    self.PDFData = PDFData;
+    self.fileNames = fileNames;
+    if (fileURLStrings != nil) {
+        NSMutableArray<NSURL *> *fileURLs = [NSMutableArray arrayWithCapacity:fileURLStrings.count];
+        for (NSString *fileURLString in fileURLStrings) {
+            NSURL *fileURL = [NSURL URLWithString:fileURLString];
+            if (fileURL != nil) {
+                [fileURLs addObject:fileURL];
+            }
+        }
+        self.fileURLs = fileURLs;
+    }
+    self.URLString = URLString;
+    self.TIFFData = TIFFData;
+    self.primaryType = primaryType;
+    return YES;
+}
+
+// externalizeBlobs が YES のとき、閾値以上の表現をブロブストアへ書き出し、
+// .rcclip にはダイジェストだけを書く（self は変更しない）。
+// knownBlobDigests にある表現はブロブストアで再ハッシュしない。
+- (BOOL)writeContainerToPath:(NSString *)path
+            externalizeBlobs:(BOOL)externalizeBlobs
+            knownBlobDigests:(nullable NSDictionary<NSString *, NSString *> *)knownBlobDigests
+                 blobDigests:(NSArray<NSString *> * _Nullable * _Nullable)outBlobDigests {
+    RCClipContainerWriter *writer = RCClipContainerWriterCreate();
+    if (writer == NULL) {
+        return NO;
+    }
+    // writer はバイト列を借りるだけなので、書き終えるまでここで保持する。
+    NSMutableArray<NSData *> *retainedBuffers = [NSMutableArray array];
+    NSMutableArray<NSString *> *blobDigests = [NSMutableArray array];
+
+    BOOL added = [self addString:self.stringValue type:RCClipSectionString
+                        toWriter:writer retainedBuffers:retainedBuffers]
+        && [self addData:self.RTFData key:kRCClipDataRTFDataKey type:RCClipSectionRTF
+        externalizeBlobs:externalizeBlobs knownBlobDigests:knownBlobDigests
+                toWriter:writer retainedBuffers:retainedBuffers blobDigests:blobDigests]
+        && [self addData:self.RTFDData key:kRCClipDataRTFDDataKey type:RCClipSectionRTFD
+        externalizeBlobs:externalizeBlobs knownBlobDigests:knownBlobDigests
+                toWriter:writer retainedBuffers:retainedBuffers blobDigests:blobDigests]
+        && [self addData:self.PDFData key:kRCClipDataPDFDataKey type:RCClipSectionPDF
+        externalizeBlobs:externalizeBlobs knownBlobDigests:knownBlobDigests
+                toWriter:writer retainedBuffers:retainedBuffers blobDigests:blobDigests]
+        && [self addStrings:self.fileNames type:RCClipSectionFileNames toWriter:writer]
+        && [self addStrings:[self.fileURLs valueForKey:@"absoluteString"] type:RCClipSectionFileURLs toWriter:writer]
+        && [self addString:self.URLString type:RCClipSectionURL
+                  toWriter:writer retainedBuffers:retainedBuffers]
+        && [self addData:self.TIFFData key:kRCClipDataTIFFDataKey type:RCClipSectionTIFF
+        externalizeBlobs:externalizeBlobs knownBlobDigests:knownBlobDigests
+                toWriter:writer retainedBuffers:retainedBuffers blobDigests:blobDigests]
+        && [self addString:self.primaryType type:RCClipSectionPrimaryType
+                  toWriter:writer retainedBuffers:retainedBuffers];
+
+    // 一時ファイル（mkstemp なので 0600）に書いて rename するため、読み手は常に完全なファイルを見る。
+    RCClipContainerStatus status = added
+        ? RCClipContainerWriterWriteFile(writer, path.fileSystemRepresentation)
+        : RCClipContainerCorrupt;
+    RCClipContainerWriterDestroy(writer);
+    if (status != RCClipContainerOK) {
+        os_log_error(RCClipDataLog(),
+                     "Failed to save clip data at path %{private}@ (status %d)",
+                     path, (int)status);
+        return NO;
+    }
+    if (outBlobDigests != NULL) {
+        *outBlobDigests = [blobDigests copy];
+    }
+    return YES;
+}
+
+- (BOOL)addString:(nullable NSString *)string
+             type:(RCClipSectionType)type
+         toWriter:(RCClipContainerWriter *)writer
+  retainedBuffers:(NSMutableArray<NSData *> *)retainedBuffers {
+    if (string == nil) {
+        return YES;
+    }
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding allowLossyConversion:YES] ?: [NSData data];
+    [retainedBuffers addObject:data];
+    BOOL compress = [[NSUserDefaults standardUserDefaults] boolForKey:kRCPrefCompressClipDataKey];
+    return RCClipDataAddSection(writer, type, data, compress);
+}
+
+- (BOOL)addStrings:(nullable NSArray<NSString *> *)strings
+              type:(RCClipSectionType)type
+          toWriter:(RCClipContainerWriter *)writer {
+    if (strings == nil) {
+        return YES;
+    }
+    NSUInteger count = strings.count;
+    const char **items = calloc(MAX(count, 1u), sizeof(*items));
+    size_t *lengths = calloc(MAX(count, 1u), sizeof(*lengths));
+    if (items == NULL || lengths == NULL) {
+        free(items);
+        free(lengths);
+        return NO;
+    }
+    // UTF8String の寿命は autorelease プールまでだが、リストは追加時にコピーされる。
+    for (NSUInteger index = 0; index < count; index++) {
+        NSString *string = [strings[index] isKindOfClass:[NSString class]] ? strings[index] : @"";
+        items[index] = string.UTF8String ?: "";
+        lengths[index] = strlen(items[index]);
+    }
+    RCClipContainerStatus status = RCClipContainerWriterAddListSection(writer, type, items, lengths, count);
+    free(items);
+    free(lengths);
+    return status == RCClipContainerOK;
+}
+
+- (BOOL)addData:(nullable NSData *)data
+             key:(NSString *)key
+            type:(RCClipSectionType)type
+externalizeBlobs:(BOOL)externalizeBlobs
+knownBlobDigests:(nullable NSDictionary<NSString *, NSString *> *)knownBlobDigests
+        toWriter:(RCClipContainerWriter *)writer
+ retainedBuffers:(NSMutableArray<NSData *> *)retainedBuffers
+     blobDigests:(NSMutableArray<NSString *> *)blobDigests {
+    NSString *digest = nil;
+    if (data == nil) {
+        // 移行中のレガシーアーカイブは、ブロブを読み込まずに参照だけを引き継ぐ。
+        id reference = self.blobDigestsByKey[key];
+        if (reference == nil) {
+            return YES;
+        }
+        if (![reference isKindOfClass:[NSString class]]) {
+            return NO;
+        }
+        digest = reference;
+    } else if (externalizeBlobs && data.length >= kRCClipDataBlobMinimumLength) {
+        // ブロブに書けなければ（nil）その表現は従来どおり埋め込む。
+        digest = [[RCClipBlobStore shared] storeData:data digest:knownBlobDigests[key]];
+    }
+
+    if (digest != nil) {
+        NSData *reference = [digest dataUsingEncoding:NSUTF8StringEncoding];
+        [retainedBuffers addObject:reference];
+        if (![blobDigests containsObject:digest]) {
+            [blobDigests addObject:digest];
+        }
+        return RCClipContainerWriterAddSection(writer, type, RC_CLIP_SECTION_FLAG_BLOB_REFERENCE,
+                                               reference.bytes, reference.length) == RCClipContainerOK;
+    }
+    [retainedBuffers addObject:data];
+    BOOL compress = [[NSUserDefaults standardUserDefaults] boolForKey:kRCPrefCompressClipDataKey];
+    return RCClipDataAddSection(writer, type, data, compress);
+}
+
+#pragma mark - Legacy Archive
+
++ (nullable instancetype)clipDataFromLegacyArchiveAtPath:(NSString *)path {
+    struct stat fileStat;
+    if (stat(path.fileSystemRepresentation, &fileStat) != 0) {
+        return nil;
+    }
+
     NSError *readError = nil;
-    NSData *archiveData = [NSData dataWithContentsOfFile:canonicalPath options:0 error:&readError];
+    NSData *archiveData = [NSData dataWithContentsOfFile:path options:0 error:&readError];
     if (archiveData == nil) {
         return nil;
     }
@@ -400,37 +1182,163 @@ static os_log_t RCClipDataLog(void) {
     RCClipData *decodedObject = [NSKeyedUnarchiver unarchivedObjectOfClass:[RCClipData class]
                                                                    fromData:archiveData
                                                                       error:&unarchiveError];
-    if (decodedObject == nil && unarchiveError != nil) {
+    if (decodedObject == nil) {
+        if (unarchiveError != nil) {
+            os_log_error(RCClipDataLog(),
+                         "Failed to unarchive clip data at path %{private}@ (%{private}@)",
+                         path, unarchiveError.localizedDescription);
+        }
+        return nil;
+    }
+
+    // ブロブを読み込む前（参照のまま）の浅いコピーを渡し、次回からは必要な表現だけを読めるようにする。
+    [self migrateLegacyArchiveAtPath:path fileNumber:fileStat.st_ino clipData:[decodedObject shallowCopy]];
+
+    if (![decodedObject loadBlobsFromStore:[RCClipBlobStore shared]]) {
         os_log_error(RCClipDataLog(),
-                     "Failed to unarchive clip data at path %{private}@ (%{private}@)",
-                     canonicalPath, unarchiveError.localizedDescription);
+                     "Missing payload blob for clip data at path %{private}@",
+                     path);
+        return nil;
     }
     return decodedObject;
 }
 
+// 読んだ時点と同じファイル（inode）が残っているときだけ置き換える。削除や別の移行で
+// 消えた・変わったファイルを書き戻さないため。ブロブは新たに書き出さず、参照を引き継ぐので
+// clip_blob_refs の参照数は変わらない。
++ (void)migrateLegacyArchiveAtPath:(NSString *)path fileNumber:(ino_t)fileNumber clipData:(RCClipData *)clipData {
+    dispatch_async(RCClipDataMigrationQueue(), ^{
+        NSString *migrationPath = [[[path stringByDeletingPathExtension] stringByAppendingPathExtension:@"migrating"]
+                                   stringByAppendingPathExtension:path.pathExtension];
+        if (![clipData writeContainerToPath:migrationPath externalizeBlobs:NO knownBlobDigests:nil blobDigests:NULL]) {
+            return;
+        }
+
+        int fd = open(path.fileSystemRepresentation, O_WRONLY | O_CLOEXEC);
+        struct stat fileStat;
+        struct stat pathStat;
+        // 開いた後にパスが削除・差し替えられていれば rename で書き戻してしまうため、
+        // rename の直前にパスをもう一度 stat し、開いたファイルと同じときだけ置き換える。
+        if (fd < 0 || fstat(fd, &fileStat) != 0 || fileStat.st_ino != fileNumber
+            || stat(path.fileSystemRepresentation, &pathStat) != 0
+            || pathStat.st_ino != fileStat.st_ino || pathStat.st_dev != fileStat.st_dev
+            || rename(migrationPath.fileSystemRepresentation, path.fileSystemRepresentation) != 0) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            unlink(migrationPath.fileSystemRepresentation);
+            return;
+        }
+        RCClipDataZeroFillFile(fd, fileStat.st_size);
+        close(fd);
+        os_log_debug(RCClipDataLog(), "Migrated legacy clip archive at path %{private}@", path);
+    });
+}
+
+- (RCClipData *)shallowCopy {
+    RCClipData *copy = [[RCClipData alloc] init];
+    copy.stringValue = self.stringValue;
+    copy.RTFData = self.RTFData;
+    copy.RTFDData = self.RTFDData;
+    copy.PDFData = self.PDFData;
+    copy.fileNames = self.fileNames;
+    copy.fileURLs = self.fileURLs;
+    copy.URLString = self.URLString;
+    copy.TIFFData = self.TIFFData;
+    copy.primaryType = self.primaryType;
+    copy.blobDigestsByKey = self.blobDigestsByKey;
+    return copy;
+}
+
+#pragma mark - Blobs
+
++ (NSArray<NSString *> *)blobEligibleKeys {
+    return @[kRCClipDataRTFDataKey, kRCClipDataRTFDDataKey, kRCClipDataPDFDataKey, kRCClipDataTIFFDataKey];
+}
+
+- (BOOL)loadBlobsFromStore:(RCClipBlobStore *)blobStore {
+    NSDictionary<NSString *, NSString *> *digestsByKey = self.blobDigestsByKey;
+    if (digestsByKey.count == 0) {
+        return YES;
+    }
+
+    NSArray<NSString *> *eligibleKeys = [[self class] blobEligibleKeys];
+    for (NSString *key in digestsByKey) {
+        NSString *digest = digestsByKey[key];
+        if (![eligibleKeys containsObject:key] || ![digest isKindOfClass:[NSString class]]) {
+            return NO;
+        }
+        NSData *data = [blobStore dataForDigest:digest];
+        if (data == nil) {
+            return NO;
+        }
+        [self setValue:data forKey:key];
+    }
+    self.blobDigestsByKey = nil;
+    return YES;
+}
+
 #pragma mark - Helpers
 
 + (NSString *)sha256HexForDigest:(const unsigned char *)digest {
-    NSMutableString *hexString = [NSMutableString stringWithCapacity:CC_SHA256_DIGEST_LENGTH * 2];
-    for (NSUInteger index = 0; index < CC_SHA256_DIGEST_LENGTH; index++) {
-        [hexString appendFormat:@"%02x", digest[index]];
-    }
-    return [hexString copy];
+    return [RCUtilities hexStringFromBytes:digest length:RC_SHA256_DIGEST_LENGTH];
+}
+
++ (NSString *)sha256HexForData:(NSData *)data {
+    RCSHA256Context context;
+    RCSHA256Context *contextPointer = &context;
+    RCSHA256Init(contextPointer);
+    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+        (void)stop;
+        RCSHA256Update(contextPointer, bytes, byteRange.length);
+    }];
+    uint8_t digest[RC_SHA256_DIGEST_LENGTH];
+    RCSHA256Final(&context, digest);
+    return [self sha256HexForDigest:digest];
+}
+
++ (BOOL)updateHashContext:(RCSHA256Context *)context withData:(nullable NSData *)source {
+    return [self updateHashContext:context withData:source blobDigestKey:nil blobDigests:nil];
 }
 
-+ (BOOL)updateHashContext:(CC_SHA256_CTX *)context withData:(nullable NSData *)source {
++ (BOOL)updateHashContext:(RCSHA256Context *)context
+                 withData:(nullable NSData *)source
+            blobDigestKey:(nullable NSString *)blobDigestKey
+              blobDigests:(nullable NSMutableDictionary<NSString *, NSString *> *)blobDigests {
     if (source.length == 0) {
         return NO;
     }
 
     NSAssert(source.length <= UINT32_MAX, @"Source data length %lu exceeds uint32_t maximum", (unsigned long)source.length);
     uint32_t length = CFSwapInt32HostToBig((uint32_t)source.length);
-    CC_SHA256_Update(context, &length, (CC_LONG)sizeof(length));
-    CC_SHA256_Update(context, source.bytes, (CC_LONG)source.length);
+    RCSHA256Update(context, &length, sizeof(length));
+
+    // dataHash とブロブのダイジェストを同時に求めるときは、RCSHA256UpdateEach が
+    // キャッシュに収まる刻みで両方のコンテキストへ流すので、大きな表現もメモリからは 1 度しか読まない。
+    RCSHA256Context blobContext;
+    RCSHA256Context *contexts[2] = { context, NULL };
+    size_t contextCount = 1;
+    if (blobDigestKey != nil && blobDigests != nil && source.length >= kRCClipDataBlobMinimumLength) {
+        RCSHA256Init(&blobContext);
+        contexts[contextCount++] = &blobContext;
+    }
+    // 不連続な NSData（dispatch_data 由来など）も bytes で平坦化せず、範囲ごとに読む。
+    // C 配列はブロックに取り込めないのでポインタ経由で渡す。
+    RCSHA256Context *const *contextPointers = contexts;
+    [source enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+        (void)stop;
+        RCSHA256UpdateEach(contextPointers, contextCount, bytes, byteRange.length);
+    }];
+
+    if (contextCount > 1) {
+        uint8_t blobDigest[RC_SHA256_DIGEST_LENGTH];
+        RCSHA256Final(&blobContext, blobDigest);
+        blobDigests[blobDigestKey] = [self sha256HexForDigest:blobDigest];
+    }
     return YES;
 }
 
-+ (BOOL)updateHashContext:(CC_SHA256_CTX *)context withString:(nullable NSString *)string {
++ (BOOL)updateHashContext:(RCSHA256Context *)context withString:(nullable NSString *)string {
     if (string.length == 0) {
         return NO;
     }
@@ -438,6 +1346,49 @@ static os_log_t RCClipDataLog(void) {
     return [self updateHashContext:context withData:data];
 }
 
++ (BOOL)updateHashContext:(RCSHA256Context *)context
+                  section:(RCClipSectionType)section
+                 withData:(nullable NSData *)source
+            blobDigestKey:(nullable NSString *)blobDigestKey
+              blobDigests:(nullable NSMutableDictionary<NSString *, NSString *> *)blobDigests {
+    if (source.length == 0) {
+        return NO;
+    }
+    uint8_t tag = (uint8_t)section;
+    RCSHA256Update(context, &tag, sizeof(tag));
+    return [self updateHashContext:context withData:source blobDigestKey:blobDigestKey blobDigests:blobDigests];
+}
+
++ (BOOL)updateHashContext:(RCSHA256Context *)context section:(RCClipSectionType)section withString:(nullable NSString *)string {
+    if (string.length == 0) {
+        return NO;
+    }
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    return [self updateHashContext:context section:section withData:data blobDigestKey:nil blobDigests:nil];
+}
+
+// リストは要素数の後に各要素を (長さ, 中身) で並べる。空の要素も長さ 0 として数える。
++ (BOOL)updateHashContext:(RCSHA256Context *)context
+                  section:(RCClipSectionType)section
+              withStrings:(nullable NSArray<NSString *> *)strings {
+    if (strings.count == 0) {
+        return NO;
+    }
+    NSAssert(strings.count <= UINT32_MAX, @"String list count %lu exceeds uint32_t maximum", (unsigned long)strings.count);
+    uint8_t tag = (uint8_t)section;
+    RCSHA256Update(context, &tag, sizeof(tag));
+    uint32_t count = CFSwapInt32HostToBig((uint32_t)strings.count);
+    RCSHA256Update(context, &count, sizeof(count));
+    for (NSString *string in strings) {
+        NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding] ?: [NSData data];
+        NSAssert(data.length <= UINT32_MAX, @"String length %lu exceeds uint32_t maximum", (unsigned long)data.length);
+        uint32_t length = CFSwapInt32HostToBig((uint32_t)data.length);
+        RCSHA256Update(context, &length, sizeof(length));
+        RCSHA256Update(context, data.bytes, data.length);
+    }
+    return YES;
+}
+
 + (NSString *)standardizedPath:(NSString *)path {
     if (path.length == 0) {
         return @"";
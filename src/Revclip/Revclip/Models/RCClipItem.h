@@ -9,7 +9,7 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@interface RCClipItem : NSObject
+@interface RCClipItem : NSObject <NSCopying>
 
 @property (nonatomic, assign) NSInteger itemId;
 @property (nonatomic, copy) NSString *dataPath;
@@ -19,6 +19,10 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, assign) NSInteger updateTime;
 @property (nonatomic, copy) NSString *thumbnailPath;
 @property (nonatomic, assign) BOOL isColorCode;
+// clip_search に索引するプレーンテキスト。挿入時にのみ使い、DB からは復元しない。
+@property (nonatomic, copy, nullable) NSString *searchText;
+// .rcclip が参照するブロブのダイジェスト（16 進）。挿入時に clip_blob_refs へ登録する。
+@property (nonatomic, copy, nullable) NSArray<NSString *> *blobDigests;
 
 // NSDictionaryからの初期化
 - (instancetype)initWithDictionary:(NSDictionary *)dict;
@@ -100,6 +100,21 @@ static BOOL RCBoolValueForKeys(NSDictionary *dictionary, NSArray<NSString *> *ke
     return self;
 }
 
+- (id)copyWithZone:(NSZone *)zone {
+    RCClipItem *copy = [[[self class] allocWithZone:zone] init];
+    copy.itemId = self.itemId;
+    copy.dataPath = self.dataPath;
+    copy.title = self.title;
+    copy.dataHash = self.dataHash;
+    copy.primaryType = self.primaryType;
+    copy.updateTime = self.updateTime;
+    copy.thumbnailPath = self.thumbnailPath;
+    copy.isColorCode = self.isColorCode;
+    copy.searchText = self.searchText;
+    copy.blobDigests = self.blobDigests;
+    return copy;
+}
+
 - (BOOL)isEqual:(id)object {
     if (self == object) {
         return YES;
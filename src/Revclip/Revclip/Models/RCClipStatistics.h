@@ -0,0 +1,22 @@
+//
+//  RCClipStatistics.h
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// clip_stats（clip_items のトリガーで更新される集計）のスナップショット。
+@interface RCClipStatistics : NSObject
+
+@property (nonatomic, assign) NSInteger itemCount;
+// .rcclip ファイルの合計バイト数（サムネイルは含まない）
+@property (nonatomic, assign) long long totalDataSize;
+@property (nonatomic, copy) NSDictionary<NSString *, NSNumber *> *itemCountsByPrimaryType;
+
+@end
+
+NS_ASSUME_NONNULL_END
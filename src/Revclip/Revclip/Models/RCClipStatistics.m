@@ -0,0 +1,20 @@
+//
+//  RCClipStatistics.m
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#import "RCClipStatistics.h"
+
+@implementation RCClipStatistics
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _itemCountsByPrimaryType = @{};
+    }
+    return self;
+}
+
+@end
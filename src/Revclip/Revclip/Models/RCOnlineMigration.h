@@ -0,0 +1,50 @@
+//
+//  RCOnlineMigration.h
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// 起動後に少しずつ進める行単位の移行（RCDatabaseManager が実行する）。
+// id 順に batchSize 行ずつ読み出し、transform で updateSQL の引数に変え、
+// online_migrations のチェックポイントと同じ短いトランザクションでコミットする。
+// 中断しても次回はチェックポイントの次の行から再開する。
+//
+// 移行中もキャプチャは続くため、登録後に追加される行は最初から新しい形式で書くこと。
+// そうした行もチェックポイントより後ろなら読み出されるので、updateSQL は
+// 移行済みの行に対して何もしない（冪等な）文にする。
+@interface RCOnlineMigration : NSObject
+
+- (instancetype)initWithName:(NSString *)name
+                   selectSQL:(NSString *)selectSQL
+                   updateSQL:(NSString *)updateSQL NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+// online_migrations.name。一度出荷した名前は変えない。
+@property (nonatomic, copy, readonly) NSString *name;
+// 引数 (チェックポイントの id, 件数)。先頭列に id を返し、id 昇順で並べる。
+@property (nonatomic, copy, readonly) NSString *selectSQL;
+@property (nonatomic, copy, readonly) NSString *updateSQL;
+// 引数 (チェックポイントの id)。残りの行数を返す。nil なら進捗は行数で報告しない。
+@property (nonatomic, copy, nullable) NSString *countSQL;
+// 1 トランザクションで書き込む行数。既定 200。
+@property (nonatomic, assign) NSInteger batchSize;
+// DB キューの外で 1 行ずつ呼ばれ、updateSQL の引数を返す（.rcclip の読み込みなどはここで行う）。
+// nil を返した行は書き込まない。未設定なら行の値をそのまま引数にする。
+@property (nonatomic, copy, nullable) NSArray * _Nullable (^transform)(NSArray *row);
+// バッチをコミットした後、次のバッチまで休む秒数。.rcclip を読むような重い移行で
+// キャプチャにディスクと CPU を譲る。既定 0。
+@property (nonatomic, assign) NSTimeInterval batchInterval;
+// 行を書き換えたトランザクションの中（DB キュー上）で、変更のあった行ごとに
+// updateSQL の引数を渡して呼ばれる。行の値を写したメモリ上の索引を追従させるのに使う。
+@property (nonatomic, copy, nullable) void (^didUpdateRow)(NSArray *arguments);
+// 最後のバッチ（completed）をコミットした後に呼ばれる。
+@property (nonatomic, copy, nullable) void (^didFinish)(void);
+
+@end
+
+NS_ASSUME_NONNULL_END
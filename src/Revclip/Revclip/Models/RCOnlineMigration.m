@@ -0,0 +1,27 @@
+//
+//  RCOnlineMigration.m
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#import "RCOnlineMigration.h"
+
+static NSInteger const kRCOnlineMigrationDefaultBatchSize = 200;
+
+@implementation RCOnlineMigration
+
+- (instancetype)initWithName:(NSString *)name
+                   selectSQL:(NSString *)selectSQL
+                   updateSQL:(NSString *)updateSQL {
+    self = [super init];
+    if (self) {
+        _name = [name copy];
+        _selectSQL = [selectSQL copy];
+        _updateSQL = [updateSQL copy];
+        _batchSize = kRCOnlineMigrationDefaultBatchSize;
+    }
+    return self;
+}
+
+@end
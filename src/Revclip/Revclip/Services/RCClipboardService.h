@@ -9,6 +9,8 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@protocol RCPasteboardProvider;
+
 @interface RCClipboardService : NSObject
 
 + (instancetype)shared;
@@ -18,15 +20,24 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)stopMonitoring;
 @property (atomic, readonly) BOOL isMonitoring;
 
+// 監視するペーストボードとコピー元アプリの取得先（既定は RCSystemPasteboardProvider）。
+// 差し替えは監視を止めている間に行う（startMonitoring で changeCount を読み直す）。
+@property (atomic, strong) id<RCPasteboardProvider> pasteboardProvider;
+
 // 内部ペースト操作中フラグ（RCPasteService がペースト中にクリップボード変更検知を抑制する）
 @property (atomic, assign) BOOL isPastingInternally;
 
 // 手動での最新クリップ取得
 - (void)captureCurrentClipboard;
 
-// Panic Erase 用: monitoringQueue までの処理をドレイン
+// Panic Erase 用: それまでに受け付けたキャプチャ（バーストで保持中の状態を含む）がパイプラインの最後（index 段）まで終わるのを待つ
 - (void)flushQueueWithCompletion:(void(^)(void))completion;
 
+// 診断: キャプチャパイプラインの段ごと（snapshot / fingerprint / persist / index）のキュー待ち・実行時間（マイクロ秒）の JSON。
+// blockedAdmissions は fingerprint 段の空きを待ったキャプチャ数、burst は合流したバースト数と捨てた途中の状態数
+- (nullable NSData *)captureMetricsJSONData;
+- (void)resetCaptureMetrics;
+
 @end
 
 // 通知名
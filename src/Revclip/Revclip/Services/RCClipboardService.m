@@ -13,18 +13,29 @@
 #import "RCExcludeAppService.h"
 #import "RCDataCleanService.h"
 #import "RCDatabaseManager.h"
+#import "RCHotKeyService.h"
 #import "RCPanicEraseService.h"
+#import "RCPasteboardProvider.h"
 #import "RCClipData.h"
 #import "RCClipItem.h"
 #import "NSColor+HexString.h"
 #import "RCUtilities.h"
+#import "RCBurstCoalescer.h"
+#import "RCCapturePlan.h"
+#import "RCCaptureSequencer.h"
+#import "RCPollScheduler.h"
+#import "RCQueryMetrics.h"
+#import "RCTrace.h"
 #import <os/log.h>
+#import <time.h>
 
 NSString * const RCClipboardDidChangeNotification = @"RCClipboardDidChangeNotification";
 
-static NSTimeInterval const kRCClipboardPollingInterval = 0.5;
-static NSInteger const kRCDefaultMaxClipSizeBytes = 52428800;
 static NSString * const kRCClipDataFileExtension = @"rcclip";
+// 段ごとに抱えられる件数。満杯になると前段が待つ（背圧）。
+static size_t const kRCCaptureFingerprintCapacity = 4;
+static long const kRCCapturePersistCapacity = 2;
+static long const kRCCaptureIndexCapacity = 4;
 static NSString * const kRCStoreTypeString = @"String";
 static NSString * const kRCStoreTypeRTF = @"RTF";
 static NSString * const kRCStoreTypeRTFD = @"RTFD";
@@ -42,14 +53,90 @@ static os_log_t RCClipboardServiceLog(void) {
     return logger;
 }
 
-@interface RCClipboardService ()
+// キャプチャパイプラインの段。キュー待ちと実行時間を段ごとに RCQueryMetrics へ記録する。
+// 値は RCQueryMetricsRegisterOperation の戻り値と一致させるため、登録は列挙順に行う。
+typedef NS_ENUM(int, RCCaptureStage) {
+    RCCaptureStageSnapshot = 0,
+    RCCaptureStageFingerprint,
+    RCCaptureStagePersist,
+    RCCaptureStageIndex,
+    RCCaptureStageCount,
+};
+
+static const char * const kRCCaptureStageNames[RCCaptureStageCount] = {
+    [RCCaptureStageSnapshot] = "snapshot",
+    [RCCaptureStageFingerprint] = "fingerprint",
+    [RCCaptureStagePersist] = "persist",
+    [RCCaptureStageIndex] = "index",
+};
+
+// dispatch_time(DISPATCH_TIME_NOW, ...) と同じ時計（スリープ中は進まない）
+static uint64_t RCClipboardMonotonicNanoseconds(void) {
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+// パイプラインを流れる 1 件分のキャプチャ。段を進むごとにフィールドが埋まる。
+@interface RCCaptureJob : NSObject
+
+@property (nonatomic, strong) RCClipData *clipData;
+@property (nonatomic, copy) NSString *sourceBundleIdentifier;
+// スナップショット時に確定させ、履歴の順序をコピーした順に保つ
+@property (nonatomic, assign) NSInteger updateTime;
+@property (nonatomic, assign) uint64_t sequence;
+// 現在の段のキューに入った時刻（キュー待ちの計測用）
+@property (nonatomic, assign) uint64_t enqueuedNanoseconds;
+@property (nonatomic, strong, nullable) RCClipDataDigests *digests;
+@property (nonatomic, assign) BOOL isColorCode;
+// 既存（または索引待ち）の同一クリップ。index 段では update_time の更新になる。
+@property (nonatomic, strong, nullable) RCClipItem *existingClipItem;
+// persist 段で保存した新規クリップ。index 段で DB に登録する。
+@property (nonatomic, strong, nullable) RCClipItem *clipItem;
+// RCTrace のスパンを 1 件のキャプチャにまとめる番号と、変化を検出したポーリングの開始時刻。
+// トレースが無効なときに検出したキャプチャはどちらも 0。
+@property (nonatomic, assign) uint64_t traceId;
+@property (nonatomic, assign) uint64_t detectedNanoseconds;
+
+@end
+
+@implementation RCCaptureJob
+@end
+
+@interface RCClipboardService () {
+    // monitoringQueue 上でのみ読み書きする
+    RCPollScheduler _pollScheduler;
+    // monitoringQueue 上でのみ読み書きする。保持中の項目は __bridge_retained した RCCaptureJob
+    RCBurstCoalescer _burstCoalescer;
+    // monitoringQueue 上でのみ読み書きする。最後に割り当てた RCCaptureJob.traceId
+    uint64_t _lastTraceId;
+    // @synchronized (self) で読み書きする
+    RCCapturePlan _capturePlan;
+}
 
 @property (atomic, readwrite, assign) BOOL isMonitoring;
 @property (nonatomic, strong, nullable) dispatch_source_t monitorTimer;
+@property (nonatomic, strong, nullable) id defaultsObserver;
+@property (atomic, assign) BOOL capturePlanNeedsRebuild;
+@property (nonatomic, copy, nullable) NSArray<id> *activityObservers;
+@property (nonatomic, copy, nullable) NSArray<id> *workspaceActivityObservers;
 @property (nonatomic, strong) dispatch_queue_t monitoringQueue;
 @property (nonatomic, strong) dispatch_queue_t fileOperationQueue;
 @property (nonatomic, assign) NSInteger cachedChangeCount;
 
+// キャプチャパイプライン: snapshot（メイン）→ fingerprint（ワーカープール）→ persist（I/O）→ index
+@property (nonatomic, strong) dispatch_queue_t fingerprintQueue;
+@property (nonatomic, strong) dispatch_queue_t sequencerQueue;
+@property (nonatomic, strong) dispatch_queue_t persistQueue;
+@property (nonatomic, strong) dispatch_queue_t indexQueue;
+@property (nonatomic, strong) dispatch_semaphore_t persistSlots;
+@property (nonatomic, strong) dispatch_semaphore_t indexSlots;
+@property (nonatomic, assign) RCCaptureSequencer *captureSequencer;
+@property (nonatomic, assign) RCQueryMetrics *captureMetrics;
+// persist 済みで index 段の登録を待っているクリップ（dataHash → clipItem）
+@property (nonatomic, strong) NSMutableDictionary<NSString *, RCClipItem *> *inFlightClipItems;
+// _burstCoalescer のカウンタの写し（診断用に monitoringQueue の外から読む）
+@property (atomic, assign) uint64_t coalescedBurstCount;
+@property (atomic, assign) uint64_t droppedBurstStateCount;
+
 - (NSInteger)readGeneralPasteboardChangeCount;
 
 @end
@@ -71,7 +158,34 @@ static os_log_t RCClipboardServiceLog(void) {
         _isMonitoring = NO;
         _monitoringQueue = dispatch_queue_create("com.revclip.clipboard.monitoring", DISPATCH_QUEUE_SERIAL);
         _fileOperationQueue = dispatch_queue_create("com.revclip.clipboard.file", DISPATCH_QUEUE_SERIAL);
+        _pasteboardProvider = [RCSystemPasteboardProvider shared];
         _cachedChangeCount = [self readGeneralPasteboardChangeCount];
+        _capturePlanNeedsRebuild = YES;
+        RCBurstCoalescerConfiguration burstConfiguration = RCBurstCoalescerDefaultConfiguration();
+        RCBurstCoalescerInit(&_burstCoalescer, &burstConfiguration);
+        __weak typeof(self) weakSelf = self;
+        _defaultsObserver = [[NSNotificationCenter defaultCenter] addObserverForName:NSUserDefaultsDidChangeNotification
+                                                                              object:nil
+                                                                               queue:nil
+                                                                          usingBlock:^(NSNotification *notification) {
+            (void)notification;
+            weakSelf.capturePlanNeedsRebuild = YES;
+        }];
+
+        dispatch_queue_attr_t utilityAttributes = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_CONCURRENT,
+                                                                                           QOS_CLASS_UTILITY, 0);
+        _fingerprintQueue = dispatch_queue_create("com.revclip.clipboard.fingerprint", utilityAttributes);
+        _sequencerQueue = dispatch_queue_create("com.revclip.clipboard.sequencer", DISPATCH_QUEUE_SERIAL);
+        _persistQueue = dispatch_queue_create("com.revclip.clipboard.persist", DISPATCH_QUEUE_SERIAL);
+        _indexQueue = dispatch_queue_create("com.revclip.clipboard.index", DISPATCH_QUEUE_SERIAL);
+        _persistSlots = dispatch_semaphore_create(kRCCapturePersistCapacity);
+        _indexSlots = dispatch_semaphore_create(kRCCaptureIndexCapacity);
+        _captureSequencer = RCCaptureSequencerCreate(kRCCaptureFingerprintCapacity);
+        _inFlightClipItems = [NSMutableDictionary dictionary];
+        _captureMetrics = RCQueryMetricsCreate();
+        for (int stage = 0; stage < RCCaptureStageCount; stage++) {
+            RCQueryMetricsRegisterOperation(_captureMetrics, kRCCaptureStageNames[stage]);
+        }
     }
     return self;
 }
@@ -86,6 +200,22 @@ static os_log_t RCClipboardServiceLog(void) {
     if (timer != nil) {
         dispatch_source_cancel(timer);
     }
+    for (id observer in _activityObservers) {
+        [[NSNotificationCenter defaultCenter] removeObserver:observer];
+    }
+    if (_defaultsObserver != nil) {
+        [[NSNotificationCenter defaultCenter] removeObserver:_defaultsObserver];
+    }
+    for (id observer in _workspaceActivityObservers) {
+        [[NSWorkspace sharedWorkspace].notificationCenter removeObserver:observer];
+    }
+    void *heldItems[RC_BURST_COALESCER_MAX_KEEP];
+    size_t heldCount = RCBurstCoalescerFlush(&_burstCoalescer, heldItems);
+    for (size_t index = 0; index < heldCount; index++) {
+        CFRelease(heldItems[index]);
+    }
+    RCCaptureSequencerDestroy(_captureSequencer);
+    RCQueryMetricsDestroy(_captureMetrics);
 }
 
 #pragma mark - Public
@@ -102,13 +232,10 @@ static os_log_t RCClipboardServiceLog(void) {
         }
 
         self.cachedChangeCount = [self readGeneralPasteboardChangeCount];
-        uint64_t interval = (uint64_t)(kRCClipboardPollingInterval * (double)NSEC_PER_SEC);
-        uint64_t leeway = interval / 10;
 
-        dispatch_source_set_timer(timer,
-                                  dispatch_time(DISPATCH_TIME_NOW, (int64_t)interval),
-                                  interval,
-                                  leeway);
+        // 単発タイマーとして使い、ポーリングのたびに RCPollScheduler が決めた次の時刻へ張り直す。
+        // 最初の時刻は monitoringQueue 上でスケジューラを初期化してから設定する。
+        dispatch_source_set_timer(timer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
 
         __weak typeof(self) weakSelf = self;
         dispatch_source_set_event_handler(timer, ^{
@@ -116,12 +243,24 @@ static os_log_t RCClipboardServiceLog(void) {
             if (strongSelf == nil) {
                 return;
             }
-            [strongSelf pollPasteboardOnMonitoringQueue];
+            [strongSelf handlePollTimerOnMonitoringQueue];
         });
 
         self.monitorTimer = timer;
         self.isMonitoring = YES;
         dispatch_resume(timer);
+
+        dispatch_async(self.monitoringQueue, ^{
+            __strong typeof(weakSelf) strongSelf = weakSelf;
+            if (strongSelf == nil) {
+                return;
+            }
+            RCPollSchedulerConfiguration configuration = RCPollSchedulerDefaultConfiguration();
+            RCPollSchedulerInit(&strongSelf->_pollScheduler, &configuration, RCClipboardMonotonicNanoseconds());
+            [strongSelf armPollTimerOnMonitoringQueue];
+        });
+
+        [self startObservingActivity];
     }
 }
 
@@ -136,11 +275,17 @@ static os_log_t RCClipboardServiceLog(void) {
         timer = self.monitorTimer;
         self.monitorTimer = nil;
         self.isMonitoring = NO;
+        [self stopObservingActivity];
     }
 
     if (timer != nil) {
         dispatch_source_cancel(timer);
     }
+
+    // 落ち着くのを待っていたバーストの最後の状態は捨てずに保存する
+    dispatch_async(self.monitoringQueue, ^{
+        [self releaseHeldBurstStatesOnMonitoringQueue:YES];
+    });
 }
 
 - (void)captureCurrentClipboard {
@@ -152,11 +297,65 @@ static os_log_t RCClipboardServiceLog(void) {
     });
 }
 
+// 段を順にたどり、それまでに受け付けたキャプチャが index 段まで終わってから completion を呼ぶ。
 - (void)flushQueueWithCompletion:(void(^)(void))completion {
     dispatch_async(self.monitoringQueue, ^{
-        if (completion != nil) {
-            completion();
-        }
+        // バーストで保持している状態もパイプラインに流してから待つ
+        [self releaseHeldBurstStatesOnMonitoringQueue:YES];
+        dispatch_barrier_async(self.fingerprintQueue, ^{
+            dispatch_async(self.sequencerQueue, ^{
+                dispatch_async(self.persistQueue, ^{
+                    dispatch_async(self.indexQueue, ^{
+                        if (completion != nil) {
+                            completion();
+                        }
+                    });
+                });
+            });
+        });
+    });
+}
+
+- (nullable NSData *)captureMetricsJSONData {
+    NSMutableDictionary<NSString *, NSDictionary *> *stages = [NSMutableDictionary dictionary];
+    size_t stageCount = RCQueryMetricsOperationCount(self.captureMetrics);
+    for (size_t index = 0; index < stageCount; index++) {
+        RCLatencySnapshot queueWait;
+        RCLatencySnapshot execution;
+        RCQueryMetricsOperationSnapshot(self.captureMetrics, index, &queueWait, &execution);
+        stages[@(RCQueryMetricsOperationName(self.captureMetrics, index))] = @{
+            @"queueWait": [RCUtilities dictionaryFromLatencySnapshot:&queueWait],
+            @"execution": [RCUtilities dictionaryFromLatencySnapshot:&execution],
+        };
+    }
+
+    NSDictionary *report = @{
+        @"generatedAt": @((long long)([[NSDate date] timeIntervalSince1970] * 1000)),
+        @"bucketUpperBoundsMicroseconds": [RCUtilities latencyBucketUpperBoundsMicroseconds],
+        @"blockedAdmissions": @(RCCaptureSequencerBlockedAdmissionCount(self.captureSequencer)),
+        @"burst": @{
+            @"bursts": @(self.coalescedBurstCount),
+            @"droppedStates": @(self.droppedBurstStateCount),
+        },
+        @"stages": stages,
+    };
+    NSError *error = nil;
+    NSData *data = [NSJSONSerialization dataWithJSONObject:report
+                                                   options:NSJSONWritingPrettyPrinted | NSJSONWritingSortedKeys
+                                                     error:&error];
+    if (data == nil) {
+        os_log_error(RCClipboardServiceLog(),
+                     "Failed to serialize capture metrics (%{public}@)",
+                     error.localizedDescription);
+    }
+    return data;
+}
+
+- (void)resetCaptureMetrics {
+    RCQueryMetricsReset(self.captureMetrics);
+    dispatch_async(self.monitoringQueue, ^{
+        RCBurstCoalescerResetCounters(&self->_burstCoalescer);
+        [self publishBurstCountersOnMonitoringQueue];
     });
 }
 
@@ -164,118 +363,236 @@ static os_log_t RCClipboardServiceLog(void) {
 
 - (NSInteger)readGeneralPasteboardChangeCount {
     if ([NSThread isMainThread]) {
-        return [NSPasteboard generalPasteboard].changeCount;
+        return self.pasteboardProvider.generalPasteboard.changeCount;
     }
 
     __block NSInteger changeCount = 0;
     dispatch_sync(dispatch_get_main_queue(), ^{
-        changeCount = [NSPasteboard generalPasteboard].changeCount;
+        changeCount = self.pasteboardProvider.generalPasteboard.changeCount;
     });
     return changeCount;
 }
 
-- (void)pollPasteboardOnMonitoringQueue {
+- (void)handlePollTimerOnMonitoringQueue {
     if (!self.isMonitoring) {
         return;
     }
 
+    uint64_t tickTraceBegin = RCTraceBegin();
+    BOOL changed = [self pollPasteboardOnMonitoringQueueWithTraceBegin:tickTraceBegin];
+    RCPollSchedulerRecordPoll(&_pollScheduler, RCClipboardMonotonicNanoseconds(), changed);
+    [self releaseHeldBurstStatesOnMonitoringQueue:NO];
+    RCTraceEnd("poll tick", tickTraceBegin, 0);
+    [self armPollTimerOnMonitoringQueue];
+}
+
+- (void)armPollTimerOnMonitoringQueue {
+    dispatch_source_t timer = nil;
+    @synchronized (self) {
+        timer = self.monitorTimer;
+    }
+    if (timer == nil) {
+        return;
+    }
+
+    uint64_t now = RCClipboardMonotonicNanoseconds();
+    uint64_t nextPoll = RCPollSchedulerNextPollNanoseconds(&_pollScheduler);
+    uint64_t settleDeadline = RCBurstCoalescerSettleDeadline(&_burstCoalescer);
+    if (settleDeadline != 0 && settleDeadline < nextPoll) {
+        nextPoll = settleDeadline;
+    }
+    uint64_t delay = nextPoll > now ? nextPoll - now : 0;
+    dispatch_source_set_timer(timer,
+                              dispatch_time(DISPATCH_TIME_NOW, (int64_t)delay),
+                              DISPATCH_TIME_FOREVER,
+                              RCPollSchedulerLeewayNanoseconds(&_pollScheduler));
+}
+
+// ホットキー・アプリ切り替え・スリープ復帰の直後はコピーが起きやすいので、すぐに 1 回ポーリングして
+// 短い間隔に戻す。アイドル時は間隔が数秒まで伸びている。
+- (void)noteActivityOnMonitoringQueue {
+    if (!self.isMonitoring) {
+        return;
+    }
+    if (RCPollSchedulerNoteActivity(&_pollScheduler, RCClipboardMonotonicNanoseconds())) {
+        [self armPollTimerOnMonitoringQueue];
+    }
+}
+
+- (void)startObservingActivity {
+    __weak typeof(self) weakSelf = self;
+    void (^handler)(NSNotification *) = ^(NSNotification *notification) {
+        (void)notification;
+        __strong typeof(weakSelf) strongSelf = weakSelf;
+        if (strongSelf == nil) {
+            return;
+        }
+        dispatch_async(strongSelf.monitoringQueue, ^{
+            [strongSelf noteActivityOnMonitoringQueue];
+        });
+    };
+
+    NSMutableArray<id> *observers = [NSMutableArray array];
+    NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+    for (NSString *name in @[
+        RCHotKeyMainTriggeredNotification,
+        RCHotKeyHistoryTriggeredNotification,
+        RCHotKeySnippetTriggeredNotification,
+        RCHotKeySnippetFolderTriggeredNotification,
+    ]) {
+        [observers addObject:[center addObserverForName:name object:nil queue:nil usingBlock:handler]];
+    }
+    self.activityObservers = observers;
+
+    NSMutableArray<id> *workspaceObservers = [NSMutableArray array];
+    NSNotificationCenter *workspaceCenter = [NSWorkspace sharedWorkspace].notificationCenter;
+    for (NSString *name in @[
+        NSWorkspaceDidActivateApplicationNotification,
+        NSWorkspaceDidWakeNotification,
+        NSWorkspaceScreensDidWakeNotification,
+        NSWorkspaceSessionDidBecomeActiveNotification,
+    ]) {
+        [workspaceObservers addObject:[workspaceCenter addObserverForName:name object:nil queue:nil usingBlock:handler]];
+    }
+    self.workspaceActivityObservers = workspaceObservers;
+}
+
+- (void)stopObservingActivity {
+    for (id observer in self.activityObservers) {
+        [[NSNotificationCenter defaultCenter] removeObserver:observer];
+    }
+    for (id observer in self.workspaceActivityObservers) {
+        [[NSWorkspace sharedWorkspace].notificationCenter removeObserver:observer];
+    }
+    self.activityObservers = nil;
+    self.workspaceActivityObservers = nil;
+}
+
+// changeCount が前回から変わっていれば YES を返す（RCPollScheduler の入力）。
+// traceBegin はポーリングの開始時刻（RCTraceBegin、無効なら 0）で、キャプチャの検出時刻になる。
+- (BOOL)pollPasteboardOnMonitoringQueueWithTraceBegin:(uint64_t)traceBegin {
     // G3-004: 内部ペースト操作中はポーリングをスキップして重複登録を防ぐ
     if (self.isPastingInternally) {
-        return;
+        return NO;
     }
 
     // G3-001: NSPasteboard の読み取りをメインキューで実行
     __block NSInteger currentChangeCount = 0;
     __block RCClipData *clipData = nil;
     __block NSString *capturedBundleIdentifier = @"";
-    __block BOOL shouldSkipConcealedOrTransient = NO;
+    __block uint64_t snapshotStarted = 0;
+    RCCapturePlan plan = [self currentCapturePlan];
+    // 番号は変化を検出したときだけ確定させる
+    uint64_t traceId = traceBegin != 0 ? _lastTraceId + 1 : 0;
+    uint64_t snapshotEnqueued = RCQueryMetricsNowNanoseconds();
     dispatch_sync(dispatch_get_main_queue(), ^{
-        NSPasteboard *pasteboard = [NSPasteboard generalPasteboard];
+        id<RCPasteboardProvider> provider = self.pasteboardProvider;
+        id<RCPasteboard> pasteboard = provider.generalPasteboard;
         currentChangeCount = pasteboard.changeCount;
 
         if (currentChangeCount == self.cachedChangeCount) {
             return;
         }
+        snapshotStarted = RCQueryMetricsNowNanoseconds();
+        uint64_t snapshotTraceBegin = RCTraceBegin();
 
-        NSRunningApplication *frontmostApplication = [NSWorkspace sharedWorkspace].frontmostApplication;
-        capturedBundleIdentifier = frontmostApplication.bundleIdentifier ?: @"";
-
-        NSArray<NSString *> *concealedTypes = @[
-            @"org.nspasteboard.ConcealedType",
-            @"org.nspasteboard.TransientType",
-            @"org.nspasteboard.AutoGeneratedType",
-        ];
-        for (NSString *type in concealedTypes) {
-            if ([pasteboard dataForType:type] != nil) {
-                shouldSkipConcealedOrTransient = YES;
-                break;
-            }
-        }
-
-        if (!shouldSkipConcealedOrTransient) {
-            clipData = [RCClipData clipDataFromPasteboard:pasteboard];
-        }
+        capturedBundleIdentifier = provider.frontmostApplicationBundleIdentifier ?: @"";
+        clipData = [self snapshotPasteboard:pasteboard plan:&plan];
+        RCTraceEnd("snapshot", snapshotTraceBegin, traceId);
     });
     if (currentChangeCount == self.cachedChangeCount) {
-        return;
+        return NO;
     }
     self.cachedChangeCount = currentChangeCount;
+    if (traceId != 0) {
+        _lastTraceId = traceId;
+    }
+    // 変化が無いときの changeCount 読み取りは記録しない
+    [self recordCaptureStage:RCCaptureStageSnapshot enqueued:snapshotEnqueued started:snapshotStarted];
 
-    if (shouldSkipConcealedOrTransient) {
-        return;
+    if (clipData == nil) {
+        return YES;
     }
 
-    [self processClipDataOnMonitoringQueue:clipData
-                  sourceBundleIdentifier:capturedBundleIdentifier];
+    RCCaptureJob *job = [self captureJobWithClipData:clipData sourceBundleIdentifier:capturedBundleIdentifier];
+    job.traceId = traceId;
+    job.detectedNanoseconds = traceBegin;
+    [self offerCaptureJobOnMonitoringQueue:job];
+    return YES;
 }
 
 - (void)captureCurrentClipboardOnMonitoringQueue {
+    // 手動の取得より前に起きたバーストの状態を先に流し、履歴の順序を保つ
+    [self releaseHeldBurstStatesOnMonitoringQueue:YES];
+
     // G3-001: NSPasteboard の読み取りをメインキューで実行
     __block RCClipData *clipData = nil;
     __block NSString *capturedBundleIdentifier = @"";
-    __block BOOL shouldSkipConcealedOrTransient = NO;
+    __block uint64_t snapshotStarted = 0;
+    RCCapturePlan plan = [self currentCapturePlan];
+    uint64_t traceBegin = RCTraceBegin();
+    uint64_t traceId = traceBegin != 0 ? ++_lastTraceId : 0;
+    uint64_t snapshotEnqueued = RCQueryMetricsNowNanoseconds();
     dispatch_sync(dispatch_get_main_queue(), ^{
-        NSPasteboard *pasteboard = [NSPasteboard generalPasteboard];
+        snapshotStarted = RCQueryMetricsNowNanoseconds();
+        uint64_t snapshotTraceBegin = RCTraceBegin();
+        id<RCPasteboardProvider> provider = self.pasteboardProvider;
+        id<RCPasteboard> pasteboard = provider.generalPasteboard;
         self.cachedChangeCount = pasteboard.changeCount;
+        clipData = [self snapshotPasteboard:pasteboard plan:&plan];
 
-        NSArray<NSString *> *concealedTypes = @[
-            @"org.nspasteboard.ConcealedType",
-            @"org.nspasteboard.TransientType",
-            @"org.nspasteboard.AutoGeneratedType",
-        ];
-        for (NSString *type in concealedTypes) {
-            if ([pasteboard dataForType:type] != nil) {
-                shouldSkipConcealedOrTransient = YES;
-                break;
-            }
-        }
-
-        if (!shouldSkipConcealedOrTransient) {
-            clipData = [RCClipData clipDataFromPasteboard:pasteboard];
-        }
-
-        NSRunningApplication *frontmostApplication = [NSWorkspace sharedWorkspace].frontmostApplication;
-        capturedBundleIdentifier = frontmostApplication.bundleIdentifier ?: @"";
+        capturedBundleIdentifier = provider.frontmostApplicationBundleIdentifier ?: @"";
+        RCTraceEnd("snapshot", snapshotTraceBegin, traceId);
     });
+    [self recordCaptureStage:RCCaptureStageSnapshot enqueued:snapshotEnqueued started:snapshotStarted];
 
-    if (shouldSkipConcealedOrTransient) {
+    if (clipData == nil) {
         return;
     }
 
-    [self processClipDataOnMonitoringQueue:clipData
-                  sourceBundleIdentifier:capturedBundleIdentifier];
+    RCCaptureJob *job = [self captureJobWithClipData:clipData sourceBundleIdentifier:capturedBundleIdentifier];
+    job.traceId = traceId;
+    job.detectedNanoseconds = traceBegin;
+    [self processCaptureJobOnMonitoringQueue:job];
+}
+
+// メインキューで呼ぶ。plan に従って保存する表現だけを読み、除外するクリップは nil。
+- (nullable RCClipData *)snapshotPasteboard:(id<RCPasteboard>)pasteboard plan:(const RCCapturePlan *)plan {
+    RCCaptureVerdict verdict = RCCaptureVerdictRead;
+    RCClipData *clipData = [RCClipData clipDataFromPasteboard:pasteboard plan:plan verdict:&verdict];
+    if (verdict == RCCaptureVerdictSkipOversized) {
+        os_log_debug(RCClipboardServiceLog(),
+                     "Skipping clip save because payload size exceeds limit (%llu bytes)",
+                     plan->maximumPayloadBytes);
+    }
+    return clipData;
+}
+
+- (RCCaptureJob *)captureJobWithClipData:(RCClipData *)clipData sourceBundleIdentifier:(NSString *)sourceBundleIdentifier {
+    RCCaptureJob *job = [[RCCaptureJob alloc] init];
+    job.clipData = clipData;
+    job.sourceBundleIdentifier = sourceBundleIdentifier ?: @"";
+    return job;
 }
 
 - (void)processClipDataOnMonitoringQueue:(RCClipData *)clipData
                     sourceBundleIdentifier:(NSString *)sourceBundleIdentifier {
+    [self processCaptureJobOnMonitoringQueue:[self captureJobWithClipData:clipData
+                                                   sourceBundleIdentifier:sourceBundleIdentifier]];
+}
+
+// パイプラインの入口（monitoringQueue）。安価な除外判定だけをここで行い、ハッシュ以降は後段に回す。
+// fingerprint 段が満杯のときは空くまで待つので、その間は次のポーリングも止まる（背圧）。
+- (void)processCaptureJobOnMonitoringQueue:(RCCaptureJob *)job {
     if ([RCPanicEraseService shared].isPanicInProgress) {
         return;
     }
 
-    if ([[RCExcludeAppService shared] shouldExcludeAppWithBundleIdentifier:sourceBundleIdentifier]) {
+    if ([[RCExcludeAppService shared] shouldExcludeAppWithBundleIdentifier:job.sourceBundleIdentifier]) {
         return;
     }
 
+    RCClipData *clipData = job.clipData;
     if (![self hasClipContent:clipData]) {
         return;
     }
@@ -284,69 +601,295 @@ static os_log_t RCClipboardServiceLog(void) {
         return;
     }
 
-    NSString *dataHash = [clipData dataHash];
-    if (dataHash.length == 0) {
+    job.updateTime = [self currentTimestamp];
+    job.sequence = RCCaptureSequencerAdmit(self.captureSequencer);
+    job.enqueuedNanoseconds = RCQueryMetricsNowNanoseconds();
+    dispatch_async(self.fingerprintQueue, ^{
+        [self fingerprintCaptureJobOnWorker:job];
+    });
+}
+
+#pragma mark - Private: Burst coalescing
+
+// バースト中に同じ状態かを見分けるための安価なキー。dataHash（SHA-256）は fingerprint 段まで求めない。
+// 衝突しても、バースト中の別の状態が 1 つ余分に捨てられるだけ。
+static uint64_t RCBurstKeyForClipData(RCClipData *clipData) {
+    uint64_t key = clipData.payloadLength;
+    key = key * 1099511628211ULL ^ clipData.capturePlanRepresentations;
+    key = key * 1099511628211ULL ^ (uint64_t)clipData.stringValue.hash;
+    key = key * 1099511628211ULL ^ (uint64_t)clipData.URLString.hash;
+    key = key * 1099511628211ULL ^ (uint64_t)clipData.fileNames.hash;
+    key = key * 1099511628211ULL ^ (uint64_t)clipData.fileURLs.hash;
+    key = key * 1099511628211ULL ^ (uint64_t)clipData.RTFData.hash;
+    key = key * 1099511628211ULL ^ (uint64_t)clipData.PDFData.hash;
+    key = key * 1099511628211ULL ^ (uint64_t)clipData.TIFFData.hash;
+    return key;
+}
+
+- (void)offerClipDataOnMonitoringQueue:(RCClipData *)clipData sourceBundleIdentifier:(NSString *)sourceBundleIdentifier {
+    [self offerCaptureJobOnMonitoringQueue:[self captureJobWithClipData:clipData
+                                                 sourceBundleIdentifier:sourceBundleIdentifier]];
+}
+
+// ポーリングで見つけた変更の入口。短い間隔で変更が続く間（スクリプトや自動化ツールのコピー）は
+// 途中の状態をキャプチャせず、落ち着いてから最後の状態だけをパイプラインに流す。
+- (void)offerCaptureJobOnMonitoringQueue:(RCCaptureJob *)job {
+    // 除外アプリのコピーが保持中の状態を押し出さないよう、ここで先に落とす
+    if ([[RCExcludeAppService shared] shouldExcludeAppWithBundleIdentifier:job.sourceBundleIdentifier]) {
         return;
     }
 
-    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
-    if (![databaseManager setupDatabase]) {
+    void *item = (__bridge_retained void *)job;
+    void *dropped = NULL;
+    RCBurstDecision decision = RCBurstCoalescerOffer(&_burstCoalescer,
+                                                     RCClipboardMonotonicNanoseconds(),
+                                                     RCBurstKeyForClipData(job.clipData),
+                                                     item,
+                                                     &dropped);
+    if (dropped != NULL) {
+        RCCaptureJob *droppedJob = (__bridge_transfer RCCaptureJob *)dropped;
+        RCTraceRecordAsyncSpan("capture (coalesced)", droppedJob.detectedNanoseconds, RCTraceNowNanoseconds(), droppedJob.traceId);
+    }
+    if (decision == RCBurstDecisionPass) {
+        CFRelease(item);
+        [self processCaptureJobOnMonitoringQueue:job];
+    }
+    [self publishBurstCountersOnMonitoringQueue];
+}
+
+// force が NO のときは、最後の変更から落ち着くまでの時間が経ったバーストだけを流す。
+- (void)releaseHeldBurstStatesOnMonitoringQueue:(BOOL)force {
+    void *items[RC_BURST_COALESCER_MAX_KEEP];
+    size_t count = force ? RCBurstCoalescerFlush(&_burstCoalescer, items)
+                         : RCBurstCoalescerSettle(&_burstCoalescer, RCClipboardMonotonicNanoseconds(), items);
+    if (count == 0) {
         return;
     }
+    os_log_debug(RCClipboardServiceLog(),
+                 "Clipboard burst settled: keeping %zu state(s), %llu intermediate state(s) dropped so far",
+                 count,
+                 RCBurstCoalescerDroppedStateCount(&_burstCoalescer));
+    for (size_t index = 0; index < count; index++) {
+        RCCaptureJob *job = (__bridge_transfer RCCaptureJob *)items[index];
+        [self processCaptureJobOnMonitoringQueue:job];
+    }
+}
 
-    NSInteger updateTime = [self currentTimestamp];
-    NSDictionary *existingClipDict = [databaseManager clipItemWithDataHash:dataHash];
-    if (existingClipDict != nil) {
-        [self handleExistingClipWithHash:dataHash
-                            existingDict:existingClipDict
-                              updateTime:updateTime
-                         databaseManager:databaseManager];
+- (void)publishBurstCountersOnMonitoringQueue {
+    self.coalescedBurstCount = RCBurstCoalescerBurstCount(&_burstCoalescer);
+    self.droppedBurstStateCount = RCBurstCoalescerDroppedStateCount(&_burstCoalescer);
+}
+
+#pragma mark - Private: Capture pipeline
+
+- (void)recordCaptureStage:(RCCaptureStage)stage enqueued:(uint64_t)enqueued started:(uint64_t)started {
+    if (started == 0) {
         return;
     }
+    RCQueryMetricsRecordOperation(self.captureMetrics, stage, started - enqueued, RCQueryMetricsNowNanoseconds() - started);
+}
+
+// fingerprint 段（ワーカープール、順不同に完了）: サイズ上限・ハッシュ・カラーコード判定
+- (void)fingerprintCaptureJobOnWorker:(RCCaptureJob *)job {
+    uint64_t started = RCQueryMetricsNowNanoseconds();
+    BOOL accepted = [self fingerprintCaptureJob:job];
+    [self recordCaptureStage:RCCaptureStageFingerprint enqueued:job.enqueuedNanoseconds started:started];
+
+    // 除外されたキャプチャも NULL として完了させ、後続の順番を止めない
+    void *item = accepted ? (__bridge_retained void *)job : NULL;
+    uint64_t sequence = job.sequence;
+    dispatch_async(self.sequencerQueue, ^{
+        RCCaptureSequencerComplete(self.captureSequencer, sequence, item);
+        [self releaseFingerprintedCaptureJobsOnSequencerQueue];
+    });
+}
+
+- (BOOL)fingerprintCaptureJob:(RCCaptureJob *)job {
+    RCClipData *clipData = job.clipData;
+
+    // 上限は表現の生の長さで判定し、大きすぎるクリップはハッシュもシリアライズもしない。
+    unsigned long long payloadLength = clipData.payloadLength;
+    unsigned long long maxClipSizeBytes = [RCUtilities maxClipSizeBytes];
+    if (payloadLength > maxClipSizeBytes) {
+        os_log_debug(RCClipboardServiceLog(),
+                     "Skipping clip save because payload size (%llu bytes) exceeds limit (%llu bytes)",
+                     payloadLength,
+                     maxClipSizeBytes);
+        return NO;
+    }
+
+    // dataHash とブロブのダイジェストを 1 回の走査で求め、保存時の再ハッシュを省く。
+    uint64_t hashTraceBegin = RCTraceBegin();
+    RCClipDataDigests *digests = [clipData storageDigests];
+    RCTraceEnd("hash", hashTraceBegin, job.traceId);
+    if (digests.dataHash.length == 0) {
+        return NO;
+    }
+    job.digests = digests;
+
+    if (clipData.stringValue.length > 0 && [NSColor isPotentialColorStringCandidate:clipData.stringValue]) {
+        job.isColorCode = [NSColor isValidColorString:clipData.stringValue];
+    }
+    return YES;
+}
+
+// 完了したものを受け付け順に persist 段へ渡す。persist 段が満杯なら空くまで待つ。
+- (void)releaseFingerprintedCaptureJobsOnSequencerQueue {
+    void *item = NULL;
+    while (RCCaptureSequencerTakeNext(self.captureSequencer, &item)) {
+        RCCaptureJob *job = (__bridge_transfer RCCaptureJob *)item;
+        if (job == nil) {
+            continue;
+        }
+        dispatch_semaphore_wait(self.persistSlots, DISPATCH_TIME_FOREVER);
+        job.enqueuedNanoseconds = RCQueryMetricsNowNanoseconds();
+        dispatch_async(self.persistQueue, ^{
+            [self persistCaptureJobOnPersistQueue:job];
+        });
+    }
+}
+
+// persist 段（直列）: 重複判定と .rcclip・サムネイルの書き出し
+- (void)persistCaptureJobOnPersistQueue:(RCCaptureJob *)job {
+    uint64_t started = RCQueryMetricsNowNanoseconds();
+    BOOL forward = [self persistCaptureJob:job];
+    [self recordCaptureStage:RCCaptureStagePersist enqueued:job.enqueuedNanoseconds started:started];
+
+    if (forward) {
+        dispatch_semaphore_wait(self.indexSlots, DISPATCH_TIME_FOREVER);
+        job.enqueuedNanoseconds = RCQueryMetricsNowNanoseconds();
+        dispatch_async(self.indexQueue, ^{
+            [self indexCaptureJobOnIndexQueue:job];
+        });
+    }
+    dispatch_semaphore_signal(self.persistSlots);
+}
+
+- (BOOL)persistCaptureJob:(RCCaptureJob *)job {
+    if ([RCPanicEraseService shared].isPanicInProgress) {
+        return NO;
+    }
+
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    if (![databaseManager setupDatabase]) {
+        return NO;
+    }
+
+    // 同じ内容がまだ index 段で登録待ちなら、DB には無くてもその行の update_time 更新として扱う。
+    RCClipData *clipData = job.clipData;
+    NSString *dataHash = job.digests.dataHash;
+    RCClipItem *existingClipItem = nil;
+    @synchronized (self.inFlightClipItems) {
+        existingClipItem = [self.inFlightClipItems[dataHash] copy];
+    }
+    if (existingClipItem == nil) {
+        existingClipItem = [databaseManager clipItemForCapturedClipData:clipData dataHash:dataHash];
+    }
+    if (existingClipItem != nil) {
+        job.existingClipItem = existingClipItem;
+        return YES;
+    }
 
     NSString *directoryPath = [RCUtilities clipDataDirectoryPath];
     if (![RCUtilities ensureDirectoryExists:directoryPath]) {
-        return;
+        return NO;
     }
 
     NSString *identifier = [NSUUID UUID].UUIDString;
     NSString *dataFileName = [NSString stringWithFormat:@"%@.%@", identifier, kRCClipDataFileExtension];
     NSString *dataPath = [directoryPath stringByAppendingPathComponent:dataFileName];
 
-    if (![self saveClipData:clipData toPath:dataPath]) {
-        return;
+    NSArray<NSString *> *blobDigests = nil;
+    uint64_t archiveTraceBegin = RCTraceBegin();
+    BOOL saved = [self saveClipData:clipData digests:job.digests toPath:dataPath blobDigests:&blobDigests];
+    RCTraceEnd("archive write", archiveTraceBegin, job.traceId);
+    if (!saved) {
+        return NO;
     }
 
+    uint64_t thumbnailTraceBegin = RCTraceBegin();
     NSString *thumbnailPath = [self generateThumbnailPathForClipData:clipData
                                                            identifier:identifier
                                                         directoryPath:directoryPath];
+    RCTraceEnd("thumbnail", thumbnailTraceBegin, job.traceId);
+
+    RCClipItem *clipItem = [[RCClipItem alloc] init];
+    clipItem.dataPath = dataPath;
+    clipItem.title = clipData.title ?: @"";
+    clipItem.dataHash = dataHash;
+    clipItem.primaryType = clipData.primaryType ?: @"";
+    clipItem.updateTime = job.updateTime;
+    clipItem.thumbnailPath = thumbnailPath ?: @"";
+    clipItem.isColorCode = job.isColorCode;
+    clipItem.searchText = clipData.searchText;
+    clipItem.blobDigests = blobDigests;
+    job.clipItem = clipItem;
+
+    @synchronized (self.inFlightClipItems) {
+        self.inFlightClipItems[dataHash] = clipItem;
+    }
+    return YES;
+}
 
-    BOOL isColorCode = NO;
-    if (clipData.stringValue.length > 0 && [NSColor isPotentialColorStringCandidate:clipData.stringValue]) {
-        isColorCode = [NSColor isValidColorString:clipData.stringValue];
+// index 段（直列）: DB への登録（または既存行の update_time 更新）と通知
+- (void)indexCaptureJobOnIndexQueue:(RCCaptureJob *)job {
+    uint64_t started = RCQueryMetricsNowNanoseconds();
+    [self indexCaptureJob:job];
+    [self recordCaptureStage:RCCaptureStageIndex enqueued:job.enqueuedNanoseconds started:started];
+    dispatch_semaphore_signal(self.indexSlots);
+}
+
+- (void)indexCaptureJob:(RCCaptureJob *)job {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    if (job.existingClipItem != nil) {
+        if ([RCPanicEraseService shared].isPanicInProgress) {
+            return;
+        }
+        // v1 のフィンガープリントで見つかった行は、その行のハッシュで更新する。
+        // 更新がコミットされてから通知する（キューにある間に押し出された行は通知しない）。
+        uint64_t updateTraceBegin = RCTraceBegin();
+        [self handleExistingClipWithHash:job.existingClipItem.dataHash
+                            existingItem:job.existingClipItem
+                              updateTime:job.updateTime
+                         databaseManager:databaseManager
+                              completion:^(RCClipItem * _Nullable updatedItem) {
+            [self postClipboardDidChangeNotificationWithClipItem:updatedItem captureJob:job];
+        }];
+        RCTraceEnd("db update", updateTraceBegin, job.traceId);
+        return;
     }
 
-    NSDictionary *clipDictionary = @{
-        @"data_path": dataPath,
-        @"title": clipData.title ?: @"",
-        @"data_hash": dataHash,
-        @"primary_type": clipData.primaryType ?: @"",
-        @"update_time": @(updateTime),
-        @"thumbnail_path": thumbnailPath ?: @"",
-        @"is_color_code": @(isColorCode),
-    };
+    RCClipItem *clipItem = job.clipItem;
+    uint64_t insertTraceBegin = RCTraceBegin();
+    // write-behind のキューに入れ、コミットの結果を待ってから保存済みとして扱う。
+    BOOL queued = ![RCPanicEraseService shared].isPanicInProgress
+        && [databaseManager enqueueClipItemObject:clipItem completion:^(BOOL committed) {
+            [self finishIndexingClipItem:clipItem committed:committed captureJob:job];
+        }];
+    RCTraceEnd("db insert", insertTraceBegin, job.traceId);
+    if (!queued) {
+        [self finishIndexingClipItem:clipItem committed:NO captureJob:job];
+    }
+}
 
-    if (![databaseManager insertClipItem:clipDictionary]) {
-        [self deleteFileAtPath:dataPath];
-        [self deleteFileAtPath:thumbnailPath];
+// 行のコミット（または失敗）後に呼ばれる。コミットまでは inFlightClipItems に残し、
+// 重複判定がキュー上の行を見失わないようにする。失敗した行のファイルはここで消す。
+- (void)finishIndexingClipItem:(RCClipItem *)clipItem committed:(BOOL)committed captureJob:(RCCaptureJob *)job {
+    @synchronized (self.inFlightClipItems) {
+        if (self.inFlightClipItems[clipItem.dataHash] == clipItem) {
+            [self.inFlightClipItems removeObjectForKey:clipItem.dataHash];
+        }
+    }
+    if (!committed) {
+        [self deleteFileAtPath:clipItem.dataPath];
+        [self deleteFileAtPath:clipItem.thumbnailPath];
         return;
     }
 
-    RCClipItem *clipItem = [[RCClipItem alloc] initWithDictionary:clipDictionary];
     // G3-006: トリミングロジックは RCDataCleanService に一本化。
     // ここでは重複して trimHistoryIfNeeded を呼ばない。
     [[RCDataCleanService shared] scheduleDebouncedCleanup];
-    [self postClipboardDidChangeNotificationWithClipItem:clipItem];
+    [self postClipboardDidChangeNotificationWithClipItem:clipItem captureJob:job];
 }
 
 /// G3-014: shouldOverwrite / shouldReorder セマンティクス
@@ -362,25 +905,33 @@ static os_log_t RCClipboardServiceLog(void) {
 ///   NO  — 並べ替えを行わない。
 ///
 /// 両方が NO の場合、既存クリップに対しては一切の更新を行わずスキップする。
+///
+/// 更新がコミットされたら completion に通知する項目を渡す（スキップ・失敗時は nil）。
+/// completion は write-behind の flush スレッドで呼ばれることがある。
 - (void)handleExistingClipWithHash:(NSString *)dataHash
-                      existingDict:(NSDictionary *)existingClipDict
+                      existingItem:(RCClipItem *)existingClipItem
                         updateTime:(NSInteger)updateTime
-                   databaseManager:(RCDatabaseManager *)databaseManager {
+                   databaseManager:(RCDatabaseManager *)databaseManager
+                        completion:(void (^)(RCClipItem * _Nullable updatedItem))completion {
     BOOL shouldOverwrite = [self boolPreferenceForKey:kRCPrefOverwriteSameHistory defaultValue:YES];
     BOOL shouldReorder = [self boolPreferenceForKey:kRCPrefReorderClipsAfterPasting defaultValue:YES];
 
     if (!shouldOverwrite && !shouldReorder) {
+        completion(nil);
         return;
     }
 
-    if (![databaseManager updateClipItemUpdateTime:dataHash time:updateTime]) {
-        return;
+    BOOL queued = [databaseManager enqueueClipItemUpdateTime:dataHash time:updateTime completion:^(BOOL committed) {
+        if (!committed) {
+            completion(nil);
+            return;
+        }
+        existingClipItem.updateTime = updateTime;
+        completion(existingClipItem);
+    }];
+    if (!queued) {
+        completion(nil);
     }
-
-    NSMutableDictionary *updatedDict = [existingClipDict mutableCopy];
-    updatedDict[@"update_time"] = @(updateTime);
-    RCClipItem *updatedItem = [[RCClipItem alloc] initWithDictionary:updatedDict];
-    [self postClipboardDidChangeNotificationWithClipItem:updatedItem];
 }
 
 #pragma mark - Private: Filtering
@@ -396,62 +947,45 @@ static os_log_t RCClipboardServiceLog(void) {
             || clipData.TIFFData.length > 0);
 }
 
+// ペーストボードからのスナップショットは plan で絞り込み済み。直接渡されたクリップにも同じ判定を使う。
 - (BOOL)shouldStoreClipData:(RCClipData *)clipData {
-    NSDictionary *storeTypes = [[NSUserDefaults standardUserDefaults] dictionaryForKey:kRCPrefStoreTypesKey];
-    if (![storeTypes isKindOfClass:[NSDictionary class]]) {
-        return YES;
-    }
-
-    BOOL hasSupportedType = NO;
-    BOOL hasEnabledType = NO;
-
-    BOOL hasString = (clipData.stringValue.length > 0);
-    if (hasString) {
-        hasSupportedType = YES;
-        hasEnabledType = hasEnabledType || [self isStoreTypeEnabledForKey:kRCStoreTypeString inStoreTypes:storeTypes];
-    }
-
-    BOOL hasRTF = (clipData.RTFData.length > 0);
-    if (hasRTF) {
-        hasSupportedType = YES;
-        hasEnabledType = hasEnabledType || [self isStoreTypeEnabledForKey:kRCStoreTypeRTF inStoreTypes:storeTypes];
-    }
-
-    BOOL hasRTFD = (clipData.RTFDData.length > 0);
-    if (hasRTFD) {
-        hasSupportedType = YES;
-        hasEnabledType = hasEnabledType || [self isStoreTypeEnabledForKey:kRCStoreTypeRTFD inStoreTypes:storeTypes];
-    }
-
-    BOOL hasPDF = (clipData.PDFData.length > 0);
-    if (hasPDF) {
-        hasSupportedType = YES;
-        hasEnabledType = hasEnabledType || [self isStoreTypeEnabledForKey:kRCStoreTypePDF inStoreTypes:storeTypes];
-    }
-
-    BOOL hasFiles = (clipData.fileNames.count > 0 || clipData.fileURLs.count > 0);
-    if (hasFiles) {
-        hasSupportedType = YES;
-        hasEnabledType = hasEnabledType || [self isStoreTypeEnabledForKey:kRCStoreTypeFilenames inStoreTypes:storeTypes];
-    }
-
-    BOOL hasURL = (clipData.URLString.length > 0);
-    if (hasURL) {
-        hasSupportedType = YES;
-        hasEnabledType = hasEnabledType || [self isStoreTypeEnabledForKey:kRCStoreTypeURL inStoreTypes:storeTypes];
-    }
+    RCCapturePlan plan = [self currentCapturePlan];
+    RCClipRepresentationMask readMask = 0;
+    RCCaptureVerdict verdict = RCCapturePlanEvaluate(&plan, [clipData capturePlanRepresentations], false, &readMask);
+    return verdict != RCCaptureVerdictSkipDisabled;
+}
 
-    BOOL hasTIFF = (clipData.TIFFData.length > 0);
-    if (hasTIFF) {
-        hasSupportedType = YES;
-        hasEnabledType = hasEnabledType || [self isStoreTypeEnabledForKey:kRCStoreTypeTIFF inStoreTypes:storeTypes];
+// 保存する型とサイズ上限は設定が変わったときだけ作り直す（スナップショットごとに NSUserDefaults を読まない）。
+- (RCCapturePlan)currentCapturePlan {
+    @synchronized (self) {
+        if (self.capturePlanNeedsRebuild) {
+            _capturePlan = [self capturePlanFromDefaults];
+            self.capturePlanNeedsRebuild = NO;
+        }
+        return _capturePlan;
     }
+}
 
-    if (!hasSupportedType) {
-        return YES;
+- (RCCapturePlan)capturePlanFromDefaults {
+    RCClipRepresentationMask enabled = RC_CLIP_REPRESENTATION_ALL;
+    NSDictionary *storeTypes = [[NSUserDefaults standardUserDefaults] dictionaryForKey:kRCPrefStoreTypesKey];
+    if ([storeTypes isKindOfClass:[NSDictionary class]]) {
+        NSDictionary<NSString *, NSNumber *> *representationsByKey = @{
+            kRCStoreTypeString: @(RCClipRepresentationString),
+            kRCStoreTypeRTF: @(RCClipRepresentationRTF),
+            kRCStoreTypeRTFD: @(RCClipRepresentationRTFD),
+            kRCStoreTypePDF: @(RCClipRepresentationPDF),
+            kRCStoreTypeFilenames: @(RCClipRepresentationFiles),
+            kRCStoreTypeURL: @(RCClipRepresentationURL),
+            kRCStoreTypeTIFF: @(RCClipRepresentationTIFF),
+        };
+        for (NSString *key in representationsByKey) {
+            if (![self isStoreTypeEnabledForKey:key inStoreTypes:storeTypes]) {
+                enabled &= ~(RCClipRepresentationMask)representationsByKey[key].unsignedIntValue;
+            }
+        }
     }
-
-    return hasEnabledType;
+    return RCCapturePlanMake(enabled, [RCUtilities maxClipSizeBytes]);
 }
 
 - (BOOL)isStoreTypeEnabledForKey:(NSString *)key inStoreTypes:(NSDictionary *)storeTypes {
@@ -467,49 +1001,27 @@ static os_log_t RCClipboardServiceLog(void) {
 
 #pragma mark - Private: File / Thumbnail
 
-// G3-002: dispatch_sync は monitoringQueue → fileOperationQueue への呼び出しであり、
+// G3-002: dispatch_sync は persistQueue → fileOperationQueue への呼び出しであり、
 // 同一キューへの sync ではないためデッドロックの危険はない。
 // 戻り値が必要なため dispatch_sync を使用している。
-- (BOOL)saveClipData:(RCClipData *)clipData toPath:(NSString *)path {
+- (BOOL)saveClipData:(RCClipData *)clipData
+             digests:(RCClipDataDigests *)digests
+              toPath:(NSString *)path
+         blobDigests:(NSArray<NSString *> * _Nullable * _Nullable)outBlobDigests {
     if (path.length == 0) {
         return NO;
     }
 
-    NSError *archiveError = nil;
-    NSData *archivedData = [NSKeyedArchiver archivedDataWithRootObject:clipData
-                                                  requiringSecureCoding:YES
-                                                                  error:&archiveError];
-    if (archivedData == nil) {
-        os_log_error(RCClipboardServiceLog(),
-                     "Failed to archive clip data before size check (%{private}@)",
-                     archiveError.localizedDescription);
-        return NO;
-    }
-
-    // CFBooleanRef チェック付きの安全な読み取り
-    id rawValue = [[NSUserDefaults standardUserDefaults] objectForKey:kRCPrefMaxClipSizeBytesKey];
-    NSInteger maxClipSizeBytes = kRCDefaultMaxClipSizeBytes;
-    if ([rawValue isKindOfClass:[NSNumber class]] &&
-        CFGetTypeID((__bridge CFTypeRef)rawValue) != CFBooleanGetTypeID()) {
-        maxClipSizeBytes = [(NSNumber *)rawValue integerValue];
-    } else if ([rawValue isKindOfClass:[NSString class]]) {
-        maxClipSizeBytes = [(NSString *)rawValue integerValue];
-    }
-    if (maxClipSizeBytes < 1048576) {
-        maxClipSizeBytes = kRCDefaultMaxClipSizeBytes;
-    }
-    if (archivedData.length > (NSUInteger)maxClipSizeBytes) {
-        os_log_debug(RCClipboardServiceLog(),
-                     "Skipping clip save because archived data size (%lu bytes) exceeds limit (%ld bytes)",
-                     (unsigned long)archivedData.length,
-                     (long)maxClipSizeBytes);
-        return NO;
-    }
-
     __block BOOL saved = NO;
+    __block NSArray<NSString *> *blobDigests = nil;
     dispatch_sync(self.fileOperationQueue, ^{
-        saved = [clipData saveToPath:path];
+        NSArray<NSString *> *savedBlobDigests = nil;
+        saved = [clipData saveToPath:path digests:digests blobDigests:&savedBlobDigests];
+        blobDigests = savedBlobDigests;
     });
+    if (outBlobDigests != NULL) {
+        *outBlobDigests = blobDigests;
+    }
     return saved;
 }
 
@@ -566,7 +1078,7 @@ static os_log_t RCClipboardServiceLog(void) {
     NSString *thumbnailFileName = [NSString stringWithFormat:@"%@.thumbnail.tiff", identifier];
     NSString *thumbnailPath = [directoryPath stringByAppendingPathComponent:thumbnailFileName];
 
-    // G3-002: dispatch_sync は monitoringQueue → fileOperationQueue であり安全
+    // G3-002: dispatch_sync は persistQueue → fileOperationQueue であり安全
     __block BOOL wrote = NO;
     dispatch_sync(self.fileOperationQueue, ^{
         NSError *error = nil;
@@ -659,15 +1171,21 @@ static os_log_t RCClipboardServiceLog(void) {
     return defaultValue;
 }
 
-- (void)postClipboardDidChangeNotificationWithClipItem:(RCClipItem *)clipItem {
+// 通知の受け手（メニューの再構築）はメインキューで同期的に走るので、その終わりをキャプチャの終点として記録する。
+- (void)postClipboardDidChangeNotificationWithClipItem:(nullable RCClipItem *)clipItem captureJob:(RCCaptureJob *)job {
     if (clipItem == nil) {
         return;
     }
 
+    uint64_t traceId = job.traceId;
+    uint64_t detectedNanoseconds = job.detectedNanoseconds;
     dispatch_async(dispatch_get_main_queue(), ^{
+        uint64_t notificationTraceBegin = RCTraceBegin();
         [[NSNotificationCenter defaultCenter] postNotificationName:RCClipboardDidChangeNotification
                                                             object:self
                                                           userInfo:@{ @"clipItem": clipItem }];
+        RCTraceEnd("notification", notificationTraceBegin, traceId);
+        RCTraceRecordAsyncSpan("capture", detectedNanoseconds, RCTraceNowNanoseconds(), traceId);
     });
 }
 
@@ -31,6 +31,10 @@ NS_ASSUME_NONNULL_BEGIN
 // Panic Erase 用: cleanupQueue までの処理をドレイン
 - (void)flushQueueWithCompletion:(void(^)(void))completion;
 
+/// Progress of the database maintenance deferred from launch while it runs on
+/// the cleanup queue (nil otherwise). Cancelling it stops the current pass.
+@property (atomic, strong, readonly, nullable) NSProgress *databaseMaintenanceProgress;
+
 @end
 
 NS_ASSUME_NONNULL_END
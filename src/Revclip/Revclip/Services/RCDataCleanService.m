@@ -8,6 +8,8 @@
 #import "RCDataCleanService.h"
 
 #import "FMDB.h"
+#import "RCClipBlobStore.h"
+#import "RCClipData.h"
 #import "RCClipItem.h"
 #import "RCConstants.h"
 #import "RCDatabaseManager.h"
@@ -24,6 +26,9 @@ static NSInteger const kRCAutoExpiryDefaultValue = 30;
 static NSInteger const kRCAutoExpiryMinimumValue = 1;
 static NSInteger const kRCAutoExpiryMaximumValue = 9999;
 static NSTimeInterval const kRCOrphanFileMinimumAge = 60.0;
+static NSInteger const kRCSearchBackfillBatchSize = 100;
+static NSInteger const kRCSearchBackfillMaxBatchesPerRun = 10;
+static NSInteger const kRCReleasedBlobBatchSize = 500;
 static NSString * const kRCClipDataFileExtension = @"rcclip";
 static NSString * const kRCThumbFileExtension = @"thumb";
 static NSString * const kRCLegacyThumbnailFileExtension = @"thumbnail.tiff";
@@ -44,8 +49,18 @@ static os_log_t RCDataCleanServiceLog(void) {
 @property (nonatomic, strong, nullable) dispatch_source_t cleanupTimer;
 @property (nonatomic, strong, nullable) dispatch_source_t cleanupDebounceTimer;
 @property (nonatomic, strong) dispatch_queue_t cleanupQueue;
+@property (atomic, strong, readwrite, nullable) NSProgress *databaseMaintenanceProgress;
 
 - (void)runDatabaseMaintenanceWithDatabaseManager:(RCDatabaseManager *)databaseManager;
+- (void)runDeferredDatabaseMaintenanceWithDatabaseManager:(RCDatabaseManager *)databaseManager;
+- (void)backfillSearchIndexWithDatabaseManager:(RCDatabaseManager *)databaseManager;
+- (void)removeReleasedBlobsWithDatabaseManager:(RCDatabaseManager *)databaseManager;
+- (void)removeOrphanBlobFilesWithDatabaseManager:(RCDatabaseManager *)databaseManager;
+- (void)evictHistoryWithDatabaseManager:(RCDatabaseManager *)databaseManager
+                   honoringHistoryLimit:(BOOL)honoringHistoryLimit;
+- (NSInteger)expiryCutoffTimestampMs;
+- (NSInteger)maxHistorySizePreference;
+- (void)removeFilesForClipItems:(NSArray<RCClipItem *> *)clipItems;
 - (BOOL)autoExpiryEnabledPreferenceValue;
 - (NSInteger)autoExpiryValuePreference;
 - (RCAutoExpiryUnit)autoExpiryUnitPreference;
@@ -213,21 +228,51 @@ static os_log_t RCDataCleanServiceLog(void) {
         return;
     }
 
-    [self expireHistoryIfNeededWithDatabaseManager:databaseManager];
-    [self trimHistoryIfNeededWithDatabaseManager:databaseManager];
+    [self evictHistoryWithDatabaseManager:databaseManager honoringHistoryLimit:YES];
+    [self removeReleasedBlobsWithDatabaseManager:databaseManager];
     [self removeOrphanClipFilesWithDatabaseManager:databaseManager];
+    [self removeOrphanBlobFilesWithDatabaseManager:databaseManager];
+    [self backfillSearchIndexWithDatabaseManager:databaseManager];
+    [self runDeferredDatabaseMaintenanceWithDatabaseManager:databaseManager];
     [self runDatabaseMaintenanceWithDatabaseManager:databaseManager];
 }
 
 - (void)expireHistoryIfNeededWithDatabaseManager:(RCDatabaseManager *)databaseManager {
+    [self evictHistoryWithDatabaseManager:databaseManager honoringHistoryLimit:NO];
+}
+
+// 期限切れと件数超過を 1 回の DELETE ... RETURNING でまとめて削除し、
+// ファイル削除はトランザクション外でまとめて行う。
+- (void)evictHistoryWithDatabaseManager:(RCDatabaseManager *)databaseManager
+                   honoringHistoryLimit:(BOOL)honoringHistoryLimit {
     if ([RCPanicEraseService shared].isPanicInProgress) {
         return;
     }
 
-    if (![self autoExpiryEnabledPreferenceValue]) {
+    NSInteger cutoffMs = [self expiryCutoffTimestampMs];
+    NSInteger maxHistorySize = honoringHistoryLimit ? [self maxHistorySizePreference] : 0;
+    if (cutoffMs == NSIntegerMin && maxHistorySize <= 0) {
+        return;
+    }
+
+    NSArray<RCClipItem *> *evictedItems = [databaseManager evictClipItemsBeyondLimit:maxHistorySize
+                                                                           olderThan:cutoffMs];
+    if (evictedItems.count == 0) {
         return;
     }
 
+    os_log_debug(RCDataCleanServiceLog(),
+                 "Evicted %lu clip history rows",
+                 (unsigned long)evictedItems.count);
+    [self removeFilesForClipItems:evictedItems];
+}
+
+// 自動期限切れが無効な場合は NSIntegerMin を返し、期限条件に一致する行をなくす。
+- (NSInteger)expiryCutoffTimestampMs {
+    if (![self autoExpiryEnabledPreferenceValue]) {
+        return NSIntegerMin;
+    }
+
     NSInteger expiryValue = [self autoExpiryValuePreference];
     RCAutoExpiryUnit expiryUnit = [self autoExpiryUnitPreference];
 
@@ -246,24 +291,10 @@ static os_log_t RCDataCleanServiceLog(void) {
     }
 
     NSInteger nowMs = (NSInteger)([[NSDate date] timeIntervalSince1970] * 1000.0);
-    NSInteger cutoffMs = nowMs - expiryDurationMs;
-    NSArray<RCClipItem *> *expiredItems = [databaseManager clipItemsOlderThan:cutoffMs];
-    for (RCClipItem *expiredItem in expiredItems) {
-        if (expiredItem.dataHash.length == 0) {
-            continue;
-        }
-
-        if ([databaseManager deleteClipItemWithDataHash:expiredItem.dataHash olderThan:cutoffMs]) {
-            [self removeFilesForClipItem:expiredItem];
-        }
-    }
+    return nowMs - expiryDurationMs;
 }
 
-- (void)trimHistoryIfNeededWithDatabaseManager:(RCDatabaseManager *)databaseManager {
-    if ([RCPanicEraseService shared].isPanicInProgress) {
-        return;
-    }
-
+- (NSInteger)maxHistorySizePreference {
     NSInteger maxHistorySize = [self integerPreferenceForKey:kRCPrefMaxHistorySizeKey
                                                 defaultValue:kRCDefaultMaxHistorySize];
     if (maxHistorySize <= 0) {
@@ -272,27 +303,7 @@ static os_log_t RCDataCleanServiceLog(void) {
     if (maxHistorySize > kRCMaxAllowedHistorySize) {
         maxHistorySize = kRCMaxAllowedHistorySize;
     }
-
-    NSInteger count = [databaseManager clipItemCount];
-    if (count <= maxHistorySize) {
-        return;
-    }
-
-    NSArray<NSDictionary *> *clipDictionaries = [databaseManager fetchClipItemsWithLimit:count];
-    if (clipDictionaries.count <= (NSUInteger)maxHistorySize) {
-        return;
-    }
-
-    for (NSUInteger index = clipDictionaries.count; index > (NSUInteger)maxHistorySize; index--) {
-        RCClipItem *oldItem = [[RCClipItem alloc] initWithDictionary:clipDictionaries[index - 1]];
-        if (oldItem.dataHash.length == 0) {
-            continue;
-        }
-
-        if ([databaseManager deleteClipItemWithDataHash:oldItem.dataHash]) {
-            [self removeFilesForClipItem:oldItem];
-        }
-    }
+    return maxHistorySize;
 }
 
 - (void)runDatabaseMaintenanceWithDatabaseManager:(RCDatabaseManager *)databaseManager {
@@ -316,6 +327,55 @@ static os_log_t RCDataCleanServiceLog(void) {
     }];
 }
 
+// setupDatabase が起動時に行わなくなった重い移行（VACUUM・オンライン移行）。
+// 起動直後の初回クリーンアップで実行し、終わらなければ次回のクリーンアップで続きから再開する。
+- (void)runDeferredDatabaseMaintenanceWithDatabaseManager:(RCDatabaseManager *)databaseManager {
+    if (![databaseManager hasDeferredMaintenance]) {
+        return;
+    }
+
+    NSProgress *progress = [NSProgress discreteProgressWithTotalUnitCount:1];
+    self.databaseMaintenanceProgress = progress;
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    BOOL completed = [databaseManager performDeferredMaintenanceWithProgress:progress];
+    if (completed) {
+        os_log_info(RCDataCleanServiceLog(),
+                    "Deferred database maintenance finished in %.0f ms",
+                    (CFAbsoluteTimeGetCurrent() - startTime) * 1000.0);
+    } else {
+        os_log_error(RCDataCleanServiceLog(),
+                     "Deferred database maintenance stopped at %.0f%%; retrying on the next cleanup",
+                     progress.fractionCompleted * 100.0);
+    }
+    self.databaseMaintenanceProgress = nil;
+}
+
+// v3 移行前のクリップは .rcclip を読んで検索索引を埋める。1 回の実行あたりの件数を
+// 抑え、ライターを長時間占有しないようバッチごとにコミットする。
+- (void)backfillSearchIndexWithDatabaseManager:(RCDatabaseManager *)databaseManager {
+    for (NSInteger batch = 0; batch < kRCSearchBackfillMaxBatchesPerRun; batch++) {
+        if ([RCPanicEraseService shared].isPanicInProgress) {
+            return;
+        }
+
+        @autoreleasepool {
+            NSArray<RCClipItem *> *clipItems = [databaseManager clipItemsMissingSearchTextWithLimit:kRCSearchBackfillBatchSize];
+            for (RCClipItem *clipItem in clipItems) {
+                // 読めないファイルは空文字で索引し、毎回読み直さないようにする。
+                // 画像と PDF は検索文字列に使わないのでセクションを読まない。
+                RCClipData *clipData = [RCClipData clipDataFromPath:clipItem.dataPath
+                                                    representations:RCClipDataRepresentationAll
+                                                                    & ~(RCClipDataRepresentationPDF | RCClipDataRepresentationTIFF)];
+                clipItem.searchText = clipData.searchText ?: @"";
+            }
+            if (![databaseManager indexSearchTextForClipItems:clipItems]
+                || clipItems.count < (NSUInteger)kRCSearchBackfillBatchSize) {
+                return;
+            }
+        }
+    }
+}
+
 - (void)removeOrphanClipFilesWithDatabaseManager:(RCDatabaseManager *)databaseManager {
     NSString *clipDirectoryPath = [RCUtilities clipDataDirectoryPath];
     if (![RCUtilities ensureDirectoryExists:clipDirectoryPath]) {
@@ -339,23 +399,23 @@ static os_log_t RCDataCleanServiceLog(void) {
 
     NSMutableSet<NSString *> *databaseClipPaths = [NSMutableSet set];
     NSMutableSet<NSString *> *databaseThumbnailPaths = [NSMutableSet set];
-    NSInteger count = [databaseManager clipItemCount];
-    if (count > 0) {
-        NSArray<NSDictionary *> *clipDictionaries = [databaseManager fetchClipItemsWithLimit:count];
-        for (NSDictionary *clipDictionary in clipDictionaries) {
-            RCClipItem *clipItem = [[RCClipItem alloc] initWithDictionary:clipDictionary];
-            NSString *canonicalDataPath = [self validatedCanonicalClipPath:clipItem.dataPath
-                                                     clipDataDirectoryPath:canonicalClipDataDirectoryPath];
-            if (canonicalDataPath.length > 0) {
-                [databaseClipPaths addObject:canonicalDataPath];
-            }
+    // 履歴全体を配列に載せず 1 行ずつ流す。保持するのはパスの集合だけ。
+    BOOL enumerated = [databaseManager enumerateClipItemsUsingBlock:^(RCClipItem *clipItem, BOOL *stop) {
+        NSString *canonicalDataPath = [self validatedCanonicalClipPath:clipItem.dataPath
+                                                 clipDataDirectoryPath:canonicalClipDataDirectoryPath];
+        if (canonicalDataPath.length > 0) {
+            [databaseClipPaths addObject:canonicalDataPath];
+        }
 
-            NSString *canonicalThumbnailPath = [self validatedCanonicalClipPath:clipItem.thumbnailPath
-                                                          clipDataDirectoryPath:canonicalClipDataDirectoryPath];
-            if (canonicalThumbnailPath.length > 0) {
-                [databaseThumbnailPaths addObject:canonicalThumbnailPath];
-            }
+        NSString *canonicalThumbnailPath = [self validatedCanonicalClipPath:clipItem.thumbnailPath
+                                                      clipDataDirectoryPath:canonicalClipDataDirectoryPath];
+        if (canonicalThumbnailPath.length > 0) {
+            [databaseThumbnailPaths addObject:canonicalThumbnailPath];
         }
+    }];
+    if (!enumerated) {
+        // 参照中のファイルを孤立扱いで消さないよう、列挙に失敗したら何もしない。
+        return;
     }
 
     for (NSString *fileName in fileNames) {
@@ -414,6 +474,53 @@ static os_log_t RCDataCleanServiceLog(void) {
     }
 }
 
+// 最後の参照が外れたブロブを削除する。猶予期間内のもの（直前に同じ内容が
+// 保存された可能性がある）は clip_blob_garbage に残し、次回に回す。
+- (void)removeReleasedBlobsWithDatabaseManager:(RCDatabaseManager *)databaseManager {
+    RCClipBlobStore *blobStore = [RCClipBlobStore shared];
+    NSArray<NSString *> *digests = [databaseManager releasedBlobDigestsWithLimit:kRCReleasedBlobBatchSize];
+    NSMutableArray<NSString *> *removedDigests = [NSMutableArray arrayWithCapacity:digests.count];
+    for (NSString *digest in digests) {
+        if ([RCPanicEraseService shared].isPanicInProgress) {
+            return;
+        }
+
+        @autoreleasepool {
+            BOOL removed = [blobStore removeReleasedBlobWithDigest:digest isReferenced:^BOOL{
+                return [databaseManager isBlobDigestReferenced:digest];
+            }];
+            if (removed) {
+                [removedDigests addObject:digest];
+            }
+        }
+    }
+    [databaseManager forgetReleasedBlobDigests:removedDigests];
+}
+
+// clip_blobs に参照の無いブロブ（保存後に DB 登録されなかったキャプチャ等）を削除する。
+- (void)removeOrphanBlobFilesWithDatabaseManager:(RCDatabaseManager *)databaseManager {
+    RCClipBlobStore *blobStore = [RCClipBlobStore shared];
+    for (NSString *digest in [blobStore storedDigests]) {
+        if ([RCPanicEraseService shared].isPanicInProgress) {
+            return;
+        }
+
+        @autoreleasepool {
+            [blobStore removeReleasedBlobWithDigest:digest isReferenced:^BOOL{
+                return [databaseManager isBlobDigestReferenced:digest];
+            }];
+        }
+    }
+}
+
+- (void)removeFilesForClipItems:(NSArray<RCClipItem *> *)clipItems {
+    for (RCClipItem *clipItem in clipItems) {
+        @autoreleasepool {
+            [self removeFilesForClipItem:clipItem];
+        }
+    }
+}
+
 - (void)removeFilesForClipItem:(RCClipItem *)clipItem {
     if (clipItem == nil) {
         return;
@@ -10,11 +10,15 @@
 NS_ASSUME_NONNULL_BEGIN
 
 @class RCClipData;
+@protocol RCPasteboardProvider;
 
 @interface RCPasteService : NSObject
 
 + (instancetype)shared;
 
+// 書き込み先のペーストボード（既定は RCSystemPasteboardProvider）
+@property (atomic, strong) id<RCPasteboardProvider> pasteboardProvider;
+
 // RCClipDataをペーストボードに設定してアクティブアプリに貼り付け
 - (void)pasteClipData:(RCClipData *)clipData;
 
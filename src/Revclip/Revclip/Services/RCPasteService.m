@@ -13,6 +13,7 @@
 #import "RCClipboardService.h"
 #import "RCClipData.h"
 #import "RCConstants.h"
+#import "RCPasteboardProvider.h"
 
 static NSTimeInterval const kRCPasteMenuCloseDelay = 0.05;
 static NSTimeInterval const kRCPasteActivationPollInterval = 0.01;
@@ -46,6 +47,14 @@ static NSTimeInterval const kRCPasteActivationTimeout = 0.5;
     return sharedService;
 }
 
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _pasteboardProvider = [RCSystemPasteboardProvider shared];
+    }
+    return self;
+}
+
 - (void)pasteClipData:(RCClipData *)clipData {
     if (clipData == nil) {
         return;
@@ -83,7 +92,7 @@ static NSTimeInterval const kRCPasteActivationTimeout = 0.5;
         return;
     }
 
-    BOOL wrote = [clipData writeToPasteboard:[NSPasteboard generalPasteboard]];
+    BOOL wrote = [clipData writeToPasteboard:self.pasteboardProvider.generalPasteboard];
     if (!wrote) {
         [self clearPastingInternallyFlagAfterDelayForGeneration:currentPasteGeneration];
         return;
@@ -266,7 +275,7 @@ static NSTimeInterval const kRCPasteActivationTimeout = 0.5;
 
 - (void)writePlainTextToPasteboard:(NSString *)text {
     NSString *safeText = text ?: @"";
-    NSPasteboard *pasteboard = [NSPasteboard generalPasteboard];
+    id<RCPasteboard> pasteboard = self.pasteboardProvider.generalPasteboard;
     [pasteboard clearContents];
     [pasteboard setString:safeText forType:NSPasteboardTypeString];
 }
@@ -0,0 +1,108 @@
+//
+//  RCPasteboardProvider.h
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#import <Cocoa/Cocoa.h>
+
+#import "RCCapturePlan.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// キャプチャとペーストが使う NSPasteboard の部分集合。NSPasteboard はそのまま準拠する。
+@protocol RCPasteboard <NSObject>
+
+@property (readonly) NSInteger changeCount;
+@property (nullable, readonly, copy) NSArray<NSPasteboardType> *types;
+
+- (nullable NSData *)dataForType:(NSPasteboardType)dataType;
+- (nullable NSString *)stringForType:(NSPasteboardType)dataType;
+- (nullable id)propertyListForType:(NSPasteboardType)dataType;
+- (nullable NSArray *)readObjectsForClasses:(NSArray<Class> *)classArray
+                                    options:(nullable NSDictionary<NSPasteboardReadingOptionKey, id> *)options;
+
+- (NSInteger)clearContents;
+- (BOOL)setData:(nullable NSData *)data forType:(NSPasteboardType)dataType;
+- (BOOL)setString:(NSString *)string forType:(NSPasteboardType)dataType;
+- (BOOL)setPropertyList:(id)plist forType:(NSPasteboardType)dataType;
+- (BOOL)writeObjects:(NSArray<id<NSPasteboardWriting>> *)objects;
+
+@end
+
+@interface NSPasteboard (RCPasteboard) <RCPasteboard>
+@end
+
+// RCClipboardService / RCPasteService が読み書きするペーストボードと、コピー元アプリの取得先。
+// どちらもメインキューで呼ぶ。
+@protocol RCPasteboardProvider <NSObject>
+
+@property (nonatomic, readonly) id<RCPasteboard> generalPasteboard;
+@property (nonatomic, readonly, copy, nullable) NSString *frontmostApplicationBundleIdentifier;
+
+@end
+
+// 既定の実装: NSPasteboard.generalPasteboard と NSWorkspace の最前面アプリ
+@interface RCSystemPasteboardProvider : NSObject <RCPasteboardProvider>
+
++ (instancetype)shared;
+
+@end
+
+/// In-memory stand-in for the general pasteboard, so the capture path can
+/// run without a logged-in session (unit tests, headless load runs). It is
+/// its own provider. Every scripted copy replaces the contents and bumps
+/// changeCount like a real copy; reads are counted so tests can check what
+/// a capture actually pulled off the pasteboard. Thread-safe.
+@interface RCInMemoryPasteboard : NSObject <RCPasteboard, RCPasteboardProvider>
+
+@property (nonatomic, copy, nullable) NSString *frontmostApplicationBundleIdentifier;
+
+/// Replaces the contents with `representations` (NSData, NSString or a
+/// property list per type; NSPasteboardTypeFileURL takes an NSArray of file
+/// NSURLs) as copied by `sourceBundleIdentifier`. Returns the new changeCount.
+- (NSInteger)scriptCopyWithRepresentations:(NSDictionary<NSPasteboardType, id> *)representations
+                    sourceBundleIdentifier:(nullable NSString *)sourceBundleIdentifier;
+
+/// Scripts a copy of `length` deterministic bytes of `type` derived from
+/// `seed` (the same seed gives the same bytes, i.e. a re-copy). String-like
+/// types get ASCII text. Returns the new changeCount.
+- (NSInteger)scriptCopyOfType:(NSPasteboardType)type
+                       length:(NSUInteger)length
+                         seed:(uint64_t)seed
+       sourceBundleIdentifier:(nullable NSString *)sourceBundleIdentifier;
+
+/// Scripts a copy offering every representation in `representations`
+/// (RCClipRepresentation bits), each built from `length` deterministic bytes
+/// of `seed` the same way as the headless benchmarks' RCBenchPasteboard, so
+/// a trace replays the same payloads in both. `marked` adds a concealed
+/// marker type. Returns the new changeCount.
+- (NSInteger)scriptCopyOfRepresentations:(RCClipRepresentationMask)representations
+                                  length:(NSUInteger)length
+                                    seed:(uint64_t)seed
+                                  marked:(BOOL)marked
+                  sourceBundleIdentifier:(nullable NSString *)sourceBundleIdentifier;
+
+/// The contents scriptCopyOfRepresentations:... puts on the pasteboard, for
+/// callers that build large payloads ahead of a timed run and script them
+/// with scriptCopyWithRepresentations:sourceBundleIdentifier:. TIFF is a
+/// real RGBA bitmap with `length` bytes of pixels, so thumbnails decode it.
++ (NSDictionary<NSPasteboardType, id> *)scriptedRepresentations:(RCClipRepresentationMask)representations
+                                                         length:(NSUInteger)length
+                                                           seed:(uint64_t)seed
+                                                         marked:(BOOL)marked;
+
+/// Bumps changeCount without changing the contents, as when several copies
+/// land between two polls or an app rewrites the same data.
+- (void)advanceChangeCountBy:(NSInteger)delta;
+
+/// Calls to dataForType: / stringForType: / propertyListForType: /
+/// readObjectsForClasses:options: and the bytes they returned.
+@property (atomic, readonly) NSUInteger readCount;
+@property (atomic, readonly) unsigned long long bytesRead;
+- (void)resetReadCounters;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,395 @@
+//
+//  RCPasteboardProvider.m
+//  Revclip
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#import "RCPasteboardProvider.h"
+
+@implementation RCSystemPasteboardProvider
+
++ (instancetype)shared {
+    static RCSystemPasteboardProvider *sharedProvider = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedProvider = [[self alloc] init];
+    });
+    return sharedProvider;
+}
+
+- (id<RCPasteboard>)generalPasteboard {
+    return [NSPasteboard generalPasteboard];
+}
+
+- (nullable NSString *)frontmostApplicationBundleIdentifier {
+    return [NSWorkspace sharedWorkspace].frontmostApplication.bundleIdentifier;
+}
+
+@end
+
+#pragma mark -
+
+// RCBenchPasteboardFillPayload（Benchmarks/RCBenchPasteboard.c）と同じバイト列。
+// splitmix64 を 8 バイトずつ進め、テキストの表現は英小文字にする。
+static void RCInMemoryPasteboardFillPayload(uint64_t seed, RCClipRepresentation representation,
+                                            uint8_t *bytes, NSUInteger length) {
+    uint64_t state = seed ^ ((uint64_t)representation << 56);
+    BOOL text = (representation == RCClipRepresentationString
+                 || representation == RCClipRepresentationURL
+                 || representation == RCClipRepresentationFiles);
+    for (NSUInteger index = 0; index < length; index += 8) {
+        state += 0x9E3779B97F4A7C15ull;
+        uint64_t mixed = state;
+        mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ull;
+        mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBull;
+        mixed ^= mixed >> 31;
+        NSUInteger count = MIN(length - index, (NSUInteger)8);
+        for (NSUInteger byte = 0; byte < count; byte++) {
+            uint8_t value = (uint8_t)(mixed >> (byte * 8));
+            bytes[index + byte] = text ? (uint8_t)('a' + value % 26) : value;
+        }
+    }
+}
+
+static NSData *RCInMemoryPasteboardPayload(uint64_t seed, RCClipRepresentation representation, NSUInteger length) {
+    NSMutableData *payload = [NSMutableData dataWithLength:length];
+    RCInMemoryPasteboardFillPayload(seed, representation, payload.mutableBytes, length);
+    return payload;
+}
+
+static NSString *RCInMemoryPasteboardText(uint64_t seed, RCClipRepresentation representation, NSUInteger length) {
+    return [[NSString alloc] initWithData:RCInMemoryPasteboardPayload(seed, representation, length)
+                                 encoding:NSASCIIStringEncoding] ?: @"";
+}
+
+// ピクセルが length バイト（幅は最大 1024）の RGBA ビットマップ。
+static NSData *RCInMemoryPasteboardTIFF(uint64_t seed, NSUInteger length) {
+    NSInteger width = (NSInteger)MIN((NSUInteger)1024, MAX(length / 4, (NSUInteger)1));
+    NSInteger height = (NSInteger)MAX(length / ((NSUInteger)width * 4), (NSUInteger)1);
+    NSBitmapImageRep *bitmap = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+                                                                       pixelsWide:width
+                                                                       pixelsHigh:height
+                                                                    bitsPerSample:8
+                                                                  samplesPerPixel:4
+                                                                         hasAlpha:YES
+                                                                         isPlanar:NO
+                                                                   colorSpaceName:NSDeviceRGBColorSpace
+                                                                      bytesPerRow:width * 4
+                                                                     bitsPerPixel:32];
+    if (bitmap == nil) {
+        return RCInMemoryPasteboardPayload(seed, RCClipRepresentationTIFF, length);
+    }
+    RCInMemoryPasteboardFillPayload(seed, RCClipRepresentationTIFF, bitmap.bitmapData, (NSUInteger)(width * height * 4));
+    return [bitmap TIFFRepresentation] ?: [NSData data];
+}
+
+@interface RCInMemoryPasteboard ()
+
+@property (atomic, readwrite) NSUInteger readCount;
+@property (atomic, readwrite) unsigned long long bytesRead;
+
+@end
+
+@implementation RCInMemoryPasteboard {
+    NSInteger _changeCount;
+    // 型 → NSData / NSString / プロパティリスト。挿入順を types として返す。
+    NSMutableArray<NSPasteboardType> *_types;
+    NSMutableDictionary<NSPasteboardType, id> *_representations;
+    NSString *_frontmostApplicationBundleIdentifier;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _changeCount = 1;
+        _types = [NSMutableArray array];
+        _representations = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+#pragma mark - RCPasteboardProvider
+
+- (id<RCPasteboard>)generalPasteboard {
+    return self;
+}
+
+- (nullable NSString *)frontmostApplicationBundleIdentifier {
+    @synchronized (self) {
+        return _frontmostApplicationBundleIdentifier;
+    }
+}
+
+- (void)setFrontmostApplicationBundleIdentifier:(nullable NSString *)frontmostApplicationBundleIdentifier {
+    @synchronized (self) {
+        _frontmostApplicationBundleIdentifier = [frontmostApplicationBundleIdentifier copy];
+    }
+}
+
+#pragma mark - Scripting
+
+- (NSInteger)scriptCopyWithRepresentations:(NSDictionary<NSPasteboardType, id> *)representations
+                    sourceBundleIdentifier:(nullable NSString *)sourceBundleIdentifier {
+    @synchronized (self) {
+        [self clearContents];
+        // 辞書の列挙順に依存しないよう、型名の順で types に並べる
+        for (NSPasteboardType type in [representations.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+            [_types addObject:type];
+            _representations[type] = representations[type];
+        }
+        _frontmostApplicationBundleIdentifier = [sourceBundleIdentifier copy];
+        return _changeCount;
+    }
+}
+
+- (NSInteger)scriptCopyOfType:(NSPasteboardType)type
+                       length:(NSUInteger)length
+                         seed:(uint64_t)seed
+       sourceBundleIdentifier:(nullable NSString *)sourceBundleIdentifier {
+    NSMutableData *bytes = [NSMutableData dataWithLength:length];
+    uint8_t *cursor = bytes.mutableBytes;
+    // splitmix64: 同じ seed なら同じバイト列（再コピー）になる
+    uint64_t state = seed;
+    BOOL text = [type isEqualToString:NSPasteboardTypeString];
+    for (NSUInteger i = 0; i < length; i++) {
+        if ((i & 7) == 0) {
+            state += 0x9E3779B97F4A7C15ull;
+        }
+        uint64_t mixed = state;
+        mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ull;
+        mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBull;
+        mixed ^= mixed >> 31;
+        uint8_t byte = (uint8_t)(mixed >> ((i & 7) * 8));
+        cursor[i] = text ? (uint8_t)('a' + byte % 26) : byte;
+    }
+
+    id representation = bytes;
+    if (text) {
+        representation = [[NSString alloc] initWithData:bytes encoding:NSASCIIStringEncoding] ?: @"";
+    }
+    return [self scriptCopyWithRepresentations:@{ type: representation }
+                        sourceBundleIdentifier:sourceBundleIdentifier];
+}
+
+- (NSInteger)scriptCopyOfRepresentations:(RCClipRepresentationMask)representations
+                                  length:(NSUInteger)length
+                                    seed:(uint64_t)seed
+                                  marked:(BOOL)marked
+                  sourceBundleIdentifier:(nullable NSString *)sourceBundleIdentifier {
+    return [self scriptCopyWithRepresentations:[[self class] scriptedRepresentations:representations
+                                                                              length:length
+                                                                                seed:seed
+                                                                              marked:marked]
+                        sourceBundleIdentifier:sourceBundleIdentifier];
+}
+
++ (NSDictionary<NSPasteboardType, id> *)scriptedRepresentations:(RCClipRepresentationMask)representations
+                                                         length:(NSUInteger)length
+                                                           seed:(uint64_t)seed
+                                                         marked:(BOOL)marked {
+    NSMutableDictionary<NSPasteboardType, id> *contents = [NSMutableDictionary dictionary];
+    if ((representations & RCClipRepresentationString) != 0) {
+        contents[NSPasteboardTypeString] = RCInMemoryPasteboardText(seed, RCClipRepresentationString, length);
+    }
+    if ((representations & RCClipRepresentationRTF) != 0) {
+        NSString *body = RCInMemoryPasteboardText(seed, RCClipRepresentationRTF, length);
+        contents[NSPasteboardTypeRTF] = [[NSString stringWithFormat:@"{\\rtf1\\ansi %@}", body]
+                                         dataUsingEncoding:NSASCIIStringEncoding];
+    }
+    if ((representations & RCClipRepresentationRTFD) != 0) {
+        contents[NSPasteboardTypeRTFD] = RCInMemoryPasteboardPayload(seed, RCClipRepresentationRTFD, length);
+    }
+    if ((representations & RCClipRepresentationPDF) != 0) {
+        contents[NSPasteboardTypePDF] = RCInMemoryPasteboardPayload(seed, RCClipRepresentationPDF, length);
+    }
+    if ((representations & RCClipRepresentationFiles) != 0) {
+        // Finder のファイルリスト: 名前 32 文字ごとに 1 ファイル
+        NSString *names = RCInMemoryPasteboardText(seed, RCClipRepresentationFiles, MAX(length, (NSUInteger)32));
+        NSMutableArray<NSURL *> *fileURLs = [NSMutableArray array];
+        for (NSUInteger offset = 0; offset + 32 <= names.length; offset += 32) {
+            NSString *name = [[names substringWithRange:NSMakeRange(offset, 32)] stringByAppendingPathExtension:@"txt"];
+            [fileURLs addObject:[NSURL fileURLWithPath:[@"/Users/Shared" stringByAppendingPathComponent:name]]];
+        }
+        contents[NSPasteboardTypeFileURL] = fileURLs;
+    }
+    if ((representations & RCClipRepresentationURL) != 0) {
+        contents[NSPasteboardTypeURL] = [@"https://example.com/"
+                                         stringByAppendingString:RCInMemoryPasteboardText(seed, RCClipRepresentationURL, length)];
+    }
+    if ((representations & RCClipRepresentationTIFF) != 0) {
+        contents[NSPasteboardTypeTIFF] = RCInMemoryPasteboardTIFF(seed, length);
+    }
+    if (marked) {
+        contents[@"org.nspasteboard.ConcealedType"] = [NSData data];
+    }
+    return contents;
+}
+
+- (void)advanceChangeCountBy:(NSInteger)delta {
+    @synchronized (self) {
+        _changeCount += MAX(delta, 0);
+    }
+}
+
+- (void)resetReadCounters {
+    @synchronized (self) {
+        self.readCount = 0;
+        self.bytesRead = 0;
+    }
+}
+
+- (void)countReadOfBytes:(unsigned long long)bytes {
+    @synchronized (self) {
+        self.readCount += 1;
+        self.bytesRead += bytes;
+    }
+}
+
+#pragma mark - RCPasteboard (read)
+
+- (NSInteger)changeCount {
+    @synchronized (self) {
+        return _changeCount;
+    }
+}
+
+- (nullable NSArray<NSPasteboardType> *)types {
+    @synchronized (self) {
+        return _types.count > 0 ? [_types copy] : nil;
+    }
+}
+
+- (nullable id)representationForType:(NSPasteboardType)dataType {
+    @synchronized (self) {
+        return _representations[dataType];
+    }
+}
+
+- (nullable NSData *)dataForType:(NSPasteboardType)dataType {
+    id representation = [self representationForType:dataType];
+    NSData *data = nil;
+    if ([representation isKindOfClass:[NSData class]]) {
+        data = representation;
+    } else if ([representation isKindOfClass:[NSString class]]) {
+        data = [(NSString *)representation dataUsingEncoding:NSUTF8StringEncoding];
+    } else if (representation != nil) {
+        data = [NSPropertyListSerialization dataWithPropertyList:representation
+                                                          format:NSPropertyListBinaryFormat_v1_0
+                                                         options:0
+                                                           error:NULL];
+    }
+    [self countReadOfBytes:data.length];
+    return data;
+}
+
+- (nullable NSString *)stringForType:(NSPasteboardType)dataType {
+    id representation = [self representationForType:dataType];
+    NSString *string = nil;
+    if ([representation isKindOfClass:[NSString class]]) {
+        string = representation;
+    } else if ([representation isKindOfClass:[NSData class]]) {
+        string = [[NSString alloc] initWithData:representation encoding:NSUTF8StringEncoding];
+    }
+    [self countReadOfBytes:[string lengthOfBytesUsingEncoding:NSUTF8StringEncoding]];
+    return string;
+}
+
+- (nullable id)propertyListForType:(NSPasteboardType)dataType {
+    id representation = [self representationForType:dataType];
+    id propertyList = representation;
+    if ([representation isKindOfClass:[NSData class]]) {
+        propertyList = [NSPropertyListSerialization propertyListWithData:representation
+                                                                 options:NSPropertyListImmutable
+                                                                  format:NULL
+                                                                   error:NULL];
+    }
+    [self countReadOfBytes:[representation isKindOfClass:[NSData class]] ? [(NSData *)representation length] : 0];
+    return propertyList;
+}
+
+- (nullable NSArray *)readObjectsForClasses:(NSArray<Class> *)classArray
+                                    options:(nullable NSDictionary<NSPasteboardReadingOptionKey, id> *)options {
+    // 対応するのは NSURL だけ（RCClipData がファイル URL の読み取りに使う）
+    if (![classArray containsObject:[NSURL class]]) {
+        return nil;
+    }
+    id representation = [self representationForType:NSPasteboardTypeFileURL];
+    NSMutableArray<NSURL *> *URLs = [NSMutableArray array];
+    if ([representation isKindOfClass:[NSArray class]]) {
+        for (id object in (NSArray *)representation) {
+            if ([object isKindOfClass:[NSURL class]]) {
+                [URLs addObject:object];
+            }
+        }
+    } else if ([representation isKindOfClass:[NSURL class]]) {
+        [URLs addObject:representation];
+    } else if ([representation isKindOfClass:[NSString class]]) {
+        NSURL *URL = [NSURL URLWithString:representation];
+        if (URL != nil) {
+            [URLs addObject:URL];
+        }
+    }
+    unsigned long long bytes = 0;
+    for (NSURL *URL in URLs) {
+        bytes += [URL.absoluteString lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    }
+    [self countReadOfBytes:bytes];
+    return URLs.count > 0 ? [URLs copy] : nil;
+}
+
+#pragma mark - RCPasteboard (write)
+
+- (NSInteger)clearContents {
+    @synchronized (self) {
+        [_types removeAllObjects];
+        [_representations removeAllObjects];
+        _changeCount += 1;
+        return _changeCount;
+    }
+}
+
+- (BOOL)setRepresentation:(nullable id)representation forType:(NSPasteboardType)dataType {
+    if (representation == nil) {
+        return NO;
+    }
+    @synchronized (self) {
+        if (_representations[dataType] == nil) {
+            [_types addObject:dataType];
+        }
+        _representations[dataType] = representation;
+    }
+    return YES;
+}
+
+- (BOOL)setData:(nullable NSData *)data forType:(NSPasteboardType)dataType {
+    return [self setRepresentation:[data copy] forType:dataType];
+}
+
+- (BOOL)setString:(NSString *)string forType:(NSPasteboardType)dataType {
+    return [self setRepresentation:[string copy] forType:dataType];
+}
+
+- (BOOL)setPropertyList:(id)plist forType:(NSPasteboardType)dataType {
+    return [self setRepresentation:plist forType:dataType];
+}
+
+- (BOOL)writeObjects:(NSArray<id<NSPasteboardWriting>> *)objects {
+    // NSURL / NSString だけを扱う（RCClipData の書き戻しで使われる範囲）
+    NSMutableArray<NSURL *> *URLs = [NSMutableArray array];
+    for (id<NSPasteboardWriting> object in objects) {
+        if ([(id)object isKindOfClass:[NSURL class]]) {
+            [URLs addObject:(NSURL *)object];
+        } else if ([(id)object isKindOfClass:[NSString class]]) {
+            [self setString:(NSString *)object forType:NSPasteboardTypeString];
+        } else {
+            return NO;
+        }
+    }
+    if (URLs.count > 0) {
+        [self setRepresentation:[URLs copy] forType:NSPasteboardTypeFileURL];
+    }
+    return YES;
+}
+
+@end
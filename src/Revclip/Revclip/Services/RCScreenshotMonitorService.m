@@ -26,7 +26,6 @@ static NSString * const kRCMetadataItemPath = @"kMDItemPath";
 static NSString * const kRCScreenshotClipDataFileExtension = @"rcclip";
 static NSString * const kRCScreenCaptureDefaultsDomain = @"com.apple.screencapture";
 static NSString * const kRCScreenCaptureLocationKey = @"location";
-static NSInteger const kRCDefaultMaxClipSizeBytes = 52428800;
 
 static os_log_t RCScreenshotMonitorServiceLog(void) {
     static os_log_t logger = nil;
@@ -375,7 +374,19 @@ static os_log_t RCScreenshotMonitorServiceLog(void) {
     clipData.TIFFData = tiffData;
     clipData.primaryType = NSPasteboardTypeTIFF;
 
-    NSString *dataHash = [clipData dataHash];
+    // 上限は TIFF の生の長さで判定し、ハッシュやアーカイブの前に弾く
+    unsigned long long payloadLength = clipData.payloadLength;
+    unsigned long long maxClipSizeBytes = [RCUtilities maxClipSizeBytes];
+    if (payloadLength > maxClipSizeBytes) {
+        os_log_debug(RCScreenshotMonitorServiceLog(),
+                     "Skipping screenshot save because payload size (%llu bytes) exceeds limit (%llu bytes)",
+                     payloadLength,
+                     maxClipSizeBytes);
+        return;
+    }
+
+    RCClipDataDigests *digests = [clipData storageDigests];
+    NSString *dataHash = digests.dataHash;
     if (dataHash.length == 0) {
         return;
     }
@@ -388,13 +399,11 @@ static os_log_t RCScreenshotMonitorServiceLog(void) {
     NSInteger updateTime = (NSInteger)([[NSDate date] timeIntervalSince1970] * 1000.0);
 
     // If an identical screenshot already exists in history, just update its timestamp
-    NSDictionary *existingClipDict = [databaseManager clipItemWithDataHash:dataHash];
-    if (existingClipDict != nil) {
-        if ([databaseManager updateClipItemUpdateTime:dataHash time:updateTime]) {
-            NSMutableDictionary *updatedDict = [existingClipDict mutableCopy];
-            updatedDict[@"update_time"] = @(updateTime);
-            RCClipItem *updatedItem = [[RCClipItem alloc] initWithDictionary:updatedDict];
-            [self postClipboardDidChangeNotificationWithClipItem:updatedItem];
+    RCClipItem *existingClipItem = [databaseManager clipItemForCapturedClipData:clipData dataHash:dataHash];
+    if (existingClipItem != nil) {
+        if ([databaseManager updateClipItemUpdateTime:existingClipItem.dataHash time:updateTime]) {
+            existingClipItem.updateTime = updateTime;
+            [self postClipboardDidChangeNotificationWithClipItem:existingClipItem];
         }
         return;
     }
@@ -410,39 +419,8 @@ static os_log_t RCScreenshotMonitorServiceLog(void) {
     NSString *dataFileName = [NSString stringWithFormat:@"%@.%@", identifier, kRCScreenshotClipDataFileExtension];
     NSString *dataPath = [directoryPath stringByAppendingPathComponent:dataFileName];
 
-    NSError *archiveError = nil;
-    NSData *archivedData = [NSKeyedArchiver archivedDataWithRootObject:clipData
-                                                  requiringSecureCoding:YES
-                                                                  error:&archiveError];
-    if (archivedData == nil) {
-        os_log_error(RCScreenshotMonitorServiceLog(),
-                     "Failed to archive screenshot clip data before size check (%{private}@)",
-                     archiveError.localizedDescription);
-        return;
-    }
-
-    // CFBooleanRef チェック付きの安全な読み取り
-    id rawValue = [[NSUserDefaults standardUserDefaults] objectForKey:kRCPrefMaxClipSizeBytesKey];
-    NSInteger maxClipSizeBytes = kRCDefaultMaxClipSizeBytes;
-    if ([rawValue isKindOfClass:[NSNumber class]] &&
-        CFGetTypeID((__bridge CFTypeRef)rawValue) != CFBooleanGetTypeID()) {
-        maxClipSizeBytes = [(NSNumber *)rawValue integerValue];
-    } else if ([rawValue isKindOfClass:[NSString class]]) {
-        maxClipSizeBytes = [(NSString *)rawValue integerValue];
-    }
-    if (maxClipSizeBytes < 1048576) {
-        maxClipSizeBytes = kRCDefaultMaxClipSizeBytes;
-    }
-
-    if (archivedData.length > (NSUInteger)maxClipSizeBytes) {
-        os_log_debug(RCScreenshotMonitorServiceLog(),
-                     "Skipping screenshot save because archived data size (%lu bytes) exceeds limit (%ld bytes)",
-                     (unsigned long)archivedData.length,
-                     (long)maxClipSizeBytes);
-        return;
-    }
-
-    if (![clipData saveToPath:dataPath]) {
+    NSArray<NSString *> *blobDigests = nil;
+    if (![clipData saveToPath:dataPath digests:digests blobDigests:&blobDigests]) {
         return;
     }
 
@@ -451,17 +429,17 @@ static os_log_t RCScreenshotMonitorServiceLog(void) {
                                                    identifier:identifier
                                                 directoryPath:directoryPath];
 
-    NSDictionary *clipDictionary = @{
-        @"data_path": dataPath,
-        @"title": [clipData title] ?: @"",
-        @"data_hash": dataHash,
-        @"primary_type": clipData.primaryType ?: @"",
-        @"update_time": @(updateTime),
-        @"thumbnail_path": thumbnailPath ?: @"",
-        @"is_color_code": @(NO),
-    };
-
-    if (![databaseManager insertClipItem:clipDictionary]) {
+    RCClipItem *clipItem = [[RCClipItem alloc] init];
+    clipItem.dataPath = dataPath;
+    clipItem.title = [clipData title] ?: @"";
+    clipItem.dataHash = dataHash;
+    clipItem.primaryType = clipData.primaryType ?: @"";
+    clipItem.updateTime = updateTime;
+    clipItem.thumbnailPath = thumbnailPath ?: @"";
+    clipItem.isColorCode = NO;
+    clipItem.blobDigests = blobDigests;
+
+    if (![databaseManager insertClipItemObject:clipItem]) {
         [RCPanicEraseService secureOverwriteFileAtPath:dataPath];
         [[NSFileManager defaultManager] removeItemAtPath:dataPath error:nil];
         if (thumbnailPath.length > 0) {
@@ -471,7 +449,6 @@ static os_log_t RCScreenshotMonitorServiceLog(void) {
         return;
     }
 
-    RCClipItem *clipItem = [[RCClipItem alloc] initWithDictionary:clipDictionary];
     [[RCDataCleanService shared] scheduleDebouncedCleanup];
     [self postClipboardDidChangeNotificationWithClipItem:clipItem];
 }
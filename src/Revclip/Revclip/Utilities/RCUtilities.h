@@ -7,6 +7,8 @@
 
 #import <Foundation/Foundation.h>
 
+#import "RCQueryMetrics.h"
+
 NS_ASSUME_NONNULL_BEGIN
 
 @interface RCUtilities : NSObject
@@ -23,9 +25,24 @@ NS_ASSUME_NONNULL_BEGIN
 // ディレクトリの自動作成
 + (BOOL)ensureDirectoryExists:(NSString *)path;
 
+// kRCPrefMaxClipSizeBytesKey（1 MB 未満や読めない値は既定の 50 MB）
++ (unsigned long long)maxClipSizeBytes;
+
 // データ保護属性の適用（権限修復 + Backup/Spotlight除外）
 + (void)applyDataProtectionAttributes;
 
+// ダイジェストと小文字 16 進文字列の相互変換。
+// DB のキーは 32 バイト BLOB で保持し、16 進文字列は API の境界でのみ生成する。
++ (NSString *)hexStringFromBytes:(const void *)bytes length:(NSUInteger)length;
++ (NSString *)hexStringFromData:(NSData *)data;
+// 奇数長や 16 進以外の文字を含む場合は nil
++ (nullable NSData *)dataFromHexString:(NSString *)hexString;
+
+// 診断用 JSON: レイテンシのヒストグラムを μs 単位の辞書に変換する（パーセンタイルはバケットの上限）
++ (NSDictionary<NSString *, id> *)dictionaryFromLatencySnapshot:(const RCLatencySnapshot *)snapshot;
+// 最後のバケット以外の上限（μs）
++ (NSArray<NSNumber *> *)latencyBucketUpperBoundsMicroseconds;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -13,6 +13,8 @@ static NSString * const kRCDatabaseFileName = @"revclip.db";
 static NSString * const kRCNeverIndexFileName = @".metadata_never_index";
 static NSNumber * const kRCDirectoryPermissions = @(0700);
 static NSNumber * const kRCFilePermissions = @(0600);
+static unsigned long long const kRCDefaultMaxClipSizeBytes = 52428800;
+static unsigned long long const kRCMinimumMaxClipSizeBytes = 1048576;
 
 @interface RCUtilities ()
 
@@ -30,6 +32,7 @@ static NSNumber * const kRCFilePermissions = @(0600);
         kRCPrefAutoExpiryValueKey: @30,
         kRCPrefAutoExpiryUnitKey: @0,
         kRCPrefMaxClipSizeBytesKey: @52428800,
+        kRCPrefCompressClipDataKey: @YES,
         kRCPrefInputPasteCommandKey: @YES,
         kRCPrefReorderClipsAfterPasting: @YES,
         kRCPrefShowStatusItemKey: @1,
@@ -63,6 +66,7 @@ static NSNumber * const kRCFilePermissions = @(0600);
         kRCThumbnailHeightKey: @32,
         kRCPrefAddClearHistoryMenuItemKey: @YES,
         kRCPrefShowAlertBeforeClearHistoryKey: @YES,
+        kRCPrefShowDebugMenuKey: @NO,
         kRCEnableAutomaticCheckKey: @YES,
         kRCUpdateCheckIntervalKey: @86400,
         kRCBetaPastePlainText: @YES,
@@ -131,6 +135,22 @@ static NSNumber * const kRCFilePermissions = @(0600);
     return created;
 }
 
++ (unsigned long long)maxClipSizeBytes {
+    // CFBooleanRef チェック付きの安全な読み取り
+    id rawValue = [[NSUserDefaults standardUserDefaults] objectForKey:kRCPrefMaxClipSizeBytesKey];
+    long long maxClipSizeBytes = 0;
+    if ([rawValue isKindOfClass:[NSNumber class]] &&
+        CFGetTypeID((__bridge CFTypeRef)rawValue) != CFBooleanGetTypeID()) {
+        maxClipSizeBytes = [(NSNumber *)rawValue longLongValue];
+    } else if ([rawValue isKindOfClass:[NSString class]]) {
+        maxClipSizeBytes = [(NSString *)rawValue longLongValue];
+    }
+    if (maxClipSizeBytes < (long long)kRCMinimumMaxClipSizeBytes) {
+        return kRCDefaultMaxClipSizeBytes;
+    }
+    return (unsigned long long)maxClipSizeBytes;
+}
+
 + (void)applyDataProtectionAttributes {
     NSFileManager *fileManager = [NSFileManager defaultManager];
     NSString *applicationSupportPath = [self applicationSupportPath];
@@ -197,6 +217,83 @@ static NSNumber * const kRCFilePermissions = @(0600);
     }
 }
 
++ (NSString *)hexStringFromBytes:(const void *)bytes length:(NSUInteger)length {
+    static const char kHexDigits[] = "0123456789abcdef";
+    if (bytes == NULL || length == 0) {
+        return @"";
+    }
+
+    const unsigned char *input = bytes;
+    char *output = malloc(length * 2);
+    if (output == NULL) {
+        return @"";
+    }
+    for (NSUInteger index = 0; index < length; index++) {
+        output[index * 2] = kHexDigits[input[index] >> 4];
+        output[index * 2 + 1] = kHexDigits[input[index] & 0x0F];
+    }
+    return [[NSString alloc] initWithBytesNoCopy:output
+                                          length:length * 2
+                                        encoding:NSASCIIStringEncoding
+                                    freeWhenDone:YES];
+}
+
++ (NSString *)hexStringFromData:(NSData *)data {
+    return [self hexStringFromBytes:data.bytes length:data.length];
+}
+
++ (nullable NSData *)dataFromHexString:(NSString *)hexString {
+    NSUInteger hexLength = hexString.length;
+    if (hexLength == 0 || (hexLength % 2) != 0) {
+        return nil;
+    }
+
+    NSMutableData *data = [NSMutableData dataWithLength:hexLength / 2];
+    unsigned char *output = data.mutableBytes;
+    for (NSUInteger index = 0; index < hexLength; index++) {
+        unichar character = [hexString characterAtIndex:index];
+        unsigned char nibble = 0;
+        if (character >= '0' && character <= '9') {
+            nibble = (unsigned char)(character - '0');
+        } else if (character >= 'a' && character <= 'f') {
+            nibble = (unsigned char)(character - 'a' + 10);
+        } else if (character >= 'A' && character <= 'F') {
+            nibble = (unsigned char)(character - 'A' + 10);
+        } else {
+            return nil;
+        }
+        output[index / 2] = (unsigned char)((index % 2 == 0) ? (nibble << 4) : (output[index / 2] | nibble));
+    }
+    return [data copy];
+}
+
+// バケットは 2 倍刻みなので、パーセンタイルはそのバケットの上限（μs）で返す。
++ (NSDictionary<NSString *, id> *)dictionaryFromLatencySnapshot:(const RCLatencySnapshot *)snapshot {
+    NSMutableDictionary<NSString *, NSNumber *> *buckets = [NSMutableDictionary dictionary];
+    for (size_t bucket = 0; bucket < RC_LATENCY_BUCKET_COUNT; bucket++) {
+        if (snapshot->buckets[bucket] > 0) {
+            buckets[[NSString stringWithFormat:@"%zu", bucket]] = @(snapshot->buckets[bucket]);
+        }
+    }
+    return @{
+        @"count": @(snapshot->count),
+        @"totalMicroseconds": @(snapshot->totalNanoseconds / 1000),
+        @"maxMicroseconds": @(snapshot->maxNanoseconds / 1000),
+        @"p50Microseconds": @(RCLatencySnapshotPercentileNanoseconds(snapshot, 0.50) / 1000),
+        @"p90Microseconds": @(RCLatencySnapshotPercentileNanoseconds(snapshot, 0.90) / 1000),
+        @"p99Microseconds": @(RCLatencySnapshotPercentileNanoseconds(snapshot, 0.99) / 1000),
+        @"buckets": buckets,
+    };
+}
+
++ (NSArray<NSNumber *> *)latencyBucketUpperBoundsMicroseconds {
+    NSMutableArray<NSNumber *> *bucketUpperBounds = [NSMutableArray arrayWithCapacity:RC_LATENCY_BUCKET_COUNT - 1];
+    for (size_t bucket = 0; bucket + 1 < RC_LATENCY_BUCKET_COUNT; bucket++) {
+        [bucketUpperBounds addObject:@(RCLatencyBucketUpperBoundNanoseconds(bucket) / 1000)];
+    }
+    return bucketUpperBounds;
+}
+
 + (BOOL)applyPOSIXPermissions:(NSNumber *)permissions toPath:(NSString *)path fileManager:(NSFileManager *)fileManager {
     NSString *expandedPath = [[path stringByExpandingTildeInPath] stringByStandardizingPath];
     if (expandedPath.length == 0 || permissions == nil) {
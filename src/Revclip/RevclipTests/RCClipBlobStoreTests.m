@@ -0,0 +1,194 @@
+#import <Security/Security.h>
+#import <XCTest/XCTest.h>
+
+#import "RCClipBlobStore.h"
+#import "RCClipData.h"
+#import "RCDatabaseTestSupport.h"
+#import "RCUtilities.h"
+
+@interface RCClipBlobStoreTests : RCDatabaseTestCase
+
+@property (nonatomic, assign) NSTimeInterval savedReleaseGracePeriod;
+
+@end
+
+@implementation RCClipBlobStoreTests
+
+- (void)setUp {
+    [super setUp];
+    self.savedReleaseGracePeriod = [RCClipBlobStore shared].releaseGracePeriod;
+    XCTAssertTrue([RCUtilities ensureDirectoryExists:[RCUtilities clipDataDirectoryPath]]);
+}
+
+- (void)tearDown {
+    [RCClipBlobStore shared].releaseGracePeriod = self.savedReleaseGracePeriod;
+    [super tearDown];
+}
+
+- (NSData *)randomDataWithLength:(NSUInteger)length {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    XCTAssertEqual(SecRandomCopyBytes(kSecRandomDefault, length, data.mutableBytes), errSecSuccess);
+    return data;
+}
+
+- (RCClipItem *)saveAndInsertClipData:(RCClipData *)clipData {
+    RCClipItem *clipItem = [self clipItemWithTitle:@"blob"
+                                        updateTime:(NSInteger)([[NSDate date] timeIntervalSince1970] * 1000)];
+    NSArray<NSString *> *blobDigests = nil;
+    XCTAssertTrue([clipData saveToPath:clipItem.dataPath blobDigests:&blobDigests]);
+    [self.createdPaths addObject:clipItem.dataPath];
+    clipItem.primaryType = @"public.tiff";
+    clipItem.blobDigests = blobDigests;
+    XCTAssertTrue([self.databaseManager insertClipItemObject:clipItem]);
+    return clipItem;
+}
+
+- (void)testIdenticalPayloadsShareOneBlobUntilLastReferenceGoes {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    RCClipBlobStore *blobStore = [RCClipBlobStore shared];
+    RCClipData *clipData = [[RCClipData alloc] init];
+    clipData.TIFFData = [self randomDataWithLength:256 * 1024];
+
+    RCClipItem *firstItem = [self saveAndInsertClipData:clipData];
+    RCClipItem *secondItem = [self saveAndInsertClipData:clipData];
+    XCTAssertEqual(firstItem.blobDigests.count, 1u);
+    XCTAssertEqualObjects(firstItem.blobDigests, secondItem.blobDigests);
+    NSString *digest = firstItem.blobDigests.firstObject;
+    NSString *blobPath = [blobStore pathForDigest:digest];
+    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:blobPath]);
+
+    // .rcclip にはペイロードを埋め込まず、読み込み時にブロブから戻す
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:firstItem.dataPath error:nil];
+    XCTAssertLessThan(attributes.fileSize, (unsigned long long)clipData.TIFFData.length);
+    XCTAssertEqualObjects([RCClipData clipDataFromPath:secondItem.dataPath].TIFFData, clipData.TIFFData);
+
+    XCTAssertTrue([databaseManager deleteClipItemWithDataHash:firstItem.dataHash]);
+    XCTAssertTrue([databaseManager isBlobDigestReferenced:digest]);
+    XCTAssertFalse([[databaseManager releasedBlobDigestsWithLimit:1000] containsObject:digest]);
+
+    XCTAssertTrue([databaseManager deleteClipItemWithDataHash:secondItem.dataHash]);
+    XCTAssertFalse([databaseManager isBlobDigestReferenced:digest]);
+    XCTAssertTrue([[databaseManager releasedBlobDigestsWithLimit:1000] containsObject:digest]);
+
+    // 猶予期間内は残し、過ぎたら削除する
+    blobStore.releaseGracePeriod = 3600;
+    XCTAssertFalse([blobStore removeReleasedBlobWithDigest:digest isReferenced:^BOOL{
+        return [databaseManager isBlobDigestReferenced:digest];
+    }]);
+    blobStore.releaseGracePeriod = 0;
+    XCTAssertTrue([blobStore removeReleasedBlobWithDigest:digest isReferenced:^BOOL{
+        return [databaseManager isBlobDigestReferenced:digest];
+    }]);
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:blobPath]);
+    XCTAssertTrue([databaseManager forgetReleasedBlobDigests:@[digest]]);
+    XCTAssertFalse([[databaseManager releasedBlobDigestsWithLimit:1000] containsObject:digest]);
+}
+
+- (void)testSmallPayloadsStayInline {
+    RCClipData *clipData = [[RCClipData alloc] init];
+    clipData.TIFFData = [self randomDataWithLength:1024];
+
+    RCClipItem *clipItem = [self saveAndInsertClipData:clipData];
+    XCTAssertEqual(clipItem.blobDigests.count, 0u);
+    XCTAssertEqualObjects([RCClipData clipDataFromPath:clipItem.dataPath].TIFFData, clipData.TIFFData);
+}
+
+- (void)testReferencedBlobIsNotRemoved {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    RCClipBlobStore *blobStore = [RCClipBlobStore shared];
+    RCClipData *clipData = [[RCClipData alloc] init];
+    clipData.PDFData = [self randomDataWithLength:64 * 1024];
+
+    RCClipItem *clipItem = [self saveAndInsertClipData:clipData];
+    NSString *digest = clipItem.blobDigests.firstObject;
+    XCTAssertNotNil(digest);
+
+    blobStore.releaseGracePeriod = 0;
+    XCTAssertTrue([blobStore removeReleasedBlobWithDigest:digest isReferenced:^BOOL{
+        return [databaseManager isBlobDigestReferenced:digest];
+    }]);
+    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:[blobStore pathForDigest:digest]]);
+    XCTAssertEqualObjects([RCClipData clipDataFromPath:clipItem.dataPath].PDFData, clipData.PDFData);
+}
+
+- (void)testCompressibleBlobIsStoredCompressedAndReused {
+    RCClipBlobStore *blobStore = [RCClipBlobStore shared];
+    NSMutableData *payload = [NSMutableData dataWithLength:256 * 1024];
+    uint8_t *bytes = payload.mutableBytes;
+    for (NSUInteger index = 0; index < payload.length; index++) {
+        bytes[index] = (uint8_t)((index / 64) % 7);
+    }
+
+    NSString *digest = [blobStore storeData:payload];
+    XCTAssertNotNil(digest);
+    NSString *blobPath = [blobStore pathForDigest:digest];
+    [self.createdPaths addObject:blobPath];
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:blobPath error:nil];
+    XCTAssertLessThan(attributes.fileSize, (unsigned long long)payload.length / 4);
+    XCTAssertEqualObjects([blobStore dataForDigest:digest], payload);
+
+    // 同じ内容は書き直さない（展開後の長さで既存ブロブと照合する）。
+    XCTAssertEqualObjects([blobStore storeData:payload digest:digest], digest);
+    NSDictionary *reusedAttributes = [[NSFileManager defaultManager] attributesOfItemAtPath:blobPath error:nil];
+    XCTAssertEqual(reusedAttributes.fileSystemFileNumber, attributes.fileSystemFileNumber);
+}
+
+- (void)testIncompressibleBlobStaysRaw {
+    RCClipBlobStore *blobStore = [RCClipBlobStore shared];
+    NSData *payload = [self randomDataWithLength:64 * 1024];
+    NSString *digest = [blobStore storeData:payload];
+    XCTAssertNotNil(digest);
+    NSString *blobPath = [blobStore pathForDigest:digest];
+    [self.createdPaths addObject:blobPath];
+    XCTAssertEqualObjects([NSData dataWithContentsOfFile:blobPath], payload);
+    XCTAssertEqualObjects([blobStore dataForDigest:digest], payload);
+}
+
+- (void)testStorageDigestsMatchSeparateHashing {
+    RCClipData *clipData = [[RCClipData alloc] init];
+    clipData.stringValue = @"caption";
+    clipData.TIFFData = [self randomDataWithLength:600 * 1024];
+
+    RCClipDataDigests *digests = [clipData storageDigests];
+    XCTAssertEqualObjects(digests.dataHash, [clipData dataHash]);
+    // 文字列で dataHash が決まっても、ブロブに出す TIFF のダイジェストは求めておく
+    NSString *storedDigest = [[RCClipBlobStore shared] storeData:clipData.TIFFData];
+    XCTAssertEqualObjects(digests.blobDigestsByKey[@"TIFFData"], storedDigest);
+
+    RCClipData *imageOnly = [[RCClipData alloc] init];
+    imageOnly.TIFFData = clipData.TIFFData;
+    imageOnly.primaryType = @"public.tiff";
+    RCClipDataDigests *imageDigests = [imageOnly storageDigests];
+    XCTAssertEqualObjects(imageDigests.dataHash, [imageOnly dataHash]);
+    XCTAssertEqualObjects(imageDigests.blobDigestsByKey[@"TIFFData"], storedDigest);
+}
+
+- (void)testPayloadLengthCountsRawRepresentations {
+    RCClipData *clipData = [[RCClipData alloc] init];
+    clipData.stringValue = @"あいう";
+    clipData.PDFData = [self randomDataWithLength:100];
+    clipData.fileNames = @[@"/tmp/a"];
+    clipData.URLString = @"https://example.com";
+    XCTAssertEqual(clipData.payloadLength, 9ull + 100ull + 6ull + 19ull);
+}
+
+- (void)testSavingWithPrecomputedDigestsRoundTrips {
+    RCClipData *clipData = [[RCClipData alloc] init];
+    clipData.stringValue = @"caption";
+    clipData.TIFFData = [self randomDataWithLength:64 * 1024];
+    RCClipDataDigests *digests = [clipData storageDigests];
+
+    NSString *path = [[RCUtilities clipDataDirectoryPath]
+                      stringByAppendingPathComponent:[[NSUUID UUID].UUIDString stringByAppendingPathExtension:@"rcclip"]];
+    NSArray<NSString *> *blobDigests = nil;
+    XCTAssertTrue([clipData saveToPath:path digests:digests blobDigests:&blobDigests]);
+    [self.createdPaths addObject:path];
+    XCTAssertEqualObjects(blobDigests, @[digests.blobDigestsByKey[@"TIFFData"]]);
+
+    RCClipData *loaded = [RCClipData clipDataFromPath:path];
+    XCTAssertEqualObjects(loaded.stringValue, clipData.stringValue);
+    XCTAssertEqualObjects(loaded.TIFFData, clipData.TIFFData);
+    XCTAssertEqualObjects([loaded dataHash], digests.dataHash);
+}
+
+@end
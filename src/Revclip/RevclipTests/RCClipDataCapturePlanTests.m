@@ -0,0 +1,68 @@
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+
+#import "RCClipData.h"
+
+@interface RCClipDataCapturePlanTests : XCTestCase
+
+@property (nonatomic, strong) NSPasteboard *pasteboard;
+
+@end
+
+@implementation RCClipDataCapturePlanTests
+
+- (void)setUp {
+    [super setUp];
+    self.pasteboard = [NSPasteboard pasteboardWithUniqueName];
+    [self.pasteboard clearContents];
+}
+
+- (void)tearDown {
+    [self.pasteboard releaseGlobally];
+    [super tearDown];
+}
+
+- (void)testDisabledTypeIsNeverRead {
+    NSMutableData *image = [NSMutableData dataWithLength:8 * 1024 * 1024];
+    [self.pasteboard setData:image forType:NSPasteboardTypeTIFF];
+
+    RCCapturePlan plan = RCCapturePlanMake(RC_CLIP_REPRESENTATION_ALL & ~RCClipRepresentationTIFF, 50 * 1024 * 1024);
+    RCCaptureVerdict verdict = RCCaptureVerdictRead;
+    XCTAssertNil([RCClipData clipDataFromPasteboard:self.pasteboard plan:&plan verdict:&verdict]);
+    XCTAssertEqual(verdict, RCCaptureVerdictSkipDisabled);
+}
+
+- (void)testOnlyEnabledRepresentationsAreStored {
+    [self.pasteboard setString:@"https://example.com" forType:NSPasteboardTypeString];
+    [self.pasteboard setData:[NSMutableData dataWithLength:1024] forType:NSPasteboardTypeTIFF];
+
+    RCCapturePlan plan = RCCapturePlanMake(RCClipRepresentationString, 50 * 1024 * 1024);
+    RCCaptureVerdict verdict = RCCaptureVerdictSkipEmpty;
+    RCClipData *clipData = [RCClipData clipDataFromPasteboard:self.pasteboard plan:&plan verdict:&verdict];
+    XCTAssertEqual(verdict, RCCaptureVerdictRead);
+    XCTAssertEqualObjects(clipData.stringValue, @"https://example.com");
+    XCTAssertNil(clipData.TIFFData);
+    XCTAssertEqualObjects(clipData.primaryType, NSPasteboardTypeString);
+}
+
+- (void)testMarkerTypeSkipsClip {
+    [self.pasteboard setString:@"secret" forType:NSPasteboardTypeString];
+    [self.pasteboard setData:[NSData data] forType:@"org.nspasteboard.ConcealedType"];
+
+    RCCapturePlan plan = RCCapturePlanMake(RC_CLIP_REPRESENTATION_ALL, 50 * 1024 * 1024);
+    RCCaptureVerdict verdict = RCCaptureVerdictRead;
+    XCTAssertNil([RCClipData clipDataFromPasteboard:self.pasteboard plan:&plan verdict:&verdict]);
+    XCTAssertEqual(verdict, RCCaptureVerdictSkipMarked);
+}
+
+- (void)testOversizedClipStopsReading {
+    [self.pasteboard setString:@"caption" forType:NSPasteboardTypeString];
+    [self.pasteboard setData:[NSMutableData dataWithLength:64 * 1024] forType:NSPasteboardTypeTIFF];
+
+    RCCapturePlan plan = RCCapturePlanMake(RC_CLIP_REPRESENTATION_ALL, 1024);
+    RCCaptureVerdict verdict = RCCaptureVerdictRead;
+    XCTAssertNil([RCClipData clipDataFromPasteboard:self.pasteboard plan:&plan verdict:&verdict]);
+    XCTAssertEqual(verdict, RCCaptureVerdictSkipOversized);
+}
+
+@end
@@ -0,0 +1,258 @@
+#import <XCTest/XCTest.h>
+
+#import "RCClipContainer.h"
+#import "RCClipData.h"
+#import "RCConstants.h"
+#import "RCUtilities.h"
+
+@interface RCClipDataContainerTests : XCTestCase
+
+@property (nonatomic, strong) NSMutableArray<NSString *> *createdPaths;
+
+@end
+
+@implementation RCClipDataContainerTests
+
+- (void)setUp {
+    [super setUp];
+    self.createdPaths = [NSMutableArray array];
+    XCTAssertTrue([RCUtilities ensureDirectoryExists:[RCUtilities clipDataDirectoryPath]]);
+}
+
+- (void)tearDown {
+    for (NSString *path in self.createdPaths) {
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    }
+    [super tearDown];
+}
+
+- (NSString *)temporaryClipPath {
+    NSString *fileName = [[NSUUID UUID].UUIDString stringByAppendingPathExtension:@"rcclip"];
+    NSString *path = [[RCUtilities clipDataDirectoryPath] stringByAppendingPathComponent:fileName];
+    [self.createdPaths addObject:path];
+    return path;
+}
+
+- (RCClipData *)sampleClipData {
+    RCClipData *clipData = [[RCClipData alloc] init];
+    clipData.stringValue = @"コンテナ";
+    clipData.RTFData = [@"{\\rtf1 a}" dataUsingEncoding:NSUTF8StringEncoding];
+    clipData.fileNames = @[@"/tmp/a.txt", @"/tmp/b c.txt"];
+    clipData.fileURLs = @[[NSURL fileURLWithPath:@"/tmp/a.txt"]];
+    clipData.URLString = @"";
+    clipData.TIFFData = [NSMutableData dataWithLength:4096];
+    clipData.primaryType = @"public.utf8-plain-text";
+    return clipData;
+}
+
+- (BOOL)fileAtPathIsContainer:(NSString *)path {
+    NSData *data = [NSData dataWithContentsOfFile:path];
+    return RCClipContainerHasMagic(data.bytes, data.length);
+}
+
+- (uint32_t)flagsOfSection:(RCClipSectionType)type atPath:(NSString *)path {
+    RCClipContainer *container = NULL;
+    XCTAssertEqual(RCClipContainerOpenFile(path.fileSystemRepresentation, &container), RCClipContainerOK);
+    RCClipSection section;
+    RCClipContainerStatus status = RCClipContainerFindSection(container, type, &section);
+    RCClipContainerClose(container);
+    XCTAssertEqual(status, RCClipContainerOK);
+    return status == RCClipContainerOK ? section.flags : UINT32_MAX;
+}
+
+- (RCClipData *)compressibleClipData {
+    NSMutableString *text = [NSMutableString string];
+    for (NSUInteger index = 0; index < 500; index++) {
+        [text appendFormat:@"%lu: クリップボードの履歴 clipboard history line\n", (unsigned long)index];
+    }
+    RCClipData *clipData = [[RCClipData alloc] init];
+    clipData.stringValue = text;
+    clipData.TIFFData = [NSMutableData dataWithLength:8192];
+    clipData.primaryType = @"public.utf8-plain-text";
+    return clipData;
+}
+
+- (void)testSavedClipRoundTripsThroughContainer {
+    RCClipData *clipData = [self sampleClipData];
+    NSString *path = [self temporaryClipPath];
+    XCTAssertTrue([clipData saveToPath:path]);
+    XCTAssertTrue([self fileAtPathIsContainer:path]);
+
+    RCClipData *loaded = [RCClipData clipDataFromPath:path];
+    XCTAssertEqualObjects(loaded.stringValue, clipData.stringValue);
+    XCTAssertEqualObjects(loaded.RTFData, clipData.RTFData);
+    XCTAssertNil(loaded.RTFDData);
+    XCTAssertNil(loaded.PDFData);
+    XCTAssertEqualObjects(loaded.fileNames, clipData.fileNames);
+    XCTAssertEqualObjects(loaded.fileURLs, clipData.fileURLs);
+    XCTAssertEqualObjects(loaded.URLString, @"");
+    XCTAssertEqualObjects(loaded.TIFFData, clipData.TIFFData);
+    XCTAssertEqualObjects(loaded.primaryType, clipData.primaryType);
+    XCTAssertEqualObjects([loaded dataHash], [clipData dataHash]);
+}
+
+- (void)testSelectedRepresentationsSkipOtherSections {
+    RCClipData *clipData = [self sampleClipData];
+    NSString *path = [self temporaryClipPath];
+    XCTAssertTrue([clipData saveToPath:path]);
+
+    RCClipData *loaded = [RCClipData clipDataFromPath:path
+                                      representations:RCClipDataRepresentationString | RCClipDataRepresentationURL];
+    XCTAssertEqualObjects(loaded.stringValue, clipData.stringValue);
+    XCTAssertEqualObjects(loaded.primaryType, clipData.primaryType);
+    XCTAssertNil(loaded.TIFFData);
+    XCTAssertNil(loaded.fileNames);
+}
+
+- (void)testLegacyArchiveIsReadAndMigrated {
+    RCClipData *clipData = [self sampleClipData];
+    NSString *path = [self temporaryClipPath];
+    NSData *archiveData = [NSKeyedArchiver archivedDataWithRootObject:clipData requiringSecureCoding:YES error:nil];
+    XCTAssertNotNil(archiveData);
+    XCTAssertTrue([archiveData writeToFile:path atomically:YES]);
+    XCTAssertFalse([self fileAtPathIsContainer:path]);
+
+    RCClipData *loaded = [RCClipData clipDataFromPath:path];
+    XCTAssertEqualObjects([loaded dataHash], [clipData dataHash]);
+    XCTAssertEqualObjects(loaded.TIFFData, clipData.TIFFData);
+
+    // 書き換えはバックグラウンドで行われる。
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:5.0];
+    while (![self fileAtPathIsContainer:path] && [deadline timeIntervalSinceNow] > 0) {
+        [NSThread sleepForTimeInterval:0.02];
+    }
+    XCTAssertTrue([self fileAtPathIsContainer:path]);
+    RCClipData *migrated = [RCClipData clipDataFromPath:path];
+    XCTAssertEqualObjects(migrated.fileNames, clipData.fileNames);
+    XCTAssertEqualObjects(migrated.TIFFData, clipData.TIFFData);
+    XCTAssertEqualObjects([migrated dataHash], [clipData dataHash]);
+}
+
+- (void)testCompressibleSectionsAreStoredCompressed {
+    RCClipData *clipData = [self compressibleClipData];
+    NSString *path = [self temporaryClipPath];
+    XCTAssertTrue([clipData saveToPath:path]);
+
+    NSUInteger rawLength = [clipData.stringValue lengthOfBytesUsingEncoding:NSUTF8StringEncoding] + clipData.TIFFData.length;
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil];
+    XCTAssertLessThan(attributes.fileSize, (unsigned long long)rawLength / 2);
+    // 本文は展開の速い LZ4、画像は deflate、短い primaryType は生のまま。
+    XCTAssertEqual([self flagsOfSection:RCClipSectionString atPath:path], RC_CLIP_SECTION_FLAG_LZ4);
+    XCTAssertEqual([self flagsOfSection:RCClipSectionTIFF atPath:path], RC_CLIP_SECTION_FLAG_DEFLATE);
+    XCTAssertEqual([self flagsOfSection:RCClipSectionPrimaryType atPath:path], 0u);
+
+    RCClipData *loaded = [RCClipData clipDataFromPath:path];
+    XCTAssertEqualObjects(loaded.stringValue, clipData.stringValue);
+    XCTAssertEqualObjects(loaded.TIFFData, clipData.TIFFData);
+    XCTAssertEqualObjects([loaded dataHash], [clipData dataHash]);
+
+    // 文字列だけを読むときは TIFF セクションに触れない（壊れていても読める）。
+    NSMutableData *bytes = [NSMutableData dataWithContentsOfFile:path];
+    RCClipContainer *container = NULL;
+    XCTAssertEqual(RCClipContainerOpenBytes(bytes.bytes, bytes.length, &container), RCClipContainerOK);
+    RCClipSection section;
+    XCTAssertEqual(RCClipContainerFindSection(container, RCClipSectionTIFF, &section), RCClipContainerOK);
+    NSUInteger tiffOffset = (NSUInteger)(section.bytes - (const uint8_t *)bytes.bytes) + (NSUInteger)section.length / 2;
+    RCClipContainerClose(container);
+    ((uint8_t *)bytes.mutableBytes)[tiffOffset] ^= 0xFF;
+    XCTAssertTrue([bytes writeToFile:path atomically:YES]);
+
+    RCClipData *stringOnly = [RCClipData clipDataFromPath:path representations:RCClipDataRepresentationString];
+    XCTAssertEqualObjects(stringOnly.stringValue, clipData.stringValue);
+    XCTAssertNil([RCClipData clipDataFromPath:path]);
+}
+
+- (void)testCompressionCanBeTurnedOff {
+    NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+    [defaults setBool:NO forKey:kRCPrefCompressClipDataKey];
+    RCClipData *clipData = [self compressibleClipData];
+    NSString *path = [self temporaryClipPath];
+    BOOL saved = [clipData saveToPath:path];
+    [defaults removeObjectForKey:kRCPrefCompressClipDataKey];
+
+    XCTAssertTrue(saved);
+    XCTAssertEqual([self flagsOfSection:RCClipSectionString atPath:path], 0u);
+    XCTAssertEqual([self flagsOfSection:RCClipSectionTIFF atPath:path], 0u);
+    XCTAssertEqualObjects([RCClipData clipDataFromPath:path].stringValue, clipData.stringValue);
+}
+
+- (void)testCorruptedSectionFailsToLoad {
+    RCClipData *clipData = [self sampleClipData];
+    NSString *path = [self temporaryClipPath];
+    XCTAssertTrue([clipData saveToPath:path]);
+
+    NSMutableData *bytes = [NSMutableData dataWithContentsOfFile:path];
+    ((uint8_t *)bytes.mutableBytes)[bytes.length - 8] ^= 0xFF;
+    XCTAssertTrue([bytes writeToFile:path atomically:YES]);
+
+    // 末尾のセクション（primaryType）が壊れているので、全体の読み込みは失敗する。
+    XCTAssertNil([RCClipData clipDataFromPath:path]);
+}
+
+- (void)testDigestsMatchExistingDataHashes {
+    // v1 は保存済みの data_hash と一致し続けることを、CommonCrypto 時代の値で確かめる。
+    RCClipData *text = [[RCClipData alloc] init];
+    text.stringValue = @"hello";
+    text.primaryType = @"public.utf8-plain-text";
+    XCTAssertEqualObjects([text legacyDataHash], @"9c015ac18bb70481f467bb1fadb4f9e6ee93a1c093f15839bb55b425d7cea994");
+    XCTAssertEqualObjects([text dataHash], @"36eaedafac118e6d585ef10fc1b3dba0f6e58a9c1716baf28d6a259c2db14e7e");
+
+    RCClipData *image = [[RCClipData alloc] init];
+    image.TIFFData = [NSMutableData dataWithLength:65536];
+    image.primaryType = @"public.tiff";
+    XCTAssertEqualObjects([image legacyDataHash], @"fa25019d0e50b3d65c14621a5162a36293252a8c16fb825d663b912675261612");
+    RCClipDataDigests *digests = [image storageDigests];
+    XCTAssertEqualObjects(digests.dataHash, @"54b36ffd5768caf5f2905826e58c74503a0603e2b8059b2f692f497575dcc75c");
+    XCTAssertEqualObjects(digests.dataHash, [image dataHash]);
+    XCTAssertEqualObjects(digests.blobDigestsByKey[@"TIFFData"],
+                          @"de2f256064a0af797747c2b97505dc0b9f3df0de4f489eac731c23ae9ca9cc31");
+}
+
+- (void)testFingerprintCoversEveryRepresentation {
+    RCClipData *plain = [[RCClipData alloc] init];
+    plain.stringValue = @"same text";
+    plain.primaryType = @"public.utf8-plain-text";
+
+    RCClipData *styled = [[RCClipData alloc] init];
+    styled.stringValue = @"same text";
+    styled.RTFData = [@"{\\rtf1 {\\b same text}}" dataUsingEncoding:NSUTF8StringEncoding];
+    styled.primaryType = @"public.utf8-plain-text";
+
+    // v1 は文字列だけで同一視していた。
+    XCTAssertEqualObjects([plain legacyDataHash], [styled legacyDataHash]);
+    XCTAssertNotEqualObjects([plain dataHash], [styled dataHash]);
+
+    RCClipData *otherType = [[RCClipData alloc] init];
+    otherType.stringValue = @"same text";
+    otherType.primaryType = @"public.html";
+    XCTAssertNotEqualObjects([plain dataHash], [otherType dataHash]);
+
+    // 表現の境界をずらしただけの内容も区別する。
+    RCClipData *split = [[RCClipData alloc] init];
+    split.fileNames = @[@"/tmp/a", @"b"];
+    RCClipData *joined = [[RCClipData alloc] init];
+    joined.fileNames = @[@"/tmp/ab"];
+    XCTAssertNotEqualObjects([split dataHash], [joined dataHash]);
+}
+
+- (void)testFingerprintIsMemoizedUntilContentChanges {
+    RCClipData *clipData = [self sampleClipData];
+    NSString *firstHash = [clipData dataHash];
+    XCTAssertEqual([clipData dataHash], firstHash);
+    XCTAssertEqualObjects([clipData storageDigests].dataHash, firstHash);
+
+    clipData.stringValue = @"変更後";
+    NSString *changedHash = [clipData dataHash];
+    XCTAssertNotEqualObjects(changedHash, firstHash);
+
+    RCClipData *fresh = [self sampleClipData];
+    fresh.stringValue = @"変更後";
+    XCTAssertEqualObjects(changedHash, [fresh dataHash]);
+    XCTAssertEqualObjects([clipData storageDigests].dataHash, changedHash);
+
+    clipData.TIFFData = nil;
+    XCTAssertNotEqualObjects([clipData storageDigests].dataHash, changedHash);
+    XCTAssertNil([clipData storageDigests].blobDigestsByKey[@"TIFFData"]);
+}
+
+@end
@@ -0,0 +1,194 @@
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+
+#import "RCClipboardService.h"
+#import "RCClipData.h"
+#import "RCClipItem.h"
+#import "RCDatabaseManager.h"
+#import "RCPasteboardProvider.h"
+
+// RCClipboardService そのもの（ポーリング → スナップショット → バースト合流 → fingerprint → persist
+// （.rcclip・ブロブストア・サムネイル）→ index）に RCInMemoryPasteboard から台本どおりのコピーを流す。
+// Benchmarks/RCHeadlessCaptureBenchmark はこの経路を C で写したモデルで、アプリのコードは実行しない。
+@interface RCClipboardCapturePerformanceTests : XCTestCase
+
+@property (nonatomic, strong) RCInMemoryPasteboard *pasteboard;
+@property (nonatomic, strong) id<RCPasteboardProvider> savedProvider;
+@property (nonatomic, assign) BOOL wasMonitoring;
+@property (nonatomic, strong) id observer;
+// RCClipboardDidChangeNotification で届いた dataHash → 行（tearDown で消す）
+@property (nonatomic, strong) NSMutableDictionary<NSString *, RCClipItem *> *capturedItems;
+@property (nonatomic, assign) NSUInteger notificationCount;
+@property (nonatomic, assign) uint64_t seedBase;
+
+@end
+
+@implementation RCClipboardCapturePerformanceTests
+
+- (void)setUp {
+    [super setUp];
+    XCTAssertTrue([[RCDatabaseManager shared] setupDatabase]);
+    RCClipboardService *service = [RCClipboardService shared];
+    self.wasMonitoring = service.isMonitoring;
+    [service stopMonitoring];
+    self.savedProvider = service.pasteboardProvider;
+    self.pasteboard = [[RCInMemoryPasteboard alloc] init];
+    service.pasteboardProvider = self.pasteboard;
+    self.capturedItems = [NSMutableDictionary dictionary];
+    // 実行ごとに別の内容にして、前の実行の行と重複させない
+    self.seedBase = (uint64_t)arc4random() << 24;
+
+    __weak typeof(self) weakSelf = self;
+    self.observer = [[NSNotificationCenter defaultCenter] addObserverForName:RCClipboardDidChangeNotification
+                                                                      object:service
+                                                                       queue:nil
+                                                                  usingBlock:^(NSNotification *notification) {
+        RCClipItem *clipItem = notification.userInfo[@"clipItem"];
+        if (clipItem.dataHash.length > 0) {
+            weakSelf.capturedItems[clipItem.dataHash] = clipItem;
+        }
+        weakSelf.notificationCount += 1;
+    }];
+}
+
+- (void)tearDown {
+    RCClipboardService *service = [RCClipboardService shared];
+    [service stopMonitoring];
+    [self drainPipeline];
+    [[NSNotificationCenter defaultCenter] removeObserver:self.observer];
+    service.pasteboardProvider = self.savedProvider;
+    if (self.wasMonitoring) {
+        [service startMonitoring];
+    }
+
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    for (RCClipItem *clipItem in self.capturedItems.allValues) {
+        [databaseManager deleteClipItemWithDataHash:clipItem.dataHash];
+        for (NSString *path in @[ clipItem.dataPath ?: @"", clipItem.thumbnailPath ?: @"" ]) {
+            if (path.length > 0) {
+                [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+            }
+        }
+    }
+    [super tearDown];
+}
+
+- (void)drainPipeline {
+    XCTestExpectation *drained = [self expectationWithDescription:@"capture pipeline drained"];
+    [[RCClipboardService shared] flushQueueWithCompletion:^{
+        [drained fulfill];
+    }];
+    [self waitForExpectations:@[drained] timeout:30.0];
+    XCTAssertTrue([[RCDatabaseManager shared] flushPendingWrites]);
+    // 通知はメインキューに非同期で投げられるので、届くまで回す
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+}
+
+// メインの run loop を回しながら待つ（ポーリングはスナップショットをメインキューで取る）。
+- (void)waitMilliseconds:(NSUInteger)milliseconds {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:milliseconds / 1000.0]];
+}
+
+// 1 回分の作業。ポーリングとバースト判定（250 ms）をまたぐよう、単発のコピーは 300 ms 空ける。
+// 各要素は contents / application / pauseMilliseconds と、保存されるはず（stored）か読まずに除外されるはず（skipped）か。
+// 単発のコピーは 20 種類（テキスト 12・RTF 付き 3・ファイルリスト 3・画像 2）で、再コピー 2 回は update_time の更新になる。
+// 20 ms ごとのバーストは 100 ms ごとのポーリングで見えた状態だけが届くので、保証されるのは最後の状態だけ。
+- (NSArray<NSDictionary *> *)workloadWithSeed:(uint64_t)seed {
+    NSMutableArray<NSDictionary *> *steps = [NSMutableArray array];
+    void (^add)(RCClipRepresentationMask, NSUInteger, uint64_t, BOOL, NSString *, NSUInteger, BOOL) =
+        ^(RCClipRepresentationMask representations, NSUInteger length, uint64_t copySeed, BOOL marked,
+          NSString *application, NSUInteger pauseMilliseconds, BOOL stored) {
+        [steps addObject:@{
+            @"contents": [RCInMemoryPasteboard scriptedRepresentations:representations
+                                                                length:length
+                                                                  seed:copySeed
+                                                                marked:marked],
+            @"application": application,
+            @"pauseMilliseconds": @(pauseMilliseconds),
+            @"stored": @(stored && !marked),
+            @"skipped": @(marked),
+        }];
+    };
+
+    for (uint64_t index = 0; index < 12; index++) {
+        add(RCClipRepresentationString, 16 + index * 24, seed + index, NO, @"com.example.editor", 300, YES);
+        if (index == 5 || index == 10) {
+            add(RCClipRepresentationString, 16, seed, NO, @"com.example.editor", 300, YES);
+        }
+    }
+    for (uint64_t index = 0; index < 3; index++) {
+        add(RCClipRepresentationString | RCClipRepresentationRTF, 4096, seed + 20 + index, NO, @"com.example.editor", 300, YES);
+        add(RCClipRepresentationFiles | RCClipRepresentationString, 640, seed + 30 + index, NO, @"com.apple.finder", 300, YES);
+    }
+    add(RCClipRepresentationString, 24, seed + 40, YES, @"com.example.passwords", 300, NO);
+    for (uint64_t index = 0; index < 2; index++) {
+        add(RCClipRepresentationTIFF, 2 * 1024 * 1024, seed + 100 + index, NO, @"com.example.preview", 300, YES);
+    }
+    for (uint64_t index = 0; index < 8; index++) {
+        add(RCClipRepresentationString, 64, seed + 50 + index, NO, @"com.example.terminal", index < 7 ? 20 : 800, index == 7);
+    }
+    return steps;
+}
+
+- (void)runWorkload:(NSArray<NSDictionary *> *)steps {
+    for (NSDictionary *step in steps) {
+        [self.pasteboard scriptCopyWithRepresentations:step[@"contents"] sourceBundleIdentifier:step[@"application"]];
+        [self waitMilliseconds:[step[@"pauseMilliseconds"] unsignedIntegerValue]];
+    }
+    [self drainPipeline];
+}
+
+// キャプチャと同じ読み方（全表現・50 MiB）で求めた dataHash。マーカー型は外して、保存されたら付くはずの値を返す。
+- (NSString *)dataHashForContents:(NSDictionary<NSPasteboardType, id> *)contents {
+    NSMutableDictionary<NSPasteboardType, id> *unmarked = [contents mutableCopy];
+    [unmarked removeObjectForKey:@"org.nspasteboard.ConcealedType"];
+    RCInMemoryPasteboard *scratch = [[RCInMemoryPasteboard alloc] init];
+    [scratch scriptCopyWithRepresentations:unmarked sourceBundleIdentifier:nil];
+    RCCapturePlan plan = RCCapturePlanMake(RC_CLIP_REPRESENTATION_ALL, 50 * 1024 * 1024);
+    return [[RCClipData clipDataFromPasteboard:scratch plan:&plan verdict:NULL] dataHash];
+}
+
+- (void)testPollingCapturesScriptedCopies {
+    RCClipboardService *service = [RCClipboardService shared];
+    NSArray<NSDictionary *> *steps = [self workloadWithSeed:self.seedBase];
+    [service startMonitoring];
+    [self runWorkload:steps];
+    [service stopMonitoring];
+    [self drainPipeline];
+
+    NSMutableSet<NSString *> *stored = [NSMutableSet set];
+    for (NSDictionary *step in steps) {
+        NSString *dataHash = [self dataHashForContents:step[@"contents"]];
+        if ([step[@"stored"] boolValue]) {
+            [stored addObject:dataHash];
+            XCTAssertNotNil(self.capturedItems[dataHash]);
+        } else if ([step[@"skipped"] boolValue]) {
+            XCTAssertNil(self.capturedItems[dataHash]);
+        }
+    }
+    XCTAssertEqual(stored.count, 21u);
+    XCTAssertGreaterThanOrEqual(self.notificationCount, stored.count + 2);
+    for (RCClipItem *clipItem in self.capturedItems.allValues) {
+        XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:clipItem.dataPath], @"%@", clipItem.dataPath);
+    }
+}
+
+- (void)testCapturePerformance {
+    RCClipboardService *service = [RCClipboardService shared];
+    XCTMeasureOptions *options = [XCTMeasureOptions defaultOptions];
+    options.iterationCount = 3;
+    __block uint64_t iteration = 0;
+    [self measureWithMetrics:@[
+        [[XCTClockMetric alloc] init],
+        [[XCTCPUMetric alloc] init],
+        [[XCTMemoryMetric alloc] init],
+        [[XCTStorageMetric alloc] init],
+    ] options:options block:^{
+        NSArray<NSDictionary *> *steps = [self workloadWithSeed:self.seedBase + (++iteration << 12)];
+        [service startMonitoring];
+        [self runWorkload:steps];
+        [service stopMonitoring];
+    }];
+}
+
+@end
@@ -0,0 +1,162 @@
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+
+#import "RCClipboardService.h"
+#import "RCClipData.h"
+#import "RCDatabaseManager.h"
+#import "RCUtilities.h"
+
+@interface RCClipboardService (Testing)
+- (void)processClipDataOnMonitoringQueue:(RCClipData *)clipData
+                    sourceBundleIdentifier:(NSString *)sourceBundleIdentifier;
+- (void)offerClipDataOnMonitoringQueue:(RCClipData *)clipData sourceBundleIdentifier:(NSString *)sourceBundleIdentifier;
+@end
+
+@interface RCClipboardCapturePipelineTests : XCTestCase
+
+@property (nonatomic, strong) NSMutableArray<NSString *> *capturedHashes;
+
+@end
+
+@implementation RCClipboardCapturePipelineTests
+
+- (void)setUp {
+    [super setUp];
+    XCTAssertTrue([[RCDatabaseManager shared] setupDatabase]);
+    self.capturedHashes = [NSMutableArray array];
+    [[RCClipboardService shared] resetCaptureMetrics];
+}
+
+- (void)tearDown {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    for (NSString *dataHash in self.capturedHashes) {
+        NSDictionary *row = [databaseManager clipItemWithDataHash:dataHash];
+        [databaseManager deleteClipItemWithDataHash:dataHash];
+        for (NSString *key in @[ @"data_path", @"thumbnail_path" ]) {
+            NSString *path = [row[key] isKindOfClass:NSString.class] ? row[key] : @"";
+            if (path.length > 0) {
+                [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+            }
+        }
+    }
+    [super tearDown];
+}
+
+- (RCClipData *)clipDataWithString:(NSString *)string {
+    RCClipData *clipData = [[RCClipData alloc] init];
+    clipData.stringValue = string;
+    clipData.primaryType = NSPasteboardTypeString;
+    NSString *dataHash = [clipData dataHash];
+    [[RCDatabaseManager shared] deleteClipItemWithDataHash:dataHash];
+    [self.capturedHashes addObject:dataHash];
+    return clipData;
+}
+
+- (void)drainPipeline {
+    XCTestExpectation *drained = [self expectationWithDescription:@"capture pipeline drained"];
+    [[RCClipboardService shared] flushQueueWithCompletion:^{
+        [drained fulfill];
+    }];
+    [self waitForExpectations:@[drained] timeout:10.0];
+    XCTAssertTrue([[RCDatabaseManager shared] flushPendingWrites]);
+}
+
+- (void)testHistoryKeepsCaptureOrderWhenALargeClipIsFingerprintedFirst {
+    RCClipboardService *service = [RCClipboardService shared];
+    NSString *token = NSUUID.UUID.UUIDString;
+
+    // 先頭の大きなクリップはハッシュに時間がかかり、後続の小さなクリップが先に fingerprint 段を抜ける。
+    NSMutableArray<RCClipData *> *clips = [NSMutableArray array];
+    NSString *large = [@"" stringByPaddingToLength:4 * 1024 * 1024 withString:token startingAtIndex:0];
+    [clips addObject:[self clipDataWithString:large]];
+    for (NSInteger index = 0; index < 8; index++) {
+        [clips addObject:[self clipDataWithString:[NSString stringWithFormat:@"pipeline %@ %ld", token, (long)index]]];
+    }
+    for (RCClipData *clipData in clips) {
+        [service processClipDataOnMonitoringQueue:clipData sourceBundleIdentifier:@"com.revclip.tests"];
+    }
+    [self drainPipeline];
+
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    long long previousId = 0;
+    long long previousUpdateTime = 0;
+    for (NSString *dataHash in self.capturedHashes) {
+        NSDictionary *row = [databaseManager clipItemWithDataHash:dataHash];
+        XCTAssertNotNil(row);
+        long long rowId = [row[@"id"] longLongValue];
+        long long updateTime = [row[@"update_time"] longLongValue];
+        XCTAssertGreaterThan(rowId, previousId);
+        XCTAssertGreaterThanOrEqual(updateTime, previousUpdateTime);
+        previousId = rowId;
+        previousUpdateTime = updateTime;
+    }
+}
+
+- (NSUInteger)clipDataFileCount {
+    NSArray<NSString *> *files = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:[RCUtilities clipDataDirectoryPath]
+                                                                                     error:nil];
+    return [files filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"pathExtension == 'rcclip'"]].count;
+}
+
+- (void)testDuplicateStillInFlightUpdatesTheSameRow {
+    RCClipboardService *service = [RCClipboardService shared];
+    RCClipData *clipData = [self clipDataWithString:[NSString stringWithFormat:@"duplicate %@", NSUUID.UUID.UUIDString]];
+    NSUInteger fileCountBefore = [self clipDataFileCount];
+
+    // 2 件目の persist 時点では 1 件目はまだ index 段の登録待ちで、DB からは見えないことがある。
+    [service processClipDataOnMonitoringQueue:clipData sourceBundleIdentifier:@"com.revclip.tests"];
+    [service processClipDataOnMonitoringQueue:clipData sourceBundleIdentifier:@"com.revclip.tests"];
+    [self drainPipeline];
+
+    XCTAssertNotNil([[RCDatabaseManager shared] clipItemWithDataHash:self.capturedHashes.firstObject]);
+    XCTAssertEqual([self clipDataFileCount], fileCountBefore + 1);
+}
+
+- (void)testEveryStageReportsLatency {
+    RCClipboardService *service = [RCClipboardService shared];
+    RCClipData *clipData = [self clipDataWithString:[NSString stringWithFormat:@"metrics %@", NSUUID.UUID.UUIDString]];
+    [service processClipDataOnMonitoringQueue:clipData sourceBundleIdentifier:@"com.revclip.tests"];
+    [self drainPipeline];
+
+    NSData *data = [service captureMetricsJSONData];
+    XCTAssertNotNil(data);
+    NSDictionary *metrics = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+    NSDictionary *stages = metrics[@"stages"];
+    for (NSString *stage in @[ @"fingerprint", @"persist", @"index" ]) {
+        XCTAssertEqualObjects(stages[stage][@"execution"][@"count"], @1, @"%@", stage);
+        XCTAssertEqualObjects(stages[stage][@"queueWait"][@"count"], @1, @"%@", stage);
+    }
+    XCTAssertNotNil(stages[@"snapshot"]);
+    XCTAssertNotNil(metrics[@"blockedAdmissions"]);
+    XCTAssertNotNil(metrics[@"burst"][@"droppedStates"]);
+}
+
+- (void)testBurstOfCopiesKeepsOnlyTheFinalState {
+    RCClipboardService *service = [RCClipboardService shared];
+    NSString *token = NSUUID.UUID.UUIDString;
+    // setUp の resetCaptureMetrics（monitoringQueue で実行）を先に終わらせる
+    [self drainPipeline];
+
+    // 連続したコピーの 3 件目からバーストとみなし、落ち着いた時点で最後の状態だけを保存する。
+    NSMutableArray<RCClipData *> *clips = [NSMutableArray array];
+    for (NSInteger index = 0; index < 6; index++) {
+        [clips addObject:[self clipDataWithString:[NSString stringWithFormat:@"burst %@ %ld", token, (long)index]]];
+    }
+    for (RCClipData *clipData in clips) {
+        [service offerClipDataOnMonitoringQueue:clipData sourceBundleIdentifier:@"com.revclip.tests"];
+    }
+    [self drainPipeline];
+
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    for (NSUInteger index = 0; index < clips.count; index++) {
+        NSDictionary *row = [databaseManager clipItemWithDataHash:self.capturedHashes[index]];
+        BOOL expectedStored = (index < 2 || index == clips.count - 1);
+        XCTAssertEqual(row != nil, expectedStored, @"clip %lu", (unsigned long)index);
+    }
+
+    NSDictionary *metrics = [NSJSONSerialization JSONObjectWithData:[service captureMetricsJSONData] options:0 error:nil];
+    XCTAssertEqualObjects(metrics[@"burst"][@"bursts"], @1);
+    XCTAssertEqualObjects(metrics[@"burst"][@"droppedStates"], @3);
+}
+
+@end
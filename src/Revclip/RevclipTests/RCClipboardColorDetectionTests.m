@@ -123,6 +123,11 @@
         [databaseManager deleteClipItemWithDataHash:dataHash];
 
         [service processClipDataOnMonitoringQueue:clipData sourceBundleIdentifier:@"com.revclip.tests"];
+        XCTestExpectation *captured = [self expectationWithDescription:@"capture pipeline drained"];
+        [service flushQueueWithCompletion:^{
+            [captured fulfill];
+        }];
+        [self waitForExpectations:@[captured] timeout:5.0];
 
         NSDictionary *row = [databaseManager clipItemWithDataHash:dataHash];
         XCTAssertNotNil(row);
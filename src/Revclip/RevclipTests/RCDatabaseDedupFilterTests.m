@@ -0,0 +1,59 @@
+#import <XCTest/XCTest.h>
+
+#import "RCDatabaseTestSupport.h"
+
+// 既定の writeBehindInterval 0 でキューを通さず、行の INSERT と同時にフィルタへ入る経路を確かめる。
+@interface RCDatabaseDedupFilterTests : RCDatabaseTestCase
+
+@end
+
+@implementation RCDatabaseDedupFilterTests
+
+- (RCClipItem *)clipItemWithUpdateTime:(NSInteger)updateTime {
+    return [self clipItemWithTitle:@"dedup-filter" updateTime:updateTime];
+}
+
+- (void)testNovelDigestIsNotFound {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    for (NSUInteger index = 0; index < 100; index++) {
+        XCTAssertNil([databaseManager clipItemForDataHash:[self randomDataHash]]);
+    }
+}
+
+- (void)testInsertedClipIsFoundAndDeletedClipIsNot {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    RCClipItem *clipItem = [self clipItemWithUpdateTime:1000];
+
+    XCTAssertTrue([databaseManager insertClipItemObject:clipItem]);
+    XCTAssertEqualObjects([databaseManager clipItemForDataHash:clipItem.dataHash].dataHash, clipItem.dataHash);
+
+    XCTAssertTrue([databaseManager deleteClipItemWithDataHash:clipItem.dataHash]);
+    XCTAssertNil([databaseManager clipItemForDataHash:clipItem.dataHash]);
+
+    // 削除後に同じ内容を再びコピーしても見つかる。
+    XCTAssertTrue([databaseManager insertClipItemObject:clipItem]);
+    XCTAssertNotNil([databaseManager clipItemForDataHash:clipItem.dataHash]);
+}
+
+- (void)testClipsSurviveBulkDeleteAndEviction {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    RCClipItem *oldItem = [self clipItemWithUpdateTime:1];
+    RCClipItem *expiredItem = [self clipItemWithUpdateTime:2];
+    RCClipItem *newItem = [self clipItemWithUpdateTime:(NSInteger)([[NSDate date] timeIntervalSince1970] * 1000.0)];
+    XCTAssertTrue([databaseManager insertClipItemObject:oldItem]);
+    XCTAssertTrue([databaseManager insertClipItemObject:expiredItem]);
+    XCTAssertTrue([databaseManager insertClipItemObject:newItem]);
+
+    // 一括削除はフィルタを作り直す。
+    XCTAssertTrue([databaseManager deleteClipItemsOlderThan:2]);
+    XCTAssertNil([databaseManager clipItemForDataHash:oldItem.dataHash]);
+    XCTAssertNotNil([databaseManager clipItemForDataHash:expiredItem.dataHash]);
+    XCTAssertNotNil([databaseManager clipItemForDataHash:newItem.dataHash]);
+
+    NSArray<RCClipItem *> *evictedItems = [databaseManager evictClipItemsBeyondLimit:0 olderThan:3];
+    XCTAssertTrue([[evictedItems valueForKey:@"dataHash"] containsObject:expiredItem.dataHash]);
+    XCTAssertNil([databaseManager clipItemForDataHash:expiredItem.dataHash]);
+    XCTAssertNotNil([databaseManager clipItemForDataHash:newItem.dataHash]);
+}
+
+@end
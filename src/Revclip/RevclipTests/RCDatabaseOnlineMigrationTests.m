@@ -0,0 +1,187 @@
+#import <XCTest/XCTest.h>
+
+#import "FMDB.h"
+#import "RCClipData.h"
+#import "RCDatabaseTestSupport.h"
+#import "RCUtilities.h"
+
+@interface RCDatabaseOnlineMigrationTests : RCDatabaseTestCase
+
+@end
+
+@implementation RCDatabaseOnlineMigrationTests
+
+// v4 より前の行と同じく data_size = 0 の行を作る。
+- (RCClipItem *)insertLegacyClipItemWithDataSize:(NSUInteger)dataSize {
+    RCDatabaseManager *databaseManager = self.databaseManager;
+    RCClipItem *clipItem = [self clipItemWithTitle:@"online migration"
+                                        updateTime:(NSInteger)([[NSDate date] timeIntervalSince1970] * 1000)];
+    XCTAssertTrue([RCUtilities ensureDirectoryExists:[RCUtilities clipDataDirectoryPath]]);
+    XCTAssertTrue([[NSMutableData dataWithLength:dataSize] writeToFile:clipItem.dataPath atomically:YES]);
+    [self.createdPaths addObject:clipItem.dataPath];
+    XCTAssertTrue([databaseManager insertClipItemObject:clipItem]);
+
+    RCClipItem *stored = [databaseManager clipItemForDataHash:clipItem.dataHash];
+    XCTAssertNotNil(stored);
+    XCTAssertTrue([databaseManager performDatabaseOperation:^BOOL(FMDatabase *db) {
+        return [db executeUpdate:@"UPDATE clip_items SET data_size = 0 WHERE id = ?", @(stored.itemId)];
+    }]);
+    return stored;
+}
+
+- (long long)dataSizeForClipItem:(RCClipItem *)clipItem {
+    __block long long dataSize = -1;
+    XCTAssertTrue([[RCDatabaseManager shared] performReadOperation:^BOOL(FMDatabase *db) {
+        dataSize = [db longForQuery:@"SELECT data_size FROM clip_items WHERE id = ?", @(clipItem.itemId)];
+        return YES;
+    }]);
+    return dataSize;
+}
+
+- (void)testDataSizeMigrationResumesFromCheckpoint {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    RCClipItem *migrated = [self insertLegacyClipItemWithDataSize:5];
+    RCClipItem *pending = [self insertLegacyClipItemWithDataSize:7];
+
+    // 1 件目までは前回の実行で処理済みという状態から再開する。
+    XCTAssertTrue([databaseManager performDatabaseOperation:^BOOL(FMDatabase *db) {
+        return [db executeUpdate:@"INSERT OR REPLACE INTO online_migrations (name, checkpoint, migrated_rows, completed) VALUES ('clip_items.data_size', ?, 0, 0)",
+                @(migrated.itemId)];
+    }]);
+    XCTAssertTrue([databaseManager hasPendingOnlineMigrations]);
+
+    NSProgress *progress = [NSProgress discreteProgressWithTotalUnitCount:1];
+    XCTAssertTrue([databaseManager runOnlineMigrationsWithProgress:progress]);
+    XCTAssertEqualWithAccuracy(progress.fractionCompleted, 1.0, 0.0001);
+    XCTAssertFalse([databaseManager hasPendingOnlineMigrations]);
+
+    XCTAssertEqual([self dataSizeForClipItem:migrated], 0);
+    XCTAssertEqual([self dataSizeForClipItem:pending], 7);
+
+    __block long long checkpoint = 0;
+    XCTAssertTrue([databaseManager performReadOperation:^BOOL(FMDatabase *db) {
+        checkpoint = [db longForQuery:@"SELECT checkpoint FROM online_migrations WHERE name = 'clip_items.data_size'"];
+        return YES;
+    }]);
+    XCTAssertGreaterThanOrEqual(checkpoint, (long long)pending.itemId);
+}
+
+- (void)testCancelledOnlineMigrationKeepsItsCheckpoint {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    RCClipItem *clipItem = [self insertLegacyClipItemWithDataSize:3];
+    XCTAssertTrue([databaseManager performDatabaseOperation:^BOOL(FMDatabase *db) {
+        return [db executeUpdate:@"INSERT OR REPLACE INTO online_migrations (name, checkpoint, migrated_rows, completed) VALUES ('clip_items.data_size', ?, 0, 0)",
+                @(clipItem.itemId - 1)];
+    }]);
+
+    NSProgress *progress = [NSProgress discreteProgressWithTotalUnitCount:1];
+    [progress cancel];
+    XCTAssertFalse([databaseManager runOnlineMigrationsWithProgress:progress]);
+    XCTAssertTrue([databaseManager hasPendingOnlineMigrations]);
+    XCTAssertEqual([self dataSizeForClipItem:clipItem], 0);
+
+    XCTAssertTrue([databaseManager runOnlineMigrationsWithProgress:nil]);
+    XCTAssertEqual([self dataSizeForClipItem:clipItem], 3);
+}
+
+- (void)testFingerprintMigrationRehashesLegacyRows {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    RCClipData *clipData = [[RCClipData alloc] init];
+    clipData.stringValue = [NSUUID UUID].UUIDString;
+    clipData.RTFData = [@"{\\rtf1 styled}" dataUsingEncoding:NSUTF8StringEncoding];
+    clipData.primaryType = @"public.utf8-plain-text";
+    NSString *dataHash = [clipData dataHash];
+    NSString *legacyDataHash = [clipData legacyDataHash];
+    XCTAssertNotEqualObjects(dataHash, legacyDataHash);
+
+    // v7 より前に保存された行と同じく、v1 のフィンガープリントで行を作る。
+    RCClipItem *clipItem = [[RCClipItem alloc] init];
+    clipItem.dataHash = legacyDataHash;
+    clipItem.dataPath = [[RCUtilities clipDataDirectoryPath]
+                         stringByAppendingPathComponent:[[NSUUID UUID].UUIDString stringByAppendingPathExtension:@"rcclip"]];
+    XCTAssertTrue([RCUtilities ensureDirectoryExists:[RCUtilities clipDataDirectoryPath]]);
+    XCTAssertTrue([clipData saveToPath:clipItem.dataPath]);
+    [self.createdPaths addObject:clipItem.dataPath];
+    clipItem.title = @"fingerprint migration";
+    clipItem.primaryType = clipData.primaryType;
+    clipItem.updateTime = (NSInteger)([[NSDate date] timeIntervalSince1970] * 1000);
+    XCTAssertTrue([databaseManager insertClipItemObject:clipItem]);
+    [self.insertedHashes addObject:legacyDataHash];
+    [self.insertedHashes addObject:dataHash];
+
+    RCClipItem *stored = [databaseManager clipItemForDataHash:legacyDataHash];
+    XCTAssertNotNil(stored);
+    XCTAssertTrue([databaseManager performDatabaseOperation:^BOOL(FMDatabase *db) {
+        return [db executeUpdate:@"UPDATE clip_items SET fingerprint_version = 1 WHERE id = ?", @(stored.itemId)]
+            && [db executeUpdate:@"INSERT OR REPLACE INTO online_migrations (name, checkpoint, migrated_rows, completed) VALUES ('clip_items.fingerprint_v2', ?, 0, 0)",
+                @(stored.itemId - 1)];
+    }]);
+    // 移行の有無は setupDatabase で読み直す。
+    [databaseManager closeDatabase];
+    XCTAssertTrue([databaseManager setupDatabase]);
+
+    // 移行中は v1 の行も重複として見つかる。
+    RCClipItem *duplicate = [databaseManager clipItemForCapturedClipData:clipData dataHash:dataHash];
+    XCTAssertEqual(duplicate.itemId, stored.itemId);
+    XCTAssertEqualObjects(duplicate.dataHash, legacyDataHash);
+
+    XCTAssertTrue([databaseManager runOnlineMigrationsWithProgress:nil]);
+    XCTAssertFalse([databaseManager hasPendingOnlineMigrations]);
+    XCTAssertEqual([databaseManager clipItemForDataHash:dataHash].itemId, stored.itemId);
+    XCTAssertNil([databaseManager clipItemForDataHash:legacyDataHash]);
+    XCTAssertEqual([databaseManager clipItemForCapturedClipData:clipData dataHash:dataHash].itemId, stored.itemId);
+}
+
+- (void)testUnreadableLegacyRowIsRetiredWhenMigrationFinishes {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    RCClipData *clipData = [[RCClipData alloc] init];
+    clipData.stringValue = [NSUUID UUID].UUIDString;
+    clipData.RTFData = [@"{\\rtf1 styled}" dataUsingEncoding:NSUTF8StringEncoding];
+    clipData.primaryType = @"public.utf8-plain-text";
+    NSString *dataHash = [clipData dataHash];
+    NSString *legacyDataHash = [clipData legacyDataHash];
+
+    // .rcclip が読めない行は再計算できないので、移行の終わりに v1 の対象から外れる。
+    RCClipItem *clipItem = [[RCClipItem alloc] init];
+    clipItem.dataHash = legacyDataHash;
+    clipItem.dataPath = [[RCUtilities clipDataDirectoryPath]
+                         stringByAppendingPathComponent:[[NSUUID UUID].UUIDString stringByAppendingPathExtension:@"rcclip"]];
+    XCTAssertTrue([RCUtilities ensureDirectoryExists:[RCUtilities clipDataDirectoryPath]]);
+    XCTAssertTrue([[@"not a clip" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:clipItem.dataPath atomically:YES]);
+    [self.createdPaths addObject:clipItem.dataPath];
+    clipItem.title = @"unreadable legacy clip";
+    clipItem.primaryType = clipData.primaryType;
+    clipItem.updateTime = (NSInteger)([[NSDate date] timeIntervalSince1970] * 1000);
+    XCTAssertTrue([databaseManager insertClipItemObject:clipItem]);
+    [self.insertedHashes addObject:legacyDataHash];
+
+    RCClipItem *stored = [databaseManager clipItemForDataHash:legacyDataHash];
+    XCTAssertNotNil(stored);
+    XCTAssertTrue([databaseManager performDatabaseOperation:^BOOL(FMDatabase *db) {
+        return [db executeUpdate:@"UPDATE clip_items SET fingerprint_version = 1 WHERE id = ?", @(stored.itemId)]
+            && [db executeUpdate:@"INSERT OR REPLACE INTO online_migrations (name, checkpoint, migrated_rows, completed) VALUES ('clip_items.fingerprint_v2', ?, 0, 0)",
+                @(stored.itemId - 1)];
+    }]);
+    [databaseManager closeDatabase];
+    XCTAssertTrue([databaseManager setupDatabase]);
+
+    // 移行中は v1 の行も重複として見つかる。
+    XCTAssertEqual([databaseManager clipItemForCapturedClipData:clipData dataHash:dataHash].itemId, stored.itemId);
+
+    XCTAssertTrue([databaseManager runOnlineMigrationsWithProgress:nil]);
+    XCTAssertFalse([databaseManager hasPendingOnlineMigrations]);
+    __block int fingerprintVersion = -1;
+    XCTAssertTrue([databaseManager performDatabaseOperation:^BOOL(FMDatabase *db) {
+        fingerprintVersion = [db intForQuery:@"SELECT fingerprint_version FROM clip_items WHERE id = ?", @(stored.itemId)];
+        return YES;
+    }]);
+    XCTAssertEqual(fingerprintVersion, 0);
+    XCTAssertNil([databaseManager clipItemForCapturedClipData:clipData dataHash:dataHash]);
+
+    // 次の起動でも v1 の重複判定には戻らない。
+    [databaseManager closeDatabase];
+    XCTAssertTrue([databaseManager setupDatabase]);
+    XCTAssertNil([databaseManager clipItemForCapturedClipData:clipData dataHash:dataHash]);
+}
+
+@end
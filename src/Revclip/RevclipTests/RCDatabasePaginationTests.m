@@ -0,0 +1,58 @@
+#import <XCTest/XCTest.h>
+
+#import "RCDatabaseTestSupport.h"
+
+@interface RCDatabasePaginationTests : RCDatabaseTestCase
+
+@end
+
+@implementation RCDatabasePaginationTests
+
+- (void)testKeysetPagesVisitEveryItemOnceAcrossEqualTimestamps {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    // 既存の履歴より新しい時刻に、同時刻の行を含めて挿入する
+    NSInteger baseTime = (NSInteger)([[NSDate date] timeIntervalSince1970] * 1000) + 60 * 60 * 1000;
+    for (NSInteger index = 0; index < 7; index++) {
+        [self insertClipItemWithTitle:@"page" updateTime:baseTime + index / 3];
+    }
+
+    NSMutableArray<NSString *> *pagedHashes = [NSMutableArray array];
+    RCClipItem *cursor = nil;
+    while (pagedHashes.count < self.insertedHashes.count) {
+        NSArray<RCClipItem *> *page = [databaseManager clipItemsAfterClipItem:cursor limit:2];
+        XCTAssertGreaterThan(page.count, 0u);
+        if (page.count == 0) {
+            break;
+        }
+        for (RCClipItem *clipItem in page) {
+            [pagedHashes addObject:clipItem.dataHash];
+        }
+        cursor = page.lastObject;
+    }
+
+    NSArray<RCClipItem *> *newest = [databaseManager clipItemsWithLimit:(NSInteger)self.insertedHashes.count];
+    XCTAssertEqualObjects(pagedHashes, [newest valueForKey:@"dataHash"]);
+    XCTAssertEqualObjects([NSSet setWithArray:pagedHashes], [NSSet setWithArray:self.insertedHashes]);
+}
+
+- (void)testEnumerationStreamsNewestFirstAndStops {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    NSInteger baseTime = (NSInteger)([[NSDate date] timeIntervalSince1970] * 1000) + 60 * 60 * 1000;
+    RCClipItem *older = [self insertClipItemWithTitle:@"page" updateTime:baseTime];
+    RCClipItem *newer = [self insertClipItemWithTitle:@"page" updateTime:baseTime + 1];
+
+    NSMutableArray<NSString *> *visited = [NSMutableArray array];
+    XCTAssertTrue([databaseManager enumerateClipItemsUsingBlock:^(RCClipItem *clipItem, BOOL *stop) {
+        [visited addObject:clipItem.dataHash];
+        *stop = (visited.count == 2);
+    }]);
+    XCTAssertEqualObjects(visited, (@[newer.dataHash, older.dataHash]));
+
+    __block NSInteger total = 0;
+    XCTAssertTrue([databaseManager enumerateClipItemsUsingBlock:^(RCClipItem *clipItem, BOOL *stop) {
+        total++;
+    }]);
+    XCTAssertEqual(total, [databaseManager clipItemCount]);
+}
+
+@end
@@ -0,0 +1,49 @@
+#import <XCTest/XCTest.h>
+#import <sqlite3.h>
+
+#import "RCDatabaseTestSupport.h"
+
+@interface RCDatabaseQueryMetricsTests : RCDatabaseTestCase
+
+@end
+
+@implementation RCDatabaseQueryMetricsTests
+
+- (void)setUp {
+    [super setUp];
+    [self.databaseManager resetQueryMetrics];
+}
+
+- (NSDictionary *)queryMetrics {
+    NSData *data = [[RCDatabaseManager shared] queryMetricsJSONData];
+    XCTAssertNotNil(data);
+    NSDictionary *metrics = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+    XCTAssertTrue([metrics isKindOfClass:[NSDictionary class]]);
+    return metrics;
+}
+
+- (void)testOperationsAndStatementsAreRecorded {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    RCClipItem *clipItem = [self insertClipItemWithTitle:@"metrics"
+                                              updateTime:(NSInteger)([[NSDate date] timeIntervalSince1970] * 1000)];
+    XCTAssertNotNil([databaseManager clipItemForDataHash:clipItem.dataHash]);
+    XCTAssertNotNil([databaseManager clipItemForDataHash:clipItem.dataHash]);
+
+    NSDictionary *metrics = [self queryMetrics];
+    XCTAssertEqualObjects(metrics[@"sqliteVersion"], @(sqlite3_libversion()));
+    NSDictionary *insert = metrics[@"operations"][@"insert"];
+    XCTAssertEqualObjects(insert[@"execution"][@"count"], @1);
+    XCTAssertEqualObjects(insert[@"queueWait"][@"count"], @1);
+    XCTAssertEqualObjects(metrics[@"operations"][@"dedupLookup"][@"execution"][@"count"], @2);
+    XCTAssertEqualObjects(metrics[@"statements"][@"insertClipItem"][@"count"], @1);
+    XCTAssertEqualObjects(metrics[@"statements"][@"selectClipItemByDataHash"][@"count"], @2);
+
+    NSDictionary *lookup = metrics[@"statements"][@"selectClipItemByDataHash"];
+    XCTAssertLessThanOrEqual([lookup[@"p50Microseconds"] unsignedLongLongValue],
+                             [lookup[@"p99Microseconds"] unsignedLongLongValue]);
+
+    [databaseManager resetQueryMetrics];
+    XCTAssertNil([self queryMetrics][@"operations"][@"insert"]);
+}
+
+@end
@@ -0,0 +1,70 @@
+#import <XCTest/XCTest.h>
+
+#import "RCDatabaseTestSupport.h"
+
+@interface RCDatabaseSearchTests : RCDatabaseTestCase
+
+@property (nonatomic, copy) NSString *marker;
+
+@end
+
+@implementation RCDatabaseSearchTests
+
+- (void)setUp {
+    [super setUp];
+    // 既存の履歴と衝突しない検索語
+    self.marker = [@"rcsearch" stringByAppendingString:[[NSUUID UUID].UUIDString substringToIndex:8].lowercaseString];
+}
+
+- (RCClipItem *)insertClipItemWithSearchText:(NSString *)searchText updateTime:(NSInteger)updateTime {
+    RCClipItem *clipItem = [self clipItemWithTitle:@"search" updateTime:updateTime];
+    clipItem.searchText = searchText;
+    XCTAssertTrue([self.databaseManager insertClipItemObject:clipItem]);
+    return clipItem;
+}
+
+- (void)testSearchRanksAndPaginatesMatches {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    NSString *strongText = [NSString stringWithFormat:@"%@ %@ %@ report", self.marker, self.marker, self.marker];
+    NSString *weakText = [NSString stringWithFormat:@"quarterly numbers and a long unrelated paragraph about %@ and more filler words here", self.marker];
+    RCClipItem *strongItem = [self insertClipItemWithSearchText:strongText updateTime:1000];
+    RCClipItem *weakItem = [self insertClipItemWithSearchText:weakText updateTime:2000];
+    [self insertClipItemWithSearchText:@"nothing to see" updateTime:3000];
+
+    NSArray<RCClipItem *> *results = [databaseManager searchClipItemsMatching:self.marker limit:10 offset:0];
+    XCTAssertEqual(results.count, 2u);
+    XCTAssertEqualObjects(results.firstObject.dataHash, strongItem.dataHash);
+    XCTAssertEqualObjects(results.lastObject.dataHash, weakItem.dataHash);
+
+    NSArray<RCClipItem *> *secondPage = [databaseManager searchClipItemsMatching:self.marker limit:1 offset:1];
+    XCTAssertEqual(secondPage.count, 1u);
+    XCTAssertEqualObjects(secondPage.firstObject.dataHash, weakItem.dataHash);
+
+    NSString *prefix = [self.marker substringToIndex:self.marker.length - 2];
+    XCTAssertEqual([databaseManager searchClipItemsMatching:[@"report " stringByAppendingString:prefix] limit:10 offset:0].count, 1u);
+    XCTAssertEqual([databaseManager searchClipItemsMatching:[prefix stringByAppendingString:@" report"] limit:10 offset:0].count, 0u);
+    XCTAssertEqual([databaseManager searchClipItemsMatching:@"   " limit:10 offset:0].count, 0u);
+}
+
+- (void)testJapaneseTextMatchesWithoutWordBreaks {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    RCClipItem *clipItem = [self insertClipItemWithSearchText:[NSString stringWithFormat:@"%@ 東京タワーの営業時間", self.marker]
+                                                   updateTime:1000];
+
+    NSString *query = [NSString stringWithFormat:@"%@ タワー", self.marker];
+    XCTAssertEqualObjects([databaseManager searchClipItemsMatching:query limit:10 offset:0].firstObject.dataHash,
+                          clipItem.dataHash);
+    query = [NSString stringWithFormat:@"%@ 大阪", self.marker];
+    XCTAssertEqual([databaseManager searchClipItemsMatching:query limit:10 offset:0].count, 0u);
+}
+
+- (void)testDeletingClipRemovesItFromIndex {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    RCClipItem *clipItem = [self insertClipItemWithSearchText:self.marker updateTime:1000];
+    XCTAssertEqual([databaseManager searchClipItemsMatching:self.marker limit:10 offset:0].count, 1u);
+
+    XCTAssertTrue([databaseManager deleteClipItemWithDataHash:clipItem.dataHash]);
+    XCTAssertEqual([databaseManager searchClipItemsMatching:self.marker limit:10 offset:0].count, 0u);
+}
+
+@end
@@ -0,0 +1,51 @@
+#import <XCTest/XCTest.h>
+
+#import "FMDB.h"
+#import "RCDatabaseManager.h"
+
+@interface RCDatabaseStartupTests : XCTestCase
+
+@end
+
+@implementation RCDatabaseStartupTests
+
+- (void)setUp {
+    [super setUp];
+    XCTAssertTrue([[RCDatabaseManager shared] setupDatabase]);
+}
+
+- (void)testSetupStampsUserVersionForTheFastPath {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    __block NSInteger userVersion = -1;
+    XCTAssertTrue([databaseManager performReadOperation:^BOOL(FMDatabase *db) {
+        userVersion = [db intForQuery:@"PRAGMA user_version"];
+        return YES;
+    }]);
+    XCTAssertEqual(userVersion, [databaseManager currentSchemaVersion]);
+}
+
+- (void)testDeferredMaintenanceCompletesAndReportsProgress {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    NSProgress *progress = [NSProgress discreteProgressWithTotalUnitCount:1];
+    XCTAssertTrue([databaseManager performDeferredMaintenanceWithProgress:progress]);
+    XCTAssertEqualWithAccuracy(progress.fractionCompleted, 1.0, 0.0001);
+    XCTAssertFalse([databaseManager hasDeferredMaintenance]);
+
+    __block NSInteger autoVacuumMode = -1;
+    XCTAssertTrue([databaseManager performReadOperation:^BOOL(FMDatabase *db) {
+        autoVacuumMode = [db intForQuery:@"PRAGMA auto_vacuum"];
+        return YES;
+    }]);
+    XCTAssertEqual(autoVacuumMode, 2);
+}
+
+- (void)testCancelledDeferredMaintenanceReportsFailure {
+    NSProgress *progress = [NSProgress discreteProgressWithTotalUnitCount:1];
+    [progress cancel];
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    if ([databaseManager hasDeferredMaintenance]) {
+        XCTAssertFalse([databaseManager performDeferredMaintenanceWithProgress:progress]);
+    }
+}
+
+@end
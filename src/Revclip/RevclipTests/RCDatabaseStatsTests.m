@@ -0,0 +1,56 @@
+#import <XCTest/XCTest.h>
+
+#import "RCClipStatistics.h"
+#import "RCDatabaseTestSupport.h"
+#import "RCUtilities.h"
+
+@interface RCDatabaseStatsTests : RCDatabaseTestCase
+
+@end
+
+@implementation RCDatabaseStatsTests
+
+// write-behind 経由でも集計に反映されることを確認する
+- (NSTimeInterval)databaseWriteBehindInterval {
+    return 60;
+}
+
+- (RCClipItem *)insertClipItemWithPrimaryType:(NSString *)primaryType dataSize:(NSUInteger)dataSize {
+    RCClipItem *clipItem = [self clipItemWithTitle:@"stats"
+                                        updateTime:(NSInteger)([[NSDate date] timeIntervalSince1970] * 1000)];
+    XCTAssertTrue([RCUtilities ensureDirectoryExists:[RCUtilities clipDataDirectoryPath]]);
+    XCTAssertTrue([[NSMutableData dataWithLength:dataSize] writeToFile:clipItem.dataPath atomically:YES]);
+    [self.createdPaths addObject:clipItem.dataPath];
+    clipItem.primaryType = primaryType;
+    XCTAssertTrue([self.databaseManager insertClipItemObject:clipItem]);
+    return clipItem;
+}
+
+- (void)testStatisticsFollowInsertsAndDeletes {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    NSString *primaryType = [@"com.revclip.test." stringByAppendingString:[NSUUID UUID].UUIDString];
+    RCClipStatistics *before = [databaseManager clipStatistics];
+    XCTAssertEqual(before.itemCount, [databaseManager clipItemCount]);
+    XCTAssertNil(before.itemCountsByPrimaryType[primaryType]);
+
+    RCClipItem *first = [self insertClipItemWithPrimaryType:primaryType dataSize:1000];
+    [self insertClipItemWithPrimaryType:primaryType dataSize:24];
+
+    RCClipStatistics *after = [databaseManager clipStatistics];
+    XCTAssertEqual(after.itemCount, before.itemCount + 2);
+    XCTAssertEqual(after.totalDataSize, before.totalDataSize + 1024);
+    XCTAssertEqualObjects(after.itemCountsByPrimaryType[primaryType], @2);
+    XCTAssertEqual([databaseManager clipItemCount], after.itemCount);
+
+    // update_time の更新は集計を変えない
+    XCTAssertTrue([databaseManager updateClipItemUpdateTime:first.dataHash time:first.updateTime + 1]);
+    XCTAssertEqual([databaseManager clipStatistics].itemCount, after.itemCount);
+
+    XCTAssertTrue([databaseManager deleteClipItemWithDataHash:first.dataHash]);
+    RCClipStatistics *afterDelete = [databaseManager clipStatistics];
+    XCTAssertEqual(afterDelete.itemCount, before.itemCount + 1);
+    XCTAssertEqual(afterDelete.totalDataSize, before.totalDataSize + 24);
+    XCTAssertEqualObjects(afterDelete.itemCountsByPrimaryType[primaryType], @1);
+}
+
+@end
@@ -0,0 +1,31 @@
+#import <XCTest/XCTest.h>
+
+#import "RCClipItem.h"
+#import "RCDatabaseManager.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// RCDatabaseManager を使うテストの共通の土台。setUp でデータベースを開いて
+// writeBehindInterval を databaseWriteBehindInterval に切り替え、tearDown で
+// insertedHashes の行と createdPaths のファイルを消して元に戻す。
+@interface RCDatabaseTestCase : XCTestCase
+
+@property (nonatomic, readonly) RCDatabaseManager *databaseManager;
+@property (nonatomic, readonly) NSMutableArray<NSString *> *insertedHashes;
+@property (nonatomic, readonly) NSMutableArray<NSString *> *createdPaths;
+
+// テスト中の writeBehindInterval。既定は 0（即時コミット）で、キューを試すサブクラスが上書きする。
+- (NSTimeInterval)databaseWriteBehindInterval;
+
+// 既存の履歴と衝突しないランダムな data_hash（32 バイト）。
+- (NSString *)randomDataHash;
+
+// ランダムな data_hash と <hash>.rcclip のパスを持つテキストのクリップ（ファイルは作らない）。
+// ハッシュは insertedHashes に登録するので、挿入した行は tearDown で消える。
+- (RCClipItem *)clipItemWithTitle:(NSString *)title updateTime:(NSInteger)updateTime;
+// clipItemWithTitle:updateTime: を insertClipItemObject: で挿入して返す。
+- (RCClipItem *)insertClipItemWithTitle:(NSString *)title updateTime:(NSInteger)updateTime;
+
+@end
+
+NS_ASSUME_NONNULL_END
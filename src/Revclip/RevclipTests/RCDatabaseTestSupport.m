@@ -0,0 +1,70 @@
+#import "RCDatabaseTestSupport.h"
+
+#import "RCUtilities.h"
+
+@interface RCDatabaseTestCase ()
+
+@property (nonatomic, assign) NSTimeInterval savedWriteBehindInterval;
+@property (nonatomic, strong, readwrite) NSMutableArray<NSString *> *insertedHashes;
+@property (nonatomic, strong, readwrite) NSMutableArray<NSString *> *createdPaths;
+
+@end
+
+@implementation RCDatabaseTestCase
+
+- (RCDatabaseManager *)databaseManager {
+    return [RCDatabaseManager shared];
+}
+
+- (void)setUp {
+    [super setUp];
+    RCDatabaseManager *databaseManager = self.databaseManager;
+    XCTAssertTrue([databaseManager setupDatabase]);
+    self.savedWriteBehindInterval = databaseManager.writeBehindInterval;
+    databaseManager.writeBehindInterval = [self databaseWriteBehindInterval];
+    self.insertedHashes = [NSMutableArray array];
+    self.createdPaths = [NSMutableArray array];
+}
+
+- (void)tearDown {
+    RCDatabaseManager *databaseManager = self.databaseManager;
+    for (NSString *dataHash in self.insertedHashes) {
+        [databaseManager deleteClipItemWithDataHash:dataHash];
+    }
+    for (NSString *path in self.createdPaths) {
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    }
+    databaseManager.writeBehindInterval = self.savedWriteBehindInterval;
+    [super tearDown];
+}
+
+- (NSTimeInterval)databaseWriteBehindInterval {
+    return 0;
+}
+
+- (NSString *)randomDataHash {
+    uuid_t uuidBytes[2];
+    [[NSUUID UUID] getUUIDBytes:uuidBytes[0]];
+    [[NSUUID UUID] getUUIDBytes:uuidBytes[1]];
+    return [RCUtilities hexStringFromBytes:uuidBytes length:sizeof(uuidBytes)];
+}
+
+- (RCClipItem *)clipItemWithTitle:(NSString *)title updateTime:(NSInteger)updateTime {
+    RCClipItem *clipItem = [[RCClipItem alloc] init];
+    clipItem.dataHash = [self randomDataHash];
+    clipItem.dataPath = [[RCUtilities clipDataDirectoryPath]
+                         stringByAppendingPathComponent:[clipItem.dataHash stringByAppendingPathExtension:@"rcclip"]];
+    clipItem.title = title;
+    clipItem.primaryType = @"public.utf8-plain-text";
+    clipItem.updateTime = updateTime;
+    [self.insertedHashes addObject:clipItem.dataHash];
+    return clipItem;
+}
+
+- (RCClipItem *)insertClipItemWithTitle:(NSString *)title updateTime:(NSInteger)updateTime {
+    RCClipItem *clipItem = [self clipItemWithTitle:title updateTime:updateTime];
+    XCTAssertTrue([self.databaseManager insertClipItemObject:clipItem]);
+    return clipItem;
+}
+
+@end
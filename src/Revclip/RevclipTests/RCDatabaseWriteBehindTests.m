@@ -0,0 +1,119 @@
+#import <XCTest/XCTest.h>
+
+#import "RCDatabaseTestSupport.h"
+
+@interface RCDatabaseWriteBehindTests : RCDatabaseTestCase
+
+@end
+
+@implementation RCDatabaseWriteBehindTests
+
+// テスト中にタイマー flush が走らないよう十分長くする。
+- (NSTimeInterval)databaseWriteBehindInterval {
+    return 60.0;
+}
+
+- (RCClipItem *)queuedClipItemWithUpdateTime:(NSInteger)updateTime {
+    return [self clipItemWithTitle:@"write-behind" updateTime:updateTime];
+}
+
+- (void)testQueuedInsertIsVisibleToLookupBeforeFlush {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    RCClipItem *clipItem = [self queuedClipItemWithUpdateTime:1000];
+
+    __block NSInteger completions = 0;
+    __block BOOL committed = NO;
+    XCTAssertTrue([databaseManager enqueueClipItemObject:clipItem completion:^(BOOL rowCommitted) {
+        completions++;
+        committed = rowCommitted;
+    }]);
+    XCTAssertFalse([databaseManager enqueueClipItemObject:clipItem completion:^(BOOL rowCommitted) {
+        (void)rowCommitted;
+        XCTFail(@"refused items must not complete");
+    }]);
+    XCTAssertEqual(completions, 0);
+
+    RCClipItem *pendingItem = [databaseManager clipItemForDataHash:clipItem.dataHash];
+    XCTAssertNotNil(pendingItem);
+    XCTAssertEqual(pendingItem.updateTime, 1000);
+
+    __block BOOL updateCommitted = NO;
+    XCTAssertTrue([databaseManager enqueueClipItemUpdateTime:clipItem.dataHash time:2000 completion:^(BOOL rowCommitted) {
+        updateCommitted = rowCommitted;
+    }]);
+    XCTAssertEqual([databaseManager clipItemForDataHash:clipItem.dataHash].updateTime, 2000);
+
+    XCTAssertTrue([databaseManager flushPendingWrites]);
+    XCTAssertEqual(completions, 1);
+    XCTAssertTrue(committed);
+    XCTAssertTrue(updateCommitted);
+    NSDictionary *row = [databaseManager clipItemWithDataHash:clipItem.dataHash];
+    XCTAssertEqualObjects(row[@"update_time"], @2000);
+}
+
+- (void)testRejectedQueuedInsertReportsFailure {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    RCClipItem *clipItem = [self queuedClipItemWithUpdateTime:1000];
+    XCTAssertTrue([databaseManager insertClipItemObject:clipItem]);
+
+    // 同じ data_hash の行はコミット済みなので、キューの行は UNIQUE 制約で弾かれる。
+    RCClipItem *duplicateItem = [clipItem copy];
+    duplicateItem.updateTime = 3000;
+    __block BOOL completed = NO;
+    __block BOOL committed = YES;
+    XCTAssertTrue([databaseManager enqueueClipItemObject:duplicateItem completion:^(BOOL rowCommitted) {
+        completed = YES;
+        committed = rowCommitted;
+    }]);
+    XCTAssertTrue([databaseManager flushPendingWrites]);
+    XCTAssertTrue(completed);
+    XCTAssertFalse(committed);
+    XCTAssertEqualObjects([databaseManager clipItemWithDataHash:clipItem.dataHash][@"update_time"], @1000);
+}
+
+- (void)testQueuedUpdateOfMissingRowReportsFailure {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    // 保存されていない（押し出し・削除済みと同じ）行への更新は 0 行になり、失敗として報告される。
+    RCClipItem *clipItem = [self queuedClipItemWithUpdateTime:1000];
+
+    __block BOOL completed = NO;
+    __block BOOL committed = YES;
+    XCTAssertTrue([databaseManager enqueueClipItemUpdateTime:clipItem.dataHash time:2000 completion:^(BOOL rowCommitted) {
+        completed = YES;
+        committed = rowCommitted;
+    }]);
+    XCTAssertTrue([databaseManager flushPendingWrites]);
+    XCTAssertTrue(completed);
+    XCTAssertFalse(committed);
+    XCTAssertFalse([databaseManager updateClipItemUpdateTime:clipItem.dataHash time:3000]);
+}
+
+- (void)testListReadsMergeQueuedWritesWithoutFlushing {
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    NSInteger newestTime = (NSInteger)([[NSDate date] timeIntervalSince1970] * 1000.0) + 60000;
+    RCClipItem *committedItem = [self queuedClipItemWithUpdateTime:1000];
+    XCTAssertTrue([databaseManager insertClipItemObject:committedItem]);
+    RCClipItem *queuedItem = [self queuedClipItemWithUpdateTime:newestTime];
+    XCTAssertTrue([databaseManager enqueueClipItemObject:queuedItem completion:^(BOOL rowCommitted) {
+        (void)rowCommitted;
+    }]);
+    // コミット済みの古い行を、キュー上の update_time 更新で先頭へ繰り上げる。
+    XCTAssertTrue([databaseManager enqueueClipItemUpdateTime:committedItem.dataHash time:newestTime + 1 completion:^(BOOL rowCommitted) {
+        (void)rowCommitted;
+    }]);
+
+    // 読み取りは flush しないので、キューの行は itemId 0 のまま一覧に重なる。
+    NSArray<RCClipItem *> *firstPage = [databaseManager clipItemsWithLimit:1];
+    XCTAssertEqualObjects(firstPage.firstObject.dataHash, committedItem.dataHash);
+    XCTAssertEqual(firstPage.firstObject.updateTime, newestTime + 1);
+    RCClipItem *secondItem = [databaseManager clipItemsAfterClipItem:firstPage.firstObject limit:1].firstObject;
+    XCTAssertEqualObjects(secondItem.dataHash, queuedItem.dataHash);
+    XCTAssertEqual(secondItem.itemId, 0);
+    RCClipItem *thirdItem = [databaseManager clipItemsAfterClipItem:secondItem limit:1].firstObject;
+    XCTAssertFalse([thirdItem.dataHash isEqualToString:committedItem.dataHash]);
+
+    XCTAssertTrue([databaseManager flushPendingWrites]);
+    XCTAssertGreaterThan([databaseManager clipItemsAfterClipItem:firstPage.firstObject limit:1].firstObject.itemId, 0);
+}
+
+@end
@@ -0,0 +1,122 @@
+#import <Cocoa/Cocoa.h>
+#import <XCTest/XCTest.h>
+
+#import "RCClipboardService.h"
+#import "RCClipData.h"
+#import "RCDatabaseManager.h"
+#import "RCPasteboardProvider.h"
+
+@interface RCInMemoryPasteboardTests : XCTestCase
+
+@property (nonatomic, strong) RCInMemoryPasteboard *pasteboard;
+
+@end
+
+@implementation RCInMemoryPasteboardTests
+
+- (void)setUp {
+    [super setUp];
+    self.pasteboard = [[RCInMemoryPasteboard alloc] init];
+}
+
+- (void)tearDown {
+    RCClipboardService *service = [RCClipboardService shared];
+    if (service.pasteboardProvider == self.pasteboard) {
+        service.pasteboardProvider = [RCSystemPasteboardProvider shared];
+    }
+    [super tearDown];
+}
+
+- (void)testScriptedCopyBumpsChangeCount {
+    NSInteger before = self.pasteboard.changeCount;
+    NSInteger after = [self.pasteboard scriptCopyOfType:NSPasteboardTypeString
+                                                 length:64
+                                                   seed:1
+                                 sourceBundleIdentifier:@"com.example.editor"];
+    XCTAssertGreaterThan(after, before);
+    XCTAssertEqual(self.pasteboard.changeCount, after);
+    XCTAssertEqualObjects(self.pasteboard.types, @[ NSPasteboardTypeString ]);
+    XCTAssertEqualObjects(self.pasteboard.frontmostApplicationBundleIdentifier, @"com.example.editor");
+
+    [self.pasteboard advanceChangeCountBy:3];
+    XCTAssertEqual(self.pasteboard.changeCount, after + 3);
+    XCTAssertEqualObjects(self.pasteboard.types, @[ NSPasteboardTypeString ]);
+}
+
+- (void)testSameSeedGivesTheSameClip {
+    RCCapturePlan plan = RCCapturePlanMake(RC_CLIP_REPRESENTATION_ALL, 50 * 1024 * 1024);
+    [self.pasteboard scriptCopyOfType:NSPasteboardTypeTIFF length:4096 seed:7 sourceBundleIdentifier:nil];
+    RCClipData *first = [RCClipData clipDataFromPasteboard:self.pasteboard plan:&plan verdict:NULL];
+    [self.pasteboard scriptCopyOfType:NSPasteboardTypeTIFF length:4096 seed:7 sourceBundleIdentifier:nil];
+    RCClipData *again = [RCClipData clipDataFromPasteboard:self.pasteboard plan:&plan verdict:NULL];
+    [self.pasteboard scriptCopyOfType:NSPasteboardTypeTIFF length:4096 seed:8 sourceBundleIdentifier:nil];
+    RCClipData *other = [RCClipData clipDataFromPasteboard:self.pasteboard plan:&plan verdict:NULL];
+
+    XCTAssertEqual(first.TIFFData.length, 4096u);
+    XCTAssertEqualObjects([first dataHash], [again dataHash]);
+    XCTAssertNotEqualObjects([first dataHash], [other dataHash]);
+}
+
+- (void)testDisabledTypeIsNeverRead {
+    [self.pasteboard scriptCopyOfType:NSPasteboardTypeTIFF length:1024 * 1024 seed:1 sourceBundleIdentifier:nil];
+    [self.pasteboard resetReadCounters];
+
+    RCCapturePlan plan = RCCapturePlanMake(RC_CLIP_REPRESENTATION_ALL & ~RCClipRepresentationTIFF, 50 * 1024 * 1024);
+    RCCaptureVerdict verdict = RCCaptureVerdictRead;
+    XCTAssertNil([RCClipData clipDataFromPasteboard:self.pasteboard plan:&plan verdict:&verdict]);
+    XCTAssertEqual(verdict, RCCaptureVerdictSkipDisabled);
+    XCTAssertEqual(self.pasteboard.readCount, 0u);
+    XCTAssertEqual(self.pasteboard.bytesRead, 0ull);
+}
+
+- (void)testWriteBackRoundTrips {
+    RCClipData *clipData = [[RCClipData alloc] init];
+    clipData.stringValue = @"round trip";
+    clipData.RTFData = [@"{\\rtf1 round trip}" dataUsingEncoding:NSUTF8StringEncoding];
+    clipData.fileURLs = @[ [NSURL fileURLWithPath:@"/tmp/a.txt"] ];
+    clipData.primaryType = NSPasteboardTypeString;
+    NSInteger before = self.pasteboard.changeCount;
+    XCTAssertTrue([clipData writeToPasteboard:self.pasteboard]);
+    XCTAssertGreaterThan(self.pasteboard.changeCount, before);
+
+    RCCapturePlan plan = RCCapturePlanMake(RC_CLIP_REPRESENTATION_ALL, 50 * 1024 * 1024);
+    RCClipData *read = [RCClipData clipDataFromPasteboard:self.pasteboard plan:&plan verdict:NULL];
+    XCTAssertEqualObjects(read.stringValue, clipData.stringValue);
+    XCTAssertEqualObjects(read.RTFData, clipData.RTFData);
+    XCTAssertEqualObjects(read.fileURLs, clipData.fileURLs);
+}
+
+- (void)testServiceCapturesFromTheProvider {
+    XCTAssertTrue([[RCDatabaseManager shared] setupDatabase]);
+    RCClipboardService *service = [RCClipboardService shared];
+    XCTAssertFalse(service.isMonitoring);
+    service.pasteboardProvider = self.pasteboard;
+
+    NSString *text = [NSString stringWithFormat:@"in-memory %@", NSUUID.UUID.UUIDString];
+    [self.pasteboard scriptCopyWithRepresentations:@{ NSPasteboardTypeString: text }
+                            sourceBundleIdentifier:@"com.revclip.tests"];
+    RCClipData *expected = [[RCClipData alloc] init];
+    expected.stringValue = text;
+    expected.primaryType = NSPasteboardTypeString;
+    NSString *dataHash = [expected dataHash];
+
+    [service captureCurrentClipboard];
+    XCTestExpectation *drained = [self expectationWithDescription:@"capture pipeline drained"];
+    [service flushQueueWithCompletion:^{
+        [drained fulfill];
+    }];
+    [self waitForExpectations:@[drained] timeout:10.0];
+    XCTAssertTrue([[RCDatabaseManager shared] flushPendingWrites]);
+
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    NSDictionary *row = [databaseManager clipItemWithDataHash:dataHash];
+    XCTAssertNotNil(row);
+    XCTAssertGreaterThan(self.pasteboard.readCount, 0u);
+    [databaseManager deleteClipItemWithDataHash:dataHash];
+    NSString *path = [row[@"data_path"] isKindOfClass:NSString.class] ? row[@"data_path"] : @"";
+    if (path.length > 0) {
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    }
+}
+
+@end
@@ -0,0 +1,31 @@
+//
+//  RCTraceReplayRunner.h
+//  RevclipTraceReplay
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RCReplayTrace.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// RCReplayTrace をアプリの実クラス（RCClipboardService / RCDatabaseManager / RCDataCleanService）に
+// RCInMemoryPasteboard 経由で再生する。ホームディレクトリを一時ディレクトリに差し替えた子プロセスの中でだけ使う。
+//
+// 再生は実時間で、イベントの間隔は maximumGap で頭打ちにする。縮めた分は、有効期限があれば行の update_time を
+// 同じだけ古くし、5 秒以上の間隔ならデバウンス後のクリーンアップ、30 分の境界をまたげば定期クリーンアップを
+// その場で実行して埋め合わせる。
+@interface RCTraceReplayRunner : NSObject
+
+- (instancetype)initWithTrace:(const RCReplayTrace *)trace maximumGap:(NSTimeInterval)maximumGap;
+- (instancetype)init NS_UNAVAILABLE;
+
+// メインの run loop を回している間に別スレッドから呼ぶ（スナップショットと通知がメインキューを使う）。
+// 最後に履歴の件数と .rcclip の対応を確かめ、result->passed に入れる。
+- (void)runWithResult:(RCReplayResult *)result;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,374 @@
+//
+//  RCTraceReplayRunner.m
+//  RevclipTraceReplay
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+
+#import "RCTraceReplayRunner.h"
+
+#import <libproc.h>
+#import <os/log.h>
+#import <sys/resource.h>
+#import <time.h>
+
+#import "FMDB.h"
+#import "RCBenchIOCounters.h"
+#import "RCBenchSupport.h"
+#import "RCCapturePlan.h"
+#import "RCClipData.h"
+#import "RCClipItem.h"
+#import "RCClipboardService.h"
+#import "RCConstants.h"
+#import "RCDataCleanService.h"
+#import "RCDatabaseManager.h"
+#import "RCHotKeyService.h"
+#import "RCPasteboardProvider.h"
+#import "RCUtilities.h"
+
+// RCDataCleanService のデバウンス（5 秒）と定期クリーンアップ（30 分）の間隔
+static uint64_t const kRCReplayDebouncedCleanupNanoseconds = 5ull * NSEC_PER_SEC;
+static uint64_t const kRCReplayCleanupIntervalNanoseconds = 30ull * 60ull * NSEC_PER_SEC;
+// 最後のコピーのあと、保持中のバースト（合流待ち 500 ms）とポーリングが落ち着くまで待つ時間
+static uint64_t const kRCReplaySettleNanoseconds = 1500ull * NSEC_PER_MSEC;
+
+static os_log_t RCTraceReplayLog(void) {
+    static os_log_t log;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        log = os_log_create("com.revclip.RevclipTraceReplay", "replay");
+    });
+    return log;
+}
+
+static uint64_t RCProcessCPUNanoseconds(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return ((uint64_t)usage.ru_utime.tv_sec + (uint64_t)usage.ru_stime.tv_sec) * NSEC_PER_SEC
+        + ((uint64_t)usage.ru_utime.tv_usec + (uint64_t)usage.ru_stime.tv_usec) * NSEC_PER_USEC;
+}
+
+// ファイルへの書き込み（.rcclip・ブロブ・サムネイル・SQLite）をまとめた論理書き込みバイト数
+static uint64_t RCProcessLogicalWrites(void) {
+    struct rusage_info_v2 info;
+    if (proc_pid_rusage(getpid(), RUSAGE_INFO_V2, (rusage_info_t *)&info) != 0) {
+        return 0;
+    }
+    return info.ri_logical_writes;
+}
+
+@interface RCTraceReplayRunner ()
+
+@property (nonatomic, assign) const RCReplayTrace *trace;
+@property (nonatomic, assign) uint64_t maximumGapNanoseconds;
+@property (nonatomic, strong) RCInMemoryPasteboard *pasteboard;
+// メインキューでだけ触る: 台本に書いたコピーの dataHash → 書いた時刻。同じ内容を書き直したら新しい時刻で置き換える
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *pendingCopies;
+@property (nonatomic, assign) uint64_t captured;
+// 縮めた間隔のうち、まだ行の update_time に反映していない分
+@property (nonatomic, assign) uint64_t unagedNanoseconds;
+// 計測から外す分（台本の準備に使った CPU 時間と、行を古くする UPDATE の I/O）
+@property (nonatomic, assign) uint64_t excludedCPUNanoseconds;
+@property (nonatomic, assign) uint64_t excludedSyncs;
+@property (nonatomic, assign) uint64_t excludedWrittenBytes;
+
+@end
+
+@implementation RCTraceReplayRunner {
+    RCBenchSamples _latencies;
+}
+
+- (instancetype)initWithTrace:(const RCReplayTrace *)trace maximumGap:(NSTimeInterval)maximumGap {
+    self = [super init];
+    if (self) {
+        _trace = trace;
+        _maximumGapNanoseconds = (uint64_t)(MAX(maximumGap, 0.0) * (double)NSEC_PER_SEC);
+        _pasteboard = [[RCInMemoryPasteboard alloc] init];
+        _pendingCopies = [NSMutableDictionary dictionary];
+        RCBenchSamplesInit(&_latencies, trace->count);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    RCBenchSamplesFree(&_latencies);
+}
+
+#pragma mark - Run
+
+- (void)runWithResult:(RCReplayResult *)result {
+    memset(result, 0, sizeof(*result));
+    for (size_t index = 0; index < self.trace->count; index++) {
+        result->copies += self.trace->events[index].kind == RCReplayEventCopy ? 1 : 0;
+    }
+
+    // 起動時と同じ順に用意する（RCAppDelegate の 1〜3, 5）。起動時のメンテナンスは計測に含めない
+    [RCUtilities registerDefaultSettings];
+    [self registerTraceSettings];
+    RCDatabaseManager *databaseManager = [RCDatabaseManager shared];
+    if (![databaseManager setupDatabase]) {
+        fprintf(stderr, "setupDatabase failed\n");
+        return;
+    }
+    [RCUtilities applyDataProtectionAttributes];
+    RCClipboardService *clipboardService = [RCClipboardService shared];
+    RCDataCleanService *dataCleanService = [RCDataCleanService shared];
+    clipboardService.pasteboardProvider = self.pasteboard;
+
+    __weak typeof(self) weakSelf = self;
+    id observer = [[NSNotificationCenter defaultCenter] addObserverForName:RCClipboardDidChangeNotification
+                                                                    object:clipboardService
+                                                                     queue:nil
+                                                                usingBlock:^(NSNotification *notification) {
+        RCClipItem *clipItem = notification.userInfo[@"clipItem"];
+        [weakSelf noteCapturedClipItem:clipItem];
+    }];
+
+    [dataCleanService startCleanupTimer];
+    [self waitForCleanupQueue];
+    dispatch_sync(dispatch_get_main_queue(), ^{
+        [clipboardService startMonitoring];
+    });
+
+    RCBenchIOCountersReset();
+    uint64_t cpuStart = RCProcessCPUNanoseconds();
+    uint64_t writtenStart = RCProcessLogicalWrites();
+
+    uint64_t previousEventAt = 0;
+    uint64_t virtualNow = 0;
+    uint64_t lastScriptedAt = RCBenchNowNanoseconds();
+    for (size_t index = 0; index < self.trace->count; index++) {
+        @autoreleasepool {
+            const RCReplayEvent *event = &self.trace->events[index];
+            uint64_t gap = event->atNanoseconds - previousEventAt;
+            previousEventAt = event->atNanoseconds;
+
+            NSDictionary<NSPasteboardType, id> *contents = nil;
+            NSString *dataHash = nil;
+            if (event->kind == RCReplayEventCopy) {
+                [self prepareCopy:&event->contents contents:&contents dataHash:&dataHash];
+            }
+
+            uint64_t realGap = MIN(gap, self.maximumGapNanoseconds);
+            if (realGap < gap) {
+                [self skipNanoseconds:gap - realGap from:virtualNow];
+            }
+            virtualNow += gap;
+
+            uint64_t deadline = lastScriptedAt + realGap;
+            uint64_t now = RCBenchNowNanoseconds();
+            if (deadline > now) {
+                RCBenchSleepMicroseconds((deadline - now) / NSEC_PER_USEC);
+            }
+            lastScriptedAt = RCBenchNowNanoseconds();
+            [self playEvent:event contents:contents dataHash:dataHash];
+        }
+    }
+
+    RCBenchSleepMicroseconds(kRCReplaySettleNanoseconds / NSEC_PER_USEC);
+    dispatch_sync(dispatch_get_main_queue(), ^{
+        [clipboardService stopMonitoring];
+    });
+    [self drainPipeline];
+    [self performCleanup];
+    [dataCleanService stopCleanupTimer];
+    // 最後の通知がメインキューで処理されるまで待つ
+    dispatch_sync(dispatch_get_main_queue(), ^{
+    });
+
+    RCBenchIOCounters io;
+    RCBenchIOCountersGet(&io);
+    uint64_t cpu = RCProcessCPUNanoseconds() - cpuStart;
+    uint64_t written = RCProcessLogicalWrites() - writtenStart;
+    result->elapsedNanoseconds = cpu > self.excludedCPUNanoseconds ? cpu - self.excludedCPUNanoseconds : 0;
+    result->bytesWritten = written > self.excludedWrittenBytes ? written - self.excludedWrittenBytes : 0;
+    result->syncs = io.syncs > self.excludedSyncs ? io.syncs - self.excludedSyncs : 0;
+    dispatch_sync(dispatch_get_main_queue(), ^{
+        result->captured = self.captured;
+        result->p50Nanoseconds = RCBenchSamplesPercentile(&self->_latencies, 50.0);
+        result->p99Nanoseconds = RCBenchSamplesPercentile(&self->_latencies, 99.0);
+    });
+    result->peakResidentBytes = RCBenchPeakResidentBytes();
+    result->passed = [self verifyHistoryWithDatabaseManager:databaseManager];
+
+    [[NSNotificationCenter defaultCenter] removeObserver:observer];
+}
+
+// トレースの履歴上限と有効期限（分単位に切り上げ）を、登録した既定値の上に重ねる。
+// 子プロセスのユーザ設定は空なので、これがそのまま使われる
+- (void)registerTraceSettings {
+    NSMutableDictionary<NSString *, id> *settings = [NSMutableDictionary dictionary];
+    if (self.trace->historyLimit >= 0) {
+        settings[kRCPrefMaxHistorySizeKey] = @(self.trace->historyLimit);
+    }
+    if (self.trace->expiryNanoseconds > 0) {
+        uint64_t minute = 60ull * NSEC_PER_SEC;
+        settings[kRCPrefAutoExpiryEnabledKey] = @YES;
+        settings[kRCPrefAutoExpiryValueKey] = @((self.trace->expiryNanoseconds + minute - 1) / minute);
+        settings[kRCPrefAutoExpiryUnitKey] = @(RCAutoExpiryUnitMinute);
+    }
+    [[NSUserDefaults standardUserDefaults] registerDefaults:settings];
+}
+
+#pragma mark - Events
+
+// 台本の内容と、保存されたときの dataHash を用意する。コピーの間（アプリが待っている間）に作り、
+// この CPU 時間は計測から外す。マーカー型付きのコピーは保存されないので dataHash を求めない
+- (void)prepareCopy:(const RCBenchPasteboardContents *)scripted
+           contents:(NSDictionary<NSPasteboardType, id> **)outContents
+           dataHash:(NSString **)outDataHash {
+    uint64_t start = clock_gettime_nsec_np(CLOCK_THREAD_CPUTIME_ID);
+    NSDictionary<NSPasteboardType, id> *contents = [RCInMemoryPasteboard scriptedRepresentations:scripted->offered
+                                                                                         length:scripted->length
+                                                                                           seed:scripted->seed
+                                                                                         marked:scripted->marked];
+    NSString *dataHash = nil;
+    if (!scripted->marked) {
+        RCInMemoryPasteboard *scratch = [[RCInMemoryPasteboard alloc] init];
+        [scratch scriptCopyWithRepresentations:contents sourceBundleIdentifier:nil];
+        RCCapturePlan plan = RCCapturePlanMake(RC_CLIP_REPRESENTATION_ALL, [RCUtilities maxClipSizeBytes]);
+        dataHash = [[RCClipData clipDataFromPasteboard:scratch plan:&plan verdict:NULL] dataHash];
+    }
+    *outContents = contents;
+    *outDataHash = dataHash;
+    self.excludedCPUNanoseconds += clock_gettime_nsec_np(CLOCK_THREAD_CPUTIME_ID) - start;
+}
+
+- (void)playEvent:(const RCReplayEvent *)event
+         contents:(nullable NSDictionary<NSPasteboardType, id> *)contents
+         dataHash:(nullable NSString *)dataHash {
+    RCInMemoryPasteboard *pasteboard = self.pasteboard;
+    NSString *application = event->contents.sourceBundleIdentifier != NULL
+        ? @(event->contents.sourceBundleIdentifier) : nil;
+    RCReplayEventKind kind = event->kind;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        switch (kind) {
+            case RCReplayEventCopy:
+                [pasteboard scriptCopyWithRepresentations:contents sourceBundleIdentifier:application];
+                if (dataHash != nil) {
+                    self.pendingCopies[dataHash] = @(RCBenchNowNanoseconds());
+                }
+                break;
+            case RCReplayEventTouch:
+                [pasteboard advanceChangeCountBy:1];
+                break;
+            case RCReplayEventActivity:
+                [[NSNotificationCenter defaultCenter] postNotificationName:RCHotKeyMainTriggeredNotification object:nil];
+                break;
+        }
+    });
+}
+
+// メインキューで呼ばれる
+- (void)noteCapturedClipItem:(RCClipItem *)clipItem {
+    if (clipItem.dataHash.length == 0) {
+        return;
+    }
+    NSNumber *scriptedAt = self.pendingCopies[clipItem.dataHash];
+    if (scriptedAt == nil) {
+        return;
+    }
+    [self.pendingCopies removeObjectForKey:clipItem.dataHash];
+    RCBenchSamplesAppend(&_latencies, RCBenchNowNanoseconds() - scriptedAt.unsignedLongLongValue);
+    self.captured += 1;
+}
+
+#pragma mark - Compressed gaps
+
+// 飛ばした時間の埋め合わせ。その間に走っていたはずのクリーンアップを、パイプラインを空にしてから実行する。
+// 期限切れはクリーンアップでしか判定しないので、行はその直前に、前回から飛ばした分だけまとめて古くする
+- (void)skipNanoseconds:(uint64_t)skipped from:(uint64_t)virtualNow {
+    self.unagedNanoseconds += skipped;
+    BOOL debounced = skipped + self.maximumGapNanoseconds >= kRCReplayDebouncedCleanupNanoseconds;
+    BOOL periodic = (virtualNow + skipped) / kRCReplayCleanupIntervalNanoseconds
+        != virtualNow / kRCReplayCleanupIntervalNanoseconds;
+    if (debounced || periodic) {
+        [self drainPipeline];
+        [self performCleanup];
+    }
+}
+
+- (void)performCleanup {
+    if (self.trace->expiryNanoseconds > 0 && self.unagedNanoseconds > 0) {
+        [self ageHistoryByMilliseconds:(int64_t)(self.unagedNanoseconds / NSEC_PER_MSEC)];
+    }
+    self.unagedNanoseconds = 0;
+    [[RCDataCleanService shared] performCleanup];
+    [self waitForCleanupQueue];
+}
+
+- (void)ageHistoryByMilliseconds:(int64_t)milliseconds {
+    RCBenchIOCounters before;
+    RCBenchIOCountersGet(&before);
+    uint64_t writtenBefore = RCProcessLogicalWrites();
+    BOOL aged = [[RCDatabaseManager shared] performDatabaseOperation:^BOOL(FMDatabase *db) {
+        return [db executeUpdate:@"UPDATE clip_items SET update_time = update_time - ?", @(milliseconds)];
+    }];
+    if (!aged) {
+        os_log_error(RCTraceReplayLog(), "Failed to age the replay history");
+    }
+    RCBenchIOCounters after;
+    RCBenchIOCountersGet(&after);
+    self.excludedSyncs += after.syncs - before.syncs;
+    self.excludedWrittenBytes += RCProcessLogicalWrites() - writtenBefore;
+}
+
+#pragma mark - Waiting
+
+- (void)drainPipeline {
+    dispatch_semaphore_t drained = dispatch_semaphore_create(0);
+    [[RCClipboardService shared] flushQueueWithCompletion:^{
+        dispatch_semaphore_signal(drained);
+    }];
+    dispatch_semaphore_wait(drained, DISPATCH_TIME_FOREVER);
+    [[RCDatabaseManager shared] flushPendingWrites];
+}
+
+- (void)waitForCleanupQueue {
+    dispatch_semaphore_t drained = dispatch_semaphore_create(0);
+    [[RCDataCleanService shared] flushQueueWithCompletion:^{
+        dispatch_semaphore_signal(drained);
+    }];
+    dispatch_semaphore_wait(drained, DISPATCH_TIME_FOREVER);
+}
+
+#pragma mark - Verification
+
+// 履歴が上限以下で、行と .rcclip が 1 対 1 か（RCBenchCaptureVerify と同じ確認）
+- (BOOL)verifyHistoryWithDatabaseManager:(RCDatabaseManager *)databaseManager {
+    NSInteger limit = [[NSUserDefaults standardUserDefaults] integerForKey:kRCPrefMaxHistorySizeKey];
+    NSInteger rows = [databaseManager clipItemCount];
+    BOOL passed = YES;
+    if (limit > 0 && rows > limit) {
+        fprintf(stderr, "history holds %ld rows, limit %ld\n", (long)rows, (long)limit);
+        passed = NO;
+    }
+
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    __block NSInteger missing = 0;
+    [databaseManager enumerateClipItemsUsingBlock:^(RCClipItem *clipItem, BOOL *stop) {
+        (void)stop;
+        if (clipItem.dataPath.length == 0 || ![fileManager fileExistsAtPath:clipItem.dataPath]) {
+            missing += 1;
+        }
+    }];
+    if (missing > 0) {
+        fprintf(stderr, "%ld rows have no clip file\n", (long)missing);
+        passed = NO;
+    }
+
+    NSInteger files = 0;
+    NSDirectoryEnumerator<NSString *> *enumerator = [fileManager enumeratorAtPath:[RCUtilities clipDataDirectoryPath]];
+    for (NSString *path in enumerator) {
+        files += [path.pathExtension isEqualToString:@"rcclip"] ? 1 : 0;
+    }
+    if (files != rows) {
+        fprintf(stderr, "%ld clip files for %ld rows\n", (long)files, (long)rows);
+        passed = NO;
+    }
+    return passed;
+}
+
+@end
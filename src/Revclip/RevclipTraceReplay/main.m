@@ -0,0 +1,157 @@
+//
+//  main.m
+//  RevclipTraceReplay
+//
+//  Copyright (c) 2024-2026 Revclip. All rights reserved.
+//
+//  Benchmarks/RCTraceReplayBenchmark のトレース・シナリオ・ベースラインを、モデルではなく
+//  アプリの実クラス（RCClipboardService / RCDatabaseManager / RCDataCleanService）に
+//  RCInMemoryPasteboard 経由で再生する。コマンドラインは RCReplayMain と同じで、加えて
+//  --max-gap-ms（既定 500）でイベント間隔の上限を決める（RCTraceReplayRunner.h）。
+//
+//  シナリオごとに自分自身を子プロセスとして起動し、CFFIXED_USER_HOME を一時ディレクトリに
+//  向けるので、ユーザの履歴には触れない。子はホームが差し替わっていることを確かめてから始める。
+//  ベースラインの options 行には pipeline=app と --max-gap-ms が付き、モデルのベースラインとは混ざらない。
+//
+//  Usage: RevclipTraceReplay [--scenario all] [--trace path] [--scale 1]
+//                            [--image-mib 20] [--seed 1] [--max-gap-ms 500]
+//                            [--baseline path] [--write-baseline path]
+//                            [--tolerance 10] [--time-tolerance 50]
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RCBenchIOCounters.h"
+#import "RCBenchSupport.h"
+#import "RCReplayTrace.h"
+#import "RCTraceReplayRunner.h"
+
+typedef struct {
+    int argc;
+    char **argv;
+} RCTraceReplayArguments;
+
+// MARK: - Child
+
+static int RCTraceReplayChildMain(int argc, char **argv) {
+    const char *home = RCBenchStringOption(argc, argv, "--replay-home", NULL);
+    const char *resultPath = RCBenchStringOption(argc, argv, "--replay-result", NULL);
+    long scenario = RCBenchIntegerOption(argc, argv, "--replay-child", -1);
+    if (home == NULL || resultPath == NULL || scenario < 0) {
+        fprintf(stderr, "--replay-child needs --replay-home and --replay-result\n");
+        return 2;
+    }
+    // 差し替えたホームでなければ、実際の履歴を消しかねないので何もしない
+    NSString *scratchHome = [@(home) stringByResolvingSymlinksInPath];
+    if (![[NSHomeDirectory() stringByResolvingSymlinksInPath] isEqualToString:scratchHome]) {
+        fprintf(stderr, "home is %s, not the scratch home %s; refusing to replay\n",
+                NSHomeDirectory().fileSystemRepresentation, home);
+        return 1;
+    }
+
+    RCReplayOptions options;
+    RCReplayOptionsParse(argc, argv, &options);
+    const char *tracePath = RCBenchStringOption(argc, argv, "--trace", NULL);
+    long maximumGapMilliseconds = RCBenchIntegerOption(argc, argv, "--max-gap-ms", 500);
+
+    RCReplayTrace trace;
+    RCReplayTraceInit(&trace);
+    __block RCReplayResult result = { 0 };
+    // データベースを開く前に入れて、すべての接続の xSync を数える
+    if (RCReplayTraceBuild((size_t)scenario, tracePath, &options, &trace) && RCBenchIOCountersInstall()) {
+        RCTraceReplayRunner *runner = [[RCTraceReplayRunner alloc] initWithTrace:&trace
+                                                                      maximumGap:MAX(maximumGapMilliseconds, 0) / 1000.0];
+        // 再生は別スレッドで行い、メインスレッドはスナップショットと通知のために run loop を回す
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+            [runner runWithResult:&result];
+            dispatch_async(dispatch_get_main_queue(), ^{
+                CFRunLoopStop(CFRunLoopGetMain());
+            });
+        });
+        CFRunLoopRun();
+    }
+    RCReplayTraceFree(&trace);
+
+    FILE *file = fopen(resultPath, "wb");
+    bool written = file != NULL && fwrite(&result, sizeof(result), 1, file) == 1;
+    written = file != NULL && fclose(file) == 0 && written;
+    return written && result.passed ? 0 : 1;
+}
+
+// MARK: - Parent
+
+static bool RCTraceReplayInChild(size_t scenario, const char *tracePath, const RCReplayOptions *options,
+                                 RCReplayResult *outResult, void *context) {
+    (void)tracePath;
+    (void)options;
+    const RCTraceReplayArguments *arguments = context;
+    char *directory = RCBenchCreateScratchDirectory("revclip-trace-replay");
+    if (directory == NULL) {
+        return false;
+    }
+    NSString *scratch = @(directory);
+    NSString *home = [scratch stringByAppendingPathComponent:@"home"];
+    NSString *resultPath = [scratch stringByAppendingPathComponent:@"result"];
+    bool ok = [[NSFileManager defaultManager] createDirectoryAtPath:home
+                                        withIntermediateDirectories:NO
+                                                         attributes:nil
+                                                              error:nil];
+    if (ok) {
+        // 同じオプションで子を起動する（子は --trace / --scale などを自分で読み直す）
+        NSMutableArray<NSString *> *childArguments = [NSMutableArray array];
+        for (int index = 1; index < arguments->argc; index++) {
+            [childArguments addObject:@(arguments->argv[index])];
+        }
+        [childArguments addObjectsFromArray:@[
+            @"--replay-child", [NSString stringWithFormat:@"%zu", scenario],
+            @"--replay-home", home,
+            @"--replay-result", resultPath,
+        ]];
+        NSMutableDictionary<NSString *, NSString *> *environment = [[NSProcessInfo processInfo].environment mutableCopy];
+        environment[@"CFFIXED_USER_HOME"] = home;
+        environment[@"HOME"] = home;
+
+        NSTask *task = [[NSTask alloc] init];
+        task.executableURL = [NSBundle mainBundle].executableURL;
+        task.arguments = childArguments;
+        task.environment = environment;
+        NSError *error = nil;
+        ok = [task launchAndReturnError:&error];
+        if (!ok) {
+            fprintf(stderr, "cannot start the replay child: %s\n", error.localizedDescription.UTF8String);
+        } else {
+            [task waitUntilExit];
+            NSData *data = [NSData dataWithContentsOfFile:resultPath];
+            ok = data.length == sizeof(*outResult);
+            if (ok) {
+                memcpy(outResult, data.bytes, sizeof(*outResult));
+            }
+            ok = ok && task.terminationReason == NSTaskTerminationReasonExit && task.terminationStatus == 0;
+        }
+    }
+    RCBenchRemoveScratchDirectory(directory);
+    free(directory);
+    return ok;
+}
+
+// MARK: - Main
+
+int main(int argc, char *argv[]) {
+    @autoreleasepool {
+        if (RCBenchStringOption(argc, argv, "--replay-child", NULL) != NULL) {
+            return RCTraceReplayChildMain(argc, argv);
+        }
+        // 間隔の上限は結果を変えるので、ベースラインの options 行に入れる
+        char pipeline[64];
+        snprintf(pipeline, sizeof(pipeline), "app max-gap-ms=%ld",
+                 MAX(RCBenchIntegerOption(argc, argv, "--max-gap-ms", 500), 0L));
+        RCTraceReplayArguments arguments = { argc, argv };
+        RCReplayDriver driver = {
+            .name = "RevclipTraceReplay",
+            .pipeline = pipeline,
+            .replay = RCTraceReplayInChild,
+            .context = &arguments,
+        };
+        return RCReplayMain(argc, argv, &driver);
+    }
+}